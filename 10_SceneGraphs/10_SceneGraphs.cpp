@@ -15,7 +15,6 @@
 
 #include "GameData.h"
 
-#include "ResourceManager.h"
 
 #ifdef _DEBUG
 #include <dxgidebug.h>
@@ -120,12 +119,6 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         return -5;
     }
 
-    if (!SUCCEEDED(InitResources(graphicsDX11.GetD3DDeviceContext())))
-    {
-        PLOG_ERROR << "Failed Initializing additional Graphics resources";
-        return -6;
-    }
-
 	// Main message loop:
     MSG msg = { nullptr };
 
@@ -154,7 +147,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 		// Let's throttle the application so that we render at a constant speed, regardless of processor speed.
         Update(deltaSeconds, graphicsDX11, camera, data);
 
-		DrawUI(data, GraphicsDX11::GetSceneRoot());
+		DrawUI(data, GraphicsDX11::GetSceneRoot(), graphicsDX11.GetSceneBvh(), graphicsDX11.GetRendererStats());
 
 		camera.SetInvertY(data.m_InvertYAxis);
 
@@ -379,6 +372,9 @@ void Update(double deltaInSeconds, GraphicsDX11& graphics, OrbitCamera& camera,
 
 	graphics.SetViewport(viewport);
     graphics.SetWorldViewProjection(camera.GetMVP());
+    graphics.SetFrustum(camera.GetFrustum());
+    graphics.SetLodView(camera.GetLodView());
+    graphics.SetPropCount(static_cast<uint32_t>(data.m_propCount));
 
 	data.m_wheelDelta = 0.f;
 }
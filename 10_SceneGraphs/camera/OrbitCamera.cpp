@@ -41,6 +41,7 @@ void OrbitCamera::SetProjection(float width, float height)
 {
     float aspect = width / height;
     m_Projection = DirectX::XMMatrixPerspectiveFovLH(degreesToRadians(78), aspect, 0.01f, 100.0f);
+    m_LodView.projectionScale = ComputeProjectionScale(degreesToRadians(78), height);
 }
 
 void OrbitCamera::SetInvertY(bool invertY)
@@ -64,6 +65,7 @@ void OrbitCamera::RotateAroundPoint(float polar, float azimuth)
     DirectX::XMVECTOR Eye = DirectX::XMVectorAdd(m_EyeFocusPoint, DirectX::XMVectorSet(x, y, z, 0.0f));
     DirectX::XMVECTOR Up = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
     m_View = DirectX::XMMatrixLookAtLH(Eye, At, Up);
+    DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(m_LodView.eye), Eye);
     m_Forward = DirectX::XMVector3Normalize(DirectX::XMVectorSubtract(At, Eye));
     m_Right = DirectX::XMVector3Cross(m_Forward, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
 }
@@ -73,6 +75,7 @@ void OrbitCamera::Update(double deltaTime)
     m_ModelView = m_World * m_View;
     m_ViewProjection = m_View * m_Projection;
     m_ModelViewProjection = m_World * m_View * m_Projection;
+    m_Frustum = ExtractFrustum(m_ViewProjection);
 }
 
 DirectX::XMMATRIX& OrbitCamera::GetMV()
@@ -2,6 +2,9 @@
 
 #include <directxmath.h>
 
+#include "Culling.h"
+#include "LodSelection.h"
+
 class OrbitCamera
 {
 public:
@@ -26,6 +29,9 @@ public:
     DirectX::XMMATRIX& GetVP();
     DirectX::XMMATRIX& GetView();
 
+    const Frustum& GetFrustum() const { return m_Frustum; }
+    const LodView& GetLodView() const { return m_LodView; }
+
 private:
     DirectX::XMMATRIX m_World;      // The Model transform matrix
     DirectX::XMMATRIX m_View;       // The View (Camera) matrix
@@ -35,6 +41,9 @@ private:
     DirectX::XMMATRIX m_ViewProjection;
     DirectX::XMMATRIX m_ModelViewProjection;
 
+    Frustum m_Frustum;              // The view frustum, in world space
+    LodView m_LodView;              // The eye position and projection scale, for picking levels of detail
+
     DirectX::XMVECTOR m_EyeFocusPoint = { 0.0f };
     DirectX::XMVECTOR m_Forward = { 0.0f, 0.0f, 1.0f };
     DirectX::XMVECTOR m_Right = { 1.0f, 0.0f, 0.0f };
@@ -58,6 +58,8 @@ struct GameData
     bool m_showTransform01 = true;
     bool m_showTransform02 = true;
 
+    int m_propCount = 0;   // Copies of the gizmo in the prop field, for stress testing instancing
+
     OrbitCamera* m_Camera = nullptr;
 
     LightData m_Light = { 0 };
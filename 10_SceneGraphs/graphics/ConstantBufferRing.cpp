@@ -0,0 +1,218 @@
+#include "ConstantBufferRing.h"
+
+#include <cstring>
+#include <thread>
+
+#include "framework.h"
+
+// Debug names for some of the D3D11 resources we'll be creating
+#ifdef _DEBUG
+constexpr char c_constantBufferRingID[] = "constantBufferRing";
+#endif
+
+ConstantBufferRing::~ConstantBufferRing()
+{
+    Cleanup();
+}
+
+/// @brief Create the ring buffer and the queries used to track the frames in flight
+/// @param pD3D11Device D3D11 Device
+/// @param size Size of the ring in bytes. Rounded up to a multiple of the slice alignment.
+/// @return S_OK if successful, E_NOTIMPL if the device can't bind constant buffers at an offset,
+/// or the error from creating the buffer or queries
+HRESULT ConstantBufferRing::Initialize(ID3D11Device* pD3D11Device, uint32_t size)
+{
+    PLOG_INFO << "Creating the constant buffer ring";
+
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    if (FAILED(pD3D11Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))
+        || !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+    {
+        PLOG_ERROR << "The device doesn't support constant buffer offsets or no-overwrite maps on constant buffers.";
+        return E_NOTIMPL;
+    }
+
+    size = (size + SliceAlignment - 1) & ~(SliceAlignment - 1);
+
+    D3D11_BUFFER_DESC ringDesc = {};
+    ringDesc.ByteWidth = size;
+    ringDesc.Usage = D3D11_USAGE_DYNAMIC;
+    ringDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    ringDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    auto hr = pD3D11Device->CreateBuffer(&ringDesc, nullptr, &m_buffer);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create the constant buffer ring.";
+        return hr;
+    }
+
+#ifdef _DEBUG
+    m_buffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_constantBufferRingID) - 1, c_constantBufferRingID);
+#endif // DEBUG
+
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_EVENT;
+
+    for (auto& query : m_frameQueries)
+    {
+        hr = pD3D11Device->CreateQuery(&queryDesc, &query);
+        if (FAILED(hr))
+        {
+            PLOG_ERROR << "Failed to create a frame query for the constant buffer ring.";
+            return hr;
+        }
+    }
+
+    m_allocator.Reset(size);
+    m_frameFence = 1;
+    m_completedFence = 0;
+    m_discardOnMap = true;
+
+    return S_OK;
+}
+
+/// @brief Has the GPU finished the frame with the given fence value?
+/// @param wait Block until it has
+bool ConstantBufferRing::IsFrameComplete(ID3D11DeviceContext* pD3D11DeviceContext, uint64_t fenceValue, bool wait)
+{
+    if (fenceValue <= m_completedFence)
+        return true;
+
+    auto query = m_frameQueries[fenceValue % MaxFramesInFlight];
+    if (!wait)
+        return pD3D11DeviceContext->GetData(query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+
+    // GetData without DONOTFLUSH makes sure the query actually gets to the GPU
+    while (pD3D11DeviceContext->GetData(query, nullptr, 0, 0) == S_FALSE)
+    {
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+/// @brief Give back the space of every frame the GPU has finished with
+/// @param waitForOldest Block on the oldest frame in flight if it isn't done yet
+void ConstantBufferRing::RetireCompletedFrames(ID3D11DeviceContext* pD3D11DeviceContext, bool waitForOldest)
+{
+    bool wait = waitForOldest;
+    while (m_completedFence + 1 < m_frameFence && IsFrameComplete(pD3D11DeviceContext, m_completedFence + 1, wait))
+    {
+        m_completedFence++;
+        wait = false;
+    }
+
+    m_allocator.Retire(m_completedFence);
+}
+
+/// @brief Start a frame. Frees what finished frames used, and waits for the GPU if it is so far
+/// behind that the query for this frame is still in use.
+void ConstantBufferRing::BeginFrame(ID3D11DeviceContext* pD3D11DeviceContext)
+{
+    bool tooManyInFlight = m_frameFence - m_completedFence > MaxFramesInFlight;
+    RetireCompletedFrames(pD3D11DeviceContext, tooManyInFlight);
+}
+
+/// @brief Finish the frame. Everything allocated since BeginFrame stays untouched until the GPU
+/// gets past this point.
+void ConstantBufferRing::EndFrame(ID3D11DeviceContext* pD3D11DeviceContext)
+{
+    pD3D11DeviceContext->End(m_frameQueries[m_frameFence % MaxFramesInFlight]);
+
+    m_allocator.EndFrame(m_frameFence);
+    m_frameFence++;
+}
+
+/// @brief Map the ring for writing. Only the slices handed out by Allocate may be written.
+/// @return true if the ring is mapped
+bool ConstantBufferRing::Map(ID3D11DeviceContext* pD3D11DeviceContext)
+{
+    D3D11_MAP mapType = m_discardOnMap ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+    D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+    if (FAILED(pD3D11DeviceContext->Map(m_buffer, 0, mapType, 0, &mappedSubresource)))
+    {
+        PLOG_ERROR << "Failed to map the constant buffer ring.";
+        return false;
+    }
+
+    m_mappedData = static_cast<uint8_t*>(mappedSubresource.pData);
+    m_discardOnMap = false;
+    return true;
+}
+
+/// @brief Allocate a slice of the ring for this frame. The ring has to be mapped.
+/// @param size Size of the constants in bytes
+/// @param cpuAddress Where to write the constants
+/// @return The slice to bind, or an empty slice if the ring is full
+ConstantBufferSlice ConstantBufferRing::Allocate(ID3D11DeviceContext* pD3D11DeviceContext, uint32_t size, void** cpuAddress)
+{
+    uint32_t sliceSize = (size + SliceAlignment - 1) & ~(SliceAlignment - 1);
+
+    uint64_t offset = m_allocator.Allocate(sliceSize, SliceAlignment);
+    while (offset == RingAllocator::InvalidOffset && m_completedFence + 1 < m_frameFence)
+    {
+        // Full, but there are older frames still holding on to space; wait for the oldest of them
+        RetireCompletedFrames(pD3D11DeviceContext, true);
+        offset = m_allocator.Allocate(sliceSize, SliceAlignment);
+    }
+
+    if (offset == RingAllocator::InvalidOffset)
+    {
+        if (!m_reportedFull)
+            PLOG_ERROR << "The constant buffer ring is too small for a single frame's constants.";
+        m_reportedFull = true;
+
+        *cpuAddress = nullptr;
+        return ConstantBufferSlice();
+    }
+
+    *cpuAddress = m_mappedData + offset;
+
+    ConstantBufferSlice slice;
+    slice.buffer = m_buffer;
+    slice.firstConstant = static_cast<uint32_t>(offset / 16);
+    slice.constantCount = sliceSize / 16;
+    return slice;
+}
+
+void ConstantBufferRing::Unmap(ID3D11DeviceContext* pD3D11DeviceContext)
+{
+    pD3D11DeviceContext->Unmap(m_buffer, 0);
+    m_mappedData = nullptr;
+}
+
+/// @brief Copy some constants into a new slice. Maps and unmaps the ring, so when there are lots of
+/// them, Map, Allocate and Unmap are cheaper.
+ConstantBufferSlice ConstantBufferRing::Upload(ID3D11DeviceContext* pD3D11DeviceContext, const void* data, uint32_t size)
+{
+    if (!Map(pD3D11DeviceContext))
+        return ConstantBufferSlice();
+
+    void* cpuAddress = nullptr;
+    auto slice = Allocate(pD3D11DeviceContext, size, &cpuAddress);
+    if (cpuAddress != nullptr)
+        memcpy(cpuAddress, data, size);
+
+    Unmap(pD3D11DeviceContext);
+    return slice;
+}
+
+void ConstantBufferRing::Cleanup()
+{
+    for (auto& query : m_frameQueries)
+    {
+        if (query != nullptr)
+        {
+            query->Release();
+            query = nullptr;
+        }
+    }
+
+    if (m_buffer != nullptr)
+    {
+        m_buffer->Release();
+        m_buffer = nullptr;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <d3d11_1.h>
+
+#include "RingAllocator.h"
+#include "StateCache.h"
+
+/// @brief One large dynamic constant buffer that per-draw constants are suballocated from.
+///
+/// Instead of every renderable owning a small constant buffer and mapping it with WRITE_DISCARD for
+/// each draw, the frame's constants are written into 256 byte aligned slices of this buffer, with
+/// a single map, and bound with VSSetConstantBuffers1 offsets. The space a frame used is handed back
+/// once an event query issued at the end of the frame says the GPU is done with it; everything after
+/// the first map uses WRITE_NO_OVERWRITE. Needs a D3D11.1 runtime (constant buffer offsetting).
+class ConstantBufferRing
+{
+public:
+    static constexpr uint32_t SliceAlignment = 256;     // constant buffer offsets are multiples of 16 constants
+    static constexpr uint32_t MaxFramesInFlight = 3;
+
+    ConstantBufferRing() = default;
+    ~ConstantBufferRing();
+
+    HRESULT Initialize(ID3D11Device* pD3D11Device, uint32_t size);
+
+    void BeginFrame(ID3D11DeviceContext* pD3D11DeviceContext);
+    void EndFrame(ID3D11DeviceContext* pD3D11DeviceContext);
+
+    bool Map(ID3D11DeviceContext* pD3D11DeviceContext);
+    ConstantBufferSlice Allocate(ID3D11DeviceContext* pD3D11DeviceContext, uint32_t size, void** cpuAddress);
+    void Unmap(ID3D11DeviceContext* pD3D11DeviceContext);
+
+    ConstantBufferSlice Upload(ID3D11DeviceContext* pD3D11DeviceContext, const void* data, uint32_t size);
+
+    const RingAllocatorStats& GetStats() const { return m_allocator.GetStats(); }
+
+    void Cleanup();
+
+private:
+    bool IsFrameComplete(ID3D11DeviceContext* pD3D11DeviceContext, uint64_t fenceValue, bool wait);
+    void RetireCompletedFrames(ID3D11DeviceContext* pD3D11DeviceContext, bool waitForOldest);
+
+    ID3D11Buffer* m_buffer = nullptr;                       // The ring itself
+    ID3D11Query* m_frameQueries[MaxFramesInFlight] = {};    // Event queries marking the end of each frame in flight
+    uint8_t* m_mappedData = nullptr;                        // CPU address of the ring while it is mapped
+
+    RingAllocator m_allocator;
+    uint64_t m_frameFence = 1;      // Fence value of the frame being recorded
+    uint64_t m_completedFence = 0;  // Last fence value the GPU is known to have passed
+    bool m_discardOnMap = true;     // The first map has to discard, everything after can be no-overwrite
+    bool m_reportedFull = false;
+};
@@ -17,4 +17,15 @@ struct LightConstantBuffer
 {
     DirectX::XMFLOAT4 mLightPosition;
     DirectX::XMFLOAT4 mDiffuse;
+};
+
+/// @brief Per submesh constants, in register b2 of the mesh vertex shaders. Positions arrive
+/// as 16 bit unorms and are expanded to positionOffset + position * positionScale. x of mMaterial
+/// is the slice of the bound texture array the submesh samples.
+struct MeshConstantBuffer
+{
+    DirectX::XMFLOAT4 mPositionScale;
+    DirectX::XMFLOAT4 mPositionOffset;
+    DirectX::XMFLOAT4 mDiffuse;
+    DirectX::XMUINT4 mMaterial;
 };
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "CookedMeshLoader.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "plog/Log.h"
+
+namespace
+{
+    // Touching one byte in each page is enough to have the whole file read in
+    constexpr size_t c_pageSize = 4096;
+}
+
+/// @brief Find the cooked version of a source asset: a .wtgm file next to it with the same name.
+/// A cooked file older than its source is ignored, so an edited asset isn't hidden by a stale one.
+/// @return The path of the cooked mesh, or an empty path if there isn't a usable one
+std::filesystem::path FindCookedMesh(const std::filesystem::path& sourcePath)
+{
+    std::filesystem::path cookedPath = sourcePath;
+    cookedPath.replace_extension(c_cookedMeshExtension);
+
+    std::error_code error;
+    if (!std::filesystem::exists(cookedPath, error))
+        return {};
+
+    if (cookedPath != sourcePath && std::filesystem::exists(sourcePath, error)
+        && std::filesystem::last_write_time(sourcePath, error) > std::filesystem::last_write_time(cookedPath, error))
+    {
+        PLOG_WARNING << "Ignoring " << cookedPath << " as it is older than " << sourcePath << "; run MeshCooker again";
+        return {};
+    }
+
+    return cookedPath;
+}
+
+/// @brief Map a cooked mesh and check it can be drawn with the vertex format the caller uses.
+/// Every page of the file is touched, so it is read from disk here rather than when the buffers
+/// are created from it.
+/// @param vertexFormat The vertex format the caller draws with; files in any other are rejected
+bool OpenCookedMesh(const std::filesystem::path& path, CookedVertexFormat vertexFormat, OpenedCookedMesh& mesh)
+{
+    if (!mesh.file.Open(path.string()))
+    {
+        PLOG_ERROR << "Failed to map cooked mesh " << path;
+        return false;
+    }
+
+    if (!mesh.view.Open(mesh.file.GetData(), mesh.file.GetSize()))
+    {
+        PLOG_ERROR << "Cooked mesh " << path << " is unusable: " << mesh.view.GetError();
+        return false;
+    }
+
+    const auto& header = mesh.view.GetHeader();
+    if (header.vertexCount == 0 || header.indexCount == 0)
+    {
+        PLOG_ERROR << "Cooked mesh " << path << " is empty";
+        return false;
+    }
+
+    if (mesh.view.GetVertexFormat() != vertexFormat)
+    {
+        PLOG_ERROR << "Cooked mesh " << path << " has vertex format " << header.vertexFormat << ", expected "
+                   << static_cast<uint32_t>(vertexFormat);
+        return false;
+    }
+
+    if (header.submeshCount == 0)
+    {
+        PLOG_ERROR << "Cooked mesh " << path << " has no submeshes";
+        return false;
+    }
+
+    const auto* bytes = static_cast<const volatile uint8_t*>(mesh.file.GetData());
+    uint8_t touched = 0;
+    for (size_t offset = 0; offset < mesh.file.GetSize(); offset += c_pageSize)
+    {
+        touched ^= bytes[offset];
+    }
+    (void)touched;
+
+    return true;
+}
+
+/// @brief Create the renderable for a cooked mesh that has been opened: one vertex and one index
+/// buffer handed straight to D3D from the mapping, without touching the vertices on the CPU, drawn
+/// as the file's submeshes.
+/// @param renderables Where to add the new renderable, with the submeshes' levels of detail. The
+/// caller owns it.
+/// @param localBounds Set to the bounds stored in the file
+/// @param textureSlices The texture array slice of each of the file's materials, for textured
+/// meshes
+bool CreateCookedRenderables(
+    const OpenedCookedMesh& opened,
+    ID3D11Device* pD3D11Device,
+    std::vector<Renderable*>& renderables,
+    Bounds& localBounds,
+    const std::vector<uint32_t>& textureSlices)
+{
+    const auto& mesh = opened.view;
+    const auto& header = mesh.GetHeader();
+
+    // Each submesh is its own run of vertices and indices, with its own quantization and material
+    std::vector<SubmeshData> submeshes;
+    uint32_t nextLod = 0;
+    for (uint32_t index = 0; index < header.submeshCount; index++)
+    {
+        SubmeshData data;
+
+        // The LOD table is sorted by submesh, so this submesh's levels are the next run of it
+        for (; nextLod < header.lodCount && mesh.GetLods()[nextLod].submeshIndex == index; nextLod++)
+        {
+            const auto& lod = mesh.GetLods()[nextLod];
+            data.lods.push_back(LodLevel{ lod.firstIndex, lod.indexCount, lod.error });
+        }
+
+        const auto& submesh = mesh.GetSubmeshes()[index];
+        if (submesh.indexCount == 0)
+            continue;
+
+        data.firstIndex = submesh.firstIndex;
+        data.indexCount = submesh.indexCount;
+        data.firstVertex = submesh.firstVertex;
+        data.vertexCount = submesh.vertexCount;
+        data.material = submesh.materialIndex;
+        std::copy(std::begin(submesh.positionScale), std::end(submesh.positionScale), data.quantization.scale);
+        std::copy(std::begin(submesh.positionOffset), std::end(submesh.positionOffset), data.quantization.offset);
+        submeshes.push_back(std::move(data));
+    }
+
+    std::vector<MaterialData> materials(header.materialCount);
+    for (uint32_t index = 0; index < header.materialCount; index++)
+    {
+        const auto& material = mesh.GetMaterials()[index];
+        std::copy(std::begin(material.diffuse), std::end(material.diffuse), materials[index].diffuse);
+    }
+
+    DXGI_FORMAT indexFormat = header.indexSize == sizeof(uint32_t) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    auto renderable = new Renderable();
+    if (!renderable->CreateBuffers(mesh.GetVertices(), header.vertexCount, header.vertexStride, mesh.GetIndices(), header.indexCount, indexFormat, pD3D11Device)
+        || !renderable->CreateSubmeshConstants(submeshes, materials, textureSlices, pD3D11Device))
+    {
+        delete renderable;
+        return false;
+    }
+    renderables.push_back(renderable);
+
+    localBounds.center = { header.boundsCenter[0], header.boundsCenter[1], header.boundsCenter[2] };
+    localBounds.extents = { header.boundsExtents[0], header.boundsExtents[1], header.boundsExtents[2] };
+    localBounds.radius = header.boundsRadius;
+
+    return true;
+}
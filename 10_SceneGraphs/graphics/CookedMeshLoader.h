@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <d3d11.h>
+
+#include "CookedMesh.h"
+#include "Culling.h"
+#include "MappedFile.h"
+#include "Renderable.h"
+
+/// @brief A cooked mesh that has been mapped and checked, waiting for its buffers to be created.
+/// Opening one does all of the file reading, so it can be done on a loader thread.
+struct OpenedCookedMesh
+{
+    MappedFile file;
+    CookedMeshView view;
+};
+
+std::filesystem::path FindCookedMesh(const std::filesystem::path& sourcePath);
+
+bool OpenCookedMesh(const std::filesystem::path& path, CookedVertexFormat vertexFormat, OpenedCookedMesh& mesh);
+
+bool CreateCookedRenderables(
+    const OpenedCookedMesh& mesh,
+    ID3D11Device* pD3D11Device,
+    std::vector<Renderable*>& renderables,
+    Bounds& localBounds,
+    const std::vector<uint32_t>& textureSlices = {});
+
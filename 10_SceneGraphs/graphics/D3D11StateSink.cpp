@@ -0,0 +1,99 @@
+#include "D3D11StateSink.h"
+#include "framework.h"
+
+D3D11StateSink::~D3D11StateSink()
+{
+    if (m_D3DContext1 != nullptr)
+    {
+        m_D3DContext1->Release();
+        m_D3DContext1 = nullptr;
+    }
+}
+
+void D3D11StateSink::SetContext(ID3D11DeviceContext* pD3D11DeviceContext)
+{
+    if (m_D3DContext1 != nullptr)
+    {
+        m_D3DContext1->Release();
+        m_D3DContext1 = nullptr;
+    }
+
+    m_D3DContext = pD3D11DeviceContext;
+
+    // Binding at an offset needs the D3D11.1 interface; without it only whole buffers can be bound
+    if (m_D3DContext != nullptr && FAILED(m_D3DContext->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&m_D3DContext1))))
+    {
+        PLOG_ERROR << "The device context doesn't support ID3D11DeviceContext1; constant buffer slices can't be bound.";
+        m_D3DContext1 = nullptr;
+    }
+}
+
+void D3D11StateSink::IASetPrimitiveTopology(uint32_t topology)
+{
+    m_D3DContext->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+void D3D11StateSink::IASetInputLayout(ID3D11InputLayout* inputLayout)
+{
+    m_D3DContext->IASetInputLayout(inputLayout);
+}
+
+void D3D11StateSink::IASetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset)
+{
+    UINT strides[] = { stride };
+    UINT offsets[] = { offset };
+    m_D3DContext->IASetVertexBuffers(slot, 1, &buffer, strides, offsets);
+}
+
+void D3D11StateSink::IASetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset)
+{
+    m_D3DContext->IASetIndexBuffer(buffer, static_cast<DXGI_FORMAT>(format), offset);
+}
+
+void D3D11StateSink::VSSetShader(ID3D11VertexShader* shader)
+{
+    m_D3DContext->VSSetShader(shader, nullptr, 0);
+}
+
+void D3D11StateSink::PSSetShader(ID3D11PixelShader* shader)
+{
+    m_D3DContext->PSSetShader(shader, nullptr, 0);
+}
+
+void D3D11StateSink::VSSetConstantBuffer(uint32_t slot, const ConstantBufferSlice& slice)
+{
+    if (slice.constantCount == 0 || m_D3DContext1 == nullptr)
+    {
+        m_D3DContext->VSSetConstantBuffers(slot, 1, &slice.buffer);
+        return;
+    }
+
+    UINT firstConstants[] = { slice.firstConstant };
+    UINT constantCounts[] = { slice.constantCount };
+    m_D3DContext1->VSSetConstantBuffers1(slot, 1, &slice.buffer, firstConstants, constantCounts);
+}
+
+void D3D11StateSink::PSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer)
+{
+    m_D3DContext->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void D3D11StateSink::PSSetShaderResource(uint32_t slot, ID3D11ShaderResourceView* view)
+{
+    m_D3DContext->PSSetShaderResources(slot, 1, &view);
+}
+
+void D3D11StateSink::PSSetSampler(uint32_t slot, ID3D11SamplerState* sampler)
+{
+    m_D3DContext->PSSetSamplers(slot, 1, &sampler);
+}
+
+void D3D11StateSink::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+    m_D3DContext->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void D3D11StateSink::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    m_D3DContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <d3d11_1.h>
+
+#include "StateCache.h"
+
+/// @brief Passes the calls the StateCache lets through on to a D3D11 device context
+class D3D11StateSink : public StateCommandSink
+{
+public:
+    D3D11StateSink() = default;
+
+    ~D3D11StateSink();
+
+    void SetContext(ID3D11DeviceContext* pD3D11DeviceContext);
+
+    void IASetPrimitiveTopology(uint32_t topology) override;
+    void IASetInputLayout(ID3D11InputLayout* inputLayout) override;
+    void IASetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset) override;
+    void IASetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset) override;
+    void VSSetShader(ID3D11VertexShader* shader) override;
+    void PSSetShader(ID3D11PixelShader* shader) override;
+    void VSSetConstantBuffer(uint32_t slot, const ConstantBufferSlice& slice) override;
+    void PSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer) override;
+    void PSSetShaderResource(uint32_t slot, ID3D11ShaderResourceView* view) override;
+    void PSSetSampler(uint32_t slot, ID3D11SamplerState* sampler) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+    void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+private:
+    ID3D11DeviceContext* m_D3DContext = nullptr; // Not owned; the context belongs to GraphicsDX11
+    ID3D11DeviceContext1* m_D3DContext1 = nullptr; // The same context, for binding constant buffer slices
+};
@@ -4,6 +4,9 @@
 #include "ResourceManager.h"
 
 #include "framework.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <dxgidebug.h>
 
 // Debug names for some of the D3D11 resources we'll be creating
@@ -14,10 +17,27 @@ constexpr char c_constantBufferID[] = "matrixConstantBuffer";
 constexpr char c_lightConstantBufferID[] = "lightconstantBuffer";
 constexpr char c_depthStencilBufferID[] = "depthStencilBuffer";
 constexpr char c_rasterizerStateID[] = "rasterizerState";
+constexpr char c_instanceBufferID[] = "instanceBuffer";
 #endif // DEBUG
 
 std::shared_ptr<SceneNode> GraphicsDX11::m_SceneRoot;
 
+// Room for the per-draw constants of a few frames; at 256 bytes a draw that's 16k draws
+constexpr uint32_t c_constantBufferRingSize = 4 * 1024 * 1024;
+
+// Smallest instance buffer we bother creating; it doubles from there when a frame needs more
+constexpr uint32_t c_minInstanceBufferCapacity = 1024;
+
+// Main thread time each frame may spend creating the GPU resources of assets that have loaded
+constexpr double c_uploadBudgetMilliseconds = 2.0;
+
+// Most memory that textures being loaded may hold at once, decoded and waiting to be uploaded
+constexpr size_t c_imageStagingBudget = 256 * 1024 * 1024;
+
+// Spacing of the prop field, and how far below the rest of the scene it sits
+constexpr float c_propSpacing = 1.5f;
+constexpr float c_propFieldHeight = -3.0f;
+
 
 /// @brief Utility function for getting the Texture that represents the backbuffer
 /// @param swapChain DXGI Swapchain to work from
@@ -93,6 +113,9 @@ HRESULT GraphicsDX11::CreateD3D11DeviceAndContext(HWND hWnd,
         return hr;
     }
 
+    m_stateSink.SetContext(m_D3DContext);
+    m_stateCache.SetSink(&m_stateSink);
+
     return S_OK;
 }
 
@@ -125,17 +148,26 @@ HRESULT GraphicsDX11::CreateD3D11Context(ID3D11Device* device, ID3D11DeviceConte
 /// @return S_OK if we were able to compile the shaders
 HRESULT GraphicsDX11::LoadAndCompileShaders()
 {
-    m_texturedShader = std::make_shared<Shader>();
-    m_texturedShader->Compile(m_D3DDevice, L"vsTexturedShader.hlsl", L"psTexturedShader.hlsl", IALayout_VertexColorNormalUV);
+    // The shaders are held for the life of the renderer, so their handles are never released;
+    // Cleanup drops the lot
+    m_texturedShader = m_resources.GetShader(m_resources.AcquireShader(L"vsTexturedShader.hlsl", L"psTexturedShader.hlsl", IALayout_PackedVertexNormalUV));
+    m_simpleLit = m_resources.GetShader(m_resources.AcquireShader(L"SimpleLit.hlsl", L"SimpleLit.hlsl", IALayout_PackedVertexNormal));
+    m_lightGeometryShader = m_resources.GetShader(m_resources.AcquireShader(L"LightGeometry.hlsl", L"LightGeometry.hlsl", IALayout_VertexColor));
+    m_shader = m_resources.GetShader(m_resources.AcquireShader(L"CombinedShader02.hlsl", L"CombinedShader02.hlsl", IALayout_VertexColor));
+    if (m_texturedShader == nullptr || m_simpleLit == nullptr || m_lightGeometryShader == nullptr || m_shader == nullptr)
+        return S_FALSE;
 
-    m_simpleLit = std::make_shared<Shader>();
-    m_simpleLit->Compile(m_D3DDevice, L"SimpleLit.hlsl", IALayout_VertexColorNormal);
+    // Instanced variants only replace the vertex shader; the pixel shaders are shared. Without
+    // them, draws just aren't instanced.
+    m_texturedShaderInstanced = m_resources.GetShader(m_resources.AcquireShader(L"vsTexturedShaderInstanced.hlsl", L"psTexturedShader.hlsl", IALayout_PackedVertexNormalUVInstanced));
+    if (m_texturedShaderInstanced != nullptr)
+        m_texturedShader->SetInstancedVariant(m_texturedShaderInstanced);
 
-    m_lightGeometryShader = std::make_shared<Shader>();
-    m_lightGeometryShader->Compile(m_D3DDevice, L"LightGeometry.hlsl", IALayout_VertexColor);
+    m_simpleLitInstanced = m_resources.GetShader(m_resources.AcquireShader(L"SimpleLitInstanced.hlsl", L"SimpleLit.hlsl", IALayout_PackedVertexNormalInstanced));
+    if (m_simpleLitInstanced != nullptr)
+        m_simpleLit->SetInstancedVariant(m_simpleLitInstanced);
 
-    m_shader = std::make_shared<Shader>();
-    return m_shader->Compile(m_D3DDevice, L"CombinedShader02.hlsl", IALayout_VertexColor);
+    return S_OK;
 }
 
 /// @brief Create the Vertex and Index buffers, as well as the input layout
@@ -144,7 +176,13 @@ HRESULT GraphicsDX11::CreateVertexAndIndexBuffers()
 {
     PLOG_INFO << "Creating the vertex and Index Buffers for General Purpose use";
 
-    m_SceneRoot = std::make_shared<SceneNode>();
+    m_transformHierarchy = std::make_shared<TransformHierarchy>();
+    m_jobSystem = std::make_shared<JobSystem>();
+    m_transformHierarchy->SetJobSystem(m_jobSystem);
+    m_imagePool = std::make_unique<ImagePool>(c_imageStagingBudget);
+    m_assetLoader = std::make_unique<AsyncLoader>();
+
+    m_SceneRoot = std::make_shared<SceneNode>(m_transformHierarchy);
     m_SceneRoot->name = "Root";
     m_SceneRoot->SetLocalTransform(DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.0f));
 
@@ -172,80 +210,158 @@ HRESULT GraphicsDX11::CreateVertexAndIndexBuffers()
         return S_FALSE;
     }
 
+    if (FAILED(m_constantBufferRing.Initialize(m_D3DDevice, c_constantBufferRingSize)))
+    {
+        PLOG_ERROR << "Failed to create the constant buffer ring.";
+        return S_FALSE;
+    }
+
 #ifdef _DEBUG
     m_viewProjectionConstantBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_constantBufferID) - 1, c_constantBufferID);
     m_lightConstantBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_lightConstantBufferID) - 1, c_lightConstantBufferID);
 #endif // DEBUG
 
-    m_cube = std::make_shared<Cube>();
-    m_plane = std::make_shared<Plane>();
+    m_cube = std::make_shared<ProceduralMesh>();
+    m_plane = std::make_shared<ProceduralMesh>();
     m_light = std::make_shared<Light>();
-    m_sphere = std::make_shared<Sphere>();
+    m_sphere = std::make_shared<ProceduralMesh>();
     m_grid = std::make_shared<Grid>();
-    m_gizmoXYZ01 = std::make_shared<Mesh>();
-    m_gizmoXYZ02 = std::make_shared<Mesh>();
-    m_texturedMesh = std::make_shared<TexturedMesh>();
 
-    m_cube->Initialize(m_D3DDevice);
+    m_cube->Initialize(m_primitiveCache, MakeCubeDesc(1.0f), m_D3DDevice, m_lightConstantBuffer);
     m_grid->Initialize(m_D3DDevice);
-    m_plane->Initialize(m_D3DDevice);
+    m_plane->Initialize(m_primitiveCache, MakePlaneDesc(2.0f, 2.0f), m_D3DDevice, m_lightConstantBuffer);
     m_light->Initialize(m_D3DDevice, m_lightConstantBuffer);
-    m_sphere->Initialize(m_D3DDevice, m_lightConstantBuffer, 0.25f, 12, 6);
-    m_gizmoXYZ01->Initialize(m_D3DDevice, m_lightConstantBuffer);
-    m_gizmoXYZ02->Initialize(m_D3DDevice, m_lightConstantBuffer);
-    m_texturedMesh->Initialize(m_D3DDevice, m_lightConstantBuffer);
-    m_gizmoXYZ01->LoadFromFile(m_D3DContext, "gizmoxyz.fbx");
-    m_gizmoXYZ02->LoadFromFile(m_D3DContext, "gizmoxyz.fbx");
-    m_texturedMesh->LoadFromFile(m_D3DContext, "brickCube.fbx");
-
-    auto gridNode = std::make_shared<SceneNode>();
+    m_sphere->Initialize(m_primitiveCache, MakeSphereDesc(0.5f, 48, 24), m_D3DDevice, m_lightConstantBuffer);
+
+    // The meshes load in the background, drawn as a plain cube until they are ready
+    Bounds placeholderBounds;
+    auto placeholder = m_primitiveCache.Acquire(MakeCubeDesc(1.0f), m_D3DDevice, placeholderBounds);
+    m_resources.SetMeshDefaults(m_lightConstantBuffer, m_assetLoader.get(), m_imagePool.get(), m_jobSystem.get(), placeholder, placeholderBounds);
+    m_gizmoXYZ = m_resources.GetMesh(m_resources.AcquireMesh("gizmoxyz.fbx"));
+    m_texturedMesh = m_resources.GetTexturedMesh(m_resources.AcquireTexturedMesh("brickCube.fbx"));
+
+    auto gridNode = std::make_shared<SceneNode>(m_transformHierarchy);
     gridNode->name = "Grid";
     gridNode->SetRenderable(m_grid, m_shader);
     gridNode->SetLocalTranslation(0.0f, 0.0f, 0.0f);
     m_SceneRoot->AddChild(gridNode);
 
-    auto cubeNode = std::make_shared<SceneNode>();
+    auto cubeNode = std::make_shared<SceneNode>(m_transformHierarchy);
     cubeNode->name = "Cube";
-    cubeNode->SetRenderable(m_cube, m_shader);
+    cubeNode->SetRenderable(m_cube, m_simpleLit);
     cubeNode->SetLocalTranslation(0.0f, 0.0f, 0.0f);
     m_SceneRoot->AddChild(cubeNode);
 
-    auto planeNode = std::make_shared<SceneNode>();
+    auto planeNode = std::make_shared<SceneNode>(m_transformHierarchy);
     planeNode->name = "Plane";
-    planeNode->SetRenderable(m_plane, m_shader);
+    planeNode->SetRenderable(m_plane, m_simpleLit);
     planeNode->SetLocalTranslation(1.5f, 0.0f, 0.0f);
     m_SceneRoot->AddChild(planeNode);
 
-    m_lightSceneNode = std::make_shared<SceneNode>();
+    m_lightSceneNode = std::make_shared<SceneNode>(m_transformHierarchy);
     m_lightSceneNode->name = "Light";
     m_lightSceneNode->SetRenderable(m_light, m_lightGeometryShader);
     m_lightSceneNode->SetLocalTranslation(1.5f, 2.0f, 1.0f);
     m_SceneRoot->AddChild(m_lightSceneNode);
 
-    auto sphereNode = std::make_shared<SceneNode>();
+    auto sphereNode = std::make_shared<SceneNode>(m_transformHierarchy);
     sphereNode->name = "Sphere";
-    sphereNode->SetRenderable(m_sphere, m_lightGeometryShader);
-    sphereNode->SetLocalTranslation(0.0f, 0.0f, 0.0f);
-    m_lightSceneNode->AddChild(sphereNode);
+    sphereNode->SetRenderable(m_sphere, m_simpleLit);
+    sphereNode->SetLocalTranslation(0.0f, 0.0f, 1.5f);
+    m_SceneRoot->AddChild(sphereNode);
 
-    auto gizmo01Node = std::make_shared<SceneNode>();
+    auto gizmo01Node = std::make_shared<SceneNode>(m_transformHierarchy);
     gizmo01Node->name = "Gizmo 01";
-    gizmo01Node->SetRenderable(m_gizmoXYZ01, m_simpleLit);
+    gizmo01Node->SetRenderable(m_gizmoXYZ, m_simpleLit);
     gizmo01Node->SetLocalTranslation(0.0f, 1.0f, 0.0f);
     m_SceneRoot->AddChild(gizmo01Node);
 
-    auto gizmo02Node = std::make_shared<SceneNode>();
+    auto gizmo02Node = std::make_shared<SceneNode>(m_transformHierarchy);
     gizmo02Node->name = "Gizmo 02";
-    gizmo02Node->SetRenderable(m_gizmoXYZ02, m_simpleLit);
+    gizmo02Node->SetRenderable(m_gizmoXYZ, m_simpleLit);
     gizmo02Node->SetLocalTranslation(0.0f, -1.0f, 0.0f);
     m_SceneRoot->AddChild(gizmo02Node);
 
-    auto texturedMeshNode = std::make_shared<SceneNode>();
+    auto texturedMeshNode = std::make_shared<SceneNode>(m_transformHierarchy);
     texturedMeshNode->name = "Textured Mesh";
     texturedMeshNode->SetRenderable(m_texturedMesh, m_texturedShader);
     texturedMeshNode->SetLocalTranslation(-1.0f, 0.0f, 0.0f);
     m_SceneRoot->AddChild(texturedMeshNode);
 
+    m_propsNode = std::make_shared<SceneNode>(m_transformHierarchy);
+    m_propsNode->name = "Props";
+    m_propsNode->SetLocalTranslation(0.0f, c_propFieldHeight, 0.0f);
+    m_SceneRoot->AddChild(m_propsNode);
+
+    return S_OK;
+}
+
+/// @brief Fill the prop field with copies of the gizmo, laid out on a square grid. They all share
+/// the same mesh and shader, so they go out as a single instanced draw.
+/// @param count How many copies to make; 0 empties the field
+void GraphicsDX11::SetPropCount(uint32_t count)
+{
+    if (count == m_propCount || m_propsNode == nullptr)
+        return;
+
+    PLOG_INFO << "Setting the prop field to " << count << " copies";
+
+    m_propsNode->RemoveChildren();
+    m_propCount = count;
+    if (count == 0)
+        return;
+
+    uint32_t rowLength = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    float extent = (rowLength - 1) * c_propSpacing * 0.5f;
+
+    for (uint32_t index = 0; index < count; index++)
+    {
+        auto propNode = std::make_shared<SceneNode>(m_transformHierarchy);
+        propNode->name = "Prop " + std::to_string(index);
+        propNode->SetRenderable(m_gizmoXYZ, m_simpleLit);
+        propNode->SetLocalTranslation((index % rowLength) * c_propSpacing - extent, 0.0f, (index / rowLength) * c_propSpacing - extent);
+        propNode->SetLocalRotation(static_cast<float>(index) * 0.1f, 0.0f, 0.0f);
+        m_propsNode->AddChild(propNode);
+    }
+}
+
+/// @brief Make sure the instance buffer can hold at least the given number of world transforms
+HRESULT GraphicsDX11::ReserveInstanceBuffer(uint32_t instanceCount)
+{
+    if (instanceCount <= m_instanceBufferCapacity)
+        return S_OK;
+
+    uint32_t capacity = m_instanceBufferCapacity == 0 ? c_minInstanceBufferCapacity : m_instanceBufferCapacity;
+    while (capacity < instanceCount)
+    {
+        capacity *= 2;
+    }
+
+    if (m_instanceBuffer != nullptr)
+    {
+        m_instanceBuffer->Release();
+        m_instanceBuffer = nullptr;
+        m_instanceBufferCapacity = 0;
+    }
+
+    D3D11_BUFFER_DESC instanceBufferDesc = {};
+    instanceBufferDesc.ByteWidth = capacity * sizeof(DirectX::XMFLOAT4X4);
+    instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    auto hr = m_D3DDevice->CreateBuffer(&instanceBufferDesc, nullptr, &m_instanceBuffer);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create the instance buffer.";
+        return hr;
+    }
+
+#ifdef _DEBUG
+    m_instanceBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_instanceBufferID) - 1, c_instanceBufferID);
+#endif // DEBUG
+
+    m_instanceBufferCapacity = capacity;
     return S_OK;
 }
 
@@ -306,6 +422,14 @@ HRESULT GraphicsDX11::CreateD3DResources()
 {
     PLOG_INFO << "Creating D3D Resources";
 
+    m_resources.Initialize(m_D3DDevice);
+
+    if (FAILED(m_samplers.Initialize(m_D3DDevice)))
+    {
+        PLOG_ERROR << "Unable to create the static samplers";
+        return S_FALSE;
+    }
+
     if (!SUCCEEDED(LoadAndCompileShaders()))
     {
         PLOG_ERROR << "Unable to load and compile shaders.";
@@ -328,9 +452,36 @@ HRESULT GraphicsDX11::CreateD3DResources()
 }
 
 
+RendererStats GraphicsDX11::GetRendererStats() const
+{
+    RendererStats stats;
+    stats.renderQueue = m_renderQueue.GetStats();
+    stats.instancing = m_instanceBatcher.GetStats();
+    stats.stateCache = m_stateCache.GetLastFrameStats();
+    stats.constantBufferRing = m_constantBufferRing.GetStats();
+    std::copy(std::begin(m_lodDraws), std::end(m_lodDraws), stats.lodDraws);
+    if (m_assetLoader != nullptr)
+        stats.assetLoading = m_assetLoader->GetStats();
+    if (m_imagePool != nullptr)
+        stats.imageStaging = m_imagePool->GetStats();
+    stats.resources = m_resources.GetReport();
+    stats.samplers = m_samplers.GetStats();
+    stats.textureArrays = m_resources.GetTextureArrayStats();
+    return stats;
+}
+
 void GraphicsDX11::Update(double deltaTime)
 {
+    // Assets that finished loading get their buffers first, so their bounds are in this update
+    m_assetLoader->ProcessUploads(c_uploadBudgetMilliseconds);
+    m_resources.EndFrame();
+
+    // Once everything has loaded, the staging memory kept for the next texture isn't needed
+    if (m_assetLoader->IsIdle())
+        m_imagePool->Trim();
+
     m_SceneRoot->Update(deltaTime);
+    m_sceneBvh.Update(m_SceneRoot);
 }
 
 /// @brief Render off a frame
@@ -338,6 +489,8 @@ void GraphicsDX11::Update(double deltaTime)
 /// @param winRect RECT that defines the window to render to
 void GraphicsDX11::Render(HWND hWnd, RECT winRect, GameData& data, double increment)
 {
+    m_constantBufferRing.BeginFrame(m_D3DContext);
+
     // Update constant buffer
     {
         D3D11_MAPPED_SUBRESOURCE mappedSubresource;
@@ -365,9 +518,43 @@ void GraphicsDX11::Render(HWND hWnd, RECT winRect, GameData& data, double increm
 
     m_D3DContext->OMSetRenderTargets(1, &m_D3DRenderTargetView, m_depthBufferView);
 
-    m_D3DContext->VSSetConstantBuffers(0, 1, &m_viewProjectionConstantBuffer);
+    m_stateCache.BeginFrame();
+    m_stateCache.VSSetConstantBuffer(0, m_viewProjectionConstantBuffer);
+
+    // The samplers are bound for the whole frame here; materials only bind their textures
+    m_samplers.BindStatic(m_stateCache);
+
+    m_sceneBvh.QueryFrustum(m_frustum, m_visibleNodes);
+
+    m_renderQueue.Clear();
+    std::fill(std::begin(m_lodDraws), std::end(m_lodDraws), 0);
+    for (uint32_t index = 0; index < m_visibleNodes.size(); index++)
+    {
+        m_visibleNodes[index]->Submit(m_renderQueue, m_MVP, index, &m_lodView);
+        m_lodDraws[std::min(m_visibleNodes[index]->GetLod(), c_maxLodLevels - 1)]++;
+    }
+    m_renderQueue.Sort();
+
+    m_instanceBatcher.Build(m_renderQueue.GetPackets(), [this](const DrawPacket& packet)
+        {
+            auto& node = m_visibleNodes[packet.item];
+            auto shader = node->GetShader();
+            return node->GetRenderable()->SupportsInstancing() && shader->GetInstancedVariant() != nullptr;
+        },
+        [this](const DrawPacket& first, const DrawPacket& packet)
+        {
+            // The keys match, but ids that wrapped around can still hide different state. The
+            // material belongs to the renderable, so that and the shader are all there is to check.
+            auto& firstNode = m_visibleNodes[first.item];
+            auto& node = m_visibleNodes[packet.item];
+            return node->GetRenderable() == firstNode->GetRenderable() && node->GetShader() == firstNode->GetShader() &&
+                node->GetLod() == firstNode->GetLod();
+        });
+
+    WriteDrawConstants();
+    SubmitRenderQueue();
 
-    m_SceneRoot->Draw(m_D3DContext);
+    m_constantBufferRing.EndFrame(m_D3DContext);
 
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
@@ -378,6 +565,120 @@ void GraphicsDX11::Render(HWND hWnd, RECT winRect, GameData& data, double increm
     m_D3DContext->Flush();
 }
 
+/// @brief Write the world transforms of the instanced batches into the instance buffer, in a
+/// single map
+/// @return true if the instanced batches can be drawn instanced
+bool GraphicsDX11::WriteInstanceTransforms()
+{
+    uint32_t instanceCount = m_instanceBatcher.GetInstanceCount();
+    if (instanceCount == 0)
+        return false;
+
+    ReserveInstanceBuffer(instanceCount);
+    if (m_instanceBufferCapacity < instanceCount)
+        return false;
+
+    D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+    if (FAILED(m_D3DContext->Map(m_instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource)))
+    {
+        PLOG_ERROR << "Failed to map the instance buffer.";
+        return false;
+    }
+
+    const auto& packets = m_renderQueue.GetPackets();
+    DirectX::XMFLOAT4X4* instances = static_cast<DirectX::XMFLOAT4X4*>(mappedSubresource.pData);
+    for (const auto& batch : m_instanceBatcher.GetBatches())
+    {
+        if (!batch.instanced)
+            continue;
+
+        for (uint32_t index = 0; index < batch.packetCount; index++)
+        {
+            auto& node = m_visibleNodes[packets[batch.firstPacket + index].item];
+            DirectX::XMStoreFloat4x4(&instances[batch.firstInstance + index], node->GetWorldTransform());
+        }
+    }
+
+    m_D3DContext->Unmap(m_instanceBuffer, 0);
+    return true;
+}
+
+/// @brief Write the world transform of every draw that isn't instanced into the constant buffer
+/// ring, all under a single map
+void GraphicsDX11::WriteDrawConstants()
+{
+    const auto& packets = m_renderQueue.GetPackets();
+    m_drawConstants.assign(packets.size(), ConstantBufferSlice());
+
+    m_instancesWritten = WriteInstanceTransforms();
+    if (m_instancesWritten && m_instanceBatcher.GetStats().instances == packets.size())
+        return;
+
+    if (packets.empty() || !m_constantBufferRing.Map(m_D3DContext))
+        return;
+
+    for (const auto& batch : m_instanceBatcher.GetBatches())
+    {
+        if (batch.instanced && m_instancesWritten)
+            continue;
+
+        for (uint32_t index = batch.firstPacket; index < batch.firstPacket + batch.packetCount; index++)
+        {
+            void* cpuAddress = nullptr;
+            m_drawConstants[index] = m_constantBufferRing.Allocate(m_D3DContext, sizeof(LocalToWorldConstantBuffer), &cpuAddress);
+            if (cpuAddress == nullptr)
+                break;
+
+            LocalToWorldConstantBuffer* constants = static_cast<LocalToWorldConstantBuffer*>(cpuAddress);
+            constants->mLocalToWorld = m_visibleNodes[packets[index].item]->GetWorldTransform();
+        }
+    }
+
+    m_constantBufferRing.Unmap(m_D3DContext);
+}
+
+/// @brief Draw everything in the (sorted) render queue. Draws next to each other in the queue
+/// mostly share their state, which the state cache then doesn't bind again; runs of the same
+/// geometry go out as a single instanced draw.
+void GraphicsDX11::SubmitRenderQueue()
+{
+    const auto& packets = m_renderQueue.GetPackets();
+    for (const auto& batch : m_instanceBatcher.GetBatches())
+    {
+        auto& firstNode = m_visibleNodes[packets[batch.firstPacket].item];
+        auto renderable = firstNode->GetRenderable();
+        auto shader = firstNode->GetShader();
+
+        // Draws without a material don't sample any textures, so whatever is bound can stay bound
+        Material* material = renderable->GetMaterial();
+
+        if (batch.instanced && m_instancesWritten)
+        {
+            shader->GetInstancedVariant()->Bind(m_stateCache);
+            if (material != nullptr)
+                material->UseMaterial(m_stateCache);
+
+            // Instances are only batched together when they picked the same level of detail
+            renderable->DrawInstanced(m_stateCache, m_instanceBuffer, batch.packetCount, batch.firstInstance, firstNode->GetLod());
+            continue;
+        }
+
+        // Everything in a batch shares its state, so this only binds anything the first time round
+        shader->Bind(m_stateCache);
+        if (material != nullptr)
+            material->UseMaterial(m_stateCache);
+
+        for (uint32_t index = batch.firstPacket; index < batch.firstPacket + batch.packetCount; index++)
+        {
+            // No constants means the ring ran out of room; skip the draw rather than use stale ones
+            if (m_drawConstants[index].buffer == nullptr)
+                continue;
+
+            renderable->DrawLod(m_stateCache, m_drawConstants[index], m_visibleNodes[packets[index].item]->GetLod());
+        }
+    }
+}
+
 /// @brief Create the Render Target view from the backbuffer
 /// @param device D3D11 Device
 /// @param renderTargetView Reference to the D3D11 Render Target View
@@ -427,26 +728,40 @@ void GraphicsDX11::Cleanup()
 {
     PLOG_INFO << "Cleaning up the resources for the Graphics DX11 class";
 
+    // Nothing may still be loading into the meshes, or be waiting to upload into them
+    m_assetLoader->Shutdown();
+
     // Release all our resources
     m_simpleLit->Cleanup();
     m_shader->Cleanup();
     m_lightGeometryShader->Cleanup();
     m_texturedShader->Cleanup();
+    if (m_simpleLitInstanced != nullptr)
+        m_simpleLitInstanced->Cleanup();
+    if (m_texturedShaderInstanced != nullptr)
+        m_texturedShaderInstanced->Cleanup();
     m_cube->Cleanup();
     m_grid->Cleanup();
     m_plane->Cleanup();
-    m_gizmoXYZ01->Cleanup();
-    m_gizmoXYZ02->Cleanup();
+    m_gizmoXYZ->Cleanup();
     m_texturedMesh->Cleanup();
     m_light->Cleanup();
     m_sphere->Cleanup();
+    m_resources.Cleanup();
+    m_samplers.Cleanup();
+    m_primitiveCache.Cleanup();
 
+    m_constantBufferRing.Cleanup();
+    if (m_instanceBuffer != nullptr)
+        m_instanceBuffer->Release();
     m_viewProjectionConstantBuffer->Release();
     m_lightConstantBuffer->Release();
     m_depthBufferView->Release();
     m_depthStencilState->Release();
     m_rasterizerState->Release();
 
+    m_stateSink.SetContext(nullptr);
+
     m_SwapChain->Release();
     m_D3DRenderTargetView->Release();
     m_D3DContext->Release();
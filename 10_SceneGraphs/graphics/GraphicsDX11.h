@@ -4,17 +4,27 @@
 #include <directxmath.h>
 #include <vector>
 
+#include "AsyncLoader.h"
+#include "ImagePool.h"
 #include "ConstantBuffers.h"
+#include "ConstantBufferRing.h"
+#include "JobSystem.h"
 #include "SceneNode.h"
+#include "SceneBvh.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "StateCache.h"
+#include "D3D11StateSink.h"
 #include "GameData.h"
 #include "Shader.h"
 #include "Grid.h"
-#include "Cube.h"
-#include "Plane.h"
 #include "Mesh.h"
+#include "PrimitiveCache.h"
+#include "ProceduralMesh.h"
+#include "ResourceManager.h"
+#include "SamplerCache.h"
 #include "TexturedMesh.h"
 #include "Light.h"
-#include "Sphere.h"
 
 #include <dxgi.h>
 #include <minwindef.h>
@@ -35,6 +45,21 @@ enum class CullMode
     Frontface
 };
 
+/// @brief The renderer's counters for the last frame, for the UI
+struct RendererStats
+{
+    RenderQueueStats renderQueue;
+    InstanceBatcherStats instancing;
+    StateCacheStats stateCache;
+    RingAllocatorStats constantBufferRing;
+    uint32_t lodDraws[c_maxLodLevels] = {};  // visible nodes drawn at each level of detail
+    AsyncLoaderStats assetLoading;
+    ImagePoolStats imageStaging;
+    ResourceReport resources;
+    SamplerTableStats samplers;
+    TextureArrayPlannerStats textureArrays;
+};
+
 class GraphicsDX11
 {
 public:
@@ -58,7 +83,14 @@ public:
         return m_SceneRoot;
     }
 
+    const SceneBvh& GetSceneBvh() const { return m_sceneBvh; }
+    RendererStats GetRendererStats() const;
+
+    void SetPropCount(uint32_t count);
+
     void SetWorldViewProjection(DirectX::XMMATRIX const& mvp) { m_MVP = mvp; }
+    void SetFrustum(Frustum const& frustum) { m_frustum = frustum; }
+    void SetLodView(LodView const& lodView) { m_lodView = lodView; }
     void SetViewport(D3D11_VIEWPORT viewport) { m_viewport = viewport; }
 
     void Update(double deltaTime);
@@ -68,6 +100,11 @@ public:
     void Cleanup();
 
 private:
+    HRESULT ReserveInstanceBuffer(uint32_t instanceCount);
+    bool WriteInstanceTransforms();
+    void WriteDrawConstants();
+    void SubmitRenderQueue();
+
     ID3D11Device* m_D3DDevice = nullptr;   // The Direct3D Device
 
     ID3D11DeviceContext* m_D3DContext = nullptr;                // The Direct3D Device Context
@@ -75,23 +112,47 @@ private:
 
     IDXGISwapChain* m_SwapChain = nullptr; // DXGI swapchain for double/triple buffering
 
+    D3D11StateSink m_stateSink;     // Forwards the state cache's calls to m_D3DContext
+    StateCache m_stateCache;        // Everything bound while drawing the scene goes through here
+
     std::shared_ptr<Shader> m_shader;
     std::shared_ptr<Shader> m_lightGeometryShader;
     std::shared_ptr<Shader> m_simpleLit;
     std::shared_ptr<Shader> m_texturedShader;
+    std::shared_ptr<Shader> m_simpleLitInstanced;
+    std::shared_ptr<Shader> m_texturedShaderInstanced;
 
     static std::shared_ptr<SceneNode> m_SceneRoot;
+    std::shared_ptr<TransformHierarchy> m_transformHierarchy;
+    std::shared_ptr<JobSystem> m_jobSystem;
+    std::unique_ptr<ImagePool> m_imagePool;             // Staging memory the loader decodes textures into; outlives the loader
+    std::unique_ptr<AsyncLoader> m_assetLoader;         // Reads meshes and textures off the main thread; their GPU resources are made in Update
+
+    SceneBvh m_sceneBvh;                                // Acceleration structure over the scene graph, for culling and picking
+    std::vector<std::shared_ptr<SceneNode>> m_visibleNodes; // Result of culling the scene against the frustum
+    RenderQueue m_renderQueue;                          // The visible nodes, sorted by the state they need
+    ConstantBufferRing m_constantBufferRing;            // Per-draw constants for the frames in flight
+    std::vector<ConstantBufferSlice> m_drawConstants;   // World transform slice for each packet in the render queue
+    InstanceBatcher m_instanceBatcher;                  // Runs of the render queue that go out as one instanced draw
+    ID3D11Buffer* m_instanceBuffer = nullptr;           // Per-instance world transforms for the instanced batches
+    uint32_t m_instanceBufferCapacity = 0;              // How many transforms m_instanceBuffer holds
+    bool m_instancesWritten = false;                    // This frame's instanced batches have their transforms
+
+    ResourceManager m_resources;                        // Loaded meshes, textures and shaders, shared by whatever uses them
+    SamplerCache m_samplers;                            // Every sampler state, one per description; the static ones are bound once a frame
 
     std::shared_ptr<Grid> m_grid;
-    std::shared_ptr<Mesh> m_gizmoXYZ01;
-    std::shared_ptr<Mesh> m_gizmoXYZ02;
-    std::shared_ptr<Cube> m_cube;
-    std::shared_ptr<Plane> m_plane;
+    std::shared_ptr<Mesh> m_gizmoXYZ;
+    std::shared_ptr<ProceduralMesh> m_cube;
+    std::shared_ptr<ProceduralMesh> m_plane;
     std::shared_ptr<TexturedMesh> m_texturedMesh;
     std::shared_ptr<Light> m_light;
-    std::shared_ptr<Sphere> m_sphere;
+    std::shared_ptr<ProceduralMesh> m_sphere;
+    PrimitiveCache m_primitiveCache;                    // Shared geometry for the procedural primitives
 
     std::shared_ptr<SceneNode> m_lightSceneNode;
+    std::shared_ptr<SceneNode> m_propsNode;     // Parent of the field of prop copies
+    uint32_t m_propCount = 0;
 
     ID3D11Buffer* m_viewProjectionConstantBuffer = nullptr; // The constant buffer for the View Projection matrix
 //    ID3D11Buffer* m_localToWorldConstantBuffer = nullptr;   // The constant buffer for the local to world matrix
@@ -104,6 +165,9 @@ private:
     //DirectX::XMMATRIX m_World;
     DirectX::XMMATRIX m_MVP;
     //DirectX::XMMATRIX m_VP;
+    Frustum m_frustum;
+    LodView m_lodView;                                  // Where the camera is, for picking each node's level of detail
+    uint32_t m_lodDraws[c_maxLodLevels] = {};           // Visible nodes drawn at each level of detail, last frame
 
     const std::vector<float> g_clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
 
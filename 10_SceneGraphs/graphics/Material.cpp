@@ -1,16 +1,13 @@
 #include "Material.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <filesystem> // for getting at current working directory and path operations. Forces us to C++17
 
+#include "TextureArrayCache.h"
 #include "utils.h"
 #include "framework.h"
 
 #ifdef _DEBUG
 constexpr char c_textureBufferID[] = "texture-buffer";
-constexpr char c_samplerBufferID[] = "sampler-Buffer";
 constexpr char c_shaderResourceViewID[] = "shader-resource-view";
 #endif
 
@@ -19,92 +16,68 @@ Material::~Material()
     Cleanup();
 }
 
+/// @brief Where an image a model refers to is found: the file of the same name in the working
+/// directory, whatever folder the model's author had it in. The working directory is looked up
+/// once, the first time, as it doesn't change while running and asking the OS for it every texture
+/// means a system call and an allocation each on the loader threads.
+std::filesystem::path Material::ResolveImagePath(const std::string& filepath)
+{
+    static const std::filesystem::path workingDirectory = std::filesystem::current_path();
+    return workingDirectory / std::filesystem::path(filepath).filename();
+}
+
+/// @brief Read a texture, cooked or not, and create the material's texture from it, all on the
+/// calling thread
 bool Material::LoadImageFromFile(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, const std::string filepath)
 {
-    int imgWidth;
-    int imgHeight;
-    int imgChannels;
-
-    auto currentpath = std::filesystem::current_path();
-    auto filename = currentpath / std::filesystem::path(filepath).filename().string();
-    unsigned char* data = stbi_load(filename.string().c_str(), &imgWidth, &imgHeight, &imgChannels, STBI_rgb_alpha);
-
-    D3D11_TEXTURE2D_DESC texture_desc = {};
-    texture_desc.Width = imgWidth;
-    texture_desc.Height = imgHeight;
-    texture_desc.MipLevels = 1;
-    texture_desc.ArraySize = 1;
-    texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    texture_desc.SampleDesc.Count = 1;
-    texture_desc.Usage = D3D11_USAGE_DEFAULT;
-    texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-    D3D11_SUBRESOURCE_DATA subresource_data = {};
-    subresource_data.pSysMem = data;
-    subresource_data.SysMemPitch = imgWidth * 4;
-
-    HRESULT result = pDevice->CreateTexture2D(&texture_desc, &subresource_data, &m_pTexture);
-    if (FAILED(result))
-    {
-        PLOG_ERROR << L"Failed to create texture 2d";
-        stbi_image_free(data);
+    LoadedTexture texture;
+    if (!ReadTexture(ResolveImagePath(filepath), texture))
         return false;
-    }
 
-#ifdef _DEBUG
-    m_pTexture->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_textureBufferID) - 1, c_textureBufferID);
-#endif // DEBUG
+    return CreateFromTexture(pDevice, texture);
+}
 
-    D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-    srv_desc.Format = texture_desc.Format;
-    srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MipLevels = 1;
-
-    result = pDevice->CreateShaderResourceView(m_pTexture, &srv_desc, &m_pShaderResourceView);
-    if (FAILED(result))
-    {
-        PLOG_ERROR << "Failed to create shader resource view";
-        m_pTexture->Release();
-        stbi_image_free(data);
+/// @brief Create the material's texture, with its whole mip chain, and view from a texture read
+/// already, which may have been done on another thread. It is the only slice of its array.
+bool Material::CreateFromTexture(ID3D11Device* pDevice, const LoadedTexture& texture)
+{
+    if (!CreateLoadedTexture(texture, pDevice, &m_pTexture, &m_pShaderResourceView))
         return false;
-    }
 
 #ifdef _DEBUG
+    m_pTexture->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_textureBufferID) - 1, c_textureBufferID);
     m_pShaderResourceView->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_shaderResourceViewID) - 1, c_shaderResourceViewID);
 #endif // DEBUG
 
-    D3D11_SAMPLER_DESC sampDesc;
-    ZeroMemory(&sampDesc, sizeof(sampDesc));
-    sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-    sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-    sampDesc.MinLOD = 0;
-    sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-    result = pDevice->CreateSamplerState(&sampDesc, &m_pSamplerState);
-    if (FAILED(result))
-    {
-        PLOG_ERROR << "Failed to create the sampler state";
-        m_pTexture->Release();
-        stbi_image_free(data);
-        return false;
-    }
+    return true;
+}
 
-#ifdef _DEBUG
-    m_pSamplerState->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_samplerBufferID) - 1, c_samplerBufferID);
-#endif // DEBUG
+/// @brief Use a slice of a texture array made elsewhere, such as by the ResourceManager, whose
+/// view is looked up each time the material is used. The array has to outlive the material's use
+/// of it; whoever gave out the slot holds the texture.
+void Material::SetTexture(const TextureArrayCache* pArrays, TextureArraySlot slot)
+{
+    Cleanup();
 
-    pDevice->Release();
-    stbi_image_free(data);
-    return true;
+    m_pArrays = pArrays;
+    m_slot = slot;
+}
+
+void Material::UseMaterial(StateCache& stateCache)
+{
+    if (m_pArrays != nullptr)
+        stateCache.PSSetShaderResource(0, m_pArrays->GetView(m_slot.array));
+    else
+        stateCache.PSSetShaderResource(0, m_pShaderResourceView);
 }
 
-void Material::UseMaterial(ID3D11DeviceContext* pDeviceContext)
+/// @return What materials that bind the same texture share, for the render queue to sort their
+/// draws together by: the shared array, or the material's own view
+const void* Material::GetStateKey() const
 {
-    pDeviceContext->PSSetShaderResources(0, 1, &m_pShaderResourceView);
-    pDeviceContext->PSSetSamplers(0, 1, &m_pSamplerState);
+    if (m_pArrays != nullptr)
+        return m_pArrays->GetStateKey(m_slot.array);
+    return m_pShaderResourceView;
 }
 
 void Material::Cleanup()
@@ -112,10 +85,10 @@ void Material::Cleanup()
     PLOG_INFO << "MaterialCleanup Destructor";
 
     SafeRelease(m_pTexture);
-    SafeRelease(m_pSamplerState);
     SafeRelease(m_pShaderResourceView);
 
     m_pTexture = nullptr;
-    m_pSamplerState = nullptr;
     m_pShaderResourceView = nullptr;
+    m_pArrays = nullptr;
+    m_slot = TextureArraySlot();
 }
\ No newline at end of file
@@ -1,8 +1,21 @@
 #pragma once
 
+#include <filesystem>
 #include <string>
 #include <d3d11_4.h>
 
+#include "StateCache.h"
+#include "TextureLoader.h"
+
+class TextureArrayCache;
+
+/// @brief The texture a mesh is drawn with. It is sampled through the linear wrap static sampler,
+/// s0, which the SamplerCache binds once a frame, so a material binds only its texture.
+///
+/// Textures are sampled from texture arrays, by slice. A material's texture is either its own, an
+/// array of one, or a slice of an array shared through a TextureArrayCache, in which case every
+/// material using the array binds the same view and draws of them can be sorted and instanced
+/// together, each passing its slice to the shader.
 class Material
 {
 public:
@@ -10,7 +23,13 @@ public:
     ~Material();
 
     bool LoadImageFromFile(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, const std::string filepath);
-    void UseMaterial(ID3D11DeviceContext* pDeviceContext);
+    bool CreateFromTexture(ID3D11Device* pDevice, const LoadedTexture& texture);
+    void SetTexture(const TextureArrayCache* pArrays, TextureArraySlot slot);
+    void UseMaterial(StateCache& stateCache);
+
+    const void* GetStateKey() const;
+
+    static std::filesystem::path ResolveImagePath(const std::string& filepath);
 
     void Cleanup();
 
@@ -18,6 +37,7 @@ public:
 
 private:
     ID3D11Texture2D* m_pTexture = nullptr;
-    ID3D11SamplerState* m_pSamplerState = nullptr;
-    ID3D11ShaderResourceView* m_pShaderResourceView = nullptr;
+    ID3D11ShaderResourceView* m_pShaderResourceView = nullptr;    // of the material's own texture
+    const TextureArrayCache* m_pArrays = nullptr;                   // not owned; the shared array, if it has no texture of its own
+    TextureArraySlot m_slot;
 };
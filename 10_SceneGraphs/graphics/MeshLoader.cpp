@@ -0,0 +1,178 @@
+#include "MeshLoader.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Material.h"
+#include "plog/Log.h"
+
+namespace
+{
+    void LogImport(const LoadedMesh& mesh, LargeMeshMode mode)
+    {
+        for (const auto& warning : mesh.imported.warnings)
+        {
+            PLOG_WARNING << mesh.path << ": " << warning;
+        }
+
+        for (const auto& part : mesh.imported.parts)
+        {
+            const auto& optimization = part.optimization;
+            if (!optimization.optimized)
+                PLOG_WARNING << "Not optimizing material " << part.materialIndex << " of " << mesh.path << " as some of its indices are past the end of its vertices";
+            else
+                PLOG_INFO << "Optimized material " << part.materialIndex << " in " << optimization.milliseconds << " ms: ACMR (FIFO " << c_fifoVertexCacheSize << ") "
+                          << optimization.fifoBefore.acmr << " -> " << optimization.fifoAfter.acmr << ", ATVR " << optimization.fifoBefore.atvr
+                          << " -> " << optimization.fifoAfter.atvr << ", " << optimization.verticesBefore - optimization.verticesAfter << " unused vertices dropped";
+
+            if (!FitsShortIndices(part.vertexCount))
+            {
+                PLOG_INFO << part.vertexCount << " vertices is too many for 16 bit indices, "
+                    << (mode == LargeMeshMode::Split ? "splitting the mesh" : "using 32 bit indices");
+            }
+        }
+    }
+}
+
+/// @brief Read a mesh, and its textures if it is textured, ready for CreateMeshRenderables. The
+/// cooked version is used if MeshCooker has made one. Safe to call from any thread.
+/// @param path The source mesh, relative to the working directory
+/// @param format NormalUV for a textured mesh, every material of which that the mesh uses has to
+/// have a diffuse texture
+/// @param mode What to do with source meshes too big for 16 bit indices
+/// @param imagePool Staging memory to decode the textures into, all of them reserved together; see
+/// ReserveTextures
+/// @param jobs Merges the source mesh's parts in parallel, when there is no cooked mesh. Only from
+/// the thread that owns it; never from a loader thread.
+bool ReadMesh(const std::string& path, MeshImportFormat format, LargeMeshMode mode, LoadedMesh& mesh, ImagePool* imagePool, JobSystem* jobs)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    mesh.path = std::filesystem::current_path() / path;
+    bool textured = format == MeshImportFormat::NormalUV;
+    std::vector<std::string> textures;  // the diffuse texture of each material
+    std::vector<bool> usedMaterials;    // whether any submesh is drawn with each material
+
+    auto cookedPath = FindCookedMesh(mesh.path);
+    if (!cookedPath.empty())
+    {
+        auto cooked = std::make_unique<OpenedCookedMesh>();
+        if (OpenCookedMesh(cookedPath, textured ? CookedVertexFormat::PackedNormalUV : CookedVertexFormat::PackedNormal, *cooked))
+        {
+            const auto& header = cooked->view.GetHeader();
+            for (uint32_t index = 0; index < header.materialCount; index++)
+            {
+                textures.push_back(cooked->view.GetMaterials()[index].diffuseTexture);
+            }
+            usedMaterials.resize(header.materialCount);
+            for (uint32_t index = 0; index < header.submeshCount; index++)
+            {
+                const auto& submesh = cooked->view.GetSubmeshes()[index];
+                if (submesh.indexCount > 0 && submesh.materialIndex < header.materialCount)
+                    usedMaterials[submesh.materialIndex] = true;
+            }
+            mesh.cooked = std::move(cooked);
+        }
+        else
+        {
+            PLOG_WARNING << "Falling back to the source mesh " << mesh.path;
+        }
+    }
+
+    if (mesh.cooked == nullptr)
+    {
+        PLOG_INFO << "Loading mesh from file: " << mesh.path;
+
+        std::string error;
+        if (!ImportMesh(mesh.path.generic_string(), format, mode, mesh.imported, error, jobs))
+        {
+            PLOG_ERROR << "Failed to import " << mesh.path << ": " << error;
+            return false;
+        }
+        LogImport(mesh, mode);
+
+        for (const auto& material : mesh.imported.materials)
+        {
+            textures.push_back(material.diffuseTexture);
+        }
+        usedMaterials.resize(textures.size());
+        for (const auto& part : mesh.imported.parts)
+        {
+            if (part.materialIndex < usedMaterials.size())
+                usedMaterials[part.materialIndex] = true;
+        }
+    }
+
+    if (textured)
+    {
+        // Each texture is read once, however many materials share it
+        mesh.materialTextures.assign(textures.size(), LoadedMesh::c_noTexture);
+        for (uint32_t material = 0; material < textures.size(); material++)
+        {
+            if (!usedMaterials[material])
+                continue;
+            if (textures[material].empty())
+            {
+                PLOG_ERROR << "Material " << material << " of " << mesh.path << " has no diffuse texture";
+                return false;
+            }
+
+            auto texturePath = Material::ResolveImagePath(textures[material]).string();
+            auto found = std::find_if(mesh.textures.begin(), mesh.textures.end(), [&texturePath](const auto& texture) { return texture->path == texturePath; });
+            mesh.materialTextures[material] = static_cast<uint32_t>(found - mesh.textures.begin());
+            if (found == mesh.textures.end())
+            {
+                mesh.textures.push_back(std::make_unique<LoadedMeshTexture>());
+                mesh.textures.back()->path = texturePath;
+            }
+        }
+
+        if (mesh.textures.empty())
+        {
+            PLOG_ERROR << mesh.path << " has no textured materials";
+            return false;
+        }
+
+        // Every texture's memory is reserved at once, as a load that waited for room in the pool
+        // while holding some of it could wait on itself
+        std::vector<LoadedTexture*> opened;
+        for (auto& texture : mesh.textures)
+        {
+            if (!OpenTexture(texture->path, texture->texture))
+                return false;
+            opened.push_back(&texture->texture);
+        }
+        if (imagePool != nullptr)
+            ReserveTextures(*imagePool, opened);
+        for (auto* texture : opened)
+        {
+            if (!DecodeTexture(*texture))
+                return false;
+        }
+    }
+
+    mesh.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
+
+/// @brief Create the buffers for a mesh that ReadMesh has read. Call on the thread that owns the
+/// device context.
+/// @param renderables Where to add the new renderable. The caller owns it.
+/// @param localBounds Set to the mesh's bounds
+/// @param textureSlices The texture array slice of each material, for textured meshes
+bool CreateMeshRenderables(const LoadedMesh& mesh, ID3D11Device* pD3D11Device, std::vector<Renderable*>& renderables, Bounds& localBounds, const std::vector<uint32_t>& textureSlices)
+{
+    if (mesh.cooked != nullptr)
+        return CreateCookedRenderables(*mesh.cooked, pD3D11Device, renderables, localBounds, textureSlices);
+
+    auto renderable = new Renderable();
+    if (!renderable->Initialize(mesh.imported.renderable, pD3D11Device, textureSlices))
+    {
+        PLOG_ERROR << "Failed to create the buffers for " << mesh.path;
+        delete renderable;
+        return false;
+    }
+    renderables.push_back(renderable);
+    localBounds = mesh.imported.bounds;
+    return true;
+}
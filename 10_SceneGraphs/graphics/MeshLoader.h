@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <d3d11.h>
+
+#include "CookedMeshLoader.h"
+#include "MeshImport.h"
+#include "Renderable.h"
+#include "TextureLoader.h"
+
+/// Loading for Mesh and TexturedMesh, in two halves so the slow one can run on a loader thread.
+/// ReadMesh does everything that only needs the CPU: mapping the cooked mesh, or importing and
+/// preparing the source mesh when there isn't one, and reading the texture. CreateMeshRenderables
+/// then creates the buffers from what it read, on the thread that owns the device.
+
+/// @brief A diffuse texture of a textured mesh, which one or more of its materials use
+struct LoadedMeshTexture
+{
+    std::string path;
+    LoadedTexture texture;
+};
+
+/// @brief Everything ReadMesh read for one mesh
+struct LoadedMesh
+{
+    static constexpr uint32_t c_noTexture = UINT32_MAX;
+
+    std::filesystem::path path;                 // the source mesh asked for
+    std::unique_ptr<OpenedCookedMesh> cooked;   // its cooked version, if there was a usable one
+    ImportedMesh imported;                      // otherwise, the source mesh imported with assimp
+    std::vector<std::unique_ptr<LoadedMeshTexture>> textures;  // each diffuse texture once, for textured meshes
+    std::vector<uint32_t> materialTextures;     // the texture of each material; c_noTexture if none of the mesh uses it
+    double milliseconds = 0.0;                  // time spent reading it
+};
+
+bool ReadMesh(const std::string& path, MeshImportFormat format, LargeMeshMode mode, LoadedMesh& mesh, ImagePool* imagePool = nullptr, JobSystem* jobs = nullptr);
+
+bool CreateMeshRenderables(const LoadedMesh& mesh, ID3D11Device* pD3D11Device, std::vector<Renderable*>& renderables, Bounds& localBounds, const std::vector<uint32_t>& textureSlices = {});
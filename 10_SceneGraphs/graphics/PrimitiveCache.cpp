@@ -0,0 +1,61 @@
+#include "PrimitiveCache.h"
+
+#include "plog/Log.h"
+
+namespace
+{
+    // Primitives are plain shapes; any colour comes from the light
+    constexpr float c_primitiveDiffuse[3] = { 0.8f, 0.8f, 0.8f };
+}
+
+/// @brief Get the renderable for a primitive, building it if nothing holds one already. Its
+/// levels of detail are built too, so a finely tessellated primitive gets cheaper with distance.
+/// @param localBounds Set to the primitive's bounds, in its own local space
+/// @return The shared renderable, or nullptr if the buffers couldn't be created
+std::shared_ptr<Renderable> PrimitiveCache::Acquire(const PrimitiveDesc& desc, ID3D11Device* pD3D11Device, Bounds& localBounds)
+{
+    PrimitiveDesc key = NormalizePrimitiveDesc(desc);
+    Entry& entry = m_entries[key];
+    if (auto shared = entry.renderable.lock())
+    {
+        localBounds = entry.bounds;
+        return shared;
+    }
+
+    PrimitiveMesh mesh = GeneratePrimitive(key);
+    RenderableData data = PrepareRenderable(mesh.vertices, mesh.indices, c_primitiveDiffuse);
+
+    auto renderable = std::make_shared<Renderable>();
+    if (!renderable->Initialize(data, pD3D11Device))
+    {
+        PLOG_ERROR << "Failed to create the buffers for a procedural primitive";
+        m_entries.erase(key);
+        return nullptr;
+    }
+
+    PLOG_INFO << "Generated a procedural primitive with " << mesh.vertices.size() << " vertices, "
+              << mesh.indices.size() / 3 << " triangles and " << renderable->GetLodCount() << " levels of detail";
+
+    entry.renderable = renderable;
+    entry.bounds = ComputeBounds(mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV));
+    localBounds = entry.bounds;
+    return renderable;
+}
+
+/// @brief How many distinct primitives are in use
+size_t PrimitiveCache::GetLiveCount() const
+{
+    size_t count = 0;
+    for (const auto& entry : m_entries)
+    {
+        if (!entry.second.renderable.expired())
+            count++;
+    }
+    return count;
+}
+
+/// @brief Forget every primitive. Ones still in use keep their buffers until they are let go.
+void PrimitiveCache::Cleanup()
+{
+    m_entries.clear();
+}
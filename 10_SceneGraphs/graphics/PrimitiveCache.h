@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+#include "Culling.h"
+#include "ProceduralGeometry.h"
+#include "Renderable.h"
+
+/// @brief The GPU side of the procedural primitives. Each distinct PrimitiveDesc is generated and
+/// uploaded once, and everything asking for the same one shares its vertex and index buffers.
+///
+/// The cache only holds weak references: a primitive's buffers go when the last thing using it
+/// lets go, and asking for it again after that builds it again.
+class PrimitiveCache
+{
+public:
+    PrimitiveCache() = default;
+
+    std::shared_ptr<Renderable> Acquire(const PrimitiveDesc& desc, ID3D11Device* pD3D11Device, Bounds& localBounds);
+
+    size_t GetLiveCount() const;
+
+    void Cleanup();
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<Renderable> renderable;
+        Bounds bounds;
+    };
+
+    std::unordered_map<PrimitiveDesc, Entry, PrimitiveDescHash> m_entries;
+};
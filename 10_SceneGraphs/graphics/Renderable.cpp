@@ -1,10 +1,16 @@
 #include "Renderable.h"
+
+#include <algorithm>
+
+#include "ConstantBufferRing.h"
+#include "ConstantBuffers.h"
 #include "utils.h"
 #include "plog/Log.h"
 
 #ifdef _DEBUG
 constexpr char c_vertexBufferID[] = "Renderable-vertexBuffer";
 constexpr char c_indexBufferID[] = "Renderable-indexBuffer";
+constexpr char c_meshConstantsID[] = "Renderable-meshConstants";
 #endif
 
 Renderable::~Renderable()
@@ -13,74 +19,45 @@ Renderable::~Renderable()
 }
 
 
-void Renderable::Initialize(
-    std::vector<ColorVertexNormal> vertexBuffer,
-    std::vector<uint16_t> indexbuffer,
-    ID3D11Device* pD3D11Device)
+/// @brief Create the buffers for a renderable prepared on the CPU, which may have been done on
+/// another thread
+/// @param textureSlices The texture array slice of each material, for textured meshes; any
+/// material past the end keeps the slice in the data
+bool Renderable::Initialize(const RenderableData& data, ID3D11Device* pD3D11Device, const std::vector<uint32_t>& textureSlices)
 {
-    m_numIndices = static_cast<uint16_t>(indexbuffer.size());
-
-    m_stride = 3 * sizeof(float) + 4 * sizeof(float) + 3 * sizeof(float);
-    m_offset = 0;
-
-    D3D11_BUFFER_DESC vertexBufferDesc = {};
-    vertexBufferDesc.ByteWidth = static_cast<UINT>(vertexBuffer.size() * m_stride);
-    vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-
-    D3D11_SUBRESOURCE_DATA vertexSubresourceData = {};
-    vertexSubresourceData.pSysMem = vertexBuffer.data();
-    vertexSubresourceData.SysMemPitch = 0;
-    vertexSubresourceData.SysMemSlicePitch = 0;
-
-    if (!SUCCEEDED(pD3D11Device->CreateBuffer(
-        &vertexBufferDesc,
-        &vertexSubresourceData,
-        &m_vertexBuffer)))
-    {
-        PLOG_ERROR << "Failed to create the Vertex Buffer for a Renderable!";
-        return;
-    }
-
-    D3D11_BUFFER_DESC indexBufferDesc = {};
-    indexBufferDesc.ByteWidth = static_cast<UINT>(m_numIndices * sizeof(WORD));
-    indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    indexBufferDesc.CPUAccessFlags = 0;
-
-    D3D11_SUBRESOURCE_DATA indexbufferData = {};
-    indexbufferData.pSysMem = indexbuffer.data();
-    indexbufferData.SysMemPitch = 0;
-    indexbufferData.SysMemSlicePitch = 0;
-
-    if (!SUCCEEDED(pD3D11Device->CreateBuffer(
-        &indexBufferDesc,
-        &indexbufferData,
-        &m_indexBuffer)))
-    {
-        PLOG_ERROR << "Failed to create a new grid index buffer";
-        return ;
-    }
+    DXGI_FORMAT indexFormat = data.indexSize == sizeof(uint32_t) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    return CreateBuffers(data.vertices.data(), data.vertexCount, data.vertexStride, data.indices.data(), data.indexCount, indexFormat, pD3D11Device)
+        && CreateSubmeshConstants(data.submeshes, data.materials, textureSlices, pD3D11Device);
 }
 
 
-void Renderable::Initialize(
-    std::vector<ColorVertexNormalUV> vertexBuffer,
-    std::vector<uint16_t> indexbuffer,
+/// @brief Create the immutable vertex and index buffers straight from memory that is already in
+/// the GPU's layout, such as a cooked mesh. The vertices have to be packed; CreateSubmeshConstants
+/// says how to unpack them.
+/// @param stride Size of a vertex, in bytes
+/// @param indexFormat DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT, matching indexData
+bool Renderable::CreateBuffers(
+    const void* vertexData,
+    size_t vertexCount,
+    UINT stride,
+    const void* indexData,
+    size_t indexCount,
+    DXGI_FORMAT indexFormat,
     ID3D11Device* pD3D11Device)
 {
-    m_numIndices = static_cast<uint16_t>(indexbuffer.size());
+    m_numIndices = static_cast<uint32_t>(indexCount);
+    m_indexFormat = indexFormat;
 
-    m_stride = 3 * sizeof(float) + 4 * sizeof(float) + 3 * sizeof(float) + 2 * sizeof(float);
+    m_stride = stride;
     m_offset = 0;
 
     D3D11_BUFFER_DESC vertexBufferDesc = {};
-    vertexBufferDesc.ByteWidth = static_cast<UINT>(vertexBuffer.size() * m_stride);
+    vertexBufferDesc.ByteWidth = static_cast<UINT>(vertexCount * m_stride);
     vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
     vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
     D3D11_SUBRESOURCE_DATA vertexSubresourceData = {};
-    vertexSubresourceData.pSysMem = vertexBuffer.data();
+    vertexSubresourceData.pSysMem = vertexData;
     vertexSubresourceData.SysMemPitch = 0;
     vertexSubresourceData.SysMemSlicePitch = 0;
 
@@ -90,22 +67,23 @@ void Renderable::Initialize(
             &m_vertexBuffer)))
         {
             PLOG_ERROR << "Failed to create the Vertex Buffer for a Renderable!";
-            return;
+            return false;
         }
 
 #ifdef _DEBUG
     m_vertexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_vertexBufferID) - 1, c_vertexBufferID);
 #endif // DEBUG
 
+    UINT indexSize = indexFormat == DXGI_FORMAT_R32_UINT ? sizeof(uint32_t) : sizeof(uint16_t);
 
     D3D11_BUFFER_DESC indexBufferDesc = {};
-    indexBufferDesc.ByteWidth = static_cast<UINT>(m_numIndices * sizeof(WORD));
+    indexBufferDesc.ByteWidth = static_cast<UINT>(m_numIndices * indexSize);
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
     indexBufferDesc.CPUAccessFlags = 0;
 
     D3D11_SUBRESOURCE_DATA indexbufferData = {};
-    indexbufferData.pSysMem = indexbuffer.data();
+    indexbufferData.pSysMem = indexData;
     indexbufferData.SysMemPitch = 0;
     indexbufferData.SysMemSlicePitch = 0;
 
@@ -115,30 +93,209 @@ void Renderable::Initialize(
             &m_indexBuffer)))
         {
             PLOG_ERROR << "Failed to create a new grid index buffer";
-            return;
+            return false;
         }
 
 #ifdef _DEBUG
     m_indexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_indexBufferID) - 1, c_indexBufferID);
 #endif // DEBUG
+
+    m_gpuBytes += vertexBufferDesc.ByteWidth + indexBufferDesc.ByteWidth;
+    return true;
+}
+
+
+/// @brief Create the constants the vertex shader unpacks each submesh's positions with, which also
+/// carry its material's colour and texture slice. They all go in one immutable buffer, a
+/// MeshConstantBuffer every 256 bytes so each submesh can bind its own as a range of it. Every
+/// submesh gets a full 256 bytes, the last one too, since that is how much a range binds; a
+/// renderable of one submesh binds the whole buffer, as it always did.
+/// @param submeshes The ranges of the vertex and index buffers to draw, each with its material
+/// @param materials What each material gives the shaders
+/// @param textureSlices Overrides the texture slice of the first materials, see Initialize
+bool Renderable::CreateSubmeshConstants(const std::vector<SubmeshData>& submeshes, const std::vector<MaterialData>& materials, const std::vector<uint32_t>& textureSlices, ID3D11Device* pD3D11Device)
+{
+    constexpr size_t stride = ConstantBufferRing::SliceAlignment / sizeof(MeshConstantBuffer);
+    static_assert(ConstantBufferRing::SliceAlignment % sizeof(MeshConstantBuffer) == 0, "submesh constants have to be a whole number of slices");
+
+    if (submeshes.empty())
+    {
+        PLOG_ERROR << "A Renderable needs at least one submesh!";
+        return false;
+    }
+
+    static const MaterialData white;
+    std::vector<MeshConstantBuffer> constants(submeshes.size() * stride);
+    m_submeshes.clear();
+    for (size_t index = 0; index < submeshes.size(); index++)
+    {
+        const auto& submesh = submeshes[index];
+        const auto& material = submesh.material < materials.size() ? materials[submesh.material] : white;
+        uint32_t textureSlice = submesh.material < textureSlices.size() ? textureSlices[submesh.material] : material.textureSlice;
+
+        auto& submeshConstants = constants[index * stride];
+        submeshConstants.mPositionScale = { submesh.quantization.scale[0], submesh.quantization.scale[1], submesh.quantization.scale[2], 0.0f };
+        submeshConstants.mPositionOffset = { submesh.quantization.offset[0], submesh.quantization.offset[1], submesh.quantization.offset[2], 1.0f };
+        submeshConstants.mDiffuse = { material.diffuse[0], material.diffuse[1], material.diffuse[2], 1.0f };
+        submeshConstants.mMaterial = { textureSlice, 0, 0, 0 };
+
+        m_submeshes.push_back(Submesh{ submesh.firstIndex, submesh.indexCount, submesh.firstVertex, submesh.material, submesh.lods });
+    }
+
+    D3D11_BUFFER_DESC constantBufferDesc = {};
+    constantBufferDesc.ByteWidth = static_cast<UINT>(constants.size() * sizeof(MeshConstantBuffer));
+    constantBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    constantBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    D3D11_SUBRESOURCE_DATA constantData = {};
+    constantData.pSysMem = constants.data();
+
+    HRESULT hr = pD3D11Device->CreateBuffer(&constantBufferDesc, &constantData, &m_meshConstants);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create the mesh constant buffer for a Renderable!";
+        return false;
+    }
+
+#ifdef _DEBUG
+    m_meshConstants->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_meshConstantsID) - 1, c_meshConstantsID);
+#endif // DEBUG
+
+    m_gpuBytes += constantBufferDesc.ByteWidth;
+    return true;
 }
 
 
-void Renderable::Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, ID3D11Buffer* worldConstants, ID3D11Buffer* lightConstants)
+/// @brief The index range and error of a level of detail of a submesh, from the start of the
+/// index buffer. Asking for a level past the coarsest gives the coarsest, so one level picked for a
+/// whole mesh works for all of its submeshes and renderables.
+LodLevel Renderable::GetLod(uint32_t submesh, uint32_t lod) const
+{
+    const auto& range = m_submeshes[submesh];
+    if (range.lods.empty())
+        return LodLevel{ range.firstIndex, range.indexCount, 0.0f };
+
+    LodLevel level = range.lods[std::min(lod, static_cast<uint32_t>(range.lods.size() - 1))];
+    level.firstIndex += range.firstIndex;
+    return level;
+}
+
+/// @brief The most levels of detail any submesh has
+uint32_t Renderable::GetLodCount() const
+{
+    size_t lodCount = 1;
+    for (const auto& submesh : m_submeshes)
+    {
+        lodCount = std::max(lodCount, submesh.lods.size());
+    }
+    return static_cast<uint32_t>(lodCount);
+}
+
+/// @brief The largest error of any submesh at a level of detail
+float Renderable::GetLodError(uint32_t lod) const
+{
+    float error = 0.0f;
+    for (uint32_t submesh = 0; submesh < m_submeshes.size(); submesh++)
+    {
+        error = std::max(error, GetLod(submesh, lod).error);
+    }
+    return error;
+}
+
+/// @brief The error of each level of detail of a mesh made of several renderables: for each level,
+/// the largest error of any of them
+std::vector<float> CollectLodErrors(const std::vector<Renderable*>& renderables)
 {
-    pD3D11DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    pD3D11DeviceContext->IASetInputLayout(shader->GetLayout());
+    uint32_t lodCount = 1;
+    for (auto* renderable : renderables)
+    {
+        lodCount = std::max(lodCount, renderable->GetLodCount());
+    }
 
-    pD3D11DeviceContext->VSSetShader(shader->GetVertexShader(), nullptr, 0);
-    pD3D11DeviceContext->PSSetShader(shader->GetPixelShader(), nullptr, 0);
+    std::vector<float> errors(lodCount, 0.0f);
+    for (uint32_t lod = 0; lod < lodCount; lod++)
+    {
+        for (auto* renderable : renderables)
+        {
+            errors[lod] = std::max(errors[lod], renderable->GetLodError(lod));
+        }
+    }
+    return errors;
+}
 
-    pD3D11DeviceContext->VSSetConstantBuffers(1, 1, &worldConstants);
-    pD3D11DeviceContext->PSSetConstantBuffers(0, 1, &lightConstants);
+/// @brief The GPU memory taken by a mesh made of several renderables
+size_t SumGpuBytes(const std::vector<Renderable*>& renderables)
+{
+    size_t bytes = 0;
+    for (auto* renderable : renderables)
+    {
+        bytes += renderable->GetGpuBytes();
+    }
+    return bytes;
+}
 
-    pD3D11DeviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &m_stride, &m_offset);
-    pD3D11DeviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R16_UINT, 0);
 
-    pD3D11DeviceContext->DrawIndexed(m_numIndices, 0, 0);
+/// @brief Bind what every draw of a submesh needs. The vertex and index buffers are the same for
+/// every submesh, so the state cache drops them after the first.
+void Renderable::BindBuffers(StateCache& stateCache, ID3D11Buffer* lightConstants, uint32_t submesh)
+{
+    stateCache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    if (m_submeshes.size() == 1)
+    {
+        stateCache.VSSetConstantBuffer(2, m_meshConstants);
+    }
+    else
+    {
+        constexpr uint32_t constantsPerSubmesh = ConstantBufferRing::SliceAlignment / 16;
+        stateCache.VSSetConstantBuffer(2, ConstantBufferSlice{ m_meshConstants, submesh * constantsPerSubmesh, constantsPerSubmesh });
+    }
+    stateCache.PSSetConstantBuffer(0, lightConstants);
+
+    stateCache.IASetVertexBuffer(0, m_vertexBuffer, m_stride, m_offset);
+    stateCache.IASetIndexBuffer(m_indexBuffer, m_indexFormat, 0);
+}
+
+/// @brief Draw every submesh, for meshes that don't change material between them
+void Renderable::Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, ID3D11Buffer* lightConstants, uint32_t lod)
+{
+    for (uint32_t submesh = 0; submesh < m_submeshes.size(); submesh++)
+    {
+        RenderSubmesh(stateCache, submesh, worldConstants, lightConstants, lod);
+    }
+}
+
+/// @brief Draw several copies of every submesh, a call per submesh
+void Renderable::RenderInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, ID3D11Buffer* lightConstants, uint32_t instanceCount, uint32_t startInstance, uint32_t lod)
+{
+    for (uint32_t submesh = 0; submesh < m_submeshes.size(); submesh++)
+    {
+        RenderSubmeshInstanced(stateCache, submesh, instanceBuffer, lightConstants, instanceCount, startInstance, lod);
+    }
+}
+
+/// @brief Draw one submesh, after its material has been set up
+void Renderable::RenderSubmesh(StateCache& stateCache, uint32_t submesh, const ConstantBufferSlice& worldConstants, ID3D11Buffer* lightConstants, uint32_t lod)
+{
+    stateCache.VSSetConstantBuffer(1, worldConstants);
+    BindBuffers(stateCache, lightConstants, submesh);
+
+    LodLevel level = GetLod(submesh, lod);
+    stateCache.DrawIndexed(level.indexCount, level.firstIndex, static_cast<int32_t>(m_submeshes[submesh].firstVertex));
+}
+
+/// @brief Draw several copies of one submesh in one call
+/// @param instanceBuffer Vertex buffer holding a local to world matrix per instance
+/// @param instanceCount How many copies to draw
+/// @param startInstance First matrix in the instance buffer to use
+/// @param lod The level of detail every copy is drawn with
+void Renderable::RenderSubmeshInstanced(StateCache& stateCache, uint32_t submesh, ID3D11Buffer* instanceBuffer, ID3D11Buffer* lightConstants, uint32_t instanceCount, uint32_t startInstance, uint32_t lod)
+{
+    BindBuffers(stateCache, lightConstants, submesh);
+    stateCache.IASetVertexBuffer(1, instanceBuffer, sizeof(DirectX::XMFLOAT4X4), 0);
+
+    LodLevel level = GetLod(submesh, lod);
+    stateCache.DrawIndexedInstanced(level.indexCount, instanceCount, level.firstIndex, static_cast<int32_t>(m_submeshes[submesh].firstVertex), startInstance);
 }
 
 void Renderable::Cleanup()
@@ -147,7 +304,11 @@ void Renderable::Cleanup()
 
     SafeRelease(m_vertexBuffer);
     SafeRelease(m_indexBuffer);
+    SafeRelease(m_meshConstants);
 
     m_vertexBuffer = nullptr;
     m_indexBuffer = nullptr;
+    m_meshConstants = nullptr;
+    m_submeshes.clear();
+    m_gpuBytes = 0;
 }
@@ -6,54 +6,65 @@
 #include <DirectXMath.h>
 
 #include "Shader.h"
+#include "StateCache.h"
+#include "RenderableData.h"
 
-struct [[nodiscard]] ColorVertexNormal
-{
-    float x;
-    float y;
-    float z;
-    float r;
-    float g;
-    float b;
-    float a;
-    float nx;
-    float ny;
-    float nz;
-};
-
-struct [[nodiscard]] ColorVertexNormalUV
-{
-    float x;
-    float y;
-    float z;
-    float r;
-    float g;
-    float b;
-    float a;
-    float nx;
-    float ny;
-    float nz;
-    float u;
-    float v;
-};
-
+/// @brief One vertex and one index buffer, drawn as one or more submeshes: ranges of the buffers
+/// with a material each. A mesh with several materials is drawn with a DrawIndexed per submesh and
+/// no buffer changes between them.
 class Renderable
 {
 public:
     Renderable() = default;
     ~Renderable();
 
-    void Initialize(std::vector<ColorVertexNormal> vertexBuffer, std::vector<uint16_t> indexbuffer, ID3D11Device* pD3D11Device);
-    void Initialize(std::vector<ColorVertexNormalUV> vertexBuffer, std::vector<uint16_t> indexbuffer, ID3D11Device* pD3D11Device);
-    void Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, ID3D11Buffer* worldConstants, ID3D11Buffer* lightConstants);
+    bool Initialize(const RenderableData& data, ID3D11Device* pD3D11Device, const std::vector<uint32_t>& textureSlices = {});
+    void Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, ID3D11Buffer* lightConstants, uint32_t lod = 0);
+    void RenderInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, ID3D11Buffer* lightConstants, uint32_t instanceCount, uint32_t startInstance, uint32_t lod = 0);
+    void RenderSubmesh(StateCache& stateCache, uint32_t submesh, const ConstantBufferSlice& worldConstants, ID3D11Buffer* lightConstants, uint32_t lod = 0);
+    void RenderSubmeshInstanced(StateCache& stateCache, uint32_t submesh, ID3D11Buffer* instanceBuffer, ID3D11Buffer* lightConstants, uint32_t instanceCount, uint32_t startInstance, uint32_t lod = 0);
 
     void Cleanup();
 
+    bool CreateBuffers(const void* vertexData, size_t vertexCount, UINT stride, const void* indexData, size_t indexCount, DXGI_FORMAT indexFormat, ID3D11Device* pD3D11Device);
+    bool CreateSubmeshConstants(const std::vector<SubmeshData>& submeshes, const std::vector<MaterialData>& materials, const std::vector<uint32_t>& textureSlices, ID3D11Device* pD3D11Device);
+
+    uint32_t GetIndexCount() const { return m_numIndices; }
+    DXGI_FORMAT GetIndexFormat() const { return m_indexFormat; }
+    uint32_t GetSubmeshCount() const { return static_cast<uint32_t>(m_submeshes.size()); }
+    uint32_t GetSubmeshMaterial(uint32_t submesh) const { return m_submeshes[submesh].material; }
+    uint32_t GetLodCount() const;
+    float GetLodError(uint32_t lod) const;
+
+    /// @brief The size of the vertex, index and constant buffers this renderable created
+    size_t GetGpuBytes() const { return m_gpuBytes; }
+
 private:
+    /// @brief Where a submesh is in the buffers
+    struct Submesh
+    {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        uint32_t firstVertex = 0;
+        uint32_t material = 0;
+        std::vector<LodLevel> lods; // from firstIndex, finest first; empty if the whole range is the only level
+    };
+
     ID3D11Buffer* m_vertexBuffer = nullptr; // The D3D11 Buffer used to hold the vertex data for the grid
     ID3D11Buffer* m_indexBuffer = nullptr;  // The D3D11 Index Buffer for the grid
+    ID3D11Buffer* m_meshConstants = nullptr; // A MeshConstantBuffer per submesh, see CreateSubmeshConstants
 
     UINT m_stride = 0;
     UINT m_offset = 0;
-    uint16_t m_numIndices = 0;
+    uint32_t m_numIndices = 0;
+    DXGI_FORMAT m_indexFormat = DXGI_FORMAT_R16_UINT;
+    size_t m_gpuBytes = 0;
+
+    std::vector<Submesh> m_submeshes;
+
+    void BindBuffers(StateCache& stateCache, ID3D11Buffer* lightConstants, uint32_t submesh);
+    LodLevel GetLod(uint32_t submesh, uint32_t lod) const;
 };
+
+std::vector<float> CollectLodErrors(const std::vector<Renderable*>& renderables);
+size_t SumGpuBytes(const std::vector<Renderable*>& renderables);
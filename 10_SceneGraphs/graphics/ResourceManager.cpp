@@ -1,19 +1,227 @@
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // Output data structure
-#include <assimp/postprocess.h>     // Post processing flags
-
-#include <directxmath.h>
+#include "ResourceManager.h"
 
+#include <algorithm>
 #include <filesystem>
-#include <iostream>
+#include <type_traits>
 
-#include "ResourceManager.h"
+#include "Mesh.h"
 #include "Renderable.h"
+#include "TexturedMesh.h"
 #include "framework.h"
+#include "utils.h"
+
+namespace
+{
+    const char* GetModeName(LargeMeshMode mode)
+    {
+        return mode == LargeMeshMode::Split ? "split" : "long";
+    }
+}
+
+TextureResource::~TextureResource()
+{
+    if (arrays != nullptr)
+        arrays->Remove(slot);
+}
+
+ResourceManager::~ResourceManager()
+{
+    Cleanup();
+}
+
+void ResourceManager::Initialize(ID3D11Device* pD3D11Device)
+{
+    m_device = pD3D11Device;
+    m_device->AddRef();
+    m_textureArrays.Initialize(m_device);
+}
+
+/// @brief Set up what every mesh is given when it is made
+/// @param loader Loads the meshes in the background, or nullptr to load them as they are acquired.
+/// It has to be shut down before the manager is cleaned up.
+/// @param imagePool Staging memory that textures loaded in the background are decoded into, with a
+/// cap on how much of it there is at once. It has to outlive the loader.
+/// @param jobSystem Spreads the merging of a source mesh's parts over its workers when there is no
+/// loader and meshes load on the main thread; loader threads merge them themselves.
+/// @param placeholder Drawn by a mesh until it has loaded
+void ResourceManager::SetMeshDefaults(ID3D11Buffer* lightConstantBuffer, AsyncLoader* loader, ImagePool* imagePool, JobSystem* jobSystem, std::shared_ptr<Renderable> placeholder, const Bounds& placeholderBounds)
+{
+    SafeRelease(m_lightConstantBuffer);
+    m_lightConstantBuffer = lightConstantBuffer;
+    m_lightConstantBuffer->AddRef();
+
+    m_loader = loader;
+    m_imagePool = imagePool;
+    m_jobSystem = jobSystem;
+    m_placeholder = std::move(placeholder);
+    m_placeholderBounds = placeholderBounds;
+}
+
+/// @brief Make a mesh, or one already made from the same file the same way, and start loading it
+/// @param format Tells the meshes loaded with different vertex formats apart
+template <typename T>
+ResourceHandle ResourceManager::AcquireMeshOf(const std::string& path, LargeMeshMode mode, const char* format)
+{
+    auto key = MakeResourceKey(path, std::string(format) + "," + GetModeName(mode));
+    auto handle = m_cache.Find(ResourceType::Mesh, key);
+    if (handle.IsValid())
+        return handle;
+
+    auto mesh = std::make_shared<T>();
+    mesh->Initialize(m_device, m_lightConstantBuffer);
+    if (m_placeholder != nullptr)
+        mesh->SetPlaceholder(m_placeholder, m_placeholderBounds);
+    mesh->SetJobSystem(m_jobSystem);
+
+    if constexpr (std::is_same_v<T, TexturedMesh>)
+    {
+        mesh->SetResourceManager(this);
+        mesh->SetImagePool(m_imagePool);
+    }
+
+    if (m_loader != nullptr)
+    {
+        mesh->LoadFromFileAsync(*m_loader, m_device, path, mode);
+    }
+    else
+    {
+        ID3D11DeviceContext* pD3D11DeviceContext = nullptr;
+        m_device->GetImmediateContext(&pD3D11DeviceContext);
+        bool loaded = mesh->LoadFromFile(pD3D11DeviceContext, path, mode);
+        pD3D11DeviceContext->Release();
+
+        if (!loaded)
+            return ResourceHandle();
+    }
+
+    // A failed background load leaves the mesh drawing its placeholder; it is cached all the same,
+    // so it isn't loaded again every time something asks for it
+    handle = m_cache.Insert(ResourceType::Mesh, key, std::static_pointer_cast<RenderBase>(mesh), mesh->GetGpuBytes());
+    if (!mesh->IsLoaded())
+        m_loadingMeshes.push_back(handle);
+    return handle;
+}
+
+/// @brief A mesh drawn with vertex normals, loaded from a file in the working directory
+ResourceHandle ResourceManager::AcquireMesh(const std::string& path, LargeMeshMode mode)
+{
+    return AcquireMeshOf<Mesh>(path, mode, "normal");
+}
+
+/// @brief A mesh with texture coordinates and a texture, which it acquires from this manager
+ResourceHandle ResourceManager::AcquireTexturedMesh(const std::string& path, LargeMeshMode mode)
+{
+    return AcquireMeshOf<TexturedMesh>(path, mode, "normalUV");
+}
+
+/// @brief A texture with its whole mip chain, read and copied into a slice of a texture array
+/// unless it is cached already
+/// @param path The image file; the key the texture is cached under
+/// @param loaded The texture, if it has been read already, say on a loader thread. If not, it is
+/// read here, from the cooked version if there is one.
+ResourceHandle ResourceManager::AcquireTexture(const std::string& path, const LoadedTexture* loaded)
+{
+    auto key = MakeResourceKey(path, "mips");
+    auto handle = m_cache.Find(ResourceType::Texture, key);
+    if (handle.IsValid())
+        return handle;
+
+    LoadedTexture read;
+    if (loaded == nullptr)
+    {
+        if (!ReadTexture(path, read))
+            return ResourceHandle();
+        loaded = &read;
+    }
+
+    auto texture = std::make_shared<TextureResource>();
+    texture->slot = m_textureArrays.Add(*loaded);
+    if (!texture->slot.IsValid())
+        return ResourceHandle();
+    texture->arrays = &m_textureArrays;
+
+    return m_cache.Insert(ResourceType::Texture, key, texture, loaded->GetBytes());
+}
 
-using namespace Assimp;
+/// @brief A vertex and pixel shader pair with their input layout, compiled unless it is cached
+/// already. Pass the same file twice for a shader with both stages in one file.
+ResourceHandle ResourceManager::AcquireShader(const std::wstring& vsFilename, const std::wstring& psFilename, IALayouts layout)
+{
+    auto path = std::filesystem::path(vsFilename).generic_string() + "+" + std::filesystem::path(psFilename).generic_string();
+    auto key = MakeResourceKey(path, "layout=" + std::to_string(layout));
+    auto handle = m_cache.Find(ResourceType::Shader, key);
+    if (handle.IsValid())
+        return handle;
+
+    auto shader = std::make_shared<Shader>();
+    // Compile reports failure with S_FALSE, which FAILED doesn't catch
+    if (shader->Compile(m_device, vsFilename, psFilename, layout) != S_OK)
+    {
+        PLOG_ERROR << "Failed to compile the shader " << path;
+        return ResourceHandle();
+    }
+
+    return m_cache.Insert(ResourceType::Shader, key, shader, shader->GetBytecodeSize());
+}
 
-HRESULT InitResources(ID3D11DeviceContext* pD3D11DeviceContext)
+std::shared_ptr<Mesh> ResourceManager::GetMesh(ResourceHandle handle) const
 {
-    return S_OK;
+    return std::dynamic_pointer_cast<Mesh>(m_cache.Get<RenderBase>(ResourceType::Mesh, handle));
+}
+
+std::shared_ptr<TexturedMesh> ResourceManager::GetTexturedMesh(ResourceHandle handle) const
+{
+    return std::dynamic_pointer_cast<TexturedMesh>(m_cache.Get<RenderBase>(ResourceType::Mesh, handle));
+}
+
+std::shared_ptr<Shader> ResourceManager::GetShader(ResourceHandle handle) const
+{
+    return m_cache.Get<Shader>(ResourceType::Shader, handle);
+}
+
+/// @return The texture's array and slice, or an invalid slot if the handle is stale. Look the
+/// array's view up in GetTextureArrays when binding it, as it changes when the array grows.
+TextureArraySlot ResourceManager::GetTextureSlot(ResourceHandle handle) const
+{
+    auto texture = m_cache.Get<TextureResource>(ResourceType::Texture, handle);
+    return texture != nullptr ? texture->slot : TextureArraySlot();
+}
+
+/// @brief Count the bytes of meshes that have finished loading, and destroy what has been
+/// released for long enough. Call once a frame, after the loader's uploads.
+void ResourceManager::EndFrame()
+{
+    m_loadingMeshes.erase(std::remove_if(m_loadingMeshes.begin(), m_loadingMeshes.end(), [this](ResourceHandle handle)
+    {
+        auto mesh = m_cache.Get<RenderBase>(ResourceType::Mesh, handle);
+        if (mesh == nullptr)
+            return true;
+
+        size_t bytes = mesh->GetGpuBytes();
+        if (bytes == 0)
+            return false;
+
+        m_cache.SetBytes(handle, bytes);
+        return true;
+    }), m_loadingMeshes.end());
+
+    m_cache.EndFrame();
+}
+
+/// @brief Drop the manager's references to everything it made, at once; whatever nothing else
+/// holds is destroyed. Handles to any of it go stale. Shut the loader down first.
+void ResourceManager::Cleanup()
+{
+    m_cache.Clear();
+    m_textureArrays.Cleanup();
+    m_loadingMeshes.clear();
+    m_placeholder.reset();
+    m_loader = nullptr;
+    m_imagePool = nullptr;
+    m_jobSystem = nullptr;
+
+    SafeRelease(m_lightConstantBuffer);
+    SafeRelease(m_device);
+    m_lightConstantBuffer = nullptr;
+    m_device = nullptr;
 }
@@ -1,7 +1,93 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
 #include <d3d11_4.h>
-#include "framework.h"
+
+#include "AsyncLoader.h"
+#include "Culling.h"
+#include "RenderableData.h"
+#include "ResourceCache.h"
 #include "Shader.h"
+#include "TextureArrayCache.h"
+#include "TextureLoader.h"
+
+class JobSystem;
+class Mesh;
+class RenderBase;
+class Renderable;
+class TexturedMesh;
+
+/// @brief A texture's slice of a texture array, as the ResourceManager caches it
+struct TextureResource
+{
+    TextureResource() = default;
+    ~TextureResource();
+
+    TextureResource(const TextureResource&) = delete;
+    TextureResource& operator=(const TextureResource&) = delete;
+
+    TextureArrayCache* arrays = nullptr;    // gets the slice back when the texture is destroyed
+    TextureArraySlot slot;
+};
+
+/// @brief Loads meshes, textures and shaders once each, whoever asks for them, and keeps
+/// them in a ResourceCache keyed by where they came from and how they were loaded.
+///
+/// Everything handed out is a handle holding a reference; give it back with Release. What nothing
+/// holds any more is destroyed a few frames later by EndFrame. Meshes load in the background if
+/// there is an AsyncLoader, drawing the placeholder until they are ready, so their bytes are only
+/// counted once they have loaded. Textures go in the slices of texture arrays, shared by every
+/// texture of the same shape. The bytes of a texture are those of all its mips, of a shader its
+/// bytecode. Samplers are the SamplerCache's.
+///
+/// Use it from the main thread only.
+class ResourceManager
+{
+public:
+    ResourceManager() = default;
+    ~ResourceManager();
+
+    ResourceManager(const ResourceManager&) = delete;
+    ResourceManager& operator=(const ResourceManager&) = delete;
+
+    void Initialize(ID3D11Device* pD3D11Device);
+    void SetMeshDefaults(ID3D11Buffer* lightConstantBuffer, AsyncLoader* loader, ImagePool* imagePool, JobSystem* jobSystem, std::shared_ptr<Renderable> placeholder, const Bounds& placeholderBounds);
+
+    ResourceHandle AcquireMesh(const std::string& path, LargeMeshMode mode = LargeMeshMode::LongIndices);
+    ResourceHandle AcquireTexturedMesh(const std::string& path, LargeMeshMode mode = LargeMeshMode::LongIndices);
+    ResourceHandle AcquireTexture(const std::string& path, const LoadedTexture* loaded = nullptr);
+    ResourceHandle AcquireShader(const std::wstring& vsFilename, const std::wstring& psFilename, IALayouts layout);
+
+    void AddRef(ResourceHandle handle) { m_cache.AddRef(handle); }
+    void Release(ResourceHandle handle) { m_cache.Release(handle); }
+
+    std::shared_ptr<Mesh> GetMesh(ResourceHandle handle) const;
+    std::shared_ptr<TexturedMesh> GetTexturedMesh(ResourceHandle handle) const;
+    std::shared_ptr<Shader> GetShader(ResourceHandle handle) const;
+    TextureArraySlot GetTextureSlot(ResourceHandle handle) const;
+    const TextureArrayCache* GetTextureArrays() const { return &m_textureArrays; }
+    TextureArrayPlannerStats GetTextureArrayStats() const { return m_textureArrays.GetStats(); }
+
+    void EndFrame();
+    ResourceReport GetReport() const { return m_cache.GetReport(); }
+
+    void Cleanup();
+
+private:
+    template <typename T>
+    ResourceHandle AcquireMeshOf(const std::string& path, LargeMeshMode mode, const char* format);
+
+    TextureArrayCache m_textureArrays;             // before the cache, so the textures in it can give their slices back
+    ResourceCache m_cache;
+    std::vector<ResourceHandle> m_loadingMeshes;   // meshes whose bytes are counted once they have loaded
 
-HRESULT InitResources(ID3D11DeviceContext* pD3D11DeviceContext);
\ No newline at end of file
+    ID3D11Device* m_device = nullptr;
+    ID3D11Buffer* m_lightConstantBuffer = nullptr;
+    AsyncLoader* m_loader = nullptr;                // not owned; meshes load synchronously without one
+    ImagePool* m_imagePool = nullptr;               // not owned; staging memory for textures the loader decodes
+    JobSystem* m_jobSystem = nullptr;               // not owned; merges source meshes' parts in parallel when they load without the loader
+    std::shared_ptr<Renderable> m_placeholder;      // drawn by meshes until they have loaded
+    Bounds m_placeholderBounds;
+};
@@ -0,0 +1,128 @@
+#include "SamplerCache.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "framework.h"
+#include "utils.h"
+
+#ifdef _DEBUG
+constexpr char c_cachedSamplerID[] = "cached-sampler";
+#endif
+
+SamplerCache::~SamplerCache()
+{
+    Cleanup();
+}
+
+/// @brief Create the static samplers
+/// @return S_OK if successful, or the error from creating a sampler
+HRESULT SamplerCache::Initialize(ID3D11Device* pD3D11Device)
+{
+    PLOG_INFO << "Creating the static samplers";
+
+    m_device = pD3D11Device;
+    m_device->AddRef();
+
+    for (uint32_t slot = 0; slot < c_staticSamplerCount; slot++)
+    {
+        m_static[slot] = Acquire(GetStaticSamplerKey(static_cast<StaticSampler>(slot)));
+        if (m_static[slot] == nullptr)
+        {
+            PLOG_ERROR << "Failed to create the " << GetStaticSamplerName(static_cast<StaticSampler>(slot)) << " static sampler.";
+            return E_FAIL;
+        }
+    }
+
+    return S_OK;
+}
+
+/// @brief A sampler state, created unless one with the same description, once normalized, has been
+/// already
+/// @return The sampler, or nullptr if it couldn't be created. The cache keeps the reference; the
+/// sampler lives until Cleanup.
+ID3D11SamplerState* SamplerCache::Acquire(const D3D11_SAMPLER_DESC& desc)
+{
+    return Acquire(ToKey(desc));
+}
+
+ID3D11SamplerState* SamplerCache::Acquire(const SamplerKey& key)
+{
+    bool added = false;
+    uint32_t index = m_table.Insert(key, &added);
+    if (!added)
+        return m_samplers[index];
+
+    // Created from the normalized key, so that what D3D makes matches what the table says it is
+    D3D11_SAMPLER_DESC desc = ToDesc(m_table.GetKey(index));
+    ID3D11SamplerState* sampler = nullptr;
+    if (FAILED(m_device->CreateSamplerState(&desc, &sampler)))
+        PLOG_ERROR << "Failed to create a sampler state";
+
+#ifdef _DEBUG
+    if (sampler != nullptr)
+        sampler->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_cachedSamplerID) - 1, c_cachedSamplerID);
+#endif // DEBUG
+
+    // A sampler that failed stays in the table as nullptr, so it isn't tried again every time
+    m_samplers.push_back(sampler);
+    return sampler;
+}
+
+/// @brief Bind the static samplers to their slots. Call once a frame, after StateCache::BeginFrame.
+void SamplerCache::BindStatic(StateCache& stateCache) const
+{
+    BindStaticSamplers(stateCache, m_static);
+}
+
+SamplerKey SamplerCache::ToKey(const D3D11_SAMPLER_DESC& desc)
+{
+    SamplerKey key;
+    key.filter = static_cast<uint32_t>(desc.Filter);
+    key.addressU = static_cast<uint32_t>(desc.AddressU);
+    key.addressV = static_cast<uint32_t>(desc.AddressV);
+    key.addressW = static_cast<uint32_t>(desc.AddressW);
+    key.mipLodBias = desc.MipLODBias;
+    key.maxAnisotropy = desc.MaxAnisotropy;
+    key.comparisonFunc = static_cast<uint32_t>(desc.ComparisonFunc);
+    for (size_t index = 0; index < 4; index++)
+    {
+        key.borderColor[index] = desc.BorderColor[index];
+    }
+    key.minLod = desc.MinLOD;
+    key.maxLod = desc.MaxLOD;
+    return key;
+}
+
+D3D11_SAMPLER_DESC SamplerCache::ToDesc(const SamplerKey& key)
+{
+    D3D11_SAMPLER_DESC desc = {};
+    desc.Filter = static_cast<D3D11_FILTER>(key.filter);
+    desc.AddressU = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(key.addressU);
+    desc.AddressV = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(key.addressV);
+    desc.AddressW = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(key.addressW);
+    desc.MipLODBias = key.mipLodBias;
+    desc.MaxAnisotropy = key.maxAnisotropy;
+    desc.ComparisonFunc = static_cast<D3D11_COMPARISON_FUNC>(key.comparisonFunc);
+    for (size_t index = 0; index < 4; index++)
+    {
+        desc.BorderColor[index] = key.borderColor[index];
+    }
+    desc.MinLOD = key.minLod;
+    desc.MaxLOD = key.maxLod;
+    return desc;
+}
+
+void SamplerCache::Cleanup()
+{
+    for (auto* sampler : m_samplers)
+    {
+        SafeRelease(sampler);
+    }
+    m_samplers.clear();
+    m_table.Clear();
+    std::fill(std::begin(m_static), std::end(m_static), nullptr);
+
+    SafeRelease(m_device);
+    m_device = nullptr;
+}
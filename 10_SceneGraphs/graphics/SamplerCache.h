@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <d3d11_4.h>
+
+#include "SamplerTable.h"
+#include "StateCache.h"
+
+/// @brief Every sampler state the renderer uses, created once for each distinct description and
+/// held until Cleanup.
+///
+/// Descriptions are deduplicated through a SamplerTable, keyed on the hash of the normalized
+/// description, so asking for a sampler that exists already is a hash lookup and never a call into
+/// D3D. The static samplers are made by Initialize and bound once a frame by BindStatic; shaders
+/// declare them at the slots StaticSampler gives, and nothing binds a sampler per draw.
+///
+/// Use it from the main thread only.
+class SamplerCache
+{
+public:
+    SamplerCache() = default;
+    ~SamplerCache();
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+    HRESULT Initialize(ID3D11Device* pD3D11Device);
+
+    ID3D11SamplerState* Acquire(const D3D11_SAMPLER_DESC& desc);
+    ID3D11SamplerState* GetStatic(StaticSampler sampler) const { return m_static[static_cast<uint32_t>(sampler)]; }
+    void BindStatic(StateCache& stateCache) const;
+
+    SamplerTableStats GetStats() const { return m_table.GetStats(); }
+
+    static SamplerKey ToKey(const D3D11_SAMPLER_DESC& desc);
+    static D3D11_SAMPLER_DESC ToDesc(const SamplerKey& key);
+
+    void Cleanup();
+
+private:
+    ID3D11SamplerState* Acquire(const SamplerKey& key);
+
+    ID3D11Device* m_device = nullptr;
+    SamplerTable m_table;
+    std::vector<ID3D11SamplerState*> m_samplers;                    // by index in the table
+    ID3D11SamplerState* m_static[c_staticSamplerCount] = {};        // by slot; the cache holds the references
+};
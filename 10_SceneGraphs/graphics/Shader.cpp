@@ -102,6 +102,7 @@ HRESULT Shader::Compile(ID3D11Device* pD3D11Device, const std::wstring& filename
             return S_FALSE;
         }
 
+    m_bytecodeSize = psBlob->GetBufferSize();
     psBlob->Release();
 
 #ifdef _DEBUG
@@ -122,6 +123,7 @@ HRESULT Shader::Compile(ID3D11Device* pD3D11Device, const std::wstring& filename
             return S_FALSE;
         }
 
+    m_bytecodeSize += vsBlob->GetBufferSize();
     vsBlob->Release();
 
 #ifdef _DEBUG
@@ -212,6 +214,7 @@ HRESULT Shader::Compile(ID3D11Device* pD3D11Device,const std::wstring& vsFilenam
             return S_FALSE;
         }
 
+    m_bytecodeSize = psBlob->GetBufferSize();
     psBlob->Release();
 
 #ifdef _DEBUG
@@ -232,6 +235,7 @@ HRESULT Shader::Compile(ID3D11Device* pD3D11Device,const std::wstring& vsFilenam
             return S_FALSE;
         }
 
+    m_bytecodeSize += vsBlob->GetBufferSize();
     vsBlob->Release();
 
 #ifdef _DEBUG
@@ -240,6 +244,16 @@ HRESULT Shader::Compile(ID3D11Device* pD3D11Device,const std::wstring& vsFilenam
     return S_OK;
 }
 
+/// @brief Bind the input layout and the vertex and pixel shaders
+/// @param stateCache The state cache to bind through
+void Shader::Bind(StateCache& stateCache)
+{
+    stateCache.IASetInputLayout(m_inputLayout);
+
+    stateCache.VSSetShader(m_vertexShader);
+    stateCache.PSSetShader(m_pixelShader);
+}
+
 void Shader::Cleanup()
 {
     PLOG_INFO << "Cleaning up the Shader";
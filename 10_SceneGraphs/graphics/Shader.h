@@ -1,14 +1,21 @@
 #pragma once
 
 #include <d3d11.h>
+#include <memory>
 #include <vector>
 #include <string>
 
+#include "StateCache.h"
+
 enum IALayouts
 {
     IALayout_VertexColor = 0,
     IALayout_VertexColorNormal,
-    IALayout_VertexColorNormalUV
+    IALayout_VertexColorNormalUV,
+    IALayout_PackedVertexNormal,
+    IALayout_PackedVertexNormalUV,
+    IALayout_PackedVertexNormalInstanced,
+    IALayout_PackedVertexNormalUVInstanced
 };
 
 const std::vector<std::vector<D3D11_INPUT_ELEMENT_DESC>> m_IALayouts = {
@@ -26,6 +33,35 @@ const std::vector<std::vector<D3D11_INPUT_ELEMENT_DESC>> m_IALayouts = {
         { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+    },
+    // The packed layouts match PackedVertexNormal and PackedVertexNormalUV: positions quantized to
+    // the mesh's bounds, octahedral normals and half float texture coordinates
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+    },
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+    },
+    // The instanced layouts take the local to world matrix, a row per element, from vertex buffer slot 1
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+    },
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
     }
 };
 
@@ -51,6 +87,8 @@ public:
 
     void Cleanup();
 
+    void Bind(StateCache& stateCache);
+
     ID3D11InputLayout* GetLayout()
     {
         return m_inputLayout;
@@ -66,8 +104,20 @@ public:
         return m_pixelShader;
     }
 
+    /// @brief The same shader, reading its local to world matrix from per-instance data instead of
+    /// a constant buffer. Draws with this shader can only be instanced when it has one.
+    void SetInstancedVariant(std::shared_ptr<Shader> variant) { m_instancedVariant = variant; }
+    Shader* GetInstancedVariant() { return m_instancedVariant.get(); }
+
+    /// @brief How big the compiled vertex and pixel shaders are, which is as near as we can get to
+    /// what the driver keeps for them
+    size_t GetBytecodeSize() const { return m_bytecodeSize; }
+
 private:
     ID3D11VertexShader* m_vertexShader = nullptr; // The Vertex Shader resource used in this example
     ID3D11PixelShader* m_pixelShader = nullptr;   // The Pixel Shader resource used in this example
     ID3D11InputLayout* m_inputLayout = nullptr;   // The Input layout resource used for the vertex shader
+
+    std::shared_ptr<Shader> m_instancedVariant;
+    size_t m_bytecodeSize = 0;
 };
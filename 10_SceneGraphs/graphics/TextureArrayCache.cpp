@@ -0,0 +1,172 @@
+#include "TextureArrayCache.h"
+
+#include <algorithm>
+
+#include "framework.h"
+#include "utils.h"
+
+#ifdef _DEBUG
+constexpr char c_textureArrayID[] = "texture-array";
+constexpr char c_textureArrayViewID[] = "texture-array-view";
+#endif
+
+TextureArrayCache::~TextureArrayCache()
+{
+    Cleanup();
+}
+
+void TextureArrayCache::Initialize(ID3D11Device* pD3D11Device, const TextureArrayLimits& limits)
+{
+    m_device = pD3D11Device;
+    m_device->AddRef();
+    m_device->GetImmediateContext(&m_context);
+    m_planner = TextureArrayPlanner(limits);
+}
+
+/// @brief Copy a texture that ReadTexture has read into a slice of an array of its shape, making
+/// the array, or making it bigger, first if it has to be
+/// @return The texture's slot, or an invalid one if there was no room for it
+TextureArraySlot TextureArrayCache::Add(const LoadedTexture& texture)
+{
+    TextureShape shape = GetTextureShape(texture);
+    if (shape.width == 0)
+        return TextureArraySlot();
+
+    auto placement = m_planner.Place(shape);
+    auto slot = placement.slot;
+    while (m_arrays.size() <= slot.array)
+    {
+        m_arrays.push_back(std::make_unique<GpuArray>());
+    }
+
+    if (placement.created || placement.grown)
+        CreateArray(slot.array, placement.grown ? placement.previousCapacity : 0);
+
+    auto& array = *m_arrays[slot.array];
+    if (slot.slice >= array.capacity)
+    {
+        PLOG_ERROR << "No room in a texture array for " << texture.path;
+        m_planner.Release(slot);
+        if (m_planner.GetArray(slot.array).capacity == 0)
+            ReleaseArray(array);
+        return TextureArraySlot();
+    }
+
+    WriteLoadedTexture(texture, m_context, array.texture, slot.slice);
+    return slot;
+}
+
+/// @brief Give a texture's slice back, for the next texture of its shape. An array with nothing
+/// left in it is destroyed.
+void TextureArrayCache::Remove(TextureArraySlot slot)
+{
+    if (!slot.IsValid() || slot.array >= m_arrays.size())
+        return;
+
+    m_planner.Release(slot);
+    if (m_planner.GetArray(slot.array).capacity == 0)
+        ReleaseArray(*m_arrays[slot.array]);
+}
+
+/// @return The view of every slice of an array, or nullptr if there isn't one. The cache keeps the
+/// reference, and the view changes whenever the array grows, so look it up each time it is bound.
+ID3D11ShaderResourceView* TextureArrayCache::GetView(uint32_t array) const
+{
+    return array < m_arrays.size() ? m_arrays[array]->view : nullptr;
+}
+
+/// @return What draws from an array share, for sorting them together; unlike the view, it stays
+/// the same when the array grows
+const void* TextureArrayCache::GetStateKey(uint32_t array) const
+{
+    return array < m_arrays.size() ? m_arrays[array].get() : nullptr;
+}
+
+/// @brief Make an array at its planned capacity, copying the first slices of the one it replaces
+/// @param copySlices How many slices, each with every mip, to copy from the array made before
+bool TextureArrayCache::CreateArray(uint32_t index, uint32_t copySlices)
+{
+    const auto& planned = m_planner.GetArray(index);
+    auto& array = *m_arrays[index];
+
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width = planned.shape.width;
+    textureDesc.Height = planned.shape.height;
+    textureDesc.MipLevels = planned.shape.mipCount;
+    textureDesc.ArraySize = planned.capacity;
+    textureDesc.Format = static_cast<DXGI_FORMAT>(planned.shape.format);
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    ID3D11Texture2D* texture = nullptr;
+    HRESULT hr = m_device->CreateTexture2D(&textureDesc, nullptr, &texture);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create a texture array of " << planned.capacity << " slices of " << planned.shape.width << "x" << planned.shape.height;
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = textureDesc.Format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MipLevels = textureDesc.MipLevels;
+    viewDesc.Texture2DArray.ArraySize = textureDesc.ArraySize;
+
+    ID3D11ShaderResourceView* view = nullptr;
+    hr = m_device->CreateShaderResourceView(texture, &viewDesc, &view);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create the view of a texture array";
+        texture->Release();
+        return false;
+    }
+
+#ifdef _DEBUG
+    texture->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_textureArrayID) - 1, c_textureArrayID);
+    view->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_textureArrayViewID) - 1, c_textureArrayViewID);
+#endif // DEBUG
+
+    if (array.texture != nullptr)
+    {
+        copySlices = std::min(copySlices, array.capacity);
+        for (uint32_t slice = 0; slice < copySlices; slice++)
+        {
+            for (uint32_t level = 0; level < planned.shape.mipCount; level++)
+            {
+                UINT subresource = D3D11CalcSubresource(level, slice, planned.shape.mipCount);
+                m_context->CopySubresourceRegion(texture, subresource, 0, 0, 0, array.texture, subresource, nullptr);
+            }
+        }
+    }
+
+    ReleaseArray(array);
+    array.texture = texture;
+    array.view = view;
+    array.capacity = planned.capacity;
+    return true;
+}
+
+void TextureArrayCache::ReleaseArray(GpuArray& array)
+{
+    SafeRelease(array.view);
+    SafeRelease(array.texture);
+    array.view = nullptr;
+    array.texture = nullptr;
+    array.capacity = 0;
+}
+
+void TextureArrayCache::Cleanup()
+{
+    for (auto& array : m_arrays)
+    {
+        ReleaseArray(*array);
+    }
+    m_arrays.clear();
+    m_planner.Clear();
+
+    SafeRelease(m_context);
+    SafeRelease(m_device);
+    m_context = nullptr;
+    m_device = nullptr;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <d3d11_4.h>
+
+#include "TextureArrayPlanner.h"
+#include "TextureLoader.h"
+
+/// @brief Texture arrays that textures are packed into, a slice each, laid out by a
+/// TextureArrayPlanner.
+///
+/// Every texture of the same size, mip count and format shares an array, so draws of any of them
+/// bind the same view and pick their texture by slice, from the per-draw constants or the instance
+/// data. An array that fills is made again at twice the size, its slices copied across on the GPU;
+/// its index, and the key the render queue sorts it by, stay the same, so materials look the view
+/// up when they are used rather than holding on to it.
+///
+/// Use it from the thread that owns the immediate context.
+class TextureArrayCache
+{
+public:
+    TextureArrayCache() = default;
+    ~TextureArrayCache();
+
+    TextureArrayCache(const TextureArrayCache&) = delete;
+    TextureArrayCache& operator=(const TextureArrayCache&) = delete;
+
+    void Initialize(ID3D11Device* pD3D11Device, const TextureArrayLimits& limits = TextureArrayLimits());
+
+    TextureArraySlot Add(const LoadedTexture& texture);
+    void Remove(TextureArraySlot slot);
+
+    ID3D11ShaderResourceView* GetView(uint32_t array) const;
+    const void* GetStateKey(uint32_t array) const;
+    TextureArrayPlannerStats GetStats() const { return m_planner.GetStats(); }
+
+    void Cleanup();
+
+private:
+    // An array on the GPU, which may have fewer slices than planned if making it bigger failed
+    struct GpuArray
+    {
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11ShaderResourceView* view = nullptr;
+        uint32_t capacity = 0;
+    };
+
+    bool CreateArray(uint32_t array, uint32_t copySlices);
+    void ReleaseArray(GpuArray& array);
+
+    ID3D11Device* m_device = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    TextureArrayPlanner m_planner;
+    std::vector<std::unique_ptr<GpuArray>> m_arrays;   // by the planner's index; never move, so their addresses are the state keys
+};
@@ -0,0 +1,330 @@
+#include "TextureLoader.h"
+
+#include <algorithm>
+
+#include "TextureMips.h"
+#include "plog/Log.h"
+#include "utils.h"
+
+namespace
+{
+    // Touching one byte in each page is enough to have the whole file read in
+    constexpr size_t c_pageSize = 4096;
+
+    /// @brief The format a cooked texture is created with. The UNORM formats are used even for sRGB
+    /// textures, as the shaders and back buffer work on the encoded values, as they always have.
+    DXGI_FORMAT GetDxgiFormat(CookedTextureFormat format)
+    {
+        switch (format)
+        {
+        case CookedTextureFormat::RGBA8:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case CookedTextureFormat::BC1:
+            return DXGI_FORMAT_BC1_UNORM;
+        case CookedTextureFormat::BC3:
+            return DXGI_FORMAT_BC3_UNORM;
+        case CookedTextureFormat::BC7:
+            return DXGI_FORMAT_BC7_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    bool OpenCookedTexture(const std::filesystem::path& path, OpenedCookedTexture& texture)
+    {
+        if (!texture.file.Open(path.string()))
+        {
+            PLOG_ERROR << "Failed to map cooked texture " << path;
+            return false;
+        }
+
+        if (!texture.view.Open(texture.file.GetData(), texture.file.GetSize()))
+        {
+            PLOG_ERROR << "Cooked texture " << path << " is unusable: " << texture.view.GetError();
+            return false;
+        }
+
+        const auto* bytes = static_cast<const volatile uint8_t*>(texture.file.GetData());
+        uint8_t touched = 0;
+        for (size_t offset = 0; offset < texture.file.GetSize(); offset += c_pageSize)
+        {
+            touched ^= bytes[offset];
+        }
+        (void)touched;
+
+        return true;
+    }
+}
+
+/// @brief Give the mips back to the pool they came from
+LoadedTexture::~LoadedTexture()
+{
+    if (pool == nullptr)
+        return;
+
+    pool->Unreserve(pooledBytes);
+    for (auto& mip : mips)
+    {
+        pool->Give(std::move(mip.pixels));
+    }
+}
+
+/// @brief Bytes the texture takes on the GPU, every level included
+size_t LoadedTexture::GetBytes() const
+{
+    size_t bytes = 0;
+    if (cooked != nullptr)
+    {
+        for (uint32_t level = 0; level < cooked->view.GetHeader().mipCount; level++)
+            bytes += static_cast<size_t>(cooked->view.GetMip(level).size);
+        return bytes;
+    }
+
+    for (const auto& mip : mips)
+        bytes += mip.pixels.size();
+    return bytes;
+}
+
+/// @brief Find the cooked version of a source image: a .wtgt file next to it with the same name.
+/// A cooked file older than its source is ignored, so an edited image isn't hidden by a stale one.
+/// @return The path of the cooked texture, or an empty path if there isn't a usable one
+std::filesystem::path FindCookedTexture(const std::filesystem::path& sourcePath)
+{
+    std::filesystem::path cookedPath = sourcePath;
+    cookedPath.replace_extension(c_cookedTextureExtension);
+
+    std::error_code error;
+    if (!std::filesystem::exists(cookedPath, error))
+        return {};
+
+    if (cookedPath != sourcePath && std::filesystem::exists(sourcePath, error)
+        && std::filesystem::last_write_time(sourcePath, error) > std::filesystem::last_write_time(cookedPath, error))
+    {
+        PLOG_WARNING << "Ignoring " << cookedPath << " as it is older than " << sourcePath << "; run TextureCooker again";
+        return {};
+    }
+
+    return cookedPath;
+}
+
+/// @brief The first half of ReadTexture: map the cooked version of a texture if there is one, else
+/// map the source image and read its size. Safe to call from any thread.
+bool OpenTexture(const std::filesystem::path& path, LoadedTexture& texture)
+{
+    texture.path = path;
+
+    auto cookedPath = FindCookedTexture(path);
+    if (!cookedPath.empty())
+    {
+        auto cooked = std::make_unique<OpenedCookedTexture>();
+        if (OpenCookedTexture(cookedPath, *cooked))
+        {
+            texture.cooked = std::move(cooked);
+            return true;
+        }
+        PLOG_WARNING << "Falling back to the source image " << path;
+    }
+
+    if (!texture.source.Open(path.string()))
+    {
+        PLOG_ERROR << "Failed to load texture from file: " << path << ": can't open the file";
+        return false;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::string error;
+    if (!ReadImageSize(texture.source.GetData(), texture.source.GetSize(), width, height, error))
+    {
+        PLOG_ERROR << "Failed to load texture from file: " << path << ": " << error;
+        return false;
+    }
+    texture.mips.resize(GetMipCount(width, height));
+    texture.mips[0].width = width;
+    texture.mips[0].height = height;
+    texture.decodedBytes = GetMipChainBytes(width, height);
+    return true;
+}
+
+/// @brief Reserve the memory to decode several opened textures in one go, waiting for the pool's
+/// budget to have room for all of them. A load holding part of its memory while it waited for the
+/// rest could stop every other load from getting theirs, itself included. Each texture gives its
+/// share back when it is destroyed. Only from a loader thread; see ImagePool.
+void ReserveTextures(ImagePool& pool, const std::vector<LoadedTexture*>& textures)
+{
+    size_t bytes = 0;
+    for (const auto* texture : textures)
+        bytes += texture->decodedBytes;
+    if (bytes == 0)
+        return;
+
+    pool.Reserve(bytes);
+    for (auto* texture : textures)
+    {
+        texture->pool = &pool;
+        texture->pooledBytes = texture->decodedBytes;
+    }
+}
+
+/// @brief The second half of ReadTexture: decode an opened source image, into the buffers of the
+/// pool that ReserveTextures reserved it from if any, and box filter its mips. Does nothing for
+/// cooked textures. Safe to call from any thread.
+bool DecodeTexture(LoadedTexture& texture)
+{
+    if (texture.cooked != nullptr)
+        return true;
+    if (!texture.source.IsOpen() || texture.mips.empty())
+        return false;
+
+    if (texture.pool != nullptr)
+    {
+        uint32_t width = texture.mips[0].width;
+        uint32_t height = texture.mips[0].height;
+        for (size_t level = 0; level < texture.mips.size(); level++)
+        {
+            texture.mips[level].pixels = texture.pool->Take(static_cast<size_t>(std::max(1u, width >> level)) * std::max(1u, height >> level) * 4);
+        }
+    }
+
+    std::string error;
+    bool decoded = DecodeImageMemory(texture.source.GetData(), texture.source.GetSize(), texture.mips[0], error);
+    texture.source.Close();
+    if (!decoded)
+    {
+        PLOG_ERROR << "Failed to load texture from file: " << texture.path << ": " << error;
+        return false;
+    }
+
+    // The box filter is quick enough to run at load time; cooking gets the sharper Kaiser filter
+    MipOptions options;
+    options.filter = MipFilter::Box;
+    FillMipChain(options, texture.mips);
+    return true;
+}
+
+/// @brief Read a texture ready for CreateLoadedTexture: the cooked version, with its filtered and
+/// compressed mips, if there is one, else the source image with box filtered mips made here. Safe
+/// to call from any thread.
+/// @param pool Decode into its buffers, waiting for its budget to have room for the whole mip chain
+/// first; only from a loader thread. Without one the mips are allocated as they are made.
+bool ReadTexture(const std::filesystem::path& path, LoadedTexture& texture, ImagePool* pool)
+{
+    if (!OpenTexture(path, texture))
+        return false;
+
+    if (pool != nullptr)
+        ReserveTextures(*pool, { &texture });
+    return DecodeTexture(texture);
+}
+
+/// @brief Create a texture that ReadTexture has read, with all of its mips in the one call, and a
+/// view of every level as a one slice array. Call on the thread that owns the device context.
+/// @param ppTexture Set to the new texture; the caller owns it
+/// @param ppView Set to the new view; the caller owns it
+bool CreateLoadedTexture(const LoadedTexture& texture, ID3D11Device* pD3D11Device, ID3D11Texture2D** ppTexture, ID3D11ShaderResourceView** ppView)
+{
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.ArraySize = 1;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> levels;
+    if (texture.cooked != nullptr)
+    {
+        const auto& view = texture.cooked->view;
+        const auto& header = view.GetHeader();
+        textureDesc.Width = header.width;
+        textureDesc.Height = header.height;
+        textureDesc.Format = GetDxgiFormat(view.GetFormat());
+        for (uint32_t level = 0; level < header.mipCount; level++)
+        {
+            levels.push_back(D3D11_SUBRESOURCE_DATA{ view.GetMipData(level), view.GetMip(level).rowPitch, 0 });
+        }
+    }
+    else
+    {
+        if (texture.mips.empty())
+            return false;
+
+        textureDesc.Width = texture.mips[0].width;
+        textureDesc.Height = texture.mips[0].height;
+        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        for (const auto& mip : texture.mips)
+        {
+            levels.push_back(D3D11_SUBRESOURCE_DATA{ mip.pixels.data(), mip.GetPitch(), 0 });
+        }
+    }
+    textureDesc.MipLevels = static_cast<UINT>(levels.size());
+
+    HRESULT hr = pD3D11Device->CreateTexture2D(&textureDesc, levels.data(), ppTexture);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create the texture for " << texture.path;
+        return false;
+    }
+
+    // Viewed as an array of one, as the textured shaders sample texture arrays
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = textureDesc.Format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MipLevels = textureDesc.MipLevels;
+    viewDesc.Texture2DArray.ArraySize = 1;
+
+    hr = pD3D11Device->CreateShaderResourceView(*ppTexture, &viewDesc, ppView);
+    if (FAILED(hr))
+    {
+        PLOG_ERROR << "Failed to create the shader resource view for " << texture.path;
+        SafeRelease(*ppTexture);
+        *ppTexture = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief What a texture that ReadTexture has read needs in an array to share it
+/// @return A shape with no width if nothing was read
+TextureShape GetTextureShape(const LoadedTexture& texture)
+{
+    TextureShape shape;
+    if (texture.cooked != nullptr)
+    {
+        const auto& header = texture.cooked->view.GetHeader();
+        shape.width = header.width;
+        shape.height = header.height;
+        shape.mipCount = header.mipCount;
+        shape.format = GetDxgiFormat(texture.cooked->view.GetFormat());
+    }
+    else if (!texture.mips.empty())
+    {
+        shape.width = texture.mips[0].width;
+        shape.height = texture.mips[0].height;
+        shape.mipCount = static_cast<uint32_t>(texture.mips.size());
+        shape.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+    shape.sliceBytes = texture.GetBytes();
+    return shape;
+}
+
+/// @brief Copy every mip of a texture that ReadTexture has read into a slice of a texture array of
+/// its shape. Call on the thread that owns the device context.
+void WriteLoadedTexture(const LoadedTexture& texture, ID3D11DeviceContext* pD3D11DeviceContext, ID3D11Texture2D* pArray, uint32_t slice)
+{
+    TextureShape shape = GetTextureShape(texture);
+    for (uint32_t level = 0; level < shape.mipCount; level++)
+    {
+        const void* data = nullptr;
+        UINT rowPitch = 0;
+        if (texture.cooked != nullptr)
+        {
+            data = texture.cooked->view.GetMipData(level);
+            rowPitch = texture.cooked->view.GetMip(level).rowPitch;
+        }
+        else
+        {
+            data = texture.mips[level].pixels.data();
+            rowPitch = texture.mips[level].GetPitch();
+        }
+        pD3D11DeviceContext->UpdateSubresource(pArray, D3D11CalcSubresource(level, slice, shape.mipCount), nullptr, data, rowPitch, 0);
+    }
+}
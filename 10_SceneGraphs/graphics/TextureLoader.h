@@ -0,0 +1,60 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <d3d11.h>
+
+#include "CookedTexture.h"
+#include "ImageDecoder.h"
+#include "ImagePool.h"
+#include "MappedFile.h"
+#include "TextureArrayPlanner.h"
+
+/// Loading for textures, in two halves like MeshLoader so the slow one can run on a loader thread.
+/// ReadTexture maps the cooked texture if TextureCooker has made one, or decodes the source image
+/// and box filters its mips if not. CreateLoadedTexture then creates the texture with its whole mip
+/// chain in one call, on the thread that owns the device, or WriteLoadedTexture copies it into a
+/// slice of a texture array of its shape. Given an ImagePool, ReadTexture decodes into its buffers,
+/// waiting for room in its budget first, and they go back when the texture does. A load of several
+/// textures opens them all with OpenTexture, reserves them together with ReserveTextures, then
+/// decodes each with DecodeTexture.
+
+/// @brief A cooked texture that has been mapped and checked, waiting for its texture to be created
+struct OpenedCookedTexture
+{
+    MappedFile file;
+    CookedTextureView view;
+};
+
+/// @brief Everything ReadTexture read for one texture
+struct LoadedTexture
+{
+    std::filesystem::path path;                     // the source image asked for
+    std::unique_ptr<OpenedCookedTexture> cooked;    // its cooked version, if there was a usable one
+    MappedFile source;                              // otherwise, the source image, until it is decoded
+    std::vector<DecodedImage> mips;                 // and the decoded image and its mips, finest first
+    size_t decodedBytes = 0;                        // what decoding the source's whole mip chain takes
+    ImagePool* pool = nullptr;                      // where the mips' memory came from, if anywhere
+    size_t pooledBytes = 0;                         // and how much of its budget they hold
+
+    LoadedTexture() = default;
+    ~LoadedTexture();
+
+    LoadedTexture(const LoadedTexture&) = delete;
+    LoadedTexture& operator=(const LoadedTexture&) = delete;
+
+    size_t GetBytes() const;
+};
+
+std::filesystem::path FindCookedTexture(const std::filesystem::path& sourcePath);
+
+bool OpenTexture(const std::filesystem::path& path, LoadedTexture& texture);
+void ReserveTextures(ImagePool& pool, const std::vector<LoadedTexture*>& textures);
+bool DecodeTexture(LoadedTexture& texture);
+bool ReadTexture(const std::filesystem::path& path, LoadedTexture& texture, ImagePool* pool = nullptr);
+
+bool CreateLoadedTexture(const LoadedTexture& texture, ID3D11Device* pD3D11Device, ID3D11Texture2D** ppTexture, ID3D11ShaderResourceView** ppView);
+
+TextureShape GetTextureShape(const LoadedTexture& texture);
+void WriteLoadedTexture(const LoadedTexture& texture, ID3D11DeviceContext* pD3D11DeviceContext, ID3D11Texture2D* pArray, uint32_t slice);
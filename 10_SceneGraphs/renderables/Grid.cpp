@@ -102,7 +102,9 @@ HRESULT Grid::Initialize(ID3D11Device * pD3D11Device)
     stride = 3 * sizeof(float) + 4 * sizeof(float);
     offset = 0;
 
-    numIndices = static_cast<uint16_t>(gridIndices.size());
+    numIndices = static_cast<UINT>(gridIndices.size());
+
+    SetLocalBounds(ComputeBounds(gridVertexData.data(), gridVertexData.size() * sizeof(float) / stride, stride));
 
     D3D11_BUFFER_DESC gridVertexBufferDesc = {};
     gridVertexBufferDesc.ByteWidth = static_cast<UINT>(gridVertexData.size() * sizeof(float));
@@ -153,46 +155,23 @@ HRESULT Grid::Initialize(ID3D11Device * pD3D11Device)
     m_gridIndexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_gridIndexBufferID) - 1, c_gridIndexBufferID);
 #endif
 
-    D3D11_BUFFER_DESC localToWorldConstantBufferDesc = {};
-    localToWorldConstantBufferDesc.ByteWidth = sizeof(LocalToWorldConstantBuffer);
-    localToWorldConstantBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    localToWorldConstantBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    localToWorldConstantBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-    if (FAILED(pD3D11Device->CreateBuffer(&localToWorldConstantBufferDesc, nullptr, &m_worldConstantBuffer)))
-    {
-        PLOG_ERROR << "Failed to create a new constant buffer.";
-        return S_FALSE;
-    }
-
     return S_OK;
 }
 
-void Grid::Draw(ID3D11DeviceContext* pD3DContext,std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+void Grid::Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
 {
-    Render(pD3DContext, shader, world);
+    Render(stateCache, worldConstants);
 }
 
-void Grid::Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+void Grid::Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
 {
-    {
-        D3D11_MAPPED_SUBRESOURCE mappedSubresource;
-        pD3D11DeviceContext->Map(m_worldConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
-        LocalToWorldConstantBuffer* constants = (LocalToWorldConstantBuffer*)(mappedSubresource.pData);
-        constants->mLocalToWorld = world;
-        pD3D11DeviceContext->Unmap(m_worldConstantBuffer, 0);
-    }
-    pD3D11DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-    pD3D11DeviceContext->IASetInputLayout(shader->GetLayout());
-
-    pD3D11DeviceContext->VSSetShader(shader->GetVertexShader(), nullptr, 0);
-    pD3D11DeviceContext->PSSetShader(shader->GetPixelShader(), nullptr, 0);
-    pD3D11DeviceContext->VSSetConstantBuffers(1, 1, &m_worldConstantBuffer);
+    stateCache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+    stateCache.VSSetConstantBuffer(1, worldConstants);
 
-    pD3D11DeviceContext->IASetVertexBuffers(0, 1, &m_gridVertexBuffer, &stride, &offset);
-    pD3D11DeviceContext->IASetIndexBuffer(m_gridIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+    stateCache.IASetVertexBuffer(0, m_gridVertexBuffer, stride, offset);
+    stateCache.IASetIndexBuffer(m_gridIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
 
-    pD3D11DeviceContext->DrawIndexed(numIndices, 0, 0);
+    stateCache.DrawIndexed(numIndices, 0, 0);
 }
 
 void Grid::Cleanup()
@@ -201,9 +180,7 @@ void Grid::Cleanup()
 
     SafeRelease(m_gridVertexBuffer);
     SafeRelease(m_gridIndexBuffer);
-    SafeRelease(m_worldConstantBuffer);
 
     m_gridVertexBuffer = nullptr;
     m_gridIndexBuffer = nullptr;
-    m_worldConstantBuffer = nullptr;
 }
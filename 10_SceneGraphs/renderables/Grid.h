@@ -13,13 +13,12 @@ public:
     ~Grid();
 
     HRESULT Initialize(ID3D11Device* pD3D11Device);
-    void Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world);
+    void Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants);
     void Cleanup() override;
 
-    virtual void Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) override;
+    virtual void Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants) override;
 
 private:
     ID3D11Buffer* m_gridVertexBuffer = nullptr;     // The D3D11 Buffer used to hold the vertex data for the grid
     ID3D11Buffer* m_gridIndexBuffer = nullptr;      // The D3D11 Index Buffer for the grid
-    ID3D11Buffer* m_worldConstantBuffer = nullptr;  // The D3D11 Constant buffer used for World Transforms
 };
@@ -42,6 +42,8 @@ HRESULT Light::Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstan
 
     numIndices = static_cast<UINT>(indices.size());
 
+    SetLocalBounds(ComputeBounds(vertexData.data(), vertexData.size() * sizeof(float) / stride, stride));
+
     D3D11_BUFFER_DESC vertexBufferDesc = {};
     vertexBufferDesc.ByteWidth = static_cast<UINT>(vertexData.size() * sizeof(float));
     vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
@@ -89,50 +91,27 @@ HRESULT Light::Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstan
     m_indices->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(c_indexBufferID) - 1, c_indexBufferID);
 #endif
 
-    D3D11_BUFFER_DESC localToWorldConstantBufferDesc = {};
-    localToWorldConstantBufferDesc.ByteWidth = sizeof(LocalToWorldConstantBuffer);
-    localToWorldConstantBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    localToWorldConstantBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    localToWorldConstantBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-    if (FAILED(pD3D11Device->CreateBuffer(&localToWorldConstantBufferDesc, nullptr, &m_worldConstantBuffer)))
-    {
-        PLOG_ERROR << "Failed to create a new constant buffer.";
-        return S_FALSE;
-    }
-
     lightConstantBuffer = lightConstantBufferPtr;
     lightConstantBuffer->AddRef();
 
     return S_OK;
 }
 
-void Light::Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+void Light::Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
 {
-    Render(pD3DContext, shader, world);
+    Render(stateCache, worldConstants);
 }
 
-void Light::Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+void Light::Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
 {
-    {
-        D3D11_MAPPED_SUBRESOURCE mappedSubresource;
-        pD3D11DeviceContext->Map(m_worldConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
-        LocalToWorldConstantBuffer* constants = (LocalToWorldConstantBuffer*)(mappedSubresource.pData);
-        constants->mLocalToWorld = world;
-        pD3D11DeviceContext->Unmap(m_worldConstantBuffer, 0);
-    }
-    pD3D11DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-    pD3D11DeviceContext->IASetInputLayout(shader->GetLayout());
-
-    pD3D11DeviceContext->VSSetShader(shader->GetVertexShader(), nullptr, 0);
-    pD3D11DeviceContext->PSSetShader(shader->GetPixelShader(), nullptr, 0);
-    pD3D11DeviceContext->VSSetConstantBuffers(1, 1, &m_worldConstantBuffer);
-    pD3D11DeviceContext->VSSetConstantBuffers(2, 1, &lightConstantBuffer);
+    stateCache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+    stateCache.VSSetConstantBuffer(1, worldConstants);
+    stateCache.VSSetConstantBuffer(2, lightConstantBuffer);
 
-    pD3D11DeviceContext->IASetVertexBuffers(0, 1, &m_vertices, &stride, &offset);
-    pD3D11DeviceContext->IASetIndexBuffer(m_indices, DXGI_FORMAT_R16_UINT, 0);
+    stateCache.IASetVertexBuffer(0, m_vertices, stride, offset);
+    stateCache.IASetIndexBuffer(m_indices, DXGI_FORMAT_R16_UINT, 0);
 
-    pD3D11DeviceContext->DrawIndexed(numIndices, 0, 0);
+    stateCache.DrawIndexed(numIndices, 0, 0);
 }
 
 void Light::Cleanup()
@@ -141,11 +120,9 @@ void Light::Cleanup()
 
     SafeRelease(m_vertices);
     SafeRelease(m_indices);
-    SafeRelease(m_worldConstantBuffer);
     SafeRelease(lightConstantBuffer);
 
     m_vertices = nullptr;
     m_indices = nullptr;
-    m_worldConstantBuffer = nullptr;
     lightConstantBuffer = nullptr;
 }
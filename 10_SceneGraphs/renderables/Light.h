@@ -11,15 +11,14 @@ public:
     ~Light();
 
     HRESULT Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr);
-    void Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world);
+    void Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants);
     void Cleanup() override;
 
-    void Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) override;
+    void Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants) override;
 
 
 private:
     ID3D11Buffer* m_vertices = nullptr;
     ID3D11Buffer* m_indices = nullptr;
-    ID3D11Buffer* m_worldConstantBuffer = nullptr;  // The D3D11 Constant buffer used for World Transforms
     ID3D11Buffer* lightConstantBuffer = nullptr;         // the D3D11 Constant buffer used for Light information
 };
@@ -1,10 +1,6 @@
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // Output data structure
-#include <assimp/postprocess.h>     // Post processing flags
-
 #include <directxmath.h>
 
-#include <filesystem>
+#include <chrono>
 
 #include "ConstantBuffers.h"
 #include "Mesh.h"
@@ -14,13 +10,9 @@
 #include <vector>
 #include <Renderable.h>
 #include <Shader.h>
-#include <assimp\material.h>
-#include <assimp\types.h>
 #include <plog\Log.h>
 #include "utils.h"
 
-using namespace Assimp;
-
 Mesh::~Mesh()
 {
     Cleanup();
@@ -28,123 +20,80 @@ Mesh::~Mesh()
 
 HRESULT Mesh::Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr)
 {
-    D3D11_BUFFER_DESC localToWorldConstantBufferDesc = {};
-    localToWorldConstantBufferDesc.ByteWidth = sizeof(LocalToWorldConstantBuffer);
-    localToWorldConstantBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    localToWorldConstantBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    localToWorldConstantBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-    if (FAILED(pD3D11Device->CreateBuffer(&localToWorldConstantBufferDesc, nullptr, &m_worldConstantBuffer)))
-    {
-        PLOG_ERROR << "Failed to create a new constant buffer.";
-        return S_FALSE;
-    }
-
     lightConstantBuffer = lightConstantBufferPtr;
     lightConstantBuffer->AddRef();
 
     return S_OK;
 }
 
-bool Mesh::LoadFromFile(ID3D11DeviceContext* pD3D11DeviceContext, std::string path)
+/// @brief Load the mesh, blocking until it is ready to draw
+bool Mesh::LoadFromFile(ID3D11DeviceContext* pD3D11DeviceContext, std::string path, LargeMeshMode mode)
 {
-    Importer importer;
-    importer.SetExtraVerbose(true);
-
-    std::filesystem::path filepath = std::filesystem::current_path() / path;
+    LoadedMesh loaded;
+    if (!ReadMesh(path, MeshImportFormat::Normal, mode, loaded, nullptr, m_jobSystem))
+        return false;
 
-    PLOG_INFO << "Loading mesh from file: " << filepath;
+    // NB: Whenever you access a D3D resouce, like so, you need to release it when you're done with it.
+    ID3D11Device* pD3D11Device;
+    pD3D11DeviceContext->GetDevice(&pD3D11Device);
+    bool created = CreateFromLoaded(loaded, pD3D11Device);
 
-    // And have it read the given file with some example postprocessing
-    // Usually - if speed is not the most important aspect for you - you'll
-    // probably to request more postprocessing than we do in this example.
-    const aiScene* scene = importer.ReadFile(filepath.generic_string(),
-        aiProcess_Triangulate |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_SortByPType);
+    // for the reader, what happens when you comment out this line?
+    pD3D11Device->Release();
+    return created;
+}
 
-    // If the import failed, report it
-    if (nullptr == scene)
+/// @brief Load the mesh in the background: it is read on one of the loader's threads and its
+/// buffers are created when the loader next runs uploads. The placeholder, if there is one, is
+/// drawn until then. The mesh has to be owned by a shared_ptr; if it goes before the load is done,
+/// the load is dropped. The device has to outlive the loader, or the loader has to be shut down
+/// first. The source mesh's parts are merged on the loader thread, not across the job system, whose
+/// workers are for the main thread's short loops.
+void Mesh::LoadFromFileAsync(AsyncLoader& loader, ID3D11Device* pD3D11Device, std::string path, LargeMeshMode mode)
+{
+    std::weak_ptr<Mesh> weakMesh = weak_from_this();
+    loader.Submit(path, [weakMesh, pD3D11Device, path, mode]() -> AsyncLoader::UploadFunction
     {
-        PLOG_ERROR << importer.GetErrorString();
-        return false;
-    }
+        if (weakMesh.expired())
+            return []() { return true; };
 
-    // construct the buffer to contain the vertices and the index buffer from the scene
-    std::vector<ColorVertexNormal> vertexBuffer;
-    std::vector<uint16_t> indexbuffer;
-    std::vector<DirectX::XMFLOAT3> materialbuffer;
+        auto loaded = std::make_shared<LoadedMesh>();
+        if (!ReadMesh(path, MeshImportFormat::Normal, mode, *loaded, nullptr))
+            return {};
 
-    if (scene->HasMaterials())
-    {
-        auto materialCount = scene->mNumMaterials;
-        for (size_t materialIndex = 0; materialIndex < materialCount; materialIndex++)
+        return [weakMesh, pD3D11Device, loaded]()
         {
-            auto material = scene->mMaterials[materialIndex];
-            aiColor3D diffuse;
-            material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
-            materialbuffer.push_back(DirectX::XMFLOAT3{ diffuse.r, diffuse.g, diffuse.b });
-        }
-    }
+            auto mesh = weakMesh.lock();
+            return mesh == nullptr || mesh->CreateFromLoaded(*loaded, pD3D11Device);
+        };
+    });
+}
 
-    if (scene->HasMeshes())
-    {
-        int offsetVertex = 0;
-        for (size_t meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++)
-        {
-            auto mesh = scene->mMeshes[meshIndex];
-            auto vertexcount = mesh->mNumVertices;
-            for (size_t vertexIndex = 0; vertexIndex < vertexcount; vertexIndex++)
-            {
-                auto vertex = mesh->mVertices[vertexIndex];
-                auto material = materialbuffer[mesh->mMaterialIndex];
-                auto normal = mesh->mNormals[vertexIndex];
-                vertexBuffer.push_back(ColorVertexNormal
-                {
-                    vertex.x,
-                    vertex.y,
-                    vertex.z,
-                    material.x,
-                    material.y,
-                    material.z,
-                    1.0f,
-                    normal.x,
-                    normal.y,
-                    normal.z
-                });
-            }
-
-            for (size_t faceIndex = 0; faceIndex < mesh->mNumFaces; faceIndex++)
-            {
-                auto const& face = mesh->mFaces[faceIndex];
-                if (face.mNumIndices != 3)
-                {
-                    PLOG_WARNING << "Skipping as the face is not triangulated. " << face.mNumIndices << "indices per face.";
-                    continue;
-                }
-                indexbuffer.push_back(face.mIndices[0] + offsetVertex);
-                indexbuffer.push_back(face.mIndices[1] + offsetVertex);
-                indexbuffer.push_back(face.mIndices[2] + offsetVertex);
-            }
-
-            if (meshIndex < scene->mNumMeshes - 1)
-                offsetVertex += scene->mMeshes[meshIndex + 1]->mNumVertices;
-        }
-
-        auto renderable = new Renderable();
-
-        // NB: Whenever you access a D3D resouce, like so, you need to release it when you're done with it.
-        ID3D11Device* pD3D11Device;
-        pD3D11DeviceContext->GetDevice(&pD3D11Device);
-        renderable->Initialize(vertexBuffer, indexbuffer, pD3D11Device);
-
-        mRenderables.push_back(renderable);
-
-        // for the reader, what happens when you comment out this line?
-        pD3D11Device->Release();
+/// @brief Set what to draw while the mesh is loading
+/// @param bounds The placeholder's bounds, used as the mesh's until it has loaded
+void Mesh::SetPlaceholder(std::shared_ptr<Renderable> placeholder, const Bounds& bounds)
+{
+    m_placeholder = std::move(placeholder);
+    if (!m_loaded)
+        SetLocalBounds(bounds);
+}
 
+bool Mesh::CreateFromLoaded(const LoadedMesh& loaded, ID3D11Device* pD3D11Device)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    Bounds bounds;
+    if (!CreateMeshRenderables(loaded, pD3D11Device, mRenderables, bounds))
         return false;
-    }
+
+    SetLocalBounds(bounds);
+
+    m_lodErrors = CollectLodErrors(mRenderables);
+    m_loaded = true;
+
+    PLOG_INFO << "Loaded " << (loaded.cooked != nullptr ? "cooked mesh " : "") << loaded.path << ": read in " << loaded.milliseconds
+              << " ms, buffers created in " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count()
+              << " ms, with " << GetLodCount() << " levels of detail";
     return true;
 }
 
@@ -156,31 +105,51 @@ void Mesh::Cleanup()
         delete p;
 
     mRenderables.clear();
+    m_lodErrors.clear();
+    m_placeholder.reset();
+    m_loaded = false;
 
-    SafeRelease(m_worldConstantBuffer);
     SafeRelease(lightConstantBuffer);
 
-    m_worldConstantBuffer = nullptr;
     lightConstantBuffer = nullptr;
 }
 
-void Mesh::Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+void Mesh::Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
+{
+    Render(stateCache, worldConstants);
+}
+
+void Mesh::DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod)
 {
-    Render(pD3DContext, shader, world);
+    Render(stateCache, worldConstants, lod);
+}
+
+void Mesh::DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod)
+{
+    if (!m_loaded)
+    {
+        if (m_placeholder != nullptr)
+            m_placeholder->RenderInstanced(stateCache, instanceBuffer, lightConstantBuffer, instanceCount, startInstance, lod);
+        return;
+    }
+
+    for (auto* renderable : mRenderables)
+    {
+        renderable->RenderInstanced(stateCache, instanceBuffer, lightConstantBuffer, instanceCount, startInstance, lod);
+    }
 }
 
-void Mesh::Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) const
+void Mesh::Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod) const
 {
+    if (!m_loaded)
     {
-        D3D11_MAPPED_SUBRESOURCE mappedSubresource;
-        pD3D11DeviceContext->Map(m_worldConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
-        LocalToWorldConstantBuffer* constants = (LocalToWorldConstantBuffer*)(mappedSubresource.pData);
-        constants->mLocalToWorld = world;
-        pD3D11DeviceContext->Unmap(m_worldConstantBuffer, 0);
+        if (m_placeholder != nullptr)
+            m_placeholder->Render(stateCache, worldConstants, lightConstantBuffer, lod);
+        return;
     }
 
     for (auto* renderable : mRenderables)
     {
-        renderable->Render(pD3D11DeviceContext, shader, m_worldConstantBuffer, lightConstantBuffer);
+        renderable->Render(stateCache, worldConstants, lightConstantBuffer, lod);
     }
 }
@@ -1,27 +1,45 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "AsyncLoader.h"
+#include "MeshLoader.h"
 #include "RenderBase.h"
 #include "Renderable.h"
 
-class Mesh : public RenderBase
+class Mesh : public RenderBase, public std::enable_shared_from_this<Mesh>
 {
 public:
     Mesh() = default;
     ~Mesh();
 
     HRESULT Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr);
-    bool LoadFromFile(ID3D11DeviceContext* pD3D11DeviceContext, std::string path);
+    bool LoadFromFile(ID3D11DeviceContext* pD3D11DeviceContext, std::string path, LargeMeshMode mode = LargeMeshMode::LongIndices);
+    void LoadFromFileAsync(AsyncLoader& loader, ID3D11Device* pD3D11Device, std::string path, LargeMeshMode mode = LargeMeshMode::LongIndices);
+    void SetPlaceholder(std::shared_ptr<Renderable> placeholder, const Bounds& bounds);
+    void SetJobSystem(JobSystem* jobSystem) { m_jobSystem = jobSystem; }
     void Cleanup() override;
 
-    void Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) const;
+    /// @brief Has the mesh finished loading? Until it has, the placeholder is drawn instead.
+    bool IsLoaded() const { return m_loaded; }
+    size_t GetGpuBytes() const override { return SumGpuBytes(mRenderables); }
 
-    virtual void Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) override;
+    void Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod = 0) const;
+
+    virtual void Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants) override;
+    void DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod) override;
+
+    bool SupportsInstancing() const override { return true; }
+    void DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod) override;
 
 private:
+    bool CreateFromLoaded(const LoadedMesh& loaded, ID3D11Device* pD3D11Device);
+
     std::vector<Renderable*> mRenderables;
+    std::shared_ptr<Renderable> m_placeholder;  // drawn until the mesh has loaded
+    bool m_loaded = false;
+    JobSystem* m_jobSystem = nullptr;           // merges the source mesh's parts in parallel when LoadFromFile loads it, if set
 
-    ID3D11Buffer* m_worldConstantBuffer = nullptr;  // The D3D11 Constant buffer used for World Transforms
     ID3D11Buffer* lightConstantBuffer = nullptr;         // the D3D11 Constant buffer used for Light information
 };
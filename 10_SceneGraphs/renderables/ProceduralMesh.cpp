@@ -0,0 +1,65 @@
+#include "ProceduralMesh.h"
+
+#include "framework.h"
+#include "utils.h"
+
+ProceduralMesh::~ProceduralMesh()
+{
+    Cleanup();
+}
+
+/// @brief Take the primitive's geometry from the cache, building it if this is the first use
+/// @param desc What to draw; it is normalized, so out of range tessellation is clamped
+HRESULT ProceduralMesh::Initialize(PrimitiveCache& cache, const PrimitiveDesc& desc, ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr)
+{
+    Cleanup();
+
+    m_desc = NormalizePrimitiveDesc(desc);
+    Bounds bounds;
+    m_renderable = cache.Acquire(m_desc, pD3D11Device, bounds);
+    if (m_renderable == nullptr)
+    {
+        PLOG_ERROR << "Failed to get the geometry for a procedural primitive";
+        return S_FALSE;
+    }
+    SetLocalBounds(bounds);
+
+    std::vector<Renderable*> renderables = { m_renderable.get() };
+    m_lodErrors = CollectLodErrors(renderables);
+
+    lightConstantBuffer = lightConstantBufferPtr;
+    lightConstantBuffer->AddRef();
+
+    return S_OK;
+}
+
+void ProceduralMesh::Cleanup()
+{
+    m_renderable.reset();
+    m_lodErrors.clear();
+
+    SafeRelease(lightConstantBuffer);
+    lightConstantBuffer = nullptr;
+}
+
+void ProceduralMesh::Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
+{
+    Render(stateCache, worldConstants);
+}
+
+void ProceduralMesh::DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod)
+{
+    Render(stateCache, worldConstants, lod);
+}
+
+void ProceduralMesh::DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod)
+{
+    if (m_renderable != nullptr)
+        m_renderable->RenderInstanced(stateCache, instanceBuffer, lightConstantBuffer, instanceCount, startInstance, lod);
+}
+
+void ProceduralMesh::Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod) const
+{
+    if (m_renderable != nullptr)
+        m_renderable->Render(stateCache, worldConstants, lightConstantBuffer, lod);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <memory>
+#include <d3d11.h>
+
+#include "RenderBase.h"
+#include "PrimitiveCache.h"
+
+/// @brief A procedural primitive, drawn lit like a loaded mesh. The geometry comes from a
+/// PrimitiveCache, so every ProceduralMesh with the same PrimitiveDesc draws from the same buffers.
+class ProceduralMesh : public RenderBase
+{
+public:
+    ProceduralMesh() = default;
+    ~ProceduralMesh();
+
+    HRESULT Initialize(PrimitiveCache& cache, const PrimitiveDesc& desc, ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr);
+    void Cleanup() override;
+
+    void Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod = 0) const;
+
+    void Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants) override;
+    void DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod) override;
+
+    bool SupportsInstancing() const override { return true; }
+    void DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod) override;
+
+    const PrimitiveDesc& GetDesc() const { return m_desc; }
+
+private:
+    PrimitiveDesc m_desc;
+    std::shared_ptr<Renderable> m_renderable;
+
+    ID3D11Buffer* lightConstantBuffer = nullptr;         // the D3D11 Constant buffer used for Light information
+};
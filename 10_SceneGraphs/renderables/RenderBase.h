@@ -1,19 +1,71 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include <Shader.h>
 #include <DirectXMath.h>
 
+#include "Culling.h"
+#include "Material.h"
+#include "StateCache.h"
+
 class RenderBase
 {
 public:
     RenderBase();
     ~RenderBase();
 
-    virtual void Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) = 0;
+    /// @brief Draw the geometry. The shader, and the material if there is one, are bound by the caller.
+    /// Everything that gets bound goes through the state cache.
+    /// @param worldConstants Slice of the frame's constant buffer ring holding the local to world matrix
+    virtual void Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants) = 0;
+
+    /// @brief Draw one level of detail, 0 being the full geometry. Geometry without levels of
+    /// detail draws itself in full.
+    virtual void DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod) { Draw(stateCache, worldConstants); }
+
+    /// @brief Can the geometry be drawn with DrawInstanced?
+    virtual bool SupportsInstancing() const { return false; }
+
+    /// @brief Draw several copies of the geometry in one call, with the instanced variant of the
+    /// shader bound by the caller.
+    /// @param instanceBuffer Vertex buffer holding a local to world matrix per instance
+    /// @param instanceCount How many copies to draw
+    /// @param startInstance First matrix in the instance buffer to use
+    /// @param lod The level of detail every copy is drawn with
+    virtual void DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod) {}
+
+    /// @brief The material to bind before drawing, or nullptr if the geometry doesn't use one
+    virtual Material* GetMaterial() { return nullptr; }
+
+    /// @brief The GPU memory the geometry's own buffers take, or 0 if it hasn't loaded yet
+    virtual size_t GetGpuBytes() const { return 0; }
 
     virtual void Cleanup() {};
 
+    /// @brief Bounds of the geometry, in its own local space
+    const Bounds& GetLocalBounds() const { return m_localBounds; }
+
+    /// @brief Changes whenever the local bounds do, such as when a mesh replaces its placeholder
+    uint64_t GetBoundsVersion() const { return m_boundsVersion; }
+
+    /// @brief How many levels of detail the geometry has, including the full one
+    uint32_t GetLodCount() const { return m_lodErrors.empty() ? 1 : static_cast<uint32_t>(m_lodErrors.size()); }
+
+    /// @brief How far each level of detail strays from the full geometry, in local space, finest
+    /// first; nullptr if there is only the one level
+    const float* GetLodErrors() const { return m_lodErrors.empty() ? nullptr : m_lodErrors.data(); }
+
 protected:
+    void SetLocalBounds(const Bounds& bounds)
+    {
+        m_localBounds = bounds;
+        m_boundsVersion++;
+    }
+
     ID3D11Buffer* worldConstantBuffer = nullptr;
+    Bounds m_localBounds;
+    uint64_t m_boundsVersion = 0;
+    std::vector<float> m_lodErrors;
 };
\ No newline at end of file
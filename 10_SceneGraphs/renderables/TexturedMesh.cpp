@@ -1,12 +1,8 @@
 #include "TexturedMesh.h"
 
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // Output data structure
-#include <assimp/postprocess.h>     // Post processing flags
-
 #include <directxmath.h>
 
-#include <filesystem>
+#include <chrono>
 
 #include "ResourceManager.h"
 #include "Material.h"
@@ -15,184 +11,216 @@
 #include "ConstantBuffers.h"
 
 #include "utils.h"
-#include <assimp\types.h>
 #include <d3d11.h>
 #include <cstdint>
 #include <string>
 #include <vector>
 #include <Renderable.h>
 #include <Shader.h>
-#include <assimp\material.h>
 #include <plog\Log.h>
 
-using namespace Assimp;
-
 HRESULT TexturedMesh::Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr)
 {
-    D3D11_BUFFER_DESC localToWorldConstantBufferDesc = {};
-    localToWorldConstantBufferDesc.ByteWidth = sizeof(LocalToWorldConstantBuffer);
-    localToWorldConstantBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    localToWorldConstantBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    localToWorldConstantBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-    if (FAILED(pD3D11Device->CreateBuffer(&localToWorldConstantBufferDesc, nullptr, &m_worldConstantBuffer)))
-    {
-        PLOG_ERROR << "Failed to create a new constant buffer.";
-        return S_FALSE;
-    }
-
     lightConstantBuffer = lightConstantBufferPtr;
     lightConstantBuffer->AddRef();
 
     return S_OK;
 }
-bool TexturedMesh::LoadFromFile(ID3D11DeviceContext* pDeviceContext, std::string path)
+
+/// @brief Load the mesh and its textures, blocking until they are ready to draw
+bool TexturedMesh::LoadFromFile(ID3D11DeviceContext* pDeviceContext, std::string path, LargeMeshMode mode)
 {
+    LoadedMesh loaded;
+    if (!ReadMesh(path, MeshImportFormat::NormalUV, mode, loaded, nullptr, m_jobSystem))
+        return false;
+
+    // NB: Whenever you access a D3D resouce, like so, you need to release it when you're done with it.
     ID3D11Device* pDevice = nullptr;
     pDeviceContext->GetDevice(&pDevice);
-    auto refCount = pDevice->AddRef();
+    bool created = CreateFromLoaded(loaded, pDevice);
     pDevice->Release();
+    return created;
+}
+
+/// @brief Load the mesh and its textures in the background: they are read on one of the loader's
+/// threads, and the buffers and textures are created when the loader next runs uploads. The
+/// placeholder, if there is one, is drawn until then. The mesh has to be owned by a shared_ptr; if
+/// it goes before the load is done, the load is dropped. The device has to outlive the loader, or
+/// the loader has to be shut down first. The source mesh's parts are merged on the loader thread,
+/// not across the job system, whose workers are for the main thread's short loops. With an
+/// image pool, the textures are decoded into its memory, and the load waits for room in it for all
+/// of them; each texture's memory goes back once it is created.
+void TexturedMesh::LoadFromFileAsync(AsyncLoader& loader, ID3D11Device* pD3D11Device, std::string path, LargeMeshMode mode)
+{
+    std::weak_ptr<TexturedMesh> weakMesh = weak_from_this();
+    ImagePool* imagePool = m_imagePool;
+    loader.Submit(path, [weakMesh, pD3D11Device, path, mode, imagePool]() -> AsyncLoader::UploadFunction
+    {
+        if (weakMesh.expired())
+            return []() { return true; };
 
-    PLOG_INFO << "Refcount at the start in Textured Mesh of pDevice: " << refCount;
+        auto loaded = std::make_shared<LoadedMesh>();
+        if (!ReadMesh(path, MeshImportFormat::NormalUV, mode, *loaded, imagePool))
+            return {};
 
-    Importer importer;
-    importer.SetExtraVerbose(true);
+        return [weakMesh, pD3D11Device, loaded]()
+        {
+            auto mesh = weakMesh.lock();
+            return mesh == nullptr || mesh->CreateFromLoaded(*loaded, pD3D11Device);
+        };
+    });
+}
 
-    std::filesystem::path filepath = std::filesystem::current_path() / path;
+/// @brief Set what to draw while the mesh is loading
+/// @param bounds The placeholder's bounds, used as the mesh's until it has loaded
+void TexturedMesh::SetPlaceholder(std::shared_ptr<Renderable> placeholder, const Bounds& bounds)
+{
+    m_placeholder = std::move(placeholder);
+    if (!m_loaded)
+        SetLocalBounds(bounds);
+}
 
-    PLOG_INFO << "Loading Textured Mesh from file: " << filepath;
+bool TexturedMesh::CreateFromLoaded(const LoadedMesh& loaded, ID3D11Device* pDevice)
+{
+    auto start = std::chrono::high_resolution_clock::now();
 
-    const aiScene* scene = importer.ReadFile(filepath.generic_string(),
-                                            aiProcess_Triangulate |
-                                            aiProcess_JoinIdenticalVertices |
-                                            aiProcess_SortByPType);
+    std::vector<uint32_t> textureSlices;
+    if (!CreateTextures(loaded, pDevice, textureSlices))
+    {
+        PLOG_ERROR << "Failed to create the textures for " << loaded.path;
+        ReleaseTextures();
+        return false;
+    }
 
-    if (nullptr == scene)
+    Bounds bounds;
+    if (!CreateMeshRenderables(loaded, pDevice, mRenderables, bounds, textureSlices))
     {
-        PLOG_ERROR << importer.GetErrorString();
+        ReleaseTextures();
         return false;
     }
+    SetLocalBounds(bounds);
 
-    std::vector<ColorVertexNormalUV> vertexBuffer;
-    std::vector<uint16_t> indexBuffer;
-    std::vector<DirectX::XMFLOAT3> materialbuffer;
+    m_lodErrors = CollectLodErrors(mRenderables);
+    m_loaded = true;
 
-    if (scene->HasMaterials())
+    uint32_t cookedTextures = 0;
+    for (const auto& texture : loaded.textures)
     {
-        auto materialCount = scene->mNumMaterials;
-        if (materialCount > 1)
-        {
-            PLOG_ERROR << "Currently only support one texture per material! Found " << materialCount;
-            return false;
-        }
+        if (texture->texture.cooked != nullptr)
+            cookedTextures++;
+    }
 
-        // Grab the diffuse values
-        for (size_t materialDiffuseIndex = 0; materialDiffuseIndex < materialCount; materialDiffuseIndex++)
-        {
-            auto material = scene->mMaterials[materialDiffuseIndex];
-            aiColor3D diffuse;
-            material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
-            materialbuffer.push_back(DirectX::XMFLOAT3{ diffuse.r, diffuse.g, diffuse.b });
-        }
+    PLOG_INFO << "Loaded " << (loaded.cooked != nullptr ? "cooked mesh " : "") << loaded.path << " and " << loaded.textures.size() << " textures ("
+              << cookedTextures << " cooked): read in " << loaded.milliseconds << " ms, buffers and textures created in "
+              << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count()
+              << " ms, with " << GetLodCount() << " levels of detail";
+    return true;
+}
 
-        // And now a texture, if one is associated
-        for (size_t materialIndex = 0; materialIndex < materialCount; materialIndex++)
+/// @brief Give each texture a material: the resource manager's copy if there is a manager, which
+/// any other mesh using the same image shares, in a texture array that other images of its shape
+/// share too, or one of its own if not
+/// @param textureSlices Set to the texture array slice of each of the mesh's materials, for its
+/// submesh constants
+bool TexturedMesh::CreateTextures(const LoadedMesh& loaded, ID3D11Device* pDevice, std::vector<uint32_t>& textureSlices)
+{
+    for (const auto& texture : loaded.textures)
+    {
+        m_materials.push_back(std::make_unique<Material>());
+        if (m_resources == nullptr)
         {
-            auto material = scene->mMaterials[materialIndex];
-            aiString texturePath;
-            auto foundTexture = material->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath);
-
-            if (!m_Material.LoadImageFromFile(pDevice, pDeviceContext, texturePath.C_Str()))
-            {
-                PLOG_ERROR << "Failed to load texture from file: " << texturePath.C_Str();
+            if (!m_materials.back()->CreateFromTexture(pDevice, texture->texture))
                 return false;
-            }
+            continue;
         }
 
-        if (scene->HasMeshes())
-        {
-            int offsetVertex = 0;
-            for (size_t meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++)
-            {
-                auto mesh = scene->mMeshes[meshIndex];
-                auto vertexcount = mesh->mNumVertices;
-                for (size_t vertexIndex = 0; vertexIndex < vertexcount; vertexIndex++)
-                {
-                    auto vertex = mesh->mVertices[vertexIndex];
-                    auto normal = mesh->mNormals[vertexIndex];
-                    auto uv = mesh->mTextureCoords[0][vertexIndex];
-                    auto materialRef = materialbuffer[mesh->mMaterialIndex];
-                    vertexBuffer.push_back(ColorVertexNormalUV{
-                        vertex.x,
-                        vertex.y,
-                        vertex.z,
-                        materialRef.x,
-                        materialRef.y,
-                        materialRef.z,
-                        1.0f,
-                        normal.x,
-                        normal.y,
-                        normal.z,
-                        uv.x,
-                        uv.y });
-                }
-
-                for (size_t faceIndex = 0; faceIndex < mesh->mNumFaces; faceIndex++)
-                {
-                    auto const& face = mesh->mFaces[faceIndex];
-                    if (face.mNumIndices != 3)
-                    {
-                        PLOG_WARNING << "Skipping as the face is not triangulated. " << face.mNumIndices << "indices per face.";
-                        continue;
-                    }
-
-                    indexBuffer.push_back(face.mIndices[0] + offsetVertex);
-                    indexBuffer.push_back(face.mIndices[1] + offsetVertex);
-                    indexBuffer.push_back(face.mIndices[2] + offsetVertex);
-                }
-
-                if (meshIndex < scene->mNumMeshes - 1)
-                    offsetVertex += scene->mMeshes[meshIndex + 1]->mNumVertices;
-            }
-
-            // NB: Whenever you access a D3D resouce, like so, you need to release it when you're done with it.
-            auto renderable = new Renderable();
-            renderable->Initialize(vertexBuffer, indexBuffer, pDevice);
-
-            mRenderables.push_back(renderable);
-
-            // for the reader, what happens when you comment out this line?
-            // pDevice->Release();
-        }
+        m_textures.push_back(m_resources->AcquireTexture(texture->path, &texture->texture));
+        if (!m_textures.back().IsValid())
+            return false;
+        m_materials.back()->SetTexture(m_resources->GetTextureArrays(), m_resources->GetTextureSlot(m_textures.back()));
     }
 
-    refCount = pDevice->AddRef();
-    pDevice->Release();
+    m_materialTextures = loaded.materialTextures;
+    textureSlices.assign(m_materialTextures.size(), 0);
+    for (size_t material = 0; material < m_materialTextures.size(); material++)
+    {
+        uint32_t texture = m_materialTextures[material];
+        if (texture != LoadedMesh::c_noTexture && m_resources != nullptr)
+            textureSlices[material] = m_resources->GetTextureSlot(m_textures[texture]).slice;
+    }
+    return true;
+}
 
-    PLOG_INFO << "Refcount at the end in Textured Mesh of pDevice: " << refCount;
+void TexturedMesh::ReleaseTextures()
+{
+    for (auto& material : m_materials)
+        material->Cleanup();
+    m_materials.clear();
+    m_materialTextures.clear();
 
-    return true;
+    if (m_resources != nullptr)
+    {
+        for (auto texture : m_textures)
+            m_resources->Release(texture);
+    }
+    m_textures.clear();
 }
 
-void TexturedMesh::Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+/// @brief The material a submesh is drawn with; the first if its material has no texture
+Material* TexturedMesh::GetSubmeshMaterial(const Renderable& renderable, uint32_t submesh) const
 {
-    Render(pD3DContext, shader, world);
+    uint32_t material = renderable.GetSubmeshMaterial(submesh);
+    uint32_t texture = material < m_materialTextures.size() ? m_materialTextures[material] : LoadedMesh::c_noTexture;
+    return m_materials[texture < m_materials.size() ? texture : 0].get();
 }
 
-void TexturedMesh::Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world)
+void TexturedMesh::Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants)
 {
+    Render(stateCache, worldConstants);
+}
+
+void TexturedMesh::DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod)
+{
+    Render(stateCache, worldConstants, lod);
+}
+
+void TexturedMesh::DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod)
+{
+    if (!m_loaded)
     {
-        D3D11_MAPPED_SUBRESOURCE mappedSubresource;
-        pD3D11DeviceContext->Map(m_worldConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
-        LocalToWorldConstantBuffer* constants = (LocalToWorldConstantBuffer*)(mappedSubresource.pData);
-        constants->mLocalToWorld = world;
-        pD3D11DeviceContext->Unmap(m_worldConstantBuffer, 0);
+        if (m_placeholder != nullptr)
+            m_placeholder->RenderInstanced(stateCache, instanceBuffer, lightConstantBuffer, instanceCount, startInstance, lod);
+        return;
     }
 
-    m_Material.UseMaterial(pD3D11DeviceContext);
+    // The renderable's buffers stay bound across its submeshes; only the texture changes, and not
+    // at all between materials whose textures share an array
     for (auto* renderable : mRenderables)
     {
-        renderable->Render(pD3D11DeviceContext, shader, m_worldConstantBuffer, lightConstantBuffer);
+        for (uint32_t submesh = 0; submesh < renderable->GetSubmeshCount(); submesh++)
+        {
+            GetSubmeshMaterial(*renderable, submesh)->UseMaterial(stateCache);
+            renderable->RenderSubmeshInstanced(stateCache, submesh, instanceBuffer, lightConstantBuffer, instanceCount, startInstance, lod);
+        }
+    }
+}
+
+void TexturedMesh::Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod)
+{
+    if (!m_loaded)
+    {
+        if (m_placeholder != nullptr)
+            m_placeholder->Render(stateCache, worldConstants, lightConstantBuffer, lod);
+        return;
+    }
+
+    for (auto* renderable : mRenderables)
+    {
+        for (uint32_t submesh = 0; submesh < renderable->GetSubmeshCount(); submesh++)
+        {
+            GetSubmeshMaterial(*renderable, submesh)->UseMaterial(stateCache);
+            renderable->RenderSubmesh(stateCache, submesh, worldConstants, lightConstantBuffer, lod);
+        }
     }
 }
 
@@ -204,13 +232,15 @@ void TexturedMesh::Cleanup()
         delete p;
 
     mRenderables.clear();
+    m_lodErrors.clear();
+    m_placeholder.reset();
+    m_loaded = false;
 
-    m_Material.Cleanup();
+    ReleaseTextures();
+    m_resources = nullptr;
 
-    SafeRelease(m_worldConstantBuffer);
     SafeRelease(lightConstantBuffer);
 
-    m_worldConstantBuffer = nullptr;
     lightConstantBuffer = nullptr;
 
 }
@@ -1,13 +1,18 @@
 #pragma once
+#include <memory>
 #include <d3d11.h>
 
+#include "AsyncLoader.h"
+#include "MeshLoader.h"
 #include "RenderBase.h"
 #include "Renderable.h"
 #include "Material.h"
+#include "ResourceCache.h"
 #include "shader.h"
 
+class ResourceManager;
 
-class TexturedMesh : public RenderBase
+class TexturedMesh : public RenderBase, public std::enable_shared_from_this<TexturedMesh>
 {
 public:
     TexturedMesh() = default;
@@ -18,16 +23,45 @@ public:
 
     HRESULT Initialize(ID3D11Device* pD3D11Device, ID3D11Buffer* lightConstantBufferPtr);
 
-    bool LoadFromFile(ID3D11DeviceContext* pD3D11DeviceContext, std::string path);
-    void Render(ID3D11DeviceContext* pD3D11DeviceContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world);
+    bool LoadFromFile(ID3D11DeviceContext* pD3D11DeviceContext, std::string path, LargeMeshMode mode = LargeMeshMode::LongIndices);
+    void LoadFromFileAsync(AsyncLoader& loader, ID3D11Device* pD3D11Device, std::string path, LargeMeshMode mode = LargeMeshMode::LongIndices);
+    void SetPlaceholder(std::shared_ptr<Renderable> placeholder, const Bounds& bounds);
+    void SetResourceManager(ResourceManager* resources) { m_resources = resources; }
+    void SetImagePool(ImagePool* imagePool) { m_imagePool = imagePool; }
+    void SetJobSystem(JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+
+    /// @brief Has the mesh and its textures finished loading? Until they have, the placeholder is drawn instead.
+    bool IsLoaded() const { return m_loaded; }
+    size_t GetGpuBytes() const override { return SumGpuBytes(mRenderables); }
+
+    void Render(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod = 0);
     void Cleanup() override;
 
-    void Draw(ID3D11DeviceContext* pD3DContext, std::shared_ptr<Shader> shader, DirectX::XMMATRIX world) override;
+    void Draw(StateCache& stateCache, const ConstantBufferSlice& worldConstants) override;
+    void DrawLod(StateCache& stateCache, const ConstantBufferSlice& worldConstants, uint32_t lod) override;
+
+    bool SupportsInstancing() const override { return true; }
+    void DrawInstanced(StateCache& stateCache, ID3D11Buffer* instanceBuffer, uint32_t instanceCount, uint32_t startInstance, uint32_t lod) override;
+
+    /// @brief The material of the first texture, which the render queue sorts the mesh by; the others
+    /// are bound between submeshes. None until the mesh has loaded.
+    Material* GetMaterial() override { return m_materials.empty() ? nullptr : m_materials[0].get(); }
 
 private:
+    bool CreateFromLoaded(const LoadedMesh& loaded, ID3D11Device* pD3D11Device);
+    bool CreateTextures(const LoadedMesh& loaded, ID3D11Device* pD3D11Device, std::vector<uint32_t>& textureSlices);
+    void ReleaseTextures();
+    Material* GetSubmeshMaterial(const Renderable& renderable, uint32_t submesh) const;
+
     std::vector<Renderable*> mRenderables;
+    std::shared_ptr<Renderable> m_placeholder;  // drawn until the mesh has loaded
+    bool m_loaded = false;
 
-    Material m_Material;
-    ID3D11Buffer* m_worldConstantBuffer = nullptr;  // The D3D11 Constant buffer used for World Transforms
+    std::vector<std::unique_ptr<Material>> m_materials;  // one per texture, as LoadedMesh::textures
+    std::vector<uint32_t> m_materialTextures;   // the texture of each of the mesh's materials, as LoadedMesh::materialTextures
+    ResourceManager* m_resources = nullptr;     // shares the textures with other meshes, if set
+    ImagePool* m_imagePool = nullptr;           // staging memory for the texture when it loads in the background, if set
+    JobSystem* m_jobSystem = nullptr;           // merges the source mesh's parts in parallel when LoadFromFile loads it, if set
+    std::vector<ResourceHandle> m_textures;
     ID3D11Buffer* lightConstantBuffer = nullptr;         // the D3D11 Constant buffer used for Light information
 };
@@ -0,0 +1,277 @@
+#include "AssetLoadingBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+#include "AsyncLoader.h"
+#include "ImageDecoder.h"
+#include "MeshImport.h"
+#include "ProceduralGeometry.h"
+
+namespace
+{
+    constexpr size_t c_assetCount = 24;
+    constexpr uint32_t c_textureSize = 512;
+    constexpr double c_uploadBudgetMilliseconds = 2.0;
+
+    // Stands in for the rest of a frame, while the loader threads carry on
+    constexpr auto c_frameRest = std::chrono::milliseconds(1);
+
+    /// @brief What an asset is loaded from: a mesh as an importer would hand it over, and an
+    /// image file in memory
+    struct SourceAsset
+    {
+        std::vector<VertexNormalUV> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+        std::vector<ImportedMaterial> materials;
+        std::vector<uint8_t> image;
+    };
+
+    struct LoadedAsset
+    {
+        ImportedMesh mesh;
+        DecodedImage image;
+    };
+
+    void AppendLittleEndian(std::vector<uint8_t>& bytes, uint32_t value, size_t size)
+    {
+        for (size_t byte = 0; byte < size; byte++)
+        {
+            bytes.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+        }
+    }
+
+    /// @brief A 24 bit BMP of a checkerboard, with the colours varied by seed
+    std::vector<uint8_t> MakeBitmap(uint32_t size, uint32_t seed)
+    {
+        const uint32_t rowBytes = (size * 3 + 3) & ~3u;
+        const uint32_t pixelBytes = rowBytes * size;
+
+        std::vector<uint8_t> bytes;
+        bytes.reserve(54 + pixelBytes);
+        bytes.push_back('B');
+        bytes.push_back('M');
+        AppendLittleEndian(bytes, 54 + pixelBytes, 4);  // file size
+        AppendLittleEndian(bytes, 0, 4);                // reserved
+        AppendLittleEndian(bytes, 54, 4);               // offset of the pixels
+        AppendLittleEndian(bytes, 40, 4);               // BITMAPINFOHEADER
+        AppendLittleEndian(bytes, size, 4);
+        AppendLittleEndian(bytes, size, 4);             // positive height: bottom row first
+        AppendLittleEndian(bytes, 1, 2);                // planes
+        AppendLittleEndian(bytes, 24, 2);               // bits per pixel
+        AppendLittleEndian(bytes, 0, 4);                // BI_RGB
+        AppendLittleEndian(bytes, pixelBytes, 4);
+        AppendLittleEndian(bytes, 2835, 4);             // 72 DPI
+        AppendLittleEndian(bytes, 2835, 4);
+        AppendLittleEndian(bytes, 0, 4);                // palette size
+        AppendLittleEndian(bytes, 0, 4);
+
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                bool light = ((x / 32) + (y / 32)) % 2 == 0;
+                bytes.push_back(static_cast<uint8_t>(light ? 200 : 40 + seed * 7));
+                bytes.push_back(static_cast<uint8_t>(light ? 180 : 60 + seed * 3));
+                bytes.push_back(static_cast<uint8_t>(light ? 160 + seed : 80));
+            }
+            bytes.resize(bytes.size() + rowBytes - size * 3, 0);
+        }
+        return bytes;
+    }
+
+    /// @brief A sphere with its northern and southern halves in different materials, and a texture
+    SourceAsset MakeSourceAsset(uint32_t seed)
+    {
+        uint32_t slices = 96 + 16 * (seed % 5);
+        PrimitiveMesh sphere = GeneratePrimitive(MakeSphereDesc(1.0f, slices, slices / 2));
+
+        SourceAsset asset;
+        asset.vertices = std::move(sphere.vertices);
+        asset.indices = std::move(sphere.indices);
+        for (size_t corner = 0; corner < asset.indices.size(); corner += 3)
+        {
+            asset.triangleMaterials.push_back(asset.vertices[asset.indices[corner]].y >= 0.0f ? 0 : 1);
+        }
+
+        ImportedMaterial north;
+        north.diffuse[0] = 0.9f;
+        ImportedMaterial south;
+        south.diffuse[2] = 0.9f;
+        asset.materials = { north, south };
+
+        asset.image = MakeBitmap(c_textureSize, seed);
+        return asset;
+    }
+
+    /// @brief Everything a loader thread does for an asset
+    bool LoadAsset(const SourceAsset& source, LoadedAsset& loaded)
+    {
+        loaded.mesh.materials = source.materials;
+        PrepareImportedMesh(source.vertices, source.indices, source.triangleMaterials, LargeMeshMode::LongIndices, loaded.mesh);
+
+        std::string error;
+        return DecodeImageMemory(source.image.data(), source.image.size(), loaded.image, error);
+    }
+
+    uint64_t HashBytes(uint64_t hash, const uint8_t* bytes, size_t size)
+    {
+        for (size_t index = 0; index < size; index++)
+        {
+            hash = (hash ^ bytes[index]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// @brief Stand in for creating the buffers and texture: copy every byte into staging memory,
+    /// as CreateBuffer and CreateTexture2D do with their initial data
+    /// @return A hash of what was uploaded
+    uint64_t UploadAsset(const LoadedAsset& loaded, std::vector<uint8_t>& staging)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto upload = [&](const std::vector<uint8_t>& bytes)
+        {
+            staging.assign(bytes.begin(), bytes.end());
+            hash = HashBytes(hash, staging.data(), std::min<size_t>(staging.size(), 4096));
+            hash ^= staging.size();
+        };
+
+        upload(loaded.mesh.renderable.vertices);
+        upload(loaded.mesh.renderable.indices);
+        upload(loaded.image.pixels);
+        return hash;
+    }
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    AssetLoadingRun RunAsync(const std::vector<SourceAsset>& sources, unsigned workerCount, const std::vector<uint64_t>& serialHashes)
+    {
+        AssetLoadingRun run;
+        run.workerCount = workerCount;
+
+        std::vector<uint64_t> hashes(sources.size(), 0);
+        std::vector<uint8_t> staging;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        AsyncLoader loader(workerCount);
+        for (size_t asset = 0; asset < sources.size(); asset++)
+        {
+            loader.Submit("asset " + std::to_string(asset), [&sources, &hashes, &staging, asset]() -> AsyncLoader::UploadFunction
+            {
+                auto loaded = std::make_shared<LoadedAsset>();
+                if (!LoadAsset(sources[asset], *loaded))
+                    return {};
+
+                return [&hashes, &staging, asset, loaded]()
+                {
+                    hashes[asset] = UploadAsset(*loaded, staging);
+                    return true;
+                };
+            });
+        }
+
+        while (!loader.IsIdle())
+        {
+            loader.ProcessUploads(c_uploadBudgetMilliseconds);
+            run.worstFrameMilliseconds = std::max(run.worstFrameMilliseconds, loader.GetStats().uploadMillisecondsLastFrame);
+            run.frames++;
+            std::this_thread::sleep_for(c_frameRest);
+        }
+        run.milliseconds = MillisecondsSince(start);
+        run.matchesSerial = hashes == serialHashes;
+        return run;
+    }
+
+    /// @brief Submit a few good assets and one whose image is corrupt, and check only that one fails
+    bool CheckFailures(const std::vector<SourceAsset>& sources)
+    {
+        SourceAsset corrupt = sources[0];
+        corrupt.image.resize(corrupt.image.size() / 2);
+        corrupt.image[0] = 'X';
+
+        const std::vector<const SourceAsset*> assets = { &sources[0], &corrupt, &sources[1] };
+        uint32_t uploaded = 0;
+
+        AsyncLoader loader(2);
+        for (const auto* source : assets)
+        {
+            loader.Submit(source == &corrupt ? "corrupt" : "good", [source, &uploaded]() -> AsyncLoader::UploadFunction
+            {
+                auto loaded = std::make_shared<LoadedAsset>();
+                if (!LoadAsset(*source, *loaded))
+                    return {};
+                return [&uploaded]() { uploaded++; return true; };
+            });
+        }
+
+        loader.WaitForLoads();
+        while (!loader.IsIdle())
+        {
+            loader.ProcessUploads(c_uploadBudgetMilliseconds);
+        }
+
+        auto stats = loader.GetStats();
+        return uploaded == 2 && stats.completed == 2 && stats.failed == 1 && stats.lastFailed == "corrupt";
+    }
+}
+
+AssetLoadingBenchmarkResult RunAssetLoadingBenchmark()
+{
+    AssetLoadingBenchmarkResult result;
+    result.budgetMilliseconds = c_uploadBudgetMilliseconds;
+    result.textureSize = c_textureSize;
+
+    std::vector<SourceAsset> sources;
+    for (uint32_t seed = 0; seed < c_assetCount; seed++)
+    {
+        sources.push_back(MakeSourceAsset(seed));
+        result.triangleCount += sources.back().indices.size() / 3;
+        result.texelCount += static_cast<size_t>(c_textureSize) * c_textureSize;
+    }
+    result.assetCount = sources.size();
+
+    // A synchronous load does it all on the main thread, in one frame
+    std::vector<uint64_t> serialHashes;
+    std::vector<uint8_t> staging;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& source : sources)
+    {
+        LoadedAsset loaded;
+        LoadAsset(source, loaded);
+        serialHashes.push_back(UploadAsset(loaded, staging));
+    }
+    result.serialMilliseconds = MillisecondsSince(start);
+
+    unsigned maxWorkers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    for (unsigned workers = 1; workers <= maxWorkers; workers *= 2)
+    {
+        result.runs.push_back(RunAsync(sources, workers, serialHashes));
+    }
+    if (result.runs.back().workerCount != maxWorkers)
+        result.runs.push_back(RunAsync(sources, maxWorkers, serialHashes));
+
+    result.failuresReported = CheckFailures(sources);
+
+    return result;
+}
+
+void ReportAssetLoadingBenchmark(const AssetLoadingBenchmarkResult& result, std::ostream& out)
+{
+    out << "Asset loading benchmark: " << result.assetCount << " meshes (" << result.triangleCount << " triangles) and "
+        << result.assetCount << " " << result.textureSize << "x" << result.textureSize << " textures\n";
+    out << "  Serial: " << result.serialMilliseconds << " ms, all of it in one frame\n";
+    for (const auto& run : result.runs)
+    {
+        out << "  " << run.workerCount << " loader threads: " << run.milliseconds << " ms over " << run.frames << " frames, at most "
+            << run.worstFrameMilliseconds << " ms of uploads in a frame (budget " << result.budgetMilliseconds << " ms)"
+            << (run.matchesSerial ? "" : ", does not match the serial load!") << "\n";
+    }
+    out << "  A corrupt asset " << (result.failuresReported ? "failed on its own" : "was not reported correctly!") << "\n";
+}
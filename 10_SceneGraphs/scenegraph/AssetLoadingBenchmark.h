@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/// @brief Loading the same assets through an AsyncLoader with some number of loader threads
+struct AssetLoadingRun
+{
+    unsigned workerCount = 0;
+    double milliseconds = 0.0;          // from the first submit to the last upload
+    uint32_t frames = 0;                // frames it took for everything to be uploaded
+    double worstFrameMilliseconds = 0.0;// most main thread time spent uploading in any one frame
+    bool matchesSerial = false;         // every asset uploaded the same bytes as the serial load
+};
+
+/// @brief The result of loading a set of meshes and textures serially and in the background
+struct AssetLoadingBenchmarkResult
+{
+    size_t assetCount = 0;
+    size_t triangleCount = 0;           // over every asset
+    size_t texelCount = 0;              // over every asset
+    uint32_t textureSize = 0;           // each texture is this many texels on a side
+    double budgetMilliseconds = 0.0;    // upload time allowed per frame
+    double serialMilliseconds = 0.0;    // loading and uploading everything on the main thread, all in one frame
+    std::vector<AssetLoadingRun> runs;
+    bool failuresReported = false;      // an asset that couldn't be decoded failed on its own, without holding up the rest
+};
+
+/// @brief Load a batch of assets the way the renderer does: each mesh is split by material,
+/// optimized, given levels of detail and packed, and each texture is decoded from an in memory
+/// BMP. First everything is done on the calling thread, as a synchronous load would, then through
+/// an AsyncLoader with more and more loader threads, running uploads under the per-frame budget.
+/// Uploads copy the prepared bytes as CreateBuffer would, so nothing touches the GPU. The meshes
+/// are generated rather than imported, so assimp isn't part of what is timed.
+AssetLoadingBenchmarkResult RunAssetLoadingBenchmark();
+
+/// @brief Write the serial load, then a line for each number of loader threads
+void ReportAssetLoadingBenchmark(const AssetLoadingBenchmarkResult& result, std::ostream& out);
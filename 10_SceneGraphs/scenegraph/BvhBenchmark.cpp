@@ -0,0 +1,128 @@
+#include "BvhBenchmark.h"
+
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <DirectXMath.h>
+
+#include "Bvh.h"
+#include "Culling.h"
+#include "mathutils.h"
+
+namespace
+{
+    constexpr int c_iterations = 5;
+    constexpr size_t c_movingPrimitiveStride = 20;
+    constexpr int c_rayCount = 10000;
+
+    // Keep the density of the scene the same whatever the primitive count
+    constexpr float c_primitivesPerUnitCubed = 0.125f;
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+std::vector<BvhBenchmarkResult> RunBvhBenchmark()
+{
+    std::vector<BvhBenchmarkResult> results;
+
+    // Same projection as the OrbitCamera, looking down +Z from the middle of the world
+    DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(
+        DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+        DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+        DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(degreesToRadians(78), 16.0f / 9.0f, 0.01f, 100.0f);
+    Frustum frustum = ExtractFrustum(view * projection);
+
+    for (size_t primitiveCount : { 10000, 100000, 1000000 })
+    {
+        BvhBenchmarkResult result;
+        result.primitiveCount = primitiveCount;
+
+        // Fixed seed, so every run uses the same scene
+        float worldSize = cbrtf(static_cast<float>(primitiveCount) / c_primitivesPerUnitCubed);
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> position(-0.5f * worldSize, 0.5f * worldSize);
+        std::uniform_real_distribution<float> size(0.1f, 1.0f);
+
+        std::vector<Bounds> bounds(primitiveCount);
+        for (auto& primitive : bounds)
+        {
+            primitive.center = { position(random), position(random), position(random) };
+            primitive.extents = { size(random), size(random), size(random) };
+            primitive.radius = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMLoadFloat3(&primitive.extents)));
+        }
+
+        Bvh bvh;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            bvh.Build(bounds);
+        }
+        result.buildMilliseconds = MillisecondsSince(start) / c_iterations;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            for (auto& primitive : bounds)
+            {
+                primitive.center.y += 0.01f;
+            }
+            bvh.Refit(bounds);
+        }
+        result.refitMilliseconds = MillisecondsSince(start) / c_iterations;
+
+        std::vector<uint32_t> changed;
+        for (size_t index = c_movingPrimitiveStride - 1; index < primitiveCount; index += c_movingPrimitiveStride)
+        {
+            changed.push_back(static_cast<uint32_t>(index));
+        }
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            for (uint32_t index : changed)
+            {
+                bounds[index].center.x += 0.05f;
+            }
+            bvh.Refit(bounds, changed);
+        }
+        result.incrementalRefitMilliseconds = MillisecondsSince(start) / c_iterations;
+
+        std::vector<uint32_t> visible;
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            visible.clear();
+            bvh.QueryFrustum(frustum, visible);
+        }
+        result.frustumQueryMilliseconds = MillisecondsSince(start) / c_iterations;
+        result.frustumQueryResults = visible.size();
+
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+        start = std::chrono::high_resolution_clock::now();
+        for (int ray = 0; ray < c_rayCount; ray++)
+        {
+            float distance;
+            bvh.Raycast({ 0.0f, 0.0f, 0.0f }, { direction(random), direction(random), direction(random) }, distance);
+        }
+        result.raycastMicroseconds = 1000.0 * MillisecondsSince(start) / c_rayCount;
+
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+void ReportBvhBenchmark(const std::vector<BvhBenchmarkResult>& results, std::ostream& out)
+{
+    for (const auto& result : results)
+    {
+        out << "BVH benchmark, " << result.primitiveCount << " primitives: build " << result.buildMilliseconds
+            << " ms, refit " << result.refitMilliseconds << " ms, incremental refit " << result.incrementalRefitMilliseconds
+            << " ms, frustum query " << result.frustumQueryMilliseconds << " ms (" << result.frustumQueryResults
+            << " visible), raycast " << result.raycastMicroseconds << " us\n";
+    }
+}
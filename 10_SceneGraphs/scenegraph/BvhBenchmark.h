@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+/// @brief The result of timing the Bvh with one primitive count
+struct BvhBenchmarkResult
+{
+    size_t primitiveCount = 0;
+    double buildMilliseconds = 0.0;
+    double refitMilliseconds = 0.0; // refit after every primitive moved
+    double incrementalRefitMilliseconds = 0.0; // refit after 5% of the primitives moved
+    double frustumQueryMilliseconds = 0.0;
+    size_t frustumQueryResults = 0;
+    double raycastMicroseconds = 0.0; // average time for a single ray
+};
+
+/// @brief Time building, refitting and querying a Bvh over 10k, 100k and 1M randomly placed
+/// primitives. Doesn't touch the GPU.
+std::vector<BvhBenchmarkResult> RunBvhBenchmark();
+
+/// @brief Write a line for each primitive count
+void ReportBvhBenchmark(const std::vector<BvhBenchmarkResult>& results, std::ostream& out);
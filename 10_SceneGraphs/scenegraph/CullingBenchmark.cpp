@@ -0,0 +1,83 @@
+#include "CullingBenchmark.h"
+
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "Culling.h"
+#include "mathutils.h"
+
+namespace
+{
+    constexpr size_t c_objectCount = 100000;
+    constexpr int c_iterations = 20;
+    constexpr float c_worldSize = 200.0f;
+}
+
+CullingBenchmarkResult RunCullingBenchmark()
+{
+    CullingBenchmarkResult result;
+    result.objectCount = c_objectCount;
+
+    // Same projection as the OrbitCamera, looking down +Z from the middle of the world
+    DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(
+        DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+        DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+        DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(degreesToRadians(78), 16.0f / 9.0f, 0.01f, 100.0f);
+    Frustum frustum = ExtractFrustum(view * projection);
+
+    // Fixed seed, so every run culls the same scene
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-0.5f * c_worldSize, 0.5f * c_worldSize);
+    std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+    std::vector<Bounds> bounds(c_objectCount);
+    std::vector<DirectX::XMFLOAT4> spheres(c_objectCount);
+    for (size_t index = 0; index < c_objectCount; index++)
+    {
+        auto& object = bounds[index];
+        object.center = { position(random), position(random), position(random) };
+        object.extents = { size(random), size(random), size(random) };
+        object.radius = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMLoadFloat3(&object.extents)));
+        spheres[index] = { object.center.x, object.center.y, object.center.z, object.radius };
+    }
+
+    size_t visibleCount = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        visibleCount = 0;
+        for (const auto& object : bounds)
+        {
+            if (TestFrustum(frustum, object) != CullResult::Outside)
+                visibleCount++;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    result.visibleCount = visibleCount;
+    result.boundsMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+
+    std::vector<uint8_t> visible(c_objectCount);
+    size_t visibleSpheres = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        visibleSpheres = CullSpheres(frustum, spheres.data(), spheres.size(), visible.data());
+    }
+    end = std::chrono::high_resolution_clock::now();
+
+    result.spheresMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+    result.visibleSpheres = visibleSpheres;
+
+    return result;
+}
+
+void ReportCullingBenchmark(const CullingBenchmarkResult& result, std::ostream& out)
+{
+    out << "Culling benchmark, " << result.objectCount << " objects: sphere and box " << result.boundsMilliseconds << " ms ("
+        << result.visibleCount << " visible), batched spheres " << result.spheresMilliseconds << " ms (" << result.visibleSpheres << " visible)\n";
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+/// @brief The result of culling a synthetic set of objects against a frustum
+struct CullingBenchmarkResult
+{
+    size_t objectCount = 0;
+    size_t visibleCount = 0;
+    size_t visibleSpheres = 0; // by the batched test, which only looks at the spheres
+    double boundsMilliseconds = 0.0; // average time to test every object's sphere and box, one at a time
+    double spheresMilliseconds = 0.0; // average time to test every object's sphere with the batched, four planes at a time test
+};
+
+/// @brief Time frustum culling of 100k randomly placed objects, comparing the per object
+/// sphere/box test against the batched sphere test. Doesn't touch the GPU.
+CullingBenchmarkResult RunCullingBenchmark();
+
+/// @brief Write the timings and what each test found visible on one line
+void ReportCullingBenchmark(const CullingBenchmarkResult& result, std::ostream& out);
@@ -0,0 +1,543 @@
+#include "ImageDecodeBenchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <thread>
+
+#include <stb_image.h>
+
+#include "AsyncLoader.h"
+#include "ImageConvert.h"
+#include "ImageDecoder.h"
+#include "ImagePool.h"
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr size_t c_maxImages = 4;
+    constexpr size_t c_decodesPerImage = 16;
+    constexpr double c_uploadBudgetMilliseconds = 2.0;
+
+    // Stands in for the rest of a frame, while the loader threads carry on
+    constexpr auto c_frameRest = std::chrono::milliseconds(1);
+
+    // How often the resident memory is looked at during a run
+    constexpr auto c_samplePeriod = std::chrono::milliseconds(1);
+
+    // The conversion loops are timed over this many texels, a few times over
+    constexpr size_t c_convertTexels = 2048 * 1024;
+    constexpr int c_convertRepeats = 8;
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    double MegabytesPerSecond(size_t bytes, double milliseconds)
+    {
+        return bytes / (1024.0 * 1024.0) / (std::max(milliseconds, 0.001) / 1000.0);
+    }
+
+    /// @brief The process's resident memory right now, or 0 where it can't be had
+    size_t GetResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters = {};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.WorkingSetSize;
+        return 0;
+#else
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0;
+        size_t residentPages = 0;
+        if (statm >> pages >> residentPages)
+            return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return 0;
+#endif
+    }
+
+    /// @brief The most resident memory the process has had since it started
+    size_t GetPeakResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters = {};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        rusage usage = {};
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            return static_cast<size_t>(usage.ru_maxrss) * 1024;   // Linux gives it in KB
+        return 0;
+#endif
+    }
+
+    /// @brief Watches the resident memory from a thread of its own, as the process's high water
+    /// mark can't be reset between runs
+    class ResidentSampler
+    {
+    public:
+        ResidentSampler()
+            : m_baseline(GetResidentBytes()), m_thread([this]() { Sample(); })
+        {
+        }
+
+        /// @return The most the resident memory rose above where it was when the sampler was made
+        size_t Stop()
+        {
+            m_stop = true;
+            m_thread.join();
+            return m_peak > m_baseline ? m_peak - m_baseline : 0;
+        }
+
+    private:
+        void Sample()
+        {
+            while (!m_stop)
+            {
+                m_peak = std::max(m_peak, GetResidentBytes());
+                std::this_thread::sleep_for(c_samplePeriod);
+            }
+        }
+
+        size_t m_baseline = 0;
+        size_t m_peak = 0;
+        std::atomic<bool> m_stop{ false };
+        std::thread m_thread;
+    };
+
+    /// @brief Counts the decoded bytes alive at once
+    struct HeldBytes
+    {
+        std::atomic<size_t> current{ 0 };
+        std::atomic<size_t> peak{ 0 };
+
+        void Add(size_t bytes)
+        {
+            size_t now = current.fetch_add(bytes) + bytes;
+            size_t previous = peak.load();
+            while (now > previous && !peak.compare_exchange_weak(previous, now))
+            {
+            }
+        }
+
+        void Remove(size_t bytes) { current.fetch_sub(bytes); }
+    };
+
+    void AppendLittleEndian(std::vector<uint8_t>& bytes, uint32_t value, size_t size)
+    {
+        for (size_t byte = 0; byte < size; byte++)
+        {
+            bytes.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+        }
+    }
+
+    /// @brief An uncompressed TGA, top row first, of one (grey), three (RGB) or four (RGBA) channels
+    /// @param texel Writes the RGBA of a texel; grey images keep the red
+    std::vector<uint8_t> MakeTga(uint32_t width, uint32_t height, uint32_t channels, const std::function<void(uint32_t, uint32_t, uint8_t*)>& texel)
+    {
+        std::vector<uint8_t> bytes;
+        bytes.reserve(18 + static_cast<size_t>(width) * height * channels);
+        bytes.push_back(0);                                 // no image ID
+        bytes.push_back(0);                                 // no colour map
+        bytes.push_back(channels == 1 ? 3 : 2);             // uncompressed grey or true colour
+        AppendLittleEndian(bytes, 0, 4);                    // colour map spec
+        AppendLittleEndian(bytes, 0, 1);
+        AppendLittleEndian(bytes, 0, 2);                    // origin
+        AppendLittleEndian(bytes, 0, 2);
+        AppendLittleEndian(bytes, width, 2);
+        AppendLittleEndian(bytes, height, 2);
+        bytes.push_back(static_cast<uint8_t>(channels * 8));
+        bytes.push_back(static_cast<uint8_t>(0x20 | (channels == 4 ? 8 : 0)));  // top row first, alpha bits
+
+        uint8_t rgba[4] = {};
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                texel(x, y, rgba);
+                if (channels == 1)
+                {
+                    bytes.push_back(rgba[0]);
+                    continue;
+                }
+                bytes.push_back(rgba[2]);
+                bytes.push_back(rgba[1]);
+                bytes.push_back(rgba[0]);
+                if (channels == 4)
+                    bytes.push_back(rgba[3]);
+            }
+        }
+        return bytes;
+    }
+
+    /// @brief Up to c_maxImages image files, undecoded, from the nearest raw/texture folder above
+    /// the working directory, which is where the source art lives
+    std::vector<std::vector<uint8_t>> LoadSourceFiles(std::vector<std::string>& skipped)
+    {
+        std::vector<std::vector<uint8_t>> files;
+        std::error_code error;
+        for (auto folder = std::filesystem::current_path(error); !folder.empty(); folder = folder.parent_path())
+        {
+            auto textures = folder / "raw" / "texture";
+            if (!std::filesystem::is_directory(textures, error))
+            {
+                if (folder == folder.parent_path())
+                    break;
+                continue;
+            }
+
+            std::vector<std::filesystem::path> paths;
+            for (const auto& entry : std::filesystem::directory_iterator(textures, error))
+            {
+                auto extension = entry.path().extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+                if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+                    paths.push_back(entry.path());
+            }
+            std::sort(paths.begin(), paths.end());
+
+            for (const auto& path : paths)
+            {
+                std::ifstream stream(path, std::ios::binary);
+                std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+                DecodedImage image;
+                std::string decodeError;
+                if (!DecodeImageMemory(file.data(), file.size(), image, decodeError))
+                {
+                    skipped.push_back(path.string() + ": " + decodeError);
+                    continue;
+                }
+
+                files.push_back(std::move(file));
+                if (files.size() == c_maxImages)
+                    break;
+            }
+            break;
+        }
+        return files;
+    }
+
+    /// @brief Stand ins for the three kinds of image the decoder expands: a photo with no alpha, a
+    /// foliage cutout with soft alpha, and a grey mask
+    std::vector<std::vector<uint8_t>> MakeProceduralFiles()
+    {
+        std::mt19937 random(1234);
+        std::uniform_int_distribution<int> grain(-12, 12);
+        auto noise = [&random, &grain](int value) { return static_cast<uint8_t>(std::clamp(value + grain(random), 0, 255)); };
+
+        std::vector<std::vector<uint8_t>> files;
+        files.push_back(MakeTga(1024, 1024, 3, [&noise](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            double shade = 0.5 + 0.5 * std::sin(x * 0.013) * std::cos(y * 0.021);
+            texel[0] = noise(static_cast<int>(90 + 140 * shade));
+            texel[1] = noise(static_cast<int>(70 + 110 * shade * shade));
+            texel[2] = noise(static_cast<int>(40 + 60 * (1.0 - shade)));
+        }));
+        files.push_back(MakeTga(512, 512, 4, [&noise](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            double leaf = std::sin(x * 0.09) + std::sin(y * 0.07 + x * 0.02);
+            texel[0] = noise(40);
+            texel[1] = noise(static_cast<int>(120 + 50 * std::sin(y * 0.05)));
+            texel[2] = noise(30);
+            texel[3] = static_cast<uint8_t>(std::clamp(128.0 + 200.0 * leaf, 0.0, 255.0));
+        }));
+        files.push_back(MakeTga(512, 512, 1, [&noise](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            texel[0] = noise(static_cast<int>(128 + 100 * std::sin((x + y) * 0.03)));
+        }));
+        return files;
+    }
+
+    /// @brief How the renderer decoded images before the pool: stb_image converts to RGBA into a
+    /// buffer of its own, which is copied out and freed
+    bool DecodeAsBefore(const std::vector<uint8_t>& file, DecodedImage& image)
+    {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        unsigned char* data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, STBI_rgb_alpha);
+        if (data == nullptr)
+            return false;
+
+        image.width = static_cast<uint32_t>(width);
+        image.height = static_cast<uint32_t>(height);
+        image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+        std::memcpy(image.pixels.data(), data, image.pixels.size());
+        stbi_image_free(data);
+        return true;
+    }
+
+    bool DecodeAsBeforeHeld(const std::vector<uint8_t>& file, DecodedImage& image, HeldBytes& held)
+    {
+        if (!DecodeAsBefore(file, image))
+            return false;
+        held.Add(image.pixels.size());
+        return true;
+    }
+
+    void ReleaseHeld(DecodedImage& image, HeldBytes& held)
+    {
+        held.Remove(image.pixels.size());
+    }
+
+    /// @brief Stands in for creating the texture: copies the texels as CreateTexture2D would, and
+    /// hashes them so the runs can be compared
+    uint64_t Upload(const DecodedImage& image, std::vector<uint8_t>& staging)
+    {
+        staging.resize(image.pixels.size());
+        std::memcpy(staging.data(), image.pixels.data(), staging.size());
+
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t offset = 0; offset + 8 <= staging.size(); offset += 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, staging.data() + offset, 8);
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    using DecodeFunction = std::function<bool(const std::vector<uint8_t>& file, DecodedImage& image, HeldBytes& held)>;
+    using ReleaseFunction = std::function<void(DecodedImage& image, HeldBytes& held)>;
+
+    /// @brief Decode every file c_decodesPerImage times on a loader, uploading under the budget
+    ImageDecodeRun RunDecodes(const char* name, const std::vector<std::vector<uint8_t>>& files, AsyncLoader& loader,
+        const DecodeFunction& decode, const ReleaseFunction& release, std::vector<uint64_t>& hashes)
+    {
+        ImageDecodeRun run;
+        run.name = name;
+        hashes.assign(files.size() * c_decodesPerImage, 0);
+
+        HeldBytes held;
+        std::vector<uint8_t> staging;
+        size_t encodedBytes = 0;
+        std::atomic<size_t> decodedBytes{ 0 };
+
+        ResidentSampler sampler;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t index = 0; index < hashes.size(); index++)
+        {
+            const auto& file = files[index % files.size()];
+            encodedBytes += file.size();
+            loader.Submit(name, [&, index]() -> AsyncLoader::UploadFunction
+            {
+                auto image = std::shared_ptr<DecodedImage>(new DecodedImage(), [&release, &held](DecodedImage* image)
+                {
+                    release(*image, held);
+                    delete image;
+                });
+                if (!decode(files[index % files.size()], *image, held))
+                    return {};
+                decodedBytes += image->pixels.size();
+
+                return [&, index, image]()
+                {
+                    hashes[index] = Upload(*image, staging);
+                    return true;
+                };
+            });
+        }
+
+        while (!loader.IsIdle())
+        {
+            loader.ProcessUploads(c_uploadBudgetMilliseconds);
+            run.frames++;
+            std::this_thread::sleep_for(c_frameRest);
+        }
+        run.milliseconds = MillisecondsSince(start);
+        run.peakResidentBytes = sampler.Stop();
+        run.peakHeldBytes = held.peak;
+        run.encodedMegabytesPerSecond = MegabytesPerSecond(encodedBytes, run.milliseconds);
+        run.decodedMegabytesPerSecond = MegabytesPerSecond(decodedBytes, run.milliseconds);
+        return run;
+    }
+
+    void ExpandScalar(const uint8_t* source, uint32_t channels, size_t texelCount, uint8_t* rgba)
+    {
+        for (size_t texel = 0; texel < texelCount; texel++)
+        {
+            const uint8_t* in = source + texel * channels;
+            uint8_t* out = rgba + texel * 4;
+            out[0] = in[0];
+            out[1] = channels >= 3 ? in[1] : in[0];
+            out[2] = channels >= 3 ? in[2] : in[0];
+            out[3] = channels == 2 ? in[1] : channels == 4 ? in[3] : 255;
+        }
+    }
+
+    void PremultiplyScalar(uint8_t* rgba, size_t texelCount)
+    {
+        for (size_t texel = 0; texel < texelCount; texel++)
+        {
+            uint8_t* colour = rgba + texel * 4;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                colour[channel] = static_cast<uint8_t>((colour[channel] * colour[3] * 2 + 255) / 510);
+            }
+        }
+    }
+
+    std::vector<uint8_t> RandomBytes(size_t count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> bytes(count);
+        for (auto& byte : bytes)
+        {
+            byte = static_cast<uint8_t>(random());
+        }
+        return bytes;
+    }
+
+    /// @brief Time a conversion over c_convertTexels texels
+    /// @return Megabytes of RGBA written a second
+    double TimeConversion(const std::function<void()>& convert)
+    {
+        convert();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int repeat = 0; repeat < c_convertRepeats; repeat++)
+        {
+            convert();
+        }
+        return MegabytesPerSecond(c_convertTexels * 4 * c_convertRepeats, MillisecondsSince(start));
+    }
+}
+
+ImageDecodeBenchmarkResult RunImageDecodeBenchmark()
+{
+    ImageDecodeBenchmarkResult result;
+
+    // The conversions on their own, against the plain loops
+    {
+        auto rgb = RandomBytes(c_convertTexels * 3, 1);
+        std::vector<uint8_t> rgba(c_convertTexels * 4);
+        result.expandMegabytesPerSecond = TimeConversion([&]() { ExpandToRgba(rgb.data(), 3, c_convertTexels, rgba.data()); });
+        result.expandScalarMegabytesPerSecond = TimeConversion([&]() { ExpandScalar(rgb.data(), 3, c_convertTexels, rgba.data()); });
+
+        // Premultiplied again and again, which costs the same as the first time
+        rgba = RandomBytes(c_convertTexels * 4, 2);
+        result.premultiplyMegabytesPerSecond = TimeConversion([&]() { PremultiplyAlpha(rgba.data(), c_convertTexels, false); });
+        result.premultiplyScalarMegabytesPerSecond = TimeConversion([&]() { PremultiplyScalar(rgba.data(), c_convertTexels); });
+        result.premultiplySrgbMegabytesPerSecond = TimeConversion([&]() { PremultiplyAlpha(rgba.data(), c_convertTexels, true); });
+    }
+
+    auto files = LoadSourceFiles(result.skipped);
+    if (files.empty())
+    {
+        files = MakeProceduralFiles();
+        result.procedural = true;
+    }
+    result.imageCount = files.size();
+    result.decodeCount = files.size() * c_decodesPerImage;
+
+    // Room for every loader thread to have an image decoding, and one more waiting for upload
+    AsyncLoader loader;
+    result.workerCount = loader.GetWorkerCount();
+    size_t largestBytes = 0;
+    for (const auto& file : files)
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::string error;
+        if (ReadImageSize(file.data(), file.size(), width, height, error))
+            largestBytes = std::max(largestBytes, static_cast<size_t>(width) * height * 4);
+        result.encodedBytes += file.size() * c_decodesPerImage;
+        result.decodedBytes += static_cast<size_t>(width) * height * 4 * c_decodesPerImage;
+    }
+    result.budgetBytes = largestBytes * (result.workerCount + 1);
+
+    // The decoder's own allocations make the process's memory grow the first time through, which
+    // would be counted against whichever run went first, so one round goes untimed. The pool's
+    // kept buffers are freed before the second run, so it doesn't start with them resident.
+    std::vector<uint64_t> beforeHashes;
+    RunDecodes("warm up", files, loader, DecodeAsBeforeHeld, ReleaseHeld, beforeHashes);
+
+    ImagePool pool(result.budgetBytes);
+    std::vector<uint64_t> pooledHashes;
+    result.runs.push_back(RunDecodes("pooled, expanded in place", files, loader,
+        [&pool](const std::vector<uint8_t>& file, DecodedImage& image, HeldBytes& held)
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::string error;
+            if (!ReadImageSize(file.data(), file.size(), width, height, error))
+                return false;
+
+            size_t bytes = static_cast<size_t>(width) * height * 4;
+            pool.Reserve(bytes);
+            held.Add(bytes);
+            image.pixels = pool.Take(bytes);
+            if (DecodeImageMemory(file.data(), file.size(), image, error))
+                return true;
+
+            held.Remove(bytes);
+            pool.Unreserve(bytes);
+            pool.Give(std::move(image.pixels));
+            return false;
+        },
+        [&pool](DecodedImage& image, HeldBytes& held)
+        {
+            if (image.pixels.empty())
+                return;
+            size_t bytes = static_cast<size_t>(image.width) * image.height * 4;
+            held.Remove(bytes);
+            pool.Unreserve(bytes);
+            pool.Give(std::move(image.pixels));
+        },
+        pooledHashes));
+    pool.Trim();
+
+    result.runs.push_back(RunDecodes("stb_image RGBA, copied, as before", files, loader, DecodeAsBeforeHeld, ReleaseHeld, beforeHashes));
+
+    loader.Shutdown();
+
+    bool matches = beforeHashes == pooledHashes && std::find(beforeHashes.begin(), beforeHashes.end(), 0) == beforeHashes.end();
+    for (auto& run : result.runs)
+    {
+        run.matches = matches;
+    }
+    auto poolStats = pool.GetStats();
+    result.poolReuses = poolStats.reuses;
+    result.poolWaits = poolStats.waits;
+    result.processPeakResidentBytes = GetPeakResidentBytes();
+
+    return result;
+}
+
+void ReportImageDecodeBenchmark(const ImageDecodeBenchmarkResult& result, std::ostream& out)
+{
+    out << "Image decode benchmark: RGB to RGBA " << result.expandMegabytesPerSecond << " MB/s (plain loop " << result.expandScalarMegabytesPerSecond
+        << "), premultiply " << result.premultiplyMegabytesPerSecond << " MB/s (plain loop " << result.premultiplyScalarMegabytesPerSecond
+        << "), in linear light " << result.premultiplySrgbMegabytesPerSecond << " MB/s\n";
+    out << "  " << result.imageCount << (result.procedural ? " generated" : " source") << " images decoded " << result.decodeCount << " times, "
+        << result.encodedBytes / 1024 << " KB to " << result.decodedBytes / 1024 << " KB, on " << result.workerCount << " loader threads\n";
+    for (const auto& run : result.runs)
+    {
+        out << "  " << run.name << ": " << run.milliseconds << " ms over " << run.frames << " frames, " << run.encodedMegabytesPerSecond
+            << " MB/s in, " << run.decodedMegabytesPerSecond << " MB/s out, at most " << run.peakHeldBytes / 1024 << " KB held, resident +"
+            << run.peakResidentBytes / 1024 << " KB" << (run.matches ? "" : " (runs don't match!)") << "\n";
+    }
+    out << "  Pool budget " << result.budgetBytes / 1024 << " KB, " << result.poolReuses << " buffers reused, " << result.poolWaits
+        << " waits; process peak resident " << result.processPeakResidentBytes / 1024 << " KB\n";
+    for (const auto& skipped : result.skipped)
+    {
+        out << "  Couldn't decode " << skipped << "\n";
+    }
+}
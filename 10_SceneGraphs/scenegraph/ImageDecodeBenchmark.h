@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// @brief Decoding the same images on the loader threads one way or the other
+struct ImageDecodeRun
+{
+    std::string name;
+    double milliseconds = 0.0;              // from the first submit to the last upload
+    double encodedMegabytesPerSecond = 0.0; // of the files decoded
+    double decodedMegabytesPerSecond = 0.0; // of the RGBA written
+    uint32_t frames = 0;                    // frames it took for everything to be uploaded
+    size_t peakHeldBytes = 0;               // most decoded bytes alive at once, decoded and waiting for upload
+    size_t peakResidentBytes = 0;           // most the process's resident memory rose above where it started
+    bool matches = false;                   // every image uploaded the same texels as the other run
+};
+
+/// @brief The result of timing the image pipeline against decoding as it was
+struct ImageDecodeBenchmarkResult
+{
+    size_t imageCount = 0;
+    bool procedural = false;                // no source images were found, so generated ones were used
+    size_t decodeCount = 0;                 // each image is decoded several times
+    size_t encodedBytes = 0;                // over every decode
+    size_t decodedBytes = 0;
+    unsigned workerCount = 0;
+    size_t budgetBytes = 0;                 // of the pool in the pooled run
+    uint64_t poolReuses = 0;                // buffers the pool handed out again
+    uint64_t poolWaits = 0;                 // loads that waited for the budget
+
+    double expandMegabytesPerSecond = 0.0;  // RGB to RGBA, of RGBA written
+    double expandScalarMegabytesPerSecond = 0.0;
+    double premultiplyMegabytesPerSecond = 0.0;
+    double premultiplyScalarMegabytesPerSecond = 0.0;
+    double premultiplySrgbMegabytesPerSecond = 0.0;
+
+    std::vector<ImageDecodeRun> runs;
+    size_t processPeakResidentBytes = 0;    // the high water mark of the whole process, where the OS says it
+    std::vector<std::string> skipped;       // source images that couldn't be decoded, and why
+};
+
+/// @brief Time expanding to RGBA and premultiplying against plain loops. Then decode the images
+/// in raw/texture, looked for above the working directory, many times over on an AsyncLoader,
+/// first through the pool and then as the renderer used to (stb_image forced to RGBA, copied out
+/// and freed), uploading under the per-frame budget as the renderer does, and measure the
+/// throughput and memory of each. If there are no images there, generated TGAs are used instead.
+ImageDecodeBenchmarkResult RunImageDecodeBenchmark();
+
+/// @brief Write the conversions, the decode runs side by side, then the pool and whatever was skipped
+void ReportImageDecodeBenchmark(const ImageDecodeBenchmarkResult& result, std::ostream& out);
@@ -0,0 +1,85 @@
+#include "InstancingBenchmark.h"
+
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+
+namespace
+{
+    constexpr size_t c_propCopies = 10000;
+    constexpr size_t c_uniqueDraws = 500;
+    constexpr int c_iterations = 20;
+    constexpr uint32_t c_propCount = 4;         // props, each one mesh drawn over and over
+    constexpr uint32_t c_shaderCount = 2;
+
+    struct Draw
+    {
+        uint32_t shader;
+        uint32_t geometry;
+        float depth;
+    };
+}
+
+InstancingBenchmarkResult RunInstancingBenchmark()
+{
+    InstancingBenchmarkResult result;
+    result.drawCount = c_propCopies + c_uniqueDraws;
+
+    // Fixed seed, so every run batches the same frame
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<uint32_t> prop(0, c_propCount - 1);
+    std::uniform_int_distribution<uint32_t> shader(0, c_shaderCount - 1);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+    // Props use geometry ids 1..c_propCount, everything else gets one of its own
+    std::vector<Draw> draws;
+    draws.reserve(result.drawCount);
+    for (size_t index = 0; index < c_propCopies; index++)
+    {
+        draws.push_back(Draw{ 0, 1 + prop(random), depth(random) });
+    }
+    for (size_t index = 0; index < c_uniqueDraws; index++)
+    {
+        draws.push_back(Draw{ shader(random), static_cast<uint32_t>(1 + c_propCount + index), depth(random) });
+    }
+
+    RenderQueue queue;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        queue.Clear();
+        for (uint32_t index = 0; index < draws.size(); index++)
+        {
+            const Draw& draw = draws[index];
+            queue.Submit(RenderQueue::MakeSortKey(draw.shader, 0, draw.geometry, draw.depth), index);
+        }
+        queue.Sort();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.sortMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+
+    // Everything can be instanced; the one-off meshes just never make a long enough run
+    InstanceBatcher batcher;
+    start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        batcher.Build(queue.GetPackets(), [](const DrawPacket&) { return true; });
+    }
+    end = std::chrono::high_resolution_clock::now();
+    result.batchMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+
+    result.drawCalls = batcher.GetStats().drawCalls;
+    result.instancedBatches = batcher.GetStats().instancedBatches;
+
+    return result;
+}
+
+void ReportInstancingBenchmark(const InstancingBenchmarkResult& result, std::ostream& out)
+{
+    out << "Instancing benchmark, " << result.drawCount << " draws: sort " << result.sortMilliseconds << " ms, batch "
+        << result.batchMilliseconds << " ms, " << result.drawCalls << " draw calls (" << result.instancedBatches << " instanced)\n";
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+/// @brief The result of batching a synthetic frame's worth of draws into instanced draws
+struct InstancingBenchmarkResult
+{
+    size_t drawCount = 0;
+    size_t drawCalls = 0;           // draw calls left after batching
+    size_t instancedBatches = 0;
+    double sortMilliseconds = 0.0;  // average time to fill and sort the render queue
+    double batchMilliseconds = 0.0; // average time to group the sorted queue into batches
+};
+
+/// @brief Time sorting and batching a frame with 10k copies of a handful of props plus a few
+/// hundred one-off meshes, and count the draw calls that are left. Doesn't touch the GPU.
+InstancingBenchmarkResult RunInstancingBenchmark();
+
+/// @brief Write the timings and the draw calls left on one line
+void ReportInstancingBenchmark(const InstancingBenchmarkResult& result, std::ostream& out);
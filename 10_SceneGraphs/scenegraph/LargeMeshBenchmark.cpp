@@ -0,0 +1,112 @@
+#include "LargeMeshBenchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "MeshSplitter.h"
+#include "VertexCompression.h"
+
+namespace
+{
+    // 1200 x 1200 quads: 1.44 million vertices and 2.88 million triangles
+    constexpr uint32_t c_gridQuads = 1200;
+}
+
+LargeMeshBenchmarkResult RunLargeMeshBenchmark()
+{
+    LargeMeshBenchmarkResult result;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    constexpr uint32_t gridVertices = c_gridQuads + 1;
+    std::vector<VertexNormal> vertices;
+    vertices.reserve(static_cast<size_t>(gridVertices) * gridVertices);
+    for (uint32_t row = 0; row < gridVertices; row++)
+    {
+        for (uint32_t column = 0; column < gridVertices; column++)
+        {
+            vertices.push_back(VertexNormal{
+                static_cast<float>(column), 0.0f, static_cast<float>(row),
+                0.0f, 1.0f, 0.0f });
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(static_cast<size_t>(c_gridQuads) * c_gridQuads * 6);
+    for (uint32_t row = 0; row < c_gridQuads; row++)
+    {
+        for (uint32_t column = 0; column < c_gridQuads; column++)
+        {
+            uint32_t corner = row * gridVertices + column;
+            indices.push_back(corner);
+            indices.push_back(corner + gridVertices);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + gridVertices);
+            indices.push_back(corner + gridVertices + 1);
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    result.fillMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    result.vertexCount = vertices.size();
+    result.triangleCount = indices.size() / 3;
+    result.longIndexBytes = indices.size() * sizeof(uint32_t);
+    for (auto index : indices)
+    {
+        if (index >= c_maxShortIndexVertices)
+            result.wrappedIndices++;
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    auto clusters = SplitMesh(indices, vertices.size());
+    std::vector<std::vector<VertexNormal>> clusterVertices;
+    clusterVertices.reserve(clusters.size());
+    for (const auto& cluster : clusters)
+    {
+        clusterVertices.push_back(GatherClusterVertices(cluster, vertices));
+    }
+    end = std::chrono::high_resolution_clock::now();
+    result.splitMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    // Walk the clusters' triangles in order; together they have to be the source's triangles
+    result.clusterCount = clusters.size();
+    result.valid = !FitsShortIndices(vertices.size()) && !clusters.empty();
+    size_t sourceIndex = 0;
+    for (size_t clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++)
+    {
+        const auto& cluster = clusters[clusterIndex];
+        result.splitVertexCount += cluster.vertices.size();
+        result.splitIndexBytes += cluster.indices.size() * sizeof(uint16_t);
+
+        if (!FitsShortIndices(cluster.vertices.size()) || clusterVertices[clusterIndex].size() != cluster.vertices.size())
+            result.valid = false;
+
+        for (auto localIndex : cluster.indices)
+        {
+            if (localIndex >= cluster.vertices.size() || sourceIndex >= indices.size()
+                || cluster.vertices[localIndex] != indices[sourceIndex])
+            {
+                result.valid = false;
+                break;
+            }
+            sourceIndex++;
+        }
+    }
+    if (sourceIndex != indices.size())
+        result.valid = false;
+
+    return result;
+}
+
+void ReportLargeMeshBenchmark(const LargeMeshBenchmarkResult& result, std::ostream& out)
+{
+    out << "Large mesh benchmark, " << result.vertexCount << " vertices, " << result.triangleCount << " triangles: "
+        << result.wrappedIndices << " indices past 16 bits, fill " << result.fillMilliseconds << " ms, split into "
+        << result.clusterCount << " clusters in " << result.splitMilliseconds << " ms ("
+        << result.splitVertexCount << " vertices, " << result.splitIndexBytes / 1024 << " KB of indices vs "
+        << result.longIndexBytes / 1024 << " KB)" << (result.valid ? "" : ", clusters DO NOT match the source mesh!") << "\n";
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+/// @brief The result of preparing a synthetic mesh too large for 16 bit indices
+struct LargeMeshBenchmarkResult
+{
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    size_t wrappedIndices = 0;      // indices a 16 bit index buffer would have wrapped around
+    double fillMilliseconds = 0.0;  // building the vertex and 32 bit index buffers
+    size_t longIndexBytes = 0;      // size of the single 32 bit index buffer
+
+    double splitMilliseconds = 0.0; // splitting into clusters and gathering their vertices
+    size_t clusterCount = 0;
+    size_t splitVertexCount = 0;    // vertices over all the clusters, including the copies along the seams
+    size_t splitIndexBytes = 0;     // size of all the clusters' 16 bit index buffers
+    bool valid = false;             // every cluster fits 16 bit indices and draws the source's triangles
+};
+
+/// @brief Build a grid mesh of a few million triangles the way the mesh loaders do, then split it
+/// into 16 bit clusters and check that the clusters draw exactly the same triangles. Doesn't touch
+/// the GPU.
+LargeMeshBenchmarkResult RunLargeMeshBenchmark();
+
+/// @brief Write the sizes and timings on one line, and whether the clusters matched
+void ReportLargeMeshBenchmark(const LargeMeshBenchmarkResult& result, std::ostream& out);
@@ -0,0 +1,150 @@
+#include "LodBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+#include "LodSelection.h"
+#include "VertexCompression.h"
+
+namespace
+{
+    constexpr uint32_t c_sphereRings = 256;
+    constexpr uint32_t c_sphereSegments = 512;
+    constexpr float c_sphereRadius = 50.0f;
+
+    // Each triangle is checked at a grid of points this many steps along each edge
+    constexpr int c_errorSamples = 4;
+
+    // A 1080 pixel high viewport with the orbit camera's field of view
+    constexpr float c_viewportHeight = 1080.0f;
+    constexpr float c_verticalFov = 78.0f * 3.14159265f / 180.0f;
+
+    constexpr float c_pi = 3.14159265f;
+
+    /// @brief A UV sphere centred on the origin. The first and last column share positions, as do
+    /// the vertices at each pole, which is the kind of seam the simplifier has to leave alone.
+    void MakeSphere(std::vector<VertexNormal>& vertices, std::vector<uint32_t>& indices)
+    {
+        for (uint32_t ring = 0; ring <= c_sphereRings; ring++)
+        {
+            float theta = c_pi * ring / c_sphereRings;
+            for (uint32_t segment = 0; segment <= c_sphereSegments; segment++)
+            {
+                float phi = 2.0f * c_pi * segment / c_sphereSegments;
+                float nx = std::sin(theta) * std::cos(phi);
+                float ny = std::cos(theta);
+                float nz = std::sin(theta) * std::sin(phi);
+                vertices.push_back(VertexNormal{ nx * c_sphereRadius, ny * c_sphereRadius, nz * c_sphereRadius, nx, ny, nz });
+            }
+        }
+
+        const uint32_t columns = c_sphereSegments + 1;
+        for (uint32_t ring = 0; ring < c_sphereRings; ring++)
+        {
+            for (uint32_t segment = 0; segment < c_sphereSegments; segment++)
+            {
+                uint32_t a = ring * columns + segment;
+                uint32_t b = a + columns;
+                if (ring > 0)
+                    indices.insert(indices.end(), { a, a + 1, b });
+                if (ring < c_sphereRings - 1)
+                    indices.insert(indices.end(), { a + 1, b + 1, b });
+            }
+        }
+    }
+
+    /// @brief The furthest any point of the triangles is from the sphere, checked on a grid of
+    /// points across each one
+    float MeasureError(const std::vector<VertexNormal>& vertices, const uint32_t* indices, size_t indexCount)
+    {
+        float maxError = 0.0f;
+        for (size_t corner = 0; corner < indexCount; corner += 3)
+        {
+            const VertexNormal& p0 = vertices[indices[corner]];
+            const VertexNormal& p1 = vertices[indices[corner + 1]];
+            const VertexNormal& p2 = vertices[indices[corner + 2]];
+            for (int i = 0; i <= c_errorSamples; i++)
+            {
+                for (int j = 0; i + j <= c_errorSamples; j++)
+                {
+                    float u = static_cast<float>(i) / c_errorSamples;
+                    float v = static_cast<float>(j) / c_errorSamples;
+                    float w = 1.0f - u - v;
+                    float x = p0.x * w + p1.x * u + p2.x * v;
+                    float y = p0.y * w + p1.y * u + p2.y * v;
+                    float z = p0.z * w + p1.z * u + p2.z * v;
+                    maxError = std::max(maxError, std::fabs(c_sphereRadius - std::sqrt(x * x + y * y + z * z)));
+                }
+            }
+        }
+        return maxError;
+    }
+}
+
+LodBenchmarkResult RunLodBenchmark()
+{
+    LodBenchmarkResult result;
+
+    std::vector<VertexNormal> vertices;
+    std::vector<uint32_t> indices;
+    MakeSphere(vertices, indices);
+    result.vertexCount = vertices.size();
+    result.triangleCount = indices.size() / 3;
+
+    LodChain chain = BuildLodChain(vertices, indices);
+    result.levelCount = static_cast<uint32_t>(chain.levels.size());
+    result.milliseconds = chain.milliseconds;
+    result.trianglesPerSecond = chain.milliseconds > 0.0 ? result.triangleCount / (chain.milliseconds / 1000.0) : 0.0;
+
+    LodView view;
+    view.eye[2] = -1.0f;
+    view.projectionScale = ComputeProjectionScale(c_verticalFov, c_viewportHeight);
+    const float center[3] = { 0.0f, 0.0f, 0.0f };
+
+    float lodErrors[c_maxLodLevels] = {};
+    result.baseError = MeasureError(vertices, chain.indices.data(), chain.levels[0].indexCount);
+    for (uint32_t level = 0; level < result.levelCount; level++)
+    {
+        const LodLevel& lod = chain.levels[level];
+        LodBenchmarkLevel& measured = result.levels[level];
+        measured.triangleCount = lod.indexCount / 3;
+        measured.reduction = static_cast<float>(measured.triangleCount) / result.triangleCount;
+        measured.estimatedError = lod.error;
+        measured.measuredError = MeasureError(vertices, chain.indices.data() + lod.firstIndex, lod.indexCount);
+        measured.switchDistance = lod.error * view.projectionScale / view.maxPixelError + c_sphereRadius;
+        lodErrors[level] = lod.error;
+    }
+
+    // Stand just past each switch distance and check the level picked is the one expected, and
+    // that its error, as measured rather than estimated, is within a few pixels
+    result.selectionConsistent = true;
+    for (uint32_t level = 1; level < result.levelCount; level++)
+    {
+        float distance = result.levels[level].switchDistance * 1.001f;
+        view.eye[2] = -distance;
+        uint32_t picked = SelectLod(view, center, c_sphereRadius, 1.0f, lodErrors, result.levelCount);
+        float pixels = ProjectLodError(view, center, c_sphereRadius, result.levels[picked].measuredError - result.baseError);
+        if (picked < level || pixels > 4.0f * view.maxPixelError)
+            result.selectionConsistent = false;
+    }
+
+    return result;
+}
+
+void ReportLodBenchmark(const LodBenchmarkResult& result, std::ostream& out)
+{
+    out << "LOD benchmark, " << result.triangleCount << " triangles in " << result.levelCount << " levels, built in "
+        << result.milliseconds << " ms (" << result.trianglesPerSecond / 1.0e6 << " M triangles/s), full mesh error "
+        << result.baseError << "\n";
+    for (uint32_t level = 0; level < result.levelCount; level++)
+    {
+        const auto& measured = result.levels[level];
+        out << "  LOD " << level << ": " << measured.triangleCount << " triangles (" << measured.reduction * 100.0f
+            << "%), error estimated " << measured.estimatedError << ", measured " << measured.measuredError
+            << ", picked from " << measured.switchDistance << " units\n";
+    }
+    if (!result.selectionConsistent)
+        out << "  LOD selection picked a level outside the pixel budget!\n";
+}
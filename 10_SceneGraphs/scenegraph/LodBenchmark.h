@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "MeshSimplifier.h"
+
+/// @brief One level of the chain built by the LOD benchmark
+struct LodBenchmarkLevel
+{
+    size_t triangleCount = 0;
+    float reduction = 0.0f;         // fraction of the full mesh's triangles that are left
+    float estimatedError = 0.0f;    // what the simplifier reports, which LOD selection goes by
+    float measuredError = 0.0f;     // the furthest any part of the level is from the true surface
+    float switchDistance = 0.0f;    // how far from the camera the mesh has to be before this level is picked
+};
+
+/// @brief The result of building a chain of levels of detail for a synthetic mesh
+struct LodBenchmarkResult
+{
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    uint32_t levelCount = 0;
+    LodBenchmarkLevel levels[c_maxLodLevels];
+    float baseError = 0.0f;             // the full mesh's own distance from the true surface
+    double milliseconds = 0.0;
+    double trianglesPerSecond = 0.0;    // input triangles simplified per second, over the whole chain
+    bool selectionConsistent = false;   // at every switch distance the level picked stays within the pixel budget
+};
+
+/// @brief Build levels of detail for a finely tessellated sphere, with seams like an imported
+/// mesh has, and measure each level against the true sphere. Doesn't touch the GPU.
+LodBenchmarkResult RunLodBenchmark();
+
+/// @brief Write the chain's totals, then a line for each level
+void ReportLodBenchmark(const LodBenchmarkResult& result, std::ostream& out);
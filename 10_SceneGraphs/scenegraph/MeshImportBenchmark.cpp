@@ -0,0 +1,252 @@
+#include "MeshImportBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ostream>
+#include <thread>
+
+#include "JobSystem.h"
+#include "MeshImport.h"
+
+namespace
+{
+    constexpr uint32_t c_sceneMeshes = 40;          // about 1.2 million vertices between them
+    constexpr int c_iterations = 5;
+
+    /// @brief A face the way assimp keeps one
+    struct TestFace
+    {
+        unsigned int mNumIndices = 0;
+        const unsigned int* mIndices = nullptr;
+    };
+
+    /// @brief The arrays of one source mesh, which a SourceMeshView looks into
+    struct TestMesh
+    {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texCoords;
+        std::vector<unsigned int> faceIndices;
+        std::vector<TestFace> faces;
+        uint32_t vertexCount = 0;
+        uint32_t materialIndex = 0;
+    };
+
+    /// @brief A strip of triangles along x, placed by the mesh's number so every vertex of the scene
+    /// is somewhere of its own
+    /// @param faceSizes Repeated over the strip: 3 for a triangle, else a face that isn't one
+    TestMesh MakeStrip(uint32_t meshIndex, uint32_t vertexCount, uint32_t materialIndex, bool normals, bool texCoords, const std::vector<uint32_t>& faceSizes = { 3 })
+    {
+        TestMesh mesh;
+        mesh.vertexCount = vertexCount;
+        mesh.materialIndex = materialIndex;
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            const float position[3] = { meshIndex * 100000.0f + vertex / 2, static_cast<float>(vertex % 2), static_cast<float>(meshIndex) };
+            mesh.positions.insert(mesh.positions.end(), position, position + 3);
+            if (normals)
+            {
+                const float normal[3] = { 0.0f, 0.0f, vertex % 2 == 0 ? 1.0f : -1.0f };
+                mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+            }
+            if (texCoords)
+            {
+                const float uvw[3] = { vertex * 0.5f, static_cast<float>(meshIndex), 0.0f };
+                mesh.texCoords.insert(mesh.texCoords.end(), uvw, uvw + 3);
+            }
+        }
+
+        // The indices go in first and the faces point into them after, once they've stopped moving
+        std::vector<uint32_t> sizes;
+        for (uint32_t first = 0; first + 3 <= vertexCount; first++)
+        {
+            uint32_t size = std::min(faceSizes[first % faceSizes.size()], vertexCount - first);
+            for (uint32_t corner = 0; corner < size; corner++)
+            {
+                mesh.faceIndices.push_back(first + corner);
+            }
+            sizes.push_back(size);
+        }
+        size_t next = 0;
+        for (auto size : sizes)
+        {
+            mesh.faces.push_back(TestFace{ size, mesh.faceIndices.data() + next });
+            next += size;
+        }
+        return mesh;
+    }
+
+    std::vector<SourceMeshView<TestFace>> MakeViews(const std::vector<TestMesh>& meshes)
+    {
+        std::vector<SourceMeshView<TestFace>> views;
+        for (const auto& mesh : meshes)
+        {
+            SourceMeshView<TestFace> view;
+            view.positions = mesh.positions.data();
+            view.normals = mesh.normals.empty() ? nullptr : mesh.normals.data();
+            view.texCoords = mesh.texCoords.empty() ? nullptr : mesh.texCoords.data();
+            view.vertexCount = mesh.vertexCount;
+            view.faces = mesh.faces.data();
+            view.faceCount = static_cast<uint32_t>(mesh.faces.size());
+            view.materialIndex = mesh.materialIndex;
+            views.push_back(view);
+        }
+        return views;
+    }
+
+    /// @brief Meshes of many sizes, most of them more than a chunk and few a whole number of them
+    std::vector<TestMesh> MakeLargeScene(uint32_t meshCount)
+    {
+        std::vector<TestMesh> meshes;
+        for (uint32_t mesh = 0; mesh < meshCount; mesh++)
+        {
+            meshes.push_back(MakeStrip(mesh, 10000 + mesh * 7919 % 40000, mesh % 5, true, true));
+        }
+        return meshes;
+    }
+
+    /// @brief The scene merged as ImportMesh did before it counted first: a mesh after another,
+    /// with the buffers growing as they go
+    template <typename TVertex>
+    size_t MergeSinglePass(const std::vector<SourceMeshView<TestFace>>& meshes, std::vector<TVertex>& vertices, std::vector<uint32_t>& indices,
+        std::vector<uint32_t>& triangleMaterials)
+    {
+        constexpr bool textured = std::is_same_v<TVertex, VertexNormalUV>;
+
+        size_t skippedFaces = 0;
+        for (const auto& mesh : meshes)
+        {
+            auto baseVertex = static_cast<uint32_t>(vertices.size());
+            for (uint32_t vertex = 0; vertex < mesh.vertexCount; vertex++)
+            {
+                const float* position = mesh.positions + static_cast<size_t>(vertex) * 3;
+                const float up[3] = { 0.0f, 1.0f, 0.0f };
+                const float* normal = mesh.normals != nullptr ? mesh.normals + static_cast<size_t>(vertex) * 3 : up;
+                if constexpr (textured)
+                {
+                    const float* uv = mesh.texCoords != nullptr ? mesh.texCoords + static_cast<size_t>(vertex) * 3 : nullptr;
+                    vertices.push_back(VertexNormalUV{ position[0], position[1], position[2], normal[0], normal[1], normal[2], uv != nullptr ? uv[0] : 0.0f, uv != nullptr ? uv[1] : 0.0f });
+                }
+                else
+                {
+                    vertices.push_back(VertexNormal{ position[0], position[1], position[2], normal[0], normal[1], normal[2] });
+                }
+            }
+
+            for (uint32_t faceIndex = 0; faceIndex < mesh.faceCount; faceIndex++)
+            {
+                const auto& face = mesh.faces[faceIndex];
+                if (face.mNumIndices != 3)
+                {
+                    skippedFaces++;
+                    continue;
+                }
+
+                indices.push_back(baseVertex + face.mIndices[0]);
+                indices.push_back(baseVertex + face.mIndices[1]);
+                indices.push_back(baseVertex + face.mIndices[2]);
+                triangleMaterials.push_back(mesh.materialIndex);
+            }
+        }
+        return skippedFaces;
+    }
+
+    template <typename TVertex>
+    struct MergedScene
+    {
+        std::vector<TVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+        MergedSceneLayout layout;
+
+        bool operator==(const MergedScene& other) const
+        {
+            return vertices.size() == other.vertices.size() && indices == other.indices && triangleMaterials == other.triangleMaterials
+                && std::memcmp(vertices.data(), other.vertices.data(), vertices.size() * sizeof(TVertex)) == 0;
+        }
+    };
+
+    template <typename TVertex>
+    MergedScene<TVertex> Merge(const std::vector<TestMesh>& meshes, JobSystem* jobs = nullptr)
+    {
+        MergedScene<TVertex> merged;
+        merged.layout = MergeSourceMeshes(MakeViews(meshes), merged.vertices, merged.indices, merged.triangleMaterials, jobs);
+        return merged;
+    }
+
+    /// @brief Merge the scene over and over, starting from empty buffers each time, and find how
+    /// many vertices a second that comes to
+    template <typename TMerge>
+    double MeasureVerticesPerSecond(size_t vertexCount, const TMerge& merge)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            merge();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        return seconds > 0.0 ? vertexCount * c_iterations / seconds : 0.0;
+    }
+}
+
+MeshImportBenchmarkResult RunMeshImportBenchmark()
+{
+    MeshImportBenchmarkResult result;
+
+    auto meshes = MakeLargeScene(c_sceneMeshes);
+    auto views = MakeViews(meshes);
+    auto serial = Merge<VertexNormalUV>(meshes);
+    result.meshes = c_sceneMeshes;
+    result.vertexCount = serial.vertices.size();
+    result.triangleCount = serial.layout.triangleCount;
+
+    result.singlePassVerticesPerSecond = MeasureVerticesPerSecond(result.vertexCount, [&views]()
+        {
+            MergedScene<VertexNormalUV> merged;
+            MergeSinglePass(views, merged.vertices, merged.indices, merged.triangleMaterials);
+        });
+    result.twoPassVerticesPerSecond = MeasureVerticesPerSecond(result.vertexCount, [&views]()
+        {
+            MergedScene<VertexNormalUV> merged;
+            MergeSourceMeshes(views, merged.vertices, merged.indices, merged.triangleMaterials);
+        });
+
+    // Doubling the workers up to one per hardware thread
+    std::vector<unsigned> workerCounts;
+    unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned workerCount = 1; workerCount < maxWorkers; workerCount *= 2)
+    {
+        workerCounts.push_back(workerCount);
+    }
+    workerCounts.push_back(maxWorkers);
+
+    for (auto workerCount : workerCounts)
+    {
+        JobSystem jobs(workerCount);
+
+        MergeScalingResult scaling;
+        scaling.workerCount = workerCount;
+        scaling.matchesSerial = Merge<VertexNormalUV>(meshes, &jobs) == serial;
+        scaling.verticesPerSecond = MeasureVerticesPerSecond(result.vertexCount, [&views, &jobs]()
+            {
+                MergedScene<VertexNormalUV> merged;
+                MergeSourceMeshes(views, merged.vertices, merged.indices, merged.triangleMaterials, &jobs);
+            });
+        result.scaling.push_back(scaling);
+    }
+
+    return result;
+}
+
+void ReportMeshImportBenchmark(const MeshImportBenchmarkResult& result, std::ostream& out)
+{
+    out << "Mesh import benchmark: " << result.meshes << " meshes, " << result.vertexCount << " vertices, " << result.triangleCount
+        << " triangles: merged at " << result.singlePassVerticesPerSecond / 1e6 << " M vertices/s a mesh after another, "
+        << result.twoPassVerticesPerSecond / 1e6 << " M vertices/s in two passes\n";
+    for (const auto& scaling : result.scaling)
+    {
+        out << "Mesh import benchmark, " << scaling.workerCount << " workers: " << scaling.verticesPerSecond / 1e6 << " M vertices/s"
+            << (scaling.matchesSerial ? "" : " (MISMATCH with the serial merge)") << "\n";
+    }
+}
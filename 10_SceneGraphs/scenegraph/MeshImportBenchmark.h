@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/// @brief How fast a scene's meshes were merged with one particular number of workers
+struct MergeScalingResult
+{
+    unsigned workerCount = 0;
+    double verticesPerSecond = 0.0;
+    bool matchesSerial = false;     // whether the buffers are byte for byte those of the serial merge
+};
+
+/// @brief The result of timing how ImportMesh merges a scene of several meshes
+struct MeshImportBenchmarkResult
+{
+    uint32_t meshes = 0;                    // in the timed scene
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    double singlePassVerticesPerSecond = 0.0;   // merged a mesh after another, growing the buffers as it goes, as it was before
+    double twoPassVerticesPerSecond = 0.0;      // counted first, then filled in buffers sized once, on one thread
+    std::vector<MergeScalingResult> scaling;    // the two passes with a JobSystem
+};
+
+/// @brief Time the merge of a large scene of several meshes in vertices a second: a mesh after
+/// another as it was, in two passes, and in two passes across JobSystems of more and more workers,
+/// checking each gives the serial merge's bytes. Doesn't touch the GPU.
+MeshImportBenchmarkResult RunMeshImportBenchmark();
+
+/// @brief Write the single threaded merges, then a line for each number of workers
+void ReportMeshImportBenchmark(const MeshImportBenchmarkResult& result, std::ostream& out);
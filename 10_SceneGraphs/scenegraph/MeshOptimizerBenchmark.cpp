@@ -0,0 +1,143 @@
+#include "MeshOptimizerBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <random>
+
+#include "VertexCompression.h"
+
+namespace
+{
+    constexpr uint32_t c_gridQuads = 256;
+    constexpr uint32_t c_sphereRings = 128;
+    constexpr uint32_t c_sphereSegments = 256;
+
+    struct BenchmarkMesh
+    {
+        std::vector<VertexNormal> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    VertexNormal MakeVertex(float x, float y, float z)
+    {
+        return VertexNormal{ x, y, z, 0.0f, 1.0f, 0.0f };
+    }
+
+    /// @brief A grid drawn a row at a time, as a naive generator or exporter would
+    BenchmarkMesh MakeGrid()
+    {
+        BenchmarkMesh mesh;
+        constexpr uint32_t gridVertices = c_gridQuads + 1;
+        for (uint32_t row = 0; row < gridVertices; row++)
+        {
+            for (uint32_t column = 0; column < gridVertices; column++)
+            {
+                mesh.vertices.push_back(MakeVertex(static_cast<float>(column), 0.0f, static_cast<float>(row)));
+            }
+        }
+
+        for (uint32_t row = 0; row < c_gridQuads; row++)
+        {
+            for (uint32_t column = 0; column < c_gridQuads; column++)
+            {
+                uint32_t corner = row * gridVertices + column;
+                mesh.indices.insert(mesh.indices.end(), { corner, corner + gridVertices, corner + 1 });
+                mesh.indices.insert(mesh.indices.end(), { corner + 1, corner + gridVertices, corner + gridVertices + 1 });
+            }
+        }
+        return mesh;
+    }
+
+    /// @brief A closed UV sphere, so there is something for the overdraw pass to work with
+    BenchmarkMesh MakeSphere()
+    {
+        BenchmarkMesh mesh;
+        constexpr float pi = 3.14159265f;
+        for (uint32_t ring = 0; ring <= c_sphereRings; ring++)
+        {
+            float theta = pi * ring / c_sphereRings;
+            for (uint32_t segment = 0; segment <= c_sphereSegments; segment++)
+            {
+                float phi = 2.0f * pi * segment / c_sphereSegments;
+                mesh.vertices.push_back(MakeVertex(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+            }
+        }
+
+        constexpr uint32_t ringVertices = c_sphereSegments + 1;
+        for (uint32_t ring = 0; ring < c_sphereRings; ring++)
+        {
+            for (uint32_t segment = 0; segment < c_sphereSegments; segment++)
+            {
+                uint32_t corner = ring * ringVertices + segment;
+                mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, corner + ringVertices });
+                mesh.indices.insert(mesh.indices.end(), { corner + 1, corner + ringVertices + 1, corner + ringVertices });
+            }
+        }
+        return mesh;
+    }
+
+    /// @brief Shuffle the triangles and the vertices, like an exporter that doesn't care about order
+    void Shuffle(BenchmarkMesh& mesh)
+    {
+        std::mt19937 random(1234);
+
+        std::vector<uint32_t> remap(mesh.vertices.size());
+        for (uint32_t vertex = 0; vertex < remap.size(); vertex++)
+            remap[vertex] = vertex;
+        std::shuffle(remap.begin(), remap.end(), random);
+
+        std::vector<VertexNormal> vertices(mesh.vertices.size());
+        for (size_t vertex = 0; vertex < remap.size(); vertex++)
+            vertices[remap[vertex]] = mesh.vertices[vertex];
+        mesh.vertices.swap(vertices);
+
+        size_t triangleCount = mesh.indices.size() / 3;
+        std::vector<uint32_t> order(triangleCount);
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+            order[triangle] = triangle;
+        std::shuffle(order.begin(), order.end(), random);
+
+        std::vector<uint32_t> indices;
+        indices.reserve(mesh.indices.size());
+        for (auto triangle : order)
+        {
+            for (int corner = 0; corner < 3; corner++)
+                indices.push_back(remap[mesh.indices[triangle * 3 + corner]]);
+        }
+        mesh.indices.swap(indices);
+    }
+}
+
+std::vector<MeshOptimizerBenchmarkResult> RunMeshOptimizerBenchmark()
+{
+    std::vector<std::pair<std::string, BenchmarkMesh>> meshes;
+    meshes.emplace_back("Grid, row order", MakeGrid());
+    meshes.emplace_back("Grid, shuffled", MakeGrid());
+    Shuffle(meshes.back().second);
+    meshes.emplace_back("Sphere, ring order", MakeSphere());
+    meshes.emplace_back("Sphere, shuffled", MakeSphere());
+    Shuffle(meshes.back().second);
+
+    std::vector<MeshOptimizerBenchmarkResult> results;
+    for (auto& [name, mesh] : meshes)
+    {
+        MeshOptimizerBenchmarkResult result;
+        result.name = name;
+        result.report = OptimizeMesh(mesh.vertices, mesh.indices);
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+void ReportMeshOptimizerBenchmark(const std::vector<MeshOptimizerBenchmarkResult>& results, std::ostream& out)
+{
+    for (const auto& result : results)
+    {
+        const auto& report = result.report;
+        out << "Mesh optimizer benchmark, " << result.name << ", " << report.fifoBefore.triangleCount << " triangles in "
+            << report.milliseconds << " ms: ACMR FIFO " << c_fifoVertexCacheSize << " " << report.fifoBefore.acmr << " -> "
+            << report.fifoAfter.acmr << ", LRU " << c_lruVertexCacheSize << " " << report.lruBefore.acmr << " -> "
+            << report.lruAfter.acmr << ", ATVR FIFO " << report.fifoBefore.atvr << " -> " << report.fifoAfter.atvr << "\n";
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+/// @brief The result of optimizing one synthetic mesh
+struct MeshOptimizerBenchmarkResult
+{
+    std::string name;
+    MeshOptimizationReport report;
+};
+
+/// @brief Optimize a few synthetic meshes with the kind of index order exporters produce, and
+/// measure them with the software vertex caches. Doesn't touch the GPU.
+std::vector<MeshOptimizerBenchmarkResult> RunMeshOptimizerBenchmark();
+
+/// @brief Write a line for each mesh, with its vertex cache figures before and after
+void ReportMeshOptimizerBenchmark(const std::vector<MeshOptimizerBenchmarkResult>& results, std::ostream& out);
@@ -0,0 +1,71 @@
+#include "ProceduralGeometryBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+
+#include "ProceduralGeometry.h"
+
+namespace
+{
+    constexpr uint32_t c_sphereSlices[] = { 32, 128, 512, 1024 };  // stacks are half the slices
+    constexpr float c_sphereRadius = 1.0f;
+
+    constexpr float c_radiansToDegrees = 180.0f / 3.14159265f;
+
+    ProceduralSphereResult RunSphere(uint32_t slices)
+    {
+        ProceduralSphereResult result;
+        PrimitiveDesc desc = MakeSphereDesc(c_sphereRadius, slices, slices / 2);
+        result.slices = desc.segments[0];
+        result.stacks = desc.segments[1];
+
+        auto start = std::chrono::high_resolution_clock::now();
+        PrimitiveMesh mesh = GeneratePrimitive(desc);
+        result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        result.vertexCount = mesh.vertices.size();
+        result.triangleCount = mesh.indices.size() / 3;
+        result.bytes = mesh.vertices.size() * sizeof(VertexNormalUV) + mesh.indices.size() * sizeof(uint32_t);
+        result.trianglesPerSecond = result.milliseconds > 0.0 ? result.triangleCount / (result.milliseconds / 1000.0) : 0.0;
+
+        for (const auto& vertex : mesh.vertices)
+        {
+            float radius = std::sqrt(vertex.x * vertex.x + vertex.y * vertex.y + vertex.z * vertex.z);
+            result.maxRadiusError = std::max(result.maxRadiusError, std::fabs(radius - c_sphereRadius) / c_sphereRadius);
+
+            // From the cross and dot products, as acos is too coarse near 1 to see errors this small
+            float cross[3] = { vertex.y * vertex.nz - vertex.z * vertex.ny, vertex.z * vertex.nx - vertex.x * vertex.nz,
+                vertex.x * vertex.ny - vertex.y * vertex.nx };
+            float sine = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+            float cosine = vertex.x * vertex.nx + vertex.y * vertex.ny + vertex.z * vertex.nz;
+            result.maxNormalErrorDegrees = std::max(result.maxNormalErrorDegrees, std::atan2(sine, cosine) * c_radiansToDegrees);
+        }
+
+        return result;
+    }
+}
+
+ProceduralGeometryBenchmarkResult RunProceduralGeometryBenchmark()
+{
+    ProceduralGeometryBenchmarkResult result;
+
+    for (auto slices : c_sphereSlices)
+    {
+        result.spheres.push_back(RunSphere(slices));
+    }
+
+    return result;
+}
+
+void ReportProceduralGeometryBenchmark(const ProceduralGeometryBenchmarkResult& result, std::ostream& out)
+{
+    out << "Procedural geometry benchmark\n";
+    for (const auto& sphere : result.spheres)
+    {
+        out << "  Sphere " << sphere.slices << "x" << sphere.stacks << ": " << sphere.vertexCount << " vertices, " << sphere.triangleCount
+            << " triangles (" << sphere.bytes / 1024 << " KB) in " << sphere.milliseconds << " ms (" << sphere.trianglesPerSecond / 1.0e6
+            << " M triangles/s), radius error " << sphere.maxRadiusError << ", normal error " << sphere.maxNormalErrorDegrees << " degrees\n";
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/// @brief Generating one sphere at a given tessellation
+struct ProceduralSphereResult
+{
+    uint32_t slices = 0;
+    uint32_t stacks = 0;
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    size_t bytes = 0;                   // vertices and 32 bit indices, before packing
+    double milliseconds = 0.0;
+    double trianglesPerSecond = 0.0;
+    float maxRadiusError = 0.0f;        // furthest a vertex is from the true sphere, relative to the radius
+    float maxNormalErrorDegrees = 0.0f; // largest angle between a normal and the direction from the centre
+};
+
+/// @brief The result of generating procedural spheres
+struct ProceduralGeometryBenchmarkResult
+{
+    std::vector<ProceduralSphereResult> spheres;
+};
+
+/// @brief Generate spheres from coarse to very finely tessellated, timing each and measuring how
+/// far they are from the true sphere. The checks every primitive has to pass are in
+/// SceneGraphTests. Doesn't touch the GPU.
+ProceduralGeometryBenchmarkResult RunProceduralGeometryBenchmark();
+
+/// @brief Write a line for each sphere
+void ReportProceduralGeometryBenchmark(const ProceduralGeometryBenchmarkResult& result, std::ostream& out);
@@ -0,0 +1,93 @@
+#include "RenderQueueBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include "RenderQueue.h"
+
+namespace
+{
+    constexpr size_t c_drawCount = 100000;
+    constexpr int c_iterations = 20;
+    constexpr uint32_t c_shaderCount = 8;
+    constexpr uint32_t c_materialCount = 64;
+    constexpr uint32_t c_geometryCount = 1024;
+
+    struct Draw
+    {
+        uint32_t shader;
+        uint32_t material;
+        uint32_t geometry;
+        float depth;
+    };
+}
+
+RenderQueueBenchmarkResult RunRenderQueueBenchmark()
+{
+    RenderQueueBenchmarkResult result;
+    result.drawCount = c_drawCount;
+
+    // Fixed seed, so every run sorts the same frame
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<uint32_t> shader(0, c_shaderCount - 1);
+    std::uniform_int_distribution<uint32_t> material(0, c_materialCount - 1);
+    std::uniform_int_distribution<uint32_t> geometry(0, c_geometryCount - 1);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+    std::vector<Draw> draws(c_drawCount);
+    for (auto& draw : draws)
+    {
+        draw = Draw{ shader(random), material(random), geometry(random), depth(random) };
+    }
+
+    RenderQueue queue;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        queue.Clear();
+        for (uint32_t index = 0; index < c_drawCount; index++)
+        {
+            const Draw& draw = draws[index];
+            queue.Submit(RenderQueue::MakeSortKey(draw.shader, draw.material, draw.geometry, draw.depth), index);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.keyMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+
+    const std::vector<DrawPacket> unsorted = queue.GetPackets();
+    result.unsortedStateChanges = RenderQueue::CountStateChanges(unsorted);
+
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> scratch;
+    start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        packets = unsorted;
+        RenderQueue::RadixSort(packets, scratch);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    result.radixSortMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+    result.sortedStateChanges = RenderQueue::CountStateChanges(packets);
+
+    std::vector<DrawPacket> stdPackets;
+    start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < c_iterations; iteration++)
+    {
+        stdPackets = unsorted;
+        std::sort(stdPackets.begin(), stdPackets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+    }
+    end = std::chrono::high_resolution_clock::now();
+    result.stdSortMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+
+    return result;
+}
+
+void ReportRenderQueueBenchmark(const RenderQueueBenchmarkResult& result, std::ostream& out)
+{
+    out << "Render queue benchmark, " << result.drawCount << " draws: keys " << result.keyMilliseconds << " ms, radix sort "
+        << result.radixSortMilliseconds << " ms, std::sort " << result.stdSortMilliseconds << " ms, state changes "
+        << result.unsortedStateChanges << " unsorted, " << result.sortedStateChanges << " sorted\n";
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+/// @brief The result of sorting a synthetic frame's worth of draws
+struct RenderQueueBenchmarkResult
+{
+    size_t drawCount = 0;
+    double keyMilliseconds = 0.0;        // average time to build the keys and fill the queue
+    double radixSortMilliseconds = 0.0;  // average time for RenderQueue's radix sort
+    double stdSortMilliseconds = 0.0;    // average time for std::sort on the same keys, for comparison
+    size_t unsortedStateChanges = 0;     // state changes needed to draw in submission order
+    size_t sortedStateChanges = 0;       // state changes needed to draw in sorted order
+};
+
+/// @brief Time building and sorting the keys for 100k draws spread over a handful of shaders,
+/// materials and vertex buffers, and count the state changes the sort saves. Doesn't touch the GPU.
+RenderQueueBenchmarkResult RunRenderQueueBenchmark();
+
+/// @brief Write the timings and state change counts on one line
+void ReportRenderQueueBenchmark(const RenderQueueBenchmarkResult& result, std::ostream& out);
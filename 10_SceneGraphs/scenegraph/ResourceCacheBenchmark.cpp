@@ -0,0 +1,125 @@
+#include "ResourceCacheBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <random>
+
+#include "ResourceCache.h"
+
+namespace
+{
+    constexpr size_t c_resourceCount = 2048;
+    constexpr uint32_t c_frameCount = 600;
+    constexpr uint32_t c_spawnsPerFrame = 64;
+    constexpr uint32_t c_maxLifetime = 120;     // frames a node lives at most
+
+    /// @brief Stands in for a loaded resource
+    struct FakeResource
+    {
+        uint64_t payload = 0;
+    };
+
+    /// @brief A resource in the pool the churn frames draw from
+    struct PoolEntry
+    {
+        ResourceType type;
+        std::string key;
+        uint64_t bytes;
+    };
+
+    /// @brief A scene node holding the resources it draws with until it goes
+    struct Node
+    {
+        uint32_t dies;
+        ResourceHandle handles[3];
+    };
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+ResourceCacheBenchmarkResult RunResourceCacheBenchmark()
+{
+    ResourceCacheBenchmarkResult result;
+
+    // Meshes, textures and shaders, a third each: big textures, middling meshes, small shaders
+    std::mt19937 random(1234);
+    std::vector<PoolEntry> pool;
+    for (size_t index = 0; index < c_resourceCount; index++)
+    {
+        switch (index % 3)
+        {
+        case 0: pool.push_back({ ResourceType::Mesh, MakeResourceKey("mesh" + std::to_string(index) + ".fbx", "normal,long"), 64 * 1024 + random() % (1024 * 1024) }); break;
+        case 1: pool.push_back({ ResourceType::Texture, MakeResourceKey("texture" + std::to_string(index) + ".png", "rgba8"), 256 * 1024u << (random() % 5) }); break;
+        default: pool.push_back({ ResourceType::Shader, MakeResourceKey("shader" + std::to_string(index) + ".hlsl", "layout=3"), 8 * 1024 }); break;
+        }
+        result.uniqueBytes += pool.back().bytes;
+    }
+    result.resourceCount = pool.size();
+
+    // A few resources are used everywhere and most rarely, as in a real level
+    std::geometric_distribution<size_t> pick(0.01);
+    std::uniform_int_distribution<uint32_t> lifetime(1, c_maxLifetime);
+
+    ResourceCache cache;
+    std::vector<Node> nodes;
+    double milliseconds = 0.0;
+    for (uint32_t frame = 0; frame < c_frameCount; frame++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        auto died = std::partition(nodes.begin(), nodes.end(), [frame](const Node& node) { return node.dies > frame; });
+        for (auto node = died; node != nodes.end(); ++node)
+        {
+            for (auto handle : node->handles)
+            {
+                cache.Release(handle);
+            }
+        }
+        nodes.erase(died, nodes.end());
+
+        for (uint32_t spawn = 0; spawn < c_spawnsPerFrame; spawn++)
+        {
+            Node node;
+            node.dies = frame + lifetime(random);
+            for (size_t slot = 0; slot < 3; slot++)
+            {
+                // Slot 0 takes a mesh, 1 a texture and 2 a shader
+                size_t index = (std::min(pick(random), c_resourceCount / 3 - 1)) * 3 + slot;
+                const auto& entry = pool[index];
+
+                auto handle = cache.Find(entry.type, entry.key);
+                if (!handle.IsValid())
+                {
+                    handle = cache.Insert(entry.type, entry.key, std::make_shared<FakeResource>(), entry.bytes);
+                    result.creates++;
+                }
+                node.handles[slot] = handle;
+                result.acquires++;
+            }
+            nodes.push_back(node);
+        }
+
+        result.destroyed += cache.EndFrame();
+        milliseconds += MillisecondsSince(start);
+
+        result.peakBytes = std::max(result.peakBytes, cache.GetReport().totalBytes);
+    }
+    result.frames = c_frameCount;
+    result.milliseconds = milliseconds;
+    result.acquiresPerSecond = result.acquires / (milliseconds / 1000.0);
+
+    return result;
+}
+
+void ReportResourceCacheBenchmark(const ResourceCacheBenchmarkResult& result, std::ostream& out)
+{
+    out << "Resource cache benchmark: " << result.acquires << " acquires over " << result.frames << " frames in " << result.milliseconds << " ms ("
+        << result.acquiresPerSecond / 1.0e6 << " M/s): " << result.creates << " loads for " << result.resourceCount
+        << " resources, " << result.destroyed << " destroyed\n";
+    out << "  Peak " << result.peakBytes / (1024 * 1024) << " MB held, of " << result.uniqueBytes / (1024 * 1024) << " MB for everything\n";
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+/// @brief The result of timing the resource cache under a level's worth of churn
+struct ResourceCacheBenchmarkResult
+{
+    size_t resourceCount = 0;           // distinct resources the frames draw from
+    uint32_t frames = 0;
+    size_t acquires = 0;                // over every frame
+    size_t creates = 0;                 // acquires that missed and had to make the resource
+    size_t destroyed = 0;               // resources the destroy delay let go
+    double milliseconds = 0.0;          // acquiring, releasing and ending frames, over every frame
+    double acquiresPerSecond = 0.0;
+    uint64_t peakBytes = 0;             // most bytes held at the end of any frame
+    uint64_t uniqueBytes = 0;           // what every resource would take if each was loaded once
+};
+
+/// @brief Run frames where scene nodes come and go, each acquiring a few of a pool of resources and
+/// releasing them when it goes, timing the cache and counting how often it had to load. The
+/// resources are plain memory, so nothing touches the GPU.
+ResourceCacheBenchmarkResult RunResourceCacheBenchmark();
+
+/// @brief Write the acquires and loads, then what was held at the peak
+void ReportResourceCacheBenchmark(const ResourceCacheBenchmarkResult& result, std::ostream& out);
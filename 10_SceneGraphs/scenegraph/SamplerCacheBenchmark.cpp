@@ -0,0 +1,219 @@
+#include "SamplerCacheBenchmark.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+#include "ResourceCache.h"
+#include "SamplerTable.h"
+#include "StateCache.h"
+
+namespace
+{
+    constexpr uint32_t c_distinctDescs = 64;
+    constexpr size_t c_lookups = 200000;
+
+    constexpr uint32_t c_frames = 100;
+    constexpr uint32_t c_drawsPerFrame = 2000;
+    constexpr uint32_t c_materials = 32;
+
+    constexpr uint32_t c_filterComparisonMinMagMipLinear = 0x95;    // D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR
+    constexpr uint32_t c_addressMirror = 2;                         // D3D11_TEXTURE_ADDRESS_MIRROR
+
+    // The hex keys are made of the key's bytes
+    static_assert(sizeof(SamplerKey) == 13 * sizeof(uint32_t), "a SamplerKey is its 13 fields and nothing else");
+
+    /// @brief Counts the sampler calls that get through the state cache, and drops everything
+    class CountingSink : public StateCommandSink
+    {
+    public:
+        void IASetPrimitiveTopology(uint32_t) override {}
+        void IASetInputLayout(ID3D11InputLayout*) override {}
+        void IASetVertexBuffer(uint32_t, ID3D11Buffer*, uint32_t, uint32_t) override {}
+        void IASetIndexBuffer(ID3D11Buffer*, uint32_t, uint32_t) override {}
+        void VSSetShader(ID3D11VertexShader*) override {}
+        void PSSetShader(ID3D11PixelShader*) override {}
+        void VSSetConstantBuffer(uint32_t, const ConstantBufferSlice&) override {}
+        void PSSetConstantBuffer(uint32_t, ID3D11Buffer*) override {}
+        void PSSetShaderResource(uint32_t, ID3D11ShaderResourceView*) override {}
+        void PSSetSampler(uint32_t, ID3D11SamplerState*) override { samplerCalls++; }
+        void DrawIndexed(uint32_t, uint32_t, int32_t) override {}
+        void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override {}
+
+        size_t samplerCalls = 0;
+    };
+
+    /// @brief Stand-ins for D3D objects; the state cache only compares the pointers
+    template <typename T>
+    T* FakeObject(std::vector<uint8_t>& storage, size_t index)
+    {
+        return reinterpret_cast<T*>(storage.data() + index);
+    }
+
+    /// @brief Descriptions that all make different samplers
+    std::vector<SamplerKey> MakeDistinctKeys(uint32_t count)
+    {
+        const uint32_t filters[] = { c_filterMinMagMipPoint, c_filterMinMagMipLinear, c_filterAnisotropic, c_filterComparisonMinMagMipLinear };
+        const uint32_t addresses[] = { c_addressWrap, c_addressMirror, c_addressClamp, c_addressBorder };
+
+        std::vector<SamplerKey> keys;
+        for (uint32_t index = 0; keys.size() < count; index++)
+        {
+            SamplerKey key;
+            key.filter = filters[index % 4];
+            key.addressU = key.addressV = addresses[(index / 4) % 4];
+            key.addressW = c_addressWrap;
+            key.mipLodBias = static_cast<float>(index / 16) * 0.5f;
+            if (key.filter == c_filterAnisotropic)
+                key.maxAnisotropy = 8;
+            if (key.filter == c_filterComparisonMinMagMipLinear)
+                key.comparisonFunc = c_comparisonLessEqual;
+            if (key.addressU == c_addressBorder)
+                key.borderColor[3] = 1.0f;
+            keys.push_back(key);
+        }
+        return keys;
+    }
+
+    /// @brief The same sampler as key, with whatever D3D ignores for it changed at random
+    SamplerKey AddNoise(SamplerKey key, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> colour(0.0f, 1.0f);
+        if (key.filter != c_filterComparisonMinMagMipLinear)
+            key.comparisonFunc = 1 + random() % 8;
+        if (key.filter != c_filterAnisotropic)
+            key.maxAnisotropy = random() % 17;
+        if (key.addressU != c_addressBorder)
+        {
+            for (float& channel : key.borderColor)
+                channel = colour(random);
+        }
+        if (key.mipLodBias == 0.0f && random() % 2 == 0)
+            key.mipLodBias = -0.0f;
+        return key;
+    }
+
+    /// @brief The key the ResourceManager used to cache a sampler under: its description as hex
+    std::string DescribeAsHex(const SamplerKey& key)
+    {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&key);
+        std::ostringstream hex;
+        hex << std::hex << std::setfill('0');
+        for (size_t index = 0; index < sizeof(key); index++)
+        {
+            hex << std::setw(2) << static_cast<unsigned>(bytes[index]);
+        }
+        return MakeResourceKey("sampler", hex.str());
+    }
+
+    /// @brief Draw a frame, each draw binding its material's texture and, before, its sampler
+    /// @return The sampler binds made
+    size_t DrawFrame(StateCache& stateCache, std::vector<uint8_t>& objects, bool staticSamplers)
+    {
+        size_t binds = 0;
+        stateCache.BeginFrame();
+        if (staticSamplers)
+        {
+            ID3D11SamplerState* samplers[c_staticSamplerCount];
+            for (uint32_t slot = 0; slot < c_staticSamplerCount; slot++)
+                samplers[slot] = FakeObject<ID3D11SamplerState>(objects, slot);
+            BindStaticSamplers(stateCache, samplers);
+            binds += c_staticSamplerCount;
+        }
+
+        // The render queue sorts the draws, so a material's draws come together
+        for (uint32_t draw = 0; draw < c_drawsPerFrame; draw++)
+        {
+            uint32_t material = draw * c_materials / c_drawsPerFrame;
+            stateCache.PSSetShaderResource(0, FakeObject<ID3D11ShaderResourceView>(objects, c_staticSamplerCount + c_materials + material));
+            if (!staticSamplers)
+            {
+                stateCache.PSSetSampler(0, FakeObject<ID3D11SamplerState>(objects, c_staticSamplerCount + material));
+                binds++;
+            }
+            stateCache.DrawIndexed(36, 0, 0);
+        }
+        return binds;
+    }
+    template <typename F>
+    double TimeNanosecondsPerLookup(size_t lookups, F&& run)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / lookups;
+    }
+}
+
+SamplerCacheBenchmarkResult RunSamplerCacheBenchmark()
+{
+    SamplerCacheBenchmarkResult result;
+
+    // Look the same few descriptions up again and again, as every texture load used to. The
+    // table is given them with their ignored fields changed; the hex keys aren't, as they would
+    // only have missed.
+    {
+        auto keys = MakeDistinctKeys(c_distinctDescs);
+        std::mt19937 random(4);
+        std::vector<SamplerKey> noisy;
+        std::vector<uint32_t> picks;
+        for (size_t lookup = 0; lookup < c_lookups; lookup++)
+        {
+            picks.push_back(random() % c_distinctDescs);
+            noisy.push_back(AddNoise(keys[picks.back()], random));
+        }
+
+        SamplerTable table;
+        result.hashedNanoseconds = TimeNanosecondsPerLookup(c_lookups, [&]()
+            {
+                for (const auto& key : noisy)
+                    table.Insert(key);
+            });
+
+        std::unordered_map<std::string, uint32_t> byHex;
+        result.stringNanoseconds = TimeNanosecondsPerLookup(c_lookups, [&]()
+            {
+                for (uint32_t pick : picks)
+                    byHex.emplace(DescribeAsHex(keys[pick]), static_cast<uint32_t>(byHex.size()));
+            });
+
+        result.lookups = c_lookups;
+        result.distinctSamplers = table.GetCount();
+    }
+
+    // A frame of draws binding a sampler each, against the static samplers bound once
+    {
+        std::vector<uint8_t> objects(c_staticSamplerCount + 2 * c_materials);
+        CountingSink before;
+        StateCache beforeCache(&before);
+        CountingSink after;
+        StateCache afterCache(&after);
+        for (uint32_t frame = 0; frame < c_frames; frame++)
+        {
+            result.samplerBindsBefore += DrawFrame(beforeCache, objects, false);
+            result.samplerBindsAfter += DrawFrame(afterCache, objects, true);
+        }
+
+        result.frames = c_frames;
+        result.drawsPerFrame = c_drawsPerFrame;
+        result.materials = c_materials;
+        result.samplerBindsBefore /= c_frames;
+        result.samplerBindsAfter /= c_frames;
+        result.samplerCallsBefore = before.samplerCalls / c_frames;
+        result.samplerCallsAfter = after.samplerCalls / c_frames;
+    }
+
+    return result;
+}
+
+void ReportSamplerCacheBenchmark(const SamplerCacheBenchmarkResult& result, std::ostream& out)
+{
+    out << "Sampler cache benchmark: " << result.lookups << " lookups of " << result.distinctSamplers << " samplers: " << result.hashedNanoseconds
+        << " ns each hashed, " << result.stringNanoseconds << " ns keyed as hex\n";
+    out << "  " << result.drawsPerFrame << " draws of " << result.materials << " materials a frame: " << result.samplerBindsBefore
+        << " sampler binds (" << result.samplerCallsBefore << " to the device) before, " << result.samplerBindsAfter << " ("
+        << result.samplerCallsAfter << ") with static samplers\n";
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+/// @brief The result of timing the sampler table against the way samplers were looked up and
+/// bound before
+struct SamplerCacheBenchmarkResult
+{
+    size_t lookups = 0;                     // descriptions looked up in each timed run
+    uint32_t distinctSamplers = 0;          // of those, different once normalized
+    double hashedNanoseconds = 0.0;         // per lookup, in the SamplerTable
+    double stringNanoseconds = 0.0;         // per lookup, keyed on the description as hex, as the ResourceManager did
+
+    uint32_t frames = 0;
+    uint32_t drawsPerFrame = 0;
+    uint32_t materials = 0;                 // the draws cycle through these
+    size_t samplerBindsBefore = 0;          // sampler binds made a frame, one for every draw
+    size_t samplerCallsBefore = 0;          // of those, ones that reached the device context
+    size_t samplerBindsAfter = 0;           // sampler binds made a frame, the static samplers once
+    size_t samplerCallsAfter = 0;
+};
+
+/// @brief Time looking descriptions up against keying them on their bytes as hex, and count the
+/// sampler binds of a frame of draws with a sampler per material and with the static samplers.
+SamplerCacheBenchmarkResult RunSamplerCacheBenchmark();
+
+/// @brief Write the lookup timings, then the binds of a frame before and after
+void ReportSamplerCacheBenchmark(const SamplerCacheBenchmarkResult& result, std::ostream& out);
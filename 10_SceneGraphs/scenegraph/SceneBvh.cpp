@@ -0,0 +1,130 @@
+#include "SceneBvh.h"
+
+#include <algorithm>
+#include <chrono>
+
+/// @brief Bring the tree up to date with the scene. Needs the world transforms of the scene graph
+/// to be up to date, and has to follow every update of them, as it only looks at the transforms
+/// the last update recomputed.
+/// @param sceneRoot Root of the scene graph
+void SceneBvh::Update(std::shared_ptr<SceneNode> sceneRoot)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto hierarchy = sceneRoot->GetTransformHierarchy();
+    uint64_t topologyVersion = hierarchy->GetTopologyVersion();
+    if (topologyVersion != m_topologyVersion)
+    {
+        m_nodes.clear();
+        m_bounds.clear();
+        m_geometry.clear();
+        m_primitiveOfTransform.clear();
+
+        std::unordered_map<RenderBase*, uint32_t> geometryIndex;
+        Gather(sceneRoot, geometryIndex);
+
+        m_bvh.Build(m_bounds);
+        m_topologyVersion = topologyVersion;
+
+        m_stats.rebuilt = true;
+        m_stats.nodesMoved = m_nodes.size();
+    }
+    else
+    {
+        m_changed.clear();
+        for (auto handle : hierarchy->GetRecomputed())
+        {
+            if (handle < m_primitiveOfTransform.size() && m_primitiveOfTransform[handle] != Bvh::InvalidIndex)
+                m_changed.push_back(m_primitiveOfTransform[handle]);
+        }
+
+        // Geometry that has finished loading since, in place of its placeholder
+        for (auto& geometry : m_geometry)
+        {
+            auto renderable = geometry.renderable.lock();
+            if (renderable != nullptr && renderable->GetBoundsVersion() != geometry.boundsVersion)
+            {
+                geometry.boundsVersion = renderable->GetBoundsVersion();
+                m_changed.insert(m_changed.end(), geometry.primitives.begin(), geometry.primitives.end());
+            }
+        }
+
+        if (!m_changed.empty())
+        {
+            std::sort(m_changed.begin(), m_changed.end());
+            m_changed.erase(std::unique(m_changed.begin(), m_changed.end()), m_changed.end());
+
+            for (auto index : m_changed)
+            {
+                m_bounds[index] = m_nodes[index]->UpdateWorldBounds();
+            }
+
+            // Geometry that had no bounds when the tree was built has no leaf yet, so that rebuilds
+            m_stats.rebuilt = m_bvh.Refit(m_bounds, m_changed);
+        }
+        else
+        {
+            m_stats.rebuilt = false;
+        }
+
+        m_stats.nodesMoved = m_changed.size();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    m_stats.primitiveCount = m_nodes.size();
+    m_stats.updateMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// @param geometryIndex Where each piece of geometry is in m_geometry
+void SceneBvh::Gather(const std::shared_ptr<SceneNode>& node, std::unordered_map<RenderBase*, uint32_t>& geometryIndex)
+{
+    if (auto renderable = node->GetRenderable())
+    {
+        auto primitive = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back(node);
+        m_bounds.push_back(node->UpdateWorldBounds());
+
+        auto handle = node->GetTransformHandle();
+        if (handle >= m_primitiveOfTransform.size())
+            m_primitiveOfTransform.resize(handle + 1, Bvh::InvalidIndex);
+        m_primitiveOfTransform[handle] = primitive;
+
+        auto inserted = geometryIndex.emplace(renderable.get(), static_cast<uint32_t>(m_geometry.size()));
+        if (inserted.second)
+            m_geometry.push_back(GeometryUsers{ renderable, renderable->GetBoundsVersion(), {} });
+        m_geometry[inserted.first->second].primitives.push_back(primitive);
+    }
+
+    for (const auto& child : node->GetChildren())
+    {
+        Gather(child, geometryIndex);
+    }
+}
+
+/// @brief Find every node that is at least partially inside the frustum
+/// @param visibleNodes Receives the nodes; cleared first
+void SceneBvh::QueryFrustum(const Frustum& frustum, std::vector<std::shared_ptr<SceneNode>>& visibleNodes) const
+{
+    visibleNodes.clear();
+
+    m_queryResults.clear();
+    m_bvh.QueryFrustum(frustum, m_queryResults);
+
+    for (uint32_t index : m_queryResults)
+    {
+        visibleNodes.push_back(m_nodes[index]);
+    }
+}
+
+/// @brief Find the node whose bounds a ray enters first
+/// @return The node, or nullptr if the ray doesn't hit anything
+std::shared_ptr<SceneNode> SceneBvh::Pick(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction) const
+{
+    float distance;
+    uint32_t index = m_bvh.Raycast(origin, direction, distance);
+    if (index == Bvh::InvalidIndex)
+        return nullptr;
+
+    return m_nodes[index];
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Bvh.h"
+#include "SceneNode.h"
+
+/// @brief Timing and size information about the last call to SceneBvh::Update
+struct SceneBvhStats
+{
+    size_t primitiveCount = 0;
+    size_t nodesMoved = 0;
+    bool rebuilt = false;
+    double updateMilliseconds = 0.0;
+};
+
+/// @brief A Bvh over the world bounds of every SceneNode with a renderable.
+///
+/// The tree is rebuilt when the topology of the scene graph changes, a node's renderable included,
+/// and otherwise refitted around just the nodes whose bounds moved since the last update: those
+/// whose transform the hierarchy recomputed, and those whose geometry's local bounds changed.
+/// Nodes with empty bounds stay out of the tree until they have some. The world bounds of the
+/// nodes are kept up to date here, so nothing else has to walk the scene graph for them.
+class SceneBvh
+{
+public:
+    SceneBvh() = default;
+
+    void Update(std::shared_ptr<SceneNode> sceneRoot);
+
+    void QueryFrustum(const Frustum& frustum, std::vector<std::shared_ptr<SceneNode>>& visibleNodes) const;
+    std::shared_ptr<SceneNode> Pick(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction) const;
+
+    const SceneBvhStats& GetStats() const { return m_stats; }
+
+private:
+    /// @brief The nodes drawing one piece of geometry, to refit when its local bounds change
+    struct GeometryUsers
+    {
+        std::weak_ptr<RenderBase> renderable;
+        uint64_t boundsVersion = 0;
+        std::vector<uint32_t> primitives;
+    };
+
+    void Gather(const std::shared_ptr<SceneNode>& node, std::unordered_map<RenderBase*, uint32_t>& geometryIndex);
+
+    Bvh m_bvh;
+    std::vector<std::shared_ptr<SceneNode>> m_nodes;
+    std::vector<Bounds> m_bounds;
+    std::vector<uint32_t> m_primitiveOfTransform;   // by transform handle; Bvh::InvalidIndex for nodes with nothing to draw
+    std::vector<GeometryUsers> m_geometry;
+    std::vector<uint32_t> m_changed;
+    mutable std::vector<uint32_t> m_queryResults; // Scratch space for QueryFrustum
+
+    uint64_t m_topologyVersion = UINT64_MAX;
+
+    SceneBvhStats m_stats;
+};
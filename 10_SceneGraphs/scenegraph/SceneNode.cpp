@@ -1,118 +1,165 @@
 #include "SceneNode.h"
 
-#include "mathutils.h"
+#include <algorithm>
+#include <cmath>
+
+SceneNode::SceneNode(std::shared_ptr<TransformHierarchy> transformHierarchy)
+    : hierarchy(transformHierarchy)
+{
+    transform = hierarchy->Create();
+}
 
 SceneNode::~SceneNode()
 {
+    hierarchy->Destroy(transform);
 }
 
+/// @brief Set what the node draws, and with which shader. A change of renderable changes which
+/// nodes the scene BVH holds, so it bumps the hierarchy's topology version.
 void SceneNode::SetRenderable(std::weak_ptr<RenderBase> renderable, std::weak_ptr<Shader> shaderPtr)
 {
+    if (renderNode.lock() != renderable.lock())
+        hierarchy->TouchTopology();
+
     renderNode = renderable;
     shader = shaderPtr;
 }
 
 void SceneNode::SetLocalTransform(const DirectX::XMMATRIX& local)
 {
-    localTransform = local;
+    hierarchy->SetLocalTransform(transform, local);
 }
 
-void SceneNode::AddChild(std::shared_ptr<SceneNode> child)
+/// @brief Attach a node below this one
+/// @return false, leaving both nodes as they were, if this node is the child or one of its descendants
+bool SceneNode::AddChild(std::shared_ptr<SceneNode> child)
 {
+    if (!hierarchy->SetParent(child->transform, transform))
+        return false;
+
     children.push_back(child);
     child->parent = weak_from_this();
+    return true;
+}
+
+/// @brief Detach every child from this node. Detaching changes the hierarchy's topology, so the
+/// scene BVH lets go of the children on its next update even while something else holds on to them.
+void SceneNode::RemoveChildren()
+{
+    for (auto& child : children)
+    {
+        child->parent.reset();
+        hierarchy->SetParent(child->transform, TransformHierarchy::InvalidHandle);
+    }
+
+    children.clear();
 }
 
 void SceneNode::SetLocalRotation(float yaw,float pitch,float roll)
 {
-    rotation.m128_f32[0] = yaw;
-    rotation.m128_f32[1] = pitch;
-    rotation.m128_f32[2] = roll;
+    hierarchy->SetLocalRotation(transform, yaw, pitch, roll);
+}
+
+void SceneNode::SetLocalRotationQuat(const DirectX::XMFLOAT4& rotation)
+{
+    hierarchy->SetLocalRotationQuat(transform, rotation);
 }
 
 void SceneNode::SetLocalTranslation(float x,float y,float z)
 {
-    translation.m128_f32[0] = x;
-    translation.m128_f32[1] = y;
-    translation.m128_f32[2] = z;
+    hierarchy->SetLocalTranslation(transform, x, y, z);
 }
 
 void SceneNode::SetLocalScale(float x,float y,float z)
 {
-    scale.m128_f32[0] = x;
-    scale.m128_f32[1] = y;
-    scale.m128_f32[2] = z;
+    hierarchy->SetLocalScale(transform, x, y, z);
 }
 
 std::array<float, 3> SceneNode::GetLocalRotation()
 {
-    return { rotation.m128_f32[0], rotation.m128_f32[1], rotation.m128_f32[2] };
+    auto rotation = hierarchy->GetLocalRotation(transform);
+    return { rotation.x, rotation.y, rotation.z };
+}
+
+DirectX::XMFLOAT4 SceneNode::GetLocalRotationQuat()
+{
+    return hierarchy->GetLocalRotationQuat(transform);
 }
 
 std::array<float, 3> SceneNode::GetLocalTranslation()
 {
-    return { translation.m128_f32[0], translation.m128_f32[1], translation.m128_f32[2] };
+    auto translation = hierarchy->GetLocalTranslation(transform);
+    return { translation.x, translation.y, translation.z };
 }
 
 std::array<float, 3> SceneNode::GetLocalScale()
 {
-    return { scale.m128_f32[0], scale.m128_f32[1], scale.m128_f32[2] };
+    auto scale = hierarchy->GetLocalScale(transform);
+    return { scale.x, scale.y, scale.z };
 }
 
 std::array<float,3> SceneNode::GetWorldRotationQuat()
 {
-    return { worldRotationQuat.m128_f32[0], worldRotationQuat.m128_f32[1], worldRotationQuat.m128_f32[2] };
+    auto worldRotationQuat = hierarchy->GetWorldRotationQuat(transform);
+    return { worldRotationQuat.x, worldRotationQuat.y, worldRotationQuat.z };
 }
 
 std::array<float,3> SceneNode::GetWorldTranslation()
 {
-    return { worldTranslation.m128_f32[0], worldTranslation.m128_f32[1], worldTranslation.m128_f32[2] };
+    auto worldTranslation = hierarchy->GetWorldTranslation(transform);
+    return { worldTranslation.x, worldTranslation.y, worldTranslation.z };
 }
 
 std::array<float,3> SceneNode::GetWorldScale()
 {
-    return { worldScale.m128_f32[0], worldScale.m128_f32[1], worldScale.m128_f32[2] };
+    auto worldScale = hierarchy->GetWorldScale(transform);
+    return { worldScale.x, worldScale.y, worldScale.z };
 }
 
+/// @brief Update the world transforms. As all the transforms live in the shared hierarchy, this
+/// only needs to be called on the root; every node in the hierarchy is updated in one pass. The
+/// world bounds follow in SceneBvh::Update, for just the nodes that moved.
 void SceneNode::Update(double deltatime)
 {
-    // update localTransform
-    localTransform = DirectX::XMMatrixScaling(scale.m128_f32[0], scale.m128_f32[1], scale.m128_f32[2]) *
-    DirectX::XMMatrixRotationY(degreesToRadians(rotation.m128_f32[1])) *
-    DirectX::XMMatrixRotationX(degreesToRadians(rotation.m128_f32[0])) *
-    DirectX::XMMatrixRotationZ(degreesToRadians(rotation.m128_f32[2])) *
-    DirectX::XMMatrixTranslation(translation.m128_f32[0], translation.m128_f32[1], translation.m128_f32[2]);
-
-    if (auto parentPtr = parent.lock())
-    {
-        worldTransform = DirectX::XMMatrixMultiply(parentPtr->worldTransform, localTransform);
-    }
-    else
-    {
-        worldTransform = localTransform;
-    }
-
-    DirectX::XMMatrixDecompose(&worldScale, &worldRotationQuat, &worldTranslation, worldTransform);
-
-    for (auto& child : children)
-    {
-        child->Update(deltatime);
-    }
+    hierarchy->Update();
 }
 
-void SceneNode::Draw(ID3D11DeviceContext* pD3DContext)
+/// @brief Move the local bounds of this node's renderable into world space. Needs an up to date
+/// world transform.
+const Bounds& SceneNode::UpdateWorldBounds()
 {
+    worldBounds = Bounds();
     if (auto sharedPtr = renderNode.lock())
-    {
-        if (auto shaderPtr = shader.lock())
-        {
-            sharedPtr->Draw(pD3DContext, shaderPtr, worldTransform);
-        }
-    }
+        worldBounds = TransformBounds(sharedPtr->GetLocalBounds(), hierarchy->GetWorldTransform(transform));
+    return worldBounds;
+}
 
-    for (auto& child : children)
+/// @brief Add this node's renderable to a render queue, keyed on the state it needs and its depth.
+/// Materials are keyed on the texture they bind, so those sharing a texture array sort together.
+/// @param queue The queue to add to
+/// @param viewProjection The camera's view projection, to find the depth of the node
+/// @param item Index the caller uses to find this node again when submitting the queue
+/// @param lodView Where the camera is, to pick the level of detail from; nullptr draws the full geometry
+void SceneNode::Submit(RenderQueue& queue, const DirectX::XMMATRIX& viewProjection, uint32_t item, const LodView* lodView)
+{
+    auto sharedPtr = renderNode.lock();
+    auto shaderPtr = shader.lock();
+    if (!sharedPtr || !shaderPtr)
+        return;
+
+    // The w of the clip space position is the distance along the view direction
+    DirectX::XMVECTOR center = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&worldBounds.center), viewProjection);
+    float depth = DirectX::XMVectorGetW(center);
+
+    lod = 0;
+    if (lodView != nullptr && sharedPtr->GetLodCount() > 1)
     {
-        child->Draw(pD3DContext);
+        // The errors are in local space; the largest scale is the most any of them can grow by
+        auto scale = hierarchy->GetWorldScale(transform);
+        float worldScale = std::max(std::max(std::fabs(scale.x), std::fabs(scale.y)), std::fabs(scale.z));
+        lod = SelectLod(*lodView, &worldBounds.center.x, worldBounds.radius, worldScale, sharedPtr->GetLodErrors(), sharedPtr->GetLodCount());
     }
 
+    auto material = sharedPtr->GetMaterial();
+    queue.Submit(shaderPtr.get(), material != nullptr ? material->GetStateKey() : nullptr, sharedPtr.get(), depth, item, lod);
 }
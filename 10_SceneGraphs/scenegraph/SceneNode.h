@@ -5,24 +5,33 @@
 #include <array>
 #include <vector>
 
+#include "Culling.h"
+#include "LodSelection.h"
 #include "RenderBase.h"
+#include "RenderQueue.h"
 #include "Shader.h"
+#include "TransformHierarchy.h"
 
+/// @brief A node in the scene graph. The transform data for the node lives in a shared
+/// TransformHierarchy; the node itself only holds a handle into it.
 class SceneNode : public std::enable_shared_from_this<SceneNode>
 {
 public:
-    SceneNode() = default;
+    explicit SceneNode(std::shared_ptr<TransformHierarchy> transformHierarchy);
     ~SceneNode();
 
     void SetRenderable(std::weak_ptr<RenderBase> renderable, std::weak_ptr<Shader> shaderPtr);
-    void AddChild(std::shared_ptr<SceneNode> child);
+    bool AddChild(std::shared_ptr<SceneNode> child);
+    void RemoveChildren();
     void SetLocalTransform(const DirectX::XMMATRIX& local);
 
     void SetLocalRotation(float yaw, float pitch, float roll);
+    void SetLocalRotationQuat(const DirectX::XMFLOAT4& rotation);
     void SetLocalTranslation(float x, float y, float z);
     void SetLocalScale(float x, float y, float z);
 
     std::array<float, 3> GetLocalRotation();
+    DirectX::XMFLOAT4 GetLocalRotationQuat();
     std::array<float, 3> GetLocalTranslation();
     std::array<float, 3> GetLocalScale();
 
@@ -30,14 +39,43 @@ public:
     std::array<float, 3> GetWorldTranslation();
     std::array<float, 3> GetWorldScale();
 
-    std::vector<std::shared_ptr<SceneNode>> GetChildren()
+    const std::vector<std::shared_ptr<SceneNode>>& GetChildren() const
     {
         return children;
     }
 
+    std::shared_ptr<TransformHierarchy> GetTransformHierarchy()
+    {
+        return hierarchy;
+    }
+
+    std::shared_ptr<RenderBase> GetRenderable()
+    {
+        return renderNode.lock();
+    }
+
+    std::shared_ptr<Shader> GetShader()
+    {
+        return shader.lock();
+    }
+
+    DirectX::XMMATRIX GetWorldTransform()
+    {
+        return hierarchy->GetWorldTransform(transform);
+    }
+
+    TransformHierarchy::Handle GetTransformHandle() const { return transform; }
+
+    /// @brief World space bounds of this node's renderable, as of the last UpdateWorldBounds
+    const Bounds& GetWorldBounds() const { return worldBounds; }
+
     virtual void Update(double deltatime);
+    const Bounds& UpdateWorldBounds();
 
-    virtual void Draw(ID3D11DeviceContext* pD3DContext);
+    void Submit(RenderQueue& queue, const DirectX::XMMATRIX& viewProjection, uint32_t item, const LodView* lodView = nullptr);
+
+    /// @brief The level of detail picked the last time the node was submitted
+    uint32_t GetLod() const { return lod; }
 
     std::string name;
 
@@ -45,17 +83,12 @@ protected:
     std::weak_ptr<SceneNode> parent;
     std::vector<std::shared_ptr<SceneNode>> children;
 
-    DirectX::XMVECTOR rotation = {0.0f, 0.0f, 0.0f};
-    DirectX::XMVECTOR translation = {0.0f, 0.0f, 0.0f};
-    DirectX::XMVECTOR scale = {1.0f, 1.0f, 1.0f};
-
-    DirectX::XMVECTOR worldRotationQuat;
-    DirectX::XMVECTOR worldTranslation;
-    DirectX::XMVECTOR worldScale;
-
-    DirectX::XMMATRIX localTransform;
-    DirectX::XMMATRIX worldTransform;
+    std::shared_ptr<TransformHierarchy> hierarchy;
+    TransformHierarchy::Handle transform = TransformHierarchy::InvalidHandle;
 
     std::weak_ptr<RenderBase> renderNode;
     std::weak_ptr<Shader> shader;
-};
\ No newline at end of file
+
+    Bounds worldBounds;
+    uint32_t lod = 0;
+};
@@ -0,0 +1,249 @@
+#include "SubmeshBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+
+#include "MeshImport.h"
+#include "StateCache.h"
+
+namespace
+{
+    constexpr uint32_t c_gridQuads = 200;           // 40401 vertices, 80000 triangles
+    constexpr uint32_t c_materials = 6;
+    constexpr uint32_t c_frames = 10;
+    constexpr uint32_t c_meshesPerFrame = 200;
+
+    constexpr uint32_t c_formatR16Uint = 57;        // DXGI_FORMAT_R16_UINT
+    constexpr uint32_t c_formatR32Uint = 42;        // DXGI_FORMAT_R32_UINT
+    constexpr size_t c_oldMeshConstantBytes = 3 * 16;       // MeshConstantBuffer before it had the material slice
+    constexpr size_t c_submeshConstantBytes = 256;          // a MeshConstantBuffer per ConstantBufferRing::SliceAlignment
+    constexpr size_t c_meshConstantBytes = 4 * 16;
+    constexpr size_t c_bakedColourBytes = 4 * sizeof(float);
+
+    /// @brief Counts the vertex and index buffer binds and draws that get through the state cache,
+    /// and drops everything
+    class CountingSink : public StateCommandSink
+    {
+    public:
+        void IASetPrimitiveTopology(uint32_t) override {}
+        void IASetInputLayout(ID3D11InputLayout*) override {}
+        void IASetVertexBuffer(uint32_t, ID3D11Buffer*, uint32_t, uint32_t) override { bufferCalls++; }
+        void IASetIndexBuffer(ID3D11Buffer*, uint32_t, uint32_t) override { bufferCalls++; }
+        void VSSetShader(ID3D11VertexShader*) override {}
+        void PSSetShader(ID3D11PixelShader*) override {}
+        void VSSetConstantBuffer(uint32_t, const ConstantBufferSlice&) override {}
+        void PSSetConstantBuffer(uint32_t, ID3D11Buffer*) override {}
+        void PSSetShaderResource(uint32_t, ID3D11ShaderResourceView*) override {}
+        void PSSetSampler(uint32_t, ID3D11SamplerState*) override {}
+        void DrawIndexed(uint32_t, uint32_t, int32_t) override { drawCalls++; }
+        void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override { drawCalls++; }
+
+        size_t bufferCalls = 0;
+        size_t drawCalls = 0;
+    };
+
+    /// @brief Stand-ins for D3D objects; the state cache only compares the pointers
+    template <typename T>
+    T* FakeObject(std::vector<uint8_t>& storage, size_t index)
+    {
+        return reinterpret_cast<T*>(storage.data() + index);
+    }
+
+    /// @brief A flat grid of quads whose materials run in bands across it, the way a model made of
+    /// several meshes arrives once ImportMesh has merged them
+    struct MaterialGrid
+    {
+        std::vector<VertexNormalUV> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+    };
+
+    /// @param bandEnds The column each material's band ends before, in order
+    MaterialGrid MakeMaterialGrid(uint32_t quads, const std::vector<uint32_t>& bandEnds)
+    {
+        MaterialGrid grid;
+        uint32_t gridVertices = quads + 1;
+        for (uint32_t row = 0; row < gridVertices; row++)
+        {
+            for (uint32_t column = 0; column < gridVertices; column++)
+            {
+                float u = static_cast<float>(column) / quads;
+                float v = static_cast<float>(row) / quads;
+                grid.vertices.push_back(VertexNormalUV{ static_cast<float>(column), 0.0f, static_cast<float>(row), 0.0f, 1.0f, 0.0f, u, v });
+            }
+        }
+
+        for (uint32_t row = 0; row < quads; row++)
+        {
+            for (uint32_t column = 0; column < quads; column++)
+            {
+                auto band = std::upper_bound(bandEnds.begin(), bandEnds.end(), column);
+                auto material = static_cast<uint32_t>(std::min<size_t>(band - bandEnds.begin(), bandEnds.size() - 1));
+
+                uint32_t corner = row * gridVertices + column;
+                const uint32_t quad[] = { corner, corner + gridVertices, corner + 1, corner + 1, corner + gridVertices, corner + gridVertices + 1 };
+                grid.indices.insert(grid.indices.end(), std::begin(quad), std::end(quad));
+                grid.triangleMaterials.push_back(material);
+                grid.triangleMaterials.push_back(material);
+            }
+        }
+        return grid;
+    }
+
+    /// @brief Bands of equal width, one per material
+    std::vector<uint32_t> EqualBands(uint32_t quads, uint32_t materials)
+    {
+        std::vector<uint32_t> bandEnds;
+        for (uint32_t material = 1; material <= materials; material++)
+        {
+            bandEnds.push_back(quads * material / materials);
+        }
+        return bandEnds;
+    }
+
+    /// @brief Materials that can be told apart by their colour
+    std::vector<ImportedMaterial> MakeMaterials(uint32_t count)
+    {
+        std::vector<ImportedMaterial> materials(count);
+        for (uint32_t index = 0; index < count; index++)
+        {
+            materials[index].diffuse[0] = 0.1f * index;
+            materials[index].diffuse[1] = 1.0f - 0.1f * index;
+            materials[index].diffuse[2] = 0.5f;
+            materials[index].diffuseTexture = "texture" + std::to_string(index) + ".png";
+        }
+        return materials;
+    }
+
+    ImportedMesh PrepareGrid(const MaterialGrid& grid, uint32_t materials, LargeMeshMode mode)
+    {
+        ImportedMesh mesh;
+        mesh.materials = MakeMaterials(materials);
+        PrepareImportedMesh(grid.vertices, grid.indices, grid.triangleMaterials, mode, mesh);
+        return mesh;
+    }
+
+    /// @brief The grid as it was prepared before submeshes: a renderable per material, or per
+    /// cluster of a material that was split
+    std::vector<RenderableData> PrepareGridBefore(const MaterialGrid& grid, uint32_t materials)
+    {
+        auto imported = MakeMaterials(materials);
+        std::vector<RenderableData> renderables;
+        for (auto& part : SplitByMaterial(grid.indices, grid.vertices.size(), grid.triangleMaterials))
+        {
+            auto partVertices = GatherVertices(part.vertices, grid.vertices);
+            OptimizeMesh(partVertices, part.indices);
+            renderables.push_back(PrepareRenderable(partVertices, part.indices, imported[part.materialIndex].diffuse));
+        }
+        return renderables;
+    }
+
+    /// @brief The range of the finest level of a submesh, from the start of the index buffer
+    LodLevel GetFinestLevel(const SubmeshData& submesh)
+    {
+        if (submesh.lods.empty())
+            return LodLevel{ submesh.firstIndex, submesh.indexCount, 0.0f };
+        return LodLevel{ submesh.firstIndex + submesh.lods[0].firstIndex, submesh.lods[0].indexCount, 0.0f };
+    }
+
+    /// @brief Count a frame's buffer binds and draws, drawing copies of a mesh one after another
+    /// the way Renderable does: each submesh binds its buffers and its constants, then draws
+    /// @param renderables Each with a vertex, index and constant buffer of its own
+    /// @param submeshConstants Whether the constant buffer holds every submesh's constants, or
+    /// each renderable is a single submesh
+    void DrawFrames(const std::vector<RenderableData>& renderables, bool submeshConstants, size_t& bufferBinds, size_t& draws)
+    {
+        std::vector<uint8_t> objects(renderables.size() * 3);
+
+        CountingSink sink;
+        StateCache stateCache(&sink);
+        for (uint32_t frame = 0; frame < c_frames; frame++)
+        {
+            stateCache.BeginFrame();
+            for (uint32_t mesh = 0; mesh < c_meshesPerFrame; mesh++)
+            {
+                for (size_t renderable = 0; renderable < renderables.size(); renderable++)
+                {
+                    const auto& data = renderables[renderable];
+                    auto vertexBuffer = FakeObject<ID3D11Buffer>(objects, renderable * 3);
+                    auto indexBuffer = FakeObject<ID3D11Buffer>(objects, renderable * 3 + 1);
+                    auto constants = FakeObject<ID3D11Buffer>(objects, renderable * 3 + 2);
+                    uint32_t indexFormat = data.indexSize == sizeof(uint32_t) ? c_formatR32Uint : c_formatR16Uint;
+
+                    for (uint32_t submesh = 0; submesh < data.submeshes.size(); submesh++)
+                    {
+                        constexpr uint32_t constantsPerSubmesh = c_submeshConstantBytes / 16;
+                        if (submeshConstants && data.submeshes.size() > 1)
+                            stateCache.VSSetConstantBuffer(2, ConstantBufferSlice{ constants, submesh * constantsPerSubmesh, constantsPerSubmesh });
+                        else
+                            stateCache.VSSetConstantBuffer(2, constants);
+                        stateCache.IASetVertexBuffer(0, vertexBuffer, data.vertexStride, 0);
+                        stateCache.IASetIndexBuffer(indexBuffer, indexFormat, 0);
+
+                        const auto& range = data.submeshes[submesh];
+                        stateCache.DrawIndexed(range.indexCount, range.firstIndex, static_cast<int32_t>(range.firstVertex));
+                    }
+                }
+            }
+        }
+
+        bufferBinds = sink.bufferCalls / c_frames;
+        draws = sink.drawCalls / c_frames;
+    }
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+SubmeshBenchmarkResult RunSubmeshBenchmark()
+{
+    SubmeshBenchmarkResult result;
+
+    auto grid = MakeMaterialGrid(c_gridQuads, EqualBands(c_gridQuads, c_materials));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto before = PrepareGridBefore(grid, c_materials);
+    result.prepareBeforeMilliseconds = MillisecondsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    auto mesh = PrepareGrid(grid, c_materials, LargeMeshMode::LongIndices);
+    result.prepareMilliseconds = MillisecondsSince(start);
+
+    const auto& data = mesh.renderable;
+    result.materials = static_cast<uint32_t>(data.materials.size());
+    result.submeshes = static_cast<uint32_t>(data.submeshes.size());
+    result.vertexCount = data.vertexCount;
+    for (const auto& submesh : data.submeshes)
+    {
+        result.triangleCount += GetFinestLevel(submesh).indexCount / 3;
+    }
+
+    result.buffersBefore = static_cast<uint32_t>(before.size() * 3);
+    result.buffersAfter = 3;
+    for (const auto& renderable : before)
+    {
+        result.gpuBytesBefore += renderable.vertices.size() + renderable.indices.size() + c_oldMeshConstantBytes;
+    }
+    result.gpuBytesAfter = data.vertices.size() + data.indices.size() + (data.submeshes.size() - 1) * c_submeshConstantBytes + c_meshConstantBytes;
+    result.bakedColourBytes = static_cast<size_t>(data.vertexCount) * c_bakedColourBytes;
+
+    result.frames = c_frames;
+    result.meshesPerFrame = c_meshesPerFrame;
+    DrawFrames(before, false, result.bufferBindsBefore, result.drawsBefore);
+    DrawFrames({ data }, true, result.bufferBindsAfter, result.drawsAfter);
+
+    return result;
+}
+
+void ReportSubmeshBenchmark(const SubmeshBenchmarkResult& result, std::ostream& out)
+{
+    out << "Submesh benchmark: " << result.materials << " materials, " << result.submeshes << " submeshes, " << result.vertexCount << " vertices, "
+        << result.triangleCount << " triangles: prepared in " << result.prepareMilliseconds << " ms vs " << result.prepareBeforeMilliseconds
+        << " ms a renderable per material; " << result.buffersAfter << " buffers (" << result.gpuBytesAfter / 1024 << " KB) vs "
+        << result.buffersBefore << " (" << result.gpuBytesBefore / 1024 << " KB), " << result.bakedColourBytes / 1024
+        << " KB of baked colour avoided; buffer binds a frame of " << result.meshesPerFrame << " meshes " << result.bufferBindsAfter
+        << " vs " << result.bufferBindsBefore << ", draws " << result.drawsAfter << " vs " << result.drawsBefore << "\n";
+}
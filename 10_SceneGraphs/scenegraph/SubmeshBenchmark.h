@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+/// @brief The result of comparing a mesh with several materials prepared as one renderable of
+/// submeshes with a renderable per material, as it was prepared before
+struct SubmeshBenchmarkResult
+{
+    uint32_t materials = 0;                 // of the timed mesh
+    uint32_t submeshes = 0;
+    size_t vertexCount = 0;                 // packed, over every submesh
+    size_t triangleCount = 0;               // at the finest level of detail
+    double prepareMilliseconds = 0.0;       // preparing it as one renderable
+    double prepareBeforeMilliseconds = 0.0; // preparing a renderable per material
+
+    uint32_t buffersBefore = 0;             // vertex, index and constant buffers, a set per material
+    uint32_t buffersAfter = 0;              // one of each
+    size_t gpuBytesBefore = 0;              // in those buffers
+    size_t gpuBytesAfter = 0;
+    size_t bakedColourBytes = 0;            // a float4 colour in every vertex, as the mesh was drawn before the colour moved to constants
+
+    uint32_t frames = 0;
+    uint32_t meshesPerFrame = 0;            // copies of the mesh drawn one after another
+    size_t bufferBindsBefore = 0;           // vertex and index buffer binds that reached the device context a frame
+    size_t bufferBindsAfter = 0;
+    size_t drawsBefore = 0;                 // draw calls a frame; the same either way
+    size_t drawsAfter = 0;
+};
+
+/// @brief Time preparing a mesh with several materials as one renderable of submeshes, and count
+/// the buffers, bytes and binds of drawing it against a renderable per material. Doesn't touch the
+/// GPU.
+SubmeshBenchmarkResult RunSubmeshBenchmark();
+
+/// @brief Write the comparison on one line
+void ReportSubmeshBenchmark(const SubmeshBenchmarkResult& result, std::ostream& out);
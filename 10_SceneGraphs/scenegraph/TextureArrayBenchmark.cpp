@@ -0,0 +1,254 @@
+#include "TextureArrayBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <set>
+#include <tuple>
+
+#include "CookedTexture.h"
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+#include "StateCache.h"
+#include "TextureArrayPlanner.h"
+#include "TextureMips.h"
+
+namespace
+{
+    constexpr uint32_t c_packedTextures = 600;
+    constexpr uint32_t c_placeRepeats = 200;
+
+    constexpr uint32_t c_drawsPerFrame = 5000;
+    constexpr uint32_t c_geometries = 50;
+    constexpr uint32_t c_variants = 6;
+    constexpr uint32_t c_frameTextures = c_geometries * c_variants;
+
+    /// @brief Counts the texture binds and draws that get through the state cache, and drops
+    /// everything else
+    class CountingSink : public StateCommandSink
+    {
+    public:
+        void IASetPrimitiveTopology(uint32_t) override {}
+        void IASetInputLayout(ID3D11InputLayout*) override {}
+        void IASetVertexBuffer(uint32_t, ID3D11Buffer*, uint32_t, uint32_t) override {}
+        void IASetIndexBuffer(ID3D11Buffer*, uint32_t, uint32_t) override {}
+        void VSSetShader(ID3D11VertexShader*) override {}
+        void PSSetShader(ID3D11PixelShader*) override {}
+        void VSSetConstantBuffer(uint32_t, const ConstantBufferSlice&) override {}
+        void PSSetConstantBuffer(uint32_t, ID3D11Buffer*) override {}
+        void PSSetShaderResource(uint32_t, ID3D11ShaderResourceView*) override { textureCalls++; }
+        void PSSetSampler(uint32_t, ID3D11SamplerState*) override {}
+        void DrawIndexed(uint32_t, uint32_t, int32_t) override { drawCalls++; }
+        void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override { drawCalls++; }
+
+        size_t textureCalls = 0;
+        size_t drawCalls = 0;
+    };
+
+    /// @brief Stand-ins for D3D objects; the state cache only compares the pointers
+    template <typename T>
+    T* FakeObject(std::vector<uint8_t>& storage, size_t index)
+    {
+        return reinterpret_cast<T*>(storage.data() + index);
+    }
+
+    /// @brief The shape of a texture with its whole mip chain, as the cooker writes it
+    TextureShape MakeShape(uint32_t width, uint32_t height, CookedTextureFormat format, uint32_t mipCount = 0)
+    {
+        TextureShape shape;
+        shape.width = width;
+        shape.height = height;
+        shape.format = static_cast<uint32_t>(format);
+        shape.mipCount = mipCount != 0 ? mipCount : GetMipCount(width, height);
+
+        for (uint32_t level = 0; level < shape.mipCount; level++)
+        {
+            shape.sliceBytes += GetCookedLevelSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+        }
+        return shape;
+    }
+
+    /// @brief Textures as a scene might have them: mostly block compressed, a few sizes, the odd
+    /// one that isn't square
+    std::vector<TextureShape> MakeTextureMix(uint32_t count, uint32_t seed)
+    {
+        const TextureShape shapes[] = {
+            MakeShape(512, 512, CookedTextureFormat::BC1),
+            MakeShape(1024, 1024, CookedTextureFormat::BC1),
+            MakeShape(1024, 1024, CookedTextureFormat::BC3),
+            MakeShape(2048, 2048, CookedTextureFormat::BC7),
+            MakeShape(256, 256, CookedTextureFormat::RGBA8),
+            MakeShape(512, 256, CookedTextureFormat::RGBA8),
+        };
+        const uint32_t weights[] = { 30, 30, 15, 5, 15, 5 };
+
+        std::mt19937 random(seed);
+        std::discrete_distribution<uint32_t> pick(std::begin(weights), std::end(weights));
+        std::vector<TextureShape> mix;
+        for (uint32_t index = 0; index < count; index++)
+        {
+            mix.push_back(shapes[pick(random)]);
+        }
+        return mix;
+    }
+
+    uint32_t CountShapes(const std::vector<TextureShape>& mix)
+    {
+        std::set<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> shapes;
+        for (const auto& shape : mix)
+        {
+            shapes.insert({ shape.width, shape.height, shape.mipCount, shape.format });
+        }
+        return static_cast<uint32_t>(shapes.size());
+    }
+
+    struct FrameCounts
+    {
+        size_t materialChanges = 0;
+        size_t textureCalls = 0;
+        size_t drawCalls = 0;
+    };
+
+    struct Draw
+    {
+        uint32_t geometry;
+        uint32_t texture;
+        float depth;
+    };
+
+    /// @brief Sort, batch and submit a frame of draws as the renderer does
+    /// @param byArray Key materials on the array their texture is in, rather than on the texture
+    FrameCounts DrawFrame(const std::vector<Draw>& draws, const std::vector<TextureArraySlot>& slots, bool byArray)
+    {
+        std::vector<uint8_t> objects(1 + 2 * c_frameTextures + c_geometries);
+        auto textureObject = [&](uint32_t texture)
+        {
+            return 1 + (byArray ? slots[texture].array : c_frameTextures + texture);
+        };
+
+        RenderQueue queue;
+        for (uint32_t index = 0; index < draws.size(); index++)
+        {
+            const auto& draw = draws[index];
+            queue.Submit(objects.data(), objects.data() + textureObject(draw.texture), objects.data() + 1 + 2 * c_frameTextures + draw.geometry, draw.depth, index);
+        }
+        queue.Sort();
+
+        InstanceBatcher batcher;
+        batcher.Build(queue.GetPackets(), [](const DrawPacket&) { return true; });
+
+        FrameCounts counts;
+        counts.materialChanges = queue.GetStats().materialChanges;
+
+        CountingSink sink;
+        StateCache stateCache(&sink);
+        stateCache.BeginFrame();
+        const auto& packets = queue.GetPackets();
+        for (const auto& batch : batcher.GetBatches())
+        {
+            uint32_t texture = draws[packets[batch.firstPacket].item].texture;
+            stateCache.PSSetShaderResource(0, FakeObject<ID3D11ShaderResourceView>(objects, textureObject(texture)));
+            if (batch.instanced)
+            {
+                stateCache.DrawIndexedInstanced(36, batch.packetCount, 0, 0, batch.firstInstance);
+                continue;
+            }
+            for (uint32_t index = 0; index < batch.packetCount; index++)
+            {
+                stateCache.DrawIndexed(36, 0, 0);
+            }
+        }
+
+        counts.textureCalls = sink.textureCalls;
+        counts.drawCalls = sink.drawCalls;
+        return counts;
+    }
+
+    /// @brief A frame of draws of a few geometries, each drawn with one of a few textures
+    std::vector<Draw> MakeDraws(uint32_t count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> depth(1.0f, 500.0f);
+        std::vector<Draw> draws;
+        for (uint32_t index = 0; index < count; index++)
+        {
+            uint32_t geometry = random() % c_geometries;
+            draws.push_back(Draw{ geometry, geometry * c_variants + static_cast<uint32_t>(random() % c_variants), depth(random) });
+        }
+        return draws;
+    }
+
+    std::vector<TextureArraySlot> PlaceFrameTextures(TextureArrayPlanner& planner, uint32_t seed)
+    {
+        std::vector<TextureArraySlot> slots;
+        for (const auto& shape : MakeTextureMix(c_frameTextures, seed))
+        {
+            slots.push_back(planner.Place(shape).slot);
+        }
+        return slots;
+    }
+
+}
+
+TextureArrayBenchmarkResult RunTextureArrayBenchmark()
+{
+    TextureArrayBenchmarkResult result;
+
+    // Pack a scene's worth of textures, over and over for the timing
+    {
+        auto mix = MakeTextureMix(c_packedTextures, 4);
+        TextureArrayPlanner planner;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t repeat = 0; repeat < c_placeRepeats; repeat++)
+        {
+            planner.Clear();
+            for (const auto& shape : mix)
+            {
+                planner.Place(shape);
+            }
+        }
+        result.placeNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (c_placeRepeats * c_packedTextures);
+
+        auto stats = planner.GetStats();
+        result.textures = stats.textures;
+        result.shapes = CountShapes(mix);
+        result.arrays = stats.arrays;
+        result.textureBytes = stats.usedBytes;
+        result.arrayBytes = stats.capacityBytes;
+        result.grows = stats.grows;
+        result.grownBytes = stats.grownBytes;
+    }
+
+    // A frame of draws sorted and instanced by texture, against by texture array
+    {
+        TextureArrayPlanner planner;
+        auto slots = PlaceFrameTextures(planner, 5);
+        auto draws = MakeDraws(c_drawsPerFrame, 6);
+        auto before = DrawFrame(draws, slots, false);
+        auto after = DrawFrame(draws, slots, true);
+
+        result.drawsPerFrame = c_drawsPerFrame;
+        result.geometries = c_geometries;
+        result.variants = c_variants;
+        result.materialChangesBefore = before.materialChanges;
+        result.textureCallsBefore = before.textureCalls;
+        result.drawCallsBefore = before.drawCalls;
+        result.materialChangesAfter = after.materialChanges;
+        result.textureCallsAfter = after.textureCalls;
+        result.drawCallsAfter = after.drawCalls;
+    }
+
+    return result;
+}
+
+void ReportTextureArrayBenchmark(const TextureArrayBenchmarkResult& result, std::ostream& out)
+{
+    out << "Texture array benchmark: " << result.textures << " textures of " << result.shapes << " shapes in " << result.arrays << " arrays: "
+        << result.textureBytes / (1024.0 * 1024.0) << " of " << result.arrayBytes / (1024.0 * 1024.0) << " MB used, "
+        << result.grows << " grows copying " << result.grownBytes / (1024.0 * 1024.0) << " MB, " << result.placeNanoseconds << " ns a texture\n";
+    out << "  " << result.drawsPerFrame << " draws of " << result.geometries << " geometries with " << result.variants
+        << " textures each: " << result.materialChangesBefore << " material changes, " << result.textureCallsBefore << " texture binds, "
+        << result.drawCallsBefore << " draw calls by texture; " << result.materialChangesAfter << ", " << result.textureCallsAfter
+        << ", " << result.drawCallsAfter << " by array\n";
+}
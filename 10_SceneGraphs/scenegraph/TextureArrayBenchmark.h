@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+/// @brief The result of timing the texture array planner and counting what packing textures into
+/// arrays saves a frame of draws
+struct TextureArrayBenchmarkResult
+{
+    uint32_t textures = 0;                  // packed, of a mix of sizes and formats
+    uint32_t shapes = 0;                    // different sizes, mip counts and formats among them
+    uint32_t arrays = 0;                    // they were packed into
+    uint64_t textureBytes = 0;
+    uint64_t arrayBytes = 0;                // the arrays' capacity, over every array
+    uint64_t grows = 0;
+    uint64_t grownBytes = 0;                // copied into bigger arrays as they filled
+    double placeNanoseconds = 0.0;          // per texture
+
+    uint32_t drawsPerFrame = 0;
+    uint32_t geometries = 0;
+    uint32_t variants = 0;                  // textures each geometry is drawn with
+    size_t materialChangesBefore = 0;       // in the sorted queue, with a material for every texture
+    size_t textureCallsBefore = 0;          // texture binds that reached the device context
+    size_t drawCallsBefore = 0;
+    size_t materialChangesAfter = 0;        // with a material for every array, the slice passed per draw
+    size_t textureCallsAfter = 0;
+    size_t drawCallsAfter = 0;
+};
+
+/// @brief Pack a mix of textures, timing the planner, and count the material changes,
+/// texture binds and draw calls of a frame of draws sorted and instanced by texture, as before,
+/// and by the array each texture is in.
+TextureArrayBenchmarkResult RunTextureArrayBenchmark();
+
+/// @brief Write the packing, then the frame's binds by texture and by array
+void ReportTextureArrayBenchmark(const TextureArrayBenchmarkResult& result, std::ostream& out);
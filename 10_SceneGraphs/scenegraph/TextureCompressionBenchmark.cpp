@@ -0,0 +1,253 @@
+#include "TextureCompressionBenchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <random>
+
+#include "BlockCompression.h"
+#include "ImageDecoder.h"
+#include "TextureMips.h"
+
+namespace
+{
+    constexpr size_t c_maxImages = 4;
+    constexpr uint32_t c_maxImageSize = 1024;   // larger images are cropped, to keep the run short
+    constexpr uint32_t c_proceduralSize = 512;
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    DecodedImage MakeImage(uint32_t width, uint32_t height, const std::function<void(uint32_t, uint32_t, uint8_t*)>& texel)
+    {
+        DecodedImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                texel(x, y, image.pixels.data() + (static_cast<size_t>(y) * width + x) * 4);
+            }
+        }
+        return image;
+    }
+
+    /// @brief The top left of the image, no bigger than c_maxImageSize and a multiple of 4 on each
+    /// side, so every format can take it
+    DecodedImage Crop(const DecodedImage& image)
+    {
+        uint32_t width = std::min(image.width, c_maxImageSize) & ~(c_blockSize - 1);
+        uint32_t height = std::min(image.height, c_maxImageSize) & ~(c_blockSize - 1);
+        return MakeImage(width, height, [&image](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            std::copy_n(image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4, 4, texel);
+        });
+    }
+
+    /// @brief Up to c_maxImages PNGs and JPGs from the nearest raw/texture folder above the working
+    /// directory, which is where the source art lives
+    std::vector<DecodedImage> LoadSourceImages(std::vector<std::string>& skipped)
+    {
+        std::vector<DecodedImage> images;
+        std::error_code error;
+        for (auto folder = std::filesystem::current_path(error); !folder.empty(); folder = folder.parent_path())
+        {
+            auto textures = folder / "raw" / "texture";
+            if (!std::filesystem::is_directory(textures, error))
+            {
+                if (folder == folder.parent_path())
+                    break;
+                continue;
+            }
+
+            std::vector<std::filesystem::path> paths;
+            for (const auto& entry : std::filesystem::directory_iterator(textures, error))
+            {
+                auto extension = entry.path().extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+                if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+                    paths.push_back(entry.path());
+            }
+            std::sort(paths.begin(), paths.end());
+
+            for (const auto& path : paths)
+            {
+                DecodedImage image;
+                std::string decodeError;
+                if (!DecodeImageFile(path.string(), image, decodeError))
+                {
+                    skipped.push_back(path.string() + ": " + decodeError);
+                    continue;
+                }
+                if (image.width < c_blockSize || image.height < c_blockSize)
+                    continue;
+
+                images.push_back(Crop(image));
+                if (images.size() == c_maxImages)
+                    break;
+            }
+            break;
+        }
+        return images;
+    }
+
+    /// @brief Stand ins for photos and painted textures: smooth shading with grain, hard edged
+    /// bricks, and a foliage cutout with soft alpha
+    std::vector<DecodedImage> MakeProceduralImages()
+    {
+        std::mt19937 random(1234);
+        std::uniform_int_distribution<int> grain(-12, 12);
+        auto noise = [&random, &grain](int value) { return static_cast<uint8_t>(std::clamp(value + grain(random), 0, 255)); };
+
+        std::vector<DecodedImage> images;
+        images.push_back(MakeImage(c_proceduralSize, c_proceduralSize, [&noise](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            double shade = 0.5 + 0.5 * std::sin(x * 0.013) * std::cos(y * 0.021);
+            texel[0] = noise(static_cast<int>(90 + 140 * shade));
+            texel[1] = noise(static_cast<int>(70 + 110 * shade * shade));
+            texel[2] = noise(static_cast<int>(40 + 60 * (1.0 - shade)));
+            texel[3] = 255;
+        }));
+        images.push_back(MakeImage(c_proceduralSize, c_proceduralSize, [&noise](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            uint32_t row = y / 32;
+            bool mortar = y % 32 < 3 || (x + (row % 2) * 32) % 64 < 3;
+            texel[0] = noise(mortar ? 190 : 150 + static_cast<int>(row * 7 % 40));
+            texel[1] = noise(mortar ? 185 : 60);
+            texel[2] = noise(mortar ? 170 : 45);
+            texel[3] = 255;
+        }));
+        images.push_back(MakeImage(c_proceduralSize, c_proceduralSize, [&noise](uint32_t x, uint32_t y, uint8_t* texel)
+        {
+            double leaf = std::sin(x * 0.09) + std::sin(y * 0.07 + x * 0.02);
+            texel[0] = noise(40);
+            texel[1] = noise(static_cast<int>(120 + 50 * std::sin(y * 0.05)));
+            texel[2] = noise(30);
+            texel[3] = static_cast<uint8_t>(std::clamp(128.0 + 200.0 * leaf, 0.0, 255.0));
+        }));
+        return images;
+    }
+
+    /// @brief Summed squared error of each texel's colour, and of its alpha
+    void AddSquaredError(const DecodedImage& original, const DecodedImage& decoded, double& colour, double& alpha)
+    {
+        for (size_t index = 0; index < original.pixels.size(); index += 4)
+        {
+            for (size_t channel = 0; channel < 4; channel++)
+            {
+                double difference = static_cast<double>(original.pixels[index + channel]) - decoded.pixels[index + channel];
+                (channel < 3 ? colour : alpha) += difference * difference;
+            }
+        }
+    }
+
+    double Psnr(double squaredError, size_t samples)
+    {
+        if (squaredError <= 0.0)
+            return INFINITY;
+        return 10.0 * std::log10(255.0 * 255.0 / (squaredError / samples));
+    }
+}
+
+TextureCompressionBenchmarkResult RunTextureCompressionBenchmark()
+{
+    TextureCompressionBenchmarkResult result;
+
+    auto images = LoadSourceImages(result.skipped);
+    if (images.empty())
+    {
+        images = MakeProceduralImages();
+        result.procedural = true;
+    }
+    result.imageCount = images.size();
+
+    // Both filters over every image; the Kaiser chains are the ones cooked, as the cooker does
+    std::vector<std::vector<DecodedImage>> chains(images.size());
+    size_t chainTexels = 0;
+    for (size_t index = 0; index < images.size(); index++)
+    {
+        MipOptions options;
+        options.filter = MipFilter::Box;
+        auto start = std::chrono::high_resolution_clock::now();
+        GenerateMips(images[index], options, chains[index]);
+        result.boxMilliseconds += MillisecondsSince(start);
+
+        options.filter = MipFilter::Kaiser;
+        start = std::chrono::high_resolution_clock::now();
+        GenerateMips(images[index], options, chains[index]);
+        result.kaiserMilliseconds += MillisecondsSince(start);
+
+        result.texelCount += images[index].pixels.size() / 4;
+        for (const auto& level : chains[index])
+        {
+            result.uncompressedBytes += level.pixels.size();
+            chainTexels += level.pixels.size() / 4;
+        }
+    }
+    result.boxMegatexelsPerSecond = result.texelCount / (result.boxMilliseconds * 1000.0);
+    result.kaiserMegatexelsPerSecond = result.texelCount / (result.kaiserMilliseconds * 1000.0);
+
+    const std::pair<const char*, BlockFormat> formats[] = { { "BC1", BlockFormat::BC1 }, { "BC3", BlockFormat::BC3 }, { "BC7", BlockFormat::BC7 } };
+    for (const auto& format : formats)
+    {
+        TextureFormatResult formatResult;
+        formatResult.name = format.first;
+        formatResult.hasAlpha = format.second != BlockFormat::BC1;
+
+        double colourError = 0.0;
+        double alphaError = 0.0;
+        std::vector<uint8_t> blocks;
+        for (size_t index = 0; index < images.size(); index++)
+        {
+            for (size_t level = 0; level < chains[index].size(); level++)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                CompressImage(format.second, chains[index][level], blocks);
+                formatResult.milliseconds += MillisecondsSince(start);
+                formatResult.bytes += blocks.size();
+
+                if (level == 0)
+                {
+                    DecodedImage decoded;
+                    DecompressImage(format.second, blocks.data(), images[index].width, images[index].height, decoded);
+                    AddSquaredError(images[index], decoded, colourError, alphaError);
+                }
+            }
+        }
+
+        formatResult.megatexelsPerSecond = chainTexels / (formatResult.milliseconds * 1000.0);
+        formatResult.colourPsnr = Psnr(colourError, result.texelCount * 3);
+        if (formatResult.hasAlpha)
+            formatResult.alphaPsnr = Psnr(alphaError, result.texelCount);
+        result.formats.push_back(formatResult);
+    }
+
+    return result;
+}
+
+void ReportTextureCompressionBenchmark(const TextureCompressionBenchmarkResult& result, std::ostream& out)
+{
+    out << "Texture compression benchmark: " << result.imageCount << (result.procedural ? " generated" : " source") << " images, " << result.texelCount / 1024
+        << " K texels: mips in " << result.boxMilliseconds << " ms box (" << result.boxMegatexelsPerSecond << " Mtexels/s), "
+        << result.kaiserMilliseconds << " ms Kaiser (" << result.kaiserMegatexelsPerSecond << " Mtexels/s)\n";
+    for (const auto& format : result.formats)
+    {
+        out << "  " << format.name << ": " << format.milliseconds << " ms (" << format.megatexelsPerSecond << " Mtexels/s), "
+            << format.bytes / 1024 << " KB of " << result.uncompressedBytes / 1024 << " KB, PSNR colour " << format.colourPsnr << " dB";
+        if (format.hasAlpha)
+            out << ", alpha " << format.alphaPsnr << " dB";
+        out << "\n";
+    }
+    for (const auto& skipped : result.skipped)
+    {
+        out << "  Couldn't decode " << skipped << "\n";
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// @brief How one block compressed format did over every image
+struct TextureFormatResult
+{
+    std::string name;
+    size_t bytes = 0;                   // the full mip chains of every image
+    double milliseconds = 0.0;          // encoding them
+    double megatexelsPerSecond = 0.0;
+    double colourPsnr = 0.0;            // of the first levels, in dB, over every image together
+    bool hasAlpha = false;              // BC1 drops alpha, so it has no alphaPsnr
+    double alphaPsnr = 0.0;
+};
+
+/// @brief The result of timing the texture pipeline on a set of images
+struct TextureCompressionBenchmarkResult
+{
+    size_t imageCount = 0;
+    bool procedural = false;            // no source images were found, so generated ones were used
+    size_t texelCount = 0;              // in the first levels of every image
+    size_t uncompressedBytes = 0;       // the full mip chains of every image, as RGBA8
+    double boxMilliseconds = 0.0;       // making every mip chain
+    double kaiserMilliseconds = 0.0;
+    double boxMegatexelsPerSecond = 0.0;
+    double kaiserMegatexelsPerSecond = 0.0;
+    std::vector<TextureFormatResult> formats;
+    std::vector<std::string> skipped;   // source images that couldn't be decoded, and why
+};
+
+/// @brief Make the mip chains of the images in raw/texture, looked for above the working
+/// directory, with the box and Kaiser filters, encode every level in BC1, BC3 and BC7, and measure
+/// the throughput and how close the first level comes back. If there are no images there, generated ones are used instead.
+TextureCompressionBenchmarkResult RunTextureCompressionBenchmark();
+
+/// @brief Write the mip filters, then a line for each format and whatever was skipped
+void ReportTextureCompressionBenchmark(const TextureCompressionBenchmarkResult& result, std::ostream& out);
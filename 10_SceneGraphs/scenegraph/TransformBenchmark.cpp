@@ -0,0 +1,244 @@
+#include "TransformBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <DirectXMath.h>
+
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+#include "mathutils.h"
+
+namespace
+{
+    constexpr size_t c_branchingFactor = 4;
+    constexpr int c_iterations = 20;
+    constexpr size_t c_movingNodeStride = 20;
+    constexpr size_t c_jobScalingNodeCount = 100000;
+
+    /// @brief A scene node the way SceneNode used to be: each node owns its matrices and the update
+    /// recurses through shared_ptr children, locking the weak_ptr parent along the way.
+    struct RecursiveNode : public std::enable_shared_from_this<RecursiveNode>
+    {
+        std::weak_ptr<RecursiveNode> parent;
+        std::vector<std::shared_ptr<RecursiveNode>> children;
+
+        DirectX::XMVECTOR rotation = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMVECTOR translation = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMVECTOR scale = { 1.0f, 1.0f, 1.0f };
+
+        DirectX::XMVECTOR worldRotationQuat;
+        DirectX::XMVECTOR worldTranslation;
+        DirectX::XMVECTOR worldScale;
+
+        DirectX::XMMATRIX localTransform;
+        DirectX::XMMATRIX worldTransform;
+
+        void Update()
+        {
+            localTransform = DirectX::XMMatrixScaling(DirectX::XMVectorGetX(scale), DirectX::XMVectorGetY(scale), DirectX::XMVectorGetZ(scale)) *
+                DirectX::XMMatrixRotationY(degreesToRadians(DirectX::XMVectorGetY(rotation))) *
+                DirectX::XMMatrixRotationX(degreesToRadians(DirectX::XMVectorGetX(rotation))) *
+                DirectX::XMMatrixRotationZ(degreesToRadians(DirectX::XMVectorGetZ(rotation))) *
+                DirectX::XMMatrixTranslation(DirectX::XMVectorGetX(translation), DirectX::XMVectorGetY(translation), DirectX::XMVectorGetZ(translation));
+
+            if (auto parentPtr = parent.lock())
+                worldTransform = DirectX::XMMatrixMultiply(parentPtr->worldTransform, localTransform);
+            else
+                worldTransform = localTransform;
+
+            DirectX::XMMatrixDecompose(&worldScale, &worldRotationQuat, &worldTranslation, worldTransform);
+
+            for (auto& child : children)
+            {
+                child->Update();
+            }
+        }
+    };
+
+    /// @brief Some arbitrary, but repeatable, local transform values for node `index`
+    DirectX::XMFLOAT3 SyntheticRotation(size_t index)
+    {
+        return { static_cast<float>(index % 7), static_cast<float>(index % 11), static_cast<float>(index % 13) };
+    }
+
+    DirectX::XMFLOAT3 SyntheticTranslation(size_t index)
+    {
+        return { 0.1f * static_cast<float>(index % 5), 0.25f, -0.1f * static_cast<float>(index % 3) };
+    }
+
+    double TimeRecursive(size_t nodeCount)
+    {
+        std::vector<std::shared_ptr<RecursiveNode>> nodes;
+        nodes.reserve(nodeCount);
+        for (size_t index = 0; index < nodeCount; index++)
+        {
+            auto node = std::make_shared<RecursiveNode>();
+            auto rotation = SyntheticRotation(index);
+            auto translation = SyntheticTranslation(index);
+            node->rotation = DirectX::XMVectorSet(rotation.x, rotation.y, rotation.z, 0.0f);
+            node->translation = DirectX::XMVectorSet(translation.x, translation.y, translation.z, 0.0f);
+
+            if (index > 0)
+            {
+                auto& parentNode = nodes[(index - 1) / c_branchingFactor];
+                parentNode->children.push_back(node);
+                node->parent = parentNode;
+            }
+            nodes.push_back(node);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            nodes[0]->Update();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        return std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+    }
+
+    /// @brief Fill a TransformHierarchy with the synthetic scene, and run the first update
+    std::vector<TransformHierarchy::Handle> BuildFlattened(TransformHierarchy& hierarchy, size_t nodeCount)
+    {
+        std::vector<TransformHierarchy::Handle> handles;
+        handles.reserve(nodeCount);
+        for (size_t index = 0; index < nodeCount; index++)
+        {
+            auto handle = hierarchy.Create();
+            auto rotation = SyntheticRotation(index);
+            auto translation = SyntheticTranslation(index);
+            hierarchy.SetLocalRotation(handle, rotation.x, rotation.y, rotation.z);
+            hierarchy.SetLocalTranslation(handle, translation.x, translation.y, translation.z);
+
+            if (index > 0)
+                hierarchy.SetParent(handle, handles[(index - 1) / c_branchingFactor]);
+            handles.push_back(handle);
+        }
+
+        // The first update re-orders the hierarchy; keep that out of the timings.
+        hierarchy.Update();
+
+        return handles;
+    }
+
+    void TimeFlattened(size_t nodeCount, TransformBenchmarkResult& result)
+    {
+        TransformHierarchy hierarchy;
+        auto handles = BuildFlattened(hierarchy, nodeCount);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            hierarchy.Invalidate();
+            hierarchy.Update();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        result.flattenedMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+
+        // Mostly static scene: move one node in twenty (never the root) every frame
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            for (size_t index = c_movingNodeStride - 1; index < nodeCount; index += c_movingNodeStride)
+            {
+                auto translation = SyntheticTranslation(index);
+                hierarchy.SetLocalTranslation(handles[index], translation.x, translation.y + 0.01f * static_cast<float>(iteration + 1), translation.z);
+            }
+            hierarchy.Update();
+        }
+        end = std::chrono::high_resolution_clock::now();
+
+        result.incrementalMilliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+        result.incrementalNodesRecomputed = hierarchy.GetStats().nodesRecomputed;
+    }
+}
+
+std::vector<TransformBenchmarkResult> RunTransformBenchmark()
+{
+    std::vector<TransformBenchmarkResult> results;
+
+    for (size_t nodeCount : { 1000, 10000, 100000 })
+    {
+        TransformBenchmarkResult result;
+        result.nodeCount = nodeCount;
+        result.recursiveMilliseconds = TimeRecursive(nodeCount);
+        TimeFlattened(nodeCount, result);
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+std::vector<JobScalingResult> RunJobScalingBenchmark()
+{
+    std::vector<JobScalingResult> results;
+
+    TransformHierarchy hierarchy;
+    auto handles = BuildFlattened(hierarchy, c_jobScalingNodeCount);
+
+    // The serial update is the reference every parallel run has to match
+    std::vector<DirectX::XMMATRIX> reference;
+    reference.reserve(handles.size());
+    for (auto handle : handles)
+    {
+        reference.push_back(hierarchy.GetWorldTransform(handle));
+    }
+
+    unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned workerCount = 1; workerCount <= maxWorkers; workerCount++)
+    {
+        hierarchy.SetJobSystem(std::make_shared<JobSystem>(workerCount));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < c_iterations; iteration++)
+        {
+            hierarchy.Invalidate();
+            hierarchy.Update();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        JobScalingResult result;
+        result.nodeCount = c_jobScalingNodeCount;
+        result.workerCount = workerCount;
+        result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count() / c_iterations;
+        result.matchesSerial = true;
+        for (size_t index = 0; index < handles.size(); index++)
+        {
+            if (memcmp(&reference[index], &hierarchy.GetWorldTransform(handles[index]), sizeof(DirectX::XMMATRIX)) != 0)
+            {
+                result.matchesSerial = false;
+                break;
+            }
+        }
+
+        results.push_back(result);
+    }
+
+    hierarchy.SetJobSystem(nullptr);
+
+    return results;
+}
+
+void ReportTransformBenchmark(const std::vector<TransformBenchmarkResult>& results, std::ostream& out)
+{
+    for (const auto& result : results)
+    {
+        out << "Transform benchmark, " << result.nodeCount << " nodes: recursive " << result.recursiveMilliseconds
+            << " ms, flattened " << result.flattenedMilliseconds << " ms, incremental " << result.incrementalMilliseconds
+            << " ms (" << result.incrementalNodesRecomputed << " nodes recomputed)\n";
+    }
+}
+
+void ReportJobScalingBenchmark(const std::vector<JobScalingResult>& results, std::ostream& out)
+{
+    for (const auto& result : results)
+    {
+        out << "Job scaling benchmark, " << result.nodeCount << " nodes, " << result.workerCount << " workers: "
+            << result.milliseconds << " ms" << (result.matchesSerial ? "" : " (MISMATCH with the serial update)") << "\n";
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+/// @brief The result of timing one hierarchy size
+struct TransformBenchmarkResult
+{
+    size_t nodeCount = 0;
+    double recursiveMilliseconds = 0.0; // average time for one update of the recursive, pointer based graph
+    double flattenedMilliseconds = 0.0; // average time for one update of the TransformHierarchy, with every node dirty
+    double incrementalMilliseconds = 0.0; // average time for one update of the TransformHierarchy, with 5% of the nodes moving
+    size_t incrementalNodesRecomputed = 0; // number of nodes recomputed by the incremental update
+};
+
+/// @brief Time the world transform update of synthetic 1k, 10k and 100k node hierarchies, comparing
+/// the flattened TransformHierarchy against a recursive, pointer based scene graph.
+/// Doesn't touch the GPU.
+std::vector<TransformBenchmarkResult> RunTransformBenchmark();
+
+/// @brief The result of timing the parallel update with one particular number of workers
+struct JobScalingResult
+{
+    size_t nodeCount = 0;
+    unsigned workerCount = 0;
+    double milliseconds = 0.0; // average time for one full update of the hierarchy
+    bool matchesSerial = false; // whether every world transform is bit for bit identical to the serial update
+};
+
+/// @brief Time a full update of a synthetic 100k node hierarchy with the JobSystem, scaling the
+/// number of workers from 1 up to the number of hardware threads. Doesn't touch the GPU.
+std::vector<JobScalingResult> RunJobScalingBenchmark();
+
+/// @brief Write a line for each hierarchy size
+void ReportTransformBenchmark(const std::vector<TransformBenchmarkResult>& results, std::ostream& out);
+
+/// @brief Write a line for each number of workers
+void ReportJobScalingBenchmark(const std::vector<JobScalingResult>& results, std::ostream& out);
@@ -0,0 +1,468 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include "JobSystem.h"
+#include "mathutils.h"
+
+namespace
+{
+    // Number of entries handed to a single job by the parallel update
+    constexpr uint32_t c_parallelGrainSize = 1024;
+
+    /// @brief Re-order the contents of a vector so that element `index` of the result is `values[order[index]]`
+    template <typename T>
+    void Permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+    {
+        std::vector<T> permuted;
+        permuted.reserve(order.size());
+        for (auto oldIndex : order)
+        {
+            permuted.push_back(values[oldIndex]);
+        }
+        values.swap(permuted);
+    }
+
+    /// @brief Build the quaternion for Euler angles (in degrees), applying the rotations in the
+    /// same order the Euler API always has: Y, then X, then Z.
+    DirectX::XMVECTOR QuaternionFromEulerDegrees(float x, float y, float z)
+    {
+        DirectX::XMVECTOR rotationY = DirectX::XMQuaternionRotationNormal(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), degreesToRadians(y));
+        DirectX::XMVECTOR rotationX = DirectX::XMQuaternionRotationNormal(DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), degreesToRadians(x));
+        DirectX::XMVECTOR rotationZ = DirectX::XMQuaternionRotationNormal(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), degreesToRadians(z));
+
+        return DirectX::XMQuaternionMultiply(DirectX::XMQuaternionMultiply(rotationY, rotationX), rotationZ);
+    }
+
+    /// @brief Convert a rotation matrix into the Euler angles (in degrees) used by SceneNode.
+    /// The rotation order matches the update pass: Y, then X, then Z.
+    DirectX::XMFLOAT3 EulerDegreesFromRotation(const DirectX::XMMATRIX& rotation)
+    {
+        DirectX::XMFLOAT4X4 m;
+        DirectX::XMStoreFloat4x4(&m, rotation);
+
+        float x = asinf(clamp(m._23, -1.0f, 1.0f));
+        float y = atan2f(-m._13, m._33);
+        float z = atan2f(-m._21, m._22);
+
+        constexpr float radiansToDegrees = 180.0f / CONST_PI;
+        return { x * radiansToDegrees, y * radiansToDegrees, z * radiansToDegrees };
+    }
+}
+
+/// @brief Allocate a new transform. It starts out as a root with an identity transform.
+/// @return Handle to the new transform
+TransformHierarchy::Handle TransformHierarchy::Create()
+{
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_handleToIndex.size());
+        m_handleToIndex.push_back(0);
+    }
+
+    m_handleToIndex[handle] = static_cast<uint32_t>(m_parents.size());
+    m_indexToHandle.push_back(handle);
+
+    m_parents.push_back(-1);
+    m_localRotation.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
+    m_localEuler.push_back({ 0.0f, 0.0f, 0.0f });
+    m_localTranslation.push_back({ 0.0f, 0.0f, 0.0f });
+    m_localScale.push_back({ 1.0f, 1.0f, 1.0f });
+    m_dirty.push_back(1);
+
+    m_worldTransform.push_back(DirectX::XMMatrixIdentity());
+    m_worldRotationQuat.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
+    m_worldScale.push_back({ 1.0f, 1.0f, 1.0f });
+    m_worldDecomposed.push_back(1);
+
+    m_orderDirty = true;
+    m_topologyVersion++;
+
+    return handle;
+}
+
+/// @brief Release a transform. Any children it had become roots. The entry is only marked here;
+/// the children are let go of and the entry is compacted away when the order is next rebuilt, so
+/// releasing a whole subtree doesn't rescan the arrays for every node in it.
+/// @param handle The transform to release
+void TransformHierarchy::Destroy(Handle handle)
+{
+    uint32_t index = m_handleToIndex[handle];
+    m_indexToHandle[index] = InvalidHandle;
+    m_handleToIndex[handle] = UINT32_MAX;
+    m_freeHandles.push_back(handle);
+
+    m_orderDirty = true;
+    m_topologyVersion++;
+}
+
+/// @brief Attach a transform to a new parent. A transform can't become a descendant of itself,
+/// as RebuildOrder could never put the loop in depth order, so that leaves the hierarchy as it was.
+/// @param child The transform to re-parent
+/// @param parent The new parent, or InvalidHandle to make the child a root
+/// @return false if the parent is the child or one of its descendants
+bool TransformHierarchy::SetParent(Handle child, Handle parent)
+{
+    uint32_t index = m_handleToIndex[child];
+    int32_t parentIndex = parent == InvalidHandle ? -1 : static_cast<int32_t>(m_handleToIndex[parent]);
+
+    // Released entries let go of their children on the next rebuild, so the walk stops at one
+    for (int32_t ancestor = parentIndex; ancestor >= 0 && m_indexToHandle[ancestor] != InvalidHandle; ancestor = m_parents[ancestor])
+    {
+        if (ancestor == static_cast<int32_t>(index))
+            return false;
+    }
+
+    m_parents[index] = parentIndex;
+    m_dirty[index] = 1;
+    m_orderDirty = true;
+    m_topologyVersion++;
+
+    return true;
+}
+
+void TransformHierarchy::SetLocalTransform(Handle handle, const DirectX::XMMATRIX& local)
+{
+    DirectX::XMVECTOR scale;
+    DirectX::XMVECTOR rotationQuat;
+    DirectX::XMVECTOR translation;
+    DirectX::XMMatrixDecompose(&scale, &rotationQuat, &translation, local);
+
+    uint32_t index = m_handleToIndex[handle];
+    DirectX::XMStoreFloat3(&m_localScale[index], scale);
+    DirectX::XMStoreFloat3(&m_localTranslation[index], translation);
+    DirectX::XMStoreFloat4(&m_localRotation[index], rotationQuat);
+    m_localEuler[index] = EulerDegreesFromRotation(DirectX::XMMatrixRotationQuaternion(rotationQuat));
+    m_dirty[index] = 1;
+}
+
+// The setters only flag the transform as dirty if the value actually changes, as the UI pushes
+// the current values back in every frame.
+
+/// @brief Convenience setter for the rotation as Euler angles in degrees, applied Y, then X, then Z.
+/// The angles are kept as given so that GetLocalRotation hands back exactly the same values.
+void TransformHierarchy::SetLocalRotation(Handle handle, float x, float y, float z)
+{
+    uint32_t index = m_handleToIndex[handle];
+    auto& euler = m_localEuler[index];
+    if (euler.x != x || euler.y != y || euler.z != z)
+    {
+        euler = { x, y, z };
+        DirectX::XMStoreFloat4(&m_localRotation[index], QuaternionFromEulerDegrees(x, y, z));
+        m_dirty[index] = 1;
+    }
+}
+
+void TransformHierarchy::SetLocalRotationQuat(Handle handle, const DirectX::XMFLOAT4& rotation)
+{
+    uint32_t index = m_handleToIndex[handle];
+    auto& current = m_localRotation[index];
+    if (current.x != rotation.x || current.y != rotation.y || current.z != rotation.z || current.w != rotation.w)
+    {
+        current = rotation;
+        m_localEuler[index] = EulerDegreesFromRotation(DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&rotation)));
+        m_dirty[index] = 1;
+    }
+}
+
+void TransformHierarchy::SetLocalTranslation(Handle handle, float x, float y, float z)
+{
+    uint32_t index = m_handleToIndex[handle];
+    auto& translation = m_localTranslation[index];
+    if (translation.x != x || translation.y != y || translation.z != z)
+    {
+        translation = { x, y, z };
+        m_dirty[index] = 1;
+    }
+}
+
+void TransformHierarchy::SetLocalScale(Handle handle, float x, float y, float z)
+{
+    uint32_t index = m_handleToIndex[handle];
+    auto& scale = m_localScale[index];
+    if (scale.x != x || scale.y != y || scale.z != z)
+    {
+        scale = { x, y, z };
+        m_dirty[index] = 1;
+    }
+}
+
+/// @brief The rotation as Euler angles in degrees
+DirectX::XMFLOAT3 TransformHierarchy::GetLocalRotation(Handle handle) const
+{
+    return m_localEuler[m_handleToIndex[handle]];
+}
+
+DirectX::XMFLOAT4 TransformHierarchy::GetLocalRotationQuat(Handle handle) const
+{
+    return m_localRotation[m_handleToIndex[handle]];
+}
+
+DirectX::XMFLOAT3 TransformHierarchy::GetLocalTranslation(Handle handle) const
+{
+    return m_localTranslation[m_handleToIndex[handle]];
+}
+
+DirectX::XMFLOAT3 TransformHierarchy::GetLocalScale(Handle handle) const
+{
+    return m_localScale[m_handleToIndex[handle]];
+}
+
+const DirectX::XMMATRIX& TransformHierarchy::GetWorldTransform(Handle handle) const
+{
+    return m_worldTransform[m_handleToIndex[handle]];
+}
+
+DirectX::XMFLOAT4 TransformHierarchy::GetWorldRotationQuat(Handle handle) const
+{
+    uint32_t index = m_handleToIndex[handle];
+    DecomposeWorld(index);
+    return m_worldRotationQuat[index];
+}
+
+/// @brief The translation is just the last row of the world matrix, so this never needs a decomposition.
+DirectX::XMFLOAT3 TransformHierarchy::GetWorldTranslation(Handle handle) const
+{
+    DirectX::XMFLOAT3 translation;
+    DirectX::XMStoreFloat3(&translation, m_worldTransform[m_handleToIndex[handle]].r[3]);
+    return translation;
+}
+
+DirectX::XMFLOAT3 TransformHierarchy::GetWorldScale(Handle handle) const
+{
+    uint32_t index = m_handleToIndex[handle];
+    DecomposeWorld(index);
+    return m_worldScale[index];
+}
+
+/// @brief Split the world transform of an entry into its scale and rotation, if that hasn't
+/// been done since the world transform was last recomputed.
+void TransformHierarchy::DecomposeWorld(uint32_t index) const
+{
+    if (m_worldDecomposed[index])
+        return;
+
+    DirectX::XMVECTOR worldScale;
+    DirectX::XMVECTOR worldRotationQuat;
+    DirectX::XMVECTOR worldTranslation;
+    DirectX::XMMatrixDecompose(&worldScale, &worldRotationQuat, &worldTranslation, m_worldTransform[index]);
+
+    DirectX::XMStoreFloat3(&m_worldScale[index], worldScale);
+    DirectX::XMStoreFloat4(&m_worldRotationQuat[index], worldRotationQuat);
+    m_worldDecomposed[index] = 1;
+}
+
+/// @brief Flag every transform as dirty, forcing the next update to recompute all of them.
+void TransformHierarchy::Invalidate()
+{
+    std::fill(m_dirty.begin(), m_dirty.end(), static_cast<uint8_t>(1));
+}
+
+/// @brief Use a job system to spread the update over several threads. Pass nullptr to always update serially.
+void TransformHierarchy::SetJobSystem(std::shared_ptr<JobSystem> jobSystem)
+{
+    m_jobSystem = jobSystem;
+}
+
+/// @brief Compute the world transform of every dirty node, and of all of their descendants.
+///
+/// Serially, this is one linear pass over the arrays. In parallel, each depth level is split
+/// across the job system in turn; entries within a level only depend on the level above, which
+/// is already complete. Every entry goes through exactly the same arithmetic either way, so both
+/// paths produce bit for bit identical results.
+void TransformHierarchy::Update()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (m_orderDirty)
+        RebuildOrder();
+
+    const size_t count = m_parents.size();
+    size_t recomputed = 0;
+    unsigned workerCount = 1;
+
+    if (m_jobSystem && m_parallelUpdate)
+    {
+        workerCount = m_jobSystem->GetWorkerCount();
+
+        std::atomic<size_t> parallelRecomputed = 0;
+        for (size_t level = 0; level + 1 < m_levelOffsets.size(); level++)
+        {
+            const uint32_t levelBegin = m_levelOffsets[level];
+            const uint32_t levelEnd = m_levelOffsets[level + 1];
+            m_jobSystem->ParallelFor(levelEnd - levelBegin, c_parallelGrainSize, [this, levelBegin, &parallelRecomputed](uint32_t begin, uint32_t end)
+                {
+                    parallelRecomputed.fetch_add(UpdateRange(levelBegin + begin, levelBegin + end), std::memory_order_relaxed);
+                });
+        }
+        recomputed = parallelRecomputed.load();
+    }
+    else
+    {
+        recomputed = UpdateRange(0, static_cast<uint32_t>(count));
+    }
+
+    // Every entry still flagged was recomputed
+    m_recomputed.clear();
+    for (uint32_t index = 0; index < count; index++)
+    {
+        if (m_dirty[index])
+        {
+            m_recomputed.push_back(m_indexToHandle[index]);
+            m_dirty[index] = 0;
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    m_stats.nodeCount = count;
+    m_stats.nodesRecomputed = recomputed;
+    m_stats.workerCount = workerCount;
+    m_stats.updateMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// @brief Recompute the dirty entries in [begin, end). The parents of these entries must already be up to date.
+/// @return The number of entries recomputed
+size_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
+{
+    size_t recomputed = 0;
+    for (uint32_t index = begin; index < end; index++)
+    {
+        // Parents are always stored before their children, so the parent's dirty flag and world
+        // transform are already up to date for this frame.
+        int32_t parentIndex = m_parents[index];
+        if (parentIndex >= 0 && m_dirty[parentIndex])
+            m_dirty[index] = 1;
+
+        if (!m_dirty[index])
+            continue;
+
+        recomputed++;
+
+        // Scale, then rotate, then translate, built in one go
+        DirectX::XMMATRIX localTransform = DirectX::XMMatrixAffineTransformation(
+            DirectX::XMLoadFloat3(&m_localScale[index]),
+            DirectX::XMVectorZero(),
+            DirectX::XMLoadFloat4(&m_localRotation[index]),
+            DirectX::XMLoadFloat3(&m_localTranslation[index]));
+
+        if (parentIndex >= 0)
+            m_worldTransform[index] = DirectX::XMMatrixMultiply(m_worldTransform[parentIndex], localTransform);
+        else
+            m_worldTransform[index] = localTransform;
+
+        // Decomposing the world transform is expensive and rarely needed, so it is deferred
+        // until somebody actually asks for the world rotation or scale.
+        m_worldDecomposed[index] = 0;
+    }
+
+    return recomputed;
+}
+
+/// @brief Drop released entries and re-sort the remaining ones by depth, so that every parent
+/// is stored before its children. Only needed after the topology has changed.
+void TransformHierarchy::RebuildOrder()
+{
+    constexpr uint32_t unknownDepth = UINT32_MAX;
+
+    const size_t count = m_parents.size();
+    std::vector<uint32_t> depths(count, unknownDepth);
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+
+    // Children of released entries become roots
+    for (size_t index = 0; index < count; index++)
+    {
+        int32_t parent = m_parents[index];
+        if (parent >= 0 && m_indexToHandle[parent] == InvalidHandle)
+        {
+            m_parents[index] = -1;
+            m_dirty[index] = 1;
+        }
+    }
+
+    for (size_t index = 0; index < count; index++)
+    {
+        if (m_indexToHandle[index] == InvalidHandle)
+            continue;
+
+        // Walk up towards the root until we find an entry whose depth we already know
+        chain.clear();
+        int32_t current = static_cast<int32_t>(index);
+        while (current >= 0 && depths[current] == unknownDepth)
+        {
+            chain.push_back(static_cast<uint32_t>(current));
+            current = m_parents[current];
+        }
+
+        uint32_t depth = current < 0 ? 0 : depths[current] + 1;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            depths[*it] = depth++;
+        }
+
+        if (depth > 0 && depth - 1 > maxDepth)
+            maxDepth = depth - 1;
+    }
+
+    // Counting sort by depth. Entries at the same depth keep their relative order.
+    std::vector<uint32_t> levelStart(maxDepth + 2, 0);
+    for (size_t index = 0; index < count; index++)
+    {
+        if (depths[index] != unknownDepth)
+            levelStart[depths[index] + 1]++;
+    }
+    for (size_t level = 1; level < levelStart.size(); level++)
+    {
+        levelStart[level] += levelStart[level - 1];
+    }
+
+    // Remember where each level starts, for the parallel update
+    m_levelOffsets = levelStart;
+
+    std::vector<uint32_t> order(levelStart.back());
+    std::vector<int32_t> oldToNew(count, -1);
+    for (size_t index = 0; index < count; index++)
+    {
+        if (depths[index] == unknownDepth)
+            continue;
+
+        uint32_t newIndex = levelStart[depths[index]]++;
+        order[newIndex] = static_cast<uint32_t>(index);
+        oldToNew[index] = static_cast<int32_t>(newIndex);
+    }
+
+    for (auto& parent : m_parents)
+    {
+        if (parent >= 0)
+            parent = oldToNew[parent];
+    }
+
+    Permute(m_parents, order);
+    Permute(m_indexToHandle, order);
+    Permute(m_localRotation, order);
+    Permute(m_localEuler, order);
+    Permute(m_localTranslation, order);
+    Permute(m_localScale, order);
+    Permute(m_dirty, order);
+    Permute(m_worldTransform, order);
+    Permute(m_worldRotationQuat, order);
+    Permute(m_worldScale, order);
+    Permute(m_worldDecomposed, order);
+
+    for (size_t index = 0; index < m_indexToHandle.size(); index++)
+    {
+        m_handleToIndex[m_indexToHandle[index]] = static_cast<uint32_t>(index);
+    }
+
+    m_orderDirty = false;
+}
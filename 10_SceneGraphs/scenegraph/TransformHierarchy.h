@@ -0,0 +1,127 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class JobSystem;
+
+/// @brief Timing and size information about the last call to TransformHierarchy::Update
+struct TransformStats
+{
+    size_t nodeCount = 0;
+    size_t nodesRecomputed = 0;
+    unsigned workerCount = 1;
+    double updateMilliseconds = 0.0;
+};
+
+/// @brief Flattened, data-oriented storage for every transform in a scene graph.
+///
+/// Rather than having each SceneNode own its matrices and walk its children recursively, all the
+/// transform data lives here in flat arrays (one entry per node). Entries are kept sorted by depth
+/// in the hierarchy, which guarantees that a parent is always stored before any of its children,
+/// so the world transforms can be computed with a single linear pass over the arrays.
+///
+/// Only entries whose local transform has changed since the last update, and their descendants,
+/// get recomputed; everything else keeps the world transform it already has. The world rotation
+/// and scale are only decomposed out of the world matrix on the first query after it changes.
+///
+/// Given a JobSystem, the update processes one depth level at a time, splitting each level across
+/// the workers.
+///
+/// SceneNodes refer to their entry through a Handle, which remains stable even when the entries
+/// get re-ordered because of changes to the topology of the graph.
+class TransformHierarchy
+{
+public:
+    using Handle = uint32_t;
+    static constexpr Handle InvalidHandle = UINT32_MAX;
+
+    TransformHierarchy() = default;
+
+    Handle Create();
+    void Destroy(Handle handle);
+    bool SetParent(Handle child, Handle parent);
+
+    void SetLocalTransform(Handle handle, const DirectX::XMMATRIX& local);
+    void SetLocalRotation(Handle handle, float x, float y, float z);
+    void SetLocalRotationQuat(Handle handle, const DirectX::XMFLOAT4& rotation);
+    void SetLocalTranslation(Handle handle, float x, float y, float z);
+    void SetLocalScale(Handle handle, float x, float y, float z);
+
+    DirectX::XMFLOAT3 GetLocalRotation(Handle handle) const;
+    DirectX::XMFLOAT4 GetLocalRotationQuat(Handle handle) const;
+    DirectX::XMFLOAT3 GetLocalTranslation(Handle handle) const;
+    DirectX::XMFLOAT3 GetLocalScale(Handle handle) const;
+
+    const DirectX::XMMATRIX& GetWorldTransform(Handle handle) const;
+    DirectX::XMFLOAT4 GetWorldRotationQuat(Handle handle) const;
+    DirectX::XMFLOAT3 GetWorldTranslation(Handle handle) const;
+    DirectX::XMFLOAT3 GetWorldScale(Handle handle) const;
+
+    void Update();
+    void Invalidate();
+
+    void SetJobSystem(std::shared_ptr<JobSystem> jobSystem);
+    void SetParallelUpdate(bool parallel) { m_parallelUpdate = parallel; }
+    bool GetParallelUpdate() const { return m_parallelUpdate; }
+
+    size_t GetNodeCount() const { return m_parents.size(); }
+    uint64_t GetTopologyVersion() const { return m_topologyVersion; }
+
+    /// @brief Bump the topology version without changing the hierarchy, for changes to what hangs
+    /// off the transforms that whatever follows the version has to start over for, such as a node
+    /// gaining or losing something to draw
+    void TouchTopology() { m_topologyVersion++; }
+
+    /// @brief The transforms the last Update recomputed, so whatever follows them (bounds, say)
+    /// only has to look at those. Replaced by every Update.
+    const std::vector<Handle>& GetRecomputed() const { return m_recomputed; }
+    const TransformStats& GetStats() const { return m_stats; }
+
+private:
+    void RebuildOrder();
+    size_t UpdateRange(uint32_t begin, uint32_t end);
+    void DecomposeWorld(uint32_t index) const;
+
+    // Handle <-> dense index indirection
+    std::vector<uint32_t> m_handleToIndex;
+    std::vector<Handle> m_indexToHandle;
+    std::vector<Handle> m_freeHandles;
+
+    // Hierarchy, stored in depth order. -1 denotes a root.
+    std::vector<int32_t> m_parents;
+
+    // Index of the first entry at each depth, plus one past the last entry
+    std::vector<uint32_t> m_levelOffsets;
+
+    // Local TRS, stored as structure-of-arrays. Rotation is a quaternion.
+    std::vector<DirectX::XMFLOAT4> m_localRotation;
+    std::vector<DirectX::XMFLOAT3> m_localTranslation;
+    std::vector<DirectX::XMFLOAT3> m_localScale;
+
+    // The local rotation as Euler degrees, for the convenience API. Never used by the update pass.
+    std::vector<DirectX::XMFLOAT3> m_localEuler;
+
+    // Set when the local transform (or the parent) changes. Propagated to children during the update pass.
+    std::vector<uint8_t> m_dirty;
+
+    // Results of the update pass
+    std::vector<DirectX::XMMATRIX> m_worldTransform;
+    std::vector<Handle> m_recomputed;
+
+    // World rotation and scale, decomposed lazily from m_worldTransform when first queried.
+    // m_worldDecomposed is cleared whenever the update pass recomputes the world transform.
+    mutable std::vector<DirectX::XMFLOAT4> m_worldRotationQuat;
+    mutable std::vector<DirectX::XMFLOAT3> m_worldScale;
+    mutable std::vector<uint8_t> m_worldDecomposed;
+
+    bool m_orderDirty = false;
+    uint64_t m_topologyVersion = 0; // Bumped every time a transform is created, destroyed or re-parented, or by TouchTopology
+
+    std::shared_ptr<JobSystem> m_jobSystem;
+    bool m_parallelUpdate = true;
+
+    TransformStats m_stats;
+};
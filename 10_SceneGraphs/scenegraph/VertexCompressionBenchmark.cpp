@@ -0,0 +1,118 @@
+#include "VertexCompressionBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "VertexCompression.h"
+
+namespace
+{
+    constexpr uint32_t c_sphereRings = 256;
+    constexpr uint32_t c_sphereSegments = 512;
+    constexpr float c_sphereRadius = 50.0f;
+    constexpr float c_uvTiling = 3.7f;     // not a power of two, so the coordinates aren't exact in half floats
+
+    // A float vertex with the material colour in it, which is what every mesh vertex was before
+    constexpr size_t c_colorVertexBytes = 12 * sizeof(float);
+
+    // Bounds on the error of each encoding. Positions get a little slack for float rounding in the
+    // encode and decode; the normal bound is comfortably above what two 16 bit components give.
+    constexpr float c_maxPositionSteps = 0.51f;
+    constexpr float c_maxNormalDegrees = 0.01f;
+    constexpr float c_maxUVRelativeError = 1.0f / 2048.0f;
+
+    constexpr float c_pi = 3.14159265f;
+
+    /// @brief A UV sphere away from the origin, so the quantization has an offset to deal with
+    std::vector<VertexNormalUV> MakeSphere()
+    {
+        std::vector<VertexNormalUV> vertices;
+        vertices.reserve(static_cast<size_t>(c_sphereRings + 1) * (c_sphereSegments + 1));
+        for (uint32_t ring = 0; ring <= c_sphereRings; ring++)
+        {
+            float theta = c_pi * ring / c_sphereRings;
+            for (uint32_t segment = 0; segment <= c_sphereSegments; segment++)
+            {
+                float phi = 2.0f * c_pi * segment / c_sphereSegments;
+                float nx = std::sin(theta) * std::cos(phi);
+                float ny = std::cos(theta);
+                float nz = std::sin(theta) * std::sin(phi);
+                vertices.push_back(VertexNormalUV{
+                    10.0f + nx * c_sphereRadius, -3.0f + ny * c_sphereRadius, 7.0f + nz * c_sphereRadius,
+                    nx, ny, nz,
+                    c_uvTiling * segment / c_sphereSegments, c_uvTiling * ring / c_sphereRings });
+            }
+        }
+        return vertices;
+    }
+}
+
+VertexCompressionBenchmarkResult RunVertexCompressionBenchmark()
+{
+    VertexCompressionBenchmarkResult result;
+
+    auto vertices = MakeSphere();
+    result.vertexCount = vertices.size();
+    result.colorVertexBytes = vertices.size() * c_colorVertexBytes;
+    result.floatVertexBytes = vertices.size() * sizeof(VertexNormalUV);
+    result.packedVertexBytes = vertices.size() * sizeof(PackedVertexNormalUV);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto quantization = ComputePositionQuantization(vertices.data(), vertices.size(), sizeof(VertexNormalUV));
+    std::vector<PackedVertexNormalUV> packed(vertices.size());
+    PackVertices(vertices.data(), vertices.size(), quantization, packed.data());
+    auto end = std::chrono::high_resolution_clock::now();
+    result.packMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    for (size_t index = 0; index < vertices.size(); index++)
+    {
+        const auto& source = vertices[index];
+        const auto& encoded = packed[index];
+
+        float position[3];
+        DequantizePosition(encoded.position, quantization, position);
+        const float* sourcePosition = &source.x;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float step = quantization.scale[axis] / 65535.0f;
+            if (step > 0.0f)
+                result.maxPositionError = std::max(result.maxPositionError, std::fabs(position[axis] - sourcePosition[axis]) / step);
+        }
+
+        float normal[3];
+        DecodeOctahedralNormal(encoded.normal, normal);
+        float cosine = std::clamp(normal[0] * source.nx + normal[1] * source.ny + normal[2] * source.nz, -1.0f, 1.0f);
+        // acos loses precision near 1, so measure the angle from the length of the difference
+        float dx = normal[0] - source.nx;
+        float dy = normal[1] - source.ny;
+        float dz = normal[2] - source.nz;
+        float angle = cosine > 0.0f ? 2.0f * std::asin(std::min(std::sqrt(dx * dx + dy * dy + dz * dz) * 0.5f, 1.0f)) : std::acos(cosine);
+        result.maxNormalErrorDegrees = std::max(result.maxNormalErrorDegrees, angle * 180.0f / c_pi);
+
+        const float* sourceUV = &source.u;
+        for (int component = 0; component < 2; component++)
+        {
+            float error = std::fabs(HalfToFloat(encoded.uv[component]) - sourceUV[component]);
+            result.maxUVError = std::max(result.maxUVError, error / std::max(std::fabs(sourceUV[component]), 1.0f));
+        }
+    }
+
+    result.withinBounds = result.maxPositionError <= c_maxPositionSteps
+        && result.maxNormalErrorDegrees <= c_maxNormalDegrees
+        && result.maxUVError <= c_maxUVRelativeError;
+
+    return result;
+}
+
+void ReportVertexCompressionBenchmark(const VertexCompressionBenchmarkResult& result, std::ostream& out)
+{
+    out << "Vertex compression benchmark, " << result.vertexCount << " vertices packed in " << result.packMilliseconds
+        << " ms: " << result.colorVertexBytes / 1024 << " KB with colour, " << result.floatVertexBytes / 1024 << " KB as floats, "
+        << result.packedVertexBytes / 1024 << " KB packed. Max error: position " << result.maxPositionError << " steps, normal "
+        << result.maxNormalErrorDegrees << " degrees, uv " << result.maxUVError
+        << (result.withinBounds ? "" : ", OUTSIDE the error bounds!") << "\n";
+}
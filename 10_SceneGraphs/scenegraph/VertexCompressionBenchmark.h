@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+/// @brief The result of packing a synthetic mesh and unpacking it again
+struct VertexCompressionBenchmarkResult
+{
+    size_t vertexCount = 0;
+    size_t colorVertexBytes = 0;        // uploaded as position, colour, normal and uv floats, as before packing
+    size_t floatVertexBytes = 0;        // as VertexNormalUV, full floats without the colour
+    size_t packedVertexBytes = 0;       // as PackedVertexNormalUV
+    double packMilliseconds = 0.0;
+
+    float maxPositionError = 0.0f;      // in quantization steps; rounding keeps it to half a step
+    float maxNormalErrorDegrees = 0.0f;
+    float maxUVError = 0.0f;            // relative to the coordinate, as half floats have 11 bits of precision
+    bool withinBounds = false;          // every error is inside the bound for its encoding
+};
+
+/// @brief Pack a sphere's vertices the way the renderer does, decode them again the way the
+/// vertex shaders do and check the error of each encoding against its bound. Doesn't touch the
+/// GPU.
+VertexCompressionBenchmarkResult RunVertexCompressionBenchmark();
+
+/// @brief Write the sizes of each layout and the largest errors on one line
+void ReportVertexCompressionBenchmark(const VertexCompressionBenchmarkResult& result, std::ostream& out);
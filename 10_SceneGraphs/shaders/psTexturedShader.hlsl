@@ -1,7 +1,9 @@
 #pragma shader_model 5.0
 
-// Define texture and sampler
-Texture2D diffuseTexture : register(t0);
+// Define texture and sampler. s0 is the linear wrap static sampler (StaticSampler::LinearWrap),
+// bound once a frame by the SamplerCache rather than by each material. Textures are shared in
+// arrays; each submesh picks its slice through its mesh constants.
+Texture2DArray diffuseTextures : register(t0);
 SamplerState samplerState : register(s0);
 
 cbuffer LightBuffer : register(b0)
@@ -12,9 +14,8 @@ cbuffer LightBuffer : register(b0)
 
 struct VS_Input
 {
-    float3 position : POSITION;
-    float4 color : COLOR;
-    float3 normal : NORMAL;
+    float4 position : POSITION;
+    float2 normal : NORMAL;
     float2 texCoord : TEXCOORD;
 };
 
@@ -25,6 +26,7 @@ struct VS_Output
     float4 color : COLOR;
     float3 normal : NORMAL;
     float2 texCoord : TEXCOORD;
+    nointerpolation uint material : MATERIAL;   // the slice of the texture array to sample
 };
 
 static const float4 minColor = float4(0.0, 0.0, 0.0, 0.0);
@@ -37,7 +39,7 @@ float4 ps_main(VS_Output input) : SV_TARGET
 
     float3 lightDir = normalize(position - input.worldpos);
     float intensity = saturate(dot(input.normal, lightDir)); // this is the 'intensity' of the light
-    float4 sampledTexture = diffuseTexture.Sample(samplerState, input.texCoord);
+    float4 sampledTexture = diffuseTextures.Sample(samplerState, float3(input.texCoord, input.material));
     float4 diffuse = sampledTexture * intensity;
 
     return clamp(diffuse + ambient, minColor, maxColor);
@@ -10,11 +10,18 @@ cbuffer LocalToWorldBuffer : register(b1)
     row_major matrix localToWorld;
 }
 
+cbuffer MeshBuffer : register(b2)
+{
+    float4 positionScale;   // positions are 16 bit unorms across the mesh's bounds
+    float4 positionOffset;
+    float4 materialColor;
+    uint materialSlice;     // the slice of the texture array this submesh samples
+}
+
 struct VS_Input
 {
-    float3 position : POSITION;
-    float4 color : COLOR;
-    float3 normal : NORMAL;
+    float4 position : POSITION;
+    float2 normal : NORMAL;
     float2 texCoord : TEXCOORD;
 };
 
@@ -25,17 +32,32 @@ struct VS_Output
     float4 color : COLOR;
     float3 normal : NORMAL;
     float2 texCoord : TEXCOORD;
+    nointerpolation uint material : MATERIAL;   // the slice of the texture array to sample
 };
 
+// Normals are octahedral encoded: the unit vector is projected onto an octahedron whose lower
+// half is folded out over the corners of a square
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-normal.z);
+    normal.xy += normal.xy >= 0.0f ? -fold : fold;
+    return normalize(normal);
+}
+
 VS_Output vs_main(VS_Input input)
 {
     VS_Output output = (VS_Output) 0;
 
-    output.worldpos = mul(float4(input.position, 1.0f), localToWorld);
-    output.position = mul(float4(input.position, 1.0f), mul(localToWorld, ViewProjection));
-    output.color = input.color;
-    output.normal = normalize(mul(input.normal, (float3x3) localToWorld));
+    float3 position = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+    float3 normal = DecodeOctahedralNormal(input.normal);
+
+    output.worldpos = mul(float4(position, 1.0f), localToWorld);
+    output.position = mul(float4(position, 1.0f), mul(localToWorld, ViewProjection));
+    output.color = materialColor;
+    output.normal = normalize(mul(normal, (float3x3) localToWorld));
     output.texCoord = input.texCoord;
+    output.material = materialSlice;
 
     return output;
 }
@@ -0,0 +1,67 @@
+#pragma shader_model 5.0
+
+// Instanced variant of vsTexturedShader. The local to world matrix comes from the per-instance
+// vertex buffer rather than the LocalToWorldBuffer.
+cbuffer ViewProjectionBuffer : register(b0)
+{
+    row_major matrix ViewProjection;
+}
+
+cbuffer MeshBuffer : register(b2)
+{
+    float4 positionScale;   // positions are 16 bit unorms across the mesh's bounds
+    float4 positionOffset;
+    float4 materialColor;
+    uint materialSlice;     // the slice of the texture array this submesh samples
+}
+
+struct VS_Input
+{
+    float4 position : POSITION;
+    float2 normal : NORMAL;
+    float2 texCoord : TEXCOORD;
+    float4 world0 : WORLD0;
+    float4 world1 : WORLD1;
+    float4 world2 : WORLD2;
+    float4 world3 : WORLD3;
+};
+
+struct VS_Output
+{
+    float4 position : SV_POSITION;
+    float3 worldpos : POSITION;
+    float4 color : COLOR;
+    float3 normal : NORMAL;
+    float2 texCoord : TEXCOORD;
+    nointerpolation uint material : MATERIAL;   // the slice of the texture array to sample
+};
+
+// Normals are octahedral encoded: the unit vector is projected onto an octahedron whose lower
+// half is folded out over the corners of a square
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-normal.z);
+    normal.xy += normal.xy >= 0.0f ? -fold : fold;
+    return normalize(normal);
+}
+
+VS_Output vs_main(VS_Input input)
+{
+    VS_Output output = (VS_Output) 0;
+
+    float3 position = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+    float3 normal = DecodeOctahedralNormal(input.normal);
+
+    // Each WORLDn element is a row of the row major matrix
+    float4x4 localToWorld = float4x4(input.world0, input.world1, input.world2, input.world3);
+
+    output.worldpos = mul(float4(position, 1.0f), localToWorld).xyz;
+    output.position = mul(float4(position, 1.0f), mul(localToWorld, ViewProjection));
+    output.color = materialColor;
+    output.normal = normalize(mul(normal, (float3x3) localToWorld));
+    output.texCoord = input.texCoord;
+    output.material = materialSlice;
+
+    return output;
+}
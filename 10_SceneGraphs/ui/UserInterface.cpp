@@ -5,7 +5,29 @@
 #include "GraphicsDX11.h"
 #include "UserInterface.h"
 #include "OrbitCamera.h"
+#include "TransformBenchmark.h"
+#include "CullingBenchmark.h"
+#include "BvhBenchmark.h"
+#include "RenderQueueBenchmark.h"
+#include "InstancingBenchmark.h"
+#include "LargeMeshBenchmark.h"
+#include "LodBenchmark.h"
+#include "MeshOptimizerBenchmark.h"
+#include "ProceduralGeometryBenchmark.h"
+#include "VertexCompressionBenchmark.h"
+#include "AssetLoadingBenchmark.h"
+#include "ResourceCacheBenchmark.h"
+#include "TextureCompressionBenchmark.h"
+#include "ImageDecodeBenchmark.h"
+#include "SamplerCacheBenchmark.h"
+#include "TextureArrayBenchmark.h"
+#include "SubmeshBenchmark.h"
+#include "MeshImportBenchmark.h"
 #include <cstdio>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <GameData.h>
 
 //
@@ -15,6 +37,10 @@
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
+// Runs the benchmarks one at a time on a thread of its own, so the window goes on drawing while
+// they do. Each hands its result back as an upload, which DrawPerformance takes in on this thread.
+static std::unique_ptr<AsyncLoader> g_benchmarkRunner;
+
 /// @brief Passthrough to allow ImGui to do it's own windows message pump handling
 /// @param hWnd Handle to window
 /// @param msg Windows Message
@@ -55,9 +81,20 @@ HRESULT InitIMGUI(HWND hWnd, GraphicsDX11& graphics)
     ImGui_ImplWin32_Init(hWnd);
     ImGui_ImplDX11_Init(graphics.GetD3DDevice(), graphics.GetD3DDeviceContext());
 
+    g_benchmarkRunner = std::make_unique<AsyncLoader>(1);
+
     return S_OK;
 }
 
+// Squared distance, in pixels, the mouse may move between press and release and still count as a click
+constexpr float c_clickDragThresholdSquared = 9.0f;
+
+// Time a frame may spend taking in the results of finished benchmarks
+constexpr double c_benchmarkResultBudgetMilliseconds = 1.0;
+
+// The node last picked in the viewport or clicked in the scene graph
+static std::weak_ptr<SceneNode> g_selectedNode;
+
 struct TreeNodeData
 {
     bool showPosition = { true };
@@ -162,11 +199,14 @@ void DrawLight(const char* name, LightData& light)
 void DrawSceneGraph(std::shared_ptr<SceneNode> node)
 {
     ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_DefaultOpen;
+    if (g_selectedNode.lock() == node)
+        flags |= ImGuiTreeNodeFlags_Selected;
+
     bool nodeOpen = ImGui::TreeNodeEx(node->name.c_str(), flags);
 
     if(ImGui::IsItemClicked())
     {
-        // do something
+        g_selectedNode = node;
     }
 
     if(nodeOpen)
@@ -200,8 +240,396 @@ void DrawSceneGraph(std::shared_ptr<SceneNode> node)
     }
 }
 
+/// @brief Select the node under the mouse when the viewport is clicked. Dragging the mouse (to
+/// orbit the camera) doesn't count as a click.
+/// @param data Application data, for the camera
+/// @param sceneBvh Acceleration structure over the scene, to cast the ray into
+void PickSceneNode(GameData& data, const SceneBvh& sceneBvh)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    if (io.WantCaptureMouse || data.m_Camera == nullptr)
+        return;
+
+    if (!ImGui::IsMouseReleased(ImGuiMouseButton_Left) || io.MouseDragMaxDistanceSqr[ImGuiMouseButton_Left] > c_clickDragThresholdSquared)
+        return;
+
+    // Mouse position to normalized device co-ordinates, then back through the view projection
+    // onto the near and far planes
+    float x = 2.0f * io.MousePos.x / io.DisplaySize.x - 1.0f;
+    float y = 1.0f - 2.0f * io.MousePos.y / io.DisplaySize.y;
+
+    DirectX::XMMATRIX inverseViewProjection = DirectX::XMMatrixInverse(nullptr, data.m_Camera->GetVP());
+    DirectX::XMVECTOR nearPoint = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(x, y, 0.0f, 1.0f), inverseViewProjection);
+    DirectX::XMVECTOR farPoint = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(x, y, 1.0f, 1.0f), inverseViewProjection);
+
+    DirectX::XMFLOAT3 origin;
+    DirectX::XMFLOAT3 direction;
+    DirectX::XMStoreFloat3(&origin, nearPoint);
+    DirectX::XMStoreFloat3(&direction, DirectX::XMVectorSubtract(farPoint, nearPoint));
+
+    g_selectedNode = sceneBvh.Pick(origin, direction);
+}
+
+/// @brief Start a benchmark on the benchmark thread. Its report goes to the log, and its result is
+/// written to result once it has finished, when DrawPerformance next takes in results.
+template <typename TResult>
+void SubmitBenchmark(const char* name, TResult (*run)(), void (*report)(const TResult&, std::ostream&), TResult& result)
+{
+    g_benchmarkRunner->Submit(name, [run, report, &result]() -> AsyncLoader::UploadFunction
+        {
+            auto finished = std::make_shared<TResult>(run());
+
+            std::stringstream text;
+            report(*finished, text);
+            std::string line;
+            while (std::getline(text, line))
+            {
+                PLOG_INFO << line;
+            }
+
+            return [finished, &result]()
+            {
+                result = std::move(*finished);
+                return true;
+            };
+        });
+}
+
+/// @brief Render off the scene graph timings, and allow running the benchmarks
+/// @param data Application data, for the size of the prop field
+/// @param sceneRoot Root of the scene graph
+/// @param sceneBvh Acceleration structure over the scene
+/// @param rendererStats Counters from the renderer's last frame
+void DrawPerformance(GameData& data, std::shared_ptr<SceneNode> sceneRoot, const SceneBvh& sceneBvh, const RendererStats& rendererStats)
+{
+    static std::vector<TransformBenchmarkResult> benchmarkResults;
+    static std::vector<JobScalingResult> jobScalingResults;
+    static CullingBenchmarkResult cullingResult;
+    static std::vector<BvhBenchmarkResult> bvhResults;
+    static RenderQueueBenchmarkResult renderQueueResult;
+    static InstancingBenchmarkResult instancingResult;
+    static LargeMeshBenchmarkResult largeMeshResult;
+    static std::vector<MeshOptimizerBenchmarkResult> meshOptimizerResults;
+    static VertexCompressionBenchmarkResult vertexCompressionResult;
+    static LodBenchmarkResult lodResult;
+    static ProceduralGeometryBenchmarkResult proceduralResult;
+    static AssetLoadingBenchmarkResult assetLoadingResult;
+    static ResourceCacheBenchmarkResult resourceCacheResult;
+    static TextureCompressionBenchmarkResult textureCompressionResult;
+    static ImageDecodeBenchmarkResult imageDecodeResult;
+    static SamplerCacheBenchmarkResult samplerCacheResult;
+    static TextureArrayBenchmarkResult textureArrayResult;
+    static SubmeshBenchmarkResult submeshResult;
+    static MeshImportBenchmarkResult meshImportResult;
+
+    // Results only ever change here, on the UI thread, so drawing them never races the benchmark
+    g_benchmarkRunner->ProcessUploads(c_benchmarkResultBudgetMilliseconds);
+
+    if (!ImGui::CollapsingHeader("Performance"))
+        return;
+
+    auto hierarchy = sceneRoot->GetTransformHierarchy();
+    const auto& stats = hierarchy->GetStats();
+    ImGui::Text("Transform update: %zu of %zu nodes recomputed in %.3f ms (%u workers)", stats.nodesRecomputed, stats.nodeCount, stats.updateMilliseconds, stats.workerCount);
+
+    const auto& bvhStats = sceneBvh.GetStats();
+    ImGui::Text("Scene BVH %s: %zu of %zu nodes moved in %.3f ms", bvhStats.rebuilt ? "rebuilt" : "refitted",
+        bvhStats.nodesMoved, bvhStats.primitiveCount, bvhStats.updateMilliseconds);
+
+    const auto& renderQueueStats = rendererStats.renderQueue;
+    ImGui::Text("Render queue: %zu draws sorted in %.3f ms, %zu shader, %zu material, %zu geometry changes (%zu avoided)",
+        renderQueueStats.drawCount, renderQueueStats.sortMilliseconds, renderQueueStats.shaderChanges, renderQueueStats.materialChanges,
+        renderQueueStats.geometryChanges, renderQueueStats.stateChangesAvoided);
+
+    const auto& instancingStats = rendererStats.instancing;
+    ImGui::Text("Instancing: %zu draws batched into %zu draw calls, %zu instances in %zu instanced draws (%.3f ms)",
+        instancingStats.packetCount, instancingStats.drawCalls, instancingStats.instances, instancingStats.instancedBatches, instancingStats.buildMilliseconds);
+
+    const auto& stateCacheStats = rendererStats.stateCache;
+    ImGui::Text("State cache: %zu calls issued, %zu elided, %zu draws", stateCacheStats.issued, stateCacheStats.elided, stateCacheStats.draws);
+
+    const auto& constantBufferRingStats = rendererStats.constantBufferRing;
+    ImGui::Text("Constant buffer ring: %zu slices, %llu KB last frame, %llu of %llu KB in flight (peak %llu KB), %zu wraps",
+        constantBufferRingStats.frameAllocations, constantBufferRingStats.frameBytes / 1024, constantBufferRingStats.used / 1024,
+        constantBufferRingStats.capacity / 1024, constantBufferRingStats.peakUsed / 1024, constantBufferRingStats.wraps);
+
+    const auto& lodDraws = rendererStats.lodDraws;
+    ImGui::Text("Levels of detail: %u / %u / %u / %u nodes at LOD 0 / 1 / 2 / 3", lodDraws[0], lodDraws[1], lodDraws[2], lodDraws[3]);
+
+    const auto& loadingStats = rendererStats.assetLoading;
+    ImGui::Text("Assets: %u queued, %u loading, %u waiting for upload, %u loaded, %u failed; %u uploads in %.3f ms last frame",
+        loadingStats.queued, loadingStats.loading, loadingStats.waitingForUpload, loadingStats.completed, loadingStats.failed,
+        loadingStats.uploadsLastFrame, loadingStats.uploadMillisecondsLastFrame);
+    if (!loadingStats.lastFailed.empty())
+        ImGui::Text("  Last asset to fail: %s", loadingStats.lastFailed.c_str());
+
+    const auto& stagingStats = rendererStats.imageStaging;
+    ImGui::Text("Image staging: %.1f of %.1f MB reserved (peak %.1f MB), %.1f MB kept; %llu of %llu buffers reused, %llu waits (%.1f ms)",
+        stagingStats.reservedBytes / (1024.0 * 1024.0), stagingStats.budgetBytes / (1024.0 * 1024.0), stagingStats.peakReservedBytes / (1024.0 * 1024.0),
+        stagingStats.freeBytes / (1024.0 * 1024.0), static_cast<unsigned long long>(stagingStats.reuses), static_cast<unsigned long long>(stagingStats.takes),
+        static_cast<unsigned long long>(stagingStats.waits), stagingStats.waitMilliseconds);
+
+    const auto& samplerStats = rendererStats.samplers;
+    ImGui::Text("Samplers: %u created, %u bound once a frame; %llu of %llu lookups found one already", samplerStats.unique, c_staticSamplerCount,
+        static_cast<unsigned long long>(samplerStats.hits), static_cast<unsigned long long>(samplerStats.lookups));
+
+    const auto& arrayStats = rendererStats.textureArrays;
+    ImGui::Text("Texture arrays: %u textures in %u arrays of %u slices, %.1f of %.1f MB used; %llu grown, copying %.1f MB",
+        arrayStats.textures, arrayStats.arrays, arrayStats.capacitySlices, arrayStats.usedBytes / (1024.0 * 1024.0), arrayStats.capacityBytes / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(arrayStats.grows), arrayStats.grownBytes / (1024.0 * 1024.0));
+
+    const auto& resourceReport = rendererStats.resources;
+    ImGui::Text("Resources: %.1f MB held", resourceReport.totalBytes / (1024.0 * 1024.0));
+    for (size_t type = 0; type < c_resourceTypeCount; type++)
+    {
+        const auto& resourceStats = resourceReport.types[type];
+        ImGui::Text("  %s: %u resident (%.1f KB), %u waiting to be destroyed (%.1f KB); %u hits, %u misses, %u destroyed",
+            GetResourceTypeName(static_cast<ResourceType>(type)), resourceStats.resident, resourceStats.residentBytes / 1024.0,
+            resourceStats.pendingDestroy, resourceStats.pendingBytes / 1024.0, resourceStats.hits, resourceStats.misses, resourceStats.destroyed);
+    }
+
+    ImGui::SliderInt("Prop copies", &data.m_propCount, 0, 20000);
+
+    bool parallelUpdate = hierarchy->GetParallelUpdate();
+    if (ImGui::Checkbox("Parallel transform update", &parallelUpdate))
+        hierarchy->SetParallelUpdate(parallelUpdate);
+
+    // Only one benchmark runs at a time, on the benchmark thread; its result appears below when it is done
+    struct Benchmark
+    {
+        const char* name;
+        void (*submit)();
+    };
+    static const Benchmark benchmarks[] = {
+        { "Transform", []() { SubmitBenchmark("transform benchmark", RunTransformBenchmark, ReportTransformBenchmark, benchmarkResults); } },
+        { "Job scaling", []() { SubmitBenchmark("job scaling benchmark", RunJobScalingBenchmark, ReportJobScalingBenchmark, jobScalingResults); } },
+        { "Culling", []() { SubmitBenchmark("culling benchmark", RunCullingBenchmark, ReportCullingBenchmark, cullingResult); } },
+        { "BVH", []() { SubmitBenchmark("BVH benchmark", RunBvhBenchmark, ReportBvhBenchmark, bvhResults); } },
+        { "Render queue", []() { SubmitBenchmark("render queue benchmark", RunRenderQueueBenchmark, ReportRenderQueueBenchmark, renderQueueResult); } },
+        { "Instancing", []() { SubmitBenchmark("instancing benchmark", RunInstancingBenchmark, ReportInstancingBenchmark, instancingResult); } },
+        { "Large mesh", []() { SubmitBenchmark("large mesh benchmark", RunLargeMeshBenchmark, ReportLargeMeshBenchmark, largeMeshResult); } },
+        { "Mesh optimizer", []() { SubmitBenchmark("mesh optimizer benchmark", RunMeshOptimizerBenchmark, ReportMeshOptimizerBenchmark, meshOptimizerResults); } },
+        { "Vertex compression", []() { SubmitBenchmark("vertex compression benchmark", RunVertexCompressionBenchmark, ReportVertexCompressionBenchmark, vertexCompressionResult); } },
+        { "LOD", []() { SubmitBenchmark("LOD benchmark", RunLodBenchmark, ReportLodBenchmark, lodResult); } },
+        { "Procedural geometry", []() { SubmitBenchmark("procedural geometry benchmark", RunProceduralGeometryBenchmark, ReportProceduralGeometryBenchmark, proceduralResult); } },
+        { "Asset loading", []() { SubmitBenchmark("asset loading benchmark", RunAssetLoadingBenchmark, ReportAssetLoadingBenchmark, assetLoadingResult); } },
+        { "Resource cache", []() { SubmitBenchmark("resource cache benchmark", RunResourceCacheBenchmark, ReportResourceCacheBenchmark, resourceCacheResult); } },
+        { "Texture compression", []() { SubmitBenchmark("texture compression benchmark", RunTextureCompressionBenchmark, ReportTextureCompressionBenchmark, textureCompressionResult); } },
+        { "Image decode", []() { SubmitBenchmark("image decode benchmark", RunImageDecodeBenchmark, ReportImageDecodeBenchmark, imageDecodeResult); } },
+        { "Sampler cache", []() { SubmitBenchmark("sampler cache benchmark", RunSamplerCacheBenchmark, ReportSamplerCacheBenchmark, samplerCacheResult); } },
+        { "Texture array", []() { SubmitBenchmark("texture array benchmark", RunTextureArrayBenchmark, ReportTextureArrayBenchmark, textureArrayResult); } },
+        { "Submesh", []() { SubmitBenchmark("submesh benchmark", RunSubmeshBenchmark, ReportSubmeshBenchmark, submeshResult); } },
+        { "Mesh import", []() { SubmitBenchmark("mesh import benchmark", RunMeshImportBenchmark, ReportMeshImportBenchmark, meshImportResult); } },
+    };
+    static size_t selectedBenchmark = 0;
+
+    if (ImGui::BeginCombo("Benchmark", benchmarks[selectedBenchmark].name))
+    {
+        for (size_t index = 0; index < std::size(benchmarks); index++)
+        {
+            if (ImGui::Selectable(benchmarks[index].name, index == selectedBenchmark))
+                selectedBenchmark = index;
+        }
+        ImGui::EndCombo();
+    }
+
+    if (!g_benchmarkRunner->IsIdle())
+        ImGui::Text("Running the benchmark...");
+    else if (ImGui::Button("Run benchmark"))
+        benchmarks[selectedBenchmark].submit();
+
+    for (const auto& result : benchmarkResults)
+    {
+        ImGui::Text("%zu nodes: recursive %.3f ms, flattened %.3f ms, incremental %.3f ms (%zu recomputed)",
+            result.nodeCount, result.recursiveMilliseconds, result.flattenedMilliseconds, result.incrementalMilliseconds, result.incrementalNodesRecomputed);
+    }
+
+    for (const auto& result : jobScalingResults)
+    {
+        ImGui::Text("%u workers: %.3f ms%s", result.workerCount, result.milliseconds, result.matchesSerial ? "" : " (does not match serial update!)");
+    }
+
+    if (cullingResult.objectCount > 0)
+    {
+        ImGui::Text("%zu objects, %zu visible: sphere and box %.3f ms, batched spheres %.3f ms",
+            cullingResult.objectCount, cullingResult.visibleCount, cullingResult.boundsMilliseconds, cullingResult.spheresMilliseconds);
+    }
+
+    for (const auto& result : bvhResults)
+    {
+        ImGui::Text("%zu primitives: build %.3f ms, refit %.3f ms, incremental refit %.3f ms, frustum query %.3f ms (%zu visible), ray %.3f us",
+            result.primitiveCount, result.buildMilliseconds, result.refitMilliseconds, result.incrementalRefitMilliseconds,
+            result.frustumQueryMilliseconds, result.frustumQueryResults, result.raycastMicroseconds);
+    }
+
+    if (renderQueueResult.drawCount > 0)
+    {
+        ImGui::Text("%zu draws: keys %.3f ms, radix sort %.3f ms, std::sort %.3f ms, state changes %zu unsorted, %zu sorted",
+            renderQueueResult.drawCount, renderQueueResult.keyMilliseconds, renderQueueResult.radixSortMilliseconds,
+            renderQueueResult.stdSortMilliseconds, renderQueueResult.unsortedStateChanges, renderQueueResult.sortedStateChanges);
+    }
+
+    if (instancingResult.drawCount > 0)
+    {
+        ImGui::Text("%zu draws: %zu draw calls after batching (%zu instanced), sort %.3f ms, batch %.3f ms",
+            instancingResult.drawCount, instancingResult.drawCalls, instancingResult.instancedBatches,
+            instancingResult.sortMilliseconds, instancingResult.batchMilliseconds);
+    }
+
+    if (largeMeshResult.triangleCount > 0)
+    {
+        ImGui::Text("%zu triangles, %zu vertices (%zu indices past 16 bits): fill %.3f ms, %zu KB of 32 bit indices",
+            largeMeshResult.triangleCount, largeMeshResult.vertexCount, largeMeshResult.wrappedIndices,
+            largeMeshResult.fillMilliseconds, largeMeshResult.longIndexBytes / 1024);
+        ImGui::Text("Split into %zu clusters in %.3f ms: %zu vertices, %zu KB of 16 bit indices%s",
+            largeMeshResult.clusterCount, largeMeshResult.splitMilliseconds, largeMeshResult.splitVertexCount,
+            largeMeshResult.splitIndexBytes / 1024, largeMeshResult.valid ? "" : " (clusters do not match the source mesh!)");
+    }
+
+    for (const auto& result : meshOptimizerResults)
+    {
+        const auto& report = result.report;
+        ImGui::Text("%s, %zu triangles in %.3f ms: ACMR FIFO %.3f -> %.3f, LRU %.3f -> %.3f, ATVR FIFO %.3f -> %.3f",
+            result.name.c_str(), report.fifoBefore.triangleCount, report.milliseconds, report.fifoBefore.acmr, report.fifoAfter.acmr,
+            report.lruBefore.acmr, report.lruAfter.acmr, report.fifoBefore.atvr, report.fifoAfter.atvr);
+    }
+
+    if (vertexCompressionResult.vertexCount > 0)
+    {
+        ImGui::Text("%zu vertices packed in %.3f ms: %zu KB with colour, %zu KB as floats, %zu KB packed",
+            vertexCompressionResult.vertexCount, vertexCompressionResult.packMilliseconds, vertexCompressionResult.colorVertexBytes / 1024,
+            vertexCompressionResult.floatVertexBytes / 1024, vertexCompressionResult.packedVertexBytes / 1024);
+        ImGui::Text("Max error: position %.3f steps, normal %.5f degrees, uv %.6f%s",
+            vertexCompressionResult.maxPositionError, vertexCompressionResult.maxNormalErrorDegrees, vertexCompressionResult.maxUVError,
+            vertexCompressionResult.withinBounds ? "" : " (outside the error bounds!)");
+    }
+
+    if (lodResult.levelCount > 0)
+    {
+        ImGui::Text("%zu triangles simplified into %u levels in %.1f ms (%.2f M triangles/s), full mesh error %.5f",
+            lodResult.triangleCount, lodResult.levelCount, lodResult.milliseconds, lodResult.trianglesPerSecond / 1.0e6, lodResult.baseError);
+        for (uint32_t level = 0; level < lodResult.levelCount; level++)
+        {
+            const auto& lod = lodResult.levels[level];
+            ImGui::Text("  LOD %u: %zu triangles (%.1f%%), error estimated %.5f, measured %.5f, picked from %.1f units",
+                level, lod.triangleCount, lod.reduction * 100.0f, lod.estimatedError, lod.measuredError, lod.switchDistance);
+        }
+        if (!lodResult.selectionConsistent)
+            ImGui::Text("  LOD selection picked a level outside the pixel budget!");
+    }
+
+    for (const auto& sphere : proceduralResult.spheres)
+    {
+        ImGui::Text("Sphere %ux%u: %zu triangles in %.2f ms (%.1f M triangles/s), radius error %.2g, normal error %.3f degrees",
+            sphere.slices, sphere.stacks, sphere.triangleCount, sphere.milliseconds, sphere.trianglesPerSecond / 1.0e6,
+            sphere.maxRadiusError, sphere.maxNormalErrorDegrees);
+    }
+
+    if (assetLoadingResult.assetCount > 0)
+    {
+        ImGui::Text("%zu meshes (%zu triangles) and textures (%zu K texels): serial %.1f ms in one frame",
+            assetLoadingResult.assetCount, assetLoadingResult.triangleCount, assetLoadingResult.texelCount / 1024, assetLoadingResult.serialMilliseconds);
+        for (const auto& run : assetLoadingResult.runs)
+        {
+            ImGui::Text("  %u loader threads: %.1f ms over %u frames, at most %.3f ms of uploads a frame (budget %.1f ms)%s",
+                run.workerCount, run.milliseconds, run.frames, run.worstFrameMilliseconds, assetLoadingResult.budgetMilliseconds,
+                run.matchesSerial ? "" : " (does not match the serial load!)");
+        }
+        if (!assetLoadingResult.failuresReported)
+            ImGui::Text("  A corrupt asset was not reported correctly!");
+    }
+
+    if (resourceCacheResult.frames > 0)
+    {
+        ImGui::Text("Resource cache: %zu acquires over %u frames in %.2f ms (%.1f M/s), %zu loads for %zu resources, %zu destroyed",
+            resourceCacheResult.acquires, resourceCacheResult.frames, resourceCacheResult.milliseconds, resourceCacheResult.acquiresPerSecond / 1.0e6,
+            resourceCacheResult.creates, resourceCacheResult.resourceCount, resourceCacheResult.destroyed);
+        ImGui::Text("  Peak %.1f MB held, of %.1f MB for every resource", resourceCacheResult.peakBytes / (1024.0 * 1024.0),
+            resourceCacheResult.uniqueBytes / (1024.0 * 1024.0));
+    }
+
+    if (textureCompressionResult.imageCount > 0)
+    {
+        ImGui::Text("Texture pipeline: %zu %s images, %zu K texels: mips %.1f Mtexels/s box, %.1f Mtexels/s Kaiser", textureCompressionResult.imageCount,
+            textureCompressionResult.procedural ? "generated" : "source", textureCompressionResult.texelCount / 1024,
+            textureCompressionResult.boxMegatexelsPerSecond, textureCompressionResult.kaiserMegatexelsPerSecond);
+        for (const auto& format : textureCompressionResult.formats)
+        {
+            if (format.hasAlpha)
+                ImGui::Text("  %s: %.2f Mtexels/s, %zu of %zu KB, PSNR %.2f dB colour, %.2f dB alpha", format.name.c_str(), format.megatexelsPerSecond,
+                    format.bytes / 1024, textureCompressionResult.uncompressedBytes / 1024, format.colourPsnr, format.alphaPsnr);
+            else
+                ImGui::Text("  %s: %.2f Mtexels/s, %zu of %zu KB, PSNR %.2f dB colour", format.name.c_str(), format.megatexelsPerSecond,
+                    format.bytes / 1024, textureCompressionResult.uncompressedBytes / 1024, format.colourPsnr);
+        }
+    }
+
+    if (imageDecodeResult.imageCount > 0)
+    {
+        ImGui::Text("Image pipeline: RGB to RGBA %.0f MB/s (plain loop %.0f), premultiply %.0f MB/s (plain loop %.0f), in linear light %.0f MB/s",
+            imageDecodeResult.expandMegabytesPerSecond, imageDecodeResult.expandScalarMegabytesPerSecond, imageDecodeResult.premultiplyMegabytesPerSecond,
+            imageDecodeResult.premultiplyScalarMegabytesPerSecond, imageDecodeResult.premultiplySrgbMegabytesPerSecond);
+        ImGui::Text("  %zu %s images decoded %zu times (%zu KB to %zu KB) on %u loader threads", imageDecodeResult.imageCount,
+            imageDecodeResult.procedural ? "generated" : "source", imageDecodeResult.decodeCount, imageDecodeResult.encodedBytes / 1024,
+            imageDecodeResult.decodedBytes / 1024, imageDecodeResult.workerCount);
+        for (const auto& run : imageDecodeResult.runs)
+        {
+            ImGui::Text("  %s: %.1f ms over %u frames, %.1f MB/s in, %.1f MB/s out, at most %zu KB held, resident +%zu KB%s", run.name.c_str(),
+                run.milliseconds, run.frames, run.encodedMegabytesPerSecond, run.decodedMegabytesPerSecond, run.peakHeldBytes / 1024,
+                run.peakResidentBytes / 1024, run.matches ? "" : " (runs don't match!)");
+        }
+        ImGui::Text("  Pool budget %zu KB, %llu buffers reused, %llu waits; process peak resident %zu KB", imageDecodeResult.budgetBytes / 1024,
+            static_cast<unsigned long long>(imageDecodeResult.poolReuses), static_cast<unsigned long long>(imageDecodeResult.poolWaits),
+            imageDecodeResult.processPeakResidentBytes / 1024);
+    }
+
+    if (samplerCacheResult.lookups > 0)
+    {
+        ImGui::Text("Sampler cache: %zu lookups of %u samplers: %.1f ns each hashed, %.1f ns keyed as hex", samplerCacheResult.lookups,
+            samplerCacheResult.distinctSamplers, samplerCacheResult.hashedNanoseconds, samplerCacheResult.stringNanoseconds);
+        ImGui::Text("  %u draws of %u materials a frame: %zu sampler binds (%zu to the device) before, %zu (%zu) with static samplers",
+            samplerCacheResult.drawsPerFrame, samplerCacheResult.materials, samplerCacheResult.samplerBindsBefore, samplerCacheResult.samplerCallsBefore,
+            samplerCacheResult.samplerBindsAfter, samplerCacheResult.samplerCallsAfter);
+    }
+
+    if (textureArrayResult.textures > 0)
+    {
+        ImGui::Text("Texture arrays: %u textures of %u shapes in %u arrays: %.1f of %.1f MB used; %llu grows copying %.1f MB; %.1f ns a texture",
+            textureArrayResult.textures, textureArrayResult.shapes, textureArrayResult.arrays, textureArrayResult.textureBytes / (1024.0 * 1024.0),
+            textureArrayResult.arrayBytes / (1024.0 * 1024.0), static_cast<unsigned long long>(textureArrayResult.grows),
+            textureArrayResult.grownBytes / (1024.0 * 1024.0), textureArrayResult.placeNanoseconds);
+        ImGui::Text("  %u draws of %u geometries with %u textures each: %zu material changes, %zu texture binds, %zu draw calls by texture; %zu, %zu, %zu by array",
+            textureArrayResult.drawsPerFrame, textureArrayResult.geometries, textureArrayResult.variants, textureArrayResult.materialChangesBefore,
+            textureArrayResult.textureCallsBefore, textureArrayResult.drawCallsBefore, textureArrayResult.materialChangesAfter,
+            textureArrayResult.textureCallsAfter, textureArrayResult.drawCallsAfter);
+    }
+
+    if (submeshResult.frames > 0)
+    {
+        ImGui::Text("Submeshes: %u materials, %u submeshes, %zu vertices, %zu triangles: prepared in %.1f ms, %.1f ms as a renderable per material",
+            submeshResult.materials, submeshResult.submeshes, submeshResult.vertexCount, submeshResult.triangleCount,
+            submeshResult.prepareMilliseconds, submeshResult.prepareBeforeMilliseconds);
+        ImGui::Text("  %u buffers of %zu KB vs %u of %zu KB; %zu KB of colour no longer baked into the vertices",
+            submeshResult.buffersAfter, submeshResult.gpuBytesAfter / 1024, submeshResult.buffersBefore, submeshResult.gpuBytesBefore / 1024,
+            submeshResult.bakedColourBytes / 1024);
+        ImGui::Text("  %u meshes a frame: %zu buffer binds and %zu draws vs %zu and %zu",
+            submeshResult.meshesPerFrame, submeshResult.bufferBindsAfter, submeshResult.drawsAfter, submeshResult.bufferBindsBefore, submeshResult.drawsBefore);
+    }
+
+    if (meshImportResult.meshes > 0)
+    {
+        ImGui::Text("Mesh import: %u meshes, %zu vertices, %zu triangles merged at %.1f M vertices/s a mesh after another, %.1f M vertices/s in two passes",
+            meshImportResult.meshes, meshImportResult.vertexCount, meshImportResult.triangleCount,
+            meshImportResult.singlePassVerticesPerSecond / 1e6, meshImportResult.twoPassVerticesPerSecond / 1e6);
+        for (const auto& scaling : meshImportResult.scaling)
+        {
+            ImGui::Text("  %u workers: %.1f M vertices/s%s", scaling.workerCount, scaling.verticesPerSecond / 1e6, scaling.matchesSerial ? "" : " (MISMATCH)");
+        }
+    }
+}
+
 /// @brief Draw our UI
-void DrawUI(GameData& data, std::shared_ptr<SceneNode> sceneRoot)
+void DrawUI(GameData& data, std::shared_ptr<SceneNode> sceneRoot, const SceneBvh& sceneBvh, const RendererStats& rendererStats)
 {
     // Start the Dear ImGui frame
     ImGui_ImplDX11_NewFrame();
@@ -211,8 +639,17 @@ void DrawUI(GameData& data, std::shared_ptr<SceneNode> sceneRoot)
 
     ImGui::Begin("Scene Graph");
 
+    PickSceneNode(data, sceneBvh);
+
     DrawSceneGraph(sceneRoot);
 
+    if (auto selected = g_selectedNode.lock())
+        ImGui::Text("Selected: %s", selected->name.c_str());
+    else
+        ImGui::Text("Selected: none (click an object to pick it)");
+
+    DrawPerformance(data, sceneRoot, sceneBvh, rendererStats);
+
     ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
     ImGui::End();
@@ -290,6 +727,9 @@ void DrawMatrix(const char* tableName, DirectX::XMMATRIX& matrix, bool enhanceMa
 /// @brief Clean up IMGui
 void DestroyIMGUI()
 {
+    // Waits for a benchmark that is still running, as it has no way to stop part way
+    g_benchmarkRunner.reset();
+
     // Cleanup
     ImGui_ImplDX11_Shutdown();
     ImGui_ImplWin32_Shutdown();
@@ -0,0 +1,176 @@
+#include "AsyncLoader.h"
+
+#include <algorithm>
+#include <chrono>
+
+AsyncLoader::AsyncLoader(unsigned workerCount)
+{
+    if (workerCount == 0)
+        workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (unsigned index = 0; index < workerCount; index++)
+    {
+        m_threads.emplace_back(&AsyncLoader::WorkerLoop, this);
+    }
+}
+
+AsyncLoader::~AsyncLoader()
+{
+    Shutdown();
+}
+
+/// @brief Queue an asset to be loaded
+/// @param name What to call the asset in the stats and the log
+/// @param load Run on a loader thread. Returns the function that uploads what it loaded, or an
+/// empty function if loading failed.
+void AsyncLoader::Submit(const std::string& name, LoadFunction load)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_quit)
+            return;
+        m_requests.push_back(Request{ name, std::move(load) });
+        m_stats.queued++;
+    }
+    m_wake.notify_one();
+}
+
+/// @brief Run the uploads of assets that have finished loading, oldest first, until the budget is
+/// spent. At least one upload runs if any are waiting, so loading always makes progress, and an
+/// upload that is already running isn't interrupted, so a big one can overrun the budget.
+/// Call once a frame, on the thread that owns the device context.
+/// @return How many uploads ran
+uint32_t AsyncLoader::ProcessUploads(double budgetMilliseconds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    uint32_t uploads = 0;
+
+    while (true)
+    {
+        Upload upload;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_uploads.empty())
+                break;
+            upload = std::move(m_uploads.front());
+            m_uploads.pop_front();
+            m_stats.waitingForUpload--;
+        }
+
+        bool uploaded = upload.upload();
+        uploads++;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (uploaded)
+            {
+                m_stats.completed++;
+            }
+            else
+            {
+                m_stats.failed++;
+                m_stats.lastFailed = upload.name;
+            }
+        }
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if (elapsed >= budgetMilliseconds)
+            break;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.uploadsLastFrame = uploads;
+    m_stats.uploadMillisecondsLastFrame = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return uploads;
+}
+
+/// @brief Block until every queued asset has been loaded. Their uploads still have to be run.
+void AsyncLoader::WaitForLoads()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_threads.empty())
+        return;
+    m_loadDone.wait(lock, [this]() { return m_requests.empty() && m_stats.loading == 0; });
+}
+
+/// @brief Stop the loader threads once they finish what they are loading. Anything still queued,
+/// and every upload that hasn't run, is dropped. Call before destroying whatever the load and
+/// upload functions write to.
+void AsyncLoader::Shutdown()
+{
+    // The uploads go before the threads are joined, as a load can be waiting for memory that only
+    // comes back when what they hold is freed. Loads that finish from here on are dropped as well.
+    std::deque<Upload> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_requests.clear();
+        dropped.swap(m_uploads);
+        m_stats.queued = 0;
+        m_stats.waitingForUpload = 0;
+    }
+    m_wake.notify_all();
+    dropped.clear();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+/// @brief Is there nothing left to load or upload?
+bool AsyncLoader::IsIdle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_requests.empty() && m_uploads.empty() && m_stats.loading == 0;
+}
+
+AsyncLoaderStats AsyncLoader::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void AsyncLoader::WorkerLoop()
+{
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_quit || !m_requests.empty(); });
+            if (m_quit)
+                return;
+            request = std::move(m_requests.front());
+            m_requests.pop_front();
+            m_stats.queued--;
+            m_stats.loading++;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        UploadFunction upload = request.load();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.loading--;
+            m_stats.loadMilliseconds += milliseconds;
+            if (m_quit)
+            {
+                // Nothing will run the upload, so let what it holds go with it
+            }
+            else if (upload)
+            {
+                m_uploads.push_back(Upload{ std::move(request.name), std::move(upload) });
+                m_stats.waitingForUpload++;
+            }
+            else
+            {
+                m_stats.failed++;
+                m_stats.lastFailed = request.name;
+            }
+        }
+        m_loadDone.notify_all();
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief Counters from an AsyncLoader
+struct AsyncLoaderStats
+{
+    uint32_t queued = 0;            // waiting for a worker
+    uint32_t loading = 0;           // being loaded by a worker right now
+    uint32_t waitingForUpload = 0;  // loaded, waiting for the main thread
+    uint32_t completed = 0;         // uploaded, since the loader was made
+    uint32_t failed = 0;            // failed to load or to upload
+    uint32_t uploadsLastFrame = 0;
+    double uploadMillisecondsLastFrame = 0.0;
+    double loadMilliseconds = 0.0;  // worker time spent loading, summed over every asset
+    std::string lastFailed;         // name of the last asset that failed, if any did
+};
+
+/// @brief Loads assets in two stages so the main thread never waits on a disk or a decoder.
+///
+/// The load stage runs on one of the loader's own threads and does everything that only needs the
+/// CPU: reading files, importing, converting and packing vertices, decoding images. It hands back
+/// an upload function, which the main thread runs from ProcessUploads to create the GPU resources,
+/// since only the immediate context's thread should be creating them in this renderer. Uploads run
+/// in the order their loads finished, as many per frame as fit in a time budget.
+///
+/// The loader threads are separate from the JobSystem's workers, which are for short parallel
+/// loops that the main thread waits on; a load can take long enough to stall those.
+class AsyncLoader
+{
+public:
+    using UploadFunction = std::function<bool()>;
+    using LoadFunction = std::function<UploadFunction()>;
+
+    /// @param workerCount Loader threads to start. 0 picks one per hardware thread, less one for the main thread.
+    explicit AsyncLoader(unsigned workerCount = 0);
+    ~AsyncLoader();
+
+    AsyncLoader(const AsyncLoader&) = delete;
+    AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+    void Submit(const std::string& name, LoadFunction load);
+
+    uint32_t ProcessUploads(double budgetMilliseconds);
+
+    void WaitForLoads();
+    void Shutdown();
+
+    bool IsIdle() const;
+    AsyncLoaderStats GetStats() const;
+    unsigned GetWorkerCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+private:
+    struct Request
+    {
+        std::string name;
+        LoadFunction load;
+    };
+
+    struct Upload
+    {
+        std::string name;
+        UploadFunction upload;
+    };
+
+    void WorkerLoop();
+
+    std::vector<std::thread> m_threads;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;         // a request was queued, or the loader is shutting down
+    std::condition_variable m_loadDone;     // a worker finished a request
+    std::deque<Request> m_requests;
+    std::deque<Upload> m_uploads;
+    AsyncLoaderStats m_stats;
+    bool m_quit = false;
+};
@@ -0,0 +1,699 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr int c_texelCount = 16;
+    constexpr int c_refineIterations = 2;
+
+    // BC7 interpolation weights for 4 bit indices, out of 64
+    constexpr int c_bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    /// @brief The mean of a block and the direction its colours spread furthest along, over the
+    /// first channelCount channels. The direction is zero if every texel is the same.
+    void FitLine(const float texels[c_texelCount][4], int channelCount, float mean[4], float axis[4])
+    {
+        for (int channel = 0; channel < 4; channel++)
+        {
+            float sum = 0.0f;
+            for (int texel = 0; texel < c_texelCount; texel++)
+                sum += texels[texel][channel];
+            mean[channel] = sum / c_texelCount;
+            axis[channel] = 0.0f;
+        }
+
+        float covariance[4][4] = {};
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            float offset[4];
+            for (int channel = 0; channel < channelCount; channel++)
+                offset[channel] = texels[texel][channel] - mean[channel];
+            for (int row = 0; row < channelCount; row++)
+                for (int column = 0; column < channelCount; column++)
+                    covariance[row][column] += offset[row] * offset[column];
+        }
+
+        // Power iteration, starting from the channel that varies most
+        int widest = 0;
+        for (int channel = 1; channel < channelCount; channel++)
+        {
+            if (covariance[channel][channel] > covariance[widest][widest])
+                widest = channel;
+        }
+        if (covariance[widest][widest] <= 0.0f)
+            return;
+
+        float vector[4] = {};
+        for (int channel = 0; channel < channelCount; channel++)
+            vector[channel] = covariance[widest][channel];
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            float largest = 0.0f;
+            for (int row = 0; row < channelCount; row++)
+            {
+                for (int column = 0; column < channelCount; column++)
+                    next[row] += covariance[row][column] * vector[column];
+                largest = std::max(largest, std::abs(next[row]));
+            }
+            if (largest <= 0.0f)
+                return;
+            for (int channel = 0; channel < channelCount; channel++)
+                vector[channel] = next[channel] / largest;
+        }
+
+        float length = 0.0f;
+        for (int channel = 0; channel < channelCount; channel++)
+            length += vector[channel] * vector[channel];
+        length = std::sqrt(length);
+        for (int channel = 0; channel < channelCount; channel++)
+            axis[channel] = vector[channel] / length;
+    }
+
+    /// @brief The ends of the block's colours along its line
+    void FitEndpoints(const float texels[c_texelCount][4], int channelCount, float start[4], float end[4])
+    {
+        float mean[4];
+        float axis[4];
+        FitLine(texels, channelCount, mean, axis);
+
+        float lowest = 0.0f;
+        float highest = 0.0f;
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            float projection = 0.0f;
+            for (int channel = 0; channel < channelCount; channel++)
+                projection += (texels[texel][channel] - mean[channel]) * axis[channel];
+            lowest = std::min(lowest, projection);
+            highest = std::max(highest, projection);
+        }
+        for (int channel = 0; channel < 4; channel++)
+        {
+            start[channel] = mean[channel] + axis[channel] * lowest;
+            end[channel] = mean[channel] + axis[channel] * highest;
+        }
+    }
+
+    /// @brief The endpoints that best fit the texels given which fraction of the way from start to
+    /// end each texel was assigned, by least squares. Leaves them as they were if the fractions
+    /// can't tell them apart.
+    void RefineEndpoints(const float texels[c_texelCount][4], const float fractions[c_texelCount], int channelCount, float start[4], float end[4])
+    {
+        float startSquared = 0.0f;
+        float endSquared = 0.0f;
+        float cross = 0.0f;
+        float startTexels[4] = {};
+        float endTexels[4] = {};
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            float w = fractions[texel];
+            startSquared += (1.0f - w) * (1.0f - w);
+            endSquared += w * w;
+            cross += (1.0f - w) * w;
+            for (int channel = 0; channel < channelCount; channel++)
+            {
+                startTexels[channel] += (1.0f - w) * texels[texel][channel];
+                endTexels[channel] += w * texels[texel][channel];
+            }
+        }
+
+        float determinant = startSquared * endSquared - cross * cross;
+        if (std::abs(determinant) < 1e-6f)
+            return;
+
+        for (int channel = 0; channel < channelCount; channel++)
+        {
+            start[channel] = std::clamp((startTexels[channel] * endSquared - endTexels[channel] * cross) / determinant, 0.0f, 255.0f);
+            end[channel] = std::clamp((endTexels[channel] * startSquared - startTexels[channel] * cross) / determinant, 0.0f, 255.0f);
+        }
+    }
+
+    void ToFloat(const uint8_t texels[64], float result[c_texelCount][4])
+    {
+        for (int texel = 0; texel < c_texelCount; texel++)
+            for (int channel = 0; channel < 4; channel++)
+                result[texel][channel] = texels[texel * 4 + channel];
+    }
+
+    int Quantize(float value, int maximum)
+    {
+        return std::clamp(static_cast<int>(std::lround(value * maximum / 255.0f)), 0, maximum);
+    }
+
+    /// @brief Write value's low bitCount bits at a bit position, least significant first
+    void PutBits(uint8_t* block, uint32_t& position, uint32_t value, uint32_t bitCount)
+    {
+        for (uint32_t bit = 0; bit < bitCount; bit++, position++)
+        {
+            if ((value >> bit) & 1)
+                block[position / 8] |= static_cast<uint8_t>(1 << (position % 8));
+        }
+    }
+
+    uint32_t GetBits(const uint8_t* block, uint32_t& position, uint32_t bitCount)
+    {
+        uint32_t value = 0;
+        for (uint32_t bit = 0; bit < bitCount; bit++, position++)
+            value |= static_cast<uint32_t>((block[position / 8] >> (position % 8)) & 1) << bit;
+        return value;
+    }
+
+    // BC1 colour ----------------------------------------------------------------------------------
+
+    uint16_t To565(const float colour[4])
+    {
+        return static_cast<uint16_t>((Quantize(colour[0], 31) << 11) | (Quantize(colour[1], 63) << 5) | Quantize(colour[2], 31));
+    }
+
+    void From565(uint16_t packed, int colour[3])
+    {
+        int red = packed >> 11;
+        int green = (packed >> 5) & 63;
+        int blue = packed & 31;
+        colour[0] = (red << 3) | (red >> 2);
+        colour[1] = (green << 2) | (green >> 4);
+        colour[2] = (blue << 3) | (blue >> 2);
+    }
+
+    /// @brief The four colours of a BC1 block with its first endpoint above its second, which is
+    /// the only way BC3 reads its colour
+    void ColourPalette(uint16_t first, uint16_t second, int palette[4][3])
+    {
+        From565(first, palette[0]);
+        From565(second, palette[1]);
+        for (int channel = 0; channel < 3; channel++)
+        {
+            palette[2][channel] = (2 * palette[0][channel] + palette[1][channel] + 1) / 3;
+            palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel] + 1) / 3;
+        }
+    }
+
+    /// @brief The nearest colour of the palette to each texel, 2 bits each
+    /// @return The summed squared error
+    uint32_t ChooseColourIndices(const uint8_t texels[64], uint16_t first, uint16_t second, uint32_t& indices)
+    {
+        int palette[4][3];
+        ColourPalette(first, second, palette);
+
+        uint32_t total = 0;
+        indices = 0;
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            uint32_t bestError = UINT32_MAX;
+            uint32_t best = 0;
+            for (uint32_t entry = 0; entry < 4; entry++)
+            {
+                uint32_t error = 0;
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    int difference = texels[texel * 4 + channel] - palette[entry][channel];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = entry;
+                }
+            }
+            indices |= best << (texel * 2);
+            total += bestError;
+        }
+        return total;
+    }
+
+    void CompressColour(const uint8_t texels[64], uint8_t* block)
+    {
+        // Fraction of the way from the first endpoint to the second for each index
+        static const float fractions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float points[c_texelCount][4];
+        ToFloat(texels, points);
+        float start[4];
+        float end[4];
+        FitEndpoints(points, 3, start, end);
+
+        // The first endpoint is the brighter end, so the block is read with four colours
+        uint16_t first = To565(end);
+        uint16_t second = To565(start);
+        uint32_t indices = 0;
+        uint32_t error = ChooseColourIndices(texels, first, second, indices);
+
+        for (int iteration = 0; iteration < c_refineIterations && error > 0; iteration++)
+        {
+            float assigned[c_texelCount];
+            for (int texel = 0; texel < c_texelCount; texel++)
+                assigned[texel] = fractions[(indices >> (texel * 2)) & 3];
+
+            float refinedFirst[4] = { end[0], end[1], end[2], 0.0f };
+            float refinedSecond[4] = { start[0], start[1], start[2], 0.0f };
+            RefineEndpoints(points, assigned, 3, refinedFirst, refinedSecond);
+
+            uint16_t candidateFirst = To565(refinedFirst);
+            uint16_t candidateSecond = To565(refinedSecond);
+            uint32_t candidateIndices = 0;
+            uint32_t candidateError = ChooseColourIndices(texels, candidateFirst, candidateSecond, candidateIndices);
+            if (candidateError >= error)
+                break;
+
+            first = candidateFirst;
+            second = candidateSecond;
+            indices = candidateIndices;
+            error = candidateError;
+            std::copy(refinedFirst, refinedFirst + 3, end);
+            std::copy(refinedSecond, refinedSecond + 3, start);
+        }
+
+        // A first endpoint at or below the second switches BC1 to three colours and black, so swap
+        // them, and with them the indices, or use just the one colour if they are the same
+        if (first < second)
+        {
+            std::swap(first, second);
+            indices ^= 0x55555555;  // 0 <-> 1, 2 <-> 3
+        }
+        else if (first == second)
+        {
+            indices = 0;
+        }
+
+        block[0] = static_cast<uint8_t>(first);
+        block[1] = static_cast<uint8_t>(first >> 8);
+        block[2] = static_cast<uint8_t>(second);
+        block[3] = static_cast<uint8_t>(second >> 8);
+        std::memcpy(block + 4, &indices, sizeof(indices));
+    }
+
+    /// @param fourColour Always read four colours, as BC3 does, whatever order the endpoints are in
+    void DecompressColour(const uint8_t* block, bool fourColour, uint8_t texels[64])
+    {
+        uint16_t first = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t second = static_cast<uint16_t>(block[2] | (block[3] << 8));
+        uint32_t indices = 0;
+        std::memcpy(&indices, block + 4, sizeof(indices));
+
+        int palette[4][3];
+        int alpha[4] = { 255, 255, 255, 255 };
+        ColourPalette(first, second, palette);
+        if (!fourColour && first <= second)
+        {
+            for (int channel = 0; channel < 3; channel++)
+            {
+                palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+                palette[3][channel] = 0;
+            }
+            alpha[3] = 0;
+        }
+
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            uint32_t entry = (indices >> (texel * 2)) & 3;
+            for (int channel = 0; channel < 3; channel++)
+                texels[texel * 4 + channel] = static_cast<uint8_t>(palette[entry][channel]);
+            texels[texel * 4 + 3] = static_cast<uint8_t>(alpha[entry]);
+        }
+    }
+
+    // BC3 alpha -----------------------------------------------------------------------------------
+
+    /// @brief The eight alphas of a BC3 alpha block: six steps between the endpoints if the first
+    /// is the larger, else four steps plus 0 and 255
+    void AlphaPalette(int first, int second, int palette[8])
+    {
+        palette[0] = first;
+        palette[1] = second;
+        if (first > second)
+        {
+            for (int step = 1; step < 7; step++)
+                palette[step + 1] = ((7 - step) * first + step * second + 3) / 7;
+        }
+        else
+        {
+            for (int step = 1; step < 5; step++)
+                palette[step + 1] = ((5 - step) * first + step * second + 2) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    uint32_t ChooseAlphaIndices(const uint8_t texels[64], int first, int second, uint64_t& indices)
+    {
+        int palette[8];
+        AlphaPalette(first, second, palette);
+
+        uint32_t total = 0;
+        indices = 0;
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            int alpha = texels[texel * 4 + 3];
+            uint32_t bestError = UINT32_MAX;
+            uint64_t best = 0;
+            for (int entry = 0; entry < 8; entry++)
+            {
+                uint32_t error = static_cast<uint32_t>((alpha - palette[entry]) * (alpha - palette[entry]));
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = entry;
+                }
+            }
+            indices |= best << (texel * 3);
+            total += bestError;
+        }
+        return total;
+    }
+
+    void CompressAlpha(const uint8_t texels[64], uint8_t* block)
+    {
+        int lowest = 255;
+        int highest = 0;
+        int innerLowest = 255;  // ignoring 0 and 255, which the six step mode has exactly
+        int innerHighest = 0;
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            int alpha = texels[texel * 4 + 3];
+            lowest = std::min(lowest, alpha);
+            highest = std::max(highest, alpha);
+            if (alpha != 0 && alpha != 255)
+            {
+                innerLowest = std::min(innerLowest, alpha);
+                innerHighest = std::max(innerHighest, alpha);
+            }
+        }
+
+        // Equal endpoints select the six step mode, whose first entry is the one alpha
+        int first = highest;
+        int second = lowest;
+        uint64_t indices = 0;
+        uint32_t error = ChooseAlphaIndices(texels, first, second, indices);
+        if (error > 0 && (lowest == 0 || highest == 255))
+        {
+            if (innerLowest > innerHighest)
+                innerLowest = innerHighest = lowest;
+            uint64_t candidateIndices = 0;
+            uint32_t candidateError = ChooseAlphaIndices(texels, innerLowest, innerHighest, candidateIndices);
+            if (candidateError < error)
+            {
+                first = innerLowest;
+                second = innerHighest;
+                indices = candidateIndices;
+            }
+        }
+
+        block[0] = static_cast<uint8_t>(first);
+        block[1] = static_cast<uint8_t>(second);
+        for (int byte = 0; byte < 6; byte++)
+            block[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+    }
+
+    void DecompressAlpha(const uint8_t* block, uint8_t texels[64])
+    {
+        int palette[8];
+        AlphaPalette(block[0], block[1], palette);
+
+        uint64_t indices = 0;
+        for (int byte = 0; byte < 6; byte++)
+            indices |= static_cast<uint64_t>(block[2 + byte]) << (byte * 8);
+        for (int texel = 0; texel < c_texelCount; texel++)
+            texels[texel * 4 + 3] = static_cast<uint8_t>(palette[(indices >> (texel * 3)) & 7]);
+    }
+
+    // BC7 mode 6 ----------------------------------------------------------------------------------
+
+    /// @brief An RGBA endpoint of 7 bits a channel plus a shared lowest bit
+    struct Bc7Endpoint
+    {
+        int channels[4];    // 7 bits each
+        int pBit;
+
+        int Expand(int channel) const { return (channels[channel] << 1) | pBit; }
+    };
+
+    /// @brief The closest endpoint to a colour, trying both values of the shared bit
+    Bc7Endpoint QuantizeBc7(const float colour[4])
+    {
+        Bc7Endpoint best = {};
+        float bestError = -1.0f;
+        for (int pBit = 0; pBit < 2; pBit++)
+        {
+            Bc7Endpoint candidate = {};
+            candidate.pBit = pBit;
+            float error = 0.0f;
+            for (int channel = 0; channel < 4; channel++)
+            {
+                candidate.channels[channel] = std::clamp(static_cast<int>(std::lround((colour[channel] - pBit) / 2.0f)), 0, 127);
+                float difference = candidate.Expand(channel) - colour[channel];
+                error += difference * difference;
+            }
+            if (bestError < 0.0f || error < bestError)
+            {
+                best = candidate;
+                bestError = error;
+            }
+        }
+        return best;
+    }
+
+    void Bc7Palette(const Bc7Endpoint& first, const Bc7Endpoint& second, int palette[16][4])
+    {
+        for (int entry = 0; entry < 16; entry++)
+        {
+            int weight = c_bc7Weights[entry];
+            for (int channel = 0; channel < 4; channel++)
+                palette[entry][channel] = ((64 - weight) * first.Expand(channel) + weight * second.Expand(channel) + 32) >> 6;
+        }
+    }
+
+    uint32_t ChooseBc7Indices(const uint8_t texels[64], const Bc7Endpoint& first, const Bc7Endpoint& second, uint8_t indices[c_texelCount])
+    {
+        int palette[16][4];
+        Bc7Palette(first, second, palette);
+
+        uint32_t total = 0;
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            uint32_t bestError = UINT32_MAX;
+            for (int entry = 0; entry < 16; entry++)
+            {
+                uint32_t error = 0;
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    int difference = texels[texel * 4 + channel] - palette[entry][channel];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    indices[texel] = static_cast<uint8_t>(entry);
+                }
+            }
+            total += bestError;
+        }
+        return total;
+    }
+
+    void CompressBc7(const uint8_t texels[64], uint8_t* block)
+    {
+        float points[c_texelCount][4];
+        ToFloat(texels, points);
+        float start[4];
+        float end[4];
+        FitEndpoints(points, 4, start, end);
+
+        Bc7Endpoint first = QuantizeBc7(start);
+        Bc7Endpoint second = QuantizeBc7(end);
+        uint8_t indices[c_texelCount];
+        uint32_t error = ChooseBc7Indices(texels, first, second, indices);
+
+        for (int iteration = 0; iteration < c_refineIterations && error > 0; iteration++)
+        {
+            float assigned[c_texelCount];
+            for (int texel = 0; texel < c_texelCount; texel++)
+                assigned[texel] = c_bc7Weights[indices[texel]] / 64.0f;
+
+            float refinedStart[4];
+            float refinedEnd[4];
+            std::copy(start, start + 4, refinedStart);
+            std::copy(end, end + 4, refinedEnd);
+            RefineEndpoints(points, assigned, 4, refinedStart, refinedEnd);
+
+            Bc7Endpoint candidateFirst = QuantizeBc7(refinedStart);
+            Bc7Endpoint candidateSecond = QuantizeBc7(refinedEnd);
+            uint8_t candidateIndices[c_texelCount];
+            uint32_t candidateError = ChooseBc7Indices(texels, candidateFirst, candidateSecond, candidateIndices);
+            if (candidateError >= error)
+                break;
+
+            first = candidateFirst;
+            second = candidateSecond;
+            std::copy(candidateIndices, candidateIndices + c_texelCount, indices);
+            error = candidateError;
+            std::copy(refinedStart, refinedStart + 4, start);
+            std::copy(refinedEnd, refinedEnd + 4, end);
+        }
+
+        // The first texel's index is stored without its top bit, so it has to be below 8: if it
+        // isn't, swap the endpoints, which mirrors every index
+        if (indices[0] >= 8)
+        {
+            std::swap(first, second);
+            for (auto& index : indices)
+                index = static_cast<uint8_t>(15 - index);
+        }
+
+        std::memset(block, 0, 16);
+        uint32_t position = 0;
+        PutBits(block, position, 1 << 6, 7);    // mode 6
+        for (int channel = 0; channel < 4; channel++)
+        {
+            PutBits(block, position, first.channels[channel], 7);
+            PutBits(block, position, second.channels[channel], 7);
+        }
+        PutBits(block, position, first.pBit, 1);
+        PutBits(block, position, second.pBit, 1);
+        PutBits(block, position, indices[0], 3);
+        for (int texel = 1; texel < c_texelCount; texel++)
+            PutBits(block, position, indices[texel], 4);
+    }
+
+    /// @brief Decodes mode 6 only, which is all CompressBc7 writes. Blocks in any other mode come
+    /// out as transparent black.
+    void DecompressBc7(const uint8_t* block, uint8_t texels[64])
+    {
+        if ((block[0] & 0x7F) != (1 << 6))
+        {
+            std::memset(texels, 0, 64);
+            return;
+        }
+
+        uint32_t position = 7;
+        Bc7Endpoint first = {};
+        Bc7Endpoint second = {};
+        for (int channel = 0; channel < 4; channel++)
+        {
+            first.channels[channel] = static_cast<int>(GetBits(block, position, 7));
+            second.channels[channel] = static_cast<int>(GetBits(block, position, 7));
+        }
+        first.pBit = static_cast<int>(GetBits(block, position, 1));
+        second.pBit = static_cast<int>(GetBits(block, position, 1));
+
+        int palette[16][4];
+        Bc7Palette(first, second, palette);
+        for (int texel = 0; texel < c_texelCount; texel++)
+        {
+            uint32_t entry = GetBits(block, position, texel == 0 ? 3 : 4);
+            for (int channel = 0; channel < 4; channel++)
+                texels[texel * 4 + channel] = static_cast<uint8_t>(palette[entry][channel]);
+        }
+    }
+}
+
+/// @brief Bytes taken by each 4x4 block of the format
+uint32_t GetBlockBytes(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+/// @brief Bytes taken by an image of the given size, counting partial blocks at the edges as whole ones
+size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+{
+    size_t blocksWide = (width + c_blockSize - 1) / c_blockSize;
+    size_t blocksHigh = (height + c_blockSize - 1) / c_blockSize;
+    return blocksWide * blocksHigh * GetBlockBytes(format);
+}
+
+/// @brief Compress one block
+/// @param texels The block's 16 RGBA texels, row by row
+/// @param block Where to write the GetBlockBytes(format) bytes of the block
+void CompressBlock(BlockFormat format, const uint8_t texels[64], uint8_t* block)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        CompressColour(texels, block);
+        break;
+    case BlockFormat::BC3:
+        CompressAlpha(texels, block);
+        CompressColour(texels, block + 8);
+        break;
+    case BlockFormat::BC7:
+        CompressBc7(texels, block);
+        break;
+    }
+}
+
+/// @brief Decompress one block into its 16 RGBA texels, row by row, as the GPU would sample them
+void DecompressBlock(BlockFormat format, const uint8_t* block, uint8_t texels[64])
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        DecompressColour(block, false, texels);
+        break;
+    case BlockFormat::BC3:
+        DecompressColour(block + 8, true, texels);
+        DecompressAlpha(block, texels);
+        break;
+    case BlockFormat::BC7:
+        DecompressBc7(block, texels);
+        break;
+    }
+}
+
+/// @brief Compress a whole image, blocks in rows from the top left, as D3D lays them out.
+/// Blocks that hang over the right or bottom edge repeat the edge texels to fill themselves.
+void CompressImage(BlockFormat format, const DecodedImage& image, std::vector<uint8_t>& blocks)
+{
+    blocks.assign(GetCompressedSize(format, image.width, image.height), 0);
+    if (image.IsEmpty())
+        return;
+
+    uint32_t blockBytes = GetBlockBytes(format);
+    uint8_t texels[64];
+    uint8_t* block = blocks.data();
+    for (uint32_t blockY = 0; blockY < image.height; blockY += c_blockSize)
+    {
+        for (uint32_t blockX = 0; blockX < image.width; blockX += c_blockSize)
+        {
+            for (uint32_t y = 0; y < c_blockSize; y++)
+            {
+                uint32_t row = std::min(blockY + y, image.height - 1);
+                for (uint32_t x = 0; x < c_blockSize; x++)
+                {
+                    uint32_t column = std::min(blockX + x, image.width - 1);
+                    std::memcpy(texels + (y * c_blockSize + x) * 4, image.pixels.data() + (static_cast<size_t>(row) * image.width + column) * 4, 4);
+                }
+            }
+            CompressBlock(format, texels, block);
+            block += blockBytes;
+        }
+    }
+}
+
+/// @brief Decompress a whole image written by CompressImage
+void DecompressImage(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, DecodedImage& image)
+{
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+    uint32_t blockBytes = GetBlockBytes(format);
+    uint8_t texels[64];
+    for (uint32_t blockY = 0; blockY < height; blockY += c_blockSize)
+    {
+        for (uint32_t blockX = 0; blockX < width; blockX += c_blockSize)
+        {
+            DecompressBlock(format, blocks, texels);
+            blocks += blockBytes;
+
+            for (uint32_t y = 0; y < c_blockSize && blockY + y < height; y++)
+            {
+                for (uint32_t x = 0; x < c_blockSize && blockX + x < width; x++)
+                {
+                    std::memcpy(image.pixels.data() + (static_cast<size_t>(blockY + y) * width + blockX + x) * 4, texels + (y * c_blockSize + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
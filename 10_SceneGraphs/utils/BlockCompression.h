@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ImageDecoder.h"
+
+/// Block compression of 8 bit RGBA images into the formats D3D samples directly. Each format
+/// stores a 4x4 square of texels in a fixed number of bytes, so a compressed texture takes a
+/// quarter (BC3, BC7) or an eighth (BC1) of the memory and bandwidth of RGBA8.
+///
+/// The encoders fit a line through each block's colours, pick the nearest point on it for each
+/// texel and then refine the ends of the line by least squares, keeping whichever is closest. BC7
+/// is encoded in mode 6 only, a single line through RGBA with 16 steps, which is most of the
+/// quality of a full mode search for a fraction of the time. This header is free of Windows and D3D
+/// headers, so the cooker can use it.
+
+/// @brief The values are written to cooked textures, so never renumber them
+enum class BlockFormat : uint32_t
+{
+    BC1 = 1,    // RGB at 4 bits a texel; alpha is dropped
+    BC3 = 2,    // RGB as BC1 plus interpolated alpha, at 8 bits a texel
+    BC7 = 3     // RGBA at 8 bits a texel, with far less banding than BC1 and BC3
+};
+
+constexpr uint32_t c_blockSize = 4;     // texels along each side of a block
+
+uint32_t GetBlockBytes(BlockFormat format);
+size_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+void CompressBlock(BlockFormat format, const uint8_t texels[64], uint8_t* block);
+void DecompressBlock(BlockFormat format, const uint8_t* block, uint8_t texels[64]);
+
+void CompressImage(BlockFormat format, const DecodedImage& image, std::vector<uint8_t>& blocks);
+void DecompressImage(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, DecodedImage& image);
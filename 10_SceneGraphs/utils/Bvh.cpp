@@ -0,0 +1,511 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+    constexpr uint32_t c_binCount = 16;
+    constexpr uint32_t c_maxLeafSize = 4;
+
+    // Relative costs of visiting a node and of testing a primitive, for the SAH
+    constexpr float c_traversalCost = 1.0f;
+    constexpr float c_intersectionCost = 1.0f;
+
+    struct Box
+    {
+        DirectX::XMVECTOR minimum = DirectX::XMVectorReplicate(FLT_MAX);
+        DirectX::XMVECTOR maximum = DirectX::XMVectorReplicate(-FLT_MAX);
+
+        void Grow(DirectX::FXMVECTOR otherMinimum, DirectX::FXMVECTOR otherMaximum)
+        {
+            minimum = DirectX::XMVectorMin(minimum, otherMinimum);
+            maximum = DirectX::XMVectorMax(maximum, otherMaximum);
+        }
+
+        float HalfArea() const
+        {
+            DirectX::XMFLOAT3 size;
+            DirectX::XMStoreFloat3(&size, DirectX::XMVectorMax(DirectX::XMVectorSubtract(maximum, minimum), DirectX::XMVectorZero()));
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+    };
+
+    float Component(const DirectX::XMFLOAT3& value, int axis)
+    {
+        return axis == 0 ? value.x : (axis == 1 ? value.y : value.z);
+    }
+
+    /// @brief Is the box inside out, as empty primitives and the nodes holding only those are?
+    bool IsEmptyBox(const DirectX::XMFLOAT3& minimum, const DirectX::XMFLOAT3& maximum)
+    {
+        return minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z;
+    }
+
+    /// @brief Slab test of a ray against a box
+    /// @return Distance along the ray to the box, or FLT_MAX if it misses
+    float IntersectBox(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& inverseDirection,
+        const DirectX::XMFLOAT3& minimum, const DirectX::XMFLOAT3& maximum, float maxDistance)
+    {
+        if (IsEmptyBox(minimum, maximum))
+            return FLT_MAX;
+
+        float t1 = (minimum.x - origin.x) * inverseDirection.x;
+        float t2 = (maximum.x - origin.x) * inverseDirection.x;
+        float tNear = std::min(t1, t2);
+        float tFar = std::max(t1, t2);
+
+        t1 = (minimum.y - origin.y) * inverseDirection.y;
+        t2 = (maximum.y - origin.y) * inverseDirection.y;
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+
+        t1 = (minimum.z - origin.z) * inverseDirection.z;
+        t2 = (maximum.z - origin.z) * inverseDirection.z;
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+
+        if (tFar < std::max(tNear, 0.0f) || tNear >= maxDistance)
+            return FLT_MAX;
+
+        return std::max(tNear, 0.0f);
+    }
+}
+
+/// @brief Build the tree from scratch
+/// @param primitiveBounds World space bounds of every primitive. Empty bounds are left out of the
+/// tree, until a Refit gives them some.
+void Bvh::Build(const std::vector<Bounds>& primitiveBounds)
+{
+    const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+
+    m_nodes.clear();
+    m_parents.clear();
+    m_primitiveIndices.clear();
+    m_primitiveLeaves.assign(primitiveCount, InvalidIndex);
+    m_primitiveMinimum.resize(primitiveCount);
+    m_primitiveMaximum.resize(primitiveCount);
+
+    std::vector<DirectX::XMFLOAT3> centroids(primitiveCount);
+    for (uint32_t index = 0; index < primitiveCount; index++)
+    {
+        const auto& bounds = primitiveBounds[index];
+        StorePrimitive(index, bounds);
+        centroids[index] = bounds.center;
+
+        if (!bounds.IsEmpty())
+            m_primitiveIndices.push_back(index);
+    }
+
+    if (m_primitiveIndices.empty())
+        return;
+
+    m_nodes.reserve(2 * m_primitiveIndices.size());
+    m_parents.reserve(2 * m_primitiveIndices.size());
+
+    // Nodes waiting to be split, with the range of m_primitiveIndices they cover
+    struct PendingNode
+    {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<PendingNode> pending;
+
+    m_nodes.push_back({});
+    m_parents.push_back(InvalidIndex);
+    pending.push_back({ 0, 0, static_cast<uint32_t>(m_primitiveIndices.size()) });
+
+    struct Bin
+    {
+        Box box;
+        uint32_t count = 0;
+    };
+
+    while (!pending.empty())
+    {
+        PendingNode current = pending.back();
+        pending.pop_back();
+
+        const uint32_t count = current.end - current.begin;
+
+        Box nodeBox;
+        Box centroidBox;
+        for (uint32_t position = current.begin; position < current.end; position++)
+        {
+            uint32_t primitive = m_primitiveIndices[position];
+            nodeBox.Grow(DirectX::XMLoadFloat3(&m_primitiveMinimum[primitive]), DirectX::XMLoadFloat3(&m_primitiveMaximum[primitive]));
+            DirectX::XMVECTOR centroid = DirectX::XMLoadFloat3(&centroids[primitive]);
+            centroidBox.Grow(centroid, centroid);
+        }
+
+        Node& node = m_nodes[current.node];
+        DirectX::XMStoreFloat3(&node.minimum, nodeBox.minimum);
+        DirectX::XMStoreFloat3(&node.maximum, nodeBox.maximum);
+        node.first = current.begin;
+        node.primitiveCount = count;
+
+        if (count <= c_maxLeafSize)
+            continue;
+
+        // Find the cheapest split over all three axes by binning the centroids
+        DirectX::XMFLOAT3 centroidMinimum;
+        DirectX::XMFLOAT3 centroidMaximum;
+        DirectX::XMStoreFloat3(&centroidMinimum, centroidBox.minimum);
+        DirectX::XMStoreFloat3(&centroidMaximum, centroidBox.maximum);
+
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        uint32_t bestSplit = 0;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float axisMinimum = Component(centroidMinimum, axis);
+            float axisExtent = Component(centroidMaximum, axis) - axisMinimum;
+            if (axisExtent <= 0.0f)
+                continue;
+
+            Bin bins[c_binCount];
+            float scale = c_binCount / axisExtent;
+            for (uint32_t position = current.begin; position < current.end; position++)
+            {
+                uint32_t primitive = m_primitiveIndices[position];
+                uint32_t bin = std::min(c_binCount - 1, static_cast<uint32_t>((Component(centroids[primitive], axis) - axisMinimum) * scale));
+                bins[bin].count++;
+                bins[bin].box.Grow(DirectX::XMLoadFloat3(&m_primitiveMinimum[primitive]), DirectX::XMLoadFloat3(&m_primitiveMaximum[primitive]));
+            }
+
+            // Sweep from both sides to get the area and count on either side of each split plane
+            float leftArea[c_binCount - 1];
+            uint32_t leftCount[c_binCount - 1];
+            Box sweep;
+            uint32_t sweepCount = 0;
+            for (uint32_t bin = 0; bin < c_binCount - 1; bin++)
+            {
+                sweep.Grow(bins[bin].box.minimum, bins[bin].box.maximum);
+                sweepCount += bins[bin].count;
+                leftArea[bin] = sweep.HalfArea();
+                leftCount[bin] = sweepCount;
+            }
+
+            sweep = Box();
+            sweepCount = 0;
+            for (uint32_t bin = c_binCount - 1; bin > 0; bin--)
+            {
+                sweep.Grow(bins[bin].box.minimum, bins[bin].box.maximum);
+                sweepCount += bins[bin].count;
+
+                uint32_t split = bin - 1;
+                if (leftCount[split] == 0 || sweepCount == 0)
+                    continue;
+
+                float cost = leftArea[split] * leftCount[split] + sweep.HalfArea() * sweepCount;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        // Keep the node as a leaf when splitting doesn't pay off, as long as the leaf doesn't get too big
+        const bool smallEnoughForLeaf = count <= 4 * c_maxLeafSize;
+        if (bestAxis >= 0)
+        {
+            float leafCost = c_intersectionCost * count;
+            float splitCost = c_traversalCost + c_intersectionCost * bestCost / std::max(nodeBox.HalfArea(), FLT_MIN);
+            if (splitCost >= leafCost && smallEnoughForLeaf)
+                continue;
+        }
+        else if (smallEnoughForLeaf)
+        {
+            continue;
+        }
+
+        // Without a usable axis all the centroids are in the same spot, so just split the range down the middle
+        uint32_t middle;
+        if (bestAxis >= 0)
+        {
+            float axisMinimum = Component(centroidMinimum, bestAxis);
+            float scale = c_binCount / (Component(centroidMaximum, bestAxis) - axisMinimum);
+            auto* first = m_primitiveIndices.data() + current.begin;
+            auto* last = m_primitiveIndices.data() + current.end;
+            auto* split = std::partition(first, last, [&](uint32_t primitive)
+                {
+                    uint32_t bin = std::min(c_binCount - 1, static_cast<uint32_t>((Component(centroids[primitive], bestAxis) - axisMinimum) * scale));
+                    return bin <= bestSplit;
+                });
+            middle = static_cast<uint32_t>(split - m_primitiveIndices.data());
+        }
+        else
+        {
+            middle = current.begin + count / 2;
+        }
+
+        uint32_t left = static_cast<uint32_t>(m_nodes.size());
+        m_nodes[current.node].first = left;
+        m_nodes[current.node].primitiveCount = 0;
+
+        m_nodes.push_back({});
+        m_nodes.push_back({});
+        m_parents.push_back(current.node);
+        m_parents.push_back(current.node);
+
+        pending.push_back({ left, current.begin, middle });
+        pending.push_back({ left + 1, middle, current.end });
+    }
+
+    for (uint32_t nodeIndex = 0; nodeIndex < m_nodes.size(); nodeIndex++)
+    {
+        const Node& node = m_nodes[nodeIndex];
+        for (uint32_t position = node.first; position < node.first + node.primitiveCount; position++)
+        {
+            m_primitiveLeaves[m_primitiveIndices[position]] = nodeIndex;
+        }
+    }
+}
+
+/// @brief Refit every node of the tree to new primitive bounds. Rebuilds instead if the number of
+/// primitives changed, or if one that was left out for being empty now has bounds.
+/// @return Whether the tree was rebuilt
+bool Bvh::Refit(const std::vector<Bounds>& primitiveBounds)
+{
+    bool rebuild = primitiveBounds.size() != m_primitiveLeaves.size();
+    for (uint32_t primitive = 0; primitive < primitiveBounds.size() && !rebuild; primitive++)
+    {
+        rebuild = m_primitiveLeaves[primitive] == InvalidIndex && !primitiveBounds[primitive].IsEmpty();
+    }
+    if (rebuild)
+    {
+        Build(primitiveBounds);
+        return true;
+    }
+
+    for (uint32_t primitive : m_primitiveIndices)
+    {
+        StorePrimitive(primitive, primitiveBounds[primitive]);
+    }
+
+    // Children are stored after their parents, so walking backwards visits them first
+    for (size_t nodeIndex = m_nodes.size(); nodeIndex-- > 0;)
+    {
+        if (m_nodes[nodeIndex].primitiveCount > 0)
+            FitLeaf(static_cast<uint32_t>(nodeIndex));
+        else
+            FitInterior(static_cast<uint32_t>(nodeIndex));
+    }
+    return false;
+}
+
+/// @brief Refit only the part of the tree above the primitives that changed. Stops walking up as
+/// soon as a node's box comes out unchanged. Rebuilds instead if one of them was left out for
+/// being empty and now has bounds.
+/// @return Whether the tree was rebuilt
+bool Bvh::Refit(const std::vector<Bounds>& primitiveBounds, const std::vector<uint32_t>& changedPrimitives)
+{
+    for (uint32_t primitive : changedPrimitives)
+    {
+        if (primitive >= m_primitiveLeaves.size() || (m_primitiveLeaves[primitive] == InvalidIndex && !primitiveBounds[primitive].IsEmpty()))
+        {
+            Build(primitiveBounds);
+            return true;
+        }
+    }
+
+    for (uint32_t primitive : changedPrimitives)
+    {
+        uint32_t leaf = m_primitiveLeaves[primitive];
+        if (leaf == InvalidIndex)
+            continue;
+
+        StorePrimitive(primitive, primitiveBounds[primitive]);
+
+        FitLeaf(leaf);
+        for (uint32_t node = m_parents[leaf]; node != InvalidIndex; node = m_parents[node])
+        {
+            if (!FitInterior(node))
+                break;
+        }
+    }
+    return false;
+}
+
+/// @brief Keep a primitive's bounds as a box. Empty bounds become an inside out box, which grows
+/// no node and which queries skip.
+void Bvh::StorePrimitive(uint32_t primitive, const Bounds& bounds)
+{
+    if (bounds.IsEmpty())
+    {
+        m_primitiveMinimum[primitive] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        m_primitiveMaximum[primitive] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        return;
+    }
+
+    DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&bounds.center);
+    DirectX::XMVECTOR extents = DirectX::XMLoadFloat3(&bounds.extents);
+    DirectX::XMStoreFloat3(&m_primitiveMinimum[primitive], DirectX::XMVectorSubtract(center, extents));
+    DirectX::XMStoreFloat3(&m_primitiveMaximum[primitive], DirectX::XMVectorAdd(center, extents));
+}
+
+void Bvh::FitLeaf(uint32_t nodeIndex)
+{
+    Node& node = m_nodes[nodeIndex];
+
+    Box box;
+    for (uint32_t position = node.first; position < node.first + node.primitiveCount; position++)
+    {
+        uint32_t primitive = m_primitiveIndices[position];
+        box.Grow(DirectX::XMLoadFloat3(&m_primitiveMinimum[primitive]), DirectX::XMLoadFloat3(&m_primitiveMaximum[primitive]));
+    }
+
+    DirectX::XMStoreFloat3(&node.minimum, box.minimum);
+    DirectX::XMStoreFloat3(&node.maximum, box.maximum);
+}
+
+/// @return Whether the box of the node changed
+bool Bvh::FitInterior(uint32_t nodeIndex)
+{
+    Node& node = m_nodes[nodeIndex];
+    const Node& left = m_nodes[node.first];
+    const Node& right = m_nodes[node.first + 1];
+
+    DirectX::XMFLOAT3 minimum;
+    DirectX::XMFLOAT3 maximum;
+    DirectX::XMStoreFloat3(&minimum, DirectX::XMVectorMin(DirectX::XMLoadFloat3(&left.minimum), DirectX::XMLoadFloat3(&right.minimum)));
+    DirectX::XMStoreFloat3(&maximum, DirectX::XMVectorMax(DirectX::XMLoadFloat3(&left.maximum), DirectX::XMLoadFloat3(&right.maximum)));
+
+    bool changed = minimum.x != node.minimum.x || minimum.y != node.minimum.y || minimum.z != node.minimum.z ||
+        maximum.x != node.maximum.x || maximum.y != node.maximum.y || maximum.z != node.maximum.z;
+
+    node.minimum = minimum;
+    node.maximum = maximum;
+    return changed;
+}
+
+/// @brief Find every primitive whose box is at least partially inside the frustum
+/// @param results Receives the indices of the primitives; it is not cleared first
+void Bvh::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const
+{
+    if (m_nodes.empty())
+        return;
+
+    auto toBounds = [](const DirectX::XMFLOAT3& minimum, const DirectX::XMFLOAT3& maximum)
+    {
+        DirectX::XMVECTOR lower = DirectX::XMLoadFloat3(&minimum);
+        DirectX::XMVECTOR upper = DirectX::XMLoadFloat3(&maximum);
+        DirectX::XMVECTOR extents = DirectX::XMVectorScale(DirectX::XMVectorSubtract(upper, lower), 0.5f);
+
+        Bounds bounds;
+        DirectX::XMStoreFloat3(&bounds.center, DirectX::XMVectorAdd(lower, extents));
+        DirectX::XMStoreFloat3(&bounds.extents, extents);
+        bounds.radius = DirectX::XMVectorGetX(DirectX::XMVector3Length(extents));
+        return bounds;
+    };
+
+    // The second value is set once a node is known to be entirely inside the frustum,
+    // so nothing below it needs testing
+    std::vector<std::pair<uint32_t, bool>> stack;
+    stack.push_back({ 0, false });
+
+    while (!stack.empty())
+    {
+        auto [nodeIndex, inside] = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[nodeIndex];
+        if (IsEmptyBox(node.minimum, node.maximum))
+            continue;
+
+        if (!inside)
+        {
+            CullResult result = TestFrustum(frustum, toBounds(node.minimum, node.maximum));
+            if (result == CullResult::Outside)
+                continue;
+            inside = result == CullResult::Inside;
+        }
+
+        if (node.primitiveCount == 0)
+        {
+            stack.push_back({ node.first + 1, inside });
+            stack.push_back({ node.first, inside });
+            continue;
+        }
+
+        for (uint32_t position = node.first; position < node.first + node.primitiveCount; position++)
+        {
+            uint32_t primitive = m_primitiveIndices[position];
+            if (IsEmptyBox(m_primitiveMinimum[primitive], m_primitiveMaximum[primitive]))
+                continue;
+            if (inside || TestFrustum(frustum, toBounds(m_primitiveMinimum[primitive], m_primitiveMaximum[primitive])) != CullResult::Outside)
+                results.push_back(primitive);
+        }
+    }
+}
+
+/// @brief Find the primitive whose box the ray enters first
+/// @param origin Start of the ray
+/// @param direction Direction of the ray; doesn't need to be normalized
+/// @param distance Receives the distance to the hit, in multiples of `direction`
+/// @return Index of the primitive hit, or InvalidIndex
+uint32_t Bvh::Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float& distance) const
+{
+    distance = FLT_MAX;
+    if (m_nodes.empty())
+        return InvalidIndex;
+
+    // Division by zero gives infinities, which the slab test handles fine
+    const DirectX::XMFLOAT3 inverseDirection = { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+
+    uint32_t closest = InvalidIndex;
+    std::vector<uint32_t> stack;
+    if (IntersectBox(origin, inverseDirection, m_nodes[0].minimum, m_nodes[0].maximum, distance) < FLT_MAX)
+        stack.push_back(0);
+
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        // The hit we have may have become closer than this node since it was pushed
+        if (IntersectBox(origin, inverseDirection, node.minimum, node.maximum, distance) == FLT_MAX)
+            continue;
+
+        if (node.primitiveCount > 0)
+        {
+            for (uint32_t position = node.first; position < node.first + node.primitiveCount; position++)
+            {
+                uint32_t primitive = m_primitiveIndices[position];
+                float hit = IntersectBox(origin, inverseDirection, m_primitiveMinimum[primitive], m_primitiveMaximum[primitive], distance);
+                if (hit < distance)
+                {
+                    distance = hit;
+                    closest = primitive;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first, so that the further one can often be skipped
+        const Node& left = m_nodes[node.first];
+        const Node& right = m_nodes[node.first + 1];
+        float leftHit = IntersectBox(origin, inverseDirection, left.minimum, left.maximum, distance);
+        float rightHit = IntersectBox(origin, inverseDirection, right.minimum, right.maximum, distance);
+
+        if (leftHit < rightHit)
+        {
+            if (rightHit < FLT_MAX)
+                stack.push_back(node.first + 1);
+            stack.push_back(node.first);
+        }
+        else
+        {
+            if (leftHit < FLT_MAX)
+                stack.push_back(node.first);
+            if (rightHit < FLT_MAX)
+                stack.push_back(node.first + 1);
+        }
+    }
+
+    return closest;
+}
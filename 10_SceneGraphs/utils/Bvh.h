@@ -0,0 +1,58 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+#include "Culling.h"
+
+/// @brief A bounding volume hierarchy over a set of primitive bounds, built with the surface area
+/// heuristic (SAH).
+///
+/// The primitives are only known by their index into the bounds array given to Build. When the
+/// primitives move, the existing tree can be refitted instead of rebuilt; refitting keeps the
+/// topology of the tree and only grows or shrinks the boxes. Rebuild when the set of primitives
+/// changes, or when the primitives have moved so much that the tree quality suffers.
+///
+/// Primitives with empty bounds are left out of the tree and never returned by a query. A refit
+/// that gives one of them bounds rebuilds the tree, since there is no leaf to put it in.
+class Bvh
+{
+public:
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    Bvh() = default;
+
+    void Build(const std::vector<Bounds>& primitiveBounds);
+    bool Refit(const std::vector<Bounds>& primitiveBounds);
+    bool Refit(const std::vector<Bounds>& primitiveBounds, const std::vector<uint32_t>& changedPrimitives);
+
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const;
+    uint32_t Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float& distance) const;
+
+    size_t GetNodeCount() const { return m_nodes.size(); }
+    size_t GetPrimitiveCount() const { return m_primitiveIndices.size(); }
+
+private:
+    // Interior nodes have a primitive count of 0, and their two children stored next to each other
+    // starting at `first`. Leaves refer to a range of m_primitiveIndices instead. Children are always
+    // stored after their parent.
+    struct Node
+    {
+        DirectX::XMFLOAT3 minimum;
+        uint32_t first;
+        DirectX::XMFLOAT3 maximum;
+        uint32_t primitiveCount;
+    };
+
+    void StorePrimitive(uint32_t primitive, const Bounds& bounds);
+    void FitLeaf(uint32_t nodeIndex);
+    bool FitInterior(uint32_t nodeIndex);
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_parents;            // Parent of each node, InvalidIndex for the root
+    std::vector<uint32_t> m_primitiveIndices;   // Primitives, grouped by leaf
+    std::vector<uint32_t> m_primitiveLeaves;    // Leaf holding each primitive, InvalidIndex for those left out
+    std::vector<DirectX::XMFLOAT3> m_primitiveMinimum; // Empty bounds are stored inside out, minimum above maximum
+    std::vector<DirectX::XMFLOAT3> m_primitiveMaximum;
+};
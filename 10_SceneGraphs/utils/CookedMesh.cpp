@@ -0,0 +1,207 @@
+#include "CookedMesh.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "MeshSplitter.h"
+#include "VertexCompression.h"
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value)
+    {
+        return (value + c_cookedMeshAlignment - 1) & ~(c_cookedMeshAlignment - 1);
+    }
+
+    /// @brief Is [offset, offset + size) inside a file of fileSize bytes?
+    bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    void WritePadding(std::ofstream& file, uint64_t from, uint64_t to)
+    {
+        static const char zeros[c_cookedMeshAlignment] = {};
+        file.write(zeros, static_cast<std::streamsize>(to - from));
+    }
+}
+
+uint32_t GetCookedVertexStride(CookedVertexFormat format)
+{
+    switch (format)
+    {
+    case CookedVertexFormat::PackedNormal:
+        return sizeof(PackedVertexNormal);
+    case CookedVertexFormat::PackedNormalUV:
+        return sizeof(PackedVertexNormalUV);
+    }
+    return 0;
+}
+
+/// @brief Write a cooked mesh to disk
+/// @param path Where to write the file; it is replaced if it exists
+/// @param mesh The mesh, with vertices already in the layout of its vertex format
+/// @param error Set to the reason when writing fails
+bool WriteCookedMesh(const std::string& path, const CookedMeshData& mesh, std::string& error)
+{
+    uint32_t stride = GetCookedVertexStride(mesh.vertexFormat);
+    if (stride == 0 || mesh.vertices.size() != static_cast<size_t>(mesh.vertexCount) * stride)
+    {
+        error = "the vertex blob doesn't match the vertex count and format";
+        return false;
+    }
+
+    // Indices are local to their submesh, so 16 bit ones do as long as no submesh is too big for
+    // them, like they would if the source had been loaded directly
+    bool shortIndices = mesh.submeshes.empty() ? FitsShortIndices(mesh.vertexCount) : true;
+    for (const auto& submesh : mesh.submeshes)
+    {
+        shortIndices = shortIndices && FitsShortIndices(submesh.vertexCount);
+    }
+    std::vector<uint16_t> narrowed;
+    if (shortIndices)
+        narrowed = NarrowIndices(mesh.indices);
+
+    CookedMeshHeader header = {};
+    header.magic = c_cookedMeshMagic;
+    header.version = c_cookedMeshVersion;
+    header.vertexFormat = static_cast<uint32_t>(mesh.vertexFormat);
+    header.vertexStride = stride;
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+    header.materialCount = static_cast<uint32_t>(mesh.materials.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    std::memcpy(header.boundsCenter, mesh.boundsCenter, sizeof(header.boundsCenter));
+    std::memcpy(header.boundsExtents, mesh.boundsExtents, sizeof(header.boundsExtents));
+    header.boundsRadius = mesh.boundsRadius;
+
+    uint64_t vertexBytes = mesh.vertices.size();
+    uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * header.indexSize;
+    uint64_t submeshBytes = mesh.submeshes.size() * sizeof(CookedSubmesh);
+    uint64_t materialBytes = mesh.materials.size() * sizeof(CookedMaterial);
+    uint64_t lodBytes = mesh.lods.size() * sizeof(CookedLod);
+
+    header.vertexOffset = AlignUp(sizeof(CookedMeshHeader));
+    header.indexOffset = AlignUp(header.vertexOffset + vertexBytes);
+    header.submeshOffset = AlignUp(header.indexOffset + indexBytes);
+    header.materialOffset = AlignUp(header.submeshOffset + submeshBytes);
+    header.lodOffset = AlignUp(header.materialOffset + materialBytes);
+    header.fileSize = header.lodOffset + lodBytes;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        error = "couldn't open the file for writing";
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WritePadding(file, sizeof(header), header.vertexOffset);
+
+    file.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(vertexBytes));
+    WritePadding(file, header.vertexOffset + vertexBytes, header.indexOffset);
+
+    if (shortIndices)
+        file.write(reinterpret_cast<const char*>(narrowed.data()), static_cast<std::streamsize>(indexBytes));
+    else
+        file.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(indexBytes));
+    WritePadding(file, header.indexOffset + indexBytes, header.submeshOffset);
+
+    file.write(reinterpret_cast<const char*>(mesh.submeshes.data()), static_cast<std::streamsize>(submeshBytes));
+    WritePadding(file, header.submeshOffset + submeshBytes, header.materialOffset);
+
+    file.write(reinterpret_cast<const char*>(mesh.materials.data()), static_cast<std::streamsize>(materialBytes));
+    WritePadding(file, header.materialOffset + materialBytes, header.lodOffset);
+
+    file.write(reinterpret_cast<const char*>(mesh.lods.data()), static_cast<std::streamsize>(lodBytes));
+
+    if (!file)
+    {
+        error = "writing the file failed";
+        return false;
+    }
+    return true;
+}
+
+/// @brief Check that a block of memory holds a cooked mesh this build understands. Everything the
+/// getters point at is known to be inside the block once this returns true.
+/// @param data Start of the file
+/// @param size Size of the file, in bytes
+bool CookedMeshView::Open(const void* data, size_t size)
+{
+    m_bytes = static_cast<const uint8_t*>(data);
+    m_header = nullptr;
+    m_error.clear();
+
+    if (data == nullptr || size < sizeof(CookedMeshHeader))
+        return Fail("too small to be a cooked mesh");
+
+    const auto* header = static_cast<const CookedMeshHeader*>(data);
+    if (header->magic != c_cookedMeshMagic)
+        return Fail("not a cooked mesh");
+    if (header->version != c_cookedMeshVersion)
+        return Fail("cooked with version " + std::to_string(header->version) + ", expected " + std::to_string(c_cookedMeshVersion));
+    if (header->fileSize != size)
+        return Fail("truncated, or has trailing data");
+
+    uint32_t stride = GetCookedVertexStride(static_cast<CookedVertexFormat>(header->vertexFormat));
+    if (stride == 0 || stride != header->vertexStride)
+        return Fail("unknown vertex format " + std::to_string(header->vertexFormat));
+    if (header->indexSize != sizeof(uint16_t) && header->indexSize != sizeof(uint32_t))
+        return Fail("unsupported index size " + std::to_string(header->indexSize));
+    if (header->indexCount % 3 != 0)
+        return Fail("index count isn't a whole number of triangles");
+
+    bool aligned = header->vertexOffset % c_cookedMeshAlignment == 0 && header->indexOffset % c_cookedMeshAlignment == 0
+        && header->submeshOffset % c_cookedMeshAlignment == 0 && header->materialOffset % c_cookedMeshAlignment == 0
+        && header->lodOffset % c_cookedMeshAlignment == 0;
+    if (!aligned
+        || !InFile(header->vertexOffset, static_cast<uint64_t>(header->vertexCount) * stride, size)
+        || !InFile(header->indexOffset, static_cast<uint64_t>(header->indexCount) * header->indexSize, size)
+        || !InFile(header->submeshOffset, static_cast<uint64_t>(header->submeshCount) * sizeof(CookedSubmesh), size)
+        || !InFile(header->materialOffset, static_cast<uint64_t>(header->materialCount) * sizeof(CookedMaterial), size)
+        || !InFile(header->lodOffset, static_cast<uint64_t>(header->lodCount) * sizeof(CookedLod), size))
+    {
+        return Fail("a blob lies outside the file");
+    }
+
+    const auto* submeshes = reinterpret_cast<const CookedSubmesh*>(m_bytes + header->submeshOffset);
+    for (uint32_t index = 0; index < header->submeshCount; index++)
+    {
+        const auto& submesh = submeshes[index];
+        if (!InFile(submesh.firstIndex, submesh.indexCount, header->indexCount)
+            || !InFile(submesh.firstVertex, submesh.vertexCount, header->vertexCount)
+            || (header->materialCount > 0 && submesh.materialIndex >= header->materialCount))
+        {
+            return Fail("submesh " + std::to_string(index) + " is out of range");
+        }
+    }
+
+    const auto* lods = reinterpret_cast<const CookedLod*>(m_bytes + header->lodOffset);
+    for (uint32_t index = 0; index < header->lodCount; index++)
+    {
+        const auto& lod = lods[index];
+        if (lod.submeshIndex >= header->submeshCount
+            || (index > 0 && lod.submeshIndex < lods[index - 1].submeshIndex)
+            || lod.indexCount % 3 != 0
+            || !InFile(lod.firstIndex, lod.indexCount, submeshes[lod.submeshIndex].indexCount))
+        {
+            return Fail("LOD " + std::to_string(index) + " is out of range");
+        }
+    }
+
+    // Only the bounds of the index ranges are checked, not every index: that would mean touching
+    // the whole blob, which is what cooking is meant to avoid. D3D treats out of range vertices as
+    // zero rather than reading past the buffer.
+    m_header = header;
+    return true;
+}
+
+bool CookedMeshView::Fail(const std::string& error)
+{
+    m_error = error;
+    m_header = nullptr;
+    return false;
+}
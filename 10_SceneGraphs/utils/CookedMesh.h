@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// The cooked mesh format (.wtgm) holds a mesh exactly as the renderer uploads it, so loading one
+/// is a matter of mapping the file and pointing D3D at the blobs. MeshCooker writes them from
+/// anything assimp can read.
+///
+/// The file is a CookedMeshHeader followed by the vertex blob, the index blob, the submesh table,
+/// the material table and the LOD table, each starting on a c_cookedMeshAlignment boundary.
+/// Everything is little endian. Each submesh is a self contained run of vertices and indices with
+/// one material, its indices counting from its own first vertex and its positions quantized with its
+/// own scale and offset, which the cooker makes the same for every submesh so they meet without
+/// cracks. A submesh's index range holds all of its levels of detail one after the other, and
+/// the LOD table says where each one starts; a submesh with no entries in it has just the one
+/// level. Bump c_cookedMeshVersion whenever the layout of any of it changes; files with another
+/// version are rejected and the source asset is loaded instead.
+///
+/// This header is shared with the cooker, so it must stay free of Windows and D3D headers.
+
+constexpr uint32_t c_cookedMeshMagic = 0x4D475457;     // "WTGM"
+constexpr uint32_t c_cookedMeshVersion = 3;
+constexpr uint64_t c_cookedMeshAlignment = 16;
+constexpr char c_cookedMeshExtension[] = ".wtgm";
+
+/// @brief Layout of the vertex blob. The values are written to disk, so never renumber them.
+/// 0 and 1 were the full float layouts, with the colour in every vertex, of version 1.
+enum class CookedVertexFormat : uint32_t
+{
+    PackedNormal = 2,   // PackedVertexNormal: quantized position, octahedral normal
+    PackedNormalUV = 3  // PackedVertexNormalUV: quantized position, octahedral normal, half float texture coordinate
+};
+
+/// @brief Size in bytes of a vertex in the given format, or 0 if the format is unknown
+uint32_t GetCookedVertexStride(CookedVertexFormat format);
+
+struct CookedMeshHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexFormat;      // a CookedVertexFormat
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;         // 2 or 4; 16 bit indices whenever every submesh's vertices fit
+    uint32_t submeshCount;
+    uint32_t materialCount;
+    uint32_t lodCount;          // entries in the LOD table, for all the submeshes together
+
+    float boundsCenter[3];      // same as Bounds: the centre of the box, shared with the sphere
+    float boundsExtents[3];
+    float boundsRadius;
+    uint32_t reserved1;
+
+    uint64_t vertexOffset;      // offsets are from the start of the file
+    uint64_t indexOffset;
+    uint64_t submeshOffset;
+    uint64_t materialOffset;
+    uint64_t lodOffset;
+    uint64_t fileSize;
+};
+static_assert(sizeof(CookedMeshHeader) == 120, "CookedMeshHeader is written to disk; keep its size fixed");
+
+/// @brief A range of the vertex and index buffers drawn with one material
+struct CookedSubmesh
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstVertex;       // the submesh's indices count from here
+    uint32_t vertexCount;
+    uint32_t materialIndex;
+    uint32_t reserved;
+    float positionScale[3];     // the submesh's PositionQuantization
+    float positionOffset[3];
+};
+static_assert(sizeof(CookedSubmesh) == 48, "CookedSubmesh is written to disk; keep its size fixed");
+
+/// @brief A level of detail of a submesh. The table is sorted by submesh and then level, finest first.
+struct CookedLod
+{
+    uint32_t submeshIndex;
+    uint32_t firstIndex;        // from the submesh's first index
+    uint32_t indexCount;
+    float error;                // how far the level strays from the full submesh, in model units
+};
+static_assert(sizeof(CookedLod) == 16, "CookedLod is written to disk; keep its size fixed");
+
+struct CookedMaterial
+{
+    float diffuse[3];
+    char diffuseTexture[116];   // path as stored in the source asset, null terminated; empty if none
+};
+static_assert(sizeof(CookedMaterial) == 128, "CookedMaterial is written to disk; keep its size fixed");
+
+/// @brief Everything the cooker collects about a mesh before it is written out
+struct CookedMeshData
+{
+    CookedVertexFormat vertexFormat = CookedVertexFormat::PackedNormal;
+    uint32_t vertexCount = 0;
+    std::vector<uint8_t> vertices;      // vertexCount vertices, already in the format's layout
+    std::vector<uint32_t> indices;      // local to each submesh, narrowed to 16 bits on write when they fit
+    std::vector<CookedSubmesh> submeshes;
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedLod> lods;
+
+    float boundsCenter[3] = { 0.0f, 0.0f, 0.0f };
+    float boundsExtents[3] = { 0.0f, 0.0f, 0.0f };
+    float boundsRadius = -1.0f;
+};
+
+bool WriteCookedMesh(const std::string& path, const CookedMeshData& mesh, std::string& error);
+
+/// @brief A validated look at a cooked mesh held in memory, usually a mapped file. Doesn't copy
+/// anything, so the memory has to outlive the view.
+class CookedMeshView
+{
+public:
+    CookedMeshView() = default;
+
+    bool Open(const void* data, size_t size);
+
+    const CookedMeshHeader& GetHeader() const { return *m_header; }
+    CookedVertexFormat GetVertexFormat() const { return static_cast<CookedVertexFormat>(m_header->vertexFormat); }
+    const void* GetVertices() const { return m_bytes + m_header->vertexOffset; }
+    const void* GetIndices() const { return m_bytes + m_header->indexOffset; }
+    const CookedSubmesh* GetSubmeshes() const { return reinterpret_cast<const CookedSubmesh*>(m_bytes + m_header->submeshOffset); }
+    const CookedMaterial* GetMaterials() const { return reinterpret_cast<const CookedMaterial*>(m_bytes + m_header->materialOffset); }
+    const CookedLod* GetLods() const { return reinterpret_cast<const CookedLod*>(m_bytes + m_header->lodOffset); }
+
+    /// @brief Why the last call to Open failed
+    const std::string& GetError() const { return m_error; }
+
+private:
+    bool Fail(const std::string& error);
+
+    const uint8_t* m_bytes = nullptr;
+    const CookedMeshHeader* m_header = nullptr;
+    std::string m_error;
+};
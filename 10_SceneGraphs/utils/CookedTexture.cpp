@@ -0,0 +1,197 @@
+#include "CookedTexture.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "TextureMips.h"
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value)
+    {
+        return (value + c_cookedTextureAlignment - 1) & ~(c_cookedTextureAlignment - 1);
+    }
+
+    /// @brief Is [offset, offset + size) inside a file of fileSize bytes?
+    bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    void WritePadding(std::ofstream& file, uint64_t from, uint64_t to)
+    {
+        static const char zeros[c_cookedTextureAlignment] = {};
+        file.write(zeros, static_cast<std::streamsize>(to - from));
+    }
+
+    bool IsKnownFormat(uint32_t format)
+    {
+        return format <= static_cast<uint32_t>(CookedTextureFormat::BC7);
+    }
+}
+
+bool IsBlockCompressed(CookedTextureFormat format)
+{
+    return format != CookedTextureFormat::RGBA8;
+}
+
+const char* GetCookedTextureFormatName(CookedTextureFormat format)
+{
+    switch (format)
+    {
+    case CookedTextureFormat::RGBA8:
+        return "RGBA8";
+    case CookedTextureFormat::BC1:
+        return "BC1";
+    case CookedTextureFormat::BC3:
+        return "BC3";
+    case CookedTextureFormat::BC7:
+        return "BC7";
+    }
+    return "unknown";
+}
+
+/// @brief Bytes from one row of a level to the next: a row of texels, or of 4x4 blocks
+uint64_t GetCookedLevelPitch(CookedTextureFormat format, uint32_t width)
+{
+    if (!IsBlockCompressed(format))
+        return static_cast<uint64_t>(width) * 4;
+    return static_cast<uint64_t>((width + c_blockSize - 1) / c_blockSize) * GetBlockBytes(static_cast<BlockFormat>(format));
+}
+
+uint64_t GetCookedLevelSize(CookedTextureFormat format, uint32_t width, uint32_t height)
+{
+    uint64_t rows = IsBlockCompressed(format) ? (height + c_blockSize - 1) / c_blockSize : height;
+    return GetCookedLevelPitch(format, width) * rows;
+}
+
+/// @brief Write a cooked texture to disk
+/// @param path Where to write the file; it is replaced if it exists
+/// @param texture The texture, with every level already in the layout of its format
+/// @param error Set to the reason when writing fails
+bool WriteCookedTexture(const std::string& path, const CookedTextureData& texture, std::string& error)
+{
+    uint32_t mipCount = static_cast<uint32_t>(texture.levels.size());
+    if (texture.width == 0 || texture.height == 0 || mipCount == 0 || mipCount > GetMipCount(texture.width, texture.height))
+    {
+        error = "the texture has no levels, or more than its size allows";
+        return false;
+    }
+
+    // D3D only takes block compressed textures whose first level is whole blocks
+    if (IsBlockCompressed(texture.format) && (texture.width % c_blockSize != 0 || texture.height % c_blockSize != 0))
+    {
+        error = "block compressed textures have to be a multiple of 4 texels on each side";
+        return false;
+    }
+
+    CookedTextureHeader header = {};
+    header.magic = c_cookedTextureMagic;
+    header.version = c_cookedTextureVersion;
+    header.format = static_cast<uint32_t>(texture.format);
+    header.flags = texture.srgb ? static_cast<uint32_t>(CookedTextureSrgb) : 0;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipCount = mipCount;
+    header.mipOffset = AlignUp(sizeof(CookedTextureHeader));
+
+    std::vector<CookedMip> mips(mipCount);
+    uint64_t offset = AlignUp(header.mipOffset + mipCount * sizeof(CookedMip));
+    for (uint32_t level = 0; level < mipCount; level++)
+    {
+        auto& mip = mips[level];
+        mip.width = std::max(1u, texture.width >> level);
+        mip.height = std::max(1u, texture.height >> level);
+        mip.rowPitch = static_cast<uint32_t>(GetCookedLevelPitch(texture.format, mip.width));
+        mip.offset = offset;
+        mip.size = GetCookedLevelSize(texture.format, mip.width, mip.height);
+        if (texture.levels[level].size() != mip.size)
+        {
+            error = "level " + std::to_string(level) + " doesn't match its size and the format";
+            return false;
+        }
+        offset = AlignUp(offset + mip.size);
+    }
+    header.fileSize = mips.back().offset + mips.back().size;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        error = "couldn't open the file for writing";
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WritePadding(file, sizeof(header), header.mipOffset);
+
+    uint64_t position = header.mipOffset + mipCount * sizeof(CookedMip);
+    file.write(reinterpret_cast<const char*>(mips.data()), static_cast<std::streamsize>(mipCount * sizeof(CookedMip)));
+    for (uint32_t level = 0; level < mipCount; level++)
+    {
+        WritePadding(file, position, mips[level].offset);
+        file.write(reinterpret_cast<const char*>(texture.levels[level].data()), static_cast<std::streamsize>(mips[level].size));
+        position = mips[level].offset + mips[level].size;
+    }
+
+    if (!file)
+    {
+        error = "writing the file failed";
+        return false;
+    }
+    return true;
+}
+
+/// @brief Check that a block of memory holds a cooked texture this build understands. Every level
+/// the getters point at is known to be inside the block once this returns true.
+/// @param data Start of the file
+/// @param size Size of the file, in bytes
+bool CookedTextureView::Open(const void* data, size_t size)
+{
+    m_bytes = static_cast<const uint8_t*>(data);
+    m_header = nullptr;
+    m_error.clear();
+
+    if (data == nullptr || size < sizeof(CookedTextureHeader))
+        return Fail("too small to be a cooked texture");
+
+    const auto* header = static_cast<const CookedTextureHeader*>(data);
+    if (header->magic != c_cookedTextureMagic)
+        return Fail("not a cooked texture");
+    if (header->version != c_cookedTextureVersion)
+        return Fail("cooked with version " + std::to_string(header->version) + ", expected " + std::to_string(c_cookedTextureVersion));
+    if (header->fileSize != size)
+        return Fail("truncated, or has trailing data");
+    if (!IsKnownFormat(header->format))
+        return Fail("unknown format " + std::to_string(header->format));
+
+    auto format = static_cast<CookedTextureFormat>(header->format);
+    if (header->width == 0 || header->height == 0 || header->mipCount == 0 || header->mipCount > GetMipCount(header->width, header->height))
+        return Fail("bad size or mip count");
+    if (IsBlockCompressed(format) && (header->width % c_blockSize != 0 || header->height % c_blockSize != 0))
+        return Fail("block compressed, but not a multiple of 4 texels on each side");
+    if (header->mipOffset % c_cookedTextureAlignment != 0 || !InFile(header->mipOffset, static_cast<uint64_t>(header->mipCount) * sizeof(CookedMip), size))
+        return Fail("the mip table lies outside the file");
+
+    // Each level has to be exactly what its size and the format make it, so D3D never reads past it
+    const auto* mips = reinterpret_cast<const CookedMip*>(m_bytes + header->mipOffset);
+    for (uint32_t level = 0; level < header->mipCount; level++)
+    {
+        const auto& mip = mips[level];
+        if (mip.width != std::max(1u, header->width >> level) || mip.height != std::max(1u, header->height >> level)
+            || mip.rowPitch != GetCookedLevelPitch(format, mip.width) || mip.size != GetCookedLevelSize(format, mip.width, mip.height)
+            || mip.offset % c_cookedTextureAlignment != 0 || !InFile(mip.offset, mip.size, size))
+        {
+            return Fail("level " + std::to_string(level) + " is out of range");
+        }
+    }
+
+    m_header = header;
+    return true;
+}
+
+bool CookedTextureView::Fail(const std::string& error)
+{
+    m_error = error;
+    m_header = nullptr;
+    return false;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+/// The cooked texture format (.wtgt) holds a texture's whole mip chain exactly as the GPU reads it,
+/// already filtered and block compressed, so loading one is a matter of mapping the file and
+/// handing every level to D3D in one go. TextureCooker writes them from the source images.
+///
+/// The file is a CookedTextureHeader followed by the mip table and then each level's data, finest
+/// first, each starting on a c_cookedTextureAlignment boundary. Everything is little endian. Bump
+/// c_cookedTextureVersion whenever the layout changes; files with another version are rejected and
+/// the source image is loaded instead.
+///
+/// This header is shared with the cooker, so it must stay free of Windows and D3D headers.
+
+constexpr uint32_t c_cookedTextureMagic = 0x54475457;  // "WTGT"
+constexpr uint32_t c_cookedTextureVersion = 1;
+constexpr uint64_t c_cookedTextureAlignment = 16;
+constexpr char c_cookedTextureExtension[] = ".wtgt";
+
+/// @brief Layout of each level. The values are written to disk, so never renumber them; the block
+/// compressed ones match BlockFormat.
+enum class CookedTextureFormat : uint32_t
+{
+    RGBA8 = 0,
+    BC1 = static_cast<uint32_t>(BlockFormat::BC1),
+    BC3 = static_cast<uint32_t>(BlockFormat::BC3),
+    BC7 = static_cast<uint32_t>(BlockFormat::BC7)
+};
+
+/// @brief The header's flags
+enum CookedTextureFlags : uint32_t
+{
+    CookedTextureSrgb = 1 << 0     // colour is sRGB encoded, and the mips were filtered in linear light
+};
+
+bool IsBlockCompressed(CookedTextureFormat format);
+const char* GetCookedTextureFormatName(CookedTextureFormat format);
+uint64_t GetCookedLevelPitch(CookedTextureFormat format, uint32_t width);
+uint64_t GetCookedLevelSize(CookedTextureFormat format, uint32_t width, uint32_t height);
+
+struct CookedTextureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;            // a CookedTextureFormat
+    uint32_t flags;             // CookedTextureFlags
+    uint32_t width;             // of the first level
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t reserved;
+
+    uint64_t mipOffset;         // offsets are from the start of the file
+    uint64_t fileSize;
+};
+static_assert(sizeof(CookedTextureHeader) == 48, "CookedTextureHeader is written to disk; keep its size fixed");
+
+struct CookedMip
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowPitch;          // bytes from one row of texels, or of blocks, to the next
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+static_assert(sizeof(CookedMip) == 32, "CookedMip is written to disk; keep its size fixed");
+
+/// @brief Everything the cooker makes of a texture before it is written out
+struct CookedTextureData
+{
+    CookedTextureFormat format = CookedTextureFormat::RGBA8;
+    bool srgb = true;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::vector<uint8_t>> levels;   // the full mip chain, finest first, already in the format's layout
+};
+
+bool WriteCookedTexture(const std::string& path, const CookedTextureData& texture, std::string& error);
+
+/// @brief A validated look at a cooked texture held in memory, usually a mapped file. Doesn't copy
+/// anything, so the memory has to outlive the view.
+class CookedTextureView
+{
+public:
+    CookedTextureView() = default;
+
+    bool Open(const void* data, size_t size);
+
+    const CookedTextureHeader& GetHeader() const { return *m_header; }
+    CookedTextureFormat GetFormat() const { return static_cast<CookedTextureFormat>(m_header->format); }
+    bool IsSrgb() const { return (m_header->flags & CookedTextureSrgb) != 0; }
+    const CookedMip& GetMip(uint32_t level) const { return reinterpret_cast<const CookedMip*>(m_bytes + m_header->mipOffset)[level]; }
+    const void* GetMipData(uint32_t level) const { return m_bytes + GetMip(level).offset; }
+
+    /// @brief Why the last call to Open failed
+    const std::string& GetError() const { return m_error; }
+
+private:
+    bool Fail(const std::string& error);
+
+    const uint8_t* m_bytes = nullptr;
+    const CookedTextureHeader* m_header = nullptr;
+    std::string m_error;
+};
@@ -0,0 +1,215 @@
+#include "Culling.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/// @brief Compute the bounds of a set of points
+/// @param positions Pointer to the first position; each position is three floats
+/// @param count Number of positions
+/// @param strideInBytes Distance between the start of two consecutive positions
+/// @return The bounds, empty if there are no points
+Bounds ComputeBounds(const void* positions, size_t count, size_t strideInBytes)
+{
+    Bounds bounds;
+    if (count == 0)
+        return bounds;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(positions);
+
+    DirectX::XMVECTOR minimum = DirectX::XMVectorReplicate(FLT_MAX);
+    DirectX::XMVECTOR maximum = DirectX::XMVectorReplicate(-FLT_MAX);
+    for (size_t index = 0; index < count; index++)
+    {
+        DirectX::XMVECTOR point = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(bytes + index * strideInBytes));
+        minimum = DirectX::XMVectorMin(minimum, point);
+        maximum = DirectX::XMVectorMax(maximum, point);
+    }
+
+    DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(minimum, maximum), 0.5f);
+    DirectX::XMStoreFloat3(&bounds.center, center);
+    DirectX::XMStoreFloat3(&bounds.extents, DirectX::XMVectorSubtract(maximum, center));
+
+    // Second pass for the sphere, which is usually a lot tighter than the one around the box
+    float radiusSquared = 0.0f;
+    for (size_t index = 0; index < count; index++)
+    {
+        DirectX::XMVECTOR point = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(bytes + index * strideInBytes));
+        radiusSquared = std::max(radiusSquared, DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(DirectX::XMVectorSubtract(point, center))));
+    }
+    bounds.radius = sqrtf(radiusSquared);
+
+    return bounds;
+}
+
+/// @brief The smallest box that contains both boxes, with a sphere that contains both spheres
+Bounds MergeBounds(const Bounds& a, const Bounds& b)
+{
+    if (a.IsEmpty())
+        return b;
+    if (b.IsEmpty())
+        return a;
+
+    DirectX::XMVECTOR centerA = DirectX::XMLoadFloat3(&a.center);
+    DirectX::XMVECTOR centerB = DirectX::XMLoadFloat3(&b.center);
+    DirectX::XMVECTOR extentsA = DirectX::XMLoadFloat3(&a.extents);
+    DirectX::XMVECTOR extentsB = DirectX::XMLoadFloat3(&b.extents);
+
+    DirectX::XMVECTOR minimum = DirectX::XMVectorMin(DirectX::XMVectorSubtract(centerA, extentsA), DirectX::XMVectorSubtract(centerB, extentsB));
+    DirectX::XMVECTOR maximum = DirectX::XMVectorMax(DirectX::XMVectorAdd(centerA, extentsA), DirectX::XMVectorAdd(centerB, extentsB));
+    DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(minimum, maximum), 0.5f);
+
+    Bounds merged;
+    DirectX::XMStoreFloat3(&merged.center, center);
+    DirectX::XMStoreFloat3(&merged.extents, DirectX::XMVectorSubtract(maximum, center));
+
+    // The spheres are re-centred on the box, so grow each one by how far its centre moved
+    float distanceA = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(centerA, center)));
+    float distanceB = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(centerB, center)));
+    float boxRadius = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(maximum, center)));
+    merged.radius = std::min(boxRadius, std::max(distanceA + a.radius, distanceB + b.radius));
+
+    return merged;
+}
+
+/// @brief Move bounds into another space. The box is grown to stay axis aligned in the new space.
+Bounds TransformBounds(const Bounds& bounds, const DirectX::XMMATRIX& transform)
+{
+    if (bounds.IsEmpty())
+        return bounds;
+
+    Bounds transformed;
+
+    DirectX::XMVECTOR center = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.center), transform);
+    DirectX::XMStoreFloat3(&transformed.center, center);
+
+    // Each new extent is the sum of the absolute contributions of the old extents (Arvo)
+    DirectX::XMVECTOR extents = DirectX::XMLoadFloat3(&bounds.extents);
+    DirectX::XMVECTOR newExtents = DirectX::XMVectorMultiply(DirectX::XMVectorSplatX(extents), DirectX::XMVectorAbs(transform.r[0]));
+    newExtents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorSplatY(extents), DirectX::XMVectorAbs(transform.r[1]), newExtents);
+    newExtents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorSplatZ(extents), DirectX::XMVectorAbs(transform.r[2]), newExtents);
+    DirectX::XMStoreFloat3(&transformed.extents, newExtents);
+
+    // The sphere scales with the largest axis scale
+    float scaleX = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(transform.r[0]));
+    float scaleY = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(transform.r[1]));
+    float scaleZ = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(transform.r[2]));
+    transformed.radius = bounds.radius * sqrtf(std::max(scaleX, std::max(scaleY, scaleZ)));
+
+    return transformed;
+}
+
+/// @brief Extract the frustum planes from a (row vector) view projection matrix, with clip space
+/// depth in [0, w] as D3D uses (Gribb/Hartmann).
+Frustum ExtractFrustum(const DirectX::XMMATRIX& viewProjection)
+{
+    // The planes are combinations of the columns of the matrix, which are the rows of its transpose
+    DirectX::XMMATRIX columns = DirectX::XMMatrixTranspose(viewProjection);
+
+    DirectX::XMVECTOR planes[6] = {
+        DirectX::XMVectorAdd(columns.r[3], columns.r[0]),      // left
+        DirectX::XMVectorSubtract(columns.r[3], columns.r[0]), // right
+        DirectX::XMVectorAdd(columns.r[3], columns.r[1]),      // bottom
+        DirectX::XMVectorSubtract(columns.r[3], columns.r[1]), // top
+        columns.r[2],                                          // near
+        DirectX::XMVectorSubtract(columns.r[3], columns.r[2]), // far
+    };
+
+    Frustum frustum;
+    for (int plane = 0; plane < 6; plane++)
+    {
+        DirectX::XMStoreFloat4(&frustum.planes[plane], DirectX::XMPlaneNormalize(planes[plane]));
+    }
+
+    // Transposed copy, padding the second group with a plane that everything is inside of
+    const DirectX::XMFLOAT4 alwaysInside = { 0.0f, 0.0f, 0.0f, FLT_MAX };
+    const DirectX::XMFLOAT4* p[8] = {
+        &frustum.planes[0], &frustum.planes[1], &frustum.planes[2], &frustum.planes[3],
+        &frustum.planes[4], &frustum.planes[5], &alwaysInside, &alwaysInside
+    };
+    for (int group = 0; group < 2; group++)
+    {
+        const DirectX::XMFLOAT4* const* g = p + group * 4;
+        frustum.planesX[group] = { g[0]->x, g[1]->x, g[2]->x, g[3]->x };
+        frustum.planesY[group] = { g[0]->y, g[1]->y, g[2]->y, g[3]->y };
+        frustum.planesZ[group] = { g[0]->z, g[1]->z, g[2]->z, g[3]->z };
+        frustum.planesW[group] = { g[0]->w, g[1]->w, g[2]->w, g[3]->w };
+    }
+
+    return frustum;
+}
+
+/// @brief Test bounds against a frustum. The cheap sphere test is tried first, and the box is
+/// only tested when the sphere straddles a plane.
+CullResult TestFrustum(const Frustum& frustum, const Bounds& bounds)
+{
+    if (bounds.IsEmpty())
+        return CullResult::Outside;
+
+    DirectX::XMVECTOR center = DirectX::XMVectorSetW(DirectX::XMLoadFloat3(&bounds.center), 1.0f);
+    DirectX::XMVECTOR extents = DirectX::XMLoadFloat3(&bounds.extents);
+
+    CullResult result = CullResult::Inside;
+    for (const auto& planeValues : frustum.planes)
+    {
+        DirectX::XMVECTOR plane = DirectX::XMLoadFloat4(&planeValues);
+        float distance = DirectX::XMVectorGetX(DirectX::XMVector4Dot(plane, center));
+
+        if (distance < -bounds.radius)
+            return CullResult::Outside;
+        if (distance >= bounds.radius)
+            continue;
+
+        // The sphere straddles the plane; see whether the box is any better
+        float projectedExtent = DirectX::XMVectorGetX(DirectX::XMVector3Dot(DirectX::XMVectorAbs(plane), extents));
+        if (distance < -projectedExtent)
+            return CullResult::Outside;
+        if (distance < projectedExtent)
+            result = CullResult::Intersecting;
+    }
+
+    return result;
+}
+
+/// @brief Test many bounding spheres against a frustum, four planes at a time.
+/// @param spheres Centre (xyz) and radius (w) of every sphere
+/// @param count Number of spheres
+/// @param visible Receives 1 for every sphere that is at least partially inside the frustum, 0 otherwise
+/// @return The number of visible spheres
+size_t CullSpheres(const Frustum& frustum, const DirectX::XMFLOAT4* spheres, size_t count, uint8_t* visible)
+{
+    DirectX::XMVECTOR planesX[2], planesY[2], planesZ[2], planesW[2];
+    for (int group = 0; group < 2; group++)
+    {
+        planesX[group] = DirectX::XMLoadFloat4(&frustum.planesX[group]);
+        planesY[group] = DirectX::XMLoadFloat4(&frustum.planesY[group]);
+        planesZ[group] = DirectX::XMLoadFloat4(&frustum.planesZ[group]);
+        planesW[group] = DirectX::XMLoadFloat4(&frustum.planesW[group]);
+    }
+
+    size_t visibleCount = 0;
+    for (size_t index = 0; index < count; index++)
+    {
+        DirectX::XMVECTOR sphere = DirectX::XMLoadFloat4(&spheres[index]);
+        DirectX::XMVECTOR x = DirectX::XMVectorSplatX(sphere);
+        DirectX::XMVECTOR y = DirectX::XMVectorSplatY(sphere);
+        DirectX::XMVECTOR z = DirectX::XMVectorSplatZ(sphere);
+        DirectX::XMVECTOR negativeRadius = DirectX::XMVectorNegate(DirectX::XMVectorSplatW(sphere));
+
+        // Signed distance to four planes at once, for each group of planes
+        DirectX::XMVECTOR outside = DirectX::XMVectorZero();
+        for (int group = 0; group < 2; group++)
+        {
+            DirectX::XMVECTOR distance = DirectX::XMVectorMultiplyAdd(x, planesX[group], planesW[group]);
+            distance = DirectX::XMVectorMultiplyAdd(y, planesY[group], distance);
+            distance = DirectX::XMVectorMultiplyAdd(z, planesZ[group], distance);
+            outside = DirectX::XMVectorOrInt(outside, DirectX::XMVectorLess(distance, negativeRadius));
+        }
+
+        uint8_t isVisible = DirectX::XMVector4EqualInt(outside, DirectX::XMVectorZero()) ? 1 : 0;
+        visible[index] = isVisible;
+        visibleCount += isVisible;
+    }
+
+    return visibleCount;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief An axis aligned bounding box and a bounding sphere sharing the same centre.
+/// A negative radius marks the bounds as empty.
+struct Bounds
+{
+    DirectX::XMFLOAT3 center = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 extents = { 0.0f, 0.0f, 0.0f }; // half the size of the box along each axis
+    float radius = -1.0f;
+
+    bool IsEmpty() const { return radius < 0.0f; }
+};
+
+/// @brief The six planes of a view frustum, pointing inwards: a point p is inside a plane when
+/// dot(plane.xyz, p) + plane.w >= 0.
+///
+/// The planes are also kept transposed (all the X components together, then all the Y components
+/// and so on) so that a point can be tested against four planes at once.
+struct Frustum
+{
+    DirectX::XMFLOAT4 planes[6];
+
+    // planesX[0] holds the x of planes 0-3, planesX[1] the x of planes 4-5 (padded).
+    DirectX::XMFLOAT4 planesX[2];
+    DirectX::XMFLOAT4 planesY[2];
+    DirectX::XMFLOAT4 planesZ[2];
+    DirectX::XMFLOAT4 planesW[2];
+};
+
+enum class CullResult
+{
+    Outside,
+    Intersecting,
+    Inside
+};
+
+Bounds ComputeBounds(const void* positions, size_t count, size_t strideInBytes);
+Bounds MergeBounds(const Bounds& a, const Bounds& b);
+Bounds TransformBounds(const Bounds& bounds, const DirectX::XMMATRIX& transform);
+
+Frustum ExtractFrustum(const DirectX::XMMATRIX& viewProjection);
+
+CullResult TestFrustum(const Frustum& frustum, const Bounds& bounds);
+
+size_t CullSpheres(const Frustum& frustum, const DirectX::XMFLOAT4* spheres, size_t count, uint8_t* visible);
@@ -0,0 +1,234 @@
+#include "ImageConvert.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define IMAGE_CONVERT_SSE 1
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets any function use SSSE3 intrinsics; GCC and Clang need telling, function by function,
+// so the rest of the file still runs on CPUs without it
+#if defined(IMAGE_CONVERT_SSE) && defined(__GNUC__)
+#define IMAGE_CONVERT_SSSE3 __attribute__((target("ssse3")))
+#else
+#define IMAGE_CONVERT_SSSE3
+#endif
+
+namespace
+{
+    constexpr uint32_t c_linearLevels = 65536;
+
+    /// @brief x / 255, rounded to nearest, for any x up to 255 * 255
+    uint32_t DivideBy255(uint32_t value)
+    {
+        value += 128;
+        return (value + (value >> 8)) >> 8;
+    }
+
+    /// @brief 8 bit sRGB to 16 bit linear and back, fine enough that every byte comes back as itself
+    struct PremultiplyTables
+    {
+        uint16_t decode[256];
+        uint8_t encode[c_linearLevels];
+
+        PremultiplyTables()
+        {
+            for (int value = 0; value < 256; value++)
+            {
+                double encoded = value / 255.0;
+                double linear = encoded <= 0.04045 ? encoded / 12.92 : std::pow((encoded + 0.055) / 1.055, 2.4);
+                decode[value] = static_cast<uint16_t>(std::lround(linear * (c_linearLevels - 1)));
+            }
+            for (uint32_t index = 0; index < c_linearLevels; index++)
+            {
+                double linear = static_cast<double>(index) / (c_linearLevels - 1);
+                double encoded = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+                encode[index] = static_cast<uint8_t>(std::lround(encoded * 255.0));
+            }
+        }
+    };
+
+    const PremultiplyTables& GetPremultiplyTables()
+    {
+        static const PremultiplyTables tables;
+        return tables;
+    }
+
+#ifdef IMAGE_CONVERT_SSE
+    bool HasSsse3()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3") != 0;
+#endif
+    }
+
+    /// @brief RGB to RGBA four texels at a time, with one shuffle. Each load reads 16 bytes for 12,
+    /// so the last few texels are left for the caller.
+    /// @return How many texels were expanded
+    IMAGE_CONVERT_SSSE3 size_t ExpandRgbSsse3(const uint8_t* source, size_t texelCount, uint8_t* rgba)
+    {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        size_t texel = 0;
+        for (; texel + 6 <= texelCount; texel += 4)
+        {
+            __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + texel * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + texel * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+        }
+        return texel;
+    }
+
+    /// @brief Grey to RGBA sixteen texels at a time
+    /// @return How many texels were expanded
+    size_t ExpandGreySse2(const uint8_t* source, size_t texelCount, uint8_t* rgba)
+    {
+        const __m128i opaque = _mm_set1_epi8(-1);
+        size_t texel = 0;
+        for (; texel + 16 <= texelCount; texel += 16)
+        {
+            __m128i grey = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + texel));
+            __m128i greyGrey[2] = { _mm_unpacklo_epi8(grey, grey), _mm_unpackhi_epi8(grey, grey) };
+            __m128i greyAlpha[2] = { _mm_unpacklo_epi8(grey, opaque), _mm_unpackhi_epi8(grey, opaque) };
+            auto* out = reinterpret_cast<__m128i*>(rgba + texel * 4);
+            for (int half = 0; half < 2; half++)
+            {
+                _mm_storeu_si128(out + half * 2, _mm_unpacklo_epi16(greyGrey[half], greyAlpha[half]));
+                _mm_storeu_si128(out + half * 2 + 1, _mm_unpackhi_epi16(greyGrey[half], greyAlpha[half]));
+            }
+        }
+        return texel;
+    }
+
+    /// @brief Grey and alpha to RGBA eight texels at a time
+    /// @return How many texels were expanded
+    size_t ExpandGreyAlphaSse2(const uint8_t* source, size_t texelCount, uint8_t* rgba)
+    {
+        const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+        size_t texel = 0;
+        for (; texel + 8 <= texelCount; texel += 8)
+        {
+            __m128i greyAlpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + texel * 2));
+            __m128i grey = _mm_and_si128(greyAlpha, lowBytes);
+            __m128i greyGrey = _mm_or_si128(grey, _mm_slli_epi16(grey, 8));
+            auto* out = reinterpret_cast<__m128i*>(rgba + texel * 4);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(greyGrey, greyAlpha));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(greyGrey, greyAlpha));
+        }
+        return texel;
+    }
+
+    /// @brief Two texels, as 16 bit channels, times their alpha over 255; the alpha stays as it was
+    __m128i PremultiplyPairSse2(__m128i texels)
+    {
+        const __m128i colourMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+        const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+        const __m128i half = _mm_set1_epi16(128);
+
+        __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(texels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_or_si128(_mm_and_si128(alpha, colourMask), alphaOne);
+        __m128i product = _mm_add_epi16(_mm_mullo_epi16(texels, alpha), half);
+        return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+    }
+
+    /// @brief Premultiply four texels at a time, in the encoded values
+    /// @return How many texels were premultiplied
+    size_t PremultiplySse2(uint8_t* rgba, size_t texelCount)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t texel = 0;
+        for (; texel + 4 <= texelCount; texel += 4)
+        {
+            auto* texels = reinterpret_cast<__m128i*>(rgba + texel * 4);
+            __m128i bytes = _mm_loadu_si128(texels);
+            __m128i low = PremultiplyPairSse2(_mm_unpacklo_epi8(bytes, zero));
+            __m128i high = PremultiplyPairSse2(_mm_unpackhi_epi8(bytes, zero));
+            _mm_storeu_si128(texels, _mm_packus_epi16(low, high));
+        }
+        return texel;
+    }
+#endif
+}
+
+/// @brief Turn texels of one to four 8 bit channels into RGBA: grey is copied into red, green and
+/// blue, and alpha is opaque when there isn't one
+/// @param channels 1 grey, 2 grey and alpha, 3 RGB or 4 RGBA
+/// @param rgba texelCount * 4 bytes; mustn't overlap the source
+void ExpandToRgba(const uint8_t* source, uint32_t channels, size_t texelCount, uint8_t* rgba)
+{
+    if (channels == 4)
+    {
+        // An empty image may come with null pointers, which memcpy mustn't be given even for 0 bytes
+        if (texelCount > 0)
+            std::memcpy(rgba, source, texelCount * 4);
+        return;
+    }
+
+    size_t texel = 0;
+#ifdef IMAGE_CONVERT_SSE
+    static const bool ssse3 = HasSsse3();
+    if (channels == 3 && ssse3)
+        texel = ExpandRgbSsse3(source, texelCount, rgba);
+    else if (channels == 2)
+        texel = ExpandGreyAlphaSse2(source, texelCount, rgba);
+    else if (channels == 1)
+        texel = ExpandGreySse2(source, texelCount, rgba);
+#endif
+
+    for (; texel < texelCount; texel++)
+    {
+        const uint8_t* in = source + texel * channels;
+        uint8_t* out = rgba + texel * 4;
+        out[0] = in[0];
+        out[1] = channels >= 3 ? in[1] : in[0];
+        out[2] = channels >= 3 ? in[2] : in[0];
+        out[3] = channels == 2 ? in[1] : 255;
+    }
+}
+
+/// @brief Multiply the colour of every texel by its alpha, so filtering and blending don't pull in
+/// the colour of texels that can't be seen
+/// @param srgb The colour is sRGB encoded, so multiply it in linear light and encode it again
+void PremultiplyAlpha(uint8_t* rgba, size_t texelCount, bool srgb)
+{
+    if (srgb)
+    {
+        const auto& tables = GetPremultiplyTables();
+        for (size_t texel = 0; texel < texelCount; texel++)
+        {
+            uint8_t* colour = rgba + texel * 4;
+            uint32_t alpha = colour[3];
+            if (alpha == 255)
+                continue;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                uint32_t linear = (tables.decode[colour[channel]] * alpha + 127) / 255;
+                colour[channel] = tables.encode[linear];
+            }
+        }
+        return;
+    }
+
+    size_t texel = 0;
+#ifdef IMAGE_CONVERT_SSE
+    texel = PremultiplySse2(rgba, texelCount);
+#endif
+
+    for (; texel < texelCount; texel++)
+    {
+        uint8_t* colour = rgba + texel * 4;
+        for (int channel = 0; channel < 3; channel++)
+        {
+            colour[channel] = static_cast<uint8_t>(DivideBy255(colour[channel] * colour[3]));
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Conversions between the layouts images are decoded in and the 8 bit RGBA that textures are made
+/// from. The loops are SSE2, or SSSE3 where the CPU has it, when built for x86, and plain C++
+/// otherwise; every version gives exactly the same bytes.
+
+void ExpandToRgba(const uint8_t* source, uint32_t channels, size_t texelCount, uint8_t* rgba);
+
+void PremultiplyAlpha(uint8_t* rgba, size_t texelCount, bool srgb);
@@ -0,0 +1,86 @@
+#include "ImageDecoder.h"
+
+#include <climits>
+
+#include "ImageConvert.h"
+#include "MappedFile.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace
+{
+    bool CheckSize(size_t size, std::string& error)
+    {
+        if (size > static_cast<size_t>(INT_MAX))
+        {
+            error = "too big to decode";
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief Say why stb_image failed
+    bool Fail(std::string& error)
+    {
+        const char* reason = stbi_failure_reason();
+        error = reason != nullptr ? reason : "unknown error";
+        return false;
+    }
+}
+
+/// @brief Read the size of an encoded image from its header, without decoding it
+/// @param error Set to the reason when the header can't be read
+bool ReadImageSize(const void* data, size_t size, uint32_t& width, uint32_t& height, std::string& error)
+{
+    if (!CheckSize(size, error))
+        return false;
+
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int channels = 0;
+    if (!stbi_info_from_memory(static_cast<const stbi_uc*>(data), static_cast<int>(size), &imageWidth, &imageHeight, &channels))
+        return Fail(error);
+
+    width = static_cast<uint32_t>(imageWidth);
+    height = static_cast<uint32_t>(imageHeight);
+    return true;
+}
+
+/// @brief Decode an image file (PNG, JPEG, TGA, BMP and anything else stb_image reads). The file is
+/// mapped rather than read through a buffer.
+/// @param error Set to the reason when decoding fails
+bool DecodeImageFile(const std::string& path, DecodedImage& image, std::string& error)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        error = "can't open the file";
+        return false;
+    }
+    return DecodeImageMemory(file.GetData(), file.GetSize(), image, error);
+}
+
+/// @brief Decode an image that is already in memory, such as one embedded in a model file. It is
+/// decoded with however many channels it has, which for RGB and grey images is less for stb_image
+/// to write, then expanded straight into the image's pixels.
+/// @param error Set to the reason when decoding fails
+bool DecodeImageMemory(const void* data, size_t size, DecodedImage& image, std::string& error)
+{
+    if (!CheckSize(size, error))
+        return false;
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    unsigned char* decoded = stbi_load_from_memory(static_cast<const stbi_uc*>(data), static_cast<int>(size), &width, &height, &channels, 0);
+    if (decoded == nullptr)
+        return Fail(error);
+
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+    ExpandToRgba(decoded, static_cast<uint32_t>(channels), static_cast<size_t>(image.width) * image.height, image.pixels.data());
+    stbi_image_free(decoded);
+    return true;
+}
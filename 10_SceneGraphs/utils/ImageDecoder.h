@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Decoding images into memory, with no GPU involved, so it can run on a loader thread. Every
+/// image comes out as 8 bit RGBA rows with no padding, whatever the file held, which is the
+/// layout of a DXGI_FORMAT_R8G8B8A8_UNORM texture. The pixels are written into whatever the image
+/// already holds, so a buffer taken from an ImagePool is decoded into without allocating.
+
+struct DecodedImage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;    // width * height RGBA texels, top row first
+
+    uint32_t GetPitch() const { return width * 4; }
+    bool IsEmpty() const { return pixels.empty(); }
+};
+
+bool ReadImageSize(const void* data, size_t size, uint32_t& width, uint32_t& height, std::string& error);
+
+bool DecodeImageFile(const std::string& path, DecodedImage& image, std::string& error);
+bool DecodeImageMemory(const void* data, size_t size, DecodedImage& image, std::string& error);
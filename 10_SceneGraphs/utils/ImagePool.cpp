@@ -0,0 +1,117 @@
+#include "ImagePool.h"
+
+#include <algorithm>
+#include <chrono>
+
+ImagePool::ImagePool(size_t budgetBytes)
+{
+    m_stats.budgetBytes = budgetBytes;
+}
+
+/// @brief Count bytes as in use, first waiting until they fit in the budget. If they never could,
+/// waits until nothing else is reserved instead.
+void ImagePool::Reserve(size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto fits = [this, bytes]() { return m_stats.reservedBytes == 0 || m_stats.reservedBytes + bytes <= m_stats.budgetBytes; };
+    if (!fits())
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        m_returned.wait(lock, fits);
+        m_stats.waits++;
+        m_stats.waitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    m_stats.reservedBytes += bytes;
+    m_stats.peakReservedBytes = std::max(m_stats.peakReservedBytes, m_stats.reservedBytes);
+
+    // The kept buffers make room for whatever the reservation has to allocate
+    EvictUntil(m_stats.budgetBytes > m_stats.reservedBytes ? m_stats.budgetBytes - m_stats.reservedBytes : 0);
+}
+
+/// @brief Give back bytes that Reserve counted, waking any loads waiting for them. Unreserve
+/// before giving the buffers back, so they can be kept.
+void ImagePool::Unreserve(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.reservedBytes -= std::min(bytes, m_stats.reservedBytes);
+    }
+    m_returned.notify_all();
+}
+
+/// @brief An empty buffer with room for at least bytes: a kept one that is no more than a quarter
+/// bigger, so a small image doesn't tie up a big buffer, or a new one. Reserve the bytes first.
+std::vector<uint8_t> ImagePool::Take(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.takes++;
+
+        auto best = m_free.end();
+        for (auto it = m_free.begin(); it != m_free.end(); ++it)
+        {
+            size_t capacity = it->capacity();
+            if (capacity >= bytes && capacity <= bytes + bytes / 4 && (best == m_free.end() || capacity < best->capacity()))
+                best = it;
+        }
+
+        if (best != m_free.end())
+        {
+            std::vector<uint8_t> buffer = std::move(*best);
+            m_free.erase(best);
+            m_stats.freeBytes -= buffer.capacity();
+            m_stats.reuses++;
+            buffer.clear();
+            return buffer;
+        }
+    }
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(bytes);
+    return buffer;
+}
+
+/// @brief Keep a buffer for a later image, if it fits in the budget alongside what is reserved
+void ImagePool::Give(std::vector<uint8_t>&& buffer)
+{
+    std::vector<uint8_t> dropped;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t capacity = buffer.capacity();
+    if (capacity == 0)
+        return;
+
+    if (m_stats.reservedBytes + m_stats.freeBytes + capacity > m_stats.budgetBytes)
+    {
+        dropped = std::move(buffer);
+        return;
+    }
+
+    m_free.push_back(std::move(buffer));
+    m_stats.freeBytes += capacity;
+}
+
+/// @brief Free every kept buffer, such as once a level has finished loading
+void ImagePool::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    EvictUntil(0);
+}
+
+ImagePoolStats ImagePool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+/// @brief Free kept buffers, oldest first, until at most freeBytes are kept. Call with the lock held.
+void ImagePool::EvictUntil(size_t freeBytes)
+{
+    size_t evicted = 0;
+    while (evicted < m_free.size() && m_stats.freeBytes > freeBytes)
+    {
+        m_stats.freeBytes -= m_free[evicted].capacity();
+        evicted++;
+    }
+    m_free.erase(m_free.begin(), m_free.begin() + evicted);
+}
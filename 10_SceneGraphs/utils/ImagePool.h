@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/// @brief Counters from an ImagePool
+struct ImagePoolStats
+{
+    size_t budgetBytes = 0;
+    size_t reservedBytes = 0;       // held by images being decoded or waiting to be uploaded
+    size_t peakReservedBytes = 0;
+    size_t freeBytes = 0;           // in buffers kept for the next image
+    uint64_t takes = 0;             // buffers handed out
+    uint64_t reuses = 0;            // of those, ones that were kept from an earlier image
+    uint64_t waits = 0;             // reservations that had to wait for memory to come back
+    double waitMilliseconds = 0.0;  // spent waiting, over every thread
+};
+
+/// @brief Staging memory for decoded images, shared by the loader threads, with a cap on how much
+/// of it there is at once.
+///
+/// A load reserves the bytes of everything it will decode before it starts, waiting if that would
+/// go over the budget, so however many images are queued only a budget's worth are ever decoded
+/// and waiting to be uploaded. It then takes a buffer for each image, one kept from an earlier
+/// image if one is big enough, and gives them back with the reservation once they are uploaded.
+/// Reserved and kept bytes together stay within the budget; the only exception is an image bigger
+/// than the whole budget, which is let through on its own.
+///
+/// Reserve blocks, so reserve only on threads whose loads the main thread goes on uploading while
+/// they wait, such as an AsyncLoader's; never on the thread that runs the uploads.
+class ImagePool
+{
+public:
+    explicit ImagePool(size_t budgetBytes);
+
+    ImagePool(const ImagePool&) = delete;
+    ImagePool& operator=(const ImagePool&) = delete;
+
+    void Reserve(size_t bytes);
+    void Unreserve(size_t bytes);
+
+    std::vector<uint8_t> Take(size_t bytes);
+    void Give(std::vector<uint8_t>&& buffer);
+
+    void Trim();
+    ImagePoolStats GetStats() const;
+
+private:
+    void EvictUntil(size_t freeBytes);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_returned;     // a reservation was given back
+    std::vector<std::vector<uint8_t>> m_free;
+    ImagePoolStats m_stats;
+};
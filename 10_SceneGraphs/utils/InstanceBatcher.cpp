@@ -0,0 +1,59 @@
+#include "InstanceBatcher.h"
+
+#include <chrono>
+
+/// @brief Split a sorted list of packets into batches
+/// @param packets The packets, sorted by key
+/// @param canInstance Whether the state of a packet can be drawn instanced. Only asked once per run
+/// of packets long enough to be worth it.
+/// @param sameDraw Whether two packets with the same state in their keys really draw the same
+/// geometry with the same shader and material. Packets are only batched with the first of their
+/// run when it says so; nullptr trusts the keys.
+void InstanceBatcher::Build(const std::vector<DrawPacket>& packets, const std::function<bool(const DrawPacket&)>& canInstance,
+    const std::function<bool(const DrawPacket&, const DrawPacket&)>& sameDraw)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    m_batches.clear();
+    m_instanceCount = 0;
+    m_stats = InstanceBatcherStats();
+    m_stats.packetCount = packets.size();
+
+    uint32_t packetCount = static_cast<uint32_t>(packets.size());
+    uint32_t first = 0;
+    while (first < packetCount)
+    {
+        uint32_t end = first + 1;
+        while (end < packetCount && SameState(packets[first].key, packets[end].key) && (!sameDraw || sameDraw(packets[first], packets[end])))
+        {
+            end++;
+        }
+
+        InstanceBatch batch;
+        batch.firstPacket = first;
+        batch.packetCount = end - first;
+        batch.instanced = batch.packetCount >= m_minInstances && canInstance(packets[first]);
+
+        if (batch.instanced)
+        {
+            batch.firstInstance = m_instanceCount;
+            m_instanceCount += batch.packetCount;
+
+            m_stats.instancedBatches++;
+            m_stats.instances += batch.packetCount;
+            m_stats.drawCalls++;
+        }
+        else
+        {
+            m_stats.drawCalls += batch.packetCount;
+        }
+
+        m_batches.push_back(batch);
+        first = end;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    m_stats.batchCount = m_batches.size();
+    m_stats.buildMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "RenderQueue.h"
+
+/// @brief A run of packets in a sorted render queue that share their shader, material and geometry
+struct InstanceBatch
+{
+    uint32_t firstPacket = 0;
+    uint32_t packetCount = 0;
+    uint32_t firstInstance = 0; // where the run's per-instance data starts; only set for instanced batches
+    bool instanced = false;     // one instanced draw for the whole run, rather than a draw per packet
+};
+
+/// @brief Counters for the last frame's batches
+struct InstanceBatcherStats
+{
+    size_t packetCount = 0;
+    size_t batchCount = 0;
+    size_t instancedBatches = 0;
+    size_t instances = 0;       // packets drawn as part of an instanced batch
+    size_t drawCalls = 0;       // draws left after batching
+    double buildMilliseconds = 0.0;
+};
+
+/// @brief Groups the packets of a sorted render queue into instanced draws.
+///
+/// Sorting puts every packet with the same shader, material and geometry next to each other, so a
+/// batch is a run of packets whose keys only differ in the depth bits. Equal keys don't prove equal
+/// state, though: ids that outgrow their field in the key wrap around. So the caller can also say
+/// whether two packets really draw the same thing, and a run is cut wherever they don't. Runs of at least
+/// GetMinInstances packets become one instanced draw, as long as the caller says the state can be
+/// instanced; anything else is drawn a packet at a time. Instanced batches get consecutive ranges of
+/// instances, in packet order, so the caller can write all the per-instance data in a single pass.
+///
+/// Like the render queue, the batcher only sees keys and items, and doesn't touch the GPU.
+class InstanceBatcher
+{
+public:
+    static constexpr uint32_t DefaultMinInstances = 2;
+
+    InstanceBatcher() = default;
+
+    void SetMinInstances(uint32_t minInstances) { m_minInstances = minInstances < 2 ? 2 : minInstances; }
+    uint32_t GetMinInstances() const { return m_minInstances; }
+
+    void Build(const std::vector<DrawPacket>& packets, const std::function<bool(const DrawPacket&)>& canInstance,
+        const std::function<bool(const DrawPacket&, const DrawPacket&)>& sameDraw = nullptr);
+
+    const std::vector<InstanceBatch>& GetBatches() const { return m_batches; }
+    uint32_t GetInstanceCount() const { return m_instanceCount; }
+    const InstanceBatcherStats& GetStats() const { return m_stats; }
+
+    /// @brief Could two sort keys need the same shader, material and geometry? They do unless the ids
+    /// of either wrapped around in the key.
+    static bool SameState(uint64_t a, uint64_t b) { return (a >> RenderQueue::GeometryShift) == (b >> RenderQueue::GeometryShift); }
+
+private:
+    std::vector<InstanceBatch> m_batches;
+    uint32_t m_instanceCount = 0;
+    uint32_t m_minInstances = DefaultMinInstances;
+
+    InstanceBatcherStats m_stats;
+};
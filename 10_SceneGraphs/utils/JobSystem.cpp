@@ -0,0 +1,141 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned workerCount)
+{
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned index = 0; index < workerCount; index++)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (unsigned index = 1; index < workerCount; index++)
+    {
+        m_threads.emplace_back(&JobSystem::WorkerLoop, this, index);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+/// @brief Split [0, count) into chunks of at most grainSize elements and run `function` on every
+/// chunk across the workers. Returns once every chunk has completed.
+/// @param count Number of elements
+/// @param grainSize Maximum number of elements handed to a single job
+/// @param function Called with the [begin, end) range of each chunk
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max(1u, grainSize);
+
+    // Not worth waking anybody up for
+    if (count <= grainSize || m_queues.size() == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+    std::atomic<uint32_t> remaining = chunkCount;
+
+    // Deal the chunks out round-robin, so every worker starts with a share of its own
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        uint32_t begin = chunk * grainSize;
+        uint32_t end = std::min(count, begin + grainSize);
+        Push(chunk % m_queues.size(), [&function, &remaining, begin, end]()
+            {
+                function(begin, end);
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wake.notify_all();
+
+    // Help out until every chunk of this call is done
+    Job job;
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        if (PopOrSteal(0, job))
+            job();
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::Push(unsigned queueIndex, Job job)
+{
+    auto& queue = *m_queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+    m_queuedJobs.fetch_add(1, std::memory_order_release);
+}
+
+/// @brief Take the newest job from our own deque, or failing that the oldest job from somebody else's
+bool JobSystem::PopOrSteal(unsigned queueIndex, Job& job)
+{
+    {
+        auto& own = *m_queues[queueIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    const unsigned queueCount = static_cast<unsigned>(m_queues.size());
+    for (unsigned offset = 1; offset < queueCount; offset++)
+    {
+        auto& victim = *m_queues[(queueIndex + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::WorkerLoop(unsigned queueIndex)
+{
+    Job job;
+    while (true)
+    {
+        if (PopOrSteal(queueIndex, job))
+        {
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait(lock, [this]() { return m_quit || m_queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (m_quit)
+            return;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief A small work-stealing job system.
+///
+/// Every worker owns a deque of jobs. A worker takes jobs from the back of its own deque, and when
+/// that runs dry it steals from the front of the other workers' deques. The thread that calls
+/// ParallelFor takes part in the work as worker 0, so a JobSystem with a worker count of 1 runs
+/// everything on the calling thread. That queue is the one thread's, so only the thread that owns
+/// the JobSystem calls ParallelFor; other threads, such as an AsyncLoader's, do their work themselves.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+    using RangeFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+    /// @param workerCount Number of threads doing work, including the calling thread. 0 picks one per hardware thread.
+    explicit JobSystem(unsigned workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunction& function);
+
+    unsigned GetWorkerCount() const { return static_cast<unsigned>(m_queues.size()); }
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void Push(unsigned queueIndex, Job job);
+    bool PopOrSteal(unsigned queueIndex, Job& job);
+    void WorkerLoop(unsigned queueIndex);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues; // Index 0 belongs to the thread calling ParallelFor
+    std::vector<std::thread> m_threads;
+
+    std::atomic<uint32_t> m_queuedJobs = 0;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_quit = false;
+};
@@ -0,0 +1,45 @@
+#include "LodSelection.h"
+
+#include <cmath>
+
+/// @brief Work out LodView::projectionScale for a perspective projection
+/// @param verticalFov The vertical field of view, in radians
+/// @param viewportHeight Height of the viewport, in pixels
+float ComputeProjectionScale(float verticalFov, float viewportHeight)
+{
+    return viewportHeight / (2.0f * std::tan(verticalFov * 0.5f));
+}
+
+/// @brief How many pixels an error of worldError could cover on a mesh with the given bounding
+/// sphere. Inside the sphere that is unbounded, which comes back as infinity.
+float ProjectLodError(const LodView& view, const float center[3], float radius, float worldError)
+{
+    float dx = center[0] - view.eye[0];
+    float dy = center[1] - view.eye[1];
+    float dz = center[2] - view.eye[2];
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - radius;
+    if (!(distance > 0.0f))
+        return worldError > 0.0f ? INFINITY : 0.0f;
+    return worldError * view.projectionScale / distance;
+}
+
+/// @brief Pick the coarsest level of detail whose error stays under the view's pixel budget
+/// @param center The world space centre of the bounding sphere
+/// @param radius The world space radius of the bounding sphere
+/// @param worldScale The largest scale from the mesh's own units into the world
+/// @param lodErrors The error of each level in the mesh's own units, finest first, not decreasing
+/// @return The level to draw; 0 when there is only one or the view has no projection
+uint32_t SelectLod(const LodView& view, const float center[3], float radius, float worldScale, const float* lodErrors, uint32_t lodCount)
+{
+    if (lodCount <= 1 || !(view.projectionScale > 0.0f))
+        return 0;
+
+    uint32_t lod = 0;
+    for (uint32_t level = 1; level < lodCount; level++)
+    {
+        if (ProjectLodError(view, center, radius, lodErrors[level] * worldScale) > view.maxPixelError)
+            break;
+        lod = level;
+    }
+    return lod;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+/// Picking a level of detail from how big its error would look on screen.
+///
+/// A level's error is a distance in the mesh's own units (see MeshSimplifier). Scaled into the
+/// world and divided by how far away the mesh is, that becomes an angle, and the projection turns
+/// the angle into pixels. The coarsest level whose error stays under a pixel budget is drawn.
+/// The distance is measured to the nearest point of the bounding sphere, so a level never looks
+/// worse from any part of the mesh than it does from its closest point.
+
+constexpr uint32_t c_maxLodLevels = 4;          // including the full mesh
+constexpr float c_defaultMaxPixelError = 1.0f;
+
+/// @brief What LOD selection needs to know about the camera
+struct LodView
+{
+    float eye[3] = { 0.0f, 0.0f, 0.0f };
+    float projectionScale = 0.0f;               // pixels per unit at distance 1: viewport height / (2 tan(fov / 2))
+    float maxPixelError = c_defaultMaxPixelError;
+};
+
+float ComputeProjectionScale(float verticalFov, float viewportHeight);
+
+float ProjectLodError(const LodView& view, const float center[3], float radius, float worldError);
+
+uint32_t SelectLod(const LodView& view, const float center[3], float radius, float worldScale, const float* lodErrors, uint32_t lodCount);
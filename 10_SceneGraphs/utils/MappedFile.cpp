@@ -0,0 +1,99 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+/// @brief Map a file. Empty files can't be mapped, so they fail to open like missing ones.
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_file = file;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+    m_mapping = mapping;
+
+    m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_data == nullptr)
+    {
+        Close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    m_file = open(path.c_str(), O_RDONLY);
+    if (m_file < 0)
+        return false;
+
+    struct stat status = {};
+    if (fstat(m_file, &status) != 0 || status.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    m_data = data;
+    m_size = static_cast<size_t>(status.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    if (m_file != nullptr)
+        CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data != nullptr)
+        munmap(const_cast<void*>(m_data), m_size);
+    if (m_file >= 0)
+        close(m_file);
+    m_file = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// @brief A read only view of a whole file, mapped into memory. Pages are only read from disk when
+/// they are first touched, and can be shared with anything else that maps the same file.
+///
+/// Works with both the Win32 and POSIX mapping calls so the tools can use it too.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+    const void* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+#ifdef _WIN32
+    void* m_file = nullptr;     // HANDLEs, kept as void* so this header doesn't pull in windows.h
+    void* m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+    const void* m_data = nullptr;
+    size_t m_size = 0;
+};
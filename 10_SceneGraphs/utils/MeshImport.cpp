@@ -0,0 +1,110 @@
+#include "MeshImport.h"
+
+#include <assimp/Importer.hpp>      // C++ importer interface
+#include <assimp/scene.h>           // Output data structure
+#include <assimp/postprocess.h>     // Post processing flags
+
+#include <type_traits>
+
+namespace
+{
+    void CollectMaterials(const aiScene* scene, ImportedMesh& mesh)
+    {
+        for (unsigned int materialIndex = 0; materialIndex < scene->mNumMaterials; materialIndex++)
+        {
+            auto material = scene->mMaterials[materialIndex];
+
+            ImportedMaterial imported;
+            aiColor3D diffuse(1.0f, 1.0f, 1.0f);
+            material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+            imported.diffuse[0] = diffuse.r;
+            imported.diffuse[1] = diffuse.g;
+            imported.diffuse[2] = diffuse.b;
+
+            aiString texturePath;
+            if (material->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == aiReturn_SUCCESS)
+                imported.diffuseTexture = texturePath.C_Str();
+
+            mesh.materials.push_back(imported);
+        }
+    }
+
+    // Merging reads assimp's vectors as arrays of floats
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "aiVector3D has to be three packed floats");
+
+    /// @brief Merge all the meshes in the scene into one vertex and index buffer and prepare it
+    template <typename TVertex>
+    void ConvertScene(const aiScene* scene, LargeMeshMode mode, ImportedMesh& mesh, JobSystem* jobs)
+    {
+        constexpr bool textured = std::is_same_v<TVertex, VertexNormalUV>;
+
+        std::vector<SourceMeshView<aiFace>> sourceMeshes;
+        for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++)
+        {
+            auto sourceMesh = scene->mMeshes[meshIndex];
+            if (sourceMesh->mNormals == nullptr)
+                mesh.warnings.push_back("Mesh " + std::to_string(meshIndex) + " has no normals; using +Y");
+            if (textured && !sourceMesh->HasTextureCoords(0))
+                mesh.warnings.push_back("Mesh " + std::to_string(meshIndex) + " has no texture coordinates; using 0, 0");
+
+            SourceMeshView<aiFace> view;
+            view.positions = reinterpret_cast<const float*>(sourceMesh->mVertices);
+            view.normals = reinterpret_cast<const float*>(sourceMesh->mNormals);
+            view.texCoords = sourceMesh->HasTextureCoords(0) ? reinterpret_cast<const float*>(sourceMesh->mTextureCoords[0]) : nullptr;
+            view.vertexCount = sourceMesh->mNumVertices;
+            view.faces = sourceMesh->mFaces;
+            view.faceCount = sourceMesh->mNumFaces;
+            view.materialIndex = sourceMesh->mMaterialIndex;
+            sourceMeshes.push_back(view);
+        }
+
+        std::vector<TVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+        auto layout = MergeSourceMeshes(sourceMeshes, vertices, indices, triangleMaterials, jobs);
+
+        if (layout.skippedFaces > 0)
+            mesh.warnings.push_back("Skipped " + std::to_string(layout.skippedFaces) + " faces that aren't triangles");
+
+        PrepareImportedMesh(vertices, indices, triangleMaterials, mode, mesh);
+    }
+}
+
+/// @brief Import a source mesh with assimp and prepare its renderable
+/// @param format The vertex format the mesh will be drawn with
+/// @param mode What to do with parts too big for 16 bit indices
+/// @param error Set to the reason when the import fails
+/// @param jobs Merges the scene's meshes in parallel if given; see MergeSourceMeshes
+bool ImportMesh(const std::string& path, MeshImportFormat format, LargeMeshMode mode, ImportedMesh& mesh, std::string& error, JobSystem* jobs)
+{
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path,
+        aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_SortByPType);
+
+    if (scene == nullptr)
+    {
+        error = importer.GetErrorString();
+        return false;
+    }
+
+    if (!scene->HasMeshes())
+    {
+        error = "the scene has no meshes";
+        return false;
+    }
+
+    CollectMaterials(scene, mesh);
+    if (format == MeshImportFormat::NormalUV)
+        ConvertScene<VertexNormalUV>(scene, mode, mesh, jobs);
+    else
+        ConvertScene<VertexNormal>(scene, mode, mesh, jobs);
+
+    if (mesh.renderable.submeshes.empty())
+    {
+        error = "the scene has no triangles";
+        return false;
+    }
+    return true;
+}
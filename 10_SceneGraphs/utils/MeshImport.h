@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Culling.h"
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+#include "RenderableData.h"
+
+/// Importing source meshes with assimp, all the way to a renderable prepared on the CPU: the scene
+/// is merged into one vertex and index buffer, split by material into submeshes, optimized, given
+/// levels of detail and packed back into one vertex and index buffer. Nothing here touches the GPU
+/// or logs, so it runs on loader threads; what happened is left in the ImportedMesh for the caller
+/// to report. Merging the scene's meshes is done in two passes: the first counts where every mesh
+/// goes, so the buffers are sized once, and the second fills them, in parallel given a JobSystem.
+
+enum class MeshImportFormat
+{
+    Normal,     // positions and normals, drawn with PackedVertexNormal
+    NormalUV    // positions, normals and texture coordinates, drawn with PackedVertexNormalUV
+};
+
+struct ImportedMaterial
+{
+    float diffuse[3] = { 1.0f, 1.0f, 1.0f };
+    std::string diffuseTexture;     // path as stored in the source asset; empty if none
+};
+
+/// @brief One material's worth of an imported mesh
+struct ImportedPart
+{
+    uint32_t materialIndex = 0;
+    size_t vertexCount = 0;
+    size_t submeshCount = 0;        // more than one if the part was split for 16 bit indices
+    MeshOptimizationReport optimization;
+};
+
+struct ImportedMesh
+{
+    RenderableData renderable;      // a submesh or more per part, drawn from one vertex and index buffer
+    std::vector<ImportedMaterial> materials;
+    std::vector<ImportedPart> parts;
+    std::vector<std::string> warnings;
+    Bounds bounds;
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+};
+
+/// @brief One mesh of a source scene as plain arrays, which is all merging reads of it
+template <typename TFace>
+struct SourceMeshView
+{
+    const float* positions = nullptr;   // xyz of each vertex
+    const float* normals = nullptr;     // xyz of each vertex; null if the mesh has none
+    const float* texCoords = nullptr;   // uvw of each vertex, as assimp keeps them; null if the mesh has none
+    uint32_t vertexCount = 0;
+    const TFace* faces = nullptr;       // with mNumIndices and mIndices, like an aiFace
+    uint32_t faceCount = 0;
+    uint32_t materialIndex = 0;
+};
+
+/// @brief A run of one mesh's vertices or faces, filled by one job
+struct MergeChunk
+{
+    uint32_t mesh = 0;
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    size_t first = 0;       // where the run's first vertex, or first triangle, goes in the merged buffers
+};
+
+/// @brief Where everything in a scene goes in the merged buffers, counted before anything is written
+struct MergedSceneLayout
+{
+    std::vector<size_t> firstVertex;        // of each mesh; its indices are offset by this
+    std::vector<MergeChunk> vertexChunks;
+    std::vector<MergeChunk> faceChunks;
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    size_t skippedFaces = 0;                // faces that aren't triangles
+};
+
+constexpr uint32_t c_mergeChunkSize = 16384;    // vertices or faces a job fills
+
+bool ImportMesh(const std::string& path, MeshImportFormat format, LargeMeshMode mode, ImportedMesh& mesh, std::string& error, JobSystem* jobs = nullptr);
+
+/// @brief Run a function over [0, count), across the job system if there is one
+template <typename TFunction>
+void ForEachChunk(JobSystem* jobs, size_t count, const TFunction& function)
+{
+    if (jobs == nullptr)
+    {
+        function(0u, static_cast<uint32_t>(count));
+        return;
+    }
+    jobs->ParallelFor(static_cast<uint32_t>(count), 1, function);
+}
+
+/// @brief The first pass of merging a scene: give each mesh its first vertex, cut its vertices and
+/// faces into chunks, and count the triangles in each chunk of faces to find where they go
+template <typename TFace>
+MergedSceneLayout LayOutSourceMeshes(const std::vector<SourceMeshView<TFace>>& meshes, JobSystem* jobs = nullptr)
+{
+    MergedSceneLayout layout;
+    for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        layout.firstVertex.push_back(layout.vertexCount);
+        for (uint32_t begin = 0; begin < meshes[mesh].vertexCount; begin += c_mergeChunkSize)
+        {
+            layout.vertexChunks.push_back(MergeChunk{ mesh, begin, std::min(meshes[mesh].vertexCount, begin + c_mergeChunkSize), layout.vertexCount + begin });
+        }
+        for (uint32_t begin = 0; begin < meshes[mesh].faceCount; begin += c_mergeChunkSize)
+        {
+            layout.faceChunks.push_back(MergeChunk{ mesh, begin, std::min(meshes[mesh].faceCount, begin + c_mergeChunkSize), 0 });
+        }
+        layout.vertexCount += meshes[mesh].vertexCount;
+    }
+
+    // Count each chunk's triangles into its first, then turn the counts into offsets
+    ForEachChunk(jobs, layout.faceChunks.size(), [&meshes, &layout](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t index = begin; index < end; index++)
+            {
+                auto& chunk = layout.faceChunks[index];
+                const auto* faces = meshes[chunk.mesh].faces;
+                chunk.first = std::count_if(faces + chunk.begin, faces + chunk.end, [](const TFace& face) { return face.mNumIndices == 3; });
+            }
+        });
+
+    size_t faceCount = 0;
+    for (auto& chunk : layout.faceChunks)
+    {
+        size_t triangles = chunk.first;
+        chunk.first = layout.triangleCount;
+        layout.triangleCount += triangles;
+        faceCount += chunk.end - chunk.begin;
+    }
+    layout.skippedFaces = faceCount - layout.triangleCount;
+    return layout;
+}
+
+/// @brief Merge the meshes of a scene into one vertex and index buffer, with the material of each
+/// triangle. The buffers are sized from the layout, once, and every chunk writes its own part of
+/// them, so the chunks can be filled in any order or all at once. A mesh without normals gets +Y,
+/// and one without texture coordinates gets 0, 0.
+/// @param jobs Fills the chunks in parallel if given. Only from the thread that owns it, as it
+/// takes part in the work as worker 0; loader threads merge on their own.
+/// @return The layout the buffers were filled with
+template <typename TVertex, typename TFace>
+MergedSceneLayout MergeSourceMeshes(const std::vector<SourceMeshView<TFace>>& meshes, std::vector<TVertex>& vertices, std::vector<uint32_t>& indices,
+    std::vector<uint32_t>& triangleMaterials, JobSystem* jobs = nullptr)
+{
+    constexpr bool textured = std::is_same_v<TVertex, VertexNormalUV>;
+
+    auto layout = LayOutSourceMeshes(meshes, jobs);
+    vertices.resize(layout.vertexCount);
+    indices.resize(layout.triangleCount * 3);
+    triangleMaterials.resize(layout.triangleCount);
+
+    ForEachChunk(jobs, layout.vertexChunks.size(), [&meshes, &layout, &vertices](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t index = begin; index < end; index++)
+            {
+                const auto& chunk = layout.vertexChunks[index];
+                const auto& mesh = meshes[chunk.mesh];
+                TVertex* out = vertices.data() + chunk.first;
+                for (uint32_t vertex = chunk.begin; vertex < chunk.end; vertex++, out++)
+                {
+                    const float* position = mesh.positions + static_cast<size_t>(vertex) * 3;
+                    const float up[3] = { 0.0f, 1.0f, 0.0f };
+                    const float* normal = mesh.normals != nullptr ? mesh.normals + static_cast<size_t>(vertex) * 3 : up;
+                    if constexpr (textured)
+                    {
+                        const float* uv = mesh.texCoords != nullptr ? mesh.texCoords + static_cast<size_t>(vertex) * 3 : nullptr;
+                        *out = VertexNormalUV{ position[0], position[1], position[2], normal[0], normal[1], normal[2], uv != nullptr ? uv[0] : 0.0f, uv != nullptr ? uv[1] : 0.0f };
+                    }
+                    else
+                    {
+                        *out = VertexNormal{ position[0], position[1], position[2], normal[0], normal[1], normal[2] };
+                    }
+                }
+            }
+        });
+
+    // Every mesh's indices start at its own first vertex
+    ForEachChunk(jobs, layout.faceChunks.size(), [&meshes, &layout, &indices, &triangleMaterials](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t index = begin; index < end; index++)
+            {
+                const auto& chunk = layout.faceChunks[index];
+                const auto& mesh = meshes[chunk.mesh];
+                auto baseVertex = static_cast<uint32_t>(layout.firstVertex[chunk.mesh]);
+                size_t triangle = chunk.first;
+                for (uint32_t faceIndex = chunk.begin; faceIndex < chunk.end; faceIndex++)
+                {
+                    const auto& face = mesh.faces[faceIndex];
+                    if (face.mNumIndices != 3)
+                        continue;
+
+                    indices[triangle * 3] = baseVertex + face.mIndices[0];
+                    indices[triangle * 3 + 1] = baseVertex + face.mIndices[1];
+                    indices[triangle * 3 + 2] = baseVertex + face.mIndices[2];
+                    triangleMaterials[triangle] = mesh.materialIndex;
+                    triangle++;
+                }
+            }
+        });
+
+    return layout;
+}
+
+/// @brief Turn a mesh merged into one vertex and index buffer into a renderable: submeshes per
+/// material, each optimized for the vertex cache, overdraw and vertex fetch before it is packed.
+/// The materials have to be filled in already; a triangle whose material isn't among them is white.
+/// All the submeshes are quantized on the grid of the whole mesh, so the parts still meet.
+/// @param triangleMaterials The material of each triangle
+template <typename TVertex>
+void PrepareImportedMesh(const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangleMaterials, LargeMeshMode mode, ImportedMesh& mesh)
+{
+    mesh.bounds = ComputeBounds(vertices.data(), vertices.size(), sizeof(TVertex));
+    mesh.vertexCount = vertices.size();
+    mesh.triangleCount = indices.size() / 3;
+
+    RenderableBuilder builder;
+    builder.SetSharedQuantization(ComputePositionQuantization(vertices.data(), vertices.size(), sizeof(TVertex)));
+    for (auto& part : SplitByMaterial(indices, vertices.size(), triangleMaterials))
+    {
+        auto partVertices = GatherVertices(part.vertices, vertices);
+
+        ImportedPart imported;
+        imported.materialIndex = part.materialIndex;
+        imported.optimization = OptimizeMesh(partVertices, part.indices);
+        imported.vertexCount = partVertices.size();
+
+        uint32_t firstSubmesh = builder.GetSubmeshCount();
+        builder.AddSubmeshes(partVertices, part.indices, part.materialIndex, mode);
+        imported.submeshCount = builder.GetSubmeshCount() - firstSubmesh;
+        mesh.parts.push_back(imported);
+    }
+
+    std::vector<MaterialData> materials(mesh.materials.size());
+    for (size_t materialIndex = 0; materialIndex < mesh.materials.size(); materialIndex++)
+    {
+        std::copy(mesh.materials[materialIndex].diffuse, mesh.materials[materialIndex].diffuse + 3, materials[materialIndex].diffuse);
+    }
+    mesh.renderable = builder.Finish(std::move(materials));
+}
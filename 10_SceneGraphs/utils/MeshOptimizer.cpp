@@ -0,0 +1,478 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t c_notCached = UINT32_MAX;
+
+    // Vertex scoring from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation". The scores
+    // assume an LRU cache of c_scoringCacheSize entries, which also works well for the smaller
+    // FIFO caches real hardware has.
+    constexpr uint32_t c_scoringCacheSize = 32;
+    constexpr float c_cacheDecayPower = 1.5f;
+    constexpr float c_lastTriangleScore = 0.75f;
+    constexpr float c_valenceBoostScale = 2.0f;
+    constexpr float c_valenceBoostPower = 0.5f;
+
+    /// @brief How much we want to use a vertex next, from where it is in the cache (or -1 if it
+    /// isn't) and how many triangles still need it
+    float ComputeVertexScore(int cachePosition, uint32_t remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // The vertices of the last triangle get a fixed score, so the next triangle doesn't
+                // favour just one of its edges
+                score = c_lastTriangleScore;
+            }
+            else
+            {
+                const float scale = 1.0f / (c_scoringCacheSize - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scale, c_cacheDecayPower);
+            }
+        }
+
+        // Vertices with few triangles left get a boost, so they are finished off rather than
+        // being left behind as isolated triangles
+        score += c_valenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -c_valenceBoostPower);
+        return score;
+    }
+
+    /// @brief Scores for every cache position and the common valences, worked out once; the pow
+    /// calls would otherwise dominate the optimizer's run time
+    class VertexScoreTable
+    {
+    public:
+        static constexpr uint32_t MaxValence = 32;
+
+        VertexScoreTable()
+        {
+            for (uint32_t valence = 0; valence < MaxValence; valence++)
+            {
+                for (int position = -1; position < static_cast<int>(c_scoringCacheSize); position++)
+                {
+                    m_scores[valence][position + 1] = ComputeVertexScore(position, valence);
+                }
+            }
+        }
+
+        float operator()(int cachePosition, uint32_t remainingTriangles) const
+        {
+            if (remainingTriangles >= MaxValence)
+                return ComputeVertexScore(cachePosition, remainingTriangles);
+            return m_scores[remainingTriangles][cachePosition + 1];
+        }
+
+    private:
+        float m_scores[MaxValence][c_scoringCacheSize + 1];
+    };
+
+    struct Float3
+    {
+        float x;
+        float y;
+        float z;
+    };
+
+    Float3 LoadPosition(const uint8_t* vertices, size_t stride, uint32_t vertex)
+    {
+        Float3 position;
+        std::memcpy(&position, vertices + vertex * stride, sizeof(position));
+        return position;
+    }
+
+    Float3 Subtract(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Float3 Cross(const Float3& a, const Float3& b) { return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    /// @brief A run of triangles drawn together when ordering for overdraw
+    struct Cluster
+    {
+        size_t firstTriangle;
+        size_t triangleCount;
+        float sortKey;
+    };
+}
+
+/// @brief Run a triangle list through a software post-transform vertex cache
+/// @param indices The triangles, in draw order
+/// @param vertexCount How many vertices the indices can refer to
+/// @param cacheSize Entries in the cache
+/// @param policy How entries are replaced
+VertexCacheStats SimulateVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, VertexCachePolicy policy)
+{
+    VertexCacheStats stats;
+    stats.triangleCount = indexCount / 3;
+    if (stats.triangleCount == 0 || cacheSize == 0)
+        return stats;
+
+    std::vector<uint8_t> referenced(vertexCount, 0);
+
+    // FIFO: a vertex is still cached if fewer than cacheSize misses have happened since it was
+    // loaded, its own load not counted. LRU: keep the cache itself, most recently used first; it
+    // is small, so searching it is cheap.
+    std::vector<size_t> loadedAt(vertexCount, SIZE_MAX);
+    std::vector<uint32_t> lru;
+    lru.reserve(cacheSize + 1);
+
+    for (size_t index = 0; index < stats.triangleCount * 3; index++)
+    {
+        uint32_t vertex = indices[index];
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = 1;
+            stats.vertexCount++;
+        }
+
+        if (policy == VertexCachePolicy::Fifo)
+        {
+            if (loadedAt[vertex] == SIZE_MAX || stats.transforms - loadedAt[vertex] > cacheSize)
+            {
+                loadedAt[vertex] = stats.transforms;
+                stats.transforms++;
+            }
+        }
+        else
+        {
+            auto found = std::find(lru.begin(), lru.end(), vertex);
+            if (found == lru.end())
+            {
+                stats.transforms++;
+                lru.insert(lru.begin(), vertex);
+                if (lru.size() > cacheSize)
+                    lru.pop_back();
+            }
+            else
+            {
+                std::rotate(lru.begin(), found, found + 1);
+            }
+        }
+    }
+
+    stats.acmr = static_cast<float>(stats.transforms) / stats.triangleCount;
+    stats.atvr = static_cast<float>(stats.transforms) / stats.vertexCount;
+    return stats;
+}
+
+/// @brief Reorder triangles so vertices are reused while they are still in the post-transform
+/// cache (Forsyth's algorithm). Greedily draws the best scoring triangle next, only rescoring the
+/// triangles around the vertices whose score changed, so it runs in roughly linear time.
+/// @param indices The triangles, reordered in place
+/// @param vertexCount How many vertices the indices can refer to
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles using each vertex. The first remainingTriangles[vertex] entries of a vertex's list
+    // are the ones not drawn yet.
+    std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for (size_t index = 0; index < triangleCount * 3; index++)
+    {
+        remainingTriangles[indices[index]]++;
+    }
+
+    std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        adjacencyStart[vertex + 1] = adjacencyStart[vertex] + remainingTriangles[vertex];
+    }
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        for (int corner = 0; corner < 3; corner++)
+        {
+            adjacency[fill[indices[triangle * 3 + corner]]++] = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    static const VertexScoreTable scoreTable;
+
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        vertexScore[vertex] = scoreTable(-1, remainingTriangles[vertex]);
+    }
+
+    std::vector<uint8_t> drawn(triangleCount, 0);
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(c_scoringCacheSize + 3);
+    newCache.reserve(c_scoringCacheSize + 3);
+
+    size_t nextUndrawn = 0;
+    size_t best = SIZE_MAX;
+    for (size_t drawnCount = 0; drawnCount < triangleCount; drawnCount++)
+    {
+        if (best == SIZE_MAX)
+        {
+            // Nothing in the cache leads anywhere; carry on from the first triangle not yet drawn
+            while (drawn[nextUndrawn])
+                nextUndrawn++;
+            best = nextUndrawn;
+        }
+
+        drawn[best] = 1;
+        const uint32_t* corners = &indices[best * 3];
+        output.insert(output.end(), corners, corners + 3);
+
+        // Take the triangle off its vertices' lists of triangles still to draw
+        for (int corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = corners[corner];
+            uint32_t* triangles = &adjacency[adjacencyStart[vertex]];
+            uint32_t& remaining = remainingTriangles[vertex];
+            auto found = std::find(triangles, triangles + remaining, static_cast<uint32_t>(best));
+            std::swap(*found, triangles[remaining - 1]);
+            remaining--;
+        }
+
+        // The triangle's vertices go to the front of the cache, pushing the rest back. The ones
+        // pushed past the end are scored as uncached, then dropped.
+        newCache.clear();
+        newCache.insert(newCache.end(), corners, corners + 3);
+        for (auto vertex : cache)
+        {
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                newCache.push_back(vertex);
+        }
+
+        for (size_t position = 0; position < newCache.size(); position++)
+        {
+            int cachePosition = position < c_scoringCacheSize ? static_cast<int>(position) : -1;
+            vertexScore[newCache[position]] = scoreTable(cachePosition, remainingTriangles[newCache[position]]);
+        }
+
+        // Only triangles around vertices whose score changed can have a new score, and the best
+        // one to draw next is almost always among them, so only they are scored
+        best = SIZE_MAX;
+        float bestScore = -1.0f;
+        for (auto vertex : newCache)
+        {
+            const uint32_t* triangles = &adjacency[adjacencyStart[vertex]];
+            for (uint32_t index = 0; index < remainingTriangles[vertex]; index++)
+            {
+                uint32_t triangle = triangles[index];
+                const uint32_t* triangleCorners = &indices[triangle * 3];
+                float score = vertexScore[triangleCorners[0]] + vertexScore[triangleCorners[1]] + vertexScore[triangleCorners[2]];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = triangle;
+                }
+            }
+        }
+
+        if (newCache.size() > c_scoringCacheSize)
+            newCache.resize(c_scoringCacheSize);
+        std::swap(cache, newCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+/// @brief Reorder cache optimized triangles to cut down on overdraw, in the spirit of Tipsify
+/// (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+///
+/// The triangles are split into clusters wherever the vertex cache starts from scratch, so moving
+/// whole clusters around costs little cache efficiency. Clusters facing away from the middle of
+/// the mesh are then drawn first: from most viewpoints they are in front of the rest, so the
+/// triangles behind them fail the depth test instead of being shaded and overwritten.
+/// @param indices The triangles, already optimized for the vertex cache, reordered in place
+/// @param vertices The vertices, with the position as three floats at the start of each
+/// @param threshold How much worse the FIFO ACMR is allowed to get, e.g. 1.05 for 5%. If the new
+/// order is worse than that, the original is kept.
+/// @return Was the order changed?
+bool OptimizeOverdraw(uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return false;
+
+    const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+
+    // A cluster starts on every triangle where all three vertices miss the cache
+    std::vector<Cluster> clusters;
+    std::vector<size_t> loadedAt(vertexCount, SIZE_MAX);
+    size_t transforms = 0;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        int misses = 0;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            if (loadedAt[vertex] == SIZE_MAX || transforms - loadedAt[vertex] > c_fifoVertexCacheSize)
+            {
+                loadedAt[vertex] = transforms;
+                transforms++;
+                misses++;
+            }
+        }
+
+        if (misses == 3 || clusters.empty())
+            clusters.push_back(Cluster{ triangle, 0, 0.0f });
+        clusters.back().triangleCount++;
+    }
+
+    if (clusters.size() < 2)
+        return false;
+
+    // Area weighted centre of the whole mesh
+    Float3 meshCenter = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    std::vector<Float3> centers(triangleCount);
+    std::vector<Float3> normals(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        Float3 a = LoadPosition(vertexBytes, stride, indices[triangle * 3 + 0]);
+        Float3 b = LoadPosition(vertexBytes, stride, indices[triangle * 3 + 1]);
+        Float3 c = LoadPosition(vertexBytes, stride, indices[triangle * 3 + 2]);
+
+        // The cross product's length is twice the area, which is all a weight needs
+        normals[triangle] = Cross(Subtract(b, a), Subtract(c, a));
+        centers[triangle] = Float3{ (a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f };
+
+        float area = std::sqrt(Dot(normals[triangle], normals[triangle]));
+        meshCenter = Float3{ meshCenter.x + centers[triangle].x * area, meshCenter.y + centers[triangle].y * area, meshCenter.z + centers[triangle].z * area };
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCenter = Float3{ meshCenter.x / meshArea, meshCenter.y / meshArea, meshCenter.z / meshArea };
+
+    for (auto& cluster : clusters)
+    {
+        Float3 center = { 0.0f, 0.0f, 0.0f };
+        Float3 normal = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (size_t triangle = cluster.firstTriangle; triangle < cluster.firstTriangle + cluster.triangleCount; triangle++)
+        {
+            float triangleArea = std::sqrt(Dot(normals[triangle], normals[triangle]));
+            center = Float3{ center.x + centers[triangle].x * triangleArea, center.y + centers[triangle].y * triangleArea, center.z + centers[triangle].z * triangleArea };
+            normal = Float3{ normal.x + normals[triangle].x, normal.y + normals[triangle].y, normal.z + normals[triangle].z };
+            area += triangleArea;
+        }
+
+        if (area > 0.0f)
+            center = Float3{ center.x / area, center.y / area, center.z / area };
+        float length = std::sqrt(Dot(normal, normal));
+        if (length > 0.0f)
+            normal = Float3{ normal.x / length, normal.y / length, normal.z / length };
+
+        cluster.sortKey = Dot(Subtract(center, meshCenter), normal);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(triangleCount * 3);
+    for (const auto& cluster : clusters)
+    {
+        reordered.insert(reordered.end(), indices + cluster.firstTriangle * 3, indices + (cluster.firstTriangle + cluster.triangleCount) * 3);
+    }
+
+    auto before = SimulateVertexCache(indices, triangleCount * 3, vertexCount, c_fifoVertexCacheSize, VertexCachePolicy::Fifo);
+    auto after = SimulateVertexCache(reordered.data(), reordered.size(), vertexCount, c_fifoVertexCacheSize, VertexCachePolicy::Fifo);
+    if (after.acmr > before.acmr * threshold)
+        return false;
+
+    std::copy(reordered.begin(), reordered.end(), indices);
+    return true;
+}
+
+/// @brief Reorder vertices into the order the triangles first use them, so fetching them walks
+/// through memory instead of jumping around it. Vertices no triangle uses are dropped.
+/// @param indices The triangles, remapped in place to the new vertex order
+/// @param vertices The vertices, reordered in place
+/// @param stride Size of a vertex, in bytes
+/// @return How many vertices are left
+size_t OptimizeVertexFetch(uint32_t* indices, size_t indexCount, void* vertices, size_t vertexCount, size_t stride)
+{
+    std::vector<uint32_t> remap(vertexCount, c_notCached);
+    uint32_t nextVertex = 0;
+    for (size_t index = 0; index < indexCount; index++)
+    {
+        uint32_t& newIndex = remap[indices[index]];
+        if (newIndex == c_notCached)
+            newIndex = nextVertex++;
+        indices[index] = newIndex;
+    }
+
+    uint8_t* vertexBytes = static_cast<uint8_t*>(vertices);
+    std::vector<uint8_t> original(vertexBytes, vertexBytes + vertexCount * stride);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        if (remap[vertex] != c_notCached)
+            std::memcpy(vertexBytes + remap[vertex] * stride, original.data() + vertex * stride, stride);
+    }
+
+    return nextVertex;
+}
+
+/// @brief Run the vertex cache, overdraw and vertex fetch passes over a mesh, measuring it before
+/// and after
+/// @param vertices The vertices, with the position as three floats at the start of each
+/// @param vertexCount How many vertices there are; set to how many are left
+/// @param stride Size of a vertex, in bytes
+/// @param indices The triangles of every range
+/// @param ranges Parts of the index buffer to reorder separately, such as submeshes; triangles
+/// never move from one range to another
+/// @return The report; nothing is changed if an index refers past the end of the vertices
+MeshOptimizationReport OptimizeMesh(void* vertices, size_t& vertexCount, size_t stride, std::vector<uint32_t>& indices, const std::vector<IndexRange>& ranges)
+{
+    // Allow the cache to get 5% worse for the sake of overdraw
+    constexpr float c_overdrawThreshold = 1.05f;
+
+    MeshOptimizationReport report;
+    report.verticesBefore = vertexCount;
+    report.verticesAfter = vertexCount;
+
+    // Every pass keeps per-vertex state, so a bad index would have them write out of bounds
+    for (auto index : indices)
+    {
+        if (index >= vertexCount)
+            return report;
+    }
+    report.optimized = true;
+
+    report.fifoBefore = SimulateVertexCache(indices.data(), indices.size(), vertexCount, c_fifoVertexCacheSize, VertexCachePolicy::Fifo);
+    report.lruBefore = SimulateVertexCache(indices.data(), indices.size(), vertexCount, c_lruVertexCacheSize, VertexCachePolicy::Lru);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (const auto& range : ranges)
+    {
+        if (static_cast<size_t>(range.firstIndex) + range.indexCount > indices.size())
+            continue;
+
+        uint32_t* rangeIndices = indices.data() + range.firstIndex;
+        OptimizeVertexCache(rangeIndices, range.indexCount, vertexCount);
+        if (OptimizeOverdraw(rangeIndices, range.indexCount, vertices, vertexCount, stride, c_overdrawThreshold))
+            report.overdrawReordered = true;
+    }
+
+    // Vertex order is shared by every range, so it is done once the triangle order is settled
+    vertexCount = OptimizeVertexFetch(indices.data(), indices.size(), vertices, vertexCount, stride);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    report.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    report.verticesAfter = vertexCount;
+    report.fifoAfter = SimulateVertexCache(indices.data(), indices.size(), vertexCount, c_fifoVertexCacheSize, VertexCachePolicy::Fifo);
+    report.lruAfter = SimulateVertexCache(indices.data(), indices.size(), vertexCount, c_lruVertexCacheSize, VertexCachePolicy::Lru);
+    return report;
+}
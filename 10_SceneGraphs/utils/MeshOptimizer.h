@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Index and vertex reordering for imported meshes: triangles are ordered for the post-transform
+/// vertex cache and then for overdraw, and vertices for fetch locality. None of it changes what
+/// is drawn, only the order it is drawn in. A software vertex cache measures the result, so the
+/// gain can be checked without a GPU.
+///
+/// Vertices are treated as opaque blocks of `stride` bytes, except for the overdraw pass which
+/// expects the position as three floats at the start of each vertex, as every vertex format in
+/// this project has.
+
+enum class VertexCachePolicy
+{
+    Fifo,   // a vertex stays cached for a fixed number of misses, whether it's reused or not
+    Lru     // a reused vertex moves back to the front of the cache
+};
+
+constexpr uint32_t c_fifoVertexCacheSize = 16;
+constexpr uint32_t c_lruVertexCacheSize = 32;
+
+/// @brief How well a triangle order uses a vertex cache
+struct VertexCacheStats
+{
+    size_t triangleCount = 0;
+    size_t vertexCount = 0;     // distinct vertices referenced
+    size_t transforms = 0;      // cache misses, each one a run of the vertex shader
+    float acmr = 0.0f;          // average cache miss ratio: transforms per triangle, from 3 down to about 0.5
+    float atvr = 0.0f;          // average transform to vertex ratio: transforms per vertex, 1 is ideal
+};
+
+/// @brief A range of an index buffer that is optimized on its own, such as a submesh
+struct IndexRange
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+/// @brief Before and after numbers for a mesh run through OptimizeMesh
+struct MeshOptimizationReport
+{
+    VertexCacheStats fifoBefore;
+    VertexCacheStats fifoAfter;
+    VertexCacheStats lruBefore;
+    VertexCacheStats lruAfter;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;   // unreferenced vertices are dropped
+    bool optimized = false;     // false if the mesh was left alone because an index was out of range
+    bool overdrawReordered = false;
+    double milliseconds = 0.0;
+};
+
+VertexCacheStats SimulateVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, VertexCachePolicy policy);
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+bool OptimizeOverdraw(uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, float threshold);
+size_t OptimizeVertexFetch(uint32_t* indices, size_t indexCount, void* vertices, size_t vertexCount, size_t stride);
+
+MeshOptimizationReport OptimizeMesh(void* vertices, size_t& vertexCount, size_t stride, std::vector<uint32_t>& indices, const std::vector<IndexRange>& ranges);
+
+/// @brief Run all the passes over a whole mesh held in vectors, shrinking the vertices if some
+/// weren't referenced
+template <typename TVertex>
+MeshOptimizationReport OptimizeMesh(std::vector<TVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    size_t vertexCount = vertices.size();
+    std::vector<IndexRange> ranges = { IndexRange{ 0, static_cast<uint32_t>(indices.size()) } };
+    auto report = OptimizeMesh(vertices.data(), vertexCount, sizeof(TVertex), indices, ranges);
+    vertices.resize(vertexCount);
+    return report;
+}
@@ -0,0 +1,418 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+
+namespace
+{
+    // A level that doesn't drop at least this fraction of the triangles of the one before isn't
+    // worth its memory, so the chain ends there
+    constexpr float c_minLodReduction = 0.15f;
+
+    // A collapse is refused if it turns any triangle around by more than this much: the cosine of
+    // the angle between the old and new normals has to stay above it
+    constexpr double c_minFlipCosine = 0.25;
+
+    /// @brief The sum of squared distances to a set of planes, each weighted by the area of the
+    /// triangle it came from, as the symmetric matrix and vector of Garland and Heckbert's paper
+    struct Quadric
+    {
+        double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+        double b2 = 0.0, bc = 0.0, bd = 0.0;
+        double c2 = 0.0, cd = 0.0;
+        double d2 = 0.0;
+        double weight = 0.0;
+
+        void AddPlane(double a, double b, double c, double d, double area)
+        {
+            a2 += area * a * a; ab += area * a * b; ac += area * a * c; ad += area * a * d;
+            b2 += area * b * b; bc += area * b * c; bd += area * b * d;
+            c2 += area * c * c; cd += area * c * d;
+            d2 += area * d * d;
+            weight += area;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+            b2 += other.b2; bc += other.bc; bd += other.bd;
+            c2 += other.c2; cd += other.cd;
+            d2 += other.d2;
+            weight += other.weight;
+            return *this;
+        }
+
+        /// @brief The weighted sum of squared distances from p to the planes
+        double Evaluate(const float p[3]) const
+        {
+            double x = p[0], y = p[1], z = p[2];
+            double result = a2 * x * x + b2 * y * y + c2 * z * z
+                + 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+                + 2.0 * (ad * x + bd * y + cd * z)
+                + d2;
+            return std::max(result, 0.0);
+        }
+    };
+
+    /// @brief The root mean square distance from p to the planes of a quadric; the error a collapse
+    /// onto p is reported with
+    double ComputeError(const Quadric& first, const Quadric& second, const float p[3])
+    {
+        double weight = first.weight + second.weight;
+        if (!(weight > 0.0))
+            return 0.0;
+        return std::sqrt((first.Evaluate(p) + second.Evaluate(p)) / weight);
+    }
+
+    void Cross(const double u[3], const double v[3], double result[3])
+    {
+        result[0] = u[1] * v[2] - u[2] * v[1];
+        result[1] = u[2] * v[0] - u[0] * v[2];
+        result[2] = u[0] * v[1] - u[1] * v[0];
+    }
+
+    /// @brief The normal of a triangle, scaled by twice its area
+    void TriangleNormal(const float* p0, const float* p1, const float* p2, double normal[3])
+    {
+        double u[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+        double v[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+        Cross(u, v, normal);
+    }
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float error;
+    };
+
+    /// @brief The state of a simplification that can be carried on in steps, so each level of
+    /// detail starts where the last one stopped and its error is still measured against the
+    /// planes of the full mesh
+    class Simplifier
+    {
+    public:
+        Simplifier(const void* vertices, size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices);
+
+        float Simplify(size_t targetIndexCount, float maxError);
+        const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+
+    private:
+        const float* Position(uint32_t vertex) const { return &m_positions[vertex * 3]; }
+        void LockBorders();
+        void BuildAdjacency();
+        bool FlipsTriangle(uint32_t from, uint32_t to) const;
+        size_t CollapsePass(size_t trianglesToRemove, double maxError);
+
+        size_t m_vertexCount;
+        std::vector<float> m_positions;
+        std::vector<uint32_t> m_indices;
+        std::vector<Quadric> m_quadrics;
+        std::vector<bool> m_locked;
+        std::vector<uint32_t> m_adjacencyOffsets;      // triangles around vertex v are [offsets[v], offsets[v + 1])
+        std::vector<uint32_t> m_adjacency;
+        double m_error = 0.0;
+    };
+
+    Simplifier::Simplifier(const void* vertices, size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices)
+        : m_vertexCount(vertexCount), m_positions(vertexCount * 3), m_quadrics(vertexCount), m_locked(vertexCount, false)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+        for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            std::memcpy(&m_positions[vertex * 3], bytes + vertex * stride, sizeof(float) * 3);
+        }
+
+        // Triangles using a vertex that isn't there can't be simplified or drawn; drop them
+        size_t triangleCount = indices.size() / 3;
+        m_indices.reserve(triangleCount * 3);
+        for (size_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            const uint32_t* corners = &indices[triangle * 3];
+            if (corners[0] < vertexCount && corners[1] < vertexCount && corners[2] < vertexCount)
+                m_indices.insert(m_indices.end(), corners, corners + 3);
+        }
+
+        for (size_t corner = 0; corner < m_indices.size(); corner += 3)
+        {
+            const uint32_t* corners = &m_indices[corner];
+            double normal[3];
+            TriangleNormal(Position(corners[0]), Position(corners[1]), Position(corners[2]), normal);
+            double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (!(length > 0.0))
+                continue;
+
+            double a = normal[0] / length;
+            double b = normal[1] / length;
+            double c = normal[2] / length;
+            const float* p = Position(corners[0]);
+            double d = -(a * p[0] + b * p[1] + c * p[2]);
+            for (int vertex = 0; vertex < 3; vertex++)
+            {
+                m_quadrics[corners[vertex]].AddPlane(a, b, c, d, length * 0.5);
+            }
+        }
+
+        LockBorders();
+    }
+
+    /// @brief Lock every vertex that mustn't move: those on an edge that isn't shared by exactly
+    /// two triangles (an open border, or where the mesh isn't a manifold), and those sharing their
+    /// position with another vertex, which are seams in the normals or texture coordinates
+    void Simplifier::LockBorders()
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(m_indices.size());
+        for (size_t corner = 0; corner < m_indices.size(); corner += 3)
+        {
+            for (int edge = 0; edge < 3; edge++)
+            {
+                uint64_t a = m_indices[corner + edge];
+                uint64_t b = m_indices[corner + (edge + 1) % 3];
+                edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        for (size_t first = 0; first < edges.size();)
+        {
+            size_t last = first;
+            while (last < edges.size() && edges[last] == edges[first])
+                last++;
+            if (last - first != 2)
+            {
+                m_locked[edges[first] >> 32] = true;
+                m_locked[edges[first] & 0xffffffff] = true;
+            }
+            first = last;
+        }
+
+        struct PositionHash
+        {
+            size_t operator()(const std::array<uint32_t, 3>& key) const
+            {
+                return (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+            }
+        };
+        std::unordered_map<std::array<uint32_t, 3>, uint32_t, PositionHash> firstAtPosition;
+        firstAtPosition.reserve(m_vertexCount);
+        for (uint32_t vertex = 0; vertex < m_vertexCount; vertex++)
+        {
+            std::array<uint32_t, 3> key;
+            std::memcpy(key.data(), Position(vertex), sizeof(float) * 3);
+            auto inserted = firstAtPosition.emplace(key, vertex);
+            if (!inserted.second)
+            {
+                m_locked[vertex] = true;
+                m_locked[inserted.first->second] = true;
+            }
+        }
+    }
+
+    void Simplifier::BuildAdjacency()
+    {
+        m_adjacencyOffsets.assign(m_vertexCount + 1, 0);
+        for (auto index : m_indices)
+        {
+            m_adjacencyOffsets[index + 1]++;
+        }
+        for (size_t vertex = 0; vertex < m_vertexCount; vertex++)
+        {
+            m_adjacencyOffsets[vertex + 1] += m_adjacencyOffsets[vertex];
+        }
+
+        m_adjacency.resize(m_indices.size());
+        std::vector<uint32_t> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+        for (size_t corner = 0; corner < m_indices.size(); corner++)
+        {
+            m_adjacency[fill[m_indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+        }
+    }
+
+    /// @brief Would moving `from` onto `to` turn over any of the triangles that stay?
+    bool Simplifier::FlipsTriangle(uint32_t from, uint32_t to) const
+    {
+        for (uint32_t slot = m_adjacencyOffsets[from]; slot < m_adjacencyOffsets[from + 1]; slot++)
+        {
+            const uint32_t* corners = &m_indices[m_adjacency[slot] * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+                continue;
+
+            const float* before[3];
+            const float* after[3];
+            for (int corner = 0; corner < 3; corner++)
+            {
+                before[corner] = Position(corners[corner]);
+                after[corner] = corners[corner] == from ? Position(to) : before[corner];
+            }
+
+            double oldNormal[3];
+            double newNormal[3];
+            TriangleNormal(before[0], before[1], before[2], oldNormal);
+            TriangleNormal(after[0], after[1], after[2], newNormal);
+            double dot = oldNormal[0] * newNormal[0] + oldNormal[1] * newNormal[1] + oldNormal[2] * newNormal[2];
+            double lengths = std::sqrt((oldNormal[0] * oldNormal[0] + oldNormal[1] * oldNormal[1] + oldNormal[2] * oldNormal[2])
+                * (newNormal[0] * newNormal[0] + newNormal[1] * newNormal[1] + newNormal[2] * newNormal[2]));
+            if (!(dot > c_minFlipCosine * lengths))
+                return true;
+        }
+        return false;
+    }
+
+    /// @brief Make as many independent collapses as the budget allows, cheapest first. Collapses
+    /// within a pass don't touch each other's triangles, so each one can be checked against
+    /// positions that won't change until the pass is over.
+    /// @return How many triangles were removed
+    size_t Simplifier::CollapsePass(size_t trianglesToRemove, double maxError)
+    {
+        BuildAdjacency();
+
+        // The cheaper direction of each edge. An interior edge turns up once from each side, so only
+        // the side where it runs from the lower index is used; every other edge is locked.
+        std::vector<Collapse> candidates;
+        candidates.reserve(m_indices.size() / 2);
+        for (size_t corner = 0; corner < m_indices.size(); corner += 3)
+        {
+            for (int edge = 0; edge < 3; edge++)
+            {
+                uint32_t a = m_indices[corner + edge];
+                uint32_t b = m_indices[corner + (edge + 1) % 3];
+                if (a >= b || (m_locked[a] && m_locked[b]))
+                    continue;
+
+                // Only an unlocked vertex moves; when both could, the one that moves the surface least does
+                double moveA = m_locked[a] ? INFINITY : ComputeError(m_quadrics[a], m_quadrics[b], Position(b));
+                double moveB = m_locked[b] ? INFINITY : ComputeError(m_quadrics[a], m_quadrics[b], Position(a));
+                if (moveA <= moveB)
+                    candidates.push_back(Collapse{ a, b, static_cast<float>(moveA) });
+                else
+                    candidates.push_back(Collapse{ b, a, static_cast<float>(moveB) });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        std::vector<uint32_t> remap(m_vertexCount);
+        for (uint32_t vertex = 0; vertex < m_vertexCount; vertex++)
+        {
+            remap[vertex] = vertex;
+        }
+        std::vector<bool> taken(m_vertexCount, false);
+
+        size_t removed = 0;
+        for (const auto& candidate : candidates)
+        {
+            if (removed >= trianglesToRemove || candidate.error > maxError)
+                break;
+            if (taken[candidate.from] || taken[candidate.to] || FlipsTriangle(candidate.from, candidate.to))
+                continue;
+
+            remap[candidate.from] = candidate.to;
+            m_quadrics[candidate.to] += m_quadrics[candidate.from];
+            m_error = std::max(m_error, static_cast<double>(candidate.error));
+
+            // Everything around the collapse is left alone for the rest of the pass
+            for (uint32_t slot = m_adjacencyOffsets[candidate.from]; slot < m_adjacencyOffsets[candidate.from + 1]; slot++)
+            {
+                const uint32_t* corners = &m_indices[m_adjacency[slot] * 3];
+                if (corners[0] == candidate.to || corners[1] == candidate.to || corners[2] == candidate.to)
+                    removed++;
+                taken[corners[0]] = true;
+                taken[corners[1]] = true;
+                taken[corners[2]] = true;
+            }
+        }
+
+        // Apply the pass, dropping the triangles that collapsed to lines
+        size_t write = 0;
+        for (size_t corner = 0; corner < m_indices.size(); corner += 3)
+        {
+            uint32_t a = remap[m_indices[corner]];
+            uint32_t b = remap[m_indices[corner + 1]];
+            uint32_t c = remap[m_indices[corner + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            m_indices[write++] = a;
+            m_indices[write++] = b;
+            m_indices[write++] = c;
+        }
+        size_t dropped = (m_indices.size() - write) / 3;
+        m_indices.resize(write);
+        return dropped;
+    }
+
+    /// @brief Simplify until there are no more than targetIndexCount indices, no collapse is left
+    /// under maxError, or nothing more can be collapsed
+    /// @return The largest error of any collapse so far, including earlier calls
+    float Simplifier::Simplify(size_t targetIndexCount, float maxError)
+    {
+        while (m_indices.size() > targetIndexCount)
+        {
+            size_t trianglesToRemove = (m_indices.size() - targetIndexCount + 2) / 3;
+            if (CollapsePass(trianglesToRemove, maxError) == 0)
+                break;
+        }
+        return static_cast<float>(m_error);
+    }
+}
+
+/// @brief Reduce a mesh to about targetIndexCount indices by collapsing edges. The result uses the
+/// same vertices, so it can share the original's vertex buffer.
+/// @param vertices The first three floats of each vertex are its position
+/// @param stride Size of a vertex, in bytes
+/// @param maxError Stop before any collapse that moves the surface further than this
+/// @param resultError If not null, set to the largest error of the collapses made
+std::vector<uint32_t> SimplifyMesh(const void* vertices, size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float maxError, float* resultError)
+{
+    Simplifier simplifier(vertices, vertexCount, stride, indices);
+    float error = simplifier.Simplify(targetIndexCount, maxError);
+    if (resultError != nullptr)
+        *resultError = error;
+    return simplifier.GetIndices();
+}
+
+/// @brief Build up to maxLevels levels of detail for a mesh, each with about half the triangles of
+/// the one before. Level 0 is the mesh as given. The chain ends early once the mesh gets small or
+/// a level barely shrinks, which happens when most of what is left is locked border or seam.
+/// Each level is reordered for the vertex cache on its own.
+LodChain BuildLodChain(const void* vertices, size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices, uint32_t maxLevels)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    LodChain chain;
+    chain.indices = indices;
+    chain.levels.push_back(LodLevel{ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+    Simplifier simplifier(vertices, vertexCount, stride, indices);
+    size_t previousCount = indices.size();
+    for (uint32_t level = 1; level < maxLevels; level++)
+    {
+        size_t targetTriangles = static_cast<size_t>(previousCount / 3 * c_lodTriangleRatio);
+        if (targetTriangles < c_minLodTriangles)
+            break;
+
+        float error = simplifier.Simplify(targetTriangles * 3, INFINITY);
+        const auto& simplified = simplifier.GetIndices();
+        if (simplified.size() > previousCount * (1.0f - c_minLodReduction))
+            break;
+
+        LodLevel lod;
+        lod.firstIndex = static_cast<uint32_t>(chain.indices.size());
+        lod.indexCount = static_cast<uint32_t>(simplified.size());
+        lod.error = error;
+        chain.indices.insert(chain.indices.end(), simplified.begin(), simplified.end());
+        OptimizeVertexCache(chain.indices.data() + lod.firstIndex, lod.indexCount, vertexCount);
+        chain.levels.push_back(lod);
+        previousCount = simplified.size();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    chain.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    return chain;
+}
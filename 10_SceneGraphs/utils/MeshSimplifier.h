@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LodSelection.h"
+
+/// Mesh simplification with quadric error metrics, and chains of levels of detail built with it.
+///
+/// Simplification collapses edges by moving one end onto the other, so a simplified mesh only
+/// ever uses vertices the full mesh already has. That keeps every level of detail on the same
+/// vertex buffer: a level is just another range of indices. Each vertex keeps a quadric, the sum
+/// of the squared distances to the planes of the triangles around it, and the edges whose
+/// collapse moves the surface least go first.
+///
+/// Vertices on an open border, and vertices that share their position with another vertex (a seam
+/// in the normals or texture coordinates), never move. Borders stay put, so meshes that were split
+/// into parts or clusters and simplified separately still meet without cracks.
+///
+/// As with MeshOptimizer, vertices are opaque blocks of `stride` bytes that start with the
+/// position as three floats.
+
+constexpr float c_lodTriangleRatio = 0.5f;      // each level aims for this fraction of the triangles of the one before
+constexpr size_t c_minLodTriangles = 32;        // levels aren't made any smaller than this
+
+/// @brief A level of detail: a range of the chain's indices and how far it strays from the full mesh
+struct LodLevel
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;         // in the mesh's own units; 0 for the full mesh
+};
+
+/// @brief The index buffer for every level of detail of a mesh, one after the other, finest first
+struct LodChain
+{
+    std::vector<uint32_t> indices;
+    std::vector<LodLevel> levels;
+    double milliseconds = 0.0;
+};
+
+std::vector<uint32_t> SimplifyMesh(const void* vertices, size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float maxError, float* resultError = nullptr);
+
+LodChain BuildLodChain(const void* vertices, size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices,
+    uint32_t maxLevels = c_maxLodLevels);
+
+/// @brief Build the levels of detail of a mesh held in a vector
+template <typename TVertex>
+LodChain BuildLodChain(const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t maxLevels = c_maxLodLevels)
+{
+    return BuildLodChain(vertices.data(), vertices.size(), sizeof(TVertex), indices, maxLevels);
+}
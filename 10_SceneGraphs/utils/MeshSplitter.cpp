@@ -0,0 +1,143 @@
+#include "MeshSplitter.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t c_notInCluster = UINT32_MAX;
+}
+
+/// @brief Copy 32 bit indices into a 16 bit index buffer. Only valid when every index fits.
+std::vector<uint16_t> NarrowIndices(const std::vector<uint32_t>& indices)
+{
+    std::vector<uint16_t> narrowed;
+    narrowed.reserve(indices.size());
+    for (auto index : indices)
+    {
+        narrowed.push_back(static_cast<uint16_t>(index));
+    }
+    return narrowed;
+}
+
+/// @brief Split a triangle list into clusters that each use at most maxClusterVertices vertices.
+///
+/// Triangles are taken in order and added to the current cluster until the next one would need
+/// more vertices than it has room for, at which point a new cluster is started. Keeping the order
+/// means triangles that share vertices tend to land in the same cluster, so only the vertices
+/// along the seams between clusters get copied. A trailing partial triangle, and any triangle
+/// using a vertex past vertexCount, is dropped.
+/// @param indices The mesh's triangles
+/// @param vertexCount How many vertices the mesh has
+/// @param maxClusterVertices The most vertices a cluster can have, at least 3
+std::vector<MeshCluster> SplitMesh(const std::vector<uint32_t>& indices, size_t vertexCount, size_t maxClusterVertices)
+{
+    std::vector<MeshCluster> clusters;
+    if (maxClusterVertices < 3 || maxClusterVertices > c_maxShortIndexVertices)
+        return clusters;
+
+    // Where each source vertex is in the current cluster. Rather than clearing this whenever a new
+    // cluster starts, each entry remembers which cluster it was written for.
+    std::vector<uint32_t> localIndex(vertexCount, c_notInCluster);
+    std::vector<uint32_t> owner(vertexCount, c_notInCluster);
+
+    size_t triangleCount = indices.size() / 3;
+    clusters.emplace_back();
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        const uint32_t* corners = &indices[triangle * 3];
+        if (corners[0] >= vertexCount || corners[1] >= vertexCount || corners[2] >= vertexCount)
+            continue;
+
+        uint32_t clusterIndex = static_cast<uint32_t>(clusters.size() - 1);
+        size_t newVertices = 0;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            if (owner[corners[corner]] != clusterIndex)
+                newVertices++;
+        }
+        // A triangle that repeats a new vertex is counted twice here, which only ever ends a
+        // cluster slightly early.
+        if (clusters.back().vertices.size() + newVertices > maxClusterVertices)
+        {
+            clusters.emplace_back();
+            clusterIndex++;
+        }
+
+        MeshCluster& cluster = clusters.back();
+        for (int corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = corners[corner];
+            if (owner[vertex] != clusterIndex)
+            {
+                owner[vertex] = clusterIndex;
+                localIndex[vertex] = static_cast<uint32_t>(cluster.vertices.size());
+                cluster.vertices.push_back(vertex);
+            }
+            cluster.indices.push_back(static_cast<uint16_t>(localIndex[vertex]));
+        }
+    }
+
+    if (clusters.back().indices.empty())
+        clusters.pop_back();
+
+    return clusters;
+}
+
+/// @brief Separate a mesh's triangles by material, so each material can be drawn with its own
+/// constants rather than having its colour repeated in every vertex. Parts come out in the order
+/// their materials are first used. Triangles using a vertex past vertexCount are dropped.
+/// @param indices The mesh's triangles
+/// @param vertexCount How many vertices the mesh has
+/// @param triangleMaterials The material of each triangle
+std::vector<MeshPart> SplitByMaterial(const std::vector<uint32_t>& indices, size_t vertexCount, const std::vector<uint32_t>& triangleMaterials)
+{
+    std::vector<MeshPart> parts;
+    std::vector<std::vector<uint32_t>> partTriangles;
+    std::vector<uint32_t> partForMaterial;
+
+    size_t triangleCount = std::min(indices.size() / 3, triangleMaterials.size());
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        const uint32_t* corners = &indices[triangle * 3];
+        if (corners[0] >= vertexCount || corners[1] >= vertexCount || corners[2] >= vertexCount)
+            continue;
+
+        uint32_t material = triangleMaterials[triangle];
+        if (material >= partForMaterial.size())
+            partForMaterial.resize(material + 1, c_notInCluster);
+        if (partForMaterial[material] == c_notInCluster)
+        {
+            partForMaterial[material] = static_cast<uint32_t>(parts.size());
+            parts.emplace_back();
+            parts.back().materialIndex = material;
+            partTriangles.emplace_back();
+        }
+        partTriangles[partForMaterial[material]].push_back(static_cast<uint32_t>(triangle));
+    }
+
+    // Fill the parts one at a time, so a vertex shared by two materials is copied once into each.
+    // As in SplitMesh, each entry remembers which part it was written for.
+    std::vector<uint32_t> localIndex(vertexCount, c_notInCluster);
+    std::vector<uint32_t> owner(vertexCount, c_notInCluster);
+    for (uint32_t partIndex = 0; partIndex < parts.size(); partIndex++)
+    {
+        MeshPart& part = parts[partIndex];
+        part.indices.reserve(partTriangles[partIndex].size() * 3);
+        for (auto triangle : partTriangles[partIndex])
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                if (owner[vertex] != partIndex)
+                {
+                    owner[vertex] = partIndex;
+                    localIndex[vertex] = static_cast<uint32_t>(part.vertices.size());
+                    part.vertices.push_back(vertex);
+                }
+                part.indices.push_back(localIndex[vertex]);
+            }
+        }
+    }
+
+    return parts;
+}
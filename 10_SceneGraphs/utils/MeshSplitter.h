@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief The most vertices a 16 bit index buffer can reach. The strip cut value (0xffff) only
+/// matters for strips, so a triangle list can use all of them.
+constexpr size_t c_maxShortIndexVertices = 65536;
+
+/// @brief Part of a larger mesh that is small enough to draw with 16 bit indices
+struct MeshCluster
+{
+    std::vector<uint32_t> vertices; // for each of the cluster's vertices, its index in the source mesh
+    std::vector<uint16_t> indices;  // triangles, indexing the cluster's vertices
+};
+
+/// @brief The triangles of a mesh that share a material, with just the vertices they use
+struct MeshPart
+{
+    uint32_t materialIndex = 0;
+    std::vector<uint32_t> vertices; // for each of the part's vertices, its index in the source mesh
+    std::vector<uint32_t> indices;  // triangles, indexing the part's vertices
+};
+
+/// @brief Can a mesh with this many vertices be drawn with 16 bit indices?
+inline bool FitsShortIndices(size_t vertexCount) { return vertexCount <= c_maxShortIndexVertices; }
+
+std::vector<uint16_t> NarrowIndices(const std::vector<uint32_t>& indices);
+
+std::vector<MeshCluster> SplitMesh(const std::vector<uint32_t>& indices, size_t vertexCount, size_t maxClusterVertices = c_maxShortIndexVertices);
+std::vector<MeshPart> SplitByMaterial(const std::vector<uint32_t>& indices, size_t vertexCount, const std::vector<uint32_t>& triangleMaterials);
+
+/// @brief Copy some of a mesh's vertices out into a vertex buffer of their own
+/// @param sourceVertices Which vertices to copy, in the order they should end up in
+template <typename TVertex>
+std::vector<TVertex> GatherVertices(const std::vector<uint32_t>& sourceVertices, const std::vector<TVertex>& vertices)
+{
+    std::vector<TVertex> gathered;
+    gathered.reserve(sourceVertices.size());
+    for (auto vertex : sourceVertices)
+    {
+        gathered.push_back(vertices[vertex]);
+    }
+    return gathered;
+}
+
+/// @brief Copy the vertices a cluster uses out of the source mesh's vertex buffer
+template <typename TVertex>
+std::vector<TVertex> GatherClusterVertices(const MeshCluster& cluster, const std::vector<TVertex>& vertices)
+{
+    return GatherVertices(cluster.vertices, vertices);
+}
@@ -0,0 +1,273 @@
+#include "ProceduralGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr float c_pi = 3.14159265358979f;
+
+    struct Vector3
+    {
+        float x;
+        float y;
+        float z;
+    };
+
+    Vector3 operator+(Vector3 a, Vector3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    Vector3 operator*(Vector3 v, float s) { return { v.x * s, v.y * s, v.z * s }; }
+
+    uint32_t ClampSegments(uint32_t segments, uint32_t minimum)
+    {
+        return std::min(std::max(segments, minimum), c_maxPrimitiveSegments);
+    }
+
+    /// @brief Add a flat rectangle split into columns by rows quads. Vertex (row, column) sits at
+    /// origin + right * column / columns + down * row / rows, so the rectangle faces
+    /// cross(right, down), and it is wound clockwise seen from that side.
+    void AppendPatch(PrimitiveMesh& mesh, Vector3 origin, Vector3 right, Vector3 down, Vector3 normal, uint32_t columns, uint32_t rows)
+    {
+        auto first = static_cast<uint32_t>(mesh.vertices.size());
+        for (uint32_t row = 0; row <= rows; row++)
+        {
+            float v = static_cast<float>(row) / rows;
+            for (uint32_t column = 0; column <= columns; column++)
+            {
+                float u = static_cast<float>(column) / columns;
+                Vector3 position = origin + right * u + down * v;
+                mesh.vertices.push_back(VertexNormalUV{ position.x, position.y, position.z, normal.x, normal.y, normal.z, u, v });
+            }
+        }
+
+        const uint32_t stride = columns + 1;
+        for (uint32_t row = 0; row < rows; row++)
+        {
+            for (uint32_t column = 0; column < columns; column++)
+            {
+                uint32_t a = first + row * stride + column;
+                uint32_t b = a + stride;
+                mesh.indices.insert(mesh.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+            }
+        }
+    }
+
+    /// @brief A UV sphere. The first and last column of each stack share positions so the texture
+    /// can wrap, and each pole is a row of vertices at the same point, one per slice, with u in the
+    /// middle of its slice (the last one is left over). The triangles that would be squashed flat
+    /// at the poles are left out.
+    void GenerateSphere(PrimitiveMesh& mesh, float radius, uint32_t slices, uint32_t stacks)
+    {
+        for (uint32_t stack = 0; stack <= stacks; stack++)
+        {
+            float theta = c_pi * stack / stacks;
+            float ringY = std::cos(theta);
+            float ringRadius = std::sin(theta);
+            bool pole = stack == 0 || stack == stacks;
+            if (pole)
+            {
+                ringY = stack == 0 ? 1.0f : -1.0f;
+                ringRadius = 0.0f;
+            }
+
+            for (uint32_t slice = 0; slice <= slices; slice++)
+            {
+                // The last column uses the angle of the first, so the seam closes exactly
+                float phi = 2.0f * c_pi * (slice % slices) / slices;
+                float nx = ringRadius * std::cos(phi);
+                float nz = ringRadius * std::sin(phi);
+                float u = (pole ? slice + 0.5f : static_cast<float>(slice)) / slices;
+                float v = static_cast<float>(stack) / stacks;
+                mesh.vertices.push_back(VertexNormalUV{ nx * radius, ringY * radius, nz * radius, nx, ringY, nz, u, v });
+            }
+        }
+
+        const uint32_t stride = slices + 1;
+        for (uint32_t stack = 0; stack < stacks; stack++)
+        {
+            for (uint32_t slice = 0; slice < slices; slice++)
+            {
+                uint32_t a = stack * stride + slice;
+                uint32_t b = a + stride;
+                if (stack > 0)
+                    mesh.indices.insert(mesh.indices.end(), { a, a + 1, b });
+                // At the north pole a and a + 1 are the same point; a is the one whose u is in this slice
+                if (stack < stacks - 1)
+                    mesh.indices.insert(mesh.indices.end(), { stack == 0 ? a : a + 1, b + 1, b });
+            }
+        }
+    }
+
+    /// @brief Six patches, one per face. Faces don't share vertices, so each keeps a flat normal
+    /// and its own texture coordinates.
+    void GenerateCube(PrimitiveMesh& mesh, float size, uint32_t segments)
+    {
+        struct Face
+        {
+            Vector3 normal;
+            Vector3 right;  // as seen from outside the cube, with down = cross(normal, right)
+        };
+        static const Face faces[] =
+        {
+            { {  1.0f,  0.0f,  0.0f }, {  0.0f,  0.0f,  1.0f } },
+            { { -1.0f,  0.0f,  0.0f }, {  0.0f,  0.0f, -1.0f } },
+            { {  0.0f,  1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f } },
+            { {  0.0f, -1.0f,  0.0f }, {  1.0f,  0.0f,  0.0f } },
+            { {  0.0f,  0.0f,  1.0f }, { -1.0f,  0.0f,  0.0f } },
+            { {  0.0f,  0.0f, -1.0f }, {  1.0f,  0.0f,  0.0f } },
+        };
+
+        float half = size * 0.5f;
+        for (const auto& face : faces)
+        {
+            Vector3 n = face.normal;
+            Vector3 r = face.right;
+            Vector3 down = { n.y * r.z - n.z * r.y, n.z * r.x - n.x * r.z, n.x * r.y - n.y * r.x };
+            Vector3 origin = n * half + r * -half + down * -half;
+            AppendPatch(mesh, origin, r * size, down * size, n, segments, segments);
+        }
+    }
+}
+
+bool PrimitiveDesc::operator==(const PrimitiveDesc& other) const
+{
+    return type == other.type
+        && size[0] == other.size[0] && size[1] == other.size[1]
+        && segments[0] == other.segments[0] && segments[1] == other.segments[1];
+}
+
+size_t PrimitiveDescHash::operator()(const PrimitiveDesc& desc) const
+{
+    uint32_t words[5] = { static_cast<uint32_t>(desc.type), 0, 0, desc.segments[0], desc.segments[1] };
+    std::memcpy(&words[1], desc.size, sizeof(desc.size));
+
+    // FNV-1a over the words
+    uint64_t hash = 14695981039346656037ull;
+    for (auto word : words)
+    {
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+/// @brief Clamp the tessellation into the range the generator supports and clear the fields the
+/// type doesn't use, so two descs that make the same primitive are equal and hash the same
+PrimitiveDesc NormalizePrimitiveDesc(const PrimitiveDesc& desc)
+{
+    PrimitiveDesc normalized = desc;
+    // Adding zero turns -0 into +0, which compare equal but don't hash the same
+    normalized.size[0] = desc.size[0] + 0.0f;
+    normalized.size[1] = desc.size[1] + 0.0f;
+
+    switch (desc.type)
+    {
+    case PrimitiveType::Sphere:
+        normalized.size[1] = 0.0f;
+        normalized.segments[0] = ClampSegments(desc.segments[0], 3);
+        normalized.segments[1] = ClampSegments(desc.segments[1], 2);
+        break;
+    case PrimitiveType::Cube:
+        normalized.size[1] = 0.0f;
+        normalized.segments[0] = ClampSegments(desc.segments[0], 1);
+        normalized.segments[1] = 1;
+        break;
+    case PrimitiveType::Plane:
+    case PrimitiveType::Grid:
+        normalized.segments[0] = ClampSegments(desc.segments[0], 1);
+        normalized.segments[1] = ClampSegments(desc.segments[1], 1);
+        break;
+    }
+    return normalized;
+}
+
+PrimitiveDesc MakeSphereDesc(float radius, uint32_t slices, uint32_t stacks)
+{
+    return NormalizePrimitiveDesc(PrimitiveDesc{ PrimitiveType::Sphere, { radius, 0.0f }, { slices, stacks } });
+}
+
+PrimitiveDesc MakeCubeDesc(float size, uint32_t segments)
+{
+    return NormalizePrimitiveDesc(PrimitiveDesc{ PrimitiveType::Cube, { size, 0.0f }, { segments, 1 } });
+}
+
+PrimitiveDesc MakePlaneDesc(float width, float height, uint32_t columns, uint32_t rows)
+{
+    return NormalizePrimitiveDesc(PrimitiveDesc{ PrimitiveType::Plane, { width, height }, { columns, rows } });
+}
+
+PrimitiveDesc MakeGridDesc(float width, float depth, uint32_t columns, uint32_t rows)
+{
+    return NormalizePrimitiveDesc(PrimitiveDesc{ PrimitiveType::Grid, { width, depth }, { columns, rows } });
+}
+
+/// @brief How many vertices GeneratePrimitive makes for a desc, without making them
+size_t GetPrimitiveVertexCount(const PrimitiveDesc& desc)
+{
+    PrimitiveDesc normalized = NormalizePrimitiveDesc(desc);
+    size_t columns = normalized.segments[0];
+    size_t rows = normalized.segments[1];
+    switch (normalized.type)
+    {
+    case PrimitiveType::Sphere:
+        return (columns + 1) * (rows + 1);
+    case PrimitiveType::Cube:
+        return 6 * (columns + 1) * (columns + 1);
+    case PrimitiveType::Plane:
+    case PrimitiveType::Grid:
+        return (columns + 1) * (rows + 1);
+    }
+    return 0;
+}
+
+/// @brief How many triangles GeneratePrimitive makes for a desc, without making them
+size_t GetPrimitiveTriangleCount(const PrimitiveDesc& desc)
+{
+    PrimitiveDesc normalized = NormalizePrimitiveDesc(desc);
+    size_t columns = normalized.segments[0];
+    size_t rows = normalized.segments[1];
+    switch (normalized.type)
+    {
+    case PrimitiveType::Sphere:
+        return 2 * columns * (rows - 1);
+    case PrimitiveType::Cube:
+        return 12 * columns * columns;
+    case PrimitiveType::Plane:
+    case PrimitiveType::Grid:
+        return 2 * columns * rows;
+    }
+    return 0;
+}
+
+/// @brief Build a primitive's vertices and triangles. The desc is normalized first, so
+/// out of range tessellation is clamped rather than refused.
+PrimitiveMesh GeneratePrimitive(const PrimitiveDesc& desc)
+{
+    PrimitiveDesc normalized = NormalizePrimitiveDesc(desc);
+
+    PrimitiveMesh mesh;
+    mesh.vertices.reserve(GetPrimitiveVertexCount(normalized));
+    mesh.indices.reserve(GetPrimitiveTriangleCount(normalized) * 3);
+
+    float width = normalized.size[0];
+    float height = normalized.size[1];
+    uint32_t columns = normalized.segments[0];
+    uint32_t rows = normalized.segments[1];
+    switch (normalized.type)
+    {
+    case PrimitiveType::Sphere:
+        GenerateSphere(mesh, width, columns, rows);
+        break;
+    case PrimitiveType::Cube:
+        GenerateCube(mesh, width, columns);
+        break;
+    case PrimitiveType::Plane:
+        AppendPatch(mesh, { -0.5f * width, 0.5f * height, 0.0f }, { width, 0.0f, 0.0f }, { 0.0f, -height, 0.0f },
+            { 0.0f, 0.0f, -1.0f }, columns, rows);
+        break;
+    case PrimitiveType::Grid:
+        AppendPatch(mesh, { -0.5f * width, 0.0f, 0.5f * height }, { width, 0.0f, 0.0f }, { 0.0f, 0.0f, -height },
+            { 0.0f, 1.0f, 0.0f }, columns, rows);
+        break;
+    }
+    return mesh;
+}
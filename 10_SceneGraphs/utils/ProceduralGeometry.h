@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VertexCompression.h"
+
+/// Procedural primitives: spheres, cubes, planes and grids built on the CPU as indexed triangle
+/// lists with normals and texture coordinates, at whatever tessellation is asked for.
+///
+/// Triangles are wound clockwise seen from the side their normals point to, which is the front
+/// face with the rasterizer state the renderer uses. Texture coordinates run from 0 to 1 across
+/// each face, with v going down as D3D expects. Every primitive is centred on the origin:
+///   - Sphere: radius size[0], segments[0] slices around Y and segments[1] stacks from pole to pole
+///   - Cube: edges size[0] long, each face split into segments[0] by segments[0] quads
+///   - Plane: size[0] by size[1] in XY facing -Z, split into segments[0] columns and segments[1] rows
+///   - Grid: size[0] by size[1] in XZ facing +Y, split into segments[0] columns and segments[1] rows
+///
+/// Primitives are described by value, so a PrimitiveDesc can key a cache and identical primitives
+/// only have to be built and uploaded once. This header is free of Windows and D3D headers.
+
+constexpr uint32_t c_maxPrimitiveSegments = 2048;
+
+enum class PrimitiveType : uint32_t
+{
+    Sphere,
+    Cube,
+    Plane,
+    Grid
+};
+
+/// @brief Everything that decides the shape of a primitive. Use the Make functions, or pass
+/// hand-filled ones through NormalizePrimitiveDesc, so equal shapes compare equal.
+struct PrimitiveDesc
+{
+    PrimitiveType type = PrimitiveType::Cube;
+    float size[2] = { 1.0f, 1.0f };
+    uint32_t segments[2] = { 1, 1 };
+
+    bool operator==(const PrimitiveDesc& other) const;
+    bool operator!=(const PrimitiveDesc& other) const { return !(*this == other); }
+};
+
+struct PrimitiveDescHash
+{
+    size_t operator()(const PrimitiveDesc& desc) const;
+};
+
+/// @brief The CPU side of a primitive, ready to go through Renderable like a loaded mesh
+struct PrimitiveMesh
+{
+    std::vector<VertexNormalUV> vertices;
+    std::vector<uint32_t> indices;
+};
+
+PrimitiveDesc NormalizePrimitiveDesc(const PrimitiveDesc& desc);
+
+PrimitiveDesc MakeSphereDesc(float radius, uint32_t slices, uint32_t stacks);
+PrimitiveDesc MakeCubeDesc(float size, uint32_t segments = 1);
+PrimitiveDesc MakePlaneDesc(float width, float height, uint32_t columns = 1, uint32_t rows = 1);
+PrimitiveDesc MakeGridDesc(float width, float depth, uint32_t columns, uint32_t rows);
+
+size_t GetPrimitiveVertexCount(const PrimitiveDesc& desc);
+size_t GetPrimitiveTriangleCount(const PrimitiveDesc& desc);
+
+PrimitiveMesh GeneratePrimitive(const PrimitiveDesc& desc);
@@ -0,0 +1,207 @@
+#include "RenderQueue.h"
+
+#include <chrono>
+#include <cstring>
+
+/// @brief Pack the state of a draw into a sort key. Ids that don't fit in their field wrap around,
+/// so with more than 4095 shaders or materials, or 16383 pieces of geometry, in a frame, draws with
+/// different state can get the same key bits; they still sort correctly by depth, but anything
+/// grouping packets by key has to check that they really share their state (see InstanceBatcher).
+/// @param depth Distance from the camera. Negative values (behind the camera) count as 0.
+uint64_t RenderQueue::MakeSortKey(uint32_t shaderId, uint32_t materialId, uint32_t geometryId, float depth)
+{
+    // The bit pattern of a positive float sorts the same way as the float itself, so the depth only
+    // needs its top bits kept. The sign bit is always clear, which leaves room to keep one more bit
+    // of the mantissa.
+    if (!(depth > 0.0f))
+        depth = 0.0f;
+
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+    depthBits >>= 31 - DepthBits;
+
+    return (static_cast<uint64_t>(shaderId & ((1u << ShaderBits) - 1)) << ShaderShift) |
+           (static_cast<uint64_t>(materialId & ((1u << MaterialBits) - 1)) << MaterialShift) |
+           (static_cast<uint64_t>(geometryId & ((1u << GeometryBits) - 1)) << GeometryShift) |
+           (static_cast<uint64_t>(depthBits & ((1u << DepthBits) - 1)) << DepthShift);
+}
+
+/// @brief Start a new frame. Keeps the ids of the objects submitted in the last frame, and releases
+/// the rest.
+void RenderQueue::Clear()
+{
+    m_packets.clear();
+
+    m_frame++;
+    ReleaseUnused(m_shaderIds);
+    ReleaseUnused(m_materialIds);
+    ReleaseUnused(m_geometryIds);
+}
+
+/// @brief Add a draw with a key made by MakeSortKey
+/// @param item Index the caller uses to find the draw again
+void RenderQueue::Submit(uint64_t key, uint32_t item)
+{
+    m_packets.push_back(DrawPacket{ key, item });
+}
+
+/// @brief Add a draw, identifying its state by the objects it uses
+/// @param shader Shader used by the draw
+/// @param material Material used by the draw, or nullptr
+/// @param geometry Vertex buffer (or whatever owns it) used by the draw
+/// @param depth Distance from the camera
+/// @param item Index the caller uses to find the draw again
+/// @param lod Level of detail drawn from the geometry. Different levels get different geometry ids,
+/// so they are never instanced together, but still sort next to each other.
+void RenderQueue::Submit(const void* shader, const void* material, const void* geometry, float depth, uint32_t item, uint32_t lod)
+{
+    uint32_t geometryId = (GetId(m_geometryIds, geometry) << LodBits) | (lod & ((1u << LodBits) - 1));
+    uint64_t key = MakeSortKey(GetId(m_shaderIds, shader), GetId(m_materialIds, material), geometryId, depth);
+    Submit(key, item);
+}
+
+/// @brief Sort the draws by key, and count how many state changes drawing them in this order takes
+void RenderQueue::Sort()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    RadixSort(m_packets, m_scratch);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    CountStateChanges(m_packets, &m_stats);
+    m_stats.sortMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// @brief Stable least significant digit radix sort on the packet keys, a byte at a time. All the
+/// histograms are built in one pass, and bytes that are the same for every key are skipped; in a
+/// scene with a handful of shaders and materials that is most of the top half of the key.
+/// @param packets Packets to sort, sorted on return
+/// @param scratch Scratch space, resized as needed
+void RenderQueue::RadixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+{
+    constexpr int passCount = sizeof(uint64_t);
+
+    const size_t count = packets.size();
+    if (count < 2)
+        return;
+
+    uint32_t histograms[passCount][256] = {};
+    for (const auto& packet : packets)
+    {
+        for (int pass = 0; pass < passCount; pass++)
+        {
+            histograms[pass][(packet.key >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    scratch.resize(count);
+    DrawPacket* source = packets.data();
+    DrawPacket* destination = scratch.data();
+
+    for (int pass = 0; pass < passCount; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        uint32_t firstByte = (source[0].key >> (pass * 8)) & 0xff;
+        if (histogram[firstByte] == count)
+            continue;
+
+        uint32_t offsets[256];
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++)
+        {
+            offsets[bucket] = offset;
+            offset += histogram[bucket];
+        }
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const DrawPacket& packet = source[index];
+            destination[offsets[(packet.key >> (pass * 8)) & 0xff]++] = packet;
+        }
+
+        std::swap(source, destination);
+    }
+
+    if (source != packets.data())
+        packets.swap(scratch);
+}
+
+/// @brief Count the state changes needed to draw the packets in their current order, assuming a
+/// piece of state is only bound when it differs from the previous draw's
+/// @param stats If not nullptr, receives the counters
+/// @return Total number of state changes
+size_t RenderQueue::CountStateChanges(const std::vector<DrawPacket>& packets, RenderQueueStats* stats)
+{
+    RenderQueueStats counters;
+    counters.drawCount = packets.size();
+
+    for (size_t index = 0; index < packets.size(); index++)
+    {
+        uint64_t key = packets[index].key;
+        bool first = index == 0;
+        uint64_t previous = first ? 0 : packets[index - 1].key;
+
+        if (first || GetShaderId(key) != GetShaderId(previous))
+            counters.shaderChanges++;
+        if (first || GetMaterialId(key) != GetMaterialId(previous))
+            counters.materialChanges++;
+        if (first || GetGeometryId(key) != GetGeometryId(previous))
+            counters.geometryChanges++;
+    }
+
+    size_t changes = counters.shaderChanges + counters.materialChanges + counters.geometryChanges;
+    counters.stateChangesAvoided = 3 * counters.drawCount - changes;
+
+    if (stats != nullptr)
+    {
+        counters.sortMilliseconds = stats->sortMilliseconds;
+        *stats = counters;
+    }
+
+    return changes;
+}
+
+uint32_t RenderQueue::GetId(IdMap& map, const void* object)
+{
+    if (object == nullptr)
+        return 0;
+
+    auto found = map.ids.find(object);
+    if (found != map.ids.end())
+    {
+        found->second.lastFrame = m_frame;
+        return found->second.id;
+    }
+
+    uint32_t id = map.nextId;
+    if (!map.freeIds.empty())
+    {
+        id = map.freeIds.back();
+        map.freeIds.pop_back();
+    }
+    else
+    {
+        map.nextId++;
+    }
+
+    map.ids.emplace(object, IdMap::Entry{ id, m_frame });
+    return id;
+}
+
+/// @brief Release the ids of the objects that weren't submitted in the last frame
+void RenderQueue::ReleaseUnused(IdMap& map)
+{
+    for (auto entry = map.ids.begin(); entry != map.ids.end();)
+    {
+        if (entry->second.lastFrame + 1 < m_frame)
+        {
+            map.freeIds.push_back(entry->second.id);
+            entry = map.ids.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
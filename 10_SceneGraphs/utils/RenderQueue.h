@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "LodSelection.h"
+
+/// @brief A single draw waiting in the RenderQueue. The queue doesn't know what is being drawn;
+/// `item` is whatever index the caller needs to find the draw again when submitting it.
+struct DrawPacket
+{
+    uint64_t key;
+    uint32_t item;
+};
+
+/// @brief Counters for the last sorted frame
+struct RenderQueueStats
+{
+    size_t drawCount = 0;
+    size_t shaderChanges = 0;
+    size_t materialChanges = 0;
+    size_t geometryChanges = 0;
+    size_t stateChangesAvoided = 0; // compared to binding the shader, material and geometry for every draw
+    double sortMilliseconds = 0.0;
+};
+
+/// @brief Collects the draws for a frame and sorts them so that draws sharing state end up next to
+/// each other.
+///
+/// Every draw gets a 64 bit sort key. From the most to the least significant bits:
+///   - 12 bits shader
+///   - 12 bits material
+///   - 16 bits geometry: 14 bits for the vertex buffer and 2 for the level of detail drawn from it
+///   - 24 bits depth, so that draws with the same state go front to back
+///
+/// Changing shader is the most expensive, so that goes in the top bits. Nothing in here depends on
+/// the graphics API; shaders, materials and geometry are only known by their ids (or by an opaque
+/// pointer that the queue turns into an id).
+///
+/// An id handed out for a pointer is kept for as long as the pointer is submitted every frame, so
+/// the order of the queue is stable. Once a frame goes by without it, the id is released for reuse:
+/// the queue never holds on to a pointer that wasn't drawn in the last frame, so a resource that is
+/// destroyed can't leave its pointer behind, and the ids stay as few as the things drawn.
+class RenderQueue
+{
+public:
+    static constexpr uint32_t ShaderBits = 12;
+    static constexpr uint32_t MaterialBits = 12;
+    static constexpr uint32_t GeometryBits = 16;
+    static constexpr uint32_t DepthBits = 24;
+    static constexpr uint32_t LodBits = 2;     // the low bits of the geometry id
+
+    static constexpr uint32_t DepthShift = 0;
+    static constexpr uint32_t GeometryShift = DepthShift + DepthBits;
+    static constexpr uint32_t MaterialShift = GeometryShift + GeometryBits;
+    static constexpr uint32_t ShaderShift = MaterialShift + MaterialBits;
+
+    static_assert(c_maxLodLevels <= (1u << LodBits), "every level of detail needs its own geometry id");
+
+    RenderQueue() = default;
+
+    static uint64_t MakeSortKey(uint32_t shaderId, uint32_t materialId, uint32_t geometryId, float depth);
+    static uint32_t GetShaderId(uint64_t key) { return static_cast<uint32_t>(key >> ShaderShift) & ((1u << ShaderBits) - 1); }
+    static uint32_t GetMaterialId(uint64_t key) { return static_cast<uint32_t>(key >> MaterialShift) & ((1u << MaterialBits) - 1); }
+    static uint32_t GetGeometryId(uint64_t key) { return static_cast<uint32_t>(key >> GeometryShift) & ((1u << GeometryBits) - 1); }
+
+    void Clear();
+    void Submit(uint64_t key, uint32_t item);
+    void Submit(const void* shader, const void* material, const void* geometry, float depth, uint32_t item, uint32_t lod = 0);
+    void Sort();
+
+    const std::vector<DrawPacket>& GetPackets() const { return m_packets; }
+    const RenderQueueStats& GetStats() const { return m_stats; }
+
+    static void RadixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+    static size_t CountStateChanges(const std::vector<DrawPacket>& packets, RenderQueueStats* stats = nullptr);
+
+private:
+    /// @brief The ids of one kind of object. nullptr is always id 0.
+    struct IdMap
+    {
+        struct Entry
+        {
+            uint32_t id;
+            uint64_t lastFrame;     // the last frame the object was submitted in
+        };
+
+        std::unordered_map<const void*, Entry> ids;
+        std::vector<uint32_t> freeIds;
+        uint32_t nextId = 1;
+    };
+
+    uint32_t GetId(IdMap& map, const void* object);
+    void ReleaseUnused(IdMap& map);
+
+    std::vector<DrawPacket> m_packets;
+    std::vector<DrawPacket> m_scratch;
+
+    IdMap m_shaderIds;
+    IdMap m_materialIds;
+    IdMap m_geometryIds;
+    uint64_t m_frame = 0;
+
+    RenderQueueStats m_stats;
+};
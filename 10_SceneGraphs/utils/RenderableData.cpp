@@ -0,0 +1,119 @@
+#include "RenderableData.h"
+
+#include <algorithm>
+#include <cstring>
+
+/// @brief Build the levels of detail of a submesh, pack its vertices and append both to the
+/// renderable's. The indices stay 32 bits until Finish.
+template <typename TPackedVertex, typename TVertex>
+void RenderableBuilder::Add(const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t material)
+{
+    LodChain chain = BuildLodChain(vertices, indices);
+
+    SubmeshData submesh;
+    submesh.firstIndex = static_cast<uint32_t>(m_indices.size());
+    submesh.indexCount = static_cast<uint32_t>(chain.indices.size());
+    submesh.firstVertex = m_data.vertexCount;
+    submesh.vertexCount = static_cast<uint32_t>(vertices.size());
+    submesh.material = material;
+    submesh.quantization = m_hasSharedQuantization ? m_sharedQuantization :
+        ComputePositionQuantization(vertices.data(), vertices.size(), sizeof(TVertex));
+    submesh.lods = std::move(chain.levels);
+
+    m_data.vertexStride = sizeof(TPackedVertex);
+    size_t firstByte = m_data.vertices.size();
+    m_data.vertices.resize(firstByte + vertices.size() * sizeof(TPackedVertex));
+    PackVertices(vertices.data(), vertices.size(), submesh.quantization, reinterpret_cast<TPackedVertex*>(m_data.vertices.data() + firstByte));
+    m_data.vertexCount += submesh.vertexCount;
+
+    m_indices.insert(m_indices.end(), chain.indices.begin(), chain.indices.end());
+    m_data.submeshes.push_back(std::move(submesh));
+}
+
+/// @brief Quantize every submesh added from now on to one grid, usually the bounds of the whole
+/// mesh, instead of to its own bounds. Each submesh loses a little precision, but positions the
+/// submeshes share stay identical after decoding.
+void RenderableBuilder::SetSharedQuantization(const PositionQuantization& quantization)
+{
+    m_sharedQuantization = quantization;
+    m_hasSharedQuantization = true;
+}
+
+/// @brief Add a submesh as it is, however many vertices it has
+void RenderableBuilder::AddSubmesh(const std::vector<VertexNormal>& vertices, const std::vector<uint32_t>& indices, uint32_t material)
+{
+    Add<PackedVertexNormal>(vertices, indices, material);
+}
+
+/// @brief Add a submesh as it is, however many vertices it has
+void RenderableBuilder::AddSubmesh(const std::vector<VertexNormalUV>& vertices, const std::vector<uint32_t>& indices, uint32_t material)
+{
+    Add<PackedVertexNormalUV>(vertices, indices, material);
+}
+
+/// @brief Hand over the renderable, with its indices at 16 bits if every submesh's vertices fit
+/// in them, so meshes made of small parts don't pay for the wider buffer. The builder is left
+/// empty, without a shared grid.
+/// @param materials The materials the submeshes were added with; any a submesh refers to that
+/// isn't in the table is white
+RenderableData RenderableBuilder::Finish(std::vector<MaterialData> materials)
+{
+    RenderableData data = std::move(m_data);
+    m_data = RenderableData();
+    m_hasSharedQuantization = false;
+
+    bool shortIndices = std::all_of(data.submeshes.begin(), data.submeshes.end(), [](const SubmeshData& submesh)
+        {
+            return FitsShortIndices(submesh.vertexCount);
+        });
+
+    data.indexCount = static_cast<uint32_t>(m_indices.size());
+    if (shortIndices)
+    {
+        auto narrowed = NarrowIndices(m_indices);
+        data.indexSize = sizeof(uint16_t);
+        data.indices.resize(narrowed.size() * sizeof(uint16_t));
+        std::memcpy(data.indices.data(), narrowed.data(), data.indices.size());
+    }
+    else
+    {
+        data.indexSize = sizeof(uint32_t);
+        data.indices.resize(m_indices.size() * sizeof(uint32_t));
+        std::memcpy(data.indices.data(), m_indices.data(), data.indices.size());
+    }
+    m_indices.clear();
+
+    for (const auto& submesh : data.submeshes)
+    {
+        if (submesh.material >= materials.size())
+            materials.resize(submesh.material + 1);
+    }
+    if (materials.empty())
+        materials.resize(1);
+    data.materials = std::move(materials);
+    return data;
+}
+
+/// @brief Prepare a renderable of one submesh and material, with its levels of detail sharing its
+/// vertex buffer
+RenderableData PrepareRenderable(const std::vector<VertexNormal>& vertices, const std::vector<uint32_t>& indices, const float diffuse[3])
+{
+    RenderableBuilder builder;
+    builder.AddSubmesh(vertices, indices, 0);
+
+    MaterialData material;
+    std::copy(diffuse, diffuse + 3, material.diffuse);
+    return builder.Finish({ material });
+}
+
+/// @brief Prepare a renderable of one submesh and material, with its levels of detail sharing its
+/// vertex buffer
+RenderableData PrepareRenderable(const std::vector<VertexNormalUV>& vertices, const std::vector<uint32_t>& indices, const float diffuse[3])
+{
+    RenderableBuilder builder;
+    builder.AddSubmesh(vertices, indices, 0);
+
+    MaterialData material;
+    std::copy(diffuse, diffuse + 3, material.diffuse);
+    return builder.Finish({ material });
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
+#include "VertexCompression.h"
+
+/// The CPU side of a Renderable: packed vertices, indices holding every level of detail, and the
+/// table of submeshes and materials that says how to draw them, laid out exactly as the GPU
+/// buffers will be. Building one is all CPU work, so it can happen on a loader thread, leaving
+/// only the buffer creation for the thread that owns the device. This header is free of Windows
+/// and D3D headers.
+
+/// @brief How to turn a mesh with more vertices than 16 bit indices can reach into submeshes
+enum class LargeMeshMode
+{
+    LongIndices,    // one submesh, and a 32 bit index buffer for the whole renderable
+    Split           // several submeshes, each small enough for 16 bit indices
+};
+
+/// @brief A range of a renderable's vertex and index buffers drawn with one material, the same
+/// layout as a CookedSubmesh
+struct SubmeshData
+{
+    uint32_t firstIndex = 0;        // the submesh's levels of detail follow one another from here
+    uint32_t indexCount = 0;
+    uint32_t firstVertex = 0;       // the submesh's indices count from here
+    uint32_t vertexCount = 0;
+    uint32_t material = 0;          // in the renderable's materials
+    PositionQuantization quantization;  // the grid shared by the renderable, or the submesh's own
+    std::vector<LodLevel> lods;     // from firstIndex, finest first; empty if the whole range is the only level
+};
+
+/// @brief What a material gives the shaders, through the constants of each submesh drawn with it
+struct MaterialData
+{
+    float diffuse[3] = { 1.0f, 1.0f, 1.0f };
+    uint32_t textureSlice = 0;      // of the texture array the material's texture is in, for textured meshes
+};
+
+struct RenderableData
+{
+    std::vector<uint8_t> vertices;  // vertexCount packed vertices of vertexStride bytes, a submesh after another
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount = 0;
+    std::vector<uint8_t> indices;   // indexCount indices of indexSize bytes, every submesh's after another
+    uint32_t indexSize = sizeof(uint16_t);  // 16 bits whenever every submesh's vertices fit
+    uint32_t indexCount = 0;
+    std::vector<SubmeshData> submeshes;
+    std::vector<MaterialData> materials;    // at least one past the highest material of any submesh
+};
+
+/// @brief Puts a renderable together a submesh at a time. Each submesh gets its own levels of
+/// detail, and they all share one vertex and one index buffer, so a mesh with several materials is
+/// still drawn from a single pair of buffers. Positions are quantized to each submesh's own bounds
+/// unless a shared grid is set: the same position rounds to different points on different grids,
+/// so submeshes that meet along an edge need the shared one, or cracks open between them.
+class RenderableBuilder
+{
+public:
+    void SetSharedQuantization(const PositionQuantization& quantization);
+
+    void AddSubmesh(const std::vector<VertexNormal>& vertices, const std::vector<uint32_t>& indices, uint32_t material);
+    void AddSubmesh(const std::vector<VertexNormalUV>& vertices, const std::vector<uint32_t>& indices, uint32_t material);
+
+    template <typename TVertex>
+    void AddSubmeshes(const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t material, LargeMeshMode mode);
+
+    uint32_t GetSubmeshCount() const { return static_cast<uint32_t>(m_data.submeshes.size()); }
+
+    RenderableData Finish(std::vector<MaterialData> materials);
+
+private:
+    template <typename TPackedVertex, typename TVertex>
+    void Add(const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t material);
+
+    RenderableData m_data;
+    std::vector<uint32_t> m_indices;    // narrowed by Finish if they fit
+    PositionQuantization m_sharedQuantization;
+    bool m_hasSharedQuantization = false;
+};
+
+RenderableData PrepareRenderable(const std::vector<VertexNormal>& vertices, const std::vector<uint32_t>& indices, const float diffuse[3]);
+RenderableData PrepareRenderable(const std::vector<VertexNormalUV>& vertices, const std::vector<uint32_t>& indices, const float diffuse[3]);
+
+/// @brief Add a part of a mesh with one material. Parts that fit in 16 bit indices always become
+/// a single submesh; larger ones are handled as the mode says. Each submesh gets its own levels of
+/// detail; the simplifier leaves the borders between clusters alone, so they still meet whichever
+/// level each one draws. Without a shared grid, the clusters are quantized on the part's.
+/// @param vertices The part's vertices
+/// @param indices The part's triangles
+/// @param material The part's material, in the table given to Finish
+template <typename TVertex>
+void RenderableBuilder::AddSubmeshes(const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t material, LargeMeshMode mode)
+{
+    if (FitsShortIndices(vertices.size()) || mode == LargeMeshMode::LongIndices)
+    {
+        AddSubmesh(vertices, indices, material);
+        return;
+    }
+
+    bool partGrid = !m_hasSharedQuantization;
+    if (partGrid)
+        SetSharedQuantization(ComputePositionQuantization(vertices.data(), vertices.size(), sizeof(TVertex)));
+
+    for (const auto& cluster : SplitMesh(indices, vertices.size()))
+    {
+        std::vector<uint32_t> clusterIndices(cluster.indices.begin(), cluster.indices.end());
+        AddSubmesh(GatherClusterVertices(cluster, vertices), clusterIndices, material);
+    }
+
+    if (partGrid)
+        m_hasSharedQuantization = false;
+}
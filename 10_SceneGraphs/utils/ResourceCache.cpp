@@ -0,0 +1,258 @@
+#include "ResourceCache.h"
+
+#include <filesystem>
+#include <utility>
+
+const char* GetResourceTypeName(ResourceType type)
+{
+    switch (type)
+    {
+    case ResourceType::Mesh: return "Mesh";
+    case ResourceType::Texture: return "Texture";
+    case ResourceType::Shader: return "Shader";
+    default: return "Unknown";
+    }
+}
+
+/// @brief Make the key a resource is cached under
+/// @param path Where the resource is loaded from. Spellings of the same path, like "a/../b.fbx"
+/// and "b.fbx", give the same key.
+/// @param parameters Anything else that changes what gets loaded, such as the index size of a mesh
+std::string MakeResourceKey(const std::string& path, const std::string& parameters)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string() + "|" + parameters;
+}
+
+ResourceCache::ResourceCache(uint32_t destroyDelayFrames)
+    : m_destroyDelay(destroyDelayFrames)
+{
+}
+
+ResourceCache::~ResourceCache()
+{
+    Clear();
+}
+
+/// @brief Look for a resource, and take a reference to it if it is there. A resource waiting to be
+/// destroyed is revived.
+/// @return An invalid handle if the resource isn't cached, in which case create it and Insert it
+ResourceHandle ResourceCache::Find(ResourceType type, const std::string& key)
+{
+    auto& keys = m_keys[static_cast<size_t>(type)];
+    auto found = keys.find(key);
+    if (found == keys.end())
+    {
+        m_misses[static_cast<size_t>(type)]++;
+        return ResourceHandle();
+    }
+
+    Slot& slot = m_slots[found->second];
+    slot.refCount++;
+    m_hits[static_cast<size_t>(type)]++;
+    return ResourceHandle{ found->second, slot.generation };
+}
+
+/// @brief Add a resource the caller has just created, holding one reference to it
+/// @param bytes How much memory it takes, for the report. SetBytes can change it later, for a
+/// resource that is still loading.
+/// @return An invalid handle if the resource is empty. If the key is taken already, the new
+/// resource is dropped and a reference to the one already cached is returned.
+ResourceHandle ResourceCache::Insert(ResourceType type, const std::string& key, std::shared_ptr<void> resource, uint64_t bytes)
+{
+    if (resource == nullptr)
+        return ResourceHandle();
+
+    auto& keys = m_keys[static_cast<size_t>(type)];
+    auto found = keys.find(key);
+    if (found != keys.end())
+    {
+        Slot& slot = m_slots[found->second];
+        slot.refCount++;
+        return ResourceHandle{ found->second, slot.generation };
+    }
+
+    uint32_t index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    Slot& slot = m_slots[index];
+    slot.key = key;
+    slot.type = type;
+    slot.resource = std::move(resource);
+    slot.bytes = bytes;
+    slot.refCount = 1;
+    keys.emplace(key, index);
+    return ResourceHandle{ index, slot.generation };
+}
+
+void ResourceCache::AddRef(ResourceHandle handle)
+{
+    if (Slot* slot = Lookup(handle))
+        slot->refCount++;
+}
+
+/// @brief Give up a reference. When the last one goes the resource is queued to be destroyed
+/// once the destroy delay has passed. Stale and invalid handles are ignored.
+void ResourceCache::Release(ResourceHandle handle)
+{
+    Slot* slot = Lookup(handle);
+    if (slot == nullptr || slot->refCount == 0)
+        return;
+
+    if (--slot->refCount > 0)
+        return;
+
+    slot->releasedFrame = m_frame;
+    if (!slot->pending)
+    {
+        slot->pending = true;
+        m_pending.push_back(handle.index);
+    }
+}
+
+uint32_t ResourceCache::GetRefCount(ResourceHandle handle) const
+{
+    const Slot* slot = Lookup(handle);
+    return slot != nullptr ? slot->refCount : 0;
+}
+
+/// @return The resource, or nothing if the handle is stale or invalid or refers to another type
+std::shared_ptr<void> ResourceCache::GetResource(ResourceType type, ResourceHandle handle) const
+{
+    const Slot* slot = Lookup(handle);
+    return slot != nullptr && slot->type == type ? slot->resource : nullptr;
+}
+
+void ResourceCache::SetBytes(ResourceHandle handle, uint64_t bytes)
+{
+    if (Slot* slot = Lookup(handle))
+        slot->bytes = bytes;
+}
+
+/// @brief Move on a frame, and destroy the resources that were released long enough ago
+/// @return How many were destroyed
+uint32_t ResourceCache::EndFrame()
+{
+    m_frame++;
+
+    // Resources are dropped only once the bookkeeping is done, as one may hold handles of its own
+    // and release them from its destructor
+    std::vector<std::shared_ptr<void>> destroyed;
+    size_t kept = 0;
+    for (uint32_t index : m_pending)
+    {
+        Slot& slot = m_slots[index];
+        if (slot.refCount > 0)
+        {
+            slot.pending = false;
+            continue;
+        }
+
+        if (m_frame - slot.releasedFrame < m_destroyDelay)
+        {
+            m_pending[kept++] = index;
+            continue;
+        }
+
+        m_keys[static_cast<size_t>(slot.type)].erase(slot.key);
+        m_destroyed[static_cast<size_t>(slot.type)]++;
+        destroyed.push_back(std::move(slot.resource));
+        slot.resource.reset();
+        slot.key.clear();
+        slot.bytes = 0;
+        slot.pending = false;
+        slot.generation++;
+        m_freeSlots.push_back(index);
+    }
+    m_pending.resize(kept);
+
+    uint32_t count = static_cast<uint32_t>(destroyed.size());
+    destroyed.clear();
+    return count;
+}
+
+/// @brief Destroy every resource now, whether it is still referenced or not. Handles to them all
+/// go stale.
+void ResourceCache::Clear()
+{
+    std::vector<std::shared_ptr<void>> destroyed;
+    m_freeSlots.clear();
+    for (uint32_t index = 0; index < m_slots.size(); index++)
+    {
+        Slot& slot = m_slots[index];
+        if (slot.resource != nullptr)
+        {
+            m_destroyed[static_cast<size_t>(slot.type)]++;
+            destroyed.push_back(std::move(slot.resource));
+            slot.resource.reset();
+            slot.generation++;
+        }
+        slot.key.clear();
+        slot.bytes = 0;
+        slot.refCount = 0;
+        slot.pending = false;
+        m_freeSlots.push_back(index);
+    }
+    for (auto& keys : m_keys)
+    {
+        keys.clear();
+    }
+    m_pending.clear();
+
+    destroyed.clear();
+}
+
+ResourceReport ResourceCache::GetReport() const
+{
+    ResourceReport report;
+    for (const Slot& slot : m_slots)
+    {
+        if (slot.resource == nullptr)
+            continue;
+
+        auto& stats = report.types[static_cast<size_t>(slot.type)];
+        if (slot.refCount > 0)
+        {
+            stats.resident++;
+            stats.residentBytes += slot.bytes;
+        }
+        else
+        {
+            stats.pendingDestroy++;
+            stats.pendingBytes += slot.bytes;
+        }
+        report.totalBytes += slot.bytes;
+    }
+
+    for (size_t type = 0; type < c_resourceTypeCount; type++)
+    {
+        report.types[type].hits = m_hits[type];
+        report.types[type].misses = m_misses[type];
+        report.types[type].destroyed = m_destroyed[type];
+    }
+    return report;
+}
+
+const ResourceCache::Slot* ResourceCache::Lookup(ResourceHandle handle) const
+{
+    if (handle.index >= m_slots.size())
+        return nullptr;
+
+    const Slot& slot = m_slots[handle.index];
+    if (slot.generation != handle.generation || slot.resource == nullptr)
+        return nullptr;
+    return &slot;
+}
+
+ResourceCache::Slot* ResourceCache::Lookup(ResourceHandle handle)
+{
+    return const_cast<Slot*>(static_cast<const ResourceCache*>(this)->Lookup(handle));
+}
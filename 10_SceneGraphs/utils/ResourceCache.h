@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ResourceType : uint32_t
+{
+    Mesh,
+    Texture,
+    Shader,
+    Count
+};
+
+constexpr size_t c_resourceTypeCount = static_cast<size_t>(ResourceType::Count);
+
+const char* GetResourceTypeName(ResourceType type);
+
+/// @brief Refers to a resource in a ResourceCache. The generation changes every time a slot is
+/// reused, so a handle to a resource that has been destroyed can't reach whatever took its place.
+struct ResourceHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+    bool operator==(const ResourceHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ResourceHandle& other) const { return !(*this == other); }
+};
+
+/// @brief What a ResourceCache is holding of one type of resource
+struct ResourceTypeStats
+{
+    uint32_t resident = 0;          // held by at least one handle
+    uint32_t pendingDestroy = 0;    // released by everything, waiting out the destroy delay
+    uint64_t residentBytes = 0;
+    uint64_t pendingBytes = 0;
+    uint32_t hits = 0;              // lookups that found the resource already there, since the cache was made
+    uint32_t misses = 0;            // lookups that had to create it
+    uint32_t destroyed = 0;
+};
+
+/// @brief Bytes resident per resource type
+struct ResourceReport
+{
+    ResourceTypeStats types[c_resourceTypeCount];
+    uint64_t totalBytes = 0;        // resident and pending, over every type
+
+    const ResourceTypeStats& Get(ResourceType type) const { return types[static_cast<size_t>(type)]; }
+};
+
+std::string MakeResourceKey(const std::string& path, const std::string& parameters);
+
+/// @brief Deduplicates and reference counts loaded resources. Each is stored once under its type
+/// and a key made from where it came from and how it was loaded, so asking for the same thing twice
+/// hands back the same resource.
+///
+/// Releasing the last reference doesn't destroy the resource straight away: it is kept for a few
+/// more frames, since the GPU may still be drawing with it, and so something released and acquired
+/// again in the same stretch, as happens when a level swaps its contents, is revived rather than
+/// reloaded. EndFrame destroys whatever has waited long enough.
+///
+/// The cache holds resources as shared_ptr<void>, and destroys them by dropping its reference,
+/// so it knows nothing of D3D. It is not thread safe; use it from the main thread.
+class ResourceCache
+{
+public:
+    static constexpr uint32_t c_defaultDestroyDelay = 3;
+
+    /// @param destroyDelayFrames A released resource is destroyed by the EndFrame this many frames
+    /// on, or by the next one if 0
+    explicit ResourceCache(uint32_t destroyDelayFrames = c_defaultDestroyDelay);
+    ~ResourceCache();
+
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+
+    ResourceHandle Find(ResourceType type, const std::string& key);
+    ResourceHandle Insert(ResourceType type, const std::string& key, std::shared_ptr<void> resource, uint64_t bytes);
+
+    void AddRef(ResourceHandle handle);
+    void Release(ResourceHandle handle);
+
+    bool IsValid(ResourceHandle handle) const { return Lookup(handle) != nullptr; }
+    uint32_t GetRefCount(ResourceHandle handle) const;
+    std::shared_ptr<void> GetResource(ResourceType type, ResourceHandle handle) const;
+
+    /// @brief The resource, as the type it was inserted as
+    template <typename T>
+    std::shared_ptr<T> Get(ResourceType type, ResourceHandle handle) const
+    {
+        return std::static_pointer_cast<T>(GetResource(type, handle));
+    }
+
+    void SetBytes(ResourceHandle handle, uint64_t bytes);
+
+    uint32_t EndFrame();
+    void Clear();
+
+    ResourceReport GetReport() const;
+
+private:
+    struct Slot
+    {
+        std::string key;
+        ResourceType type = ResourceType::Mesh;
+        std::shared_ptr<void> resource;     // empty while the slot is free
+        uint64_t bytes = 0;
+        uint32_t refCount = 0;
+        uint32_t generation = 0;
+        uint64_t releasedFrame = 0;         // when the count last went to zero
+        bool pending = false;               // in m_pending
+    };
+
+    const Slot* Lookup(ResourceHandle handle) const;
+    Slot* Lookup(ResourceHandle handle);
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<std::string, uint32_t> m_keys[c_resourceTypeCount];
+    std::vector<uint32_t> m_pending;        // slots whose count went to zero, oldest first
+
+    uint64_t m_frame = 0;
+    uint32_t m_destroyDelay;
+
+    uint32_t m_hits[c_resourceTypeCount] = {};
+    uint32_t m_misses[c_resourceTypeCount] = {};
+    uint32_t m_destroyed[c_resourceTypeCount] = {};
+};
@@ -0,0 +1,87 @@
+#include "RingAllocator.h"
+
+/// @brief Forget every allocation and start over with a ring of the given size
+void RingAllocator::Reset(uint64_t capacity)
+{
+    m_capacity = capacity;
+    m_head = 0;
+    m_used = 0;
+    m_frameSize = 0;
+    m_frameAllocations = 0;
+    m_frames.clear();
+
+    m_stats = RingAllocatorStats();
+    m_stats.capacity = capacity;
+}
+
+/// @brief Allocate a range for the frame in progress
+/// @param size Size of the range in bytes
+/// @param alignment Alignment of the start of the range; must be a power of two
+/// @return Offset of the range, or InvalidOffset if the ring is full until older frames are retired
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    uint64_t offset = (m_head + alignment - 1) & ~(alignment - 1);
+    uint64_t padding = offset - m_head;
+    bool wraps = offset + size > m_capacity;
+    if (wraps)
+    {
+        // Skip the rest of the buffer, the range has to be contiguous
+        padding = m_capacity - m_head;
+        offset = 0;
+    }
+
+    // Everything from the oldest pending frame up to the head is in use, so whatever is left over
+    // is free; that's the space up to the oldest frame, both before and after a wrap.
+    if (size > m_capacity || m_used + padding + size > m_capacity)
+    {
+        m_stats.failedAllocations++;
+        return InvalidOffset;
+    }
+
+    if (wraps)
+        m_stats.wraps++;
+
+    m_head = offset + size;
+    m_used += padding + size;
+    m_frameSize += padding + size;
+    m_frameAllocations++;
+
+    if (m_used > m_stats.peakUsed)
+        m_stats.peakUsed = m_used;
+    m_stats.used = m_used;
+
+    return offset;
+}
+
+/// @brief Close the frame in progress
+/// @param fenceValue Fence the GPU signals once it is done with everything allocated in the frame
+void RingAllocator::EndFrame(uint64_t fenceValue)
+{
+    m_frames.push_back(Frame{ fenceValue, m_frameSize });
+
+    m_stats.frameBytes = m_frameSize;
+    m_stats.frameAllocations = m_frameAllocations;
+
+    m_frameSize = 0;
+    m_frameAllocations = 0;
+}
+
+/// @brief Free every frame whose fence the GPU has passed
+/// @param completedFenceValue The last fence value the GPU signalled
+void RingAllocator::Retire(uint64_t completedFenceValue)
+{
+    while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+    {
+        m_used -= m_frames.front().size;
+        m_frames.pop_front();
+    }
+
+    // With nothing in flight the head can go back to the start, so the next frame doesn't wrap
+    if (m_frames.empty() && m_frameSize == 0)
+    {
+        m_head = 0;
+        m_used = 0;
+    }
+
+    m_stats.used = m_used;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/// @brief Counters about the ring's use
+struct RingAllocatorStats
+{
+    uint64_t capacity = 0;
+    uint64_t used = 0;          // bytes in frames the GPU may still be reading, including padding
+    uint64_t peakUsed = 0;
+    uint64_t frameBytes = 0;    // bytes allocated by the last finished frame, including padding
+    size_t frameAllocations = 0;
+    size_t wraps = 0;
+    size_t failedAllocations = 0;
+};
+
+/// @brief Hands out ranges of a fixed size buffer in a ring, for data that only lives for a frame.
+///
+/// Allocations are made from the head of the ring and freed a frame at a time from the tail. At the
+/// end of a frame, EndFrame tags everything allocated during it with a fence value; once the GPU is
+/// known to have passed that fence, Retire gives the space back. An allocation never straddles the
+/// end of the buffer; if it doesn't fit, the rest of the buffer is skipped and it starts at 0.
+///
+/// The allocator only does the bookkeeping. It doesn't own any memory, and it doesn't know what a
+/// fence is beyond the numbers it is given, which have to increase from frame to frame.
+class RingAllocator
+{
+public:
+    static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+    RingAllocator() = default;
+    explicit RingAllocator(uint64_t capacity) { Reset(capacity); }
+
+    void Reset(uint64_t capacity);
+
+    uint64_t Allocate(uint64_t size, uint64_t alignment);
+    void EndFrame(uint64_t fenceValue);
+    void Retire(uint64_t completedFenceValue);
+
+    bool HasPendingFrames() const { return !m_frames.empty(); }
+    uint64_t GetOldestPendingFence() const { return m_frames.empty() ? 0 : m_frames.front().fenceValue; }
+
+    const RingAllocatorStats& GetStats() const { return m_stats; }
+
+private:
+    struct Frame
+    {
+        uint64_t fenceValue;
+        uint64_t size;  // bytes used by the frame, including padding
+    };
+
+    uint64_t m_capacity = 0;
+    uint64_t m_head = 0;        // where the next allocation starts looking
+    uint64_t m_used = 0;        // bytes from the start of the oldest pending frame up to the head
+    uint64_t m_frameSize = 0;   // bytes used by the frame in progress
+    size_t m_frameAllocations = 0;
+
+    std::deque<Frame> m_frames;
+
+    RingAllocatorStats m_stats;
+};
@@ -0,0 +1,196 @@
+#include "SamplerTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    constexpr size_t c_keyWords = 13;
+
+    // D3D11_FILTER_REDUCTION_TYPE_SHIFT and _MASK, D3D11_FILTER_REDUCTION_TYPE_COMPARISON and
+    // D3D11_ANISOTROPIC_FILTERING_BIT: how the filter enum says what it does
+    constexpr uint32_t c_reductionShift = 7;
+    constexpr uint32_t c_reductionMask = 0x3;
+    constexpr uint32_t c_reductionComparison = 1;
+    constexpr uint32_t c_anisotropicBit = 0x40;
+
+    uint32_t FloatBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    /// @brief The key as words, floats by their bits, so that equal keys hash the same
+    void ToWords(const SamplerKey& key, uint32_t (&words)[c_keyWords])
+    {
+        words[0] = key.filter;
+        words[1] = key.addressU;
+        words[2] = key.addressV;
+        words[3] = key.addressW;
+        words[4] = FloatBits(key.mipLodBias);
+        words[5] = key.maxAnisotropy;
+        words[6] = key.comparisonFunc;
+        for (size_t index = 0; index < 4; index++)
+        {
+            words[7 + index] = FloatBits(key.borderColor[index]);
+        }
+        words[11] = FloatBits(key.minLod);
+        words[12] = FloatBits(key.maxLod);
+    }
+
+    /// @brief -0 is the same as 0 to the sampler, but not to the hash
+    float PositiveZero(float value)
+    {
+        return value == 0.0f ? 0.0f : value;
+    }
+}
+
+/// @brief Equal when every field has the same bits, so that equal keys always hash the same
+bool SamplerKey::operator==(const SamplerKey& other) const
+{
+    uint32_t words[c_keyWords];
+    uint32_t otherWords[c_keyWords];
+    ToWords(*this, words);
+    ToWords(other, otherWords);
+    return std::equal(std::begin(words), std::end(words), std::begin(otherWords));
+}
+
+/// @brief Clear the fields D3D ignores for the key's filter and address modes, so keys that make
+/// the same sampler are equal
+SamplerKey NormalizeSamplerKey(const SamplerKey& key)
+{
+    SamplerKey normalized = key;
+
+    bool comparison = ((key.filter >> c_reductionShift) & c_reductionMask) == c_reductionComparison;
+    if (!comparison)
+        normalized.comparisonFunc = c_comparisonNever;
+
+    if ((key.filter & c_anisotropicBit) == 0)
+        normalized.maxAnisotropy = 0;
+    else
+        normalized.maxAnisotropy = std::min(std::max(key.maxAnisotropy, 1u), c_maxSamplerAnisotropy);
+
+    bool border = key.addressU == c_addressBorder || key.addressV == c_addressBorder || key.addressW == c_addressBorder;
+    for (float& channel : normalized.borderColor)
+    {
+        channel = border ? PositiveZero(channel) : 0.0f;
+    }
+
+    normalized.mipLodBias = PositiveZero(key.mipLodBias);
+    normalized.minLod = PositiveZero(key.minLod);
+    normalized.maxLod = PositiveZero(key.maxLod);
+    return normalized;
+}
+
+/// @brief 64-bit FNV-1a over the key's fields. Normalize the key first for samplers that are the
+/// same to hash the same.
+uint64_t HashSamplerKey(const SamplerKey& key)
+{
+    uint32_t words[c_keyWords];
+    ToWords(key, words);
+
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : words)
+    {
+        for (uint32_t shift = 0; shift < 32; shift += 8)
+        {
+            hash ^= (word >> shift) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+/// @brief The description of a static sampler
+SamplerKey GetStaticSamplerKey(StaticSampler sampler)
+{
+    SamplerKey key;
+    switch (sampler)
+    {
+    case StaticSampler::LinearClamp:
+        key.addressU = key.addressV = key.addressW = c_addressClamp;
+        break;
+    case StaticSampler::PointClamp:
+        key.filter = c_filterMinMagMipPoint;
+        key.addressU = key.addressV = key.addressW = c_addressClamp;
+        break;
+    case StaticSampler::AnisotropicWrap:
+        key.filter = c_filterAnisotropic;
+        key.maxAnisotropy = c_maxSamplerAnisotropy;
+        break;
+    default:
+        break;
+    }
+    return key;
+}
+
+const char* GetStaticSamplerName(StaticSampler sampler)
+{
+    switch (sampler)
+    {
+    case StaticSampler::LinearWrap: return "linear wrap";
+    case StaticSampler::LinearClamp: return "linear clamp";
+    case StaticSampler::PointClamp: return "point clamp";
+    case StaticSampler::AnisotropicWrap: return "anisotropic wrap";
+    default: return "unknown";
+    }
+}
+
+/// @brief Bind the static samplers to their slots. Call once a frame, after StateCache::BeginFrame.
+void BindStaticSamplers(StateCache& stateCache, ID3D11SamplerState* const (&samplers)[c_staticSamplerCount])
+{
+    for (uint32_t slot = 0; slot < c_staticSamplerCount; slot++)
+    {
+        stateCache.PSSetSampler(slot, samplers[slot]);
+    }
+}
+
+/// @brief The index of a key, added to the table if no equal one is in it already
+/// @param added Set to whether the key was new, if not nullptr
+uint32_t SamplerTable::Insert(const SamplerKey& key, bool* added)
+{
+    m_lookups++;
+
+    SamplerKey normalized = NormalizeSamplerKey(key);
+    auto found = m_indices.find(normalized);
+    if (found != m_indices.end())
+    {
+        m_hits++;
+        if (added != nullptr)
+            *added = false;
+        return found->second;
+    }
+
+    uint32_t index = static_cast<uint32_t>(m_keys.size());
+    m_keys.push_back(normalized);
+    m_indices.emplace(normalized, index);
+    if (added != nullptr)
+        *added = true;
+    return index;
+}
+
+/// @return The index of a key, or c_notFound if nothing equal to it has been inserted
+uint32_t SamplerTable::Find(const SamplerKey& key) const
+{
+    auto found = m_indices.find(NormalizeSamplerKey(key));
+    return found != m_indices.end() ? found->second : c_notFound;
+}
+
+SamplerTableStats SamplerTable::GetStats() const
+{
+    SamplerTableStats stats;
+    stats.lookups = m_lookups;
+    stats.hits = m_hits;
+    stats.unique = GetCount();
+    return stats;
+}
+
+void SamplerTable::Clear()
+{
+    m_indices.clear();
+    m_keys.clear();
+    m_lookups = 0;
+    m_hits = 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "StateCache.h"
+
+// The D3D11 enum values a SamplerKey uses, so the table doesn't need the D3D11 headers
+constexpr uint32_t c_filterMinMagMipPoint = 0x00;       // D3D11_FILTER_MIN_MAG_MIP_POINT
+constexpr uint32_t c_filterMinMagMipLinear = 0x15;      // D3D11_FILTER_MIN_MAG_MIP_LINEAR
+constexpr uint32_t c_filterAnisotropic = 0x55;          // D3D11_FILTER_ANISOTROPIC
+constexpr uint32_t c_addressWrap = 1;                   // D3D11_TEXTURE_ADDRESS_WRAP
+constexpr uint32_t c_addressClamp = 3;                  // D3D11_TEXTURE_ADDRESS_CLAMP
+constexpr uint32_t c_addressBorder = 4;                 // D3D11_TEXTURE_ADDRESS_BORDER
+constexpr uint32_t c_comparisonNever = 1;               // D3D11_COMPARISON_NEVER
+constexpr uint32_t c_comparisonLessEqual = 4;           // D3D11_COMPARISON_LESS_EQUAL
+constexpr uint32_t c_maxSamplerAnisotropy = 16;         // D3D11_MAX_MAXANISOTROPY
+
+/// @brief Everything a sampler state is made from, field for field as in D3D11_SAMPLER_DESC
+struct SamplerKey
+{
+    uint32_t filter = c_filterMinMagMipLinear;
+    uint32_t addressU = c_addressWrap;
+    uint32_t addressV = c_addressWrap;
+    uint32_t addressW = c_addressWrap;
+    float mipLodBias = 0.0f;
+    uint32_t maxAnisotropy = 0;
+    uint32_t comparisonFunc = c_comparisonNever;
+    float borderColor[4] = {};
+    float minLod = 0.0f;
+    float maxLod = 3.402823466e+38f;    // D3D11_FLOAT32_MAX, every mip
+
+    bool operator==(const SamplerKey& other) const;
+    bool operator!=(const SamplerKey& other) const { return !(*this == other); }
+};
+
+SamplerKey NormalizeSamplerKey(const SamplerKey& key);
+uint64_t HashSamplerKey(const SamplerKey& key);
+
+struct SamplerKeyHash
+{
+    size_t operator()(const SamplerKey& key) const { return static_cast<size_t>(HashSamplerKey(key)); }
+};
+
+/// @brief The samplers every pixel shader can count on. Each is bound to the slot of its value,
+/// s0 up, once a frame, so materials never bind a sampler of their own.
+enum class StaticSampler : uint32_t
+{
+    LinearWrap,         // s0: trilinear, wrapping; what every material samples its texture with
+    LinearClamp,        // s1
+    PointClamp,         // s2
+    AnisotropicWrap,    // s3
+    Count
+};
+
+constexpr uint32_t c_staticSamplerCount = static_cast<uint32_t>(StaticSampler::Count);
+
+SamplerKey GetStaticSamplerKey(StaticSampler sampler);
+const char* GetStaticSamplerName(StaticSampler sampler);
+void BindStaticSamplers(StateCache& stateCache, ID3D11SamplerState* const (&samplers)[c_staticSamplerCount]);
+
+/// @brief Counters from a SamplerTable
+struct SamplerTableStats
+{
+    uint64_t lookups = 0;   // keys inserted, new or not
+    uint64_t hits = 0;      // of those, ones that were there already
+    uint32_t unique = 0;    // distinct samplers in the table
+};
+
+/// @brief Gives every distinct sampler description an index, so each is created only once.
+///
+/// Keys are normalized before they are looked up: fields D3D ignores for the filter and address
+/// modes given (the border colour when nothing clamps to the border, the comparison function of a
+/// filter that doesn't compare, the anisotropy of one that isn't anisotropic) are cleared, so two
+/// descriptions that differ only in those share an index.
+class SamplerTable
+{
+public:
+    static constexpr uint32_t c_notFound = UINT32_MAX;
+
+    uint32_t Insert(const SamplerKey& key, bool* added = nullptr);
+    uint32_t Find(const SamplerKey& key) const;
+
+    const SamplerKey& GetKey(uint32_t index) const { return m_keys[index]; }
+    uint32_t GetCount() const { return static_cast<uint32_t>(m_keys.size()); }
+    SamplerTableStats GetStats() const;
+
+    void Clear();
+
+private:
+    std::unordered_map<SamplerKey, uint32_t, SamplerKeyHash> m_indices;
+    std::vector<SamplerKey> m_keys;     // normalized, by index
+    uint64_t m_lookups = 0;
+    uint64_t m_hits = 0;
+};
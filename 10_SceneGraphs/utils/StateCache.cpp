@@ -0,0 +1,171 @@
+#include "StateCache.h"
+
+/// @brief Change where the calls go. Forgets everything that is bound.
+void StateCache::SetSink(StateCommandSink* sink)
+{
+    m_sink = sink;
+    Invalidate();
+}
+
+/// @brief Start counting a new frame, and forget what is bound: the device context gets cleared at
+/// the end of every frame.
+void StateCache::BeginFrame()
+{
+    m_lastFrameStats = m_stats;
+    m_stats = StateCacheStats();
+    Invalidate();
+}
+
+/// @brief Forget everything that is bound, so the next call for every piece of state goes through
+void StateCache::Invalidate()
+{
+    m_topology.known = false;
+    m_inputLayout.known = false;
+    m_indexBuffer.known = false;
+    m_vertexShader.known = false;
+    m_pixelShader.known = false;
+
+    for (auto& binding : m_vertexBuffers)
+        binding.known = false;
+    for (auto& binding : m_vsConstantBuffers)
+        binding.known = false;
+    for (auto& binding : m_psConstantBuffers)
+        binding.known = false;
+    for (auto& binding : m_psShaderResources)
+        binding.known = false;
+    for (auto& binding : m_psSamplers)
+        binding.known = false;
+}
+
+/// @brief Record a new value for a piece of state
+/// @return true if the call needs to go through to the sink
+template <typename T>
+bool StateCache::Update(Binding<T>& binding, const T& value)
+{
+    if (binding.known && binding.value == value)
+    {
+        m_stats.elided++;
+        return false;
+    }
+
+    binding.value = value;
+    binding.known = true;
+    m_stats.issued++;
+    return true;
+}
+
+void StateCache::IASetPrimitiveTopology(uint32_t topology)
+{
+    if (Update(m_topology, topology))
+        m_sink->IASetPrimitiveTopology(topology);
+}
+
+void StateCache::IASetInputLayout(ID3D11InputLayout* inputLayout)
+{
+    if (Update(m_inputLayout, inputLayout))
+        m_sink->IASetInputLayout(inputLayout);
+}
+
+/// @brief Bind a vertex buffer. Slots past the ones the cache tracks always go through.
+void StateCache::IASetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset)
+{
+    if (slot >= VertexBufferSlots)
+    {
+        m_stats.issued++;
+        m_sink->IASetVertexBuffer(slot, buffer, stride, offset);
+        return;
+    }
+
+    if (Update(m_vertexBuffers[slot], VertexBufferBinding{ buffer, stride, offset }))
+        m_sink->IASetVertexBuffer(slot, buffer, stride, offset);
+}
+
+void StateCache::IASetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset)
+{
+    if (Update(m_indexBuffer, IndexBufferBinding{ buffer, format, offset }))
+        m_sink->IASetIndexBuffer(buffer, format, offset);
+}
+
+void StateCache::VSSetShader(ID3D11VertexShader* shader)
+{
+    if (Update(m_vertexShader, shader))
+        m_sink->VSSetShader(shader);
+}
+
+void StateCache::PSSetShader(ID3D11PixelShader* shader)
+{
+    if (Update(m_pixelShader, shader))
+        m_sink->PSSetShader(shader);
+}
+
+void StateCache::VSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer)
+{
+    VSSetConstantBuffer(slot, ConstantBufferSlice{ buffer, 0, 0 });
+}
+
+/// @brief Bind part of a constant buffer. Slices of the same buffer at different offsets are
+/// different bindings, so only binding the exact same slice again is dropped.
+void StateCache::VSSetConstantBuffer(uint32_t slot, const ConstantBufferSlice& slice)
+{
+    if (slot >= ConstantBufferSlots)
+    {
+        m_stats.issued++;
+        m_sink->VSSetConstantBuffer(slot, slice);
+        return;
+    }
+
+    if (Update(m_vsConstantBuffers[slot], slice))
+        m_sink->VSSetConstantBuffer(slot, slice);
+}
+
+void StateCache::PSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer)
+{
+    if (slot >= ConstantBufferSlots)
+    {
+        m_stats.issued++;
+        m_sink->PSSetConstantBuffer(slot, buffer);
+        return;
+    }
+
+    if (Update(m_psConstantBuffers[slot], buffer))
+        m_sink->PSSetConstantBuffer(slot, buffer);
+}
+
+void StateCache::PSSetShaderResource(uint32_t slot, ID3D11ShaderResourceView* view)
+{
+    if (slot >= ShaderResourceSlots)
+    {
+        m_stats.issued++;
+        m_sink->PSSetShaderResource(slot, view);
+        return;
+    }
+
+    if (Update(m_psShaderResources[slot], view))
+        m_sink->PSSetShaderResource(slot, view);
+}
+
+void StateCache::PSSetSampler(uint32_t slot, ID3D11SamplerState* sampler)
+{
+    if (slot >= SamplerSlots)
+    {
+        m_stats.issued++;
+        m_sink->PSSetSampler(slot, sampler);
+        return;
+    }
+
+    if (Update(m_psSamplers[slot], sampler))
+        m_sink->PSSetSampler(slot, sampler);
+}
+
+/// @brief Draws always go through; they are only counted
+void StateCache::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+    m_stats.draws++;
+    m_sink->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void StateCache::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    m_stats.draws++;
+    m_sink->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
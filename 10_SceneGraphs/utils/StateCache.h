@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Only pointers to these are ever stored, so the cache doesn't need the D3D11 headers
+struct ID3D11Buffer;
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+
+/// @brief A range of a constant buffer, counted in 16 byte constants. A count of 0 binds the whole buffer.
+struct ConstantBufferSlice
+{
+    ID3D11Buffer* buffer = nullptr;
+    uint32_t firstConstant = 0;
+    uint32_t constantCount = 0;
+
+    bool operator==(const ConstantBufferSlice& other) const
+    {
+        return buffer == other.buffer && firstConstant == other.firstConstant && constantCount == other.constantCount;
+    }
+};
+
+/// @brief Where the StateCache sends the calls that do change state. The D3D11 implementation
+/// forwards them to a device context; anything else (a recorder, a null sink) can stand in for it.
+///
+/// Topologies and formats are passed as their D3D11 enum values.
+class StateCommandSink
+{
+public:
+    virtual ~StateCommandSink() = default;
+
+    virtual void IASetPrimitiveTopology(uint32_t topology) = 0;
+    virtual void IASetInputLayout(ID3D11InputLayout* inputLayout) = 0;
+    virtual void IASetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset) = 0;
+    virtual void IASetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset) = 0;
+    virtual void VSSetShader(ID3D11VertexShader* shader) = 0;
+    virtual void PSSetShader(ID3D11PixelShader* shader) = 0;
+    virtual void VSSetConstantBuffer(uint32_t slot, const ConstantBufferSlice& slice) = 0;
+    virtual void PSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer) = 0;
+    virtual void PSSetShaderResource(uint32_t slot, ID3D11ShaderResourceView* view) = 0;
+    virtual void PSSetSampler(uint32_t slot, ID3D11SamplerState* sampler) = 0;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+    virtual void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) = 0;
+};
+
+/// @brief Counters for the current frame
+struct StateCacheStats
+{
+    size_t issued = 0;  // state calls passed on to the sink
+    size_t elided = 0;  // state calls dropped because the state was already bound
+    size_t draws = 0;
+};
+
+/// @brief Remembers the pipeline state that is currently bound, and drops any call that would bind
+/// the same thing again.
+///
+/// Every bind in the renderer goes through here. The cache assumes nothing else touches the device
+/// context between calls; when something does (ImGui, ClearState at the end of the frame), call
+/// Invalidate, or BeginFrame at the start of the next frame.
+class StateCache
+{
+public:
+    static constexpr uint32_t ConstantBufferSlots = 14;
+    static constexpr uint32_t VertexBufferSlots = 16;
+    static constexpr uint32_t ShaderResourceSlots = 16;
+    static constexpr uint32_t SamplerSlots = 16;
+
+    StateCache() = default;
+    explicit StateCache(StateCommandSink* sink) : m_sink(sink) {}
+
+    void SetSink(StateCommandSink* sink);
+
+    void BeginFrame();
+    void Invalidate();
+
+    void IASetPrimitiveTopology(uint32_t topology);
+    void IASetInputLayout(ID3D11InputLayout* inputLayout);
+    void IASetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset);
+    void IASetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset);
+    void VSSetShader(ID3D11VertexShader* shader);
+    void PSSetShader(ID3D11PixelShader* shader);
+    void VSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer);
+    void VSSetConstantBuffer(uint32_t slot, const ConstantBufferSlice& slice);
+    void PSSetConstantBuffer(uint32_t slot, ID3D11Buffer* buffer);
+    void PSSetShaderResource(uint32_t slot, ID3D11ShaderResourceView* view);
+    void PSSetSampler(uint32_t slot, ID3D11SamplerState* sampler);
+
+    void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+    void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance);
+
+    const StateCacheStats& GetStats() const { return m_stats; }
+    const StateCacheStats& GetLastFrameStats() const { return m_lastFrameStats; }
+
+private:
+    // A piece of bound state, and whether the cache knows what it is
+    template <typename T>
+    struct Binding
+    {
+        T value = {};
+        bool known = false;
+    };
+
+    template <typename T>
+    bool Update(Binding<T>& binding, const T& value);
+
+    struct VertexBufferBinding
+    {
+        ID3D11Buffer* buffer;
+        uint32_t stride;
+        uint32_t offset;
+
+        bool operator==(const VertexBufferBinding& other) const
+        {
+            return buffer == other.buffer && stride == other.stride && offset == other.offset;
+        }
+    };
+
+    struct IndexBufferBinding
+    {
+        ID3D11Buffer* buffer;
+        uint32_t format;
+        uint32_t offset;
+
+        bool operator==(const IndexBufferBinding& other) const
+        {
+            return buffer == other.buffer && format == other.format && offset == other.offset;
+        }
+    };
+
+    StateCommandSink* m_sink = nullptr;
+
+    Binding<uint32_t> m_topology;
+    Binding<ID3D11InputLayout*> m_inputLayout;
+    Binding<VertexBufferBinding> m_vertexBuffers[VertexBufferSlots];
+    Binding<IndexBufferBinding> m_indexBuffer;
+    Binding<ID3D11VertexShader*> m_vertexShader;
+    Binding<ID3D11PixelShader*> m_pixelShader;
+    Binding<ConstantBufferSlice> m_vsConstantBuffers[ConstantBufferSlots];
+    Binding<ID3D11Buffer*> m_psConstantBuffers[ConstantBufferSlots];
+    Binding<ID3D11ShaderResourceView*> m_psShaderResources[ShaderResourceSlots];
+    Binding<ID3D11SamplerState*> m_psSamplers[SamplerSlots];
+
+    StateCacheStats m_stats;
+    StateCacheStats m_lastFrameStats;
+};
@@ -0,0 +1,133 @@
+#include "TextureArrayPlanner.h"
+
+#include <algorithm>
+
+TextureArrayPlanner::TextureArrayPlanner(const TextureArrayLimits& limits)
+    : m_limits(limits)
+{
+}
+
+/// @brief Find a slice for a texture: one released in an array of its shape, else one never used,
+/// else in an array of its shape grown to make room, else in a new array
+TextureArrayPlacement TextureArrayPlanner::Place(const TextureShape& shape)
+{
+    TextureArrayPlacement placement;
+
+    for (uint32_t index = 0; index < m_arrays.size(); index++)
+    {
+        auto& array = m_arrays[index];
+        if (array.capacity == 0 || array.shape != shape)
+            continue;
+
+        if (!array.freeSlices.empty())
+        {
+            placement.slot = TextureArraySlot{ index, array.freeSlices.back() };
+            array.freeSlices.pop_back();
+            array.used++;
+            return placement;
+        }
+        if (array.highWater < array.capacity)
+        {
+            placement.slot = TextureArraySlot{ index, array.highWater++ };
+            array.used++;
+            return placement;
+        }
+    }
+
+    // Every array of the shape is full: grow one, if one can be
+    uint32_t limit = GetSliceLimit(shape);
+    for (uint32_t index = 0; index < m_arrays.size(); index++)
+    {
+        auto& array = m_arrays[index];
+        if (array.capacity == 0 || array.shape != shape || array.capacity >= limit)
+            continue;
+
+        placement.grown = true;
+        placement.previousCapacity = array.capacity;
+        m_grows++;
+        m_grownBytes += array.highWater * shape.sliceBytes;
+
+        array.capacity = std::min(limit, array.capacity * 2);
+        placement.slot = TextureArraySlot{ index, array.highWater++ };
+        array.used++;
+        return placement;
+    }
+
+    // A new array, in the place of one that has emptied if there is one
+    uint32_t index = 0;
+    while (index < m_arrays.size() && m_arrays[index].capacity != 0)
+    {
+        index++;
+    }
+    if (index == m_arrays.size())
+        m_arrays.emplace_back();
+
+    auto& array = m_arrays[index];
+    array.shape = shape;
+    array.capacity = std::min(limit, std::max(m_limits.initialSlices, 1u));
+    array.used = 1;
+    array.highWater = 1;
+    array.freeSlices.clear();
+
+    placement.created = true;
+    placement.slot = TextureArraySlot{ index, 0 };
+    return placement;
+}
+
+/// @brief Give a slice back. An array left with nothing in it is let go.
+void TextureArrayPlanner::Release(TextureArraySlot slot)
+{
+    if (!slot.IsValid() || slot.array >= m_arrays.size())
+        return;
+
+    auto& array = m_arrays[slot.array];
+    if (array.used == 0 || slot.slice >= array.highWater
+        || std::find(array.freeSlices.begin(), array.freeSlices.end(), slot.slice) != array.freeSlices.end())
+        return;
+
+    array.used--;
+    if (array.used == 0)
+    {
+        array.capacity = 0;
+        array.highWater = 0;
+        array.freeSlices.clear();
+        return;
+    }
+    array.freeSlices.push_back(slot.slice);
+}
+
+/// @brief The most slices an array of a shape may have: as many as fit in the byte limit, within
+/// the slice limit, and never less than one
+uint32_t TextureArrayPlanner::GetSliceLimit(const TextureShape& shape) const
+{
+    uint64_t slices = m_limits.maxSlices;
+    if (shape.sliceBytes > 0)
+        slices = std::min<uint64_t>(slices, m_limits.maxArrayBytes / shape.sliceBytes);
+    return static_cast<uint32_t>(std::max<uint64_t>(slices, 1));
+}
+
+TextureArrayPlannerStats TextureArrayPlanner::GetStats() const
+{
+    TextureArrayPlannerStats stats;
+    for (const auto& array : m_arrays)
+    {
+        if (array.capacity == 0)
+            continue;
+
+        stats.arrays++;
+        stats.textures += array.used;
+        stats.capacitySlices += array.capacity;
+        stats.usedBytes += array.used * array.shape.sliceBytes;
+        stats.capacityBytes += array.capacity * array.shape.sliceBytes;
+    }
+    stats.grows = m_grows;
+    stats.grownBytes = m_grownBytes;
+    return stats;
+}
+
+void TextureArrayPlanner::Clear()
+{
+    m_arrays.clear();
+    m_grows = 0;
+    m_grownBytes = 0;
+}
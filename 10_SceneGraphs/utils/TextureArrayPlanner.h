@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr uint32_t c_maxTextureArraySlices = 2048;     // D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+
+/// @brief What a texture has to match exactly to share an array with others
+struct TextureShape
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipCount = 0;
+    uint32_t format = 0;        // the DXGI_FORMAT value
+    uint64_t sliceBytes = 0;    // every mip of one texture
+
+    bool operator==(const TextureShape& other) const
+    {
+        return width == other.width && height == other.height && mipCount == other.mipCount && format == other.format && sliceBytes == other.sliceBytes;
+    }
+    bool operator!=(const TextureShape& other) const { return !(*this == other); }
+};
+
+/// @brief Where a texture is: which array, and which slice of it
+struct TextureArraySlot
+{
+    static constexpr uint32_t c_noArray = UINT32_MAX;
+
+    uint32_t array = c_noArray;
+    uint32_t slice = 0;
+
+    bool IsValid() const { return array != c_noArray; }
+};
+
+/// @brief How big arrays may get
+struct TextureArrayLimits
+{
+    uint32_t initialSlices = 4;                 // an array's capacity when it is first made; it doubles from there
+    uint32_t maxSlices = c_maxTextureArraySlices;
+    uint64_t maxArrayBytes = 256ull << 20;      // an array is capped at this many bytes, but always holds at least one texture
+};
+
+/// @brief An array as the planner has laid it out
+struct PlannedTextureArray
+{
+    TextureShape shape;
+    uint32_t capacity = 0;          // slices; 0 once the array has emptied and been let go
+    uint32_t used = 0;
+    uint32_t highWater = 0;         // slices below this have been handed out; the rest have never been
+    std::vector<uint32_t> freeSlices;   // below highWater, handed out and released since
+};
+
+/// @brief What Place did, so the caller can make the GPU side match
+struct TextureArrayPlacement
+{
+    TextureArraySlot slot;
+    bool created = false;           // the array is new, or was empty and has to be made again
+    bool grown = false;             // the array's capacity went up; its slices have to be copied to a bigger one
+    uint32_t previousCapacity = 0;  // before it grew
+};
+
+/// @brief Counters from a TextureArrayPlanner
+struct TextureArrayPlannerStats
+{
+    uint32_t arrays = 0;            // with a capacity
+    uint32_t textures = 0;          // in a slice
+    uint32_t capacitySlices = 0;    // over every array
+    uint64_t usedBytes = 0;
+    uint64_t capacityBytes = 0;
+    uint64_t grows = 0;
+    uint64_t grownBytes = 0;        // slices copied into bigger arrays, over every grow
+};
+
+/// @brief Lays textures out in texture arrays, so draws of different textures can share one
+/// binding and pick theirs by slice.
+///
+/// Textures of the same shape (size, mip count and format) go in the same array. Arrays start
+/// small and double whenever one is full, up to the limits; once an array can't grow, another of
+/// the same shape is started. Released slices are handed out again before the array grows, and an
+/// array that empties is let go, keeping its index for the next texture of its shape. Arrays keep
+/// their indices, so a slot stays valid however its array grows.
+///
+/// Only plans; the caller creates and copies the arrays. Nothing in here touches the GPU.
+class TextureArrayPlanner
+{
+public:
+    explicit TextureArrayPlanner(const TextureArrayLimits& limits = TextureArrayLimits());
+
+    TextureArrayPlacement Place(const TextureShape& shape);
+    void Release(TextureArraySlot slot);
+
+    uint32_t GetSliceLimit(const TextureShape& shape) const;
+    const PlannedTextureArray& GetArray(uint32_t array) const { return m_arrays[array]; }
+    uint32_t GetArrayCount() const { return static_cast<uint32_t>(m_arrays.size()); }
+    const TextureArrayLimits& GetLimits() const { return m_limits; }
+    TextureArrayPlannerStats GetStats() const;
+
+    void Clear();
+
+private:
+    TextureArrayLimits m_limits;
+    std::vector<PlannedTextureArray> m_arrays;
+    uint64_t m_grows = 0;
+    uint64_t m_grownBytes = 0;
+};
@@ -0,0 +1,302 @@
+#include "TextureMips.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define TEXTURE_MIPS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+    constexpr int c_kaiserTaps = 8;             // source texels under each destination texel, along one axis
+    constexpr float c_kaiserRadius = 2.0f;      // in destination texels
+    constexpr float c_kaiserAlpha = 4.0f;       // the window's shape: higher trades sharpness for less ringing
+    constexpr uint32_t c_encodeTableSize = 16384;
+
+    /// @brief An image of linear float RGBA texels, as levels are filtered
+    struct FloatImage
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<float> texels;  // 4 floats a texel, top row first
+
+        float* Row(uint32_t y) { return texels.data() + static_cast<size_t>(y) * width * 4; }
+        const float* Row(uint32_t y) const { return texels.data() + static_cast<size_t>(y) * width * 4; }
+    };
+
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    /// @brief 8 bit sRGB to linear, and linear to 8 bit sRGB finely enough that every step of the
+    /// darkest values, where the curve is steepest, still lands on the right byte
+    struct ColourTables
+    {
+        float decode[256];
+        uint8_t encode[c_encodeTableSize];
+
+        ColourTables()
+        {
+            for (int value = 0; value < 256; value++)
+            {
+                decode[value] = SrgbToLinear(value / 255.0f);
+            }
+            for (uint32_t index = 0; index < c_encodeTableSize; index++)
+            {
+                float linear = (index + 0.5f) / c_encodeTableSize;
+                encode[index] = static_cast<uint8_t>(std::lround(LinearToSrgb(linear) * 255.0f));
+            }
+        }
+    };
+
+    const ColourTables& GetColourTables()
+    {
+        static const ColourTables tables;
+        return tables;
+    }
+
+    void ToFloat(const DecodedImage& image, bool srgb, FloatImage& result)
+    {
+        const auto& tables = GetColourTables();
+        result.width = image.width;
+        result.height = image.height;
+        result.texels.resize(image.pixels.size());
+        for (size_t index = 0; index < image.pixels.size(); index += 4)
+        {
+            for (size_t channel = 0; channel < 3; channel++)
+            {
+                uint8_t value = image.pixels[index + channel];
+                result.texels[index + channel] = srgb ? tables.decode[value] : value / 255.0f;
+            }
+            result.texels[index + 3] = image.pixels[index + 3] / 255.0f;
+        }
+    }
+
+    uint8_t ToByte(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    void ToBytes(const FloatImage& image, bool srgb, DecodedImage& result)
+    {
+        const auto& tables = GetColourTables();
+        result.width = image.width;
+        result.height = image.height;
+        result.pixels.resize(image.texels.size());
+        for (size_t index = 0; index < image.texels.size(); index += 4)
+        {
+            for (size_t channel = 0; channel < 3; channel++)
+            {
+                float value = std::clamp(image.texels[index + channel], 0.0f, 1.0f);
+                result.pixels[index + channel] = srgb
+                    ? tables.encode[std::min(static_cast<uint32_t>(value * c_encodeTableSize), c_encodeTableSize - 1)]
+                    : ToByte(value);
+            }
+            result.pixels[index + 3] = ToByte(image.texels[index + 3]);
+        }
+    }
+
+    /// @brief destination = the sum of each source texel times its weight, all four channels at once
+    void WeightedSum(const float* const* sources, const float* weights, int count, float* destination)
+    {
+#ifdef TEXTURE_MIPS_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (int tap = 0; tap < count; tap++)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(sources[tap]), _mm_set1_ps(weights[tap])));
+        }
+        _mm_storeu_ps(destination, sum);
+#else
+        float sum[4] = {};
+        for (int tap = 0; tap < count; tap++)
+        {
+            for (int channel = 0; channel < 4; channel++)
+            {
+                sum[channel] += sources[tap][channel] * weights[tap];
+            }
+        }
+        std::copy(sum, sum + 4, destination);
+#endif
+    }
+
+    void BoxDownsample(const FloatImage& source, FloatImage& destination)
+    {
+        static const float weights[4] = { 0.25f, 0.25f, 0.25f, 0.25f };
+        for (uint32_t y = 0; y < destination.height; y++)
+        {
+            const float* row0 = source.Row(std::min(2 * y, source.height - 1));
+            const float* row1 = source.Row(std::min(2 * y + 1, source.height - 1));
+            float* out = destination.Row(y);
+            for (uint32_t x = 0; x < destination.width; x++)
+            {
+                uint32_t x0 = std::min(2 * x, source.width - 1) * 4;
+                uint32_t x1 = std::min(2 * x + 1, source.width - 1) * 4;
+                const float* texels[4] = { row0 + x0, row0 + x1, row1 + x0, row1 + x1 };
+                WeightedSum(texels, weights, 4, out + x * 4);
+            }
+        }
+    }
+
+    /// @brief The zeroth order modified Bessel function of the first kind, for the Kaiser window
+    double BesselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    /// @brief The weights of the source texels 2x - 3 to 2x + 4 under destination texel x, which
+    /// are the same for every x when halving
+    void KaiserWeights(float weights[c_kaiserTaps])
+    {
+        const double pi = 3.14159265358979323846;
+        double total = 0.0;
+        double raw[c_kaiserTaps];
+        for (int tap = 0; tap < c_kaiserTaps; tap++)
+        {
+            // Distance from the destination texel's centre, in destination texels
+            double t = (tap - c_kaiserTaps / 2 + 0.5) / 2.0;
+            double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+            double ratio = t / c_kaiserRadius;
+            double window = ratio * ratio < 1.0 ? BesselI0(c_kaiserAlpha * std::sqrt(1.0 - ratio * ratio)) / BesselI0(c_kaiserAlpha) : 0.0;
+            raw[tap] = sinc * window;
+            total += raw[tap];
+        }
+        for (int tap = 0; tap < c_kaiserTaps; tap++)
+        {
+            weights[tap] = static_cast<float>(raw[tap] / total);
+        }
+    }
+
+    uint32_t Address(int64_t coordinate, uint32_t size, bool wrap)
+    {
+        if (wrap)
+            return static_cast<uint32_t>(((coordinate % size) + size) % size);
+        return static_cast<uint32_t>(std::clamp<int64_t>(coordinate, 0, size - 1));
+    }
+
+    /// @brief Halve the image along one axis at a time, horizontally and then vertically
+    void KaiserDownsample(const FloatImage& source, bool wrap, FloatImage& scratch, FloatImage& destination)
+    {
+        float weights[c_kaiserTaps];
+        KaiserWeights(weights);
+        const float* texels[c_kaiserTaps];
+
+        // A side that is already 1 texel is kept, as every tap lands on the one texel
+        scratch.width = destination.width;
+        scratch.height = source.height;
+        scratch.texels.resize(static_cast<size_t>(scratch.width) * scratch.height * 4);
+        for (uint32_t y = 0; y < source.height; y++)
+        {
+            const float* row = source.Row(y);
+            float* out = scratch.Row(y);
+            for (uint32_t x = 0; x < scratch.width; x++)
+            {
+                for (int tap = 0; tap < c_kaiserTaps; tap++)
+                {
+                    texels[tap] = row + Address(2 * static_cast<int64_t>(x) + tap - c_kaiserTaps / 2 + 1, source.width, wrap) * 4;
+                }
+                WeightedSum(texels, weights, c_kaiserTaps, out + x * 4);
+            }
+        }
+
+        for (uint32_t y = 0; y < destination.height; y++)
+        {
+            const float* rows[c_kaiserTaps];
+            for (int tap = 0; tap < c_kaiserTaps; tap++)
+            {
+                rows[tap] = scratch.Row(Address(2 * static_cast<int64_t>(y) + tap - c_kaiserTaps / 2 + 1, scratch.height, wrap));
+            }
+
+            float* out = destination.Row(y);
+            for (uint32_t x = 0; x < destination.width; x++)
+            {
+                for (int tap = 0; tap < c_kaiserTaps; tap++)
+                {
+                    texels[tap] = rows[tap] + x * 4;
+                }
+                WeightedSum(texels, weights, c_kaiserTaps, out + x * 4);
+            }
+        }
+    }
+}
+
+/// @brief How many levels a full mip chain has, the image itself included
+uint32_t GetMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        count++;
+    }
+    return count;
+}
+
+/// @brief Make the full mip chain of an image
+/// @param levels Set to every level, finest first; the first is a copy of the source
+void GenerateMips(const DecodedImage& source, const MipOptions& options, std::vector<DecodedImage>& levels)
+{
+    levels.clear();
+    if (source.IsEmpty())
+        return;
+
+    levels.push_back(source);
+    FillMipChain(options, levels);
+}
+
+/// @brief Make the rest of the mip chain of the image in the first level. Levels after it that are
+/// there already are written over, keeping their buffers, so they can come from an ImagePool.
+/// @param levels Has the image first; set to every level, finest first
+void FillMipChain(const MipOptions& options, std::vector<DecodedImage>& levels)
+{
+    if (levels.empty() || levels[0].IsEmpty())
+        return;
+
+    uint32_t count = GetMipCount(levels[0].width, levels[0].height);
+    levels.resize(count);
+
+    FloatImage current;
+    FloatImage next;
+    FloatImage scratch;
+    ToFloat(levels[0], options.srgb, current);
+    for (uint32_t level = 1; level < count; level++)
+    {
+        next.width = std::max(1u, current.width / 2);
+        next.height = std::max(1u, current.height / 2);
+        next.texels.resize(static_cast<size_t>(next.width) * next.height * 4);
+
+        if (options.filter == MipFilter::Kaiser)
+            KaiserDownsample(current, options.wrap, scratch, next);
+        else
+            BoxDownsample(current, next);
+
+        ToBytes(next, options.srgb, levels[level]);
+        std::swap(current, next);
+    }
+}
+
+/// @brief Bytes of every level of a full RGBA8 mip chain
+size_t GetMipChainBytes(uint32_t width, uint32_t height)
+{
+    size_t bytes = 0;
+    for (uint32_t level = 0; level < GetMipCount(width, height); level++)
+    {
+        bytes += static_cast<size_t>(std::max(1u, width >> level)) * std::max(1u, height >> level) * 4;
+    }
+    return bytes;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ImageDecoder.h"
+
+/// Mip chain generation for 8 bit RGBA images, on the CPU. Each level is half the size of the one
+/// before, rounded down but never below 1, down to 1x1, which is what D3D expects of a full chain.
+///
+/// Levels are filtered from the previous one at full float precision, and only rounded to 8 bits
+/// on the way out, so rounding doesn't build up down the chain. Colour is filtered in linear light
+/// when the image is sRGB encoded, which keeps bright detail from darkening as it shrinks; alpha
+/// is always linear. The inner loops work on a whole RGBA texel at a time, with SSE where the
+/// compiler has it. This header is free of Windows and D3D headers, so the cooker can use it.
+
+enum class MipFilter
+{
+    Box,    // average of each 2x2 square: fast, but soft and prone to aliasing
+    Kaiser  // 8 tap windowed sinc: sharper, with far less aliasing, for a few times the cost
+};
+
+struct MipOptions
+{
+    MipFilter filter = MipFilter::Kaiser;
+    bool srgb = true;   // colour is sRGB encoded, as photos and painted textures are
+    bool wrap = true;   // the filter wraps around the edges, as for a tiling texture, rather than clamping
+};
+
+uint32_t GetMipCount(uint32_t width, uint32_t height);
+size_t GetMipChainBytes(uint32_t width, uint32_t height);
+
+void GenerateMips(const DecodedImage& source, const MipOptions& options, std::vector<DecodedImage>& levels);
+void FillMipChain(const MipOptions& options, std::vector<DecodedImage>& levels);
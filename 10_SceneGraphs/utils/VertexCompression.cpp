@@ -0,0 +1,216 @@
+#include "VertexCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr float c_unorm16Max = 65535.0f;
+    constexpr float c_snorm16Max = 32767.0f;
+
+    float SignNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    int16_t ToSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * c_snorm16Max));
+    }
+
+    /// @brief The conversion DXGI_FORMAT_R16G16_SNORM does when the vertex is fetched
+    float FromSnorm16(int16_t value)
+    {
+        return std::max(value / c_snorm16Max, -1.0f);
+    }
+}
+
+/// @brief Work out the quantization for a set of vertices from their bounding box, so the full
+/// 16 bit range covers the mesh on every axis
+/// @param vertices The first three floats of each vertex are its position
+/// @param stride Size of a vertex, in bytes
+PositionQuantization ComputePositionQuantization(const void* vertices, size_t vertexCount, size_t stride)
+{
+    PositionQuantization quantization;
+    if (vertexCount == 0)
+        return quantization;
+
+    float minimum[3] = { INFINITY, INFINITY, INFINITY };
+    float maximum[3] = { -INFINITY, -INFINITY, -INFINITY };
+    const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        float position[3];
+        std::memcpy(position, bytes + vertex * stride, sizeof(position));
+        for (int axis = 0; axis < 3; axis++)
+        {
+            minimum[axis] = std::min(minimum[axis], position[axis]);
+            maximum[axis] = std::max(maximum[axis], position[axis]);
+        }
+    }
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        quantization.offset[axis] = minimum[axis];
+        quantization.scale[axis] = maximum[axis] - minimum[axis];
+    }
+    return quantization;
+}
+
+/// @brief Quantize a position to 16 bits an axis. Positions outside the quantization's box are
+/// clamped to it. The error is at most half a step, scale / 65535 / 2, on each axis.
+void QuantizePosition(const float position[3], const PositionQuantization& quantization, uint16_t encoded[4])
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float unit = 0.0f;
+        if (quantization.scale[axis] > 0.0f)
+            unit = std::clamp((position[axis] - quantization.offset[axis]) / quantization.scale[axis], 0.0f, 1.0f);
+        encoded[axis] = static_cast<uint16_t>(std::lround(unit * c_unorm16Max));
+    }
+    encoded[3] = 0;
+}
+
+/// @brief Expand a quantized position the way the vertex shaders do
+void DequantizePosition(const uint16_t encoded[4], const PositionQuantization& quantization, float position[3])
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        position[axis] = quantization.offset[axis] + (encoded[axis] / c_unorm16Max) * quantization.scale[axis];
+    }
+}
+
+/// @brief Encode a unit normal by projecting it onto an octahedron and unfolding that into a
+/// square. Two 16 bit components are good for about 0.004 of a degree at worst. A zero length
+/// normal comes back as +Z.
+void EncodeOctahedralNormal(const float normal[3], int16_t encoded[2])
+{
+    float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (!(length > 0.0f))
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    if (normal[2] < 0.0f)
+    {
+        // Fold the lower half of the octahedron out over the corners of the square
+        float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+        float foldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    encoded[0] = ToSnorm16(x);
+    encoded[1] = ToSnorm16(y);
+}
+
+/// @brief Decode an octahedral normal the way the vertex shaders do
+void DecodeOctahedralNormal(const int16_t encoded[2], float normal[3])
+{
+    float x = FromSnorm16(encoded[0]);
+    float y = FromSnorm16(encoded[1]);
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    float fold = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -fold : fold;
+    y += y >= 0.0f ? -fold : fold;
+
+    float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+/// @brief Convert to an IEEE half, rounding to nearest even like the hardware does. Values past
+/// the largest half become infinity and tiny ones become half denormals or zero.
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    // Infinity stays infinity and NaN stays a (quiet) NaN
+    if (magnitude >= 0x7f800000)
+        return static_cast<uint16_t>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+
+    // 65520 and up round past 65504, the largest half
+    if (magnitude >= 0x477ff000)
+        return static_cast<uint16_t>(sign | 0x7c00);
+
+    // Below 2^-14 the half is denormal, in steps of 2^-24
+    if (magnitude < 0x38800000)
+    {
+        if (magnitude < 0x33000000)
+            return static_cast<uint16_t>(sign);
+
+        uint32_t exponent = magnitude >> 23;
+        uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+        uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Rebias the exponent from 127 to 15 and drop 13 bits of mantissa. A carry out of the
+    // mantissa when rounding correctly bumps the exponent.
+    uint32_t half = (magnitude - 0x38000000) >> 13;
+    uint32_t remainder = magnitude & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    if (exponent == 0)
+    {
+        float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void PackVertices(const VertexNormal* vertices, size_t vertexCount, const PositionQuantization& quantization, PackedVertexNormal* packed)
+{
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        const VertexNormal& source = vertices[vertex];
+        QuantizePosition(&source.x, quantization, packed[vertex].position);
+        EncodeOctahedralNormal(&source.nx, packed[vertex].normal);
+    }
+}
+
+void PackVertices(const VertexNormalUV* vertices, size_t vertexCount, const PositionQuantization& quantization, PackedVertexNormalUV* packed)
+{
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        const VertexNormalUV& source = vertices[vertex];
+        QuantizePosition(&source.x, quantization, packed[vertex].position);
+        EncodeOctahedralNormal(&source.nx, packed[vertex].normal);
+        packed[vertex].uv[0] = FloatToHalf(source.u);
+        packed[vertex].uv[1] = FloatToHalf(source.v);
+    }
+}
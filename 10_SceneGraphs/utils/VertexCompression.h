@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Vertex formats for meshes, and the encoding between them.
+///
+/// Loaders build vertices at full float precision (VertexNormal, VertexNormalUV), which is what
+/// the optimizer, the splitter and the bounds work on. Just before upload they are packed:
+///   - positions become 16 bit unorms relative to the mesh's bounding box, expanded in the vertex
+///     shader with the scale and offset from the mesh's constant buffer
+///   - normals are octahedral encoded into two 16 bit snorms
+///   - texture coordinates become half floats
+/// The material colour isn't part of the vertex at all any more; it lives in the same constant
+/// buffer as the position scale and offset.
+///
+/// This header is shared with the cooker, so it must stay free of Windows and D3D headers.
+
+struct VertexNormal
+{
+    float x;
+    float y;
+    float z;
+    float nx;
+    float ny;
+    float nz;
+};
+
+struct VertexNormalUV
+{
+    float x;
+    float y;
+    float z;
+    float nx;
+    float ny;
+    float nz;
+    float u;
+    float v;
+};
+
+/// @brief What the GPU reads for a VertexNormal: 12 bytes rather than 40 with the colour
+struct PackedVertexNormal
+{
+    uint16_t position[4];   // R16G16B16A16_UNORM, w unused
+    int16_t normal[2];      // R16G16_SNORM, octahedral
+};
+static_assert(sizeof(PackedVertexNormal) == 12, "PackedVertexNormal has to match IALayout_PackedVertexNormal");
+
+/// @brief What the GPU reads for a VertexNormalUV: 16 bytes rather than 48 with the colour
+struct PackedVertexNormalUV
+{
+    uint16_t position[4];   // R16G16B16A16_UNORM, w unused
+    int16_t normal[2];      // R16G16_SNORM, octahedral
+    uint16_t uv[2];         // R16G16_FLOAT
+};
+static_assert(sizeof(PackedVertexNormalUV) == 16, "PackedVertexNormalUV has to match IALayout_PackedVertexNormalUV");
+
+/// @brief How to expand a quantized position: position = offset + unorm * scale
+struct PositionQuantization
+{
+    float scale[3] = { 0.0f, 0.0f, 0.0f };
+    float offset[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+PositionQuantization ComputePositionQuantization(const void* vertices, size_t vertexCount, size_t stride);
+
+void QuantizePosition(const float position[3], const PositionQuantization& quantization, uint16_t encoded[4]);
+void DequantizePosition(const uint16_t encoded[4], const PositionQuantization& quantization, float position[3]);
+
+void EncodeOctahedralNormal(const float normal[3], int16_t encoded[2]);
+void DecodeOctahedralNormal(const int16_t encoded[2], float normal[3]);
+
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+void PackVertices(const VertexNormal* vertices, size_t vertexCount, const PositionQuantization& quantization, PackedVertexNormal* packed);
+void PackVertices(const VertexNormalUV* vertices, size_t vertexCount, const PositionQuantization& quantization, PackedVertexNormalUV* packed);
@@ -0,0 +1,337 @@
+// MeshCooker: converts anything assimp can read (FBX, OBJ, ...) into the cooked mesh format the
+// 10_SceneGraphs renderer maps and uploads directly. See CookedMesh.h for the layout.
+//
+// Usage: MeshCooker [--textured] [--no-optimize] [--no-lods] <source> [<output>]
+//
+// The triangles are grouped into a submesh per material. Each submesh's triangles are reordered for
+// the vertex cache and overdraw, and its vertices for fetch locality (see MeshOptimizer.h), unless
+// --no-optimize is given. Each submesh then gets simplified levels of detail (see MeshSimplifier.h),
+// unless --no-lods is given. The vertices are then packed to the formats in VertexCompression.h.
+//
+// The output defaults to the source path with a .wtgm extension. Mesh and TexturedMesh look for a
+// cooked file next to the asset they are asked to load, so cooking in place is all it takes.
+//
+// Only portable code is used so it builds outside Visual Studio as well, e.g. on Linux, with the
+// CMakeLists.txt next to this file.
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
+#include "VertexCompression.h"
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "Usage: MeshCooker [--textured] [--no-optimize] [--no-lods] <source> [<output>]\n"
+                  << "  --textured     write position, normal and uv vertices for TexturedMesh;\n"
+                  << "                 without it, position and normal vertices for Mesh\n"
+                  << "  --no-optimize  keep assimp's triangle and vertex order\n"
+                  << "  --no-lods      only write the full mesh, without simplified levels of detail\n";
+    }
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    /// @brief The scene with full precision vertices, before it is split and packed
+    struct SourceMesh
+    {
+        std::vector<VertexNormalUV> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+    };
+
+    /// @brief Same box and sphere as ComputeBounds in Culling.cpp, which can't be used here as it
+    /// needs DirectXMath
+    void ComputeBounds(const std::vector<VertexNormalUV>& vertices, CookedMeshData& mesh)
+    {
+        if (vertices.empty())
+            return;
+
+        float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (const auto& vertex : vertices)
+        {
+            const float* p = &vertex.x;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                minimum[axis] = std::min(minimum[axis], p[axis]);
+                maximum[axis] = std::max(maximum[axis], p[axis]);
+            }
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mesh.boundsCenter[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+            mesh.boundsExtents[axis] = maximum[axis] - mesh.boundsCenter[axis];
+        }
+
+        float radiusSquared = 0.0f;
+        for (const auto& vertex : vertices)
+        {
+            float x = vertex.x - mesh.boundsCenter[0];
+            float y = vertex.y - mesh.boundsCenter[1];
+            float z = vertex.z - mesh.boundsCenter[2];
+            radiusSquared = std::max(radiusSquared, x * x + y * y + z * z);
+        }
+        mesh.boundsRadius = std::sqrt(radiusSquared);
+    }
+
+    /// @brief Collect the materials, and merge all the meshes in the scene into one vertex and
+    /// index buffer, the way Mesh and TexturedMesh do when they load with assimp
+    bool ConvertScene(const aiScene* scene, bool textured, SourceMesh& source, CookedMeshData& mesh)
+    {
+        for (unsigned int materialIndex = 0; materialIndex < scene->mNumMaterials; materialIndex++)
+        {
+            auto material = scene->mMaterials[materialIndex];
+
+            CookedMaterial cooked = {};
+            aiColor3D diffuse(1.0f, 1.0f, 1.0f);
+            material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+            cooked.diffuse[0] = diffuse.r;
+            cooked.diffuse[1] = diffuse.g;
+            cooked.diffuse[2] = diffuse.b;
+
+            aiString texturePath;
+            if (material->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == aiReturn_SUCCESS)
+            {
+                if (texturePath.length >= sizeof(cooked.diffuseTexture))
+                {
+                    std::cerr << "Texture path is too long to cook: " << texturePath.C_Str() << "\n";
+                    return false;
+                }
+                std::memcpy(cooked.diffuseTexture, texturePath.C_Str(), texturePath.length + 1);
+            }
+            mesh.materials.push_back(cooked);
+        }
+
+        for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++)
+        {
+            auto sourceMesh = scene->mMeshes[meshIndex];
+            if (sourceMesh->mNormals == nullptr)
+                std::cerr << "Mesh " << meshIndex << " has no normals; using +Y\n";
+            if (textured && !sourceMesh->HasTextureCoords(0))
+                std::cerr << "Mesh " << meshIndex << " has no texture coordinates; using 0, 0\n";
+
+            // Every mesh's indices start at its own first vertex
+            uint32_t baseVertex = static_cast<uint32_t>(source.vertices.size());
+            source.vertices.reserve(source.vertices.size() + sourceMesh->mNumVertices);
+            for (unsigned int vertexIndex = 0; vertexIndex < sourceMesh->mNumVertices; vertexIndex++)
+            {
+                auto vertex = sourceMesh->mVertices[vertexIndex];
+                auto normal = sourceMesh->mNormals != nullptr ? sourceMesh->mNormals[vertexIndex] : aiVector3D(0.0f, 1.0f, 0.0f);
+                auto uv = textured && sourceMesh->HasTextureCoords(0) ? sourceMesh->mTextureCoords[0][vertexIndex] : aiVector3D();
+                source.vertices.push_back(VertexNormalUV{ vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z, uv.x, uv.y });
+            }
+
+            for (unsigned int faceIndex = 0; faceIndex < sourceMesh->mNumFaces; faceIndex++)
+            {
+                const auto& face = sourceMesh->mFaces[faceIndex];
+                if (face.mNumIndices != 3)
+                    continue;
+
+                source.indices.push_back(baseVertex + face.mIndices[0]);
+                source.indices.push_back(baseVertex + face.mIndices[1]);
+                source.indices.push_back(baseVertex + face.mIndices[2]);
+                source.triangleMaterials.push_back(sourceMesh->mMaterialIndex);
+            }
+        }
+
+        if (source.vertices.empty() || source.indices.empty())
+        {
+            std::cerr << "The scene has no triangles to cook\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    VertexNormal DropUV(const VertexNormalUV& vertex)
+    {
+        return VertexNormal{ vertex.x, vertex.y, vertex.z, vertex.nx, vertex.ny, vertex.nz };
+    }
+
+    /// @brief Split the mesh into a submesh per material, optimize each one and pack its vertices,
+    /// quantizing every submesh's positions on the grid of the whole mesh, so the parts meet
+    /// without cracks
+    template <typename TVertex, typename TPackedVertex>
+    void CookSubmeshes(const SourceMesh& source, bool optimize, uint32_t lodLevels, CookedMeshData& mesh)
+    {
+        auto quantization = ComputePositionQuantization(source.vertices.data(), source.vertices.size(), sizeof(VertexNormalUV));
+        for (auto& part : SplitByMaterial(source.indices, source.vertices.size(), source.triangleMaterials))
+        {
+            std::vector<TVertex> vertices;
+            vertices.reserve(part.vertices.size());
+            for (auto vertex : part.vertices)
+            {
+                if constexpr (std::is_same_v<TVertex, VertexNormal>)
+                    vertices.push_back(DropUV(source.vertices[vertex]));
+                else
+                    vertices.push_back(source.vertices[vertex]);
+            }
+
+            if (optimize)
+            {
+                auto report = OptimizeMesh(vertices, part.indices);
+                std::cout << "Optimized material " << part.materialIndex << " in " << report.milliseconds << " ms\n"
+                          << "  ACMR FIFO " << c_fifoVertexCacheSize << ": " << report.fifoBefore.acmr << " -> " << report.fifoAfter.acmr
+                          << ", LRU " << c_lruVertexCacheSize << ": " << report.lruBefore.acmr << " -> " << report.lruAfter.acmr << "\n"
+                          << "  ATVR FIFO " << c_fifoVertexCacheSize << ": " << report.fifoBefore.atvr << " -> " << report.fifoAfter.atvr
+                          << ", LRU " << c_lruVertexCacheSize << ": " << report.lruBefore.atvr << " -> " << report.lruAfter.atvr << "\n"
+                          << "  " << report.verticesBefore - report.verticesAfter << " unused vertices dropped, overdraw order "
+                          << (report.overdrawReordered ? "applied" : "not applied") << "\n";
+            }
+
+            // The levels of detail go after the full mesh in the submesh's index range
+            LodChain chain = BuildLodChain(vertices, part.indices, lodLevels);
+            uint32_t submeshIndex = static_cast<uint32_t>(mesh.submeshes.size());
+            if (chain.levels.size() > 1)
+                std::cout << "Built " << chain.levels.size() << " levels of detail for material " << part.materialIndex << " in " << chain.milliseconds << " ms\n";
+            for (uint32_t level = 0; level < chain.levels.size(); level++)
+            {
+                const auto& lod = chain.levels[level];
+                mesh.lods.push_back(CookedLod{ submeshIndex, lod.firstIndex, lod.indexCount, lod.error });
+                if (level > 0)
+                    std::cout << "  LOD " << level << ": " << lod.indexCount / 3 << " triangles, error " << lod.error << "\n";
+            }
+
+            CookedSubmesh submesh = {};
+            submesh.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+            submesh.indexCount = static_cast<uint32_t>(chain.indices.size());
+            submesh.firstVertex = mesh.vertexCount;
+            submesh.vertexCount = static_cast<uint32_t>(vertices.size());
+            submesh.materialIndex = part.materialIndex;
+            std::memcpy(submesh.positionScale, quantization.scale, sizeof(submesh.positionScale));
+            std::memcpy(submesh.positionOffset, quantization.offset, sizeof(submesh.positionOffset));
+            mesh.submeshes.push_back(submesh);
+
+            std::vector<TPackedVertex> packed(vertices.size());
+            PackVertices(vertices.data(), vertices.size(), quantization, packed.data());
+            const auto* bytes = reinterpret_cast<const uint8_t*>(packed.data());
+            mesh.vertices.insert(mesh.vertices.end(), bytes, bytes + packed.size() * sizeof(TPackedVertex));
+            mesh.vertexCount += submesh.vertexCount;
+
+            mesh.indices.insert(mesh.indices.end(), chain.indices.begin(), chain.indices.end());
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CookedVertexFormat format = CookedVertexFormat::PackedNormal;
+    bool optimize = true;
+    uint32_t lodLevels = c_maxLodLevels;
+    std::vector<std::string> paths;
+    for (int index = 1; index < argc; index++)
+    {
+        std::string argument = argv[index];
+        if (argument == "--textured")
+        {
+            format = CookedVertexFormat::PackedNormalUV;
+        }
+        else if (argument == "--no-optimize")
+        {
+            optimize = false;
+        }
+        else if (argument == "--no-lods")
+        {
+            lodLevels = 1;
+        }
+        else if (argument.rfind("--", 0) == 0)
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.empty() || paths.size() > 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::filesystem::path sourcePath = paths[0];
+    std::filesystem::path cookedPath = paths.size() > 1 ? std::filesystem::path(paths[1]) : sourcePath;
+    if (paths.size() == 1)
+        cookedPath.replace_extension(c_cookedMeshExtension);
+
+    // The same import the runtime does when there isn't a cooked mesh, so the timings compare
+    auto start = std::chrono::high_resolution_clock::now();
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(sourcePath.generic_string(),
+        aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_SortByPType);
+    if (scene == nullptr)
+    {
+        std::cerr << "Failed to import " << sourcePath << ": " << importer.GetErrorString() << "\n";
+        return 1;
+    }
+
+    CookedMeshData mesh;
+    mesh.vertexFormat = format;
+    SourceMesh source;
+    if (!ConvertScene(scene, format == CookedVertexFormat::PackedNormalUV, source, mesh))
+        return 1;
+    double importMilliseconds = MillisecondsSince(start);
+
+    ComputeBounds(source.vertices, mesh);
+    if (format == CookedVertexFormat::PackedNormalUV)
+        CookSubmeshes<VertexNormalUV, PackedVertexNormalUV>(source, optimize, lodLevels, mesh);
+    else
+        CookSubmeshes<VertexNormal, PackedVertexNormal>(source, optimize, lodLevels, mesh);
+
+    std::string error;
+    if (!WriteCookedMesh(cookedPath.string(), mesh, error))
+    {
+        std::cerr << "Failed to write " << cookedPath << ": " << error << "\n";
+        return 1;
+    }
+
+    // Load it back the way the runtime does. Copying the blobs stands in for the GPU upload, which
+    // reads every byte of them.
+    start = std::chrono::high_resolution_clock::now();
+    MappedFile file;
+    CookedMeshView view;
+    if (!file.Open(cookedPath.string()) || !view.Open(file.GetData(), file.GetSize()))
+    {
+        std::cerr << "Failed to read back " << cookedPath << ": " << view.GetError() << "\n";
+        return 1;
+    }
+    const auto& header = view.GetHeader();
+    std::vector<uint8_t> upload(static_cast<size_t>(header.vertexCount) * header.vertexStride + static_cast<size_t>(header.indexCount) * header.indexSize);
+    std::memcpy(upload.data(), view.GetVertices(), static_cast<size_t>(header.vertexCount) * header.vertexStride);
+    std::memcpy(upload.data() + static_cast<size_t>(header.vertexCount) * header.vertexStride, view.GetIndices(), static_cast<size_t>(header.indexCount) * header.indexSize);
+    double cookedMilliseconds = MillisecondsSince(start);
+
+    std::cout << "Cooked " << sourcePath << " to " << cookedPath << ": " << header.vertexCount << " vertices, "
+              << header.indexCount / 3 << " triangles, " << header.indexSize * 8 << " bit indices, "
+              << header.submeshCount << " submeshes, " << header.lodCount << " levels of detail, " << header.materialCount << " materials, "
+              << header.fileSize << " bytes\n";
+    std::cout << "Load time: assimp " << importMilliseconds << " ms, cooked " << cookedMilliseconds << " ms ("
+              << importMilliseconds / std::max(cookedMilliseconds, 0.001) << "x faster)\n";
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncLoader.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief A load that does nothing but hand back an upload which records its number
+    AsyncLoader::LoadFunction RecordingLoad(uint32_t number, std::vector<uint32_t>& uploaded, bool uploadSucceeds = true)
+    {
+        return [number, &uploaded, uploadSucceeds]() -> AsyncLoader::UploadFunction
+            {
+                return [number, &uploaded, uploadSucceeds]()
+                    {
+                        uploaded.push_back(number);
+                        return uploadSucceeds;
+                    };
+            };
+    }
+
+    void Sleep(double milliseconds)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(milliseconds));
+    }
+}
+
+SCENEGRAPH_TEST(AsyncLoader, UploadsRunOnCaller)
+{
+    AsyncLoader loader(2);
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic<uint32_t> loadsOnCaller = 0;
+    uint32_t uploadsElsewhere = 0;
+    uint32_t uploads = 0;
+    for (uint32_t index = 0; index < 8; index++)
+    {
+        loader.Submit("asset " + std::to_string(index), [&]() -> AsyncLoader::UploadFunction
+            {
+                if (std::this_thread::get_id() == caller)
+                    loadsOnCaller++;
+                return [&]()
+                    {
+                        uploadsElsewhere += std::this_thread::get_id() != caller;
+                        uploads++;
+                        return true;
+                    };
+            });
+    }
+
+    // Nothing is uploaded until the caller asks
+    loader.WaitForLoads();
+    bool waiting = uploads == 0 && loader.GetStats().waitingForUpload == 8 && !loader.IsIdle();
+
+    uint32_t ran = loader.ProcessUploads(1000.0);
+    AsyncLoaderStats stats = loader.GetStats();
+    return waiting && ran == 8 && uploads == 8 && loadsOnCaller == 0 && uploadsElsewhere == 0 &&
+        stats.completed == 8 && stats.failed == 0 && stats.queued == 0 && stats.waitingForUpload == 0 &&
+        stats.uploadsLastFrame == 8 && loader.IsIdle();
+}
+
+SCENEGRAPH_TEST(AsyncLoader, Failures)
+{
+    AsyncLoader loader(1);
+    std::vector<uint32_t> uploaded;
+    loader.Submit("loads", RecordingLoad(0, uploaded));
+    loader.Submit("fails to load", []() { return AsyncLoader::UploadFunction(); });
+    loader.Submit("fails to upload", RecordingLoad(2, uploaded, false));
+    loader.WaitForLoads();
+
+    // A failed load is counted as soon as it happens, and never gets an upload
+    AsyncLoaderStats loaded = loader.GetStats();
+    bool loadFailure = loaded.failed == 1 && loaded.lastFailed == "fails to load" && loaded.waitingForUpload == 2;
+
+    loader.ProcessUploads(1000.0);
+    AsyncLoaderStats stats = loader.GetStats();
+    return loadFailure && uploaded == std::vector<uint32_t>{ 0, 2 } &&
+        stats.completed == 1 && stats.failed == 2 && stats.lastFailed == "fails to upload";
+}
+
+SCENEGRAPH_TEST(AsyncLoader, UploadBudget)
+{
+    AsyncLoader loader(1);
+    std::vector<uint32_t> uploaded;
+    for (uint32_t index = 0; index < 6; index++)
+    {
+        loader.Submit("slow upload", [index, &uploaded]() -> AsyncLoader::UploadFunction
+            {
+                return [index, &uploaded]()
+                    {
+                        Sleep(2.0);
+                        uploaded.push_back(index);
+                        return true;
+                    };
+            });
+    }
+    loader.WaitForLoads();
+
+    // An upload that overruns the budget still finishes, and ends the frame; a budget of nothing
+    // still makes progress
+    uint32_t first = loader.ProcessUploads(1.0);
+    uint32_t second = loader.ProcessUploads(0.0);
+    bool oneEach = first == 1 && second == 1 && loader.GetStats().uploadsLastFrame == 1 && loader.GetStats().waitingForUpload == 4;
+
+    // A roomy budget takes the rest, still oldest first
+    uint32_t rest = loader.ProcessUploads(1000.0);
+    uint32_t none = loader.ProcessUploads(1000.0);
+    return oneEach && rest == 4 && none == 0 && uploaded == std::vector<uint32_t>{ 0, 1, 2, 3, 4, 5 };
+}
+
+SCENEGRAPH_TEST(AsyncLoader, OneThread)
+{
+    AsyncLoader loader(1);
+    std::mutex mutex;
+    std::vector<std::thread::id> loadThreads;
+    std::vector<uint32_t> uploaded;
+    for (uint32_t index = 0; index < 16; index++)
+    {
+        loader.Submit("asset", [index, &mutex, &loadThreads, &uploaded]() -> AsyncLoader::UploadFunction
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    loadThreads.push_back(std::this_thread::get_id());
+                }
+                return RecordingLoad(index, uploaded)();
+            });
+    }
+    loader.WaitForLoads();
+    loader.ProcessUploads(1000.0);
+
+    // One thread, not the caller's, loads everything in the order it was submitted
+    bool oneThread = loadThreads.size() == 16 && loadThreads[0] != std::this_thread::get_id();
+    for (const auto& thread : loadThreads)
+    {
+        oneThread &= thread == loadThreads[0];
+    }
+
+    std::vector<uint32_t> expected;
+    for (uint32_t index = 0; index < 16; index++)
+    {
+        expected.push_back(index);
+    }
+    return loader.GetWorkerCount() == 1 && oneThread && uploaded == expected && loader.IsIdle();
+}
+
+SCENEGRAPH_TEST(AsyncLoader, ShutdownDropsQueuedWork)
+{
+    AsyncLoader loader(1);
+    std::vector<uint32_t> uploaded;
+
+    // A finished load whose upload hasn't run yet; what it holds is let go without it running
+    auto held = std::make_shared<int>(0);
+    loader.Submit("waiting for upload", [held, &uploaded]() -> AsyncLoader::UploadFunction
+        {
+            return [held, &uploaded]()
+                {
+                    uploaded.push_back(0);
+                    return true;
+                };
+        });
+    loader.WaitForLoads();
+
+    // A load in progress, which only finishes once the queue behind it has been filled and then
+    // emptied by Shutdown
+    std::atomic<bool> started = false;
+    std::atomic<bool> allQueued = false;
+    loader.Submit("in progress", [&]() -> AsyncLoader::UploadFunction
+        {
+            started = true;
+            while (!allQueued || loader.GetStats().queued != 0)
+            {
+                std::this_thread::yield();
+            }
+            return RecordingLoad(1, uploaded)();
+        });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+
+    std::atomic<uint32_t> queuedLoads = 0;
+    for (uint32_t index = 2; index < 10; index++)
+    {
+        loader.Submit("queued", [&]() -> AsyncLoader::UploadFunction
+            {
+                queuedLoads++;
+                return []() { return true; };
+            });
+    }
+    bool queued = loader.GetStats().queued == 8;
+    allQueued = true;
+
+    loader.Shutdown();
+
+    // Nothing queued ran, nothing uploads, and the loader takes no more work
+    loader.Submit("after shutdown", RecordingLoad(10, uploaded));
+    uint32_t uploads = loader.ProcessUploads(1000.0);
+    AsyncLoaderStats stats = loader.GetStats();
+    return queued && queuedLoads == 0 && uploads == 0 && uploaded.empty() && held.use_count() == 1 &&
+        stats.queued == 0 && stats.waitingForUpload == 0 && stats.loading == 0 && stats.completed == 0 &&
+        loader.IsIdle() && loader.GetWorkerCount() == 0;
+}
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Bvh.h"
+#include "Culling.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    Bounds MakeBounds(float x, float y, float z, float extentX, float extentY, float extentZ)
+    {
+        Bounds bounds;
+        bounds.center = { x, y, z };
+        bounds.extents = { extentX, extentY, extentZ };
+        bounds.radius = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ);
+        return bounds;
+    }
+
+    /// @brief Boxes of all sizes scattered over a 200 unit cube, with every `emptyEvery`th one empty
+    std::vector<Bounds> MakeScene(std::mt19937& random, size_t count, size_t emptyEvery)
+    {
+        std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 4.0f);
+        std::vector<Bounds> bounds;
+        for (size_t index = 0; index < count; index++)
+        {
+            if (emptyEvery != 0 && index % emptyEvery == 0)
+                bounds.push_back(Bounds());
+            else
+                bounds.push_back(MakeBounds(position(random), position(random), position(random), extent(random), extent(random), extent(random)));
+        }
+        return bounds;
+    }
+
+    /// @brief Somewhere in or around the scene, looking at some other spot in it
+    Frustum MakeFrustum(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+        DirectX::XMVECTOR eye = DirectX::XMVectorSet(position(random), position(random), position(random), 1.0f);
+        DirectX::XMVECTOR target = DirectX::XMVectorSet(position(random), position(random), position(random), 1.0f);
+        DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(eye, target, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 1.5f, 0.1f, 150.0f);
+        return ExtractFrustum(view * projection);
+    }
+
+    /// @brief What QueryFrustum should find: every primitive with bounds whose box isn't outside
+    std::vector<uint32_t> BruteForceFrustum(const Frustum& frustum, const std::vector<Bounds>& bounds)
+    {
+        std::vector<uint32_t> results;
+        for (uint32_t primitive = 0; primitive < bounds.size(); primitive++)
+        {
+            if (!bounds[primitive].IsEmpty() && TestFrustum(frustum, bounds[primitive]) != CullResult::Outside)
+                results.push_back(primitive);
+        }
+        return results;
+    }
+
+    bool QueryMatches(const Bvh& bvh, const Frustum& frustum, const std::vector<Bounds>& bounds)
+    {
+        std::vector<uint32_t> results;
+        bvh.QueryFrustum(frustum, results);
+        std::sort(results.begin(), results.end());
+        return results == BruteForceFrustum(frustum, bounds);
+    }
+
+    /// @brief Slab test of a ray against one box, written out the long way
+    float RayBoxDistance(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, const Bounds& bounds)
+    {
+        const float* start = &origin.x;
+        const float* step = &direction.x;
+        const float* center = &bounds.center.x;
+        const float* extents = &bounds.extents.x;
+        float enter = 0.0f;
+        float exit = FLT_MAX;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float lower = center[axis] - extents[axis];
+            float upper = center[axis] + extents[axis];
+            if (step[axis] == 0.0f)
+            {
+                if (start[axis] < lower || start[axis] > upper)
+                    return FLT_MAX;
+                continue;
+            }
+            float t1 = (lower - start[axis]) / step[axis];
+            float t2 = (upper - start[axis]) / step[axis];
+            enter = std::max(enter, std::min(t1, t2));
+            exit = std::min(exit, std::max(t1, t2));
+        }
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    /// @brief Does Raycast find a primitive at the nearest distance any box is hit, or miss when nothing is?
+    bool RaycastMatches(const Bvh& bvh, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, const std::vector<Bounds>& bounds)
+    {
+        float nearest = FLT_MAX;
+        for (const auto& primitive : bounds)
+        {
+            if (!primitive.IsEmpty())
+                nearest = std::min(nearest, RayBoxDistance(origin, direction, primitive));
+        }
+
+        float distance = 0.0f;
+        uint32_t hit = bvh.Raycast(origin, direction, distance);
+        if (nearest == FLT_MAX)
+            return hit == Bvh::InvalidIndex;
+        return hit < bounds.size() && !bounds[hit].IsEmpty() && Near(distance, nearest, 1e-3f) &&
+            Near(RayBoxDistance(origin, direction, bounds[hit]), nearest, 1e-3f);
+    }
+
+    void MoveSome(std::mt19937& random, std::vector<Bounds>& bounds, std::vector<uint32_t>& moved, size_t every)
+    {
+        std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+        moved.clear();
+        for (uint32_t primitive = 0; primitive < bounds.size(); primitive++)
+        {
+            if (bounds[primitive].IsEmpty() || random() % every != 0)
+                continue;
+            bounds[primitive].center.x += offset(random);
+            bounds[primitive].center.y += offset(random);
+            bounds[primitive].center.z += offset(random);
+            moved.push_back(primitive);
+        }
+    }
+}
+
+SCENEGRAPH_TEST(Bvh, QueryFrustumMatchesBruteForce)
+{
+    std::mt19937 random(7);
+    std::vector<Bounds> bounds = MakeScene(random, 2000, 13);
+
+    Bvh bvh;
+    bvh.Build(bounds);
+    size_t filled = std::count_if(bounds.begin(), bounds.end(), [](const Bounds& primitive) { return !primitive.IsEmpty(); });
+    if (bvh.GetPrimitiveCount() != filled || bvh.GetNodeCount() == 0)
+        return false;
+
+    for (int view = 0; view < 50; view++)
+    {
+        if (!QueryMatches(bvh, MakeFrustum(random), bounds))
+            return false;
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(Bvh, RaycastMatchesBruteForce)
+{
+    std::mt19937 random(8);
+    std::vector<Bounds> bounds = MakeScene(random, 2000, 13);
+    Bvh bvh;
+    bvh.Build(bounds);
+
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+    for (int ray = 0; ray < 500; ray++)
+    {
+        DirectX::XMFLOAT3 origin = { position(random), position(random), position(random) };
+        DirectX::XMFLOAT3 towards = { direction(random), direction(random), direction(random) };
+
+        // Rays along an axis take the divisions by zero
+        if (ray % 10 == 0)
+            towards = { 0.0f, 0.0f, ray % 20 == 0 ? 1.0f : -1.0f };
+
+        if (!RaycastMatches(bvh, origin, towards, bounds))
+            return false;
+    }
+
+    // Nothing in the tree, nothing hit
+    Bvh empty;
+    empty.Build({ Bounds(), Bounds() });
+    float distance = 0.0f;
+    return empty.GetNodeCount() == 0 && empty.Raycast({ 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, distance) == Bvh::InvalidIndex;
+}
+
+SCENEGRAPH_TEST(Bvh, RefitMatchesBruteForce)
+{
+    std::mt19937 random(9);
+    std::vector<Bounds> bounds = MakeScene(random, 1000, 0);
+    Bvh bvh;
+    bvh.Build(bounds);
+
+    // Everything moves, then only some of it, and the queries keep up either way
+    std::vector<uint32_t> moved;
+    for (int frame = 0; frame < 10; frame++)
+    {
+        MoveSome(random, bounds, moved, frame % 2 == 0 ? 1 : 20);
+        bool rebuilt = frame % 2 == 0 ? bvh.Refit(bounds) : bvh.Refit(bounds, moved);
+        if (rebuilt || !QueryMatches(bvh, MakeFrustum(random), bounds))
+            return false;
+
+        DirectX::XMFLOAT3 origin = { -150.0f, bounds[frame].center.y, bounds[frame].center.z };
+        if (!RaycastMatches(bvh, origin, { 1.0f, 0.0f, 0.0f }, bounds))
+            return false;
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(Bvh, EmptyBoundsComeAndGo)
+{
+    // Everything in a row along x, with every other box empty to begin with
+    std::vector<Bounds> bounds;
+    for (int index = 0; index < 64; index++)
+    {
+        bounds.push_back(index % 2 == 0 ? MakeBounds(index * 4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f) : Bounds());
+    }
+
+    Bvh bvh;
+    bvh.Build(bounds);
+    bool leftOut = bvh.GetPrimitiveCount() == 32 && RaycastMatches(bvh, { -10.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, bounds);
+
+    // An empty primitive that gets bounds has no leaf to go in, so the tree is rebuilt around it
+    std::mt19937 random(10);
+    bounds[1] = MakeBounds(-5.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+    bool added = bvh.Refit(bounds, { 1 }) && bvh.GetPrimitiveCount() == 33 && QueryMatches(bvh, MakeFrustum(random), bounds);
+    float distance = 0.0f;
+    added = added && bvh.Raycast({ -10.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, distance) == 1 && Near(distance, 4.0f);
+
+    bounds[3] = MakeBounds(12.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+    bool addedByFullRefit = bvh.Refit(bounds) && bvh.GetPrimitiveCount() == 34;
+
+    // One that loses its bounds just stops being found, without a rebuild
+    bounds[1] = Bounds();
+    bool removed = !bvh.Refit(bounds, { 1 }) && RaycastMatches(bvh, { -10.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, bounds) &&
+        bvh.Raycast({ -10.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, distance) == 0;
+    for (int view = 0; view < 20; view++)
+    {
+        removed = removed && QueryMatches(bvh, MakeFrustum(random), bounds);
+    }
+
+    // So does a whole leaf's worth
+    for (int index = 0; index < 16; index++)
+    {
+        bounds[index] = Bounds();
+    }
+    bool emptied = !bvh.Refit(bounds) && RaycastMatches(bvh, { -10.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, bounds);
+
+    // More primitives than the tree was built with rebuilds too
+    bounds.push_back(MakeBounds(0.0f, 50.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+    bool grown = bvh.Refit(bounds) && RaycastMatches(bvh, { 0.0f, 60.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, bounds);
+
+    return leftOut && added && addedByFullRefit && removed && emptied && grown;
+}
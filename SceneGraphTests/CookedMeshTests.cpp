@@ -0,0 +1,186 @@
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "MeshSplitter.h"
+#include "SceneGraphTest.h"
+#include "VertexCompression.h"
+
+namespace
+{
+    /// @brief Two submeshes of four vertices, the first with two levels of detail and the second with
+    /// just the one, and a material each
+    CookedMeshData MakeMesh()
+    {
+        CookedMeshData mesh;
+        mesh.vertexFormat = CookedVertexFormat::PackedNormal;
+        mesh.vertexCount = 8;
+        mesh.vertices.resize(mesh.vertexCount * sizeof(PackedVertexNormal));
+        for (size_t index = 0; index < mesh.vertices.size(); index++)
+        {
+            mesh.vertices[index] = static_cast<uint8_t>(index * 7);
+        }
+
+        mesh.indices = { 0, 1, 2, 0, 2, 3, 0, 1, 3, 0, 1, 2 };
+        mesh.submeshes.push_back(CookedSubmesh{ 0, 9, 0, 4, 0, 0, { 1.0f, 2.0f, 3.0f }, { -1.0f, -2.0f, -3.0f } });
+        mesh.submeshes.push_back(CookedSubmesh{ 9, 3, 4, 4, 1, 0, { 1.0f, 2.0f, 3.0f }, { -1.0f, -2.0f, -3.0f } });
+        mesh.lods.push_back(CookedLod{ 0, 0, 6, 0.0f });
+        mesh.lods.push_back(CookedLod{ 0, 6, 3, 0.25f });
+
+        CookedMaterial plain = {};
+        plain.diffuse[0] = 0.5f;
+        CookedMaterial textured = {};
+        std::strcpy(textured.diffuseTexture, "textures/brick.png");
+        mesh.materials = { plain, textured };
+
+        mesh.boundsCenter[1] = 1.0f;
+        mesh.boundsExtents[0] = 2.0f;
+        mesh.boundsRadius = 3.0f;
+        return mesh;
+    }
+
+    /// @brief Cook a mesh to a temporary file and read it back into memory aligned as a mapping would be
+    bool WriteAndRead(const CookedMeshData& mesh, std::vector<uint64_t>& storage, size_t& size)
+    {
+        std::error_code fileError;
+        auto path = std::filesystem::temp_directory_path(fileError) / "scenegraph-tests.wtgm";
+        std::string error;
+        if (fileError || !WriteCookedMesh(path.string(), mesh, error))
+            return false;
+
+        bool read = false;
+        {
+            MappedFile file;
+            if (file.Open(path.string()))
+            {
+                size = file.GetSize();
+                storage.assign((size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+                std::memcpy(storage.data(), file.GetData(), size);
+                read = true;
+            }
+        }
+        std::filesystem::remove(path, fileError);
+        return read;
+    }
+
+    /// @brief Does Open reject the cooked mesh once `damage` has been done to a copy of it?
+    bool Rejects(const std::vector<uint64_t>& storage, size_t size, const std::function<void(uint8_t* bytes, CookedMeshHeader& header)>& damage)
+    {
+        std::vector<uint64_t> copy = storage;
+        auto* bytes = reinterpret_cast<uint8_t*>(copy.data());
+        damage(bytes, *reinterpret_cast<CookedMeshHeader*>(bytes));
+
+        CookedMeshView view;
+        return !view.Open(copy.data(), size) && !view.GetError().empty();
+    }
+
+    CookedSubmesh* Submeshes(uint8_t* bytes, const CookedMeshHeader& header) { return reinterpret_cast<CookedSubmesh*>(bytes + header.submeshOffset); }
+    CookedLod* Lods(uint8_t* bytes, const CookedMeshHeader& header) { return reinterpret_cast<CookedLod*>(bytes + header.lodOffset); }
+}
+
+SCENEGRAPH_TEST(CookedMesh, RoundTrip)
+{
+    CookedMeshData mesh = MakeMesh();
+    std::vector<uint64_t> storage;
+    size_t size = 0;
+    CookedMeshView view;
+    if (!WriteAndRead(mesh, storage, size) || !view.Open(storage.data(), size))
+        return false;
+
+    const auto& header = view.GetHeader();
+    bool counts = header.vertexCount == 8 && header.indexCount == 12 && header.submeshCount == 2 && header.materialCount == 2 &&
+        header.lodCount == 2 && header.fileSize == size && view.GetVertexFormat() == CookedVertexFormat::PackedNormal &&
+        header.vertexStride == sizeof(PackedVertexNormal) && header.boundsCenter[1] == 1.0f && header.boundsExtents[0] == 2.0f &&
+        header.boundsRadius == 3.0f;
+
+    // Every submesh fits 16 bit indices, so that's what is written
+    const auto* indices = static_cast<const uint16_t*>(view.GetIndices());
+    bool shortIndices = header.indexSize == sizeof(uint16_t);
+    for (size_t index = 0; shortIndices && index < mesh.indices.size(); index++)
+    {
+        shortIndices = indices[index] == mesh.indices[index];
+    }
+
+    bool blobs = std::memcmp(view.GetVertices(), mesh.vertices.data(), mesh.vertices.size()) == 0 &&
+        std::memcmp(view.GetSubmeshes(), mesh.submeshes.data(), mesh.submeshes.size() * sizeof(CookedSubmesh)) == 0 &&
+        std::memcmp(view.GetMaterials(), mesh.materials.data(), mesh.materials.size() * sizeof(CookedMaterial)) == 0 &&
+        std::memcmp(view.GetLods(), mesh.lods.data(), mesh.lods.size() * sizeof(CookedLod)) == 0;
+
+    bool aligned = header.vertexOffset % c_cookedMeshAlignment == 0 && header.indexOffset % c_cookedMeshAlignment == 0 &&
+        header.submeshOffset % c_cookedMeshAlignment == 0 && header.materialOffset % c_cookedMeshAlignment == 0 &&
+        header.lodOffset % c_cookedMeshAlignment == 0;
+
+    return counts && shortIndices && blobs && aligned;
+}
+
+SCENEGRAPH_TEST(CookedMesh, LongIndices)
+{
+    // One submesh too big for 16 bit indices makes the whole file use 32 bit ones
+    CookedMeshData mesh = MakeMesh();
+    mesh.vertexCount = static_cast<uint32_t>(c_maxShortIndexVertices) + 1;
+    mesh.vertices.assign(mesh.vertexCount * sizeof(PackedVertexNormal), 0);
+    mesh.indices[11] = mesh.vertexCount - 1;
+    mesh.submeshes[1].firstVertex = 0;
+    mesh.submeshes[1].vertexCount = mesh.vertexCount;
+
+    std::vector<uint64_t> storage;
+    size_t size = 0;
+    CookedMeshView view;
+    if (!WriteAndRead(mesh, storage, size) || !view.Open(storage.data(), size))
+        return false;
+
+    const auto* indices = static_cast<const uint32_t*>(view.GetIndices());
+    return view.GetHeader().indexSize == sizeof(uint32_t) && std::memcmp(indices, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)) == 0;
+}
+
+SCENEGRAPH_TEST(CookedMesh, WriteRejectsMismatchedVertices)
+{
+    CookedMeshData mesh = MakeMesh();
+    mesh.vertices.pop_back();
+    std::string error;
+    return !WriteCookedMesh("never-written.wtgm", mesh, error) && !error.empty() && !std::filesystem::exists("never-written.wtgm");
+}
+
+SCENEGRAPH_TEST(CookedMesh, OpenRejectsDamage)
+{
+    std::vector<uint64_t> storage;
+    size_t size = 0;
+    if (!WriteAndRead(MakeMesh(), storage, size))
+        return false;
+
+    CookedMeshView view;
+    bool truncated = !view.Open(storage.data(), size - 1) && !view.Open(storage.data(), sizeof(CookedMeshHeader) - 1) && !view.Open(nullptr, 0);
+
+    bool header = Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.magic++; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.version = c_cookedMeshVersion + 1; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.version = c_cookedMeshVersion - 1; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.vertexFormat = 0; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.indexSize = 1; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.indexCount = 11; });
+
+    // Offsets that are off the alignment, even by a little, or that run past the end
+    bool offsets = Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.indexOffset += 2; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.materialOffset -= 4; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.lodOffset += c_cookedMeshAlignment; }) &&
+        Rejects(storage, size, [](uint8_t*, CookedMeshHeader& header) { header.vertexCount += 100; });
+
+    bool submeshes = Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header) { Submeshes(bytes, header)[1].indexCount += 3; }) &&
+        Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header) { Submeshes(bytes, header)[1].firstVertex = 6; }) &&
+        Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header) { Submeshes(bytes, header)[0].materialIndex = 2; });
+
+    bool lods = Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header) { Lods(bytes, header)[1].submeshIndex = 2; }) &&
+        Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header) { Lods(bytes, header)[1].indexCount = 6; }) &&
+        Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header) { Lods(bytes, header)[1].indexCount = 2; }) &&
+        Rejects(storage, size, [](uint8_t* bytes, CookedMeshHeader& header)
+            {
+                // The table has to be sorted by submesh
+                Lods(bytes, header)[0].submeshIndex = 1;
+                Lods(bytes, header)[0].indexCount = 3;
+            });
+
+    // And the untouched file still opens
+    return truncated && header && offsets && submeshes && lods && view.Open(storage.data(), size);
+}
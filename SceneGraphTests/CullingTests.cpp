@@ -0,0 +1,172 @@
+#include <random>
+#include <vector>
+
+#include "Culling.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief Looking down +Z from the origin with a 90 degree field of view, near 0.1 and far 100
+    Frustum MakeFrustum()
+    {
+        DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(
+            DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+            DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+            DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, 1.0f, 0.1f, 100.0f);
+        return ExtractFrustum(view * projection);
+    }
+
+    Bounds MakeBounds(float x, float y, float z, float extentX, float extentY, float extentZ)
+    {
+        Bounds bounds;
+        bounds.center = { x, y, z };
+        bounds.extents = { extentX, extentY, extentZ };
+        bounds.radius = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ);
+        return bounds;
+    }
+
+    /// @brief Whether the box of the inner bounds is inside both the box and the sphere of the outer
+    bool Contains(const Bounds& outer, const Bounds& inner)
+    {
+        const float* outerCenter = &outer.center.x;
+        const float* outerExtents = &outer.extents.x;
+        const float* innerCenter = &inner.center.x;
+        const float* innerExtents = &inner.extents.x;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (innerCenter[axis] - innerExtents[axis] < outerCenter[axis] - outerExtents[axis] - 1e-4f ||
+                innerCenter[axis] + innerExtents[axis] > outerCenter[axis] + outerExtents[axis] + 1e-4f)
+                return false;
+        }
+
+        // The sphere only has to hold the box, which is all the merged bounds promise
+        for (int corner = 0; corner < 8; corner++)
+        {
+            float dx = innerCenter[0] + (corner & 1 ? innerExtents[0] : -innerExtents[0]) - outerCenter[0];
+            float dy = innerCenter[1] + (corner & 2 ? innerExtents[1] : -innerExtents[1]) - outerCenter[1];
+            float dz = innerCenter[2] + (corner & 4 ? innerExtents[2] : -innerExtents[2]) - outerCenter[2];
+            if (std::sqrt(dx * dx + dy * dy + dz * dz) > outer.radius + 1e-4f)
+                return false;
+        }
+        return true;
+    }
+}
+
+SCENEGRAPH_TEST(Culling, ComputeBoundsOfPoints)
+{
+    // The corners of a box from (1, 2, 3) to (3, 6, 11), with a stride wider than the position
+    std::vector<float> vertices;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        vertices.push_back(corner & 1 ? 3.0f : 1.0f);
+        vertices.push_back(corner & 2 ? 6.0f : 2.0f);
+        vertices.push_back(corner & 4 ? 11.0f : 3.0f);
+        vertices.push_back(-100.0f);
+    }
+
+    Bounds bounds = ComputeBounds(vertices.data(), 8, 4 * sizeof(float));
+    return Near(bounds.center.x, 2.0f) && Near(bounds.center.y, 4.0f) && Near(bounds.center.z, 7.0f) &&
+        Near(bounds.extents.x, 1.0f) && Near(bounds.extents.y, 2.0f) && Near(bounds.extents.z, 4.0f) &&
+        Near(bounds.radius, std::sqrt(21.0f));
+}
+
+SCENEGRAPH_TEST(Culling, EmptyBounds)
+{
+    Frustum frustum = MakeFrustum();
+    Bounds empty = ComputeBounds(nullptr, 0, 12);
+    Bounds box = MakeBounds(0.0f, 0.0f, 10.0f, 1.0f, 1.0f, 1.0f);
+
+    Bounds merged = MergeBounds(empty, box);
+    return empty.IsEmpty() && TestFrustum(frustum, empty) == CullResult::Outside &&
+        TransformBounds(empty, DirectX::XMMatrixTranslation(0.0f, 0.0f, 10.0f)).IsEmpty() &&
+        Near(merged.center.z, 10.0f) && Near(merged.radius, box.radius);
+}
+
+SCENEGRAPH_TEST(Culling, MergeContainsBoth)
+{
+    Bounds a = MakeBounds(-3.0f, 1.0f, 2.0f, 1.0f, 0.5f, 2.0f);
+    Bounds b = MakeBounds(4.0f, -2.0f, 0.0f, 0.25f, 3.0f, 1.0f);
+    Bounds merged = MergeBounds(a, b);
+    return Contains(merged, a) && Contains(merged, b);
+}
+
+SCENEGRAPH_TEST(Culling, TransformBounds)
+{
+    Bounds box = MakeBounds(1.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f);
+
+    // Scaled by 2 along x, then moved: the sphere grows with the largest scale
+    Bounds moved = TransformBounds(box, DirectX::XMMatrixScaling(2.0f, 1.0f, 1.0f) * DirectX::XMMatrixTranslation(0.0f, 5.0f, 0.0f));
+    bool scaled = Near(moved.center.x, 2.0f) && Near(moved.center.y, 5.0f) && Near(moved.center.z, 0.0f) &&
+        Near(moved.extents.x, 2.0f) && Near(moved.extents.y, 2.0f) && Near(moved.extents.z, 3.0f) &&
+        Near(moved.radius, 2.0f * box.radius);
+
+    // A quarter turn about y swaps the x and z extents, and an eighth of a turn grows the box to
+    // keep it axis aligned
+    Bounds quarter = TransformBounds(box, DirectX::XMMatrixRotationY(DirectX::XM_PIDIV2));
+    bool rotated = Near(quarter.extents.x, 3.0f) && Near(quarter.extents.z, 1.0f) && Near(quarter.radius, box.radius);
+
+    Bounds eighth = TransformBounds(box, DirectX::XMMatrixRotationY(DirectX::XM_PIDIV4));
+    float grown = (1.0f + 3.0f) * std::sqrt(0.5f);
+    bool aligned = Near(eighth.extents.x, grown) && Near(eighth.extents.z, grown) && Near(eighth.extents.y, 2.0f);
+
+    return scaled && rotated && aligned;
+}
+
+SCENEGRAPH_TEST(Culling, FrustumClassification)
+{
+    Frustum frustum = MakeFrustum();
+    return TestFrustum(frustum, MakeBounds(0.0f, 0.0f, 10.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Inside &&
+        TestFrustum(frustum, MakeBounds(0.0f, 0.0f, -10.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Outside &&
+        TestFrustum(frustum, MakeBounds(0.0f, 0.0f, 200.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Outside &&
+        TestFrustum(frustum, MakeBounds(-100.0f, 0.0f, 10.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Outside &&
+        TestFrustum(frustum, MakeBounds(0.0f, 30.0f, 10.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Outside &&
+        TestFrustum(frustum, MakeBounds(0.0f, 0.0f, 100.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Intersecting &&
+        TestFrustum(frustum, MakeBounds(10.0f, 0.0f, 10.0f, 1.0f, 1.0f, 1.0f)) == CullResult::Intersecting;
+}
+
+SCENEGRAPH_TEST(Culling, BoxRejectsWhatTheSphereCannot)
+{
+    // A long thin box behind the camera: its sphere reaches through the near plane, its box doesn't
+    Frustum frustum = MakeFrustum();
+    Bounds sliver = MakeBounds(0.0f, 0.0f, -2.0f, 10.0f, 0.1f, 0.1f);
+    return TestFrustum(frustum, sliver) == CullResult::Outside;
+}
+
+SCENEGRAPH_TEST(Culling, CullSpheresMatchesPlanes)
+{
+    Frustum frustum = MakeFrustum();
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 5.0f);
+
+    const size_t count = 10000;
+    std::vector<DirectX::XMFLOAT4> spheres(count);
+    for (auto& sphere : spheres)
+    {
+        sphere = { position(random), position(random), position(random), radius(random) };
+    }
+
+    std::vector<uint8_t> visible(count);
+    size_t visibleCount = CullSpheres(frustum, spheres.data(), count, visible.data());
+
+    // One plane at a time, as the sphere part of TestFrustum does
+    size_t expectedCount = 0;
+    for (size_t index = 0; index < count; index++)
+    {
+        const auto& sphere = spheres[index];
+        bool inside = true;
+        for (const auto& plane : frustum.planes)
+        {
+            if (plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w < -sphere.w)
+                inside = false;
+        }
+
+        if (visible[index] != (inside ? 1 : 0))
+            return false;
+        expectedCount += inside ? 1 : 0;
+    }
+
+    return visibleCount == expectedCount && visibleCount > 0 && visibleCount < count;
+}
@@ -0,0 +1,116 @@
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "ImageConvert.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    void ExpandScalar(const uint8_t* source, uint32_t channels, size_t texelCount, uint8_t* rgba)
+    {
+        for (size_t texel = 0; texel < texelCount; texel++)
+        {
+            const uint8_t* in = source + texel * channels;
+            uint8_t* out = rgba + texel * 4;
+            out[0] = in[0];
+            out[1] = channels >= 3 ? in[1] : in[0];
+            out[2] = channels >= 3 ? in[2] : in[0];
+            out[3] = channels == 2 ? in[1] : channels == 4 ? in[3] : 255;
+        }
+    }
+
+    void PremultiplyScalar(uint8_t* rgba, size_t texelCount)
+    {
+        for (size_t texel = 0; texel < texelCount; texel++)
+        {
+            uint8_t* colour = rgba + texel * 4;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                colour[channel] = static_cast<uint8_t>((colour[channel] * colour[3] * 2 + 255) / 510);
+            }
+        }
+    }
+
+    std::vector<uint8_t> RandomBytes(size_t count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> bytes(count);
+        for (auto& byte : bytes)
+        {
+            byte = static_cast<uint8_t>(random());
+        }
+        return bytes;
+    }
+}
+
+// Every channel count expands as a plain loop would, including the texels past the last
+// whole run of the vector loops
+SCENEGRAPH_TEST(ImageConvert, Expand)
+{
+    const size_t counts[] = { 0, 1, 5, 6, 7, 15, 16, 17, 33, 1001 };
+    for (uint32_t channels = 1; channels <= 4; channels++)
+    {
+        for (size_t count : counts)
+        {
+            auto source = RandomBytes(count * channels, static_cast<uint32_t>(count * 4 + channels));
+            std::vector<uint8_t> expected(count * 4 + 1, 0xCD);
+            std::vector<uint8_t> actual(count * 4 + 1, 0xCD);
+            ExpandScalar(source.data(), channels, count, expected.data());
+            ExpandToRgba(source.data(), channels, count, actual.data());
+            if (actual != expected)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Premultiplying the encoded values rounds to nearest, for every colour and alpha
+SCENEGRAPH_TEST(ImageConvert, Premultiply)
+{
+    std::vector<uint8_t> texels;
+    for (int alpha = 0; alpha < 256; alpha++)
+    {
+        for (int colour = 0; colour < 256; colour++)
+        {
+            texels.insert(texels.end(), { static_cast<uint8_t>(colour), static_cast<uint8_t>(255 - colour), static_cast<uint8_t>(colour ^ 0x5A), static_cast<uint8_t>(alpha) });
+        }
+    }
+    texels.resize(texels.size() - 4);  // leaves a tail for the scalar loop
+
+    auto expected = texels;
+    PremultiplyScalar(expected.data(), expected.size() / 4);
+    PremultiplyAlpha(texels.data(), texels.size() / 4, false);
+    return texels == expected;
+}
+
+// Premultiplying sRGB leaves opaque texels as they were, clears transparent ones, and
+// comes within a step of doing it in float in between
+SCENEGRAPH_TEST(ImageConvert, PremultiplySrgb)
+{
+    auto toLinear = [](double value) { return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4); };
+    auto toSrgb = [](double value) { return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055; };
+
+    const int alphas[] = { 0, 1, 64, 128, 192, 254, 255 };
+    for (int alpha : alphas)
+    {
+        std::vector<uint8_t> texels;
+        for (int colour = 0; colour < 256; colour++)
+        {
+            texels.insert(texels.end(), { static_cast<uint8_t>(colour), static_cast<uint8_t>(colour), static_cast<uint8_t>(colour), static_cast<uint8_t>(alpha) });
+        }
+        PremultiplyAlpha(texels.data(), 256, true);
+
+        for (int colour = 0; colour < 256; colour++)
+        {
+            int result = texels[colour * 4];
+            int expected = static_cast<int>(std::lround(toSrgb(toLinear(colour / 255.0) * alpha / 255.0) * 255.0));
+            if (texels[colour * 4 + 3] != alpha || std::abs(result - expected) > 1)
+                return false;
+            if ((alpha == 255 && result != colour) || (alpha == 0 && result != 0))
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "AsyncLoader.h"
+#include "ImagePool.h"
+#include "SceneGraphTest.h"
+
+// The pool reuses a buffer that is close enough in size, frees kept ones to make room
+// for a reservation, and lets one reservation bigger than the budget through on its own
+SCENEGRAPH_TEST(ImagePool, ReusesAndFrees)
+{
+    ImagePool pool(1000);
+    pool.Reserve(400);
+    auto first = pool.Take(400);
+    bool ok = first.capacity() >= 400 && first.empty();
+    pool.Unreserve(400);
+    pool.Give(std::move(first));
+    ok = ok && pool.GetStats().freeBytes >= 400;
+
+    // 350 fits beside the kept 400, and the 400 is no more than a quarter too big for it
+    pool.Reserve(350);
+    auto second = pool.Take(350);
+    ok = ok && pool.GetStats().reuses == 1 && second.capacity() >= 400;
+    pool.Unreserve(350);
+    pool.Give(std::move(second));
+
+    // 700 doesn't fit beside it, so it goes
+    pool.Reserve(700);
+    ok = ok && pool.GetStats().freeBytes == 0;
+    pool.Unreserve(700);
+
+    pool.Reserve(5000);
+    ok = ok && pool.GetStats().reservedBytes == 5000;
+    pool.Unreserve(5000);
+
+    auto stats = pool.GetStats();
+    return ok && stats.reservedBytes == 0 && stats.peakReservedBytes == 5000 && stats.waits == 0;
+}
+
+// A loader shuts down while one load holds the whole pool, waiting for an upload that
+// never runs, and another is waiting for it: the held memory goes back and nothing hangs
+SCENEGRAPH_TEST(ImagePool, ShutdownWhileWaiting)
+{
+    const size_t bytes = 64 * 64 * 4;
+    ImagePool pool(bytes);
+
+    {
+        AsyncLoader loader(2);
+        for (int load = 0; load < 4; load++)
+        {
+            loader.Submit("waiting", [&pool, bytes]() -> AsyncLoader::UploadFunction
+            {
+                pool.Reserve(bytes);
+                auto reservation = std::shared_ptr<void>(nullptr, [&pool, bytes](void*) { pool.Unreserve(bytes); });
+                return [reservation]() { return true; };
+            });
+        }
+
+        auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        auto stats = loader.GetStats();
+        while (stats.waitingForUpload == 0 || stats.loading == 0)
+        {
+            if (std::chrono::steady_clock::now() > giveUp)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            stats = loader.GetStats();
+        }
+        loader.Shutdown();
+    }
+
+    return pool.GetStats().reservedBytes == 0;
+}
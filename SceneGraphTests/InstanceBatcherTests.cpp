@@ -0,0 +1,104 @@
+#include <vector>
+
+#include "InstanceBatcher.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    bool AlwaysInstance(const DrawPacket&) { return true; }
+}
+
+SCENEGRAPH_TEST(InstanceBatcher, RunsOfTheSameState)
+{
+    // Three of one mesh, one of another, then two of a third that can't be instanced
+    std::vector<DrawPacket> packets = {
+        { RenderQueue::MakeSortKey(1, 1, 1, 1.0f), 0 },
+        { RenderQueue::MakeSortKey(1, 1, 1, 2.0f), 1 },
+        { RenderQueue::MakeSortKey(1, 1, 1, 3.0f), 2 },
+        { RenderQueue::MakeSortKey(1, 1, 2, 1.0f), 3 },
+        { RenderQueue::MakeSortKey(1, 2, 3, 1.0f), 4 },
+        { RenderQueue::MakeSortKey(1, 2, 3, 2.0f), 5 },
+    };
+
+    InstanceBatcher batcher;
+    batcher.Build(packets, [](const DrawPacket& packet) { return packet.item < 4; });
+
+    const auto& batches = batcher.GetBatches();
+    const auto& stats = batcher.GetStats();
+    return batches.size() == 3 &&
+        batches[0].firstPacket == 0 && batches[0].packetCount == 3 && batches[0].instanced && batches[0].firstInstance == 0 &&
+        batches[1].firstPacket == 3 && batches[1].packetCount == 1 && !batches[1].instanced &&
+        batches[2].firstPacket == 4 && batches[2].packetCount == 2 && !batches[2].instanced &&
+        batcher.GetInstanceCount() == 3 && stats.drawCalls == 4 && stats.instancedBatches == 1 && stats.instances == 3;
+}
+
+SCENEGRAPH_TEST(InstanceBatcher, MinimumInstances)
+{
+    std::vector<DrawPacket> packets = {
+        { RenderQueue::MakeSortKey(1, 1, 1, 1.0f), 0 },
+        { RenderQueue::MakeSortKey(1, 1, 1, 2.0f), 1 },
+        { RenderQueue::MakeSortKey(1, 1, 2, 1.0f), 2 },
+        { RenderQueue::MakeSortKey(1, 1, 2, 2.0f), 3 },
+        { RenderQueue::MakeSortKey(1, 1, 2, 3.0f), 4 },
+    };
+
+    InstanceBatcher batcher;
+    batcher.SetMinInstances(3);
+    batcher.Build(packets, AlwaysInstance);
+
+    const auto& batches = batcher.GetBatches();
+    return batches.size() == 2 && !batches[0].instanced && batches[1].instanced && batches[1].firstInstance == 0 &&
+        batcher.GetInstanceCount() == 3 && batcher.GetStats().drawCalls == 3;
+}
+
+SCENEGRAPH_TEST(InstanceBatcher, InstanceRangesFollowPacketOrder)
+{
+    std::vector<DrawPacket> packets;
+    for (uint32_t geometry = 1; geometry <= 4; geometry++)
+    {
+        for (uint32_t copy = 0; copy < geometry + 1; copy++)
+        {
+            packets.push_back({ RenderQueue::MakeSortKey(1, 1, geometry, static_cast<float>(copy)), static_cast<uint32_t>(packets.size()) });
+        }
+    }
+
+    InstanceBatcher batcher;
+    batcher.Build(packets, AlwaysInstance);
+
+    uint32_t nextInstance = 0;
+    for (const auto& batch : batcher.GetBatches())
+    {
+        if (!batch.instanced || batch.firstInstance != nextInstance || batch.firstInstance != batch.firstPacket)
+            return false;
+        nextInstance += batch.packetCount;
+    }
+    return nextInstance == packets.size();
+}
+
+SCENEGRAPH_TEST(InstanceBatcher, WrappedIdsAreNotBatched)
+{
+    // 16384 pieces of geometry later the geometry id wraps around to the same bits as the first
+    const uint32_t wrapped = 1u << (RenderQueue::GeometryBits - RenderQueue::LodBits);
+    RenderQueue queue;
+    std::vector<int> meshes(wrapped + 1);
+    int shader;
+    for (uint32_t mesh = 0; mesh <= wrapped; mesh++)
+    {
+        queue.Submit(&shader, nullptr, &meshes[mesh], 1.0f, mesh);
+    }
+    queue.Sort();
+
+    // Going by the keys alone, the first and the last mesh end up in one batch
+    InstanceBatcher batcher;
+    batcher.Build(queue.GetPackets(), AlwaysInstance);
+    bool merged = batcher.GetInstanceCount() == 2;
+
+    // Asked whether the packets really draw the same thing, they're split again
+    batcher.Build(queue.GetPackets(), AlwaysInstance, [](const DrawPacket& first, const DrawPacket& packet)
+        {
+            return first.item == packet.item;
+        });
+    bool split = batcher.GetInstanceCount() == 0 && batcher.GetBatches().size() == wrapped + 1;
+
+    return merged && split;
+}
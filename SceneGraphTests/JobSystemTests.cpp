@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief Run one ParallelFor and check every index in [0, count) was handed out exactly once,
+    /// in ranges no longer than the grain (with more than one worker, which splits the work)
+    bool VisitsEachIndexOnce(JobSystem& jobs, uint32_t count, uint32_t grainSize)
+    {
+        std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[count + 1]);
+        for (uint32_t index = 0; index <= count; index++)
+        {
+            visits[index] = 0;
+        }
+
+        std::atomic<bool> badRange = false;
+        jobs.ParallelFor(count, grainSize, [&](uint32_t begin, uint32_t end)
+            {
+                if (begin >= end || end > count || end - begin > std::max(1u, grainSize))
+                    badRange = true;
+                for (uint32_t index = begin; index < end && index < count; index++)
+                {
+                    visits[index]++;
+                }
+            });
+
+        for (uint32_t index = 0; index < count; index++)
+        {
+            if (visits[index] != 1)
+                return false;
+        }
+        return !badRange;
+    }
+}
+
+SCENEGRAPH_TEST(JobSystem, EveryIndexOnce)
+{
+    JobSystem jobs(4);
+    const uint32_t count = 1000;
+
+    // Grains smaller than, equal to and larger than the count, and ones that don't divide it
+    for (uint32_t grainSize : { 1u, 7u, 64u, 999u, 1000u, 1001u, 100000u })
+    {
+        if (!VisitsEachIndexOnce(jobs, count, grainSize))
+            return false;
+    }
+
+    // A grain of 0 is taken as 1
+    return VisitsEachIndexOnce(jobs, 100, 0);
+}
+
+SCENEGRAPH_TEST(JobSystem, ZeroCount)
+{
+    JobSystem jobs(4);
+    bool called = false;
+    jobs.ParallelFor(0, 16, [&](uint32_t, uint32_t) { called = true; });
+    return !called;
+}
+
+SCENEGRAPH_TEST(JobSystem, BackToBackDispatches)
+{
+    // Each call has to have finished, every chunk of it, before the next starts handing out work
+    JobSystem jobs(4);
+    std::vector<uint32_t> values(4096, 0);
+    for (uint32_t round = 0; round < 200; round++)
+    {
+        jobs.ParallelFor(static_cast<uint32_t>(values.size()), 1 + round % 100, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t index = begin; index < end; index++)
+                {
+                    values[index]++;
+                }
+            });
+
+        for (uint32_t value : values)
+        {
+            if (value != round + 1)
+                return false;
+        }
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(JobSystem, OneWorkerRunsOnCaller)
+{
+    JobSystem jobs(1);
+    const std::thread::id caller = std::this_thread::get_id();
+    bool elsewhere = false;
+    uint32_t calls = 0;
+    jobs.ParallelFor(1000, 10, [&](uint32_t begin, uint32_t end)
+        {
+            elsewhere |= std::this_thread::get_id() != caller;
+            calls++;
+
+            // With nobody to share with, the whole range comes in one call
+            elsewhere |= begin != 0 || end != 1000;
+        });
+
+    return jobs.GetWorkerCount() == 1 && calls == 1 && !elsewhere;
+}
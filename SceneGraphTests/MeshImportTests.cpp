@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MeshImport.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief A face the way assimp keeps one
+    struct TestFace
+    {
+        unsigned int mNumIndices = 0;
+        const unsigned int* mIndices = nullptr;
+    };
+
+    /// @brief The arrays of one source mesh, which a SourceMeshView looks into
+    struct TestMesh
+    {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texCoords;
+        std::vector<unsigned int> faceIndices;
+        std::vector<TestFace> faces;
+        uint32_t vertexCount = 0;
+        uint32_t materialIndex = 0;
+    };
+
+    /// @brief A strip of triangles along x, placed by the mesh's number so every vertex of the scene
+    /// is somewhere of its own
+    /// @param faceSizes Repeated over the strip: 3 for a triangle, else a face that isn't one
+    TestMesh MakeStrip(uint32_t meshIndex, uint32_t vertexCount, uint32_t materialIndex, bool normals, bool texCoords, const std::vector<uint32_t>& faceSizes = { 3 })
+    {
+        TestMesh mesh;
+        mesh.vertexCount = vertexCount;
+        mesh.materialIndex = materialIndex;
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            const float position[3] = { meshIndex * 100000.0f + vertex / 2, static_cast<float>(vertex % 2), static_cast<float>(meshIndex) };
+            mesh.positions.insert(mesh.positions.end(), position, position + 3);
+            if (normals)
+            {
+                const float normal[3] = { 0.0f, 0.0f, vertex % 2 == 0 ? 1.0f : -1.0f };
+                mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+            }
+            if (texCoords)
+            {
+                const float uvw[3] = { vertex * 0.5f, static_cast<float>(meshIndex), 0.0f };
+                mesh.texCoords.insert(mesh.texCoords.end(), uvw, uvw + 3);
+            }
+        }
+
+        // The indices go in first and the faces point into them after, once they've stopped moving
+        std::vector<uint32_t> sizes;
+        for (uint32_t first = 0; first + 3 <= vertexCount; first++)
+        {
+            uint32_t size = std::min(faceSizes[first % faceSizes.size()], vertexCount - first);
+            for (uint32_t corner = 0; corner < size; corner++)
+            {
+                mesh.faceIndices.push_back(first + corner);
+            }
+            sizes.push_back(size);
+        }
+        size_t next = 0;
+        for (auto size : sizes)
+        {
+            mesh.faces.push_back(TestFace{ size, mesh.faceIndices.data() + next });
+            next += size;
+        }
+        return mesh;
+    }
+
+    std::vector<SourceMeshView<TestFace>> MakeViews(const std::vector<TestMesh>& meshes)
+    {
+        std::vector<SourceMeshView<TestFace>> views;
+        for (const auto& mesh : meshes)
+        {
+            SourceMeshView<TestFace> view;
+            view.positions = mesh.positions.data();
+            view.normals = mesh.normals.empty() ? nullptr : mesh.normals.data();
+            view.texCoords = mesh.texCoords.empty() ? nullptr : mesh.texCoords.data();
+            view.vertexCount = mesh.vertexCount;
+            view.faces = mesh.faces.data();
+            view.faceCount = static_cast<uint32_t>(mesh.faces.size());
+            view.materialIndex = mesh.materialIndex;
+            views.push_back(view);
+        }
+        return views;
+    }
+
+    /// @brief Meshes of many sizes, most of them more than a chunk and few a whole number of them
+    std::vector<TestMesh> MakeLargeScene(uint32_t meshCount)
+    {
+        std::vector<TestMesh> meshes;
+        for (uint32_t mesh = 0; mesh < meshCount; mesh++)
+        {
+            meshes.push_back(MakeStrip(mesh, 10000 + mesh * 7919 % 40000, mesh % 5, true, true));
+        }
+        return meshes;
+    }
+
+    template <typename TVertex>
+    struct MergedScene
+    {
+        std::vector<TVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+        MergedSceneLayout layout;
+
+        bool operator==(const MergedScene& other) const
+        {
+            return vertices.size() == other.vertices.size() && indices == other.indices && triangleMaterials == other.triangleMaterials
+                && std::memcmp(vertices.data(), other.vertices.data(), vertices.size() * sizeof(TVertex)) == 0;
+        }
+    };
+
+    template <typename TVertex>
+    MergedScene<TVertex> Merge(const std::vector<TestMesh>& meshes, JobSystem* jobs = nullptr)
+    {
+        MergedScene<TVertex> merged;
+        merged.layout = MergeSourceMeshes(MakeViews(meshes), merged.vertices, merged.indices, merged.triangleMaterials, jobs);
+        return merged;
+    }
+
+    /// @brief Every triangle of the source, in order, is in the merged buffers with the corners and
+    /// material of its own mesh
+    template <typename TVertex>
+    bool MatchesSource(const std::vector<TestMesh>& meshes, const MergedScene<TVertex>& merged)
+    {
+        size_t triangle = 0;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& face : mesh.faces)
+            {
+                if (face.mNumIndices != 3)
+                    continue;
+                if (triangle >= merged.triangleMaterials.size() || merged.triangleMaterials[triangle] != mesh.materialIndex)
+                    return false;
+
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t index = merged.indices[triangle * 3 + corner];
+                    if (index >= merged.vertices.size())
+                        return false;
+
+                    const auto& vertex = merged.vertices[index];
+                    const float* position = mesh.positions.data() + static_cast<size_t>(face.mIndices[corner]) * 3;
+                    if (vertex.x != position[0] || vertex.y != position[1] || vertex.z != position[2])
+                        return false;
+                }
+                triangle++;
+            }
+        }
+        return triangle == merged.triangleMaterials.size() && merged.indices.size() == triangle * 3;
+    }
+}
+
+// Each mesh's indices start after the vertices of the meshes before it
+SCENEGRAPH_TEST(MeshImport, Offsets)
+{
+    std::vector<TestMesh> meshes;
+    meshes.push_back(MakeStrip(0, 5, 0, true, true));
+    meshes.push_back(MakeStrip(1, 17, 1, true, true));
+    meshes.push_back(MakeStrip(2, 4, 2, true, true));
+
+    auto merged = Merge<VertexNormalUV>(meshes);
+    const std::vector<size_t> firstVertex = { 0, 5, 22 };
+    return merged.layout.firstVertex == firstVertex && merged.vertices.size() == 26 && merged.layout.triangleCount == 3 + 15 + 2
+        && MatchesSource(meshes, merged);
+}
+
+// Faces that aren't triangles are counted and left out, and the triangles after them
+// keep their place
+SCENEGRAPH_TEST(MeshImport, SkippedFaces)
+{
+    std::vector<TestMesh> meshes;
+    meshes.push_back(MakeStrip(0, 12, 0, true, false, { 3, 2, 3, 4 }));
+    meshes.push_back(MakeStrip(1, 9, 1, true, false));
+
+    auto merged = Merge<VertexNormal>(meshes);
+    return merged.layout.skippedFaces == 5 && merged.layout.triangleCount == 5 + 7 && MatchesSource(meshes, merged);
+}
+
+// A mesh without normals gets +Y and one without texture coordinates gets 0, 0, while
+// the meshes beside them keep their own
+SCENEGRAPH_TEST(MeshImport, Defaults)
+{
+    std::vector<TestMesh> meshes;
+    meshes.push_back(MakeStrip(0, 6, 0, true, true));
+    meshes.push_back(MakeStrip(1, 6, 0, false, false));
+
+    auto merged = Merge<VertexNormalUV>(meshes);
+    if (!MatchesSource(meshes, merged))
+        return false;
+
+    for (uint32_t vertex = 0; vertex < 6; vertex++)
+    {
+        const auto& own = merged.vertices[vertex];
+        const auto& defaulted = merged.vertices[6 + vertex];
+        if (own.nz != meshes[0].normals[vertex * 3 + 2] || own.u != vertex * 0.5f || own.v != 0.0f)
+            return false;
+        if (defaulted.nx != 0.0f || defaulted.ny != 1.0f || defaulted.nz != 0.0f || defaulted.u != 0.0f || defaulted.v != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Meshes with nothing in them take no room and don't move the meshes after them
+SCENEGRAPH_TEST(MeshImport, EmptyMeshes)
+{
+    std::vector<TestMesh> meshes;
+    meshes.push_back(MakeStrip(0, 0, 0, true, true));
+    meshes.push_back(MakeStrip(1, 7, 1, true, true));
+    meshes.push_back(MakeStrip(2, 2, 2, true, true));   // vertices but no faces
+    meshes.push_back(MakeStrip(3, 0, 3, true, true));
+    meshes.push_back(MakeStrip(4, 5, 4, true, true));
+
+    auto merged = Merge<VertexNormalUV>(meshes);
+    const std::vector<size_t> firstVertex = { 0, 0, 7, 9, 9 };
+    return merged.layout.firstVertex == firstVertex && merged.vertices.size() == 14 && MatchesSource(meshes, merged)
+        && Merge<VertexNormalUV>({}).vertices.empty();
+}
+
+// Filling the chunks across a JobSystem gives the same bytes as filling them in order
+SCENEGRAPH_TEST(MeshImport, Parallel)
+{
+    auto meshes = MakeLargeScene(8);
+    meshes.push_back(MakeStrip(8, c_mergeChunkSize * 2, 1, false, false, { 3, 3, 5 }));
+
+    auto serial = Merge<VertexNormalUV>(meshes);
+    if (serial.layout.vertexChunks.size() <= meshes.size() || !MatchesSource(meshes, serial))
+        return false;
+
+    JobSystem jobs(4);
+    return Merge<VertexNormalUV>(meshes, &jobs) == serial && Merge<VertexNormal>(meshes, &jobs).indices == serial.indices;
+}
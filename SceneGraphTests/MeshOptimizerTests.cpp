@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "ProceduralGeometry.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    /// @brief A vertex that remembers where it started, so reordered vertices can be traced back
+    struct TracedVertex
+    {
+        float x, y, z;
+        uint32_t source;
+    };
+
+    /// @brief The triangles of an index list, each rotated to start at its smallest index so the
+    /// winding is kept but the starting corner doesn't matter, then sorted
+    std::vector<Triangle> SortedTriangles(const std::vector<uint32_t>& indices)
+    {
+        std::vector<Triangle> triangles;
+        for (size_t first = 0; first + 2 < indices.size(); first += 3)
+        {
+            Triangle triangle = { indices[first], indices[first + 1], indices[first + 2] };
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    bool SameTriangles(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+    {
+        return SortedTriangles(a) == SortedTriangles(b);
+    }
+
+    /// @brief Shuffle whole triangles, the worst case for the vertex cache
+    void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed)
+    {
+        std::vector<Triangle> triangles;
+        for (size_t first = 0; first + 2 < indices.size(); first += 3)
+        {
+            triangles.push_back({ indices[first], indices[first + 1], indices[first + 2] });
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+        indices.clear();
+        for (const auto& triangle : triangles)
+        {
+            indices.insert(indices.end(), triangle.begin(), triangle.end());
+        }
+    }
+
+    /// @brief Transforms by a cache kept the obvious way, as a queue of the vertices in it
+    size_t ReferenceTransforms(const std::vector<uint32_t>& indices, uint32_t cacheSize, VertexCachePolicy policy)
+    {
+        std::deque<uint32_t> cache;
+        size_t transforms = 0;
+        for (auto vertex : indices)
+        {
+            auto found = std::find(cache.begin(), cache.end(), vertex);
+            if (found == cache.end())
+            {
+                transforms++;
+                cache.push_front(vertex);
+                if (cache.size() > cacheSize)
+                    cache.pop_back();
+            }
+            else if (policy == VertexCachePolicy::Lru)
+            {
+                cache.erase(found);
+                cache.push_front(vertex);
+            }
+        }
+        return transforms;
+    }
+
+    float Acmr(const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        return SimulateVertexCache(indices.data(), indices.size(), vertexCount, c_fifoVertexCacheSize, VertexCachePolicy::Fifo).acmr;
+    }
+
+    /// @brief Every vertex of a primitive, marked with its own index
+    std::vector<TracedVertex> TraceVertices(const PrimitiveMesh& mesh)
+    {
+        std::vector<TracedVertex> vertices;
+        for (const auto& vertex : mesh.vertices)
+        {
+            vertices.push_back(TracedVertex{ vertex.x, vertex.y, vertex.z, static_cast<uint32_t>(vertices.size()) });
+        }
+        return vertices;
+    }
+
+    /// @brief The triangles of a reordered mesh, in the vertices it started with
+    std::vector<uint32_t> SourceIndices(const std::vector<uint32_t>& indices, const std::vector<TracedVertex>& vertices)
+    {
+        std::vector<uint32_t> source;
+        for (auto index : indices)
+        {
+            source.push_back(vertices[index].source);
+        }
+        return source;
+    }
+
+    const PrimitiveDesc c_grid = MakeGridDesc(10.0f, 10.0f, 48, 48);
+    const PrimitiveDesc c_sphere = MakeSphereDesc(1.0f, 48, 24);
+}
+
+SCENEGRAPH_TEST(MeshOptimizer, SimulateVertexCache)
+{
+    // Two triangles sharing an edge: four transforms, each vertex once
+    std::vector<uint32_t> quad = { 0, 1, 2, 0, 2, 3 };
+    VertexCacheStats stats = SimulateVertexCache(quad.data(), quad.size(), 4, c_fifoVertexCacheSize, VertexCachePolicy::Fifo);
+    bool known = stats.triangleCount == 2 && stats.vertexCount == 4 && stats.transforms == 4 && Near(stats.acmr, 2.0f) && Near(stats.atvr, 1.0f);
+
+    // A reused vertex stays in an LRU cache but not in a FIFO one
+    std::vector<uint32_t> reuse = { 0, 1, 2, 0, 3, 4, 0, 5, 6 };
+    bool policies = SimulateVertexCache(reuse.data(), reuse.size(), 7, 3, VertexCachePolicy::Lru).transforms == 7 &&
+        SimulateVertexCache(reuse.data(), reuse.size(), 7, 3, VertexCachePolicy::Fifo).transforms == 8;
+
+    // And against the obvious cache on random streams, small enough to hit now and again
+    std::mt19937 random(5);
+    bool matches = true;
+    for (uint32_t cacheSize : { 3u, 8u, c_fifoVertexCacheSize, c_lruVertexCacheSize })
+    {
+        std::vector<uint32_t> indices(3000);
+        for (auto& index : indices)
+        {
+            index = random() % 48;
+        }
+        for (auto policy : { VertexCachePolicy::Fifo, VertexCachePolicy::Lru })
+        {
+            matches &= SimulateVertexCache(indices.data(), indices.size(), 48, cacheSize, policy).transforms == ReferenceTransforms(indices, cacheSize, policy);
+        }
+    }
+
+    return known && policies && matches;
+}
+
+SCENEGRAPH_TEST(MeshOptimizer, VertexCacheOrder)
+{
+    for (const auto& desc : { c_grid, c_sphere })
+    {
+        PrimitiveMesh mesh = GeneratePrimitive(desc);
+        size_t vertexCount = mesh.vertices.size();
+
+        // Optimizing never loses or flips a triangle, and never makes the cache do worse, whether the
+        // triangles start in the generator's order or shuffled
+        for (bool shuffle : { false, true })
+        {
+            std::vector<uint32_t> indices = mesh.indices;
+            if (shuffle)
+                ShuffleTriangles(indices, 11);
+            std::vector<uint32_t> optimized = indices;
+            OptimizeVertexCache(optimized.data(), optimized.size(), vertexCount);
+
+            float before = Acmr(indices, vertexCount);
+            float after = Acmr(optimized, vertexCount);
+            if (!SameTriangles(indices, optimized) || after > before || (shuffle && after > 0.5f * before))
+                return false;
+        }
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(MeshOptimizer, OverdrawOrder)
+{
+    PrimitiveMesh mesh = GeneratePrimitive(c_sphere);
+    std::vector<uint32_t> indices = mesh.indices;
+    OptimizeVertexCache(indices.data(), indices.size(), mesh.vertices.size());
+    float cached = Acmr(indices, mesh.vertices.size());
+
+    // Within the threshold the triangles may move, but only whole, and the cache stays within it
+    std::vector<uint32_t> reordered = indices;
+    OptimizeOverdraw(reordered.data(), reordered.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), 1.05f);
+    bool kept = SameTriangles(indices, reordered) && Acmr(reordered, mesh.vertices.size()) <= cached * 1.05f;
+
+    // A threshold nothing can meet leaves the order alone
+    std::vector<uint32_t> untouched = indices;
+    bool refused = !OptimizeOverdraw(untouched.data(), untouched.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), 0.0f) &&
+        untouched == indices;
+
+    return kept && refused;
+}
+
+SCENEGRAPH_TEST(MeshOptimizer, VertexFetchRemap)
+{
+    PrimitiveMesh mesh = GeneratePrimitive(c_sphere);
+    std::vector<TracedVertex> vertices = TraceVertices(mesh);
+
+    // Leave a few vertices out; they should be dropped
+    std::vector<uint32_t> indices(mesh.indices.begin() + 30, mesh.indices.end());
+    ShuffleTriangles(indices, 3);
+    std::vector<uint32_t> remapped = indices;
+    size_t used = OptimizeVertexFetch(remapped.data(), remapped.size(), vertices.data(), vertices.size(), sizeof(TracedVertex));
+
+    std::vector<uint32_t> usedVertices = indices;
+    std::sort(usedVertices.begin(), usedVertices.end());
+    usedVertices.erase(std::unique(usedVertices.begin(), usedVertices.end()), usedVertices.end());
+
+    // Every index still finds its vertex, and vertices come in the order they are first used
+    bool consistent = used == usedVertices.size() && SourceIndices(remapped, vertices) == indices;
+    uint32_t nextNew = 0;
+    for (auto index : remapped)
+    {
+        if (index > nextNew)
+            return false;
+        if (index == nextNew)
+            nextNew++;
+    }
+    return consistent && nextNew == used;
+}
+
+SCENEGRAPH_TEST(MeshOptimizer, OptimizeMesh)
+{
+    PrimitiveMesh mesh = GeneratePrimitive(c_sphere);
+    std::vector<TracedVertex> vertices = TraceVertices(mesh);
+    std::vector<uint32_t> indices = mesh.indices;
+    ShuffleTriangles(indices, 7);
+
+    // Two ranges, whose triangles must stay in them
+    uint32_t split = static_cast<uint32_t>(indices.size() / 3 / 2 * 3);
+    std::vector<IndexRange> ranges = { IndexRange{ 0, split }, IndexRange{ split, static_cast<uint32_t>(indices.size()) - split } };
+    std::vector<uint32_t> optimized = indices;
+    size_t vertexCount = vertices.size();
+    MeshOptimizationReport report = OptimizeMesh(vertices.data(), vertexCount, sizeof(TracedVertex), optimized, ranges);
+
+    std::vector<uint32_t> source = SourceIndices(optimized, vertices);
+    bool ranged = SameTriangles(std::vector<uint32_t>(source.begin(), source.begin() + split), std::vector<uint32_t>(indices.begin(), indices.begin() + split)) &&
+        SameTriangles(std::vector<uint32_t>(source.begin() + split, source.end()), std::vector<uint32_t>(indices.begin() + split, indices.end()));
+
+    bool reported = report.optimized && report.verticesBefore == mesh.vertices.size() && report.verticesAfter == vertexCount &&
+        report.fifoAfter.acmr < report.fifoBefore.acmr && report.lruAfter.acmr < report.lruBefore.acmr &&
+        report.fifoAfter.triangleCount == report.fifoBefore.triangleCount && Near(report.fifoAfter.atvr * vertexCount, static_cast<float>(report.fifoAfter.transforms), 0.5f);
+
+    // An index past the end leaves everything as it was
+    std::vector<uint32_t> bad = { 0, 1, 2, 0, 2, static_cast<uint32_t>(vertexCount) };
+    std::vector<uint32_t> badCopy = bad;
+    size_t badCount = vertexCount;
+    MeshOptimizationReport refused = OptimizeMesh(vertices.data(), badCount, sizeof(TracedVertex), bad, { IndexRange{ 0, 6 } });
+
+    return ranged && reported && !refused.optimized && bad == badCopy && badCount == vertexCount;
+}
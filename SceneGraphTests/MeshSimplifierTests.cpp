@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "LodSelection.h"
+#include "MeshSimplifier.h"
+#include "ProceduralGeometry.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    using Edge = std::pair<uint32_t, uint32_t>;
+
+    /// @brief The edges of a triangle list that only one triangle uses
+    std::set<Edge> BorderEdges(const std::vector<uint32_t>& indices)
+    {
+        std::map<Edge, int> uses;
+        for (size_t first = 0; first + 2 < indices.size(); first += 3)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t a = indices[first + corner];
+                uint32_t b = indices[first + (corner + 1) % 3];
+                uses[Edge{ std::min(a, b), std::max(a, b) }]++;
+            }
+        }
+
+        std::set<Edge> border;
+        for (const auto& edge : uses)
+        {
+            if (edge.second == 1)
+                border.insert(edge.first);
+        }
+        return border;
+    }
+
+    /// @brief Are all of the given vertices still used by some triangle?
+    bool AllUsed(const std::vector<uint32_t>& vertices, const std::vector<uint32_t>& indices)
+    {
+        std::set<uint32_t> used(indices.begin(), indices.end());
+        return std::all_of(vertices.begin(), vertices.end(), [&](uint32_t vertex) { return used.count(vertex) != 0; });
+    }
+
+    /// @brief Every triangle of a level uses three different vertices of the mesh
+    bool ValidTriangles(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+    {
+        for (size_t first = 0; first + 2 < indexCount; first += 3)
+        {
+            uint32_t a = indices[first], b = indices[first + 1], c = indices[first + 2];
+            if (a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c)
+                return false;
+        }
+        return indexCount % 3 == 0;
+    }
+
+    /// @brief A grid with a bump in the middle, so collapsing its inside isn't free
+    PrimitiveMesh MakeBumpyGrid()
+    {
+        PrimitiveMesh mesh = GeneratePrimitive(MakeGridDesc(10.0f, 10.0f, 40, 40));
+        for (auto& vertex : mesh.vertices)
+        {
+            vertex.y = std::exp(-(vertex.x * vertex.x + vertex.z * vertex.z) / 8.0f);
+        }
+        return mesh;
+    }
+}
+
+SCENEGRAPH_TEST(MeshSimplifier, LodChainShrinks)
+{
+    PrimitiveMesh mesh = GeneratePrimitive(MakeSphereDesc(1.0f, 64, 32));
+    LodChain chain = BuildLodChain(mesh.vertices, mesh.indices);
+    if (chain.levels.size() != c_maxLodLevels)
+        return false;
+
+    // Level 0 is the mesh itself; each one after has fewer triangles and at least as much error
+    bool first = chain.levels[0].firstIndex == 0 && chain.levels[0].indexCount == mesh.indices.size() && chain.levels[0].error == 0.0f &&
+        std::equal(mesh.indices.begin(), mesh.indices.end(), chain.indices.begin());
+    for (size_t level = 1; level < chain.levels.size(); level++)
+    {
+        const LodLevel& finer = chain.levels[level - 1];
+        const LodLevel& lod = chain.levels[level];
+        if (lod.firstIndex != finer.firstIndex + finer.indexCount || lod.indexCount >= finer.indexCount || lod.error < finer.error ||
+            !(lod.error > 0.0f) || !ValidTriangles(chain.indices.data() + lod.firstIndex, lod.indexCount, mesh.vertices.size()))
+        {
+            return false;
+        }
+    }
+
+    const LodLevel& last = chain.levels.back();
+    return first && last.firstIndex + last.indexCount == chain.indices.size();
+}
+
+SCENEGRAPH_TEST(MeshSimplifier, SmallMeshesStop)
+{
+    // Half of a mesh this small would be under c_minLodTriangles, so it has no levels to add
+    PrimitiveMesh cube = GeneratePrimitive(MakeCubeDesc(1.0f, 2));
+    LodChain chain = BuildLodChain(cube.vertices, cube.indices);
+    return cube.indices.size() / 3 / 2 < c_minLodTriangles && chain.levels.size() == 1 && chain.indices == cube.indices;
+}
+
+SCENEGRAPH_TEST(MeshSimplifier, KeepsBorders)
+{
+    PrimitiveMesh mesh = MakeBumpyGrid();
+    std::vector<uint32_t> simplified = SimplifyMesh(mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), mesh.indices, mesh.indices.size() / 8, INFINITY);
+
+    // The inside goes, but the open edge of the grid stays exactly where it was
+    return simplified.size() < mesh.indices.size() / 2 && ValidTriangles(simplified.data(), simplified.size(), mesh.vertices.size()) &&
+        BorderEdges(simplified) == BorderEdges(mesh.indices);
+}
+
+SCENEGRAPH_TEST(MeshSimplifier, KeepsSeams)
+{
+    // The sphere's texture seam runs down one meridian, with two vertices at every point of it
+    PrimitiveMesh mesh = GeneratePrimitive(MakeSphereDesc(1.0f, 48, 24));
+    std::map<std::vector<float>, std::vector<uint32_t>> byPosition;
+    for (uint32_t vertex = 0; vertex < mesh.vertices.size(); vertex++)
+    {
+        const auto& position = mesh.vertices[vertex];
+        byPosition[{ position.x, position.y, position.z }].push_back(vertex);
+    }
+
+    std::set<uint32_t> seam;
+    for (const auto& shared : byPosition)
+    {
+        if (shared.second.size() == 2)
+            seam.insert(shared.second.begin(), shared.second.end());
+    }
+
+    // Both sides of it have to stay, vertex for vertex, or the texture would tear open along it
+    std::vector<uint32_t> simplified = SimplifyMesh(mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), mesh.indices, mesh.indices.size() / 4, INFINITY);
+    std::set<Edge> seamEdges, keptEdges;
+    for (const auto& edge : BorderEdges(mesh.indices))
+    {
+        if (seam.count(edge.first) && seam.count(edge.second))
+            seamEdges.insert(edge);
+    }
+    for (const auto& edge : BorderEdges(simplified))
+    {
+        if (seamEdges.count(edge))
+            keptEdges.insert(edge);
+    }
+
+    return seam.size() == 2 * (24 - 1) && seamEdges.size() == 2 * (24 - 2) && simplified.size() < mesh.indices.size() / 2 &&
+        AllUsed(std::vector<uint32_t>(seam.begin(), seam.end()), simplified) && keptEdges == seamEdges;
+}
+
+SCENEGRAPH_TEST(MeshSimplifier, MaxError)
+{
+    // A curved surface can't lose anything for free, so no error allowed leaves it whole, and a
+    // small one stops the collapses there
+    PrimitiveMesh mesh = MakeBumpyGrid();
+    float error = -1.0f;
+    std::vector<uint32_t> none = SimplifyMesh(mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), mesh.indices, 0, 0.0f, &error);
+    bool whole = none.size() == mesh.indices.size() && error == 0.0f;
+
+    float limited = 0.0f;
+    std::vector<uint32_t> some = SimplifyMesh(mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), mesh.indices, 0, 1e-3f, &limited);
+    float unlimited = 0.0f;
+    std::vector<uint32_t> all = SimplifyMesh(mesh.vertices.data(), mesh.vertices.size(), sizeof(VertexNormalUV), mesh.indices, 0, INFINITY, &unlimited);
+    return whole && limited <= 1e-3f && some.size() < mesh.indices.size() && all.size() < some.size() && unlimited > limited;
+}
+
+SCENEGRAPH_TEST(LodSelection, ProjectionScale)
+{
+    // A 90 degree field of view over 1000 pixels: 500 pixels per unit at distance 1
+    return Near(ComputeProjectionScale(3.14159265f * 0.5f, 1000.0f), 500.0f, 1e-2f) &&
+        Near(ComputeProjectionScale(3.14159265f / 3.0f, 600.0f), 300.0f * std::sqrt(3.0f), 1e-2f);
+}
+
+SCENEGRAPH_TEST(LodSelection, SwitchDistances)
+{
+    LodView view;
+    view.projectionScale = 500.0f;
+    view.maxPixelError = 1.0f;
+    const float center[3] = { 0.0f, 0.0f, 0.0f };
+    const float errors[c_maxLodLevels] = { 0.0f, 0.01f, 0.1f, 1.0f };
+
+    // A level is drawn once error * 500 / (distance - radius) drops to a pixel: with a radius of 1,
+    // level 1 from 6 units out, level 2 from 51 and level 3 from 501
+    auto lodAt = [&](float distance, float worldScale = 1.0f, float radius = 1.0f)
+        {
+            view.eye[2] = -distance;
+            return SelectLod(view, center, radius, worldScale, errors, c_maxLodLevels);
+        };
+    bool switches = lodAt(0.0f) == 0 && lodAt(5.9f) == 0 && lodAt(6.1f) == 1 && lodAt(50.9f) == 1 && lodAt(51.1f) == 2 &&
+        lodAt(500.0f) == 2 && lodAt(502.0f) == 3 && lodAt(1e6f) == 3;
+
+    // Twice the scale doubles the error; a bigger sphere brings its surface closer
+    bool scaled = lodAt(10.0f, 2.0f) == 0 && lodAt(12.0f, 2.0f) == 1 && lodAt(6.5f, 1.0f, 1.0f) == 1 && lodAt(6.5f, 1.0f, 2.0f) == 0;
+
+    // Fewer levels, or no projection, limit the choice
+    view.eye[2] = -1e6f;
+    bool limited = SelectLod(view, center, 1.0f, 1.0f, errors, 2) == 1 && SelectLod(view, center, 1.0f, 1.0f, errors, 1) == 0;
+    view.projectionScale = 0.0f;
+    return switches && scaled && limited && SelectLod(view, center, 1.0f, 1.0f, errors, c_maxLodLevels) == 0;
+}
@@ -0,0 +1,124 @@
+#include <vector>
+
+#include "MeshSplitter.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief A triangle strip written out as a list: triangle i is (i, i + 1, i + 2), so after the
+    /// first each triangle brings one new vertex
+    std::vector<uint32_t> MakeStrip(uint32_t vertexCount)
+    {
+        std::vector<uint32_t> indices;
+        for (uint32_t first = 0; first + 2 < vertexCount; first++)
+        {
+            indices.insert(indices.end(), { first, first + 1, first + 2 });
+        }
+        return indices;
+    }
+
+    /// @brief Two triangles to every cell of a grid of columns x rows vertices
+    std::vector<uint32_t> MakeGrid(uint32_t columns, uint32_t rows)
+    {
+        std::vector<uint32_t> indices;
+        for (uint32_t row = 0; row + 1 < rows; row++)
+        {
+            for (uint32_t column = 0; column + 1 < columns; column++)
+            {
+                uint32_t corner = row * columns + column;
+                indices.insert(indices.end(), { corner, corner + columns, corner + 1, corner + 1, corner + columns, corner + columns + 1 });
+            }
+        }
+        return indices;
+    }
+
+    /// @brief Do the clusters stay within their vertex budget, and do their triangles, taken back
+    /// to the source mesh's vertices, come to exactly the source's triangles in the same order?
+    bool SplitIsLossless(const std::vector<MeshCluster>& clusters, const std::vector<uint32_t>& indices, size_t maxClusterVertices)
+    {
+        std::vector<uint32_t> rebuilt;
+        for (const auto& cluster : clusters)
+        {
+            if (cluster.vertices.size() > maxClusterVertices || cluster.indices.empty() || cluster.indices.size() % 3 != 0)
+                return false;
+            for (auto index : cluster.indices)
+            {
+                if (index >= cluster.vertices.size())
+                    return false;
+                rebuilt.push_back(cluster.vertices[index]);
+            }
+        }
+        return rebuilt == indices;
+    }
+}
+
+SCENEGRAPH_TEST(MeshSplitter, FitsShortIndices)
+{
+    // Triangle lists can use 0xffff as an ordinary index, so 65536 vertices still fit
+    return FitsShortIndices(0) && FitsShortIndices(3) && FitsShortIndices(65535) && FitsShortIndices(65536) &&
+        !FitsShortIndices(65537) && !FitsShortIndices(1u << 20);
+}
+
+SCENEGRAPH_TEST(MeshSplitter, NarrowIndices)
+{
+    std::vector<uint32_t> indices = { 0, 1, 2, 65534, 65535, 300 };
+    std::vector<uint16_t> narrowed = NarrowIndices(indices);
+    return narrowed == std::vector<uint16_t>{ 0, 1, 2, 65534, 65535, 300 } && NarrowIndices({}).empty();
+}
+
+SCENEGRAPH_TEST(MeshSplitter, ShortIndexBoundary)
+{
+    // Exactly as many vertices as 16 bit indices reach stays in one cluster, and one more doesn't
+    std::vector<uint32_t> fits = MakeStrip(65536);
+    std::vector<MeshCluster> one = SplitMesh(fits, 65536);
+    bool boundary = one.size() == 1 && one[0].vertices.size() == 65536 && one[0].indices.back() == 65535 &&
+        SplitIsLossless(one, fits, c_maxShortIndexVertices);
+
+    std::vector<uint32_t> over = MakeStrip(65537);
+    std::vector<MeshCluster> two = SplitMesh(over, 65537);
+    return boundary && two.size() == 2 && SplitIsLossless(two, over, c_maxShortIndexVertices);
+}
+
+SCENEGRAPH_TEST(MeshSplitter, SharedVerticesCopied)
+{
+    // The second triangle needs two new vertices where the first cluster has room for one, so it
+    // starts a cluster of its own with its own copy of the vertex the two share
+    std::vector<uint32_t> indices = { 0, 1, 2, 2, 3, 4 };
+    std::vector<MeshCluster> clusters = SplitMesh(indices, 5, 4);
+    return clusters.size() == 2 &&
+        clusters[0].vertices == std::vector<uint32_t>{ 0, 1, 2 } && clusters[0].indices == std::vector<uint16_t>{ 0, 1, 2 } &&
+        clusters[1].vertices == std::vector<uint32_t>{ 2, 3, 4 } && clusters[1].indices == std::vector<uint16_t>{ 0, 1, 2 } &&
+        SplitIsLossless(clusters, indices, 4);
+}
+
+SCENEGRAPH_TEST(MeshSplitter, LargeMeshLossless)
+{
+    // 300 x 300 vertices is 90000, too many for one cluster
+    const uint32_t columns = 300, rows = 300;
+    std::vector<uint32_t> indices = MakeGrid(columns, rows);
+    std::vector<MeshCluster> clusters = SplitMesh(indices, columns * rows);
+
+    // Only the rows along the seams between clusters should be copied
+    size_t clusterVertices = 0;
+    for (const auto& cluster : clusters)
+    {
+        clusterVertices += cluster.vertices.size();
+    }
+
+    std::vector<MeshCluster> small = SplitMesh(indices, columns * rows, 1000);
+    return clusters.size() == 2 && SplitIsLossless(clusters, indices, c_maxShortIndexVertices) &&
+        clusterVertices <= columns * rows + 2 * columns &&
+        small.size() > 90 && SplitIsLossless(small, indices, 1000);
+}
+
+SCENEGRAPH_TEST(MeshSplitter, DropsBadTriangles)
+{
+    // A triangle past the vertex count and a trailing partial one go; the rest keep their order
+    std::vector<uint32_t> indices = { 0, 1, 2, 1, 2, 9, 2, 3, 0, 3, 1 };
+    std::vector<MeshCluster> clusters = SplitMesh(indices, 4);
+    bool dropped = SplitIsLossless(clusters, { 0, 1, 2, 2, 3, 0 }, c_maxShortIndexVertices);
+
+    // A cluster can't be smaller than a triangle, or bigger than 16 bit indices reach
+    return dropped && SplitMesh(indices, 4, 2).empty() && SplitMesh(indices, 4, c_maxShortIndexVertices + 1).empty() &&
+        SplitMesh({}, 0).empty();
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ProceduralGeometry.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    constexpr float c_normalTolerance = 1.0e-4f;
+    constexpr float c_uvTolerance = 1.0e-6f;
+
+    // Positions closer than this fraction of the primitive's size are welded when checking that a
+    // surface is closed. A power of two, so grid lines at whole fractions of the size never land
+    // halfway between two steps.
+    constexpr float c_weldStep = 1.0f / (1 << 20);
+
+    struct WeldKey
+    {
+        int32_t x;
+        int32_t y;
+        int32_t z;
+
+        bool operator==(const WeldKey& other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+
+    struct WeldKeyHash
+    {
+        size_t operator()(const WeldKey& key) const
+        {
+            return (static_cast<size_t>(static_cast<uint32_t>(key.x)) * 73856093u)
+                ^ (static_cast<size_t>(static_cast<uint32_t>(key.y)) * 19349663u)
+                ^ (static_cast<size_t>(static_cast<uint32_t>(key.z)) * 83492791u);
+        }
+    };
+
+    /// @brief Give every vertex the number of the first vertex at (nearly) the same position
+    std::vector<uint32_t> WeldPositions(const PrimitiveMesh& mesh, float size)
+    {
+        float scale = 1.0f / (size * c_weldStep);
+        std::unordered_map<WeldKey, uint32_t, WeldKeyHash> firstAt;
+        firstAt.reserve(mesh.vertices.size());
+
+        std::vector<uint32_t> welded(mesh.vertices.size());
+        for (size_t index = 0; index < mesh.vertices.size(); index++)
+        {
+            const auto& vertex = mesh.vertices[index];
+            WeldKey key = { static_cast<int32_t>(std::lround(vertex.x * scale)), static_cast<int32_t>(std::lround(vertex.y * scale)),
+                static_cast<int32_t>(std::lround(vertex.z * scale)) };
+            welded[index] = firstAt.emplace(key, static_cast<uint32_t>(index)).first->second;
+        }
+        return welded;
+    }
+
+    /// @brief Run the checks every primitive has to pass: the vertex and triangle counts the desc
+    /// promises, indices in range, unit normals, triangles wound to face their normals and, for
+    /// the closed shapes, a watertight surface once the seams are welded
+    bool CheckPrimitive(const PrimitiveDesc& desc, const PrimitiveMesh& mesh)
+    {
+        if (mesh.vertices.size() != GetPrimitiveVertexCount(desc) || mesh.indices.size() != GetPrimitiveTriangleCount(desc) * 3)
+            return false;
+
+        std::vector<uint8_t> used(mesh.vertices.size(), 0);
+        for (auto index : mesh.indices)
+        {
+            if (index >= mesh.vertices.size())
+                return false;
+            used[index] = 1;
+        }
+
+        for (size_t index = 0; index < mesh.vertices.size(); index++)
+        {
+            if (!used[index])
+                continue;
+            const auto& vertex = mesh.vertices[index];
+            float length = std::sqrt(vertex.nx * vertex.nx + vertex.ny * vertex.ny + vertex.nz * vertex.nz);
+            if (std::fabs(length - 1.0f) > c_normalTolerance)
+                return false;
+            if (vertex.u < -c_uvTolerance || vertex.u > 1.0f + c_uvTolerance || vertex.v < -c_uvTolerance || vertex.v > 1.0f + c_uvTolerance)
+                return false;
+        }
+
+        // Seen from the side the normals point to, each triangle has to be clockwise: its
+        // geometric normal, cross(b - a, c - a), points the same way as its vertex normals
+        for (size_t corner = 0; corner < mesh.indices.size(); corner += 3)
+        {
+            const auto& a = mesh.vertices[mesh.indices[corner]];
+            const auto& b = mesh.vertices[mesh.indices[corner + 1]];
+            const auto& c = mesh.vertices[mesh.indices[corner + 2]];
+            float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+            float e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+            float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float facing = normal[0] * (a.nx + b.nx + c.nx) + normal[1] * (a.ny + b.ny + c.ny) + normal[2] * (a.nz + b.nz + c.nz);
+            if (!(facing > 0.0f))
+                return false;
+        }
+
+        // With the seams welded, each edge can only be used once in each direction. Edges used in
+        // one direction only are on the border: closed shapes have none, and flat ones have the
+        // outline of their grid of quads.
+        std::vector<uint32_t> welded = WeldPositions(mesh, std::max(desc.size[0], desc.size[1]));
+        std::vector<uint64_t> edges;
+        edges.reserve(mesh.indices.size());
+        for (size_t corner = 0; corner < mesh.indices.size(); corner += 3)
+        {
+            for (int edge = 0; edge < 3; edge++)
+            {
+                uint64_t from = welded[mesh.indices[corner + edge]];
+                uint64_t to = welded[mesh.indices[corner + (edge + 1) % 3]];
+                edges.push_back((from << 32) | to);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        if (std::adjacent_find(edges.begin(), edges.end()) != edges.end())
+            return false;
+
+        size_t borderEdges = 0;
+        for (auto edge : edges)
+        {
+            uint64_t reversed = (edge << 32) | (edge >> 32);
+            if (!std::binary_search(edges.begin(), edges.end(), reversed))
+                borderEdges++;
+        }
+
+        bool closed = desc.type == PrimitiveType::Sphere || desc.type == PrimitiveType::Cube;
+        size_t expectedBorder = closed ? 0 : 2 * (static_cast<size_t>(desc.segments[0]) + desc.segments[1]);
+        return borderEdges == expectedBorder;
+    }
+
+    /// @brief Check every primitive of a type at a range of tessellations
+    template <typename TMakeDesc>
+    bool CheckTessellations(TMakeDesc makeDesc)
+    {
+        const uint32_t tessellations[] = { 1, 2, 3, 7, 16, 64 };
+        for (auto segments : tessellations)
+        {
+            PrimitiveDesc desc = makeDesc(segments);
+            if (!CheckPrimitive(desc, GeneratePrimitive(desc)))
+                return false;
+        }
+        return true;
+    }
+
+    /// @brief Descs that make the same shape have to be equal and hash the same, so they share a
+    /// cache entry
+    bool SameKey(const PrimitiveDesc& a, const PrimitiveDesc& b)
+    {
+        PrimitiveDescHash hash;
+        PrimitiveDesc normalizedA = NormalizePrimitiveDesc(a);
+        PrimitiveDesc normalizedB = NormalizePrimitiveDesc(b);
+        return normalizedA == normalizedB && hash(normalizedA) == hash(normalizedB);
+    }
+}
+
+SCENEGRAPH_TEST(ProceduralGeometry, Cubes)
+{
+    return CheckTessellations([](uint32_t segments) { return MakeCubeDesc(1.0f, segments); }) &&
+        CheckTessellations([](uint32_t segments) { return MakeCubeDesc(3.5f, segments); });
+}
+
+SCENEGRAPH_TEST(ProceduralGeometry, Planes)
+{
+    return CheckTessellations([](uint32_t segments) { return MakePlaneDesc(2.0f, 2.0f, segments, segments); }) &&
+        CheckTessellations([](uint32_t segments) { return MakePlaneDesc(4.0f, 1.0f, segments, segments * 2 + 1); });
+}
+
+SCENEGRAPH_TEST(ProceduralGeometry, Grids)
+{
+    return CheckTessellations([](uint32_t segments) { return MakeGridDesc(10.0f, 10.0f, segments, segments); }) &&
+        CheckTessellations([](uint32_t segments) { return MakeGridDesc(3.0f, 8.0f, segments * 3, segments); });
+}
+
+SCENEGRAPH_TEST(ProceduralGeometry, Spheres)
+{
+    if (!CheckTessellations([](uint32_t segments) { return MakeSphereDesc(0.25f, segments + 2, segments + 1); }))
+        return false;
+
+    // A fine sphere's vertices are on it, with normals pointing straight out
+    PrimitiveDesc desc = MakeSphereDesc(1.0f, 512, 256);
+    PrimitiveMesh mesh = GeneratePrimitive(desc);
+    float maxRadiusError = 0.0f;
+    float maxSine = 0.0f;
+    for (const auto& vertex : mesh.vertices)
+    {
+        float radius = std::sqrt(vertex.x * vertex.x + vertex.y * vertex.y + vertex.z * vertex.z);
+        maxRadiusError = std::max(maxRadiusError, std::fabs(radius - 1.0f));
+
+        float cross[3] = { vertex.y * vertex.nz - vertex.z * vertex.ny, vertex.z * vertex.nx - vertex.x * vertex.nz,
+            vertex.x * vertex.ny - vertex.y * vertex.nx };
+        maxSine = std::max(maxSine, std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]));
+    }
+    return CheckPrimitive(desc, mesh) && maxRadiusError < 1.0e-5f && maxSine < 1.0e-5f;
+}
+
+SCENEGRAPH_TEST(ProceduralGeometry, EqualShapesShareKeys)
+{
+    PrimitiveDesc handFilled;
+    handFilled.type = PrimitiveType::Cube;
+    handFilled.size[0] = 1.0f;
+    handFilled.size[1] = 7.0f;
+    handFilled.segments[0] = 0;
+    handFilled.segments[1] = 9;
+
+    return SameKey(MakeSphereDesc(1.0f, 1, 1), MakeSphereDesc(1.0f, 3, 2)) &&
+        SameKey(MakeSphereDesc(1.0f, 100000, 8), MakeSphereDesc(1.0f, c_maxPrimitiveSegments, 8)) &&
+        SameKey(handFilled, MakeCubeDesc(1.0f)) &&
+        SameKey(MakePlaneDesc(-0.0f, 1.0f), MakePlaneDesc(0.0f, 1.0f));
+}
+
+SCENEGRAPH_TEST(ProceduralGeometry, DifferentShapesDoNot)
+{
+    std::unordered_set<PrimitiveDesc, PrimitiveDescHash> distinct = {
+        MakeSphereDesc(1.0f, 32, 16), MakeSphereDesc(1.0f, 32, 17), MakeSphereDesc(2.0f, 32, 16),
+        MakeCubeDesc(1.0f), MakeCubeDesc(1.0f, 2),
+        MakePlaneDesc(1.0f, 1.0f), MakeGridDesc(1.0f, 1.0f, 1, 1), MakePlaneDesc(1.0f, 2.0f), MakePlaneDesc(1.0f, 1.0f, 2, 1)
+    };
+    return distinct.size() == 9;
+}
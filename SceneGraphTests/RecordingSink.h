@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "StateCache.h"
+
+/// @brief Records the calls that get through a StateCache, in place of a device context
+class RecordingSink : public StateCommandSink
+{
+public:
+    enum Call
+    {
+        Topology,
+        InputLayout,
+        VertexBuffer,
+        IndexBuffer,
+        VertexShader,
+        PixelShader,
+        VSConstantBuffer,
+        PSConstantBuffer,
+        ShaderResource,
+        Sampler,
+        Draw,
+        CallCount
+    };
+
+    /// @brief One call, with the slot it bound, or 0 for calls without one
+    struct Record
+    {
+        Call call;
+        uint32_t slot;
+    };
+
+    void IASetPrimitiveTopology(uint32_t) override { Add(Topology, 0); }
+    void IASetInputLayout(ID3D11InputLayout*) override { Add(InputLayout, 0); }
+    void IASetVertexBuffer(uint32_t slot, ID3D11Buffer*, uint32_t, uint32_t) override { Add(VertexBuffer, slot); }
+    void IASetIndexBuffer(ID3D11Buffer*, uint32_t, uint32_t) override { Add(IndexBuffer, 0); }
+    void VSSetShader(ID3D11VertexShader*) override { Add(VertexShader, 0); }
+    void PSSetShader(ID3D11PixelShader*) override { Add(PixelShader, 0); }
+    void VSSetConstantBuffer(uint32_t slot, const ConstantBufferSlice&) override { Add(VSConstantBuffer, slot); }
+    void PSSetConstantBuffer(uint32_t slot, ID3D11Buffer*) override { Add(PSConstantBuffer, slot); }
+    void PSSetShaderResource(uint32_t slot, ID3D11ShaderResourceView*) override { Add(ShaderResource, slot); }
+    void PSSetSampler(uint32_t slot, ID3D11SamplerState*) override { Add(Sampler, slot); }
+    void DrawIndexed(uint32_t, uint32_t, int32_t) override { Add(Draw, 0); }
+    void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override { Add(Draw, 0); }
+
+    size_t Count(Call call) const { return m_counts[call]; }
+    const std::vector<Record>& GetRecords() const { return m_records; }
+
+    void Reset()
+    {
+        m_records.clear();
+        for (auto& count : m_counts)
+            count = 0;
+    }
+
+private:
+    void Add(Call call, uint32_t slot)
+    {
+        m_records.push_back({ call, slot });
+        m_counts[call]++;
+    }
+
+    std::vector<Record> m_records;
+    size_t m_counts[CallCount] = {};
+};
+
+/// @brief Stand-ins for D3D objects, which the state cache only ever compares
+template <typename T>
+T* FakeObject(std::vector<uint8_t>& storage, size_t index)
+{
+    return reinterpret_cast<T*>(storage.data() + index);
+}
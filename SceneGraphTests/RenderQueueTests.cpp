@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "RenderQueue.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    uint32_t ShaderOf(const RenderQueue& queue, size_t packet) { return RenderQueue::GetShaderId(queue.GetPackets()[packet].key); }
+    uint32_t MaterialOf(const RenderQueue& queue, size_t packet) { return RenderQueue::GetMaterialId(queue.GetPackets()[packet].key); }
+    uint32_t GeometryOf(const RenderQueue& queue, size_t packet) { return RenderQueue::GetGeometryId(queue.GetPackets()[packet].key); }
+}
+
+SCENEGRAPH_TEST(RenderQueue, SortKeyFields)
+{
+    uint64_t key = RenderQueue::MakeSortKey(5, 7, 9, 3.0f);
+    bool fields = RenderQueue::GetShaderId(key) == 5 && RenderQueue::GetMaterialId(key) == 7 && RenderQueue::GetGeometryId(key) == 9;
+
+    // State outranks depth, and within the same state nearer sorts first
+    bool order = RenderQueue::MakeSortKey(1, 0, 0, 1000.0f) < RenderQueue::MakeSortKey(2, 0, 0, 0.5f) &&
+        RenderQueue::MakeSortKey(1, 1, 0, 1000.0f) < RenderQueue::MakeSortKey(1, 2, 0, 0.5f) &&
+        RenderQueue::MakeSortKey(1, 1, 1, 1000.0f) < RenderQueue::MakeSortKey(1, 1, 2, 0.5f) &&
+        RenderQueue::MakeSortKey(1, 1, 1, 0.5f) < RenderQueue::MakeSortKey(1, 1, 1, 2.0f) &&
+        RenderQueue::MakeSortKey(1, 1, 1, 2.0f) < RenderQueue::MakeSortKey(1, 1, 1, 100.0f);
+
+    // Behind the camera counts as at the camera
+    bool behind = RenderQueue::MakeSortKey(1, 1, 1, -5.0f) == RenderQueue::MakeSortKey(1, 1, 1, 0.0f);
+
+    return fields && order && behind;
+}
+
+SCENEGRAPH_TEST(RenderQueue, RadixSortMatchesStableSort)
+{
+    std::mt19937_64 random(42);
+    std::vector<DrawPacket> packets;
+    for (uint32_t item = 0; item < 5000; item++)
+    {
+        // Few distinct states, so many keys are equal and the order among them shows
+        uint64_t key = RenderQueue::MakeSortKey(random() % 3, random() % 5, random() % 7, static_cast<float>(random() % 4));
+        packets.push_back(DrawPacket{ key, item });
+    }
+
+    std::vector<DrawPacket> expected = packets;
+    std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+
+    std::vector<DrawPacket> scratch;
+    RenderQueue::RadixSort(packets, scratch);
+
+    for (size_t index = 0; index < packets.size(); index++)
+    {
+        if (packets[index].key != expected[index].key || packets[index].item != expected[index].item)
+            return false;
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(RenderQueue, CountStateChanges)
+{
+    std::vector<DrawPacket> packets = {
+        { RenderQueue::MakeSortKey(1, 1, 1, 1.0f), 0 },
+        { RenderQueue::MakeSortKey(1, 1, 1, 2.0f), 1 },     // nothing changes
+        { RenderQueue::MakeSortKey(1, 1, 2, 1.0f), 2 },     // geometry
+        { RenderQueue::MakeSortKey(1, 2, 2, 1.0f), 3 },     // material
+        { RenderQueue::MakeSortKey(2, 2, 2, 1.0f), 4 },     // shader
+    };
+
+    RenderQueueStats stats;
+    size_t changes = RenderQueue::CountStateChanges(packets, &stats);
+    return changes == 6 && stats.drawCount == 5 && stats.shaderChanges == 2 && stats.materialChanges == 2 &&
+        stats.geometryChanges == 2 && stats.stateChangesAvoided == 9;
+}
+
+SCENEGRAPH_TEST(RenderQueue, SubmitGroupsByState)
+{
+    int shaders[2] = {}, materials[2] = {}, meshes[3] = {};
+
+    RenderQueue queue;
+    queue.Submit(&shaders[1], &materials[0], &meshes[0], 5.0f, 0);
+    queue.Submit(&shaders[0], &materials[1], &meshes[1], 5.0f, 1);
+    queue.Submit(&shaders[1], &materials[0], &meshes[0], 1.0f, 2);
+    queue.Submit(&shaders[0], &materials[1], &meshes[2], 5.0f, 3);
+    queue.Submit(&shaders[0], nullptr, &meshes[1], 5.0f, 4);
+    queue.Sort();
+
+    // Shaders get ids in the order they are first seen, and the same mesh sorts together, nearest first
+    const auto& packets = queue.GetPackets();
+    return packets.size() == 5 &&
+        packets[0].item == 2 && packets[1].item == 0 &&
+        packets[2].item == 4 && MaterialOf(queue, 2) == 0 &&
+        packets[3].item == 1 && packets[4].item == 3 &&
+        queue.GetStats().shaderChanges == 2;
+}
+
+SCENEGRAPH_TEST(RenderQueue, LevelsOfDetailAreSeparateGeometry)
+{
+    int shader = 0, mesh = 0;
+
+    RenderQueue queue;
+    queue.Submit(&shader, nullptr, &mesh, 1.0f, 0, 0);
+    queue.Submit(&shader, nullptr, &mesh, 1.0f, 1, 1);
+    queue.Sort();
+
+    uint32_t finest = GeometryOf(queue, 0);
+    uint32_t coarser = GeometryOf(queue, 1);
+    return finest != coarser && (finest >> RenderQueue::LodBits) == (coarser >> RenderQueue::LodBits);
+}
+
+SCENEGRAPH_TEST(RenderQueue, IdsStableWhileDrawn)
+{
+    int shaders[3] = {};
+
+    RenderQueue queue;
+    std::vector<uint32_t> first;
+    for (int frame = 0; frame < 4; frame++)
+    {
+        queue.Clear();
+        queue.Submit(&shaders[2], nullptr, nullptr, 1.0f, 0);
+        queue.Submit(&shaders[0], nullptr, nullptr, 1.0f, 1);
+        queue.Submit(&shaders[1], nullptr, nullptr, 1.0f, 2);
+
+        std::vector<uint32_t> ids;
+        for (const auto& packet : queue.GetPackets())
+        {
+            ids.push_back(RenderQueue::GetShaderId(packet.key));
+        }
+
+        if (frame == 0)
+            first = ids;
+        else if (ids != first)
+            return false;
+    }
+
+    return first == std::vector<uint32_t>{ 1, 2, 3 };
+}
+
+SCENEGRAPH_TEST(RenderQueue, IdsReleasedWhenNotDrawn)
+{
+    int meshes[3] = {};
+    int shader = 0;
+
+    RenderQueue queue;
+    queue.Submit(&shader, nullptr, &meshes[0], 1.0f, 0);
+    queue.Submit(&shader, nullptr, &meshes[1], 1.0f, 1);
+    uint32_t kept = GeometryOf(queue, 0);
+    uint32_t dropped = GeometryOf(queue, 1);
+
+    // A frame without meshes[1] releases its id, which the next new mesh takes
+    queue.Clear();
+    queue.Submit(&shader, nullptr, &meshes[0], 1.0f, 0);
+    queue.Clear();
+    queue.Submit(&shader, nullptr, &meshes[0], 1.0f, 0);
+    queue.Submit(&shader, nullptr, &meshes[2], 1.0f, 1);
+    bool reused = GeometryOf(queue, 0) == kept && GeometryOf(queue, 1) == dropped;
+
+    // And meshes[1], back again, gets a new id rather than one in use
+    queue.Clear();
+    queue.Submit(&shader, nullptr, &meshes[0], 1.0f, 0);
+    queue.Submit(&shader, nullptr, &meshes[2], 1.0f, 1);
+    queue.Submit(&shader, nullptr, &meshes[1], 1.0f, 2);
+    bool distinct = GeometryOf(queue, 2) != kept && GeometryOf(queue, 2) != dropped;
+
+    // Ids stay as few as the things drawn in a frame, however many come and go
+    int many[100] = {};
+    for (int frame = 0; frame < 100; frame++)
+    {
+        queue.Clear();
+        queue.Submit(&shader, nullptr, &many[frame], 1.0f, 0);
+    }
+    bool bounded = (GeometryOf(queue, 0) >> RenderQueue::LodBits) <= 4;
+
+    return reused && distinct && bounded && ShaderOf(queue, 0) == 1;
+}
@@ -0,0 +1,103 @@
+#include <cstring>
+#include <vector>
+
+#include "RenderableData.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief Where a vertex of a submesh ends up once the vertex shader has expanded it
+    void DecodePosition(const RenderableData& data, const SubmeshData& submesh, uint32_t vertex, float position[3])
+    {
+        PackedVertexNormal packed;
+        std::memcpy(&packed, data.vertices.data() + (submesh.firstVertex + vertex) * data.vertexStride, sizeof(packed));
+        DequantizePosition(packed.position, submesh.quantization, position);
+    }
+
+    /// @brief A quad facing up, its corners in order around it
+    void AddQuad(std::vector<VertexNormal>& vertices, std::vector<uint32_t>& indices, const float corners[4][2])
+    {
+        uint32_t first = static_cast<uint32_t>(vertices.size());
+        for (int corner = 0; corner < 4; corner++)
+        {
+            vertices.push_back(VertexNormal{ corners[corner][0], 0.0f, corners[corner][1], 0.0f, 1.0f, 0.0f });
+        }
+        indices.insert(indices.end(), { first, first + 2, first + 1, first, first + 3, first + 2 });
+    }
+
+    bool SameDecodedPosition(const RenderableData& data, uint32_t vertexA, uint32_t vertexB)
+    {
+        float a[3];
+        float b[3];
+        DecodePosition(data, data.submeshes[0], vertexA, a);
+        DecodePosition(data, data.submeshes[1], vertexB, b);
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    }
+}
+
+SCENEGRAPH_TEST(RenderableData, SharedGridClosesSeams)
+{
+    // Two parts with different materials and bounds, sharing the edge from (0.7, 0) to (0.7, 1):
+    // the left one's corners 1 and 2 are the right one's 0 and 3
+    const float leftCorners[4][2] = { { -0.13f, 0.0f }, { 0.7f, 0.0f }, { 0.7f, 1.0f }, { -0.13f, 1.0f } };
+    const float rightCorners[4][2] = { { 0.7f, 0.0f }, { 5.31f, -2.23f }, { 5.31f, 1.71f }, { 0.7f, 1.0f } };
+    std::vector<VertexNormal> left, right;
+    std::vector<uint32_t> leftIndices, rightIndices;
+    AddQuad(left, leftIndices, leftCorners);
+    AddQuad(right, rightIndices, rightCorners);
+
+    // On their own grids the edge rounds to different points in each
+    RenderableBuilder separate;
+    separate.AddSubmesh(left, leftIndices, 0);
+    separate.AddSubmesh(right, rightIndices, 1);
+    auto cracked = separate.Finish({});
+    bool crack = !SameDecodedPosition(cracked, 1, 0) || !SameDecodedPosition(cracked, 2, 3);
+
+    std::vector<VertexNormal> whole(left);
+    whole.insert(whole.end(), right.begin(), right.end());
+    RenderableBuilder shared;
+    shared.SetSharedQuantization(ComputePositionQuantization(whole.data(), whole.size(), sizeof(VertexNormal)));
+    shared.AddSubmesh(left, leftIndices, 0);
+    shared.AddSubmesh(right, rightIndices, 1);
+    auto sealed = shared.Finish({});
+
+    // Finish forgets the grid along with everything else
+    shared.AddSubmesh(right, rightIndices, 0);
+    auto next = shared.Finish({});
+
+    return crack && SameDecodedPosition(sealed, 1, 0) && SameDecodedPosition(sealed, 2, 3) &&
+        Near(next.submeshes[0].quantization.offset[0], 0.7f) && Near(next.submeshes[0].quantization.scale[2], 3.94f);
+}
+
+SCENEGRAPH_TEST(RenderableData, SplitClustersShareTheirPartsGrid)
+{
+    // A strip too long for 16 bit indices, so it's split into clusters
+    std::vector<VertexNormal> vertices;
+    std::vector<uint32_t> indices;
+    const uint32_t columns = 40000;
+    for (uint32_t column = 0; column <= columns; column++)
+    {
+        float x = column * 0.013f;
+        vertices.push_back(VertexNormal{ x, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f });
+        vertices.push_back(VertexNormal{ x, 0.0f, 1.0f + 0.001f * (column % 7), 0.0f, 1.0f, 0.0f });
+    }
+    for (uint32_t column = 0; column < columns; column++)
+    {
+        uint32_t first = column * 2;
+        indices.insert(indices.end(), { first, first + 1, first + 2, first + 2, first + 1, first + 3 });
+    }
+
+    RenderableBuilder builder;
+    builder.AddSubmeshes(vertices, indices, 0, LargeMeshMode::Split);
+    auto data = builder.Finish({});
+
+    auto part = ComputePositionQuantization(vertices.data(), vertices.size(), sizeof(VertexNormal));
+    if (data.submeshes.size() < 2 || data.indexSize != sizeof(uint16_t))
+        return false;
+    for (const auto& submesh : data.submeshes)
+    {
+        if (std::memcmp(&submesh.quantization, &part, sizeof(part)) != 0)
+            return false;
+    }
+    return true;
+}
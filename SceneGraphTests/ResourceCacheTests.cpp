@@ -0,0 +1,205 @@
+#include <memory>
+#include <string>
+
+#include "ResourceCache.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    /// @brief Stands in for a loaded resource, and records when it is destroyed
+    struct FakeResource
+    {
+        explicit FakeResource(uint32_t* destroyedCount = nullptr)
+            : destroyed(destroyedCount)
+        {
+        }
+
+        ~FakeResource()
+        {
+            if (destroyed != nullptr)
+                (*destroyed)++;
+        }
+
+        uint32_t* destroyed;
+    };
+
+    /// @brief Holds a handle to another resource, and releases it when it is destroyed, as a mesh
+    /// does its texture
+    struct DependentResource
+    {
+        ~DependentResource()
+        {
+            cache->Release(dependency);
+        }
+
+        ResourceCache* cache = nullptr;
+        ResourceHandle dependency;
+    };
+
+    ResourceHandle InsertFake(ResourceCache& cache, ResourceType type, const std::string& key, uint64_t bytes, uint32_t* destroyed = nullptr)
+    {
+        return cache.Insert(type, key, std::make_shared<FakeResource>(destroyed), bytes);
+    }
+}
+
+SCENEGRAPH_TEST(ResourceCache, Deduplication)
+{
+    ResourceCache cache;
+    auto key = MakeResourceKey("models/../crate.fbx", "normal,long");
+    if (key != MakeResourceKey("crate.fbx", "normal,long") || key == MakeResourceKey("crate.fbx", "normal,split"))
+        return false;
+
+    if (cache.Find(ResourceType::Mesh, key).IsValid())
+        return false;
+
+    auto first = InsertFake(cache, ResourceType::Mesh, key, 100);
+    auto second = cache.Find(ResourceType::Mesh, MakeResourceKey("crate.fbx", "normal,long"));
+    auto other = cache.Find(ResourceType::Texture, key);    // same key, but another type
+    auto report = cache.GetReport();
+
+    return first.IsValid() && second == first && !other.IsValid() && cache.GetRefCount(first) == 2
+        && cache.GetResource(ResourceType::Mesh, first) != nullptr && cache.GetResource(ResourceType::Texture, first) == nullptr
+        && report.Get(ResourceType::Mesh).resident == 1 && report.Get(ResourceType::Mesh).hits == 1 && report.Get(ResourceType::Mesh).misses == 1;
+}
+
+SCENEGRAPH_TEST(ResourceCache, ReferenceCounts)
+{
+    ResourceCache cache(1);
+    uint32_t destroyed = 0;
+    auto handle = InsertFake(cache, ResourceType::Texture, "brick.png|rgba8", 64, &destroyed);
+    cache.AddRef(handle);
+    cache.Find(ResourceType::Texture, "brick.png|rgba8");
+
+    // Three references; two released leaves it alive however many frames go by
+    cache.Release(handle);
+    cache.Release(handle);
+    for (int frame = 0; frame < 10; frame++)
+    {
+        cache.EndFrame();
+    }
+    if (destroyed != 0 || cache.GetRefCount(handle) != 1)
+        return false;
+
+    cache.Release(handle);
+    cache.Release(handle);  // one too many is ignored
+    cache.EndFrame();
+    return destroyed == 1 && !cache.IsValid(handle);
+}
+
+SCENEGRAPH_TEST(ResourceCache, DestroyDelay)
+{
+    ResourceCache cache(3);
+    uint32_t destroyed = 0;
+    auto handle = InsertFake(cache, ResourceType::Mesh, "a", 10, &destroyed);
+    cache.Release(handle);
+
+    // Still there after two frames, gone by the end of the third
+    uint32_t first = cache.EndFrame();
+    uint32_t second = cache.EndFrame();
+    bool aliveAfterTwo = cache.IsValid(handle) && destroyed == 0 && cache.GetReport().Get(ResourceType::Mesh).pendingDestroy == 1;
+    uint32_t third = cache.EndFrame();
+
+    return first == 0 && second == 0 && aliveAfterTwo && third == 1 && destroyed == 1 && !cache.IsValid(handle)
+        && !cache.Find(ResourceType::Mesh, "a").IsValid();
+}
+
+SCENEGRAPH_TEST(ResourceCache, Revival)
+{
+    ResourceCache cache(3);
+    uint32_t destroyed = 0;
+    auto handle = InsertFake(cache, ResourceType::Shader, "lit.hlsl", 10, &destroyed);
+    cache.Release(handle);
+    cache.EndFrame();
+    cache.EndFrame();
+
+    // Acquired again just before it would have gone, so it comes back rather than reloading
+    auto revived = cache.Find(ResourceType::Shader, "lit.hlsl");
+    for (int frame = 0; frame < 5; frame++)
+    {
+        cache.EndFrame();
+    }
+    if (revived != handle || destroyed != 0 || cache.GetRefCount(handle) != 1)
+        return false;
+
+    // And released again, the delay starts over
+    cache.Release(handle);
+    cache.EndFrame();
+    cache.EndFrame();
+    bool alive = cache.IsValid(handle);
+    cache.EndFrame();
+    return alive && destroyed == 1;
+}
+
+SCENEGRAPH_TEST(ResourceCache, StaleHandles)
+{
+    ResourceCache cache(0);
+    auto old = InsertFake(cache, ResourceType::Mesh, "old", 10);
+    cache.Release(old);
+    cache.EndFrame();
+
+    // The new resource takes the old one's slot; the old handle mustn't reach it
+    uint32_t destroyed = 0;
+    auto fresh = InsertFake(cache, ResourceType::Mesh, "new", 20, &destroyed);
+    if (fresh.index != old.index || fresh == old || cache.IsValid(old) || cache.GetResource(ResourceType::Mesh, old) != nullptr)
+        return false;
+
+    cache.AddRef(old);
+    cache.Release(old);
+    cache.Release(old);
+    cache.SetBytes(old, 1000);
+    cache.EndFrame();
+
+    auto report = cache.GetReport();
+    bool untouched = cache.GetRefCount(fresh) == 1 && destroyed == 0 && report.Get(ResourceType::Mesh).residentBytes == 20;
+
+    cache.Clear();
+    return untouched && destroyed == 1 && !cache.IsValid(fresh) && !ResourceHandle().IsValid();
+}
+
+SCENEGRAPH_TEST(ResourceCache, DependentDestroy)
+{
+    ResourceCache cache(1);
+    uint32_t destroyed = 0;
+    auto texture = InsertFake(cache, ResourceType::Texture, "brick.png", 10, &destroyed);
+
+    auto mesh = std::make_shared<DependentResource>();
+    mesh->cache = &cache;
+    mesh->dependency = texture;
+    auto meshHandle = cache.Insert(ResourceType::Mesh, "brickCube.fbx", mesh, 20);
+    mesh.reset();
+
+    // Destroying the mesh releases the texture from inside EndFrame; the texture then waits its turn
+    cache.Release(meshHandle);
+    cache.EndFrame();
+    bool textureWaits = !cache.IsValid(meshHandle) && cache.IsValid(texture) && cache.GetRefCount(texture) == 0 && destroyed == 0;
+    cache.EndFrame();
+    if (!textureWaits || destroyed != 1)
+        return false;
+
+    // Clear copes with the same thing
+    auto texture2 = InsertFake(cache, ResourceType::Texture, "brick.png", 10, &destroyed);
+    auto mesh2 = std::make_shared<DependentResource>();
+    mesh2->cache = &cache;
+    mesh2->dependency = texture2;
+    cache.Insert(ResourceType::Mesh, "brickCube.fbx", mesh2, 20);
+    mesh2.reset();
+    cache.Clear();
+    return destroyed == 2 && cache.GetReport().totalBytes == 0;
+}
+
+SCENEGRAPH_TEST(ResourceCache, Report)
+{
+    ResourceCache cache(2);
+    InsertFake(cache, ResourceType::Mesh, "a", 1000);
+    auto b = InsertFake(cache, ResourceType::Mesh, "b", 500);
+    InsertFake(cache, ResourceType::Texture, "c", 4096);
+    InsertFake(cache, ResourceType::Shader, "d", 0);
+    cache.SetBytes(b, 700);
+    cache.Release(b);
+
+    auto report = cache.GetReport();
+    const auto& meshes = report.Get(ResourceType::Mesh);
+    return meshes.resident == 1 && meshes.residentBytes == 1000 && meshes.pendingDestroy == 1 && meshes.pendingBytes == 700
+        && report.Get(ResourceType::Texture).residentBytes == 4096 && report.Get(ResourceType::Shader).resident == 1
+        && report.Get(ResourceType::Shader).residentBytes == 0 && report.totalBytes == 1000 + 700 + 4096;
+}
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "RingAllocator.h"
+#include "SceneGraphTest.h"
+
+SCENEGRAPH_TEST(RingAllocator, AlignsAllocations)
+{
+    RingAllocator ring(1024);
+    uint64_t first = ring.Allocate(10, 1);
+    uint64_t second = ring.Allocate(16, 256);
+    uint64_t third = ring.Allocate(4, 16);
+    return first == 0 && second == 256 && third == 272 && ring.GetStats().used == 276;
+}
+
+SCENEGRAPH_TEST(RingAllocator, FullUntilRetired)
+{
+    RingAllocator ring(1024);
+    bool filled = ring.Allocate(512, 256) == 0 && ring.Allocate(512, 256) == 512;
+    ring.EndFrame(1);
+
+    // Nothing fits while the GPU may still read the frame, and a range larger than the ring never does
+    bool full = ring.Allocate(1, 1) == RingAllocator::InvalidOffset && ring.Allocate(2048, 1) == RingAllocator::InvalidOffset;
+    bool failures = ring.GetStats().failedAllocations == 2;
+
+    ring.Retire(0);
+    bool stillFull = ring.Allocate(1, 1) == RingAllocator::InvalidOffset;
+
+    // Once the fence passes, the whole ring is free again, from the start
+    ring.Retire(1);
+    bool free = !ring.HasPendingFrames() && ring.Allocate(1024, 256) == 0;
+
+    return filled && full && failures && stillFull && free && ring.GetStats().peakUsed == 1024;
+}
+
+SCENEGRAPH_TEST(RingAllocator, WrapsWithoutStraddling)
+{
+    RingAllocator ring(1000);
+    ring.Allocate(400, 1);
+    ring.EndFrame(1);
+    ring.Allocate(400, 1);
+    ring.EndFrame(2);
+    ring.Retire(1);
+
+    // 200 bytes are left at the end, too few for 300, so the range starts over at 0 and the tail is
+    // skipped
+    uint64_t wrapped = ring.Allocate(300, 1);
+    bool wraps = wrapped == 0 && ring.GetStats().wraps == 1;
+
+    // The space before the frame still in flight is all that's left
+    bool rest = ring.Allocate(100, 1) == 300 && ring.Allocate(1, 1) == RingAllocator::InvalidOffset;
+
+    return wraps && rest && ring.GetOldestPendingFence() == 2;
+}
+
+SCENEGRAPH_TEST(RingAllocator, LiveRangesNeverOverlap)
+{
+    const uint64_t capacity = 64 * 1024;
+    RingAllocator ring(capacity);
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint64_t> size(1, 4096);
+    std::uniform_int_distribution<int> alignmentShift(0, 8);
+    std::uniform_int_distribution<int> allocations(0, 40);
+    std::uniform_int_distribution<int> latency(0, 3);
+
+    // The ranges of every frame the GPU may still be reading, oldest first
+    std::deque<std::pair<uint64_t, std::vector<std::pair<uint64_t, uint64_t>>>> frames;
+    std::vector<std::pair<uint64_t, uint64_t>> live;
+
+    uint64_t completed = 0;
+    for (uint64_t fence = 1; fence <= 2000; fence++)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> frame;
+        int count = allocations(random);
+        for (int allocation = 0; allocation < count; allocation++)
+        {
+            uint64_t bytes = size(random);
+            uint64_t alignment = 1ull << alignmentShift(random);
+            uint64_t offset = ring.Allocate(bytes, alignment);
+            if (offset == RingAllocator::InvalidOffset)
+                continue;
+
+            if (offset % alignment != 0 || offset + bytes > capacity)
+                return false;
+
+            for (const auto& range : live)
+            {
+                if (offset < range.first + range.second && range.first < offset + bytes)
+                    return false;
+            }
+            for (const auto& range : frame)
+            {
+                if (offset < range.first + range.second && range.first < offset + bytes)
+                    return false;
+            }
+            frame.push_back({ offset, bytes });
+        }
+
+        ring.EndFrame(fence);
+        frames.push_back({ fence, frame });
+
+        // The GPU finishes frames a few behind
+        uint64_t behind = static_cast<uint64_t>(latency(random));
+        completed = fence > behind ? std::max(completed, fence - behind) : completed;
+        ring.Retire(completed);
+        while (!frames.empty() && frames.front().first <= completed)
+        {
+            frames.pop_front();
+        }
+
+        live.clear();
+        for (const auto& pending : frames)
+        {
+            live.insert(live.end(), pending.second.begin(), pending.second.end());
+        }
+    }
+
+    return ring.GetStats().wraps > 0 && ring.GetStats().failedAllocations > 0;
+}
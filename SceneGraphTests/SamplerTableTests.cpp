@@ -0,0 +1,224 @@
+#include <cstring>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "RecordingSink.h"
+#include "SamplerTable.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    constexpr uint32_t c_distinctDescs = 64;
+    constexpr size_t c_hashedKeys = 100000;
+
+    constexpr uint32_t c_filterComparisonMinMagMipLinear = 0x95;    // D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR
+    constexpr uint32_t c_addressMirror = 2;                         // D3D11_TEXTURE_ADDRESS_MIRROR
+
+    // The hash check changes the key a word at a time
+    static_assert(sizeof(SamplerKey) == 13 * sizeof(uint32_t), "a SamplerKey is its 13 fields and nothing else");
+
+    /// @brief The sampler Material::CreateFromTexture used to create for every material
+    SamplerKey OldMaterialSampler()
+    {
+        SamplerKey key{};
+        key.filter = c_filterMinMagMipLinear;
+        key.addressU = c_addressWrap;
+        key.addressV = c_addressWrap;
+        key.addressW = c_addressWrap;
+        key.comparisonFunc = c_comparisonNever;
+        key.minLod = 0;
+        key.maxLod = 3.402823466e+38f;
+        return key;
+    }
+
+    /// @brief Descriptions that all make different samplers
+    std::vector<SamplerKey> MakeDistinctKeys(uint32_t count)
+    {
+        const uint32_t filters[] = { c_filterMinMagMipPoint, c_filterMinMagMipLinear, c_filterAnisotropic, c_filterComparisonMinMagMipLinear };
+        const uint32_t addresses[] = { c_addressWrap, c_addressMirror, c_addressClamp, c_addressBorder };
+
+        std::vector<SamplerKey> keys;
+        for (uint32_t index = 0; keys.size() < count; index++)
+        {
+            SamplerKey key;
+            key.filter = filters[index % 4];
+            key.addressU = key.addressV = addresses[(index / 4) % 4];
+            key.addressW = c_addressWrap;
+            key.mipLodBias = static_cast<float>(index / 16) * 0.5f;
+            if (key.filter == c_filterAnisotropic)
+                key.maxAnisotropy = 8;
+            if (key.filter == c_filterComparisonMinMagMipLinear)
+                key.comparisonFunc = c_comparisonLessEqual;
+            if (key.addressU == c_addressBorder)
+                key.borderColor[3] = 1.0f;
+            keys.push_back(key);
+        }
+        return keys;
+    }
+
+    /// @brief The same sampler as key, with whatever D3D ignores for it changed at random
+    SamplerKey AddNoise(SamplerKey key, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> colour(0.0f, 1.0f);
+        if (key.filter != c_filterComparisonMinMagMipLinear)
+            key.comparisonFunc = 1 + random() % 8;
+        if (key.filter != c_filterAnisotropic)
+            key.maxAnisotropy = random() % 17;
+        if (key.addressU != c_addressBorder)
+        {
+            for (float& channel : key.borderColor)
+                channel = colour(random);
+        }
+        if (key.mipLodBias == 0.0f && random() % 2 == 0)
+            key.mipLodBias = -0.0f;
+        return key;
+    }
+}
+
+SCENEGRAPH_TEST(SamplerTable, Normalize)
+{
+    std::mt19937 random(1);
+    for (const auto& key : MakeDistinctKeys(c_distinctDescs))
+    {
+        SamplerKey normalized = NormalizeSamplerKey(key);
+        for (int variant = 0; variant < 8; variant++)
+        {
+            SamplerKey noisy = NormalizeSamplerKey(AddNoise(key, random));
+            if (noisy != normalized || HashSamplerKey(noisy) != HashSamplerKey(normalized))
+                return false;
+        }
+    }
+
+    // What the sampler does use keeps samplers apart
+    SamplerKey border = GetStaticSamplerKey(StaticSampler::LinearClamp);
+    border.addressU = c_addressBorder;
+    SamplerKey otherBorder = border;
+    otherBorder.borderColor[0] = 1.0f;
+
+    SamplerKey anisotropic = GetStaticSamplerKey(StaticSampler::AnisotropicWrap);
+    SamplerKey lessAnisotropic = anisotropic;
+    lessAnisotropic.maxAnisotropy = 4;
+
+    SamplerKey comparison = GetStaticSamplerKey(StaticSampler::LinearClamp);
+    comparison.filter = c_filterComparisonMinMagMipLinear;
+    comparison.comparisonFunc = c_comparisonLessEqual;
+    SamplerKey otherComparison = comparison;
+    otherComparison.comparisonFunc = c_comparisonNever;
+
+    // Anisotropy is kept to what D3D accepts
+    SamplerKey tooAnisotropic = anisotropic;
+    tooAnisotropic.maxAnisotropy = 64;
+
+    return NormalizeSamplerKey(border) != NormalizeSamplerKey(otherBorder)
+        && NormalizeSamplerKey(anisotropic) != NormalizeSamplerKey(lessAnisotropic)
+        && NormalizeSamplerKey(comparison) != NormalizeSamplerKey(otherComparison)
+        && NormalizeSamplerKey(tooAnisotropic).maxAnisotropy == c_maxSamplerAnisotropy;
+}
+
+SCENEGRAPH_TEST(SamplerTable, Hash)
+{
+    // Many different keys, none of which should collide in 64 bits
+    std::mt19937 random(2);
+    std::unordered_set<uint64_t> hashes;
+    for (size_t index = 0; index < c_hashedKeys; index++)
+    {
+        SamplerKey key;
+        key.filter = random() % 0x200;
+        key.addressU = 1 + random() % 5;
+        key.mipLodBias = static_cast<float>(index);
+        hashes.insert(HashSamplerKey(key));
+    }
+    if (hashes.size() != c_hashedKeys)
+        return false;
+
+    // Keys that differ in a single field anywhere hash differently
+    SamplerKey key;
+    uint64_t hash = HashSamplerKey(key);
+    for (size_t field = 0; field < 13; field++)
+    {
+        SamplerKey changed = key;
+        uint32_t words[13];
+        std::memcpy(words, &changed, sizeof(words));
+        words[field] ^= 0x100;
+        std::memcpy(&changed, words, sizeof(words));
+        if (changed == key || HashSamplerKey(changed) == hash)
+            return false;
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(SamplerTable, Table)
+{
+    auto keys = MakeDistinctKeys(c_distinctDescs);
+    SamplerTable table;
+    std::vector<uint32_t> indices;
+    for (const auto& key : keys)
+    {
+        bool added = false;
+        indices.push_back(table.Insert(key, &added));
+        if (!added)
+            return false;
+    }
+
+    std::mt19937 random(3);
+    for (size_t lookup = 0; lookup < 4096; lookup++)
+    {
+        size_t which = random() % keys.size();
+        bool added = true;
+        SamplerKey noisy = AddNoise(keys[which], random);
+        if (table.Insert(noisy, &added) != indices[which] || added || table.Find(noisy) != indices[which])
+            return false;
+    }
+
+    SamplerKey missing = keys[0];
+    missing.maxLod = 1.0f;
+    auto stats = table.GetStats();
+    return table.GetCount() == c_distinctDescs && stats.unique == c_distinctDescs && stats.lookups == c_distinctDescs + 4096
+        && stats.hits == 4096 && table.Find(missing) == SamplerTable::c_notFound
+        && table.GetKey(indices[5]) == NormalizeSamplerKey(keys[5]);
+}
+
+SCENEGRAPH_TEST(SamplerTable, StaticSamplers)
+{
+    SamplerTable table;
+    for (uint32_t slot = 0; slot < c_staticSamplerCount; slot++)
+    {
+        bool added = false;
+        if (table.Insert(GetStaticSamplerKey(static_cast<StaticSampler>(slot)), &added) != slot || !added)
+            return false;
+    }
+
+    // Materials sample with s0, which has to be the sampler each of them used to create
+    return GetStaticSamplerKey(StaticSampler::LinearWrap) == OldMaterialSampler()
+        && table.Find(OldMaterialSampler()) == static_cast<uint32_t>(StaticSampler::LinearWrap);
+}
+
+SCENEGRAPH_TEST(SamplerTable, BoundOnceAFrame)
+{
+    std::vector<uint8_t> storage(c_staticSamplerCount + 8);
+    ID3D11SamplerState* samplers[c_staticSamplerCount];
+    for (uint32_t slot = 0; slot < c_staticSamplerCount; slot++)
+        samplers[slot] = FakeObject<ID3D11SamplerState>(storage, slot);
+
+    // Materials only bind their textures, so the static samplers are the only sampler binds
+    RecordingSink sink;
+    StateCache stateCache(&sink);
+    for (uint32_t frame = 0; frame < 4; frame++)
+    {
+        stateCache.BeginFrame();
+        BindStaticSamplers(stateCache, samplers);
+        for (uint32_t draw = 0; draw < 64; draw++)
+        {
+            stateCache.PSSetShaderResource(0, FakeObject<ID3D11ShaderResourceView>(storage, c_staticSamplerCount + draw % 8));
+            stateCache.DrawIndexed(36, 0, 0);
+        }
+    }
+
+    for (const auto& record : sink.GetRecords())
+    {
+        if (record.call == RecordingSink::Sampler && record.slot >= c_staticSamplerCount)
+            return false;
+    }
+    return sink.Count(RecordingSink::Sampler) == 4 * c_staticSamplerCount;
+}
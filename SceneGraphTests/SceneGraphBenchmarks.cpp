@@ -0,0 +1,129 @@
+// SceneGraphBenchmarks: runs the benchmarks behind the Performance panel of 10_SceneGraphs from the
+// command line, without a window, a GPU or the logger, and prints their reports to stdout so runs
+// can be compared between machines and commits.
+//
+// Usage: SceneGraphBenchmarks [--list] [<filter>]
+//
+// Runs every benchmark whose name contains the filter, or all of them without one, and exits with
+// 1 if the filter matches none. --list prints the names instead of running them.
+//
+// The asset loading and image benchmarks need stb_image, so they are only built in when the
+// CMakeLists.txt next to this file finds it (SCENEGRAPH_IMAGE_BENCHMARKS):
+//   cmake -S SceneGraphTests -B build && cmake --build build && build/SceneGraphBenchmarks
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "BvhBenchmark.h"
+#include "CullingBenchmark.h"
+#include "InstancingBenchmark.h"
+#include "LargeMeshBenchmark.h"
+#include "LodBenchmark.h"
+#include "MeshImportBenchmark.h"
+#include "MeshOptimizerBenchmark.h"
+#include "ProceduralGeometryBenchmark.h"
+#include "RenderQueueBenchmark.h"
+#include "ResourceCacheBenchmark.h"
+#include "SamplerCacheBenchmark.h"
+#include "SubmeshBenchmark.h"
+#include "TextureArrayBenchmark.h"
+#include "TransformBenchmark.h"
+#include "VertexCompressionBenchmark.h"
+
+#ifdef SCENEGRAPH_IMAGE_BENCHMARKS
+#include "AssetLoadingBenchmark.h"
+#include "ImageDecodeBenchmark.h"
+#include "TextureCompressionBenchmark.h"
+#endif
+
+namespace
+{
+    struct Benchmark
+    {
+        const char* name;
+        void (*run)(std::ostream& out);
+    };
+
+    // Same names and order as the buttons of the Performance panel
+    const Benchmark c_benchmarks[] =
+    {
+        { "Transform", [](std::ostream& out) { ReportTransformBenchmark(RunTransformBenchmark(), out); } },
+        { "Job scaling", [](std::ostream& out) { ReportJobScalingBenchmark(RunJobScalingBenchmark(), out); } },
+        { "Culling", [](std::ostream& out) { ReportCullingBenchmark(RunCullingBenchmark(), out); } },
+        { "BVH", [](std::ostream& out) { ReportBvhBenchmark(RunBvhBenchmark(), out); } },
+        { "Render queue", [](std::ostream& out) { ReportRenderQueueBenchmark(RunRenderQueueBenchmark(), out); } },
+        { "Instancing", [](std::ostream& out) { ReportInstancingBenchmark(RunInstancingBenchmark(), out); } },
+        { "Large mesh", [](std::ostream& out) { ReportLargeMeshBenchmark(RunLargeMeshBenchmark(), out); } },
+        { "Mesh optimizer", [](std::ostream& out) { ReportMeshOptimizerBenchmark(RunMeshOptimizerBenchmark(), out); } },
+        { "Vertex compression", [](std::ostream& out) { ReportVertexCompressionBenchmark(RunVertexCompressionBenchmark(), out); } },
+        { "LOD", [](std::ostream& out) { ReportLodBenchmark(RunLodBenchmark(), out); } },
+        { "Procedural geometry", [](std::ostream& out) { ReportProceduralGeometryBenchmark(RunProceduralGeometryBenchmark(), out); } },
+#ifdef SCENEGRAPH_IMAGE_BENCHMARKS
+        { "Asset loading", [](std::ostream& out) { ReportAssetLoadingBenchmark(RunAssetLoadingBenchmark(), out); } },
+#endif
+        { "Resource cache", [](std::ostream& out) { ReportResourceCacheBenchmark(RunResourceCacheBenchmark(), out); } },
+#ifdef SCENEGRAPH_IMAGE_BENCHMARKS
+        { "Texture compression", [](std::ostream& out) { ReportTextureCompressionBenchmark(RunTextureCompressionBenchmark(), out); } },
+        { "Image decode", [](std::ostream& out) { ReportImageDecodeBenchmark(RunImageDecodeBenchmark(), out); } },
+#endif
+        { "Sampler cache", [](std::ostream& out) { ReportSamplerCacheBenchmark(RunSamplerCacheBenchmark(), out); } },
+        { "Texture array", [](std::ostream& out) { ReportTextureArrayBenchmark(RunTextureArrayBenchmark(), out); } },
+        { "Submesh", [](std::ostream& out) { ReportSubmeshBenchmark(RunSubmeshBenchmark(), out); } },
+        { "Mesh import", [](std::ostream& out) { ReportMeshImportBenchmark(RunMeshImportBenchmark(), out); } },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    bool list = false;
+    std::string filter;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (std::strcmp(argv[arg], "--list") == 0)
+        {
+            list = true;
+        }
+        else if (argv[arg][0] == '-')
+        {
+            std::cerr << "Usage: SceneGraphBenchmarks [--list] [<filter>]\n";
+            return 2;
+        }
+        else
+        {
+            filter = argv[arg];
+        }
+    }
+
+    size_t run = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& benchmark : c_benchmarks)
+    {
+        if (std::string(benchmark.name).find(filter) == std::string::npos)
+            continue;
+
+        if (list)
+        {
+            std::cout << benchmark.name << "\n";
+            continue;
+        }
+
+        run++;
+        benchmark.run(std::cout);
+        std::cout << std::endl;
+    }
+
+    if (run == 0 && !list)
+    {
+        std::cerr << "No benchmark matches " << filter << "\n";
+        return 1;
+    }
+
+    if (!list)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << run << " benchmarks in " << seconds << " s\n";
+    }
+    return 0;
+}
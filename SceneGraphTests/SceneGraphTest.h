@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+/// A tiny test harness for the portable parts of 10_SceneGraphs. A test is a function returning
+/// whether the behaviour it pins down holds; SCENEGRAPH_TEST defines one and registers it, so a test
+/// file only has to be compiled in to be run.
+
+using TestFunction = bool (*)();
+
+struct TestCase
+{
+    const char* suite;
+    const char* name;
+    TestFunction function;
+};
+
+/// @brief Every test compiled into the executable
+std::vector<TestCase>& RegisteredTests();
+
+struct TestRegistration
+{
+    TestRegistration(const char* suite, const char* name, TestFunction function)
+    {
+        RegisteredTests().push_back({ suite, name, function });
+    }
+};
+
+#define SCENEGRAPH_TEST(suite, name) \
+    static bool suite##_##name(); \
+    static TestRegistration suite##_##name##_registration(#suite, #name, suite##_##name); \
+    static bool suite##_##name()
+
+/// @brief Whether two floats are within an absolute tolerance of each other
+inline bool Near(float a, float b, float tolerance = 1e-4f)
+{
+    return std::fabs(a - b) <= tolerance;
+}
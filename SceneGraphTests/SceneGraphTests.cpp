@@ -0,0 +1,113 @@
+// SceneGraphTests: checks the parts of 10_SceneGraphs that don't need a window or a GPU (culling,
+// the BVH, the render queue, the state cache, mesh and texture processing, ...) from the command line,
+// so they run headless and in CI.
+//
+// Usage: SceneGraphTests [--list] [<filter>]
+//
+// Runs every test whose Suite.Name contains the filter, or all of them without one, and exits with
+// 1 if any failed. --list prints the names instead of running them.
+//
+// Only portable code is used so it builds outside Visual Studio as well, e.g. on Linux with the
+// CMakeLists.txt next to this file, which also registers the tests with CTest:
+//   cmake -S SceneGraphTests -B build && cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "SceneGraphTest.h"
+
+std::vector<TestCase>& RegisteredTests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+namespace
+{
+    std::string FullName(const TestCase& test)
+    {
+        return std::string(test.suite) + "." + test.name;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool list = false;
+    std::string filter;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (std::strcmp(argv[arg], "--list") == 0)
+        {
+            list = true;
+        }
+        else if (argv[arg][0] == '-')
+        {
+            std::cerr << "Usage: SceneGraphTests [--list] [<filter>]\n";
+            return 2;
+        }
+        else
+        {
+            filter = argv[arg];
+        }
+    }
+
+    // Registration order depends on the link order, so sort for a stable report
+    auto tests = RegisteredTests();
+    std::stable_sort(tests.begin(), tests.end(), [](const TestCase& a, const TestCase& b)
+        {
+            return FullName(a) < FullName(b);
+        });
+
+    size_t run = 0;
+    std::vector<std::string> failures;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& test : tests)
+    {
+        std::string name = FullName(test);
+        if (name.find(filter) == std::string::npos)
+            continue;
+
+        if (list)
+        {
+            std::cout << name << "\n";
+            continue;
+        }
+
+        run++;
+        bool passed = false;
+        try
+        {
+            passed = test.function();
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << name << " threw: " << exception.what() << "\n";
+        }
+
+        std::cout << (passed ? "[  ok  ] " : "[ FAIL ] ") << name << std::endl;
+        if (!passed)
+            failures.push_back(name);
+    }
+
+    if (list)
+        return 0;
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "\n" << run - failures.size() << " of " << run << " tests passed in " << milliseconds << " ms\n";
+    for (const auto& failure : failures)
+    {
+        std::cout << "  failed: " << failure << "\n";
+    }
+
+    if (run == 0 && !filter.empty())
+    {
+        std::cerr << "No test matches " << filter << "\n";
+        return 1;
+    }
+
+    return failures.empty() ? 0 : 1;
+}
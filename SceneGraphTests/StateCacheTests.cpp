@@ -0,0 +1,139 @@
+#include <vector>
+
+#include "RecordingSink.h"
+#include "SceneGraphTest.h"
+#include "StateCache.h"
+
+SCENEGRAPH_TEST(StateCache, DropsRepeatedBinds)
+{
+    std::vector<uint8_t> storage(16);
+    auto* shaderA = FakeObject<ID3D11VertexShader>(storage, 0);
+    auto* shaderB = FakeObject<ID3D11VertexShader>(storage, 1);
+    auto* layout = FakeObject<ID3D11InputLayout>(storage, 2);
+
+    RecordingSink sink;
+    StateCache cache(&sink);
+    cache.VSSetShader(shaderA);
+    cache.VSSetShader(shaderA);
+    cache.VSSetShader(shaderB);
+    cache.VSSetShader(shaderB);
+    cache.IASetInputLayout(layout);
+    cache.IASetInputLayout(layout);
+    cache.IASetPrimitiveTopology(4);
+    cache.IASetPrimitiveTopology(4);
+
+    return sink.Count(RecordingSink::VertexShader) == 2 && sink.Count(RecordingSink::InputLayout) == 1 &&
+        sink.Count(RecordingSink::Topology) == 1 && cache.GetStats().issued == 4 && cache.GetStats().elided == 4;
+}
+
+SCENEGRAPH_TEST(StateCache, SlotsAreIndependent)
+{
+    std::vector<uint8_t> storage(16);
+    auto* view = FakeObject<ID3D11ShaderResourceView>(storage, 0);
+    auto* sampler = FakeObject<ID3D11SamplerState>(storage, 1);
+
+    RecordingSink sink;
+    StateCache cache(&sink);
+    cache.PSSetShaderResource(0, view);
+    cache.PSSetShaderResource(1, view);
+    cache.PSSetShaderResource(0, view);
+    cache.PSSetSampler(0, sampler);
+    cache.PSSetSampler(3, sampler);
+    cache.PSSetSampler(3, sampler);
+
+    return sink.Count(RecordingSink::ShaderResource) == 2 && sink.Count(RecordingSink::Sampler) == 2;
+}
+
+SCENEGRAPH_TEST(StateCache, ComparesWholeBindings)
+{
+    std::vector<uint8_t> storage(16);
+    auto* buffer = FakeObject<ID3D11Buffer>(storage, 0);
+
+    RecordingSink sink;
+    StateCache cache(&sink);
+
+    // A different stride, offset or index format is a different binding of the same buffer
+    cache.IASetVertexBuffer(0, buffer, 16, 0);
+    cache.IASetVertexBuffer(0, buffer, 16, 0);
+    cache.IASetVertexBuffer(0, buffer, 32, 0);
+    cache.IASetVertexBuffer(0, buffer, 32, 64);
+    cache.IASetIndexBuffer(buffer, 57, 0);
+    cache.IASetIndexBuffer(buffer, 42, 0);
+    cache.IASetIndexBuffer(buffer, 42, 0);
+
+    // And so are slices of a constant buffer at different offsets; the whole buffer is a slice of 0
+    cache.VSSetConstantBuffer(1, buffer);
+    cache.VSSetConstantBuffer(1, ConstantBufferSlice{ buffer, 0, 0 });
+    cache.VSSetConstantBuffer(1, ConstantBufferSlice{ buffer, 16, 4 });
+    cache.VSSetConstantBuffer(1, ConstantBufferSlice{ buffer, 16, 4 });
+    cache.VSSetConstantBuffer(1, ConstantBufferSlice{ buffer, 32, 4 });
+
+    return sink.Count(RecordingSink::VertexBuffer) == 3 && sink.Count(RecordingSink::IndexBuffer) == 2 &&
+        sink.Count(RecordingSink::VSConstantBuffer) == 3;
+}
+
+SCENEGRAPH_TEST(StateCache, InvalidateForgetsEverything)
+{
+    std::vector<uint8_t> storage(16);
+    auto* shader = FakeObject<ID3D11PixelShader>(storage, 0);
+    auto* buffer = FakeObject<ID3D11Buffer>(storage, 1);
+
+    RecordingSink sink;
+    StateCache cache(&sink);
+    cache.PSSetShader(shader);
+    cache.PSSetConstantBuffer(2, buffer);
+    cache.Invalidate();
+    cache.PSSetShader(shader);
+    cache.PSSetConstantBuffer(2, buffer);
+
+    // Changing the sink forgets what the old one had bound
+    RecordingSink other;
+    cache.SetSink(&other);
+    cache.PSSetShader(shader);
+
+    return sink.Count(RecordingSink::PixelShader) == 2 && sink.Count(RecordingSink::PSConstantBuffer) == 2 &&
+        other.Count(RecordingSink::PixelShader) == 1;
+}
+
+SCENEGRAPH_TEST(StateCache, FramesCountSeparately)
+{
+    std::vector<uint8_t> storage(16);
+    auto* shader = FakeObject<ID3D11VertexShader>(storage, 0);
+
+    RecordingSink sink;
+    StateCache cache(&sink);
+    cache.BeginFrame();
+    cache.VSSetShader(shader);
+    cache.VSSetShader(shader);
+    cache.DrawIndexed(3, 0, 0);
+    cache.DrawIndexedInstanced(3, 10, 0, 0, 0);
+
+    // The device context is cleared between frames, so the shader goes through again
+    cache.BeginFrame();
+    cache.VSSetShader(shader);
+
+    const auto& last = cache.GetLastFrameStats();
+    const auto& current = cache.GetStats();
+    return last.issued == 1 && last.elided == 1 && last.draws == 2 &&
+        current.issued == 1 && current.elided == 0 && current.draws == 0 &&
+        sink.Count(RecordingSink::VertexShader) == 2 && sink.Count(RecordingSink::Draw) == 2;
+}
+
+SCENEGRAPH_TEST(StateCache, UntrackedSlotsGoThrough)
+{
+    std::vector<uint8_t> storage(16);
+    auto* buffer = FakeObject<ID3D11Buffer>(storage, 0);
+    auto* sampler = FakeObject<ID3D11SamplerState>(storage, 1);
+
+    RecordingSink sink;
+    StateCache cache(&sink);
+    for (int repeat = 0; repeat < 2; repeat++)
+    {
+        cache.IASetVertexBuffer(StateCache::VertexBufferSlots, buffer, 16, 0);
+        cache.VSSetConstantBuffer(StateCache::ConstantBufferSlots, buffer);
+        cache.PSSetSampler(StateCache::SamplerSlots, sampler);
+    }
+
+    return sink.Count(RecordingSink::VertexBuffer) == 2 && sink.Count(RecordingSink::VSConstantBuffer) == 2 &&
+        sink.Count(RecordingSink::Sampler) == 2 && cache.GetStats().elided == 0;
+}
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MeshImport.h"
+#include "RecordingSink.h"
+#include "SceneGraphTest.h"
+
+namespace
+{
+    constexpr uint32_t c_materials = 6;
+    constexpr uint32_t c_largeGridQuads = 300;      // 90601 vertices, too many for 16 bit indices
+    constexpr uint32_t c_formatR16Uint = 57;        // DXGI_FORMAT_R16_UINT
+
+    /// @brief A flat grid of quads whose materials run in bands across it, the way a model made of
+    /// several meshes arrives once ImportMesh has merged them
+    struct MaterialGrid
+    {
+        std::vector<VertexNormalUV> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> triangleMaterials;
+    };
+
+    /// @param bandEnds The column each material's band ends before, in order
+    MaterialGrid MakeMaterialGrid(uint32_t quads, const std::vector<uint32_t>& bandEnds)
+    {
+        MaterialGrid grid;
+        uint32_t gridVertices = quads + 1;
+        for (uint32_t row = 0; row < gridVertices; row++)
+        {
+            for (uint32_t column = 0; column < gridVertices; column++)
+            {
+                float u = static_cast<float>(column) / quads;
+                float v = static_cast<float>(row) / quads;
+                grid.vertices.push_back(VertexNormalUV{ static_cast<float>(column), 0.0f, static_cast<float>(row), 0.0f, 1.0f, 0.0f, u, v });
+            }
+        }
+
+        for (uint32_t row = 0; row < quads; row++)
+        {
+            for (uint32_t column = 0; column < quads; column++)
+            {
+                auto band = std::upper_bound(bandEnds.begin(), bandEnds.end(), column);
+                auto material = static_cast<uint32_t>(std::min<size_t>(band - bandEnds.begin(), bandEnds.size() - 1));
+
+                uint32_t corner = row * gridVertices + column;
+                const uint32_t quad[] = { corner, corner + gridVertices, corner + 1, corner + 1, corner + gridVertices, corner + gridVertices + 1 };
+                grid.indices.insert(grid.indices.end(), std::begin(quad), std::end(quad));
+                grid.triangleMaterials.push_back(material);
+                grid.triangleMaterials.push_back(material);
+            }
+        }
+        return grid;
+    }
+
+    /// @brief Bands of equal width, one per material
+    std::vector<uint32_t> EqualBands(uint32_t quads, uint32_t materials)
+    {
+        std::vector<uint32_t> bandEnds;
+        for (uint32_t material = 1; material <= materials; material++)
+        {
+            bandEnds.push_back(quads * material / materials);
+        }
+        return bandEnds;
+    }
+
+    /// @brief Materials that can be told apart by their colour
+    std::vector<ImportedMaterial> MakeMaterials(uint32_t count)
+    {
+        std::vector<ImportedMaterial> materials(count);
+        for (uint32_t index = 0; index < count; index++)
+        {
+            materials[index].diffuse[0] = 0.1f * index;
+            materials[index].diffuse[1] = 1.0f - 0.1f * index;
+            materials[index].diffuse[2] = 0.5f;
+            materials[index].diffuseTexture = "texture" + std::to_string(index) + ".png";
+        }
+        return materials;
+    }
+
+    ImportedMesh PrepareGrid(const MaterialGrid& grid, uint32_t materials, LargeMeshMode mode)
+    {
+        ImportedMesh mesh;
+        mesh.materials = MakeMaterials(materials);
+        PrepareImportedMesh(grid.vertices, grid.indices, grid.triangleMaterials, mode, mesh);
+        return mesh;
+    }
+
+    /// @brief The range of the finest level of a submesh, from the start of the index buffer
+    LodLevel GetFinestLevel(const SubmeshData& submesh)
+    {
+        if (submesh.lods.empty())
+            return LodLevel{ submesh.firstIndex, submesh.indexCount, 0.0f };
+        return LodLevel{ submesh.firstIndex + submesh.lods[0].firstIndex, submesh.lods[0].indexCount, 0.0f };
+    }
+
+    uint32_t ReadIndex(const RenderableData& data, size_t index)
+    {
+        if (data.indexSize == sizeof(uint16_t))
+        {
+            uint16_t value;
+            std::memcpy(&value, data.indices.data() + index * sizeof(uint16_t), sizeof(value));
+            return value;
+        }
+        uint32_t value;
+        std::memcpy(&value, data.indices.data() + index * sizeof(uint32_t), sizeof(value));
+        return value;
+    }
+
+    // A triangle by its material and the grid points of its corners, turned so the smallest comes
+    // first, which keeps the winding
+    using Triangle = std::array<int64_t, 4>;
+
+    Triangle MakeTriangle(uint32_t material, const int64_t corners[3])
+    {
+        size_t first = std::min_element(corners, corners + 3) - corners;
+        return Triangle{ material, corners[first], corners[(first + 1) % 3], corners[(first + 2) % 3] };
+    }
+
+    int64_t GridPoint(float x, float z)
+    {
+        return std::llround(z) * 100000 + std::llround(x);
+    }
+
+    /// @brief Every triangle the submeshes draw at their finest level, with the material it is
+    /// drawn with; empty if an index points outside its submesh
+    std::vector<Triangle> CollectDrawnTriangles(const RenderableData& data)
+    {
+        std::vector<Triangle> triangles;
+        for (const auto& submesh : data.submeshes)
+        {
+            LodLevel level = GetFinestLevel(submesh);
+            for (uint32_t index = 0; index + 2 < level.indexCount; index += 3)
+            {
+                int64_t corners[3];
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t vertex = ReadIndex(data, level.firstIndex + index + corner);
+                    if (vertex >= submesh.vertexCount)
+                        return {};
+
+                    PackedVertexNormalUV packed;
+                    std::memcpy(&packed, data.vertices.data() + static_cast<size_t>(submesh.firstVertex + vertex) * data.vertexStride, sizeof(packed));
+                    float position[3];
+                    DequantizePosition(packed.position, submesh.quantization, position);
+                    corners[corner] = GridPoint(position[0], position[2]);
+                }
+                triangles.push_back(MakeTriangle(submesh.material, corners));
+            }
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    std::vector<Triangle> CollectSourceTriangles(const MaterialGrid& grid)
+    {
+        std::vector<Triangle> triangles;
+        for (size_t triangle = 0; triangle < grid.triangleMaterials.size(); triangle++)
+        {
+            int64_t corners[3];
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const auto& vertex = grid.vertices[grid.indices[triangle * 3 + corner]];
+                corners[corner] = GridPoint(vertex.x, vertex.z);
+            }
+            triangles.push_back(MakeTriangle(grid.triangleMaterials[triangle], corners));
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    /// @brief The submeshes follow one another through both buffers and end where they do
+    bool ValidateLayout(const RenderableData& data)
+    {
+        if (data.submeshes.empty() || data.vertices.size() != static_cast<size_t>(data.vertexCount) * data.vertexStride
+            || data.indices.size() != static_cast<size_t>(data.indexCount) * data.indexSize)
+            return false;
+
+        uint32_t nextIndex = 0;
+        uint32_t nextVertex = 0;
+        for (const auto& submesh : data.submeshes)
+        {
+            if (submesh.firstIndex != nextIndex || submesh.firstVertex != nextVertex || submesh.material >= data.materials.size())
+                return false;
+            nextIndex += submesh.indexCount;
+            nextVertex += submesh.vertexCount;
+        }
+        return nextIndex == data.indexCount && nextVertex == data.vertexCount;
+    }
+}
+
+// A mesh of several small materials is one renderable, a submesh per material, laid
+// out one after another
+SCENEGRAPH_TEST(Submesh, OneRenderable)
+{
+    auto grid = MakeMaterialGrid(40, EqualBands(40, c_materials));
+    auto mesh = PrepareGrid(grid, c_materials, LargeMeshMode::LongIndices);
+    const auto& data = mesh.renderable;
+
+    if (!ValidateLayout(data) || data.submeshes.size() != c_materials || data.materials.size() != c_materials
+        || data.vertexStride != sizeof(PackedVertexNormalUV) || mesh.parts.size() != c_materials)
+        return false;
+
+    for (const auto& part : mesh.parts)
+    {
+        if (part.submeshCount != 1)
+            return false;
+    }
+    return true;
+}
+
+// The submeshes draw each triangle of the source once, with its own material
+SCENEGRAPH_TEST(Submesh, Triangles)
+{
+    auto grid = MakeMaterialGrid(40, EqualBands(40, c_materials));
+    auto mesh = PrepareGrid(grid, c_materials, LargeMeshMode::LongIndices);
+    auto drawn = CollectDrawnTriangles(mesh.renderable);
+    return !drawn.empty() && drawn == CollectSourceTriangles(grid);
+}
+
+// The material table carries the source's colours, and a material missing from it is
+// white rather than out of range
+SCENEGRAPH_TEST(Submesh, Materials)
+{
+    auto grid = MakeMaterialGrid(12, { 4, 8, 12 });
+    for (auto& material : grid.triangleMaterials)
+    {
+        if (material == 2)
+            material = 4;   // past the end of the three materials
+    }
+
+    auto mesh = PrepareGrid(grid, 3, LargeMeshMode::LongIndices);
+    const auto& data = mesh.renderable;
+    if (!ValidateLayout(data) || data.materials.size() != 5 || data.submeshes.size() != 3)
+        return false;
+
+    for (uint32_t index = 0; index < 3; index++)
+    {
+        if (!std::equal(std::begin(data.materials[index].diffuse), std::end(data.materials[index].diffuse), mesh.materials[index].diffuse))
+            return false;
+    }
+    for (uint32_t index = 3; index < 5; index++)
+    {
+        const auto& diffuse = data.materials[index].diffuse;
+        if (diffuse[0] != 1.0f || diffuse[1] != 1.0f || diffuse[2] != 1.0f)
+            return false;
+    }
+
+    bool drawsMissing = std::any_of(data.submeshes.begin(), data.submeshes.end(), [](const SubmeshData& submesh) { return submesh.material == 4; });
+    return drawsMissing && CollectDrawnTriangles(data) == CollectSourceTriangles(grid);
+}
+
+// Indices are 16 bits while every submesh fits them. A part too big for them makes the
+// whole index buffer 32 bits if it is kept whole, or is split into submeshes that fit.
+SCENEGRAPH_TEST(Submesh, IndexSize)
+{
+    auto small = PrepareGrid(MakeMaterialGrid(40, EqualBands(40, c_materials)), c_materials, LargeMeshMode::LongIndices);
+    if (small.renderable.indexSize != sizeof(uint16_t))
+        return false;
+
+    // Material 0 covers 271 of the 301 columns of vertices: 81571 of them
+    auto grid = MakeMaterialGrid(c_largeGridQuads, { 270, c_largeGridQuads });
+    auto sourceTriangles = CollectSourceTriangles(grid);
+
+    auto whole = PrepareGrid(grid, 2, LargeMeshMode::LongIndices);
+    if (!ValidateLayout(whole.renderable) || whole.renderable.indexSize != sizeof(uint32_t) || whole.renderable.submeshes.size() != 2
+        || CollectDrawnTriangles(whole.renderable) != sourceTriangles)
+        return false;
+
+    auto split = PrepareGrid(grid, 2, LargeMeshMode::Split);
+    if (!ValidateLayout(split.renderable) || split.renderable.indexSize != sizeof(uint16_t) || split.renderable.submeshes.size() <= 2
+        || split.parts.size() != 2 || split.parts[0].submeshCount < 2 || split.parts[1].submeshCount != 1)
+        return false;
+
+    for (const auto& submesh : split.renderable.submeshes)
+    {
+        if (!FitsShortIndices(submesh.vertexCount))
+            return false;
+    }
+    return CollectDrawnTriangles(split.renderable) == sourceTriangles;
+}
+
+// Each submesh's levels of detail lie in its own range, finest first, index only its
+// own vertices and get coarser as they go
+SCENEGRAPH_TEST(Submesh, LodRanges)
+{
+    auto grid = MakeMaterialGrid(60, EqualBands(60, 3));
+    auto mesh = PrepareGrid(grid, 3, LargeMeshMode::LongIndices);
+    const auto& data = mesh.renderable;
+    if (!ValidateLayout(data))
+        return false;
+
+    bool anyLods = false;
+    for (const auto& submesh : data.submeshes)
+    {
+        if (submesh.lods.empty())
+            continue;
+
+        anyLods = true;
+        if (submesh.lods[0].firstIndex != 0)
+            return false;
+        for (size_t lod = 0; lod < submesh.lods.size(); lod++)
+        {
+            const auto& level = submesh.lods[lod];
+            if (level.indexCount == 0 || level.indexCount % 3 != 0 || level.firstIndex + level.indexCount > submesh.indexCount)
+                return false;
+            if (lod > 0 && (level.indexCount > submesh.lods[lod - 1].indexCount || level.error < submesh.lods[lod - 1].error))
+                return false;
+
+            for (uint32_t index = 0; index < level.indexCount; index++)
+            {
+                if (ReadIndex(data, submesh.firstIndex + level.firstIndex + index) >= submesh.vertexCount)
+                    return false;
+            }
+        }
+    }
+    return anyLods;
+}
+
+// Copies of a mesh of several materials bind its buffers once between them, and draw a
+// submesh at a time, each binding its buffers and its slice of the constants the way
+// Renderable does
+SCENEGRAPH_TEST(Submesh, Draws)
+{
+    constexpr uint32_t c_copies = 20;
+    constexpr uint32_t c_constantsPerSubmesh = 256 / 16;
+    auto data = PrepareGrid(MakeMaterialGrid(40, EqualBands(40, c_materials)), c_materials, LargeMeshMode::LongIndices).renderable;
+
+    std::vector<uint8_t> storage(3);
+    auto* vertexBuffer = FakeObject<ID3D11Buffer>(storage, 0);
+    auto* indexBuffer = FakeObject<ID3D11Buffer>(storage, 1);
+    auto* constants = FakeObject<ID3D11Buffer>(storage, 2);
+
+    RecordingSink sink;
+    StateCache stateCache(&sink);
+    for (uint32_t copy = 0; copy < c_copies; copy++)
+    {
+        for (uint32_t submesh = 0; submesh < data.submeshes.size(); submesh++)
+        {
+            const auto& range = data.submeshes[submesh];
+            stateCache.VSSetConstantBuffer(2, ConstantBufferSlice{ constants, submesh * c_constantsPerSubmesh, c_constantsPerSubmesh });
+            stateCache.IASetVertexBuffer(0, vertexBuffer, data.vertexStride, 0);
+            stateCache.IASetIndexBuffer(indexBuffer, c_formatR16Uint, 0);
+            stateCache.DrawIndexed(range.indexCount, range.firstIndex, static_cast<int32_t>(range.firstVertex));
+        }
+    }
+
+    return sink.Count(RecordingSink::VertexBuffer) == 1 && sink.Count(RecordingSink::IndexBuffer) == 1 &&
+        sink.Count(RecordingSink::Draw) == static_cast<size_t>(c_copies) * c_materials;
+}
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "CookedTexture.h"
+#include "InstanceBatcher.h"
+#include "RecordingSink.h"
+#include "RenderQueue.h"
+#include "SceneGraphTest.h"
+#include "TextureArrayPlanner.h"
+#include "TextureMips.h"
+
+namespace
+{
+    constexpr uint32_t c_geometries = 50;
+    constexpr uint32_t c_variants = 6;
+    constexpr uint32_t c_frameTextures = c_geometries * c_variants;
+
+    /// @brief The shape of a texture with its whole mip chain, as the cooker writes it
+    TextureShape MakeShape(uint32_t width, uint32_t height, CookedTextureFormat format, uint32_t mipCount = 0)
+    {
+        TextureShape shape;
+        shape.width = width;
+        shape.height = height;
+        shape.format = static_cast<uint32_t>(format);
+        shape.mipCount = mipCount != 0 ? mipCount : GetMipCount(width, height);
+
+        for (uint32_t level = 0; level < shape.mipCount; level++)
+        {
+            shape.sliceBytes += GetCookedLevelSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+        }
+        return shape;
+    }
+
+    /// @brief Textures as a scene might have them: mostly block compressed, a few sizes, the odd
+    /// one that isn't square
+    std::vector<TextureShape> MakeTextureMix(uint32_t count, uint32_t seed)
+    {
+        const TextureShape shapes[] = {
+            MakeShape(512, 512, CookedTextureFormat::BC1),
+            MakeShape(1024, 1024, CookedTextureFormat::BC1),
+            MakeShape(1024, 1024, CookedTextureFormat::BC3),
+            MakeShape(2048, 2048, CookedTextureFormat::BC7),
+            MakeShape(256, 256, CookedTextureFormat::RGBA8),
+            MakeShape(512, 256, CookedTextureFormat::RGBA8),
+        };
+        const uint32_t weights[] = { 30, 30, 15, 5, 15, 5 };
+
+        std::mt19937 random(seed);
+        std::discrete_distribution<uint32_t> pick(std::begin(weights), std::end(weights));
+        std::vector<TextureShape> mix;
+        for (uint32_t index = 0; index < count; index++)
+        {
+            mix.push_back(shapes[pick(random)]);
+        }
+        return mix;
+    }
+
+    uint32_t CountShapes(const std::vector<TextureShape>& mix)
+    {
+        std::set<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> shapes;
+        for (const auto& shape : mix)
+        {
+            shapes.insert({ shape.width, shape.height, shape.mipCount, shape.format });
+        }
+        return static_cast<uint32_t>(shapes.size());
+    }
+
+    bool SameSlot(TextureArraySlot a, TextureArraySlot b)
+    {
+        return a.array == b.array && a.slice == b.slice;
+    }
+
+    struct FrameCounts
+    {
+        size_t materialChanges = 0;
+        size_t textureCalls = 0;
+        size_t drawCalls = 0;
+        bool batchesShareArrays = true;     // every texture in a batch is in the array it binds
+    };
+
+    struct Draw
+    {
+        uint32_t geometry;
+        uint32_t texture;
+        float depth;
+    };
+
+    /// @brief Sort, batch and submit a frame of draws as the renderer does
+    /// @param byArray Key materials on the array their texture is in, rather than on the texture
+    FrameCounts DrawFrame(const std::vector<Draw>& draws, const std::vector<TextureArraySlot>& slots, bool byArray)
+    {
+        std::vector<uint8_t> objects(1 + 2 * c_frameTextures + c_geometries);
+        auto textureObject = [&](uint32_t texture)
+        {
+            return 1 + (byArray ? slots[texture].array : c_frameTextures + texture);
+        };
+
+        RenderQueue queue;
+        for (uint32_t index = 0; index < draws.size(); index++)
+        {
+            const auto& draw = draws[index];
+            queue.Submit(objects.data(), objects.data() + textureObject(draw.texture), objects.data() + 1 + 2 * c_frameTextures + draw.geometry, draw.depth, index);
+        }
+        queue.Sort();
+
+        InstanceBatcher batcher;
+        batcher.Build(queue.GetPackets(), [](const DrawPacket&) { return true; });
+
+        FrameCounts counts;
+        counts.materialChanges = queue.GetStats().materialChanges;
+
+        RecordingSink sink;
+        StateCache stateCache(&sink);
+        stateCache.BeginFrame();
+        const auto& packets = queue.GetPackets();
+        for (const auto& batch : batcher.GetBatches())
+        {
+            uint32_t texture = draws[packets[batch.firstPacket].item].texture;
+            stateCache.PSSetShaderResource(0, FakeObject<ID3D11ShaderResourceView>(objects, textureObject(texture)));
+            for (uint32_t index = batch.firstPacket; index < batch.firstPacket + batch.packetCount; index++)
+            {
+                uint32_t other = draws[packets[index].item].texture;
+                if (byArray && slots[other].array != slots[texture].array)
+                    counts.batchesShareArrays = false;
+                if (!batch.instanced)
+                    stateCache.DrawIndexed(36, 0, 0);
+            }
+            if (batch.instanced)
+                stateCache.DrawIndexedInstanced(36, batch.packetCount, 0, 0, batch.firstInstance);
+        }
+
+        counts.textureCalls = sink.Count(RecordingSink::ShaderResource);
+        counts.drawCalls = sink.Count(RecordingSink::Draw);
+        return counts;
+    }
+
+    /// @brief A frame of draws of a few geometries, each drawn with one of a few textures
+    std::vector<Draw> MakeDraws(uint32_t count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> depth(1.0f, 500.0f);
+        std::vector<Draw> draws;
+        for (uint32_t index = 0; index < count; index++)
+        {
+            uint32_t geometry = random() % c_geometries;
+            draws.push_back(Draw{ geometry, geometry * c_variants + static_cast<uint32_t>(random() % c_variants), depth(random) });
+        }
+        return draws;
+    }
+
+    std::vector<TextureArraySlot> PlaceFrameTextures(TextureArrayPlanner& planner, uint32_t seed)
+    {
+        std::vector<TextureArraySlot> slots;
+        for (const auto& shape : MakeTextureMix(c_frameTextures, seed))
+        {
+            slots.push_back(planner.Place(shape).slot);
+        }
+        return slots;
+    }
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, GroupedByShape)
+{
+    auto mix = MakeTextureMix(300, 1);
+    TextureArrayPlanner planner;
+    std::set<std::pair<uint32_t, uint32_t>> slots;
+    for (const auto& shape : mix)
+    {
+        auto slot = planner.Place(shape).slot;
+        if (!slot.IsValid() || planner.GetArray(slot.array).shape != shape || slot.slice >= planner.GetArray(slot.array).capacity)
+            return false;
+        if (!slots.insert({ slot.array, slot.slice }).second)
+            return false;
+    }
+
+    // None of the mix is big enough to need a second array of its shape
+    auto stats = planner.GetStats();
+    return stats.arrays == CountShapes(mix) && stats.textures == mix.size();
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, KeptApart)
+{
+    TextureArrayPlanner planner;
+    auto base = planner.Place(MakeShape(256, 256, CookedTextureFormat::BC1)).slot;
+    auto format = planner.Place(MakeShape(256, 256, CookedTextureFormat::BC3)).slot;
+    auto mips = planner.Place(MakeShape(256, 256, CookedTextureFormat::BC1, 4)).slot;
+    auto size = planner.Place(MakeShape(256, 128, CookedTextureFormat::BC1)).slot;
+    auto same = planner.Place(MakeShape(256, 256, CookedTextureFormat::BC1)).slot;
+
+    std::set<uint32_t> arrays = { base.array, format.array, mips.array, size.array };
+    return arrays.size() == 4 && same.array == base.array && same.slice == 1;
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, Growth)
+{
+    TextureArrayLimits limits;
+    limits.initialSlices = 4;
+    TextureArrayPlanner planner(limits);
+    auto shape = MakeShape(256, 256, CookedTextureFormat::RGBA8);
+
+    for (uint32_t index = 0; index < 4; index++)
+    {
+        auto placement = planner.Place(shape);
+        if (placement.grown || placement.created != (index == 0) || placement.slot.slice != index)
+            return false;
+    }
+
+    auto fifth = planner.Place(shape);
+    if (!fifth.grown || fifth.created || fifth.previousCapacity != 4 || fifth.slot.slice != 4 || planner.GetArray(0).capacity != 8)
+        return false;
+    for (uint32_t index = 5; index < 8; index++)
+    {
+        if (planner.Place(shape).grown)
+            return false;
+    }
+    auto ninth = planner.Place(shape);
+
+    auto stats = planner.GetStats();
+    return ninth.grown && ninth.previousCapacity == 8 && planner.GetArray(0).capacity == 16 && stats.arrays == 1
+        && stats.grows == 2 && stats.grownBytes == 12 * shape.sliceBytes && stats.usedBytes == 9 * shape.sliceBytes
+        && stats.capacityBytes == 16 * shape.sliceBytes;
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, Limits)
+{
+    // The slice limit: once an array is as big as it may get, another is started
+    TextureArrayLimits limits;
+    limits.maxSlices = 8;
+    TextureArrayPlanner planner(limits);
+    auto shape = MakeShape(128, 128, CookedTextureFormat::BC1);
+    for (uint32_t index = 0; index < 20; index++)
+    {
+        planner.Place(shape);
+    }
+    for (uint32_t array = 0; array < planner.GetArrayCount(); array++)
+    {
+        if (planner.GetArray(array).capacity > 8)
+            return false;
+    }
+    if (planner.GetStats().arrays != 3 || planner.GetSliceLimit(shape) != 8)
+        return false;
+
+    // The byte limit, which never stops a texture bigger than it going in on its own
+    TextureArrayLimits bytes;
+    auto big = MakeShape(1024, 1024, CookedTextureFormat::RGBA8);
+    bytes.maxArrayBytes = big.sliceBytes * 3;
+    TextureArrayPlanner budgeted(bytes);
+    for (uint32_t index = 0; index < 7; index++)
+    {
+        budgeted.Place(big);
+    }
+    auto huge = MakeShape(4096, 4096, CookedTextureFormat::RGBA8);
+    auto hugeSlot = budgeted.Place(huge).slot;
+
+    return budgeted.GetSliceLimit(big) == 3 && budgeted.GetSliceLimit(huge) == 1 && budgeted.GetArray(0).capacity == 3
+        && budgeted.GetArray(hugeSlot.array).capacity == 1 && budgeted.GetStats().arrays == 4;
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, ReleaseAndReuse)
+{
+    TextureArrayLimits limits;
+    limits.initialSlices = 8;
+    TextureArrayPlanner planner(limits);
+    auto shape = MakeShape(256, 256, CookedTextureFormat::BC3);
+    std::vector<TextureArraySlot> slots;
+    for (uint32_t index = 0; index < 6; index++)
+    {
+        slots.push_back(planner.Place(shape).slot);
+    }
+
+    planner.Release(slots[2]);
+    planner.Release(slots[4]);
+    planner.Release(slots[4]);              // a second release is ignored
+    planner.Release(TextureArraySlot());    // as is an invalid slot
+    if (planner.GetArray(0).used != 4)
+        return false;
+
+    auto first = planner.Place(shape);
+    auto second = planner.Place(shape);
+    auto third = planner.Place(shape);
+    std::set<uint32_t> reused = { first.slot.slice, second.slot.slice };
+    return reused == std::set<uint32_t>{ 2, 4 } && !first.grown && !second.grown && third.slot.slice == 6
+        && planner.GetArray(0).used == 7 && planner.GetArray(0).capacity == 8;
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, EmptiedArrays)
+{
+    TextureArrayPlanner planner;
+    auto a = MakeShape(256, 256, CookedTextureFormat::BC1);
+    auto b = MakeShape(512, 512, CookedTextureFormat::BC1);
+    auto c = MakeShape(128, 128, CookedTextureFormat::BC7);
+
+    std::vector<TextureArraySlot> slotsA;
+    for (uint32_t index = 0; index < 3; index++)
+    {
+        slotsA.push_back(planner.Place(a).slot);
+    }
+    auto slotB = planner.Place(b).slot;
+    for (auto slot : slotsA)
+    {
+        planner.Release(slot);
+    }
+    if (planner.GetArray(slotsA[0].array).capacity != 0 || planner.GetStats().arrays != 1)
+        return false;
+
+    auto placedC = planner.Place(c);
+    auto placedA = planner.Place(a);
+    return placedC.created && placedC.slot.array == slotsA[0].array && placedC.slot.slice == 0
+        && placedA.created && placedA.slot.array == 2 && !SameSlot(placedA.slot, slotB) && planner.GetArrayCount() == 3;
+}
+
+SCENEGRAPH_TEST(TextureArrayPlanner, FewerBinds)
+{
+    TextureArrayPlanner planner;
+    auto slots = PlaceFrameTextures(planner, 2);
+    auto draws = MakeDraws(1000, 3);
+    auto before = DrawFrame(draws, slots, false);
+    auto after = DrawFrame(draws, slots, true);
+
+    return after.batchesShareArrays && after.textureCalls <= planner.GetStats().arrays && after.textureCalls < before.textureCalls
+        && after.materialChanges < before.materialChanges && after.drawCalls < before.drawCalls;
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "CookedTexture.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "SceneGraphTest.h"
+#include "TextureMips.h"
+
+namespace
+{
+    DecodedImage MakeImage(uint32_t width, uint32_t height, const std::function<void(uint32_t, uint32_t, uint8_t*)>& texel)
+    {
+        DecodedImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                texel(x, y, image.pixels.data() + (static_cast<size_t>(y) * width + x) * 4);
+            }
+        }
+        return image;
+    }
+}
+
+SCENEGRAPH_TEST(TextureCompression, MipChain)
+{
+    if (GetMipCount(1, 1) != 1 || GetMipCount(512, 384) != 10 || GetMipCount(5, 3) != 3)
+        return false;
+
+    auto image = MakeImage(5, 3, [](uint32_t x, uint32_t y, uint8_t* texel) { texel[0] = texel[1] = texel[2] = texel[3] = static_cast<uint8_t>(x * 40 + y); });
+    for (auto filter : { MipFilter::Box, MipFilter::Kaiser })
+    {
+        MipOptions options;
+        options.filter = filter;
+        std::vector<DecodedImage> levels;
+        GenerateMips(image, options, levels);
+
+        const uint32_t expected[3][2] = { { 5, 3 }, { 2, 1 }, { 1, 1 } };
+        if (levels.size() != 3 || levels[0].pixels != image.pixels)
+            return false;
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            if (levels[level].width != expected[level][0] || levels[level].height != expected[level][1]
+                || levels[level].pixels.size() != static_cast<size_t>(expected[level][0]) * expected[level][1] * 4)
+                return false;
+        }
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(TextureCompression, FlatImage)
+{
+    auto image = MakeImage(48, 20, [](uint32_t, uint32_t, uint8_t* texel) { texel[0] = 17; texel[1] = 130; texel[2] = 250; texel[3] = 99; });
+    for (auto filter : { MipFilter::Box, MipFilter::Kaiser })
+    {
+        for (bool wrap : { true, false })
+        {
+            MipOptions options;
+            options.filter = filter;
+            options.wrap = wrap;
+            std::vector<DecodedImage> levels;
+            GenerateMips(image, options, levels);
+            for (const auto& level : levels)
+            {
+                for (size_t index = 0; index < level.pixels.size(); index += 4)
+                {
+                    if (!std::equal(level.pixels.begin() + index, level.pixels.begin() + index + 4, image.pixels.begin()))
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Half black and half white averages to a half as bright in linear light, which sRGB
+// encodes as 188, not 128; alpha and linear images average as they are
+SCENEGRAPH_TEST(TextureCompression, LinearLight)
+{
+    auto image = MakeImage(2, 2, [](uint32_t x, uint32_t y, uint8_t* texel) { texel[0] = texel[1] = texel[2] = texel[3] = (x + y) % 2 == 0 ? 255 : 0; });
+    std::vector<DecodedImage> levels;
+    MipOptions options;
+    options.filter = MipFilter::Box;
+    GenerateMips(image, options, levels);
+    auto srgb = levels.back().pixels;
+
+    options.srgb = false;
+    GenerateMips(image, options, levels);
+    auto linear = levels.back().pixels;
+
+    return std::abs(srgb[0] - 188) <= 1 && srgb[3] == 128 && linear[0] == 128 && linear[3] == 128;
+}
+
+// A block of one colour comes back as that colour, give or take the format's precision
+SCENEGRAPH_TEST(TextureCompression, SolidBlocks)
+{
+    const std::pair<BlockFormat, int> formats[] = { { BlockFormat::BC1, 4 }, { BlockFormat::BC3, 4 }, { BlockFormat::BC7, 1 } };
+    const uint8_t colours[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 200, 100, 37, 255 }, { 12, 240, 130, 77 } };
+    for (const auto& format : formats)
+    {
+        for (const auto& colour : colours)
+        {
+            uint8_t texels[64];
+            for (int texel = 0; texel < 16; texel++)
+                std::copy_n(colour, 4, texels + texel * 4);
+
+            uint8_t block[16];
+            uint8_t decoded[64];
+            CompressBlock(format.first, texels, block);
+            DecompressBlock(format.first, block, decoded);
+            bool hasAlpha = format.first != BlockFormat::BC1;
+            for (int texel = 0; texel < 16; texel++)
+            {
+                for (int channel = 0; channel < (hasAlpha ? 4 : 3); channel++)
+                {
+                    if (std::abs(decoded[texel * 4 + channel] - colour[channel]) > format.second)
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(TextureCompression, CookedTexture)
+{
+    auto image = MakeImage(64, 32, [](uint32_t x, uint32_t y, uint8_t* texel) { texel[0] = static_cast<uint8_t>(x * 4); texel[1] = static_cast<uint8_t>(y * 8); texel[2] = 90; texel[3] = 255; });
+    std::vector<DecodedImage> levels;
+    GenerateMips(image, MipOptions(), levels);
+
+    CookedTextureData texture;
+    texture.format = CookedTextureFormat::BC1;
+    texture.width = image.width;
+    texture.height = image.height;
+    for (const auto& level : levels)
+    {
+        texture.levels.emplace_back();
+        CompressImage(BlockFormat::BC1, level, texture.levels.back());
+    }
+
+    std::error_code fileError;
+    auto path = std::filesystem::temp_directory_path(fileError) / "scenegraph-tests.wtgt";
+    std::string error;
+    if (fileError || !WriteCookedTexture(path.string(), texture, error))
+        return false;
+
+    bool matches = false;
+    {
+        MappedFile file;
+        CookedTextureView view;
+        if (file.Open(path.string()) && view.Open(file.GetData(), file.GetSize()))
+        {
+            const auto& header = view.GetHeader();
+            matches = view.GetFormat() == CookedTextureFormat::BC1 && view.IsSrgb() && header.mipCount == levels.size();
+            for (uint32_t level = 0; matches && level < header.mipCount; level++)
+            {
+                const auto* data = static_cast<const uint8_t*>(view.GetMipData(level));
+                matches = view.GetMip(level).width == levels[level].width && std::equal(data, data + view.GetMip(level).size, texture.levels[level].begin());
+            }
+
+            // One byte short has to be rejected, not read past
+            CookedTextureView truncated;
+            matches = matches && !truncated.Open(file.GetData(), file.GetSize() - 1);
+        }
+    }
+    std::filesystem::remove(path, fileError);
+
+    // Block compressed textures have to be whole blocks
+    texture.width = 30;
+    return matches && !WriteCookedTexture(path.string(), texture, error);
+}
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SceneGraphTest.h"
+#include "TransformHierarchy.h"
+
+namespace
+{
+    using Handle = TransformHierarchy::Handle;
+
+    bool MatricesNear(const DirectX::XMMATRIX& a, const DirectX::XMMATRIX& b, float tolerance = 1e-4f)
+    {
+        DirectX::XMFLOAT4X4 left, right;
+        DirectX::XMStoreFloat4x4(&left, a);
+        DirectX::XMStoreFloat4x4(&right, b);
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                if (!Near(left.m[row][column], right.m[row][column], tolerance))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool NearFloat3(const DirectX::XMFLOAT3& a, float x, float y, float z, float tolerance = 1e-4f)
+    {
+        return Near(a.x, x, tolerance) && Near(a.y, y, tolerance) && Near(a.z, z, tolerance);
+    }
+
+    /// @brief Two quaternions for the same rotation, allowing for q and -q being the same one
+    bool SameRotation(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, float tolerance = 1e-4f)
+    {
+        float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        return Near(std::fabs(dot), 1.0f, tolerance);
+    }
+
+    /// @brief The Euler rotation the long way: Y, then X, then Z, one matrix at a time
+    DirectX::XMMATRIX EulerMatrix(float x, float y, float z)
+    {
+        return DirectX::XMMatrixRotationY(DirectX::XMConvertToRadians(y)) * DirectX::XMMatrixRotationX(DirectX::XMConvertToRadians(x)) *
+            DirectX::XMMatrixRotationZ(DirectX::XMConvertToRadians(z));
+    }
+
+    std::vector<Handle> Sorted(std::vector<Handle> handles)
+    {
+        std::sort(handles.begin(), handles.end());
+        return handles;
+    }
+
+    /// @brief A tree with `count` nodes, each with `branching` children, wide enough that the
+    /// parallel update splits its lower levels into several jobs
+    std::vector<Handle> MakeTree(TransformHierarchy& hierarchy, uint32_t count, uint32_t branching)
+    {
+        std::vector<Handle> handles;
+        for (uint32_t index = 0; index < count; index++)
+        {
+            handles.push_back(hierarchy.Create());
+            if (index > 0)
+                hierarchy.SetParent(handles[index], handles[(index - 1) / branching]);
+        }
+        return handles;
+    }
+
+    /// @brief Give some of the nodes a new local transform, the same ones in every hierarchy for the same seed
+    void MoveSome(TransformHierarchy& hierarchy, const std::vector<Handle>& handles, uint32_t seed, uint32_t every)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+        std::uniform_real_distribution<float> angle(-80.0f, 80.0f);
+        std::uniform_real_distribution<float> scale(0.9f, 1.1f);
+        for (auto handle : handles)
+        {
+            if (random() % every != 0)
+                continue;
+            hierarchy.SetLocalTranslation(handle, offset(random), offset(random), offset(random));
+            hierarchy.SetLocalRotation(handle, angle(random), angle(random), angle(random));
+            float uniform = scale(random);
+            hierarchy.SetLocalScale(handle, uniform, uniform, uniform);
+        }
+    }
+
+    bool SameWorld(const TransformHierarchy& a, const TransformHierarchy& b, const std::vector<Handle>& handles)
+    {
+        for (auto handle : handles)
+        {
+            if (std::memcmp(&a.GetWorldTransform(handle), &b.GetWorldTransform(handle), sizeof(DirectX::XMMATRIX)) != 0)
+                return false;
+        }
+        return Sorted(a.GetRecomputed()) == Sorted(b.GetRecomputed());
+    }
+}
+
+SCENEGRAPH_TEST(TransformHierarchy, TrsOrder)
+{
+    TransformHierarchy hierarchy;
+    Handle root = hierarchy.Create();
+    Handle child = hierarchy.Create();
+    hierarchy.SetParent(child, root);
+
+    hierarchy.SetLocalScale(root, 2.0f, 2.0f, 2.0f);
+    hierarchy.SetLocalRotation(root, 0.0f, 90.0f, 0.0f);
+    hierarchy.SetLocalTranslation(root, 1.0f, 2.0f, 3.0f);
+    hierarchy.SetLocalScale(child, 1.0f, 2.0f, 1.0f);
+    hierarchy.SetLocalRotation(child, 30.0f, 45.0f, 60.0f);
+    hierarchy.SetLocalTranslation(child, 1.0f, 0.0f, 0.0f);
+    hierarchy.Update();
+
+    // Locally it is scale, then rotate, then translate, with the Euler angles turning Y, X, then
+    // Z; the parent's world transform goes in front, as it always has in the scene graph
+    DirectX::XMMATRIX rootWorld = DirectX::XMMatrixScaling(2.0f, 2.0f, 2.0f) * EulerMatrix(0.0f, 90.0f, 0.0f) * DirectX::XMMatrixTranslation(1.0f, 2.0f, 3.0f);
+    DirectX::XMMATRIX childLocal = DirectX::XMMatrixScaling(1.0f, 2.0f, 1.0f) * EulerMatrix(30.0f, 45.0f, 60.0f) * DirectX::XMMatrixTranslation(1.0f, 0.0f, 0.0f);
+    bool matrices = MatricesNear(hierarchy.GetWorldTransform(root), rootWorld) && MatricesNear(hierarchy.GetWorldTransform(child), rootWorld * childLocal);
+
+    // The root's x axis is doubled and turned a quarter around y onto -z, and its origin moved
+    DirectX::XMFLOAT4X4 world;
+    DirectX::XMStoreFloat4x4(&world, hierarchy.GetWorldTransform(root));
+    return matrices && Near(world._11, 0.0f) && Near(world._13, -2.0f) && NearFloat3(hierarchy.GetWorldTranslation(root), 1.0f, 2.0f, 3.0f);
+}
+
+SCENEGRAPH_TEST(TransformHierarchy, EulerRoundTrip)
+{
+    TransformHierarchy hierarchy;
+    Handle euler = hierarchy.Create();
+    Handle quat = hierarchy.Create();
+
+    const float angles[][3] = { { 0.0f, 0.0f, 0.0f }, { 30.0f, 45.0f, 60.0f }, { -80.0f, 170.0f, -120.0f }, { 10.0f, -90.0f, 0.0f }, { 89.0f, 0.0f, 45.0f } };
+    for (const auto& angle : angles)
+    {
+        // The angles come back exactly as given, and make the rotation they say they do
+        hierarchy.SetLocalRotation(euler, angle[0], angle[1], angle[2]);
+        DirectX::XMFLOAT3 kept = hierarchy.GetLocalRotation(euler);
+        DirectX::XMFLOAT4 rotation = hierarchy.GetLocalRotationQuat(euler);
+        if (kept.x != angle[0] || kept.y != angle[1] || kept.z != angle[2] ||
+            !MatricesNear(DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&rotation)), EulerMatrix(angle[0], angle[1], angle[2])))
+        {
+            return false;
+        }
+
+        // Setting the quaternion instead gives the same angles back, away from the poles
+        hierarchy.SetLocalRotationQuat(quat, rotation);
+        DirectX::XMFLOAT4 keptQuat = hierarchy.GetLocalRotationQuat(quat);
+        if (std::memcmp(&keptQuat, &rotation, sizeof(rotation)) != 0 || !NearFloat3(hierarchy.GetLocalRotation(quat), angle[0], angle[1], angle[2], 1e-2f))
+            return false;
+    }
+    return true;
+}
+
+SCENEGRAPH_TEST(TransformHierarchy, DirtyPropagation)
+{
+    TransformHierarchy hierarchy;
+    Handle root = hierarchy.Create();
+    Handle a = hierarchy.Create();
+    Handle b = hierarchy.Create();
+    Handle sibling = hierarchy.Create();
+    hierarchy.Create(); // A root of its own, which nothing below touches
+    hierarchy.SetParent(a, root);
+    hierarchy.SetParent(b, a);
+    hierarchy.SetParent(sibling, root);
+
+    // Everything starts out dirty, and nothing is once it has been updated
+    hierarchy.Update();
+    bool first = hierarchy.GetRecomputed().size() == 5;
+    hierarchy.Update();
+    bool clean = hierarchy.GetRecomputed().empty() && hierarchy.GetStats().nodesRecomputed == 0;
+
+    // A change reaches every descendant and nothing else
+    hierarchy.SetLocalTranslation(a, 0.0f, 5.0f, 0.0f);
+    hierarchy.Update();
+    bool descendants = Sorted(hierarchy.GetRecomputed()) == Sorted({ a, b }) && hierarchy.GetStats().nodesRecomputed == 2 &&
+        NearFloat3(hierarchy.GetWorldTranslation(b), 0.0f, 5.0f, 0.0f);
+
+    // Setting what is already there changes nothing
+    hierarchy.SetLocalTranslation(a, 0.0f, 5.0f, 0.0f);
+    hierarchy.SetLocalRotation(root, 0.0f, 0.0f, 0.0f);
+    hierarchy.Update();
+    bool unchanged = hierarchy.GetRecomputed().empty();
+
+    hierarchy.SetLocalTranslation(root, 1.0f, 0.0f, 0.0f);
+    hierarchy.Update();
+    bool wholeTree = Sorted(hierarchy.GetRecomputed()) == Sorted({ root, a, b, sibling }) &&
+        NearFloat3(hierarchy.GetWorldTranslation(b), 1.0f, 5.0f, 0.0f) && NearFloat3(hierarchy.GetWorldTranslation(sibling), 1.0f, 0.0f, 0.0f);
+
+    // Moving a node under another parent recomputes it below its new parent
+    hierarchy.SetParent(sibling, b);
+    hierarchy.Update();
+    bool reparented = hierarchy.GetRecomputed() == std::vector<Handle>{ sibling } && NearFloat3(hierarchy.GetWorldTranslation(sibling), 1.0f, 5.0f, 0.0f);
+
+    hierarchy.Invalidate();
+    hierarchy.Update();
+    return first && clean && descendants && unchanged && wholeTree && reparented && hierarchy.GetRecomputed().size() == 5;
+}
+
+SCENEGRAPH_TEST(TransformHierarchy, LazyDecompose)
+{
+    TransformHierarchy hierarchy;
+    Handle root = hierarchy.Create();
+    Handle child = hierarchy.Create();
+    hierarchy.SetParent(child, root);
+
+    DirectX::XMFLOAT4 rootRotation, childRotation, expected;
+    DirectX::XMStoreFloat4(&rootRotation, DirectX::XMQuaternionRotationNormal(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), 0.5f));
+    DirectX::XMStoreFloat4(&childRotation, DirectX::XMQuaternionRotationNormal(DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), 0.25f));
+    // With the parent's world transform in front, its rotation applies first
+    DirectX::XMStoreFloat4(&expected, DirectX::XMQuaternionMultiply(DirectX::XMLoadFloat4(&rootRotation), DirectX::XMLoadFloat4(&childRotation)));
+
+    hierarchy.SetLocalScale(root, 2.0f, 2.0f, 2.0f);
+    hierarchy.SetLocalRotationQuat(root, rootRotation);
+    hierarchy.SetLocalScale(child, 1.5f, 1.5f, 1.5f);
+    hierarchy.SetLocalRotationQuat(child, childRotation);
+    hierarchy.Update();
+
+    // The first query splits up the new world transform, and asking again gives the same
+    bool first = NearFloat3(hierarchy.GetWorldScale(child), 3.0f, 3.0f, 3.0f) && SameRotation(hierarchy.GetWorldRotationQuat(child), expected) &&
+        NearFloat3(hierarchy.GetWorldScale(child), 3.0f, 3.0f, 3.0f) && SameRotation(hierarchy.GetWorldRotationQuat(root), rootRotation);
+
+    // Once the parent changes, the child's old decomposition is no good any more
+    hierarchy.SetLocalScale(root, 0.5f, 0.5f, 0.5f);
+    hierarchy.SetLocalRotationQuat(root, { 0.0f, 0.0f, 0.0f, 1.0f });
+    hierarchy.Update();
+    return first && NearFloat3(hierarchy.GetWorldScale(child), 0.75f, 0.75f, 0.75f) && SameRotation(hierarchy.GetWorldRotationQuat(child), childRotation);
+}
+
+SCENEGRAPH_TEST(TransformHierarchy, ParallelMatchesSerial)
+{
+    TransformHierarchy serial;
+    TransformHierarchy parallel;
+    serial.SetParallelUpdate(false);
+    parallel.SetJobSystem(std::make_shared<JobSystem>(4));
+
+    constexpr uint32_t count = 20000;
+    std::vector<Handle> handles = MakeTree(serial, count, 4);
+    if (MakeTree(parallel, count, 4) != handles)
+        return false;
+
+    MoveSome(serial, handles, 1, 1);
+    MoveSome(parallel, handles, 1, 1);
+    serial.Update();
+    parallel.Update();
+    bool full = SameWorld(serial, parallel, handles) && parallel.GetStats().workerCount == 4 && serial.GetStats().workerCount == 1 &&
+        parallel.GetStats().nodesRecomputed == count;
+
+    // Bit for bit the same, frame after frame, with only some nodes moving and the odd one changing parent
+    for (uint32_t frame = 0; frame < 5; frame++)
+    {
+        MoveSome(serial, handles, frame + 2, 50);
+        MoveSome(parallel, handles, frame + 2, 50);
+        Handle moved = handles[count - 1 - frame * 1000];
+        serial.SetParent(moved, handles[frame]);
+        parallel.SetParent(moved, handles[frame]);
+        serial.Update();
+        parallel.Update();
+        if (!SameWorld(serial, parallel, handles) || parallel.GetStats().nodesRecomputed != serial.GetStats().nodesRecomputed)
+            return false;
+    }
+    return full;
+}
+
+SCENEGRAPH_TEST(TransformHierarchy, SetParentRejectsCycles)
+{
+    TransformHierarchy hierarchy;
+    Handle root = hierarchy.Create();
+    Handle a = hierarchy.Create();
+    Handle b = hierarchy.Create();
+    hierarchy.SetParent(a, root);
+    hierarchy.SetParent(b, a);
+    hierarchy.SetLocalTranslation(root, 1.0f, 0.0f, 0.0f);
+    hierarchy.SetLocalTranslation(a, 0.0f, 1.0f, 0.0f);
+    hierarchy.SetLocalTranslation(b, 0.0f, 0.0f, 1.0f);
+    hierarchy.Update();
+
+    // Nothing can go below itself, directly or further down, and a refusal changes nothing
+    uint64_t version = hierarchy.GetTopologyVersion();
+    bool rejected = !hierarchy.SetParent(root, b) && !hierarchy.SetParent(a, a) && !hierarchy.SetParent(a, b) &&
+        hierarchy.GetTopologyVersion() == version;
+    hierarchy.Update();
+    rejected = rejected && hierarchy.GetRecomputed().empty() && NearFloat3(hierarchy.GetWorldTranslation(b), 1.0f, 1.0f, 1.0f);
+
+    // Moving up the tree is fine, and so is going below what used to be a descendant afterwards
+    bool accepted = hierarchy.SetParent(b, root) && hierarchy.SetParent(a, b);
+    hierarchy.Update();
+    accepted = accepted && NearFloat3(hierarchy.GetWorldTranslation(a), 1.0f, 1.0f, 1.0f);
+
+    // A released node lets go of its children, so they can take on their old ancestors
+    hierarchy.Destroy(b);
+    bool released = hierarchy.SetParent(root, a);
+    hierarchy.Update();
+    return rejected && accepted && released && NearFloat3(hierarchy.GetWorldTranslation(root), 1.0f, 1.0f, 0.0f);
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "SceneGraphTest.h"
+#include "VertexCompression.h"
+
+namespace
+{
+    constexpr float c_pi = 3.14159265f;
+
+    /// @brief Angle between two unit vectors in degrees, measured from the length of their
+    /// difference, since acos loses precision near 1
+    float AngleDegrees(const float a[3], const float b[3])
+    {
+        float dx = a[0] - b[0];
+        float dy = a[1] - b[1];
+        float dz = a[2] - b[2];
+        float chord = std::sqrt(dx * dx + dy * dy + dz * dz);
+        return 2.0f * std::asin(std::min(chord * 0.5f, 1.0f)) * 180.0f / c_pi;
+    }
+}
+
+SCENEGRAPH_TEST(VertexCompression, NormalsWithinBound)
+{
+    // A dense sweep of the sphere, including the poles and the seams of the octahedron
+    float worst = 0.0f;
+    const int rings = 300;
+    const int segments = 600;
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        float theta = c_pi * ring / rings;
+        for (int segment = 0; segment <= segments; segment++)
+        {
+            float phi = 2.0f * c_pi * segment / segments;
+            float normal[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+
+            int16_t encoded[2];
+            float decoded[3];
+            EncodeOctahedralNormal(normal, encoded);
+            DecodeOctahedralNormal(encoded, decoded);
+            worst = std::max(worst, AngleDegrees(normal, decoded));
+        }
+    }
+
+    // A zero length normal comes back as +Z
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+    int16_t encoded[2];
+    float decoded[3];
+    EncodeOctahedralNormal(zero, encoded);
+    DecodeOctahedralNormal(encoded, decoded);
+
+    return worst < 0.005f && Near(decoded[0], 0.0f) && Near(decoded[1], 0.0f) && Near(decoded[2], 1.0f);
+}
+
+SCENEGRAPH_TEST(VertexCompression, PositionsWithinHalfAStep)
+{
+    std::vector<VertexNormal> vertices;
+    for (int index = 0; index < 1000; index++)
+    {
+        float t = index / 999.0f;
+        vertices.push_back(VertexNormal{ 10.0f + 37.3f * t, -3.0f + 0.5f * std::sin(t * 40.0f), 7.0f - 5.0f * t * t, 0.0f, 1.0f, 0.0f });
+    }
+
+    auto quantization = ComputePositionQuantization(vertices.data(), vertices.size(), sizeof(VertexNormal));
+    float worstSteps = 0.0f;
+    for (const auto& vertex : vertices)
+    {
+        uint16_t encoded[4];
+        float decoded[3];
+        QuantizePosition(&vertex.x, quantization, encoded);
+        DequantizePosition(encoded, quantization, decoded);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float step = quantization.scale[axis] / 65535.0f;
+            worstSteps = std::max(worstSteps, std::fabs(decoded[axis] - (&vertex.x)[axis]) / step);
+        }
+    }
+
+    // The box's corners are exact, and a flat axis decodes to its one value
+    VertexNormal flat[2] = { { 1.0f, 2.0f, 3.0f, 0.0f, 1.0f, 0.0f }, { 5.0f, 2.0f, 4.0f, 0.0f, 1.0f, 0.0f } };
+    auto flatQuantization = ComputePositionQuantization(flat, 2, sizeof(VertexNormal));
+    uint16_t encoded[4];
+    float decoded[3];
+    QuantizePosition(&flat[1].x, flatQuantization, encoded);
+    DequantizePosition(encoded, flatQuantization, decoded);
+
+    // Rounding in the encode and decode gets a little slack
+    return worstSteps <= 0.51f && decoded[0] == 5.0f && decoded[1] == 2.0f && decoded[2] == 4.0f;
+}
+
+SCENEGRAPH_TEST(VertexCompression, HalfFloats)
+{
+    // Small integers, powers of two and the largest half are exact
+    const float exact[] = { 0.0f, 1.0f, -1.0f, 0.5f, 2.0f, 1024.0f, 65504.0f, 0.25f };
+    for (float value : exact)
+    {
+        if (HalfToFloat(FloatToHalf(value)) != value)
+            return false;
+    }
+
+    // Anything else is within the 11 bits of precision halves have
+    float worst = 0.0f;
+    for (int index = 1; index < 10000; index++)
+    {
+        float value = index * 0.00137f;
+        worst = std::max(worst, std::fabs(HalfToFloat(FloatToHalf(value)) - value) / value);
+    }
+    return worst <= 1.0f / 2048.0f;
+}
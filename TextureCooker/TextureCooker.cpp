@@ -0,0 +1,230 @@
+// TextureCooker: converts an image (PNG, JPG, TGA, BMP, ...) into the cooked texture format the
+// 10_SceneGraphs renderer maps and uploads directly. See CookedTexture.h for the layout.
+//
+// Usage: TextureCooker [--format rgba8|bc1|bc3|bc7] [--box] [--linear] [--clamp] [--premultiply] <source> [<output>]
+//
+// The full mip chain is filtered from the source with a Kaiser windowed sinc, in linear light unless
+// --linear says the image isn't sRGB (normal maps, masks), and wrapping around the edges unless
+// --clamp is given (see TextureMips.h). Every level is then block compressed (see
+// BlockCompression.h): BC7 by default, BC1 for half the size again where alpha doesn't matter, BC3
+// for alpha with BC1 quality colour. Images that aren't a multiple of 4 texels on each side can't
+// be block compressed, so they are written as RGBA8. --premultiply multiplies the colour by alpha
+// before any of that, in linear light for sRGB images, for textures drawn with premultiplied blending.
+//
+// The output defaults to the source path with a .wtgt extension. Textures are looked for next to
+// their source image, so cooking in place is all it takes.
+//
+// Only portable code is used so it builds outside Visual Studio as well, e.g. on Linux (one line,
+// with stb_image.h on the include path):
+//   g++ -std=c++17 -O2 -I../10_SceneGraphs/utils TextureCooker.cpp ../10_SceneGraphs/utils/BlockCompression.cpp
+//       ../10_SceneGraphs/utils/CookedTexture.cpp ../10_SceneGraphs/utils/ImageConvert.cpp ../10_SceneGraphs/utils/ImageDecoder.cpp
+//       ../10_SceneGraphs/utils/MappedFile.cpp ../10_SceneGraphs/utils/TextureMips.cpp -o TextureCooker
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "CookedTexture.h"
+#include "ImageConvert.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "TextureMips.h"
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "Usage: TextureCooker [--format rgba8|bc1|bc3|bc7] [--box] [--linear] [--clamp] [--premultiply] <source> [<output>]\n"
+                  << "  --format  how each level is stored; bc7 if not given\n"
+                  << "  --box     filter the mips with a 2x2 box rather than a Kaiser windowed sinc\n"
+                  << "  --linear  the colour isn't sRGB encoded, so filter it as it is\n"
+                  << "  --clamp   clamp at the edges when filtering, for textures that don't tile\n"
+                  << "  --premultiply  multiply the colour by alpha, for premultiplied blending\n";
+    }
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    bool ParseFormat(const std::string& name, CookedTextureFormat& format)
+    {
+        const CookedTextureFormat formats[] = { CookedTextureFormat::RGBA8, CookedTextureFormat::BC1, CookedTextureFormat::BC3, CookedTextureFormat::BC7 };
+        for (auto candidate : formats)
+        {
+            std::string candidateName = GetCookedTextureFormatName(candidate);
+            std::transform(candidateName.begin(), candidateName.end(), candidateName.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+            if (candidateName == name)
+            {
+                format = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief Peak signal to noise ratio of the RGB of two images the same size, in dB. Higher is
+    /// closer; identical images come out as infinity.
+    double ColourPsnr(const DecodedImage& original, const DecodedImage& decoded)
+    {
+        double squaredError = 0.0;
+        for (size_t index = 0; index < original.pixels.size(); index += 4)
+        {
+            for (size_t channel = 0; channel < 3; channel++)
+            {
+                double difference = static_cast<double>(original.pixels[index + channel]) - decoded.pixels[index + channel];
+                squaredError += difference * difference;
+            }
+        }
+        double meanSquaredError = squaredError / (original.pixels.size() / 4 * 3);
+        return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CookedTextureFormat format = CookedTextureFormat::BC7;
+    MipOptions options;
+    bool premultiply = false;
+    std::vector<std::string> paths;
+    for (int index = 1; index < argc; index++)
+    {
+        std::string argument = argv[index];
+        if (argument == "--format" && index + 1 < argc)
+        {
+            if (!ParseFormat(argv[++index], format))
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (argument == "--box")
+        {
+            options.filter = MipFilter::Box;
+        }
+        else if (argument == "--linear")
+        {
+            options.srgb = false;
+        }
+        else if (argument == "--clamp")
+        {
+            options.wrap = false;
+        }
+        else if (argument == "--premultiply")
+        {
+            premultiply = true;
+        }
+        else if (argument.rfind("--", 0) == 0)
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.empty() || paths.size() > 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::filesystem::path sourcePath = paths[0];
+    std::filesystem::path cookedPath = paths.size() > 1 ? std::filesystem::path(paths[1]) : sourcePath;
+    if (paths.size() == 1)
+        cookedPath.replace_extension(c_cookedTextureExtension);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    DecodedImage image;
+    std::string error;
+    if (!DecodeImageFile(sourcePath.string(), image, error))
+    {
+        std::cerr << "Failed to decode " << sourcePath << ": " << error << "\n";
+        return 1;
+    }
+    double decodeMilliseconds = MillisecondsSince(start);
+
+    if (premultiply)
+        PremultiplyAlpha(image.pixels.data(), static_cast<size_t>(image.width) * image.height, options.srgb);
+
+    if (IsBlockCompressed(format) && (image.width % c_blockSize != 0 || image.height % c_blockSize != 0))
+    {
+        std::cerr << image.width << "x" << image.height << " isn't a multiple of 4 texels on each side, so writing RGBA8\n";
+        format = CookedTextureFormat::RGBA8;
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<DecodedImage> mips;
+    GenerateMips(image, options, mips);
+    double mipMilliseconds = MillisecondsSince(start);
+
+    CookedTextureData texture;
+    texture.format = format;
+    texture.srgb = options.srgb;
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.levels.resize(mips.size());
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t level = 0; level < mips.size(); level++)
+    {
+        if (IsBlockCompressed(format))
+            CompressImage(static_cast<BlockFormat>(format), mips[level], texture.levels[level]);
+        else
+            texture.levels[level] = mips[level].pixels;
+    }
+    double encodeMilliseconds = MillisecondsSince(start);
+
+    if (!WriteCookedTexture(cookedPath.string(), texture, error))
+    {
+        std::cerr << "Failed to write " << cookedPath << ": " << error << "\n";
+        return 1;
+    }
+
+    // Load it back the way the runtime does, and see how close the first level came out
+    start = std::chrono::high_resolution_clock::now();
+    MappedFile file;
+    CookedTextureView view;
+    if (!file.Open(cookedPath.string()) || !view.Open(file.GetData(), file.GetSize()))
+    {
+        std::cerr << "Failed to read back " << cookedPath << ": " << view.GetError() << "\n";
+        return 1;
+    }
+    const auto& header = view.GetHeader();
+    std::vector<uint8_t> upload;
+    upload.reserve(static_cast<size_t>(header.fileSize));
+    for (uint32_t level = 0; level < header.mipCount; level++)
+    {
+        const auto* data = static_cast<const uint8_t*>(view.GetMipData(level));
+        upload.insert(upload.end(), data, data + view.GetMip(level).size);
+    }
+    double cookedMilliseconds = MillisecondsSince(start);
+
+    size_t uncompressedBytes = 0;
+    for (const auto& mip : mips)
+    {
+        uncompressedBytes += mip.pixels.size();
+    }
+    std::cout << "Cooked " << sourcePath << " to " << cookedPath << ": " << header.width << "x" << header.height << ", "
+              << header.mipCount << " levels, " << GetCookedTextureFormatName(view.GetFormat()) << (view.IsSrgb() ? " sRGB" : "") << ", "
+              << header.fileSize << " bytes (RGBA8 with mips would be " << uncompressedBytes << ")\n";
+    std::cout << "Mips (" << (options.filter == MipFilter::Kaiser ? "Kaiser" : "box") << ") in " << mipMilliseconds << " ms, encoded in "
+              << encodeMilliseconds << " ms (" << image.width * image.height * 4.0 / 3.0 / 1000.0 / std::max(encodeMilliseconds, 0.001) << " Mtexels/s)\n";
+    if (IsBlockCompressed(format))
+    {
+        DecodedImage decoded;
+        DecompressImage(static_cast<BlockFormat>(format), static_cast<const uint8_t*>(view.GetMipData(0)), header.width, header.height, decoded);
+        std::cout << "First level PSNR: " << ColourPsnr(image, decoded) << " dB\n";
+    }
+    std::cout << "Load time: decode " << decodeMilliseconds << " ms + mips " << mipMilliseconds << " ms, cooked " << cookedMilliseconds << " ms ("
+              << (decodeMilliseconds + mipMilliseconds) / std::max(cookedMilliseconds, 0.001) << "x faster)\n";
+
+    return 0;
+}